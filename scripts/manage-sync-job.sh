@@ -11,6 +11,15 @@ mkdir -p "$SYSTEMD_DIR"
 
 LOG_FILE="$HOME/.config/proton-drive/sync-manager.log"
 
+# Held by the app (or proton-drive-daemon) while its sync engine runs
+if [ -n "$XDG_RUNTIME_DIR" ]; then
+    ENGINE_LOCK="$XDG_RUNTIME_DIR/proton-drive-engine.lock"
+else
+    ENGINE_LOCK="/tmp/proton-drive-engine-$(id -u).lock"
+fi
+# One file per job run the engine (or "sync" below) asked for
+RUN_REQUEST_DIR="$HOME/.cache/proton-drive/run-requested"
+
 # ============================================================
 # GRACEFUL SHUTDOWN HANDLING
 # ============================================================
@@ -302,6 +311,7 @@ trigger_job() {
     job_id="$1"
     if [ -f "$JOB_DIR/$job_id.conf" ]; then
         source "$JOB_DIR/$job_id.conf"
+        mkdir -p "$RUN_REQUEST_DIR" && touch "$RUN_REQUEST_DIR/$job_id"
         systemctl --user start "$SERVICE_NAME.service"
         echo "Job $job_id started."
     else
@@ -500,6 +510,21 @@ run_dynamic_job() {
         buffer_size="32M"
     fi
     
+    # Learned concurrency: the desktop app measures each run of a job and
+    # records the transfers/checkers for the next one in sync_jobs.json
+    registry_file="$HOME/.config/proton-drive/sync_jobs.json"
+    if [ -f "$registry_file" ] && command -v jq >/dev/null; then
+        learned=$(jq -r --arg lp "$local_path" \
+            '.jobs[]? | select(.local_path == $lp) | "\(.learned_transfers // 0) \(.learned_checkers // 0)"' \
+            "$registry_file" 2>/dev/null | head -1)
+        read -r learned_transfers learned_checkers <<< "$learned"
+        if [ "${learned_transfers:-0}" -gt 0 ] 2>/dev/null && [ "${learned_checkers:-0}" -gt 0 ] 2>/dev/null; then
+            echo "Learned concurrency: $learned_transfers transfers, $learned_checkers checkers"
+            transfers=$learned_transfers
+            checkers=$learned_checkers
+        fi
+    fi
+    
     # 2. Build Command
     # Priority: nice -n 15 (Low CPU priority for "Natural Scaling")
     # Disk: ionice -c 3 (Idle) if available
@@ -550,7 +575,17 @@ run_dynamic_job() {
     SCRIPT_DIR=$(dirname "$(readlink -f "$0")")
     MONITOR_SCRIPT="$SCRIPT_DIR/adaptive-monitor.py"
     
-    if [ -f "$MONITOR_SCRIPT" ]; then
+    # The desktop app (window or proton-drive-daemon) measures this run to
+    # pick the next one's transfers; live changes would skew its numbers.
+    # The daemon's comm is truncated to "proton-drive-da", so it is found by
+    # its bus name, or by full command line where there is no session bus.
+    app_running=false
+    if pgrep -x proton-drive >/dev/null \
+        || busctl --user status me.proton.drive.Daemon >/dev/null 2>&1 \
+        || pgrep -u "$(id -u)" -f '(^|/)proton-drive-daemon( |$)' >/dev/null; then
+        app_running=true
+    fi
+    if [ -f "$MONITOR_SCRIPT" ] && [ "$app_running" = false ]; then
         echo "Starting Adaptive Monitor on port $rc_port (Max Transfers: $transfers)..."
         # Wait a bit for rclone to start before launching python
         # We use a trap to kill the python monitor when this script exits
@@ -792,6 +827,32 @@ run_dynamic_job() {
     fi
 }
 
+# True if a job run should step aside for the engine's own scheduler: the
+# engine lock is held and the engine did not ask for this run (its request
+# marker is fresh). The timers stay enabled while the app runs, so periodic
+# sync carries on by itself if the app or daemon dies.
+engine_owns_schedule() {
+    local local_path="$1" remote_path="$2" conf job_id="" inode
+    for conf in "$JOB_DIR"/*.conf; do
+        [ -f "$conf" ] || continue
+        if grep -qxF "LOCAL_PATH=\"$local_path\"" "$conf" && grep -qxF "REMOTE_PATH=\"$remote_path\"" "$conf"; then
+            job_id=$(basename "$conf" .conf)
+            break
+        fi
+    done
+    if [ -n "$job_id" ] && [ -f "$RUN_REQUEST_DIR/$job_id" ]; then
+        local fresh
+        fresh=$(find "$RUN_REQUEST_DIR/$job_id" -mmin -5 2>/dev/null)
+        rm -f "$RUN_REQUEST_DIR/$job_id"
+        [ -n "$fresh" ] && return 1
+    fi
+    # Read the holder from /proc/locks rather than taking the lock, which
+    # would make an engine starting at this moment think another one runs
+    [ -e "$ENGINE_LOCK" ] || return 1
+    inode=$(stat -c %i "$ENGINE_LOCK" 2>/dev/null) || return 1
+    grep -q "FLOCK.*:$inode " /proc/locks 2>/dev/null
+}
+
 case "$1" in
     list)
         list_jobs
@@ -823,6 +884,10 @@ case "$1" in
         fi
         ;;
     run)
+        if engine_owns_schedule "$2" "$3"; then
+            echo "Sync engine is running and schedules this job itself - skipping timer run."
+            exit 0
+        fi
         run_dynamic_job "${@:2}"
         ;;
     *)
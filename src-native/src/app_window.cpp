@@ -7,6 +7,13 @@
 #include "sync_job_metadata.hpp"
 #include "notifications.hpp"
 #include "settings.hpp"
+#include "sync_scheduler.hpp"
+#include "startup.hpp"
+#include "trace.hpp"
+#include "transfer_scheduler.hpp"
+#include "cloud_monitor.hpp"
+#include "daemon_service.hpp"
+#include "cloud_mount.hpp"
 #include <filesystem>
 #include <fstream>
 #include <sstream>
@@ -18,6 +25,9 @@
 #include <cctype>
 #include <cstdio>
 #include <set>
+#include <map>
+#include <atomic>
+#include <chrono>
 #include <unistd.h>
 #include <limits.h>
 
@@ -742,19 +752,10 @@ bool AppWindow::initialize() {
     
     build_window();
     
-    // Start status polling
-    g_timeout_add(2000, [](gpointer data) -> gboolean {
-        auto* self = static_cast<AppWindow*>(data);
-        self->poll_status();
-        return G_SOURCE_CONTINUE;
-    }, this);
-    
-    // Start sync activity polling (every 1 second for responsive UI)
-    g_timeout_add(1000, [](gpointer data) -> gboolean {
-        auto* self = static_cast<AppWindow*>(data);
-        self->poll_sync_activity();
-        return G_SOURCE_CONTINUE;
-    }, this);
+    // Service status and sync activity are redrawn when StatusService
+    // reports a change (sampled here, or the daemon's properties)
+    status_listener_id_ = proton::StatusService::getInstance().add_listener(
+        [this](const proton::SyncStatus& status) { on_status_changed(status); });
     
     // Add window-level drop target so drag-drop works on ANY page
     GtkDropTarget* window_drop_target = gtk_drop_target_new(G_TYPE_INVALID, GDK_ACTION_COPY);
@@ -801,6 +802,18 @@ bool AppWindow::initialize() {
     
     gtk_widget_add_controller(window_, GTK_EVENT_CONTROLLER(window_drop_target));
     
+    // Hidden developer shortcut: Ctrl+Shift+T starts tracing, pressing it
+    // again writes the trace out
+    GtkEventController* shortcuts = gtk_shortcut_controller_new();
+    gtk_shortcut_controller_set_scope(GTK_SHORTCUT_CONTROLLER(shortcuts), GTK_SHORTCUT_SCOPE_GLOBAL);
+    gtk_shortcut_controller_add_shortcut(GTK_SHORTCUT_CONTROLLER(shortcuts), gtk_shortcut_new(
+        gtk_shortcut_trigger_parse_string("<Control><Shift>t"),
+        gtk_callback_action_new(+[](GtkWidget*, GVariant*, gpointer data) -> gboolean {
+            static_cast<AppWindow*>(data)->toggle_tracing();
+            return TRUE;
+        }, this, nullptr)));
+    gtk_widget_add_controller(window_, shortcuts);
+    
     Logger::info("[AppWindow] Initialized with GTK4");
     return true;
 }
@@ -1570,7 +1583,9 @@ void AppWindow::build_window() {
         std::string interval_str = std::to_string(minutes) + "m";
         if (minutes >= 9999) interval_str = "1d"; // For manual, set to 1 day to minimize
         
-        // Update all job timers
+        // The scheduler adapts around the new base interval; the job timers
+        // (used while the app is closed) get it as their fixed interval
+        proton::SyncScheduler::getInstance().reschedule();
         std::string update_cmd = "for timer in ~/.config/systemd/user/proton-drive-job-*.timer; do "
                                  "if [ -f \"$timer\" ]; then "
                                  "sed -i 's/OnUnitActiveSec=.*/OnUnitActiveSec=" + interval_str + "/' \"$timer\"; "
@@ -1714,10 +1729,12 @@ void AppWindow::build_window() {
                     gtk_label_set_text(GTK_LABEL(data->self->index_status_label_), 
                                        ("Status: " + data->status).c_str());
                 }
-                if (data->percent >= 100) {
+                // An incomplete crawl ends short of 100% with an error status
+                bool failed = data->status.rfind("Error:", 0) == 0;
+                if (data->percent >= 100 || failed) {
                     gtk_widget_set_sensitive(GTK_WIDGET(data->btn), TRUE);
                     gtk_button_set_label(data->btn, "Force Rebuild Index");
-                    data->self->append_log("[Search] Indexing complete!");
+                    data->self->append_log(failed ? "[Search] " + data->status : "[Search] Indexing complete!");
                 }
                 delete data;
                 return G_SOURCE_REMOVE;
@@ -1739,14 +1756,13 @@ void AppWindow::build_window() {
     // Add content area directly to main_hbox (no progress overlay)
     gtk_box_append(GTK_BOX(main_hbox), content_area_);
     
-    // Initial state refresh
+    // Initial state refresh. Jobs, devices and cloud monitoring need the
+    // sync registry and index, which come up after first paint; they are
+    // refreshed again in on_background_init_complete()
     refresh_profiles();
     refresh_sync_jobs();
     refresh_devices();
-    poll_status();
-    
-    // Start cloud monitoring for automatic sync
-    start_cloud_monitoring();
+    show_status(proton::StatusService::getInstance().current());
     
     // Log startup
     append_log("Proton Drive started");
@@ -1755,11 +1771,100 @@ void AppWindow::build_window() {
     const char* home = getenv("HOME");
     current_local_path_ = home ? std::string(home) + "/ProtonDrive" : "/tmp";
     
-    // Refresh file lists
-    refresh_cloud_files();
+    // Paint the last session's cloud view from its snapshot; without one,
+    // wait for the index rather than listing the same folder twice
+    std::string snapshot_path;
+    std::vector<IndexedFile> snapshot_rows;
+    if (proton::FirstPaintSnapshot::getInstance().take(snapshot_path, snapshot_rows)) {
+        current_cloud_path_ = snapshot_path;
+        gtk_label_set_text(GTK_LABEL(path_bar_), current_cloud_path_.c_str());
+        if (snapshot_rows.empty()) {
+            show_cloud_status("Folder is empty");
+        } else {
+            show_cloud_rows(std::move(snapshot_rows), CloudRowStyle::Browse);
+        }
+    } else {
+        show_cloud_status("Loading...", nullptr, true);
+    }
     refresh_local_files();
 }
 
+void AppWindow::on_background_init_complete() {
+    refresh_sync_jobs();
+    refresh_devices();
+    refresh_sync_activity();
+    
+    if (SyncManager::getInstance().runs_engine()) {
+        start_engine_services();
+    } else {
+        // proton-drive-daemon does the syncing; show what it reports
+        proton::DaemonClient::Handlers handlers;
+        handlers.log = [this](const std::string& line) { append_log(line); };
+        handlers.jobs_changed = [this]() { refresh_sync_jobs(); };
+        handlers.remote_changed = [this]() {
+            refresh_cloud_files();
+            refresh_local_files();
+        };
+        handlers.status = [](const proton::SyncStatus& status) {
+            proton::StatusService::getInstance().publish(status);
+        };
+        handlers.vanished = [this]() { take_over_engine(); };
+        proton::DaemonClient::subscribe(std::move(handlers));
+    }
+    
+    // Revalidates the snapshot (or fills the empty view) through the index
+    refresh_cloud_files();
+}
+
+void AppWindow::start_engine_services() {
+    // Start cloud monitoring for automatic sync
+    start_cloud_monitoring();
+    
+    auto& status = proton::StatusService::getInstance();
+    status.start();
+    int metrics_port = proton::SettingsManager::getInstance().get_metrics_port();
+    if (metrics_port > 0 && metrics_port < 65536) {
+        status.start_metrics(static_cast<uint16_t>(metrics_port));
+    }
+}
+
+void AppWindow::take_over_engine() {
+    if (engine_takeover_id_ > 0 || SyncManager::getInstance().runs_engine()) return;
+    
+    // The bus name goes before the daemon's shutdown releases the engine
+    // lock; poll for it rather than leave sync jobs unattended
+    engine_takeover_attempts_ = 0;
+    engine_takeover_id_ = g_timeout_add(500, +[](gpointer user_data) -> gboolean {
+        auto* self = static_cast<AppWindow*>(user_data);
+        if (!proton::acquire_engine_lock()) {
+            if (++self->engine_takeover_attempts_ < 20) return G_SOURCE_CONTINUE;
+            self->engine_takeover_id_ = 0;
+            Logger::warn("[AppWindow] proton-drive-daemon exited but still holds the engine lock");
+            self->show_toast("Background sync stopped - restart Proton Drive to resume syncing", 8000);
+            return G_SOURCE_REMOVE;
+        }
+        self->engine_takeover_id_ = 0;
+        
+        Logger::info("[AppWindow] proton-drive-daemon exited - running the sync engine in this window");
+        proton::DaemonClient::unsubscribe();
+        SyncManager::getInstance().start_engine();
+        self->start_engine_services();
+        
+        auto& settings = proton::SettingsManager::getInstance();
+        if (settings.get_mount_enabled()) {
+            proton::CloudMount::getInstance().start(settings.get_mount_point(), settings.get_mount_cache_size());
+        }
+        auto& file_index = FileIndex::getInstance();
+        if (!file_index.is_indexing() && file_index.needs_refresh(2)) {
+            file_index.start_background_index(false);
+        }
+        
+        self->append_log("Background sync stopped - syncing continues in this window");
+        self->show_toast("Background sync stopped - syncing continues in this window");
+        return G_SOURCE_REMOVE;
+    }, this);
+}
+
 void AppWindow::build_header_bar() {
     header_bar_ = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
     gtk_widget_set_margin_start(header_bar_, 10);
@@ -1819,6 +1924,7 @@ void AppWindow::set_drop_zone_highlight(bool active) {
 }
 
 void AppWindow::handle_dropped_files(const std::vector<std::string>& paths) {
+    std::vector<std::string> files;
     for (const auto& path : paths) {
         append_log("[Drop] Received: " + path);
         
@@ -1827,21 +1933,19 @@ void AppWindow::handle_dropped_files(const std::vector<std::string>& paths) {
             append_log("[Drop] Local folder detected: " + path);
             show_sync_from_local_dialog(path);
         } else {
-            // Single file: upload directly to current cloud folder
+            // Files: upload directly to current cloud folder (batched below)
             append_log("[Upload] Uploading file to cloud: " + path);
-            std::vector<std::string> single_file = {path};
-            handle_cloud_drop(single_file, current_cloud_path_);
+            files.push_back(path);
         }
     }
+    if (!files.empty()) {
+        handle_cloud_drop(files, current_cloud_path_);
+    }
 }
 
 void AppWindow::handle_cloud_drop(const std::vector<std::string>& local_paths, const std::string& cloud_folder) {
     if (local_paths.empty()) return;
     
-    std::string rclone_path = AppWindowHelpers::get_rclone_path();
-    std::string dest = "proton:" + cloud_folder;
-    if (dest.back() != '/') dest += "/";
-    
     // Count total files for progress
     int total_files = static_cast<int>(local_paths.size());
     
@@ -1858,153 +1962,241 @@ void AppWindow::handle_cloud_drop(const std::vector<std::string>& local_paths, c
     // Invalidate cache now so refresh will get fresh data
     invalidate_cloud_cache();
     
+    // Group by source folder: each group is one rclone process (and one
+    // Proton session) with --transfers parallelism, not one per item
+    std::map<std::string, std::vector<DropUploadItem>> batches;
     for (const auto& local_path : local_paths) {
-        std::string filename = fs::path(local_path).filename().string();
-        bool is_dir = safe_is_directory(local_path);
+        DropUploadItem item;
+        item.local_path = local_path;
+        item.filename = fs::path(local_path).filename().string();
+        item.is_dir = safe_is_directory(local_path);
+        item.remote_path = cloud_folder;
+        if (item.remote_path.back() != '/') item.remote_path += "/";
+        item.remote_path += item.filename;
         
-        append_log(std::string("[Upload] ") + (is_dir ? "Copying folder" : "Uploading") + ": " + filename);
+        append_log(std::string("[Upload] ") + (item.is_dir ? "Copying folder" : "Uploading") + ": " + item.filename);
         
         // Add to transfer popup
-        add_transfer_item(filename, true);  // true = upload
-        
-        // For folders, offer to create a sync job
-        std::string remote_path = cloud_folder;
-        if (remote_path.back() != '/') remote_path += "/";
-        remote_path += filename;
+        add_transfer_item(item.filename, true);  // true = upload
         
-        // Use copy for files, copyto for keeping structure
-        std::string cmd;
-        if (is_dir) {
-            // For folders, use copy to preserve folder name
-            cmd = rclone_path + " copy " + AppWindowHelpers::shell_escape(local_path) + 
-                  " " + AppWindowHelpers::shell_escape(dest + filename) + " --progress 2>&1";
-        } else {
-            // For files, use copyto
-            cmd = rclone_path + " copyto " + AppWindowHelpers::shell_escape(local_path) + 
-                  " " + AppWindowHelpers::shell_escape(dest + filename) + " --progress 2>&1";
+        batches[fs::path(local_path).parent_path().string()].push_back(std::move(item));
+    }
+    
+    for (auto& batch : batches) {
+        proton::TaskPool::getInstance().submit(proton::TaskLane::Transfer,
+            [this, source_dir = batch.first, items = std::move(batch.second), cloud_folder]() {
+                upload_drop_batch(source_dir, items, cloud_folder);
+            });
+    }
+}
+
+void AppWindow::upload_drop_batch(const std::string& source_dir, const std::vector<DropUploadItem>& items,
+                                  const std::string& cloud_folder) {
+    std::string dest = "proton:" + cloud_folder;
+    if (dest.back() != '/') dest += "/";
+    
+    // File list relative to source_dir: files as-is, folders expanded to every file inside
+    struct ItemProgress {
+        size_t total = 0;
+        size_t done = 0;
+        bool failed = false;
+        bool finished = false;
+    };
+    std::vector<ItemProgress> progress(items.size());
+    std::map<std::string, size_t> item_by_name;
+    
+    static std::atomic<unsigned> batch_counter{0};
+    const char* home = std::getenv("HOME");
+    std::string list_dir = std::string(home ? home : "/tmp") + "/.cache/proton-drive";
+    { std::error_code ec; fs::create_directories(list_dir, ec); }
+    std::string list_path = list_dir + "/drop-" + std::to_string(getpid()) + "-" +
+                            std::to_string(batch_counter++) + ".txt";
+    std::ofstream list(list_path, std::ios::trunc);
+    
+    for (size_t i = 0; i < items.size(); ++i) {
+        const auto& item = items[i];
+        item_by_name[item.filename] = i;
+        if (!item.is_dir) {
+            list << item.filename << '\n';
+            progress[i].total = 1;
+            continue;
         }
-        
-        Logger::info("[CloudDrop] Executing: " + cmd);
-        
-        // Run upload in background thread
-        auto* self = this;
-        std::string target_folder = cloud_folder;  // Capture for lambda
-        std::string local_path_copy = local_path;
-        std::string remote_path_copy = remote_path;
-        std::thread([self, cmd, filename, is_dir, target_folder, total_files, local_path_copy, remote_path_copy]() {
-            FILE* pipe = popen(cmd.c_str(), "r");
-            if (pipe) {
-                char buffer[256];
-                while (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
-                    // Could parse progress here for detailed feedback
+        std::error_code ec;
+        fs::recursive_directory_iterator it(item.local_path, fs::directory_options::skip_permission_denied, ec);
+        for (; !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            std::error_code type_ec;
+            if (!it->is_regular_file(type_ec)) continue;
+            std::string full = it->path().string();
+            list << item.filename << '/' << full.substr(item.local_path.size() + 1) << '\n';
+            progress[i].total++;
+        }
+        if (progress[i].total == 0) {
+            // files-from only creates folders that hold files
+            AppWindowHelpers::run_rclone_with_timeout("mkdir " + AppWindowHelpers::shell_escape(dest + item.filename), 60);
+        }
+    }
+    list.close();
+    
+    auto ticket = proton::TransferScheduler::getInstance().begin(proton::TransferPriority::UserCopy,
+                                                                 source_dir + " -> " + dest);
+    int transfers = proton::SettingsManager::getInstance().get_max_parallel_transfers();
+    std::string cmd = get_rclone_path() + " copy " + AppWindowHelpers::shell_escape(source_dir) + " " + AppWindowHelpers::shell_escape(dest) +
+                      " --files-from-raw " + AppWindowHelpers::shell_escape(list_path) + " --no-traverse" +
+                      " --transfers " + std::to_string(transfers) + " -v --stats 1s --stats-one-line 2>&1";
+    Logger::info("[CloudDrop] Executing: " + cmd);
+    
+    // -v reports every object: "INFO  : <path>: Copied (new)" / "ERROR : <path>: Failed to copy: ..."
+    // plus a one-line stats summary of the whole batch every second
+    auto item_for = [&](const std::string& line, size_t start, size_t end) -> long {
+        if (start == std::string::npos || end == std::string::npos || end <= start) return -1;
+        std::string object = line.substr(start, end - start);
+        auto found = item_by_name.find(object.substr(0, object.find('/')));
+        return found == item_by_name.end() ? -1 : static_cast<long>(found->second);
+    };
+    auto last_post = std::chrono::steady_clock::now();
+    
+    int ret = -1;
+    FILE* pipe = popen(cmd.c_str(), "r");
+    if (pipe) {
+        char buffer[4096];
+        std::string line;
+        while (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
+            line += buffer;
+            if (line.back() != '\n') continue;
+            line.pop_back();
+            
+            size_t info = line.find("INFO  : ");
+            size_t error = line.find("ERROR : ");
+            AppWindowHelpers::RcloneStats stats;
+            if (info != std::string::npos && AppWindowHelpers::parse_rclone_stats_line(line, stats)) {
+                // Byte counts are per batch, so they are only exact for a
+                // lone item (typically one big file); folders keep file counts
+                auto now = std::chrono::steady_clock::now();
+                if (items.size() == 1 && !progress[0].finished && stats.total > 0 &&
+                    now - last_post > std::chrono::milliseconds(250)) {
+                    last_post = now;
+                    const std::string& name = items[0].filename;
+                    double fraction = static_cast<double>(stats.bytes) / static_cast<double>(stats.total);
+                    proton::TaskPool::post_to_main([this, name, fraction, speed = stats.speed, bytes = stats.bytes]() {
+                        update_transfer_progress(name, fraction, speed, bytes);
+                    });
                 }
-                int ret = pclose(pipe);
-                
-                // Update transfer progress (simple completion for now)
-                struct UpdateData {
-                    AppWindow* self;
-                    std::string filename;
-                    bool success;
-                };
-                auto* update_data = new UpdateData{self, filename, (ret == 0)};
-                
-                g_idle_add(+[](gpointer user_data) -> gboolean {
-                    auto* d = static_cast<UpdateData*>(user_data);
-                    d->self->complete_transfer_item(d->filename, d->success);
-                    delete d;
-                    return G_SOURCE_REMOVE;
-                }, update_data);
-                
-                // Capture results for main thread callback
-                struct UploadResult {
-                    AppWindow* self;
-                    std::string filename;
-                    std::string target_folder;
-                    std::string local_path;
-                    std::string remote_path;
-                    bool is_dir;
-                    bool success;
-                };
-                auto* result = new UploadResult{self, filename, target_folder, local_path_copy, remote_path_copy, is_dir, (ret == 0)};
-                
-                // Handle completion on main thread
-                g_idle_add(+[](gpointer data) -> gboolean {
-                    auto* r = static_cast<UploadResult*>(data);
-                    
-                    if (r->success) {
-                        Logger::info("[CloudDrop] Upload complete: " + r->filename);
-                        r->self->append_log("[Upload] ✓ Completed: " + r->filename);
-                        
-                        // Show success notification
-                        proton::NotificationManager::getInstance().notify(
-                            "Upload Complete",
-                            r->filename + " uploaded to " + r->target_folder,
-                            proton::NotificationType::UPLOAD_COMPLETE
-                        );
-                        
-                        // For folders, automatically create a sync job
-                        if (r->is_dir) {
-                            auto& registry = SyncJobRegistry::getInstance();
-                            std::string job_id = registry.createJob(r->local_path, r->remote_path, "bisync");
-                            Logger::info("[CloudDrop] Created sync job for folder: " + r->filename + " (job: " + job_id + ")");
-                            r->self->append_log("[Sync] Created two-way sync job for: " + r->filename);
-                            r->self->refresh_sync_jobs();
-                        }
-                    } else {
-                        Logger::error("[CloudDrop] Upload failed: " + r->filename);
-                        r->self->append_log("[Upload] ✗ Failed: " + r->filename);
-                        
-                        // Show error notification
-                        proton::NotificationManager::getInstance().notify(
-                            "Upload Failed",
-                            "Failed to upload " + r->filename,
-                            proton::NotificationType::ERROR
-                        );
+            } else if (info != std::string::npos) {
+                long idx = item_for(line, info + 8, line.find(": Copied (", info + 8));
+                if (idx >= 0 && !progress[idx].finished) {
+                    auto& p = progress[idx];
+                    p.done++;
+                    const std::string& name = items[idx].filename;
+                    auto now = std::chrono::steady_clock::now();
+                    if (p.done >= p.total && !p.failed) {
+                        p.finished = true;
+                        proton::TaskPool::post_to_main([this, name]() { complete_transfer_item(name, true); });
+                    } else if (now - last_post > std::chrono::milliseconds(250)) {
+                        last_post = now;
+                        double fraction = static_cast<double>(p.done) / static_cast<double>(p.total);
+                        proton::TaskPool::post_to_main([this, name, fraction]() {
+                            update_transfer_progress(name, fraction, "", 0);
+                        });
                     }
-                    
-                    // Always refresh cloud browser to show new files
-                    r->self->invalidate_cloud_cache();
-                    r->self->refresh_cloud_files_async(true);  // Force refresh
-                    
-                    delete r;
-                    return G_SOURCE_REMOVE;
-                }, result);
+                }
+            } else if (error != std::string::npos) {
+                long idx = item_for(line, error + 8, line.find(": Failed to copy", error + 8));
+                if (idx >= 0) progress[idx].failed = true;
+                Logger::warn("[CloudDrop] " + line.substr(error));
             }
-        }).detach();
+            line.clear();
+        }
+        ret = pclose(pipe);
+    }
+    std::remove(list_path.c_str());
+    ticket.release();
+    
+    // Unchanged files are not reported, so a clean exit settles everything left
+    struct ItemResult {
+        DropUploadItem item;
+        bool success;
+    };
+    std::vector<ItemResult> results;
+    for (size_t i = 0; i < items.size(); ++i) {
+        results.push_back({items[i], !progress[i].failed && (progress[i].finished || ret == 0)});
     }
+    
+    proton::TaskPool::post_to_main([this, results = std::move(results), cloud_folder]() {
+        size_t succeeded = 0;
+        for (const auto& r : results) {
+            if (r.success) {
+                succeeded++;
+                Logger::info("[CloudDrop] Upload complete: " + r.item.filename);
+                append_log("[Upload] ✓ Completed: " + r.item.filename);
+                
+                // For folders, automatically create a sync job
+                if (r.item.is_dir) {
+                    auto& registry = SyncJobRegistry::getInstance();
+                    std::string job_id = registry.createJob(r.item.local_path, r.item.remote_path, "bisync");
+                    Logger::info("[CloudDrop] Created sync job for folder: " + r.item.filename + " (job: " + job_id + ")");
+                    append_log("[Sync] Created two-way sync job for: " + r.item.filename);
+                    refresh_sync_jobs();
+                }
+            } else {
+                Logger::error("[CloudDrop] Upload failed: " + r.item.filename);
+                append_log("[Upload] ✗ Failed: " + r.item.filename);
+            }
+            complete_transfer_item(r.item.filename, r.success);
+        }
+        
+        // One notification per batch rather than per file
+        size_t failed = results.size() - succeeded;
+        if (succeeded > 0) {
+            proton::NotificationManager::getInstance().notify(
+                "Upload Complete",
+                (results.size() == 1 ? results.front().item.filename : std::to_string(succeeded) + " item(s)") +
+                    " uploaded to " + cloud_folder,
+                proton::NotificationType::UPLOAD_COMPLETE
+            );
+        }
+        if (failed > 0) {
+            proton::NotificationManager::getInstance().notify(
+                "Upload Failed",
+                results.size() == 1 ? "Failed to upload " + results.front().item.filename
+                                    : "Failed to upload " + std::to_string(failed) + " item(s)",
+                proton::NotificationType::ERROR
+            );
+        }
+        
+        // Always refresh cloud browser to show new files
+        invalidate_cloud_cache();
+        refresh_cloud_files_async(true);  // Force refresh
+    });
 }
 
 // Button handlers
-void AppWindow::poll_status() {
-    // Check if any sync job timers are active
-    std::string output = exec_command("systemctl --user list-units 'proton-drive-job-*.timer' --state=active --no-legend 2>/dev/null | wc -l");
-    
-    // Trim whitespace
-    output.erase(0, output.find_first_not_of(" \t\n"));
-    output.erase(output.find_last_not_of(" \t\n") + 1);
+void AppWindow::on_status_changed(const proton::SyncStatus& status) {
+    show_status(status);
     
-    int active_timers = 0;
-    try {
-        active_timers = std::stoi(output);
-    } catch (...) {}
-    
-    update_service_status(active_timers > 0);
+    // As a daemon client the activity list still reads this process's RC
+    // poller; catch it up when the daemon starts or finishes a sync
+    if (status.running_syncs != last_running_syncs_ && !SyncManager::getInstance().runs_engine()) {
+        SyncManager::getInstance().request_stats_refresh();
+    }
+    last_running_syncs_ = status.running_syncs;
+    refresh_sync_activity();
+}
+
+void AppWindow::show_status(const proton::SyncStatus& status) {
+    update_service_status(status.scheduler_active);
     
     // Update index status in Settings if visible
     if (index_status_label_) {
-        auto& file_index = FileIndex::getInstance();
-        auto stats = file_index.get_stats();
-        
         std::string status_text;
-        if (stats.is_indexing) {
-            status_text = "Status: Indexing... " + std::to_string(stats.index_progress_percent) + "%";
-        } else if (stats.total_files == 0 && stats.total_folders == 0) {
+        if (status.indexing) {
+            status_text = "Status: Indexing... " + std::to_string(status.index_progress) + "%";
+        } else if (status.indexed_files == 0 && status.indexed_folders == 0) {
             status_text = "Status: Empty - click Rebuild Index to populate";
         } else {
-            status_text = "Status: " + std::to_string(stats.total_files) + " files, " + 
-                         std::to_string(stats.total_folders) + " folders indexed";
-            if (!stats.last_full_index.empty()) {
-                status_text += " (last: " + stats.last_full_index.substr(0, 16) + ")";
+            status_text = "Status: " + std::to_string(status.indexed_files) + " files, " + 
+                         std::to_string(status.indexed_folders) + " folders indexed";
+            if (!status.last_indexed.empty()) {
+                status_text += " (last: " + status.last_indexed.substr(0, 16) + ")";
             }
         }
         gtk_label_set_text(GTK_LABEL(index_status_label_), status_text.c_str());
@@ -2053,13 +2245,28 @@ void AppWindow::set_toggle_callback(std::function<void()> callback) {
 void AppWindow::shutdown() {
     Logger::info("[AppWindow] Shutting down...");
     
+    auto& status = proton::StatusService::getInstance();
+    status.remove_listener(status_listener_id_);
+    status.stop();
+    if (engine_takeover_id_ > 0) {
+        g_source_remove(engine_takeover_id_);
+        engine_takeover_id_ = 0;
+    }
+    proton::DaemonClient::unsubscribe();
+    
     // Stop cloud monitoring thread
-    if (cloud_monitoring_active_.load()) {
+    if (proton::CloudMonitor::getInstance().is_running()) {
         Logger::info("[AppWindow] Stopping cloud monitor thread...");
         stop_cloud_monitoring();
         Logger::info("[AppWindow] Cloud monitor stopped");
     }
     
+    // Next launch paints this view before anything else is up
+    if (last_listing_) {
+        proton::FirstPaintSnapshot::getInstance().save(last_listing_path_, last_listing_->entries);
+        last_listing_.reset();
+    }
+    
     Logger::info("[AppWindow] Shutdown complete");
 }
 
@@ -2094,6 +2301,29 @@ void AppWindow::append_log(const std::string& message) {
     Logger::info("[AppWindow] " + message);
 }
 
+void AppWindow::toggle_tracing() {
+    if (!proton::Trace::enabled()) {
+        proton::Trace::set_enabled(true);
+        show_toast("Tracing started - press Ctrl+Shift+T again to save");
+        return;
+    }
+    
+    proton::Trace::set_enabled(false);
+    const char* home = getenv("HOME");
+    time_t now = time(nullptr);
+    char stamp[32];
+    strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", localtime(&now));
+    std::string path = (home ? std::string(home) + "/.cache/proton-drive" : std::string("/tmp")) +
+                       "/trace-" + stamp + ".json";
+    size_t events = 0;
+    if (proton::Trace::export_chrome_json(path, &events)) {
+        append_log("[Trace] Saved " + std::to_string(events) + " events to " + path);
+        show_toast("Trace saved to " + path);
+    } else {
+        show_toast("Failed to save trace");
+    }
+}
+
 void AppWindow::show_toast(const std::string& message, int duration_ms) {
     if (!toast_revealer_ || !toast_label_) return;
     
@@ -10,6 +10,10 @@
 #include <mutex>
 #include <chrono>
 #include "file_index.hpp"
+#include "cloud_file_model.hpp"
+#include "cloud_dir_cache.hpp"
+#include "task_pool.hpp"
+#include "status_service.hpp"
 
 /**
  * Main Application Window (GTK4)
@@ -94,6 +98,17 @@ public:
      */
     GtkWidget* get_cloud_tree() const { return cloud_tree_; }
 
+    /**
+     * Cloud list row under (x, y) in cloud tree coordinates, or nullptr.
+     * The item is owned by the list view.
+     */
+    PdFileItem* get_cloud_item_at(double x, double y, guint* position = nullptr) const;
+
+    /**
+     * How cloud rows are currently rendered (browse listing vs search results)
+     */
+    CloudRowStyle get_cloud_row_style() const { return cloud_row_style_; }
+
     /**
      * Get local tree widget for external callbacks
      */
@@ -142,6 +157,13 @@ public:
                                                  const std::string& sync_type,
                                                  const std::string& resolution);
 
+    /**
+     * Called on the main thread once the subsystems deferred past first
+     * paint (index, sync registry, trash) are up: starts cloud monitoring
+     * and replaces the first-paint snapshot with a live listing
+     */
+    void on_background_init_complete();
+
     /**
      * Shutdown - stop all background threads and cleanup resources
      * Must be called before application exit to prevent crashes
@@ -188,7 +210,14 @@ private:
     
     // File browser panel
     GtkWidget* file_browser_box_ = nullptr;
-    GtkWidget* cloud_tree_ = nullptr;
+    GtkWidget* cloud_tree_ = nullptr;          // GtkListView over cloud_model_
+    PdFileModel* cloud_model_ = nullptr;       // owned by the list view's selection model
+    CloudRowStyle cloud_row_style_ = CloudRowStyle::Browse;
+    GtkWidget* cloud_view_stack_ = nullptr;    // "list" or "status"
+    GtkWidget* cloud_status_spinner_ = nullptr;
+    GtkWidget* cloud_status_icon_ = nullptr;
+    GtkWidget* cloud_status_label_ = nullptr;
+    bool cloud_loading_ = false;
     GtkWidget* local_tree_ = nullptr;
     GtkWidget* path_bar_ = nullptr;
     GtkWidget* cloud_scroll_ = nullptr;
@@ -201,18 +230,9 @@ private:
     bool search_waiting_for_index_ = false;
     std::string current_cloud_path_ = "/";
     std::string current_local_path_;
-    
-    // Cloud file cache to avoid blocking UI
-    struct CloudFileCache {
-        std::string path;
-        std::string json_data;
-        std::chrono::steady_clock::time_point timestamp;
-        bool valid() const {
-            auto age = std::chrono::steady_clock::now() - timestamp;
-            return !json_data.empty() && age < std::chrono::minutes(5);
-        }
-    };
-    std::map<std::string, CloudFileCache> cloud_cache_;
+    // Last validated browse listing, saved as the next launch's first paint
+    CloudDirCache::ListingPtr last_listing_;
+    std::string last_listing_path_;
     
     // Logs panel (bottom)
     GtkWidget* logs_revealer_ = nullptr;
@@ -238,15 +258,7 @@ private:
     int completed_transfers_ = 0;
     int total_transfers_ = 0;
     
-    // Auto-download tracking to prevent duplicate downloads
-    std::set<std::string> active_downloads_;  // Tracks paths currently being downloaded
-    std::mutex download_mutex_;                // Protects active_downloads_
-    
-    // Cloud monitoring state
-    std::atomic<bool> cloud_monitoring_active_{false};
     std::atomic<bool> cloud_discovery_running_{false};  // Tracks async device discovery
-    std::thread cloud_monitor_thread_;
-    std::map<std::string, std::time_t> last_cloud_check_;  // job_id -> last check time
     
     // Hamburger menu contents
     GtkWidget* service_status_label_ = nullptr;
@@ -278,6 +290,9 @@ private:
     // Drop zone styling
     void set_drop_zone_highlight(bool active);
     
+    // Ctrl+Shift+T: start tracing, or stop and export it
+    void toggle_tracing();
+    
     // Button click handlers  
     void on_start_clicked();
     void on_stop_clicked();
@@ -295,8 +310,12 @@ private:
     // File browser methods
     void refresh_cloud_files();
     void refresh_cloud_files_async(bool force_refresh = false);
-    void populate_cloud_tree(const std::string& json_data);
-    void populate_cloud_tree_from_index(const std::vector<IndexedFile>& files);
+    void show_cloud_listing(const CloudDirCache::ListingPtr& listing, bool final);
+    void show_cloud_rows(std::vector<IndexedFile> files, CloudRowStyle style);
+    void show_cloud_status(const std::string& message, const char* icon_name = nullptr, bool spinner = false);
+    void queue_auto_download(const std::string& cloud_path, const std::string& name);
+    bool download_cloud_file(const std::string& remote, const std::string& local_path,
+                             const std::string& transfer_name, int timeout_seconds);
     void refresh_local_files();
     void navigate_cloud(const std::string& path);
     void navigate_local(const std::string& path);
@@ -305,14 +324,23 @@ private:
     void perform_search(const std::string& query);
     void invalidate_cloud_cache();  // Clear all cached cloud data
     
-    // Cloud monitoring for automatic sync
+    // Cloud monitoring for automatic sync (proton::CloudMonitor)
     void start_cloud_monitoring();
     void stop_cloud_monitoring();
-    void monitor_cloud_changes();  // Check for new/changed files in synced folders
     
-    // Status polling
-    void poll_status();
-    void poll_sync_activity();
+    // Engine-side services (cloud monitor, status bus, metrics)
+    void start_engine_services();
+    // proton-drive-daemon left the bus: run the engine here once its lock is free
+    void take_over_engine();
+    guint engine_takeover_id_ = 0;
+    int engine_takeover_attempts_ = 0;
+    
+    // Status display, driven by StatusService changes
+    void on_status_changed(const proton::SyncStatus& status);
+    void show_status(const proton::SyncStatus& status);
+    void refresh_sync_activity();
+    int status_listener_id_ = 0;
+    uint32_t last_running_syncs_ = 0;
     
     // Conflict resolution UI
     void refresh_conflicts();
@@ -337,6 +365,17 @@ private:
     // File drop handling
     void handle_dropped_files(const std::vector<std::string>& paths);
     void handle_cloud_drop(const std::vector<std::string>& local_paths, const std::string& cloud_folder);
+    
+    // One dropped file or folder; all items sharing a parent folder upload together
+    struct DropUploadItem {
+        std::string local_path;
+        std::string filename;     // Transfer row name and top-level entry in the batch
+        std::string remote_path;  // Cloud path of the uploaded item
+        bool is_dir = false;
+    };
+    // Runs on the transfer lane: one `rclone copy --files-from-raw` per batch
+    void upload_drop_batch(const std::string& source_dir, const std::vector<DropUploadItem>& items,
+                           const std::string& cloud_folder);
     void show_sync_from_local_dialog(const std::string& local_path);
     void start_local_to_cloud_sync(const std::string& local_path,
                                    const std::string& remote_path,
@@ -8,11 +8,18 @@
 #include "device_identity.hpp"
 #include "notifications.hpp"
 #include "settings.hpp"
+#include "sync_scheduler.hpp"
+#include "local_state.hpp"
+#include "hash_service.hpp"
+#include "local_scanner.hpp"
+#include "daemon_service.hpp"
 #include "logger.hpp"
 #include <fstream>
 #include <filesystem>
 #include <algorithm>
+#include <sstream>
 #include <thread>
+#include <unordered_map>
 #include <gtk/gtk.h>
 #include <glib-object.h>
 #include <glib.h>
@@ -311,30 +318,23 @@ static void on_cleanup_confirm_delete_everywhere(GtkButton*, gpointer data) {
 }
 
 void AppWindow::on_start_clicked() {
-    append_log("[Service] Starting all sync job timers...");
-    std::thread([]() {
-        // Start all job timers
-        run_system("for timer in ~/.config/systemd/user/proton-drive-job-*.timer; do "
-                   "systemctl --user start \"$(basename \"$timer\")\" 2>/dev/null; done");
-    }).detach();
-    
-    g_timeout_add(1000, [](gpointer data) -> gboolean {
-        static_cast<AppWindow*>(data)->poll_status();
-        return G_SOURCE_REMOVE;
-    }, this);
+    append_log("[Service] Resuming scheduled sync for all jobs...");
+    if (SyncManager::getInstance().runs_engine()) {
+        proton::SyncScheduler::getInstance().resume();
+        proton::StatusService::getInstance().refresh();
+    } else {
+        proton::DaemonClient::call("Resume");
+    }
 }
 
 void AppWindow::on_stop_clicked() {
-    append_log("[Service] Stopping all sync job timers...");
-    std::thread([]() {
-        // Stop all job timers
-        run_system("systemctl --user stop 'proton-drive-job-*.timer' 2>/dev/null");
-    }).detach();
-    
-    g_timeout_add(1000, [](gpointer data) -> gboolean {
-        static_cast<AppWindow*>(data)->poll_status();
-        return G_SOURCE_REMOVE;
-    }, this);
+    append_log("[Service] Pausing scheduled sync for all jobs...");
+    if (SyncManager::getInstance().runs_engine()) {
+        proton::SyncScheduler::getInstance().pause();
+        proton::StatusService::getInstance().refresh();
+    } else {
+        proton::DaemonClient::call("Pause");
+    }
 }
 
 void AppWindow::on_add_sync_clicked() {
@@ -438,8 +438,83 @@ struct ConflictDialogData {
     std::string sync_type;
     std::string new_remote_path;  // Alternative path with device name
     GtkWidget* dialog;
+    std::shared_ptr<std::atomic<bool>> closed;  // Stops the content comparison
 };
 
+// Compare a local folder with an existing cloud folder by SHA-1, so the
+// user can tell whether merging would overwrite anything
+static std::string compare_folder_contents(const std::string& local_path, const std::string& remote_path,
+                                           const std::atomic<bool>& cancel) {
+    constexpr size_t MAX_FILES = 20000;
+
+    // "<sha1>  <path>" per file. Files the backend has no hash for get a
+    // space-padded hash column, so split after it rather than at the first
+    // double space.
+    constexpr size_t HASH_COLUMN = 40;
+    std::unordered_map<std::string, std::string> cloud;
+    std::istringstream listing(exec_rclone_with_timeout(
+        "hashsum sha1 " + shell_escape("proton:" + remote_path), 120));
+    for (std::string line; std::getline(listing, line);) {
+        size_t sep = line.find("  ", HASH_COLUMN);
+        if (sep != HASH_COLUMN || sep + 2 >= line.size()) continue;
+        std::string hash = line.substr(0, HASH_COLUMN);
+        cloud[line.substr(sep + 2)] = hash.find(' ') == std::string::npos ? hash : "";
+    }
+    if (cancel.load()) return "";
+    if (cloud.empty()) return "Could not read the cloud folder's contents.";
+
+    std::vector<std::string> rel_paths;
+    std::vector<std::string> full_paths;
+    size_t only_local = 0;
+    size_t unverified = 0;  // Present on both sides, no cloud hash to compare
+    std::error_code ec;
+    fs::recursive_directory_iterator it(local_path, fs::directory_options::skip_permission_denied, ec);
+    for (; !ec && it != fs::recursive_directory_iterator() && rel_paths.size() < MAX_FILES; it.increment(ec)) {
+        if (!it->is_regular_file(ec)) continue;
+        std::string rel = it->path().lexically_relative(local_path).string();
+        auto match = cloud.find(rel);
+        if (match == cloud.end()) {
+            only_local++;
+            continue;
+        }
+        if (match->second.empty()) {
+            unverified++;
+            continue;
+        }
+        rel_paths.push_back(rel);
+        full_paths.push_back(it->path().string());
+    }
+    // Stopped at the cap (or by an error): cloud files not reached may still
+    // exist locally, so nothing can be called cloud-only
+    bool partial = ec || it != fs::recursive_directory_iterator();
+
+    auto hashes = proton::HashService::getInstance().hash_files(full_paths, &cancel);
+    if (cancel.load()) return "";
+
+    size_t identical = 0;
+    size_t differ = 0;
+    for (size_t i = 0; i < rel_paths.size(); ++i) {
+        if (hashes[i] == cloud[rel_paths[i]]) identical++;
+        else differ++;
+    }
+    if (partial) {
+        return "Compared the first " + std::to_string(rel_paths.size()) + " files by content: " +
+               std::to_string(identical) + " identical, " + std::to_string(differ) + " different, " +
+               std::to_string(only_local) + " only on this device" +
+               (unverified > 0 ? ", " + std::to_string(unverified) + " not checked" : "") +
+               ". The rest of the folder was not compared.";
+    }
+    size_t only_cloud = cloud.size() - identical - differ - unverified;
+
+    if (differ == 0 && only_local == 0 && only_cloud == 0 && unverified == 0) {
+        return "Contents match your local folder (" + std::to_string(identical) + " files) - merging changes nothing.";
+    }
+    return "Compared by content: " + std::to_string(identical) + " identical, " +
+           std::to_string(differ) + " different, " + std::to_string(only_local) +
+           " only on this device, " + std::to_string(only_cloud) + " only in the cloud" +
+           (unverified > 0 ? " (" + std::to_string(unverified) + " not checked)." : ".");
+}
+
 static void show_conflict_resolution_dialog(GtkWindow* parent,
                                              AppWindow* self,
                                              const std::string& title,
@@ -493,9 +568,31 @@ static void show_conflict_resolution_dialog(GtkWindow* parent,
     std::string new_remote = fs::path(remote_path).parent_path().string() + "/" + 
                              folder_name + "-" + this_device_name;
     
-    auto* data = new ConflictDialogData{self, local_path, remote_path, sync_type, new_remote, dialog};
+    auto closed = std::make_shared<std::atomic<bool>>(false);
+    auto* data = new ConflictDialogData{self, local_path, remote_path, sync_type, new_remote, dialog, closed};
     g_object_set_data_full(G_OBJECT(dialog), "conflict-data", data,
-        +[](gpointer p) { delete static_cast<ConflictDialogData*>(p); });
+        +[](gpointer p) {
+            auto* d = static_cast<ConflictDialogData*>(p);
+            d->closed->store(true);
+            delete d;
+        });
+    
+    // Content comparison fills in while the user reads the options
+    if (allow_merge) {
+        GtkWidget* compare_label = gtk_label_new("Comparing folder contents...");
+        gtk_widget_add_css_class(compare_label, "dim-label");
+        gtk_label_set_wrap(GTK_LABEL(compare_label), TRUE);
+        gtk_label_set_xalign(GTK_LABEL(compare_label), 0);
+        gtk_box_insert_child_after(GTK_BOX(box), compare_label, body);
+        
+        proton::TaskPool::getInstance().submit(proton::TaskLane::Background, [closed, compare_label, local_path, remote_path]() {
+            std::string summary = compare_folder_contents(local_path, remote_path, *closed);
+            proton::TaskPool::post_to_main([closed, compare_label, summary]() {
+                if (closed->load() || summary.empty()) return;
+                gtk_label_set_text(GTK_LABEL(compare_label), summary.c_str());
+            });
+        });
+    }
     
     // Button box
     GtkWidget* btn_box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 8);
@@ -769,7 +866,7 @@ void AppWindow::perform_sync_after_conflict_resolution(const std::string& local_
     
     auto* data = new AsyncData{this, local_path, remote_path, sync_type, resolution, folder_display};
     
-    std::thread([data]() {
+    proton::TaskPool::getInstance().submit(proton::TaskLane::Interactive, [data]() {
         auto& registry = SyncJobRegistry::getInstance();
         
         std::string job_id = registry.createJob(data->local_path, data->remote_path, data->sync_type);
@@ -831,7 +928,7 @@ void AppWindow::perform_sync_after_conflict_resolution(const std::string& local_
         }, ui_data);
         
         delete data;
-    }).detach();
+    });
 }
 
 void AppWindow::on_add_profile_clicked() {
@@ -1252,7 +1349,7 @@ void AppWindow::on_test_connection_clicked() {
     
     TestData* test_data = new TestData{this, progress_dialog, status_label, spinner};
     
-    std::thread([test_data]() {
+    proton::TaskPool::getInstance().submit(proton::TaskLane::Interactive, [test_data]() {
         try {
             // Test connection with a simple lsjson command
             std::string rclone_path = get_rclone_path();
@@ -1319,7 +1416,7 @@ void AppWindow::on_test_connection_clicked() {
             Logger::error("[Connection] Test exception: " + std::string(e.what()));
             delete test_data;
         }
-    }).detach();
+    });
 }
 
 void AppWindow::on_settings_clicked() {
@@ -1743,7 +1840,7 @@ void AppWindow::show_local_cleanup_dialog() {
         gtk_progress_bar_set_text(GTK_PROGRESS_BAR(progress_bar), "");
     } else {
         // Async scan
-        std::thread scan_thread([this, cancel_flag, dialog, progress_bar, list_box, move_btn, cloud_only_btn, delete_everywhere_btn, items]() {
+        proton::TaskPool::getInstance().submit(proton::TaskLane::Interactive, [this, cancel_flag, dialog, progress_bar, list_box, move_btn, cloud_only_btn, delete_everywhere_btn, items]() {
             try {
                 Logger::info("[LocalCleanup] Starting scan...");
                 // Scan all synced folders
@@ -1785,33 +1882,54 @@ void AppWindow::show_local_cleanup_dialog() {
                         continue;
                     }
                     
-                    // Scan only regular files (skip directories for now to simplify)
+                    // Jobs with recorded local state need no walk: take their
+                    // largest files, skipping rows the watcher has not caught up on
                     int file_count = 0;
-                    try {
-                        for (auto& entry : fs::recursive_directory_iterator(local_path, fs::directory_options::skip_permission_denied)) {
-                            try {
-                                if (entry.is_regular_file()) {
-                                    int64_t size = entry.file_size();
-                                    if (size > 0) {
-                                        CleanupItem item;
-                                        item.path = entry.path().string();
-                                        item.size = size;
-                                        item.is_dir = false;
-                                        
-                                        // Compute cloud path
-                                        fs::path relative = fs::relative(entry.path(), local_path);
-                                        item.cloud_path = remote_path + "/" + relative.string();
-                                        
-                                        items->push_back(item);
-                                        file_count++;
-                                    }
-                                }
-                            } catch (const std::exception& e) {
-                                Logger::debug("[LocalCleanup] Skipping file " + entry.path().string() + ": " + e.what());
-                            }
+                    auto& local_state = proton::LocalStateStore::getInstance();
+                    if (local_state.has_state(job.job_id)) {
+                        auto rows = local_state.files(job.job_id);
+                        std::sort(rows.begin(), rows.end(), [](const proton::LocalFileState& a, const proton::LocalFileState& b) {
+                            return a.size > b.size;
+                        });
+                        for (const auto& row : rows) {
+                            if (file_count >= 100 || row.size <= 0) break;
+                            std::string full_path = (fs::path(local_path) / row.path).string();
+                            if (!safe_exists(full_path)) continue;
+                            CleanupItem item;
+                            item.path = full_path;
+                            item.size = row.size;
+                            item.is_dir = false;
+                            item.cloud_path = remote_path + "/" + row.path;
+                            items->push_back(item);
+                            file_count++;
                         }
-                    } catch (const std::exception& e) {
-                        Logger::error("[LocalCleanup] Failed to scan " + local_path + ": " + e.what());
+                        Logger::info("[LocalCleanup] Found " + std::to_string(file_count) + " files in " + local_path + " (from local state)");
+                        continue;
+                    }
+                    
+                    // Parallel walk for the largest regular files, streaming
+                    // running totals into the progress bar
+                    proton::LocalScanOptions options;
+                    options.cancel = cancel_flag.get();
+                    options.progress = [&](const proton::LocalScanProgress& progress) {
+                        if (cancel_flag->load()) return;
+                        std::string text = progress_text + " \u2014 " + std::to_string(progress.files) + " files, " +
+                                           format_file_size(progress.bytes);
+                        g_idle_add(+[](gpointer data) -> gboolean {
+                            auto* params = static_cast<std::pair<GtkWidget*, std::string>*>(data);
+                            gtk_progress_bar_set_text(GTK_PROGRESS_BAR(params->first), params->second.c_str());
+                            delete params;
+                            return FALSE;
+                        }, new std::pair<GtkWidget*, std::string>(progress_bar, text));
+                    };
+                    for (auto& entry : proton::LocalScanner::largest_files(local_path, 100, options)) {
+                        CleanupItem item;
+                        item.path = (fs::path(local_path) / entry.path).string();
+                        item.size = entry.size;
+                        item.is_dir = false;
+                        item.cloud_path = remote_path + "/" + entry.path;
+                        items->push_back(item);
+                        file_count++;
                     }
                     
                     Logger::info("[LocalCleanup] Found " + std::to_string(file_count) + " files in " + local_path);
@@ -1902,7 +2020,6 @@ void AppWindow::show_local_cleanup_dialog() {
                 }
             }
         });
-        scan_thread.detach();
     }
     
     // Connect buttons
@@ -8,10 +8,15 @@
 #include "app_window_helpers.hpp"
 #include "logger.hpp"
 #include "sync_job_metadata.hpp"
-#include <gtk/gtk.h>
+#include "rclone_rc.hpp"
+#include "process_tracker.hpp"
+#include "trace.hpp"
+#include <glib.h>
 #include <filesystem>
 #include <fstream>
 #include <array>
+#include <cctype>
+#include <cstdlib>
 #include <memory>
 #include <vector>
 #include <unistd.h>
@@ -38,7 +43,9 @@ std::string shell_escape(const std::string& arg) {
     return result;
 }
 
-std::string get_rclone_path() {
+namespace {
+
+std::string find_rclone() {
     // Check for AppImage bundled rclone first
     const char* appdir = std::getenv("APPDIR");
     if (appdir) {
@@ -81,7 +88,26 @@ std::string get_rclone_path() {
     return "rclone";
 }
 
+} // namespace
+
+std::string get_rclone_path() {
+    // The candidates don't move while we run; probe (and log) them once
+    static const std::string path = find_rclone();
+    return path;
+}
+
 std::string exec_rclone(const std::string& args) {
+    proton::TraceSpan span("rclone", "exec");
+    span.set_detail(args);
+    
+    // Prefer the persistent RC daemon: one HTTP round-trip, no re-login
+    std::string rc_output;
+    int rc_exit = 0;
+    if (proton::RcloneRC::getInstance().run(args, 0, rc_output, rc_exit)) {
+        Logger::debug("[rclone] RC: " + args);
+        return rc_exit == 0 ? rc_output : "";
+    }
+    
     std::string rclone_path = get_rclone_path();
     std::string cmd = rclone_path + " " + args + " 2>/dev/null";
     Logger::debug("[rclone] Executing: " + cmd);
@@ -98,6 +124,15 @@ std::string exec_rclone(const std::string& args) {
 }
 
 std::string exec_rclone_with_timeout(const std::string& args, int timeout_seconds) {
+    proton::TraceSpan span("rclone", "exec");
+    span.set_detail(args);
+    std::string rc_output;
+    int rc_exit = 0;
+    if (proton::RcloneRC::getInstance().run(args, timeout_seconds, rc_output, rc_exit)) {
+        Logger::debug("[rclone] RC (timeout " + std::to_string(timeout_seconds) + "s): " + args);
+        return rc_exit == 0 ? rc_output : "";
+    }
+    
     std::string rclone_path = get_rclone_path();
     std::string cmd = "timeout " + std::to_string(timeout_seconds) + " " + 
                       rclone_path + " " + args + " 2>/dev/null";
@@ -116,12 +151,34 @@ std::string exec_rclone_with_timeout(const std::string& args, int timeout_second
 }
 
 int run_rclone(const std::string& args) {
+    std::string rc_output;
+    int rc_exit = 0;
+    if (proton::RcloneRC::getInstance().run(args, 0, rc_output, rc_exit)) {
+        Logger::debug("[rclone] RC run: " + args);
+        return rc_exit;
+    }
+    
     std::string rclone_path = get_rclone_path();
     std::string cmd = rclone_path + " " + args + " 2>/dev/null";
     Logger::debug("[rclone] Running: " + cmd);
     return std::system(cmd.c_str());
 }
 
+int run_rclone_with_timeout(const std::string& args, int timeout_seconds) {
+    std::string rc_output;
+    int rc_exit = 0;
+    if (proton::RcloneRC::getInstance().run(args, timeout_seconds, rc_output, rc_exit)) {
+        Logger::debug("[rclone] RC run (timeout " + std::to_string(timeout_seconds) + "s): " + args);
+        return rc_exit;
+    }
+    
+    std::string rclone_path = get_rclone_path();
+    std::string cmd = "timeout " + std::to_string(timeout_seconds) + " " +
+                      rclone_path + " " + args + " >/dev/null 2>&1";
+    Logger::debug("[rclone] Running (timeout " + std::to_string(timeout_seconds) + "s): " + cmd);
+    return std::system(cmd.c_str());
+}
+
 std::string exec_command(const char* cmd) {
     try {
         std::array<char, 128> buffer;
@@ -214,13 +271,13 @@ std::pair<std::string, std::string> get_sync_status_for_path(const std::string&
     
     // Use SyncJobRegistry as the single source of truth (matches Sync Jobs tab)
     auto& registry = SyncJobRegistry::getInstance();
-    auto all_jobs = registry.getAllJobs();
+    auto snapshot = registry.snapshot();
     
     bool found_matching_job = false;
     std::string local_path_found;
     std::string local_file_path;
     
-    for (const auto& job : all_jobs) {
+    for (const auto& job : snapshot->jobs) {
         std::string remote_check = job.remote_path;
         if (!remote_check.empty() && remote_check.front() == '/') {
             remote_check = remote_check.substr(1);
@@ -265,20 +322,8 @@ std::pair<std::string, std::string> get_sync_status_for_path(const std::string&
     }
     
     // Check if rclone is currently running for this sync job
-    std::string ps_cmd = "pgrep -a rclone 2>/dev/null | grep -E '(bisync|sync|copy)' | grep -F " + 
-                        shell_escape(local_path_found) + " 2>/dev/null | wc -l";
-    FILE* pipe = popen(ps_cmd.c_str(), "r");
-    if (pipe) {
-        char buffer[32] = {0};
-        if (fgets(buffer, sizeof(buffer), pipe)) {
-            int count = std::atoi(buffer);
-            pclose(pipe);
-            if (count > 0) {
-                return {"⏳ Pending", "sync-badge-pending"};
-            }
-        } else {
-            pclose(pipe);
-        }
+    if (proton::ProcessTracker::getInstance().is_syncing_path(local_path_found)) {
+        return {"⏳ Pending", "sync-badge-pending"};
     }
     
     return {"✓ Synced", "sync-badge-synced"};
@@ -400,4 +445,48 @@ std::string format_file_size(int64_t bytes) {
     return buf;
 }
 
+// "12.500 MiB", "12.500Mi", "100 MBytes", "512 B" -> bytes
+static bool parse_rclone_size(const char* text, int64_t& bytes) {
+    char* end = nullptr;
+    double value = std::strtod(text, &end);
+    if (end == text) return false;
+    while (*end == ' ') end++;
+    double scale = 1;
+    switch (*end) {
+        case 'k':
+        case 'K': scale = 1024.0; break;
+        case 'M': scale = 1024.0 * 1024; break;
+        case 'G': scale = 1024.0 * 1024 * 1024; break;
+        case 'T': scale = 1024.0 * 1024 * 1024 * 1024; break;
+        case 'P': scale = 1024.0 * 1024 * 1024 * 1024 * 1024; break;
+        default: break;
+    }
+    bytes = static_cast<int64_t>(value * scale);
+    return true;
+}
+
+bool parse_rclone_stats_line(const std::string& line, RcloneStats& out) {
+    size_t slash = line.find(" / ");
+    size_t percent = line.find("%, ", slash == std::string::npos ? 0 : slash);
+    if (slash == std::string::npos || percent == std::string::npos) return false;
+    
+    // Walk back over "<number>[ ]<unit>" to the start of the transferred size
+    size_t start = line.find_last_of(" :", slash - 1);
+    if (start != std::string::npos && start > 0 && std::isalpha(static_cast<unsigned char>(line[start + 1]))) {
+        start = line.find_last_of(" :", start - 1);
+    }
+    start = start == std::string::npos ? 0 : start + 1;
+    
+    RcloneStats stats;
+    if (!parse_rclone_size(line.c_str() + start, stats.bytes) ||
+        !parse_rclone_size(line.c_str() + slash + 3, stats.total)) {
+        return false;
+    }
+    size_t speed_start = percent + 3;
+    size_t speed_end = line.find(',', speed_start);
+    stats.speed = line.substr(speed_start, speed_end == std::string::npos ? std::string::npos : speed_end - speed_start);
+    out = stats;
+    return true;
+}
+
 } // namespace AppWindowHelpers
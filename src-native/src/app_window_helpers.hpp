@@ -14,12 +14,14 @@ namespace AppWindowHelpers {
 std::string shell_escape(const std::string& arg);
 
 /**
- * Get path to rclone binary (AppImage bundled or system)
+ * Get path to rclone binary (AppImage bundled or system), resolved once
  */
 std::string get_rclone_path();
 
 /**
- * Execute rclone command and capture output
+ * Execute rclone command and capture output.
+ * Routed through the persistent RC daemon when it understands the command,
+ * otherwise a fresh rclone process is spawned.
  */
 std::string exec_rclone(const std::string& args);
 
@@ -34,6 +36,12 @@ std::string exec_rclone_with_timeout(const std::string& args, int timeout_second
  */
 int run_rclone(const std::string& args);
 
+/**
+ * Run rclone command with a timeout (in seconds) without capturing output.
+ * Returns the exit status (0 on success).
+ */
+int run_rclone_with_timeout(const std::string& args, int timeout_seconds);
+
 /**
  * Execute shell command and capture output
  */
@@ -74,6 +82,22 @@ bool run_rclone_config_create(const std::string& username,
  */
 std::string format_file_size(int64_t size);
 
+/**
+ * One rclone --stats-one-line summary, e.g.
+ * "12.500 MiB / 100 MiB, 12%, 4.200 MiB/s, ETA 20s"
+ */
+struct RcloneStats {
+    int64_t bytes = 0;
+    int64_t total = 0;
+    std::string speed;          // As rclone printed it ("4.200 MiB/s")
+};
+
+/**
+ * Parse a stats line from rclone's output (log prefix allowed).
+ * Returns false for every other line.
+ */
+bool parse_rclone_stats_line(const std::string& line, RcloneStats& out);
+
 /**
  * Safe filesystem operations that never throw exceptions.
  * These wrappers use std::error_code to handle I/O errors gracefully.
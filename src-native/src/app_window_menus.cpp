@@ -8,6 +8,7 @@
 #include "trash_manager.hpp"
 #include "notifications.hpp"
 #include "logger.hpp"
+#include "transfer_scheduler.hpp"
 #include <fstream>
 #include <filesystem>
 #include <thread>
@@ -323,10 +324,16 @@ void AppWindow::show_cloud_context_menu(const std::string& path, bool is_dir, do
             const char* p = static_cast<const char*>(g_object_get_data(G_OBJECT(btn), "path"));
             auto* self = static_cast<AppWindow*>(data);
             std::string dest = std::string(getenv("HOME")) + "/Downloads/" + fs::path(p).filename().string();
-            std::string cmd = "rclone copy " + shell_escape("proton:" + std::string(p)) + " " + 
-                             shell_escape(fs::path(dest).parent_path().string() + "/") + " &";
+            std::string remote = "proton:" + std::string(p);
             self->append_log("[Download] " + std::string(p) + " → ~/Downloads/");
-            run_system(cmd);
+            proton::TaskPool::getInstance().submit(proton::TaskLane::Transfer, [self, remote, dest]() {
+                auto ticket = proton::TransferScheduler::getInstance().begin(proton::TransferPriority::UserCopy, remote);
+                bool ok = self->download_cloud_file(remote, dest, "", 600);
+                std::string name = fs::path(dest).filename().string();
+                proton::TaskPool::post_to_main([self, name, ok]() {
+                    self->append_log(ok ? "[Download] ✓ Saved ~/Downloads/" + name : "[Error] Failed to download " + name);
+                });
+            });
             GtkWidget* pop = gtk_widget_get_ancestor(GTK_WIDGET(btn), GTK_TYPE_POPOVER);
             if (pop) gtk_popover_popdown(GTK_POPOVER(pop));
         }), this);
@@ -433,13 +440,16 @@ void AppWindow::show_cloud_context_menu(const std::string& path, bool is_dir, do
         gtk_widget_add_css_class(remove_local_btn, "flat-button");
         char* local_p = g_strdup(local_item_path.c_str());
         g_object_set_data_full(G_OBJECT(remove_local_btn), "local_path", local_p, g_free);
+        std::string cloud_item_path = (!path.empty() && path.front() != '/') ? "/" + path : path;
+        g_object_set_data_full(G_OBJECT(remove_local_btn), "cloud_path", g_strdup(cloud_item_path.c_str()), g_free);
         g_signal_connect(remove_local_btn, "clicked", G_CALLBACK(+[](GtkButton* btn, gpointer data) {
             const char* lp = static_cast<const char*>(g_object_get_data(G_OBJECT(btn), "local_path"));
+            const char* cp = static_cast<const char*>(g_object_get_data(G_OBJECT(btn), "cloud_path"));
             auto* self = static_cast<AppWindow*>(data);
             
             // Move to trash using TrashManager
             std::string local_path_str(lp);
-            if (proton::TrashManager::getInstance().move_to_trash(local_path_str)) {
+            if (proton::TrashManager::getInstance().move_to_trash(local_path_str, cp ? cp : "")) {
                 self->append_log("[Remove] Moved to trash: " + local_path_str + " (cloud copy preserved)");
                 
                 // Show notification to user
@@ -731,7 +741,7 @@ void AppWindow::show_version_history_dialog(const std::string& cloud_path) {
     
     VersionData* vdata = new VersionData{this, dialog, main_box, spinner, loading_label, cloud_path};
     
-    std::thread([vdata]() {
+    proton::TaskPool::getInstance().submit(proton::TaskLane::Interactive, [vdata]() {
         // Run rclone backend versions command
         std::string cmd = "rclone backend versions proton: remote:" + shell_escape(vdata->cloud_path) + " 2>&1";
         std::array<char, 256> buffer;
@@ -775,7 +785,7 @@ void AppWindow::show_version_history_dialog(const std::string& cloud_path) {
             delete vd;
             return G_SOURCE_REMOVE;
         }, vdata);
-    }).detach();
+    });
 }
 
 void AppWindow::show_cloud_delete_confirm(const std::string& path, bool is_folder) {
@@ -860,7 +870,7 @@ void AppWindow::show_cloud_delete_confirm(const std::string& path, bool is_folde
         del->self->append_log("[Delete] Removing from cloud: " + del->path);
         
         auto* self_ptr = del->self;
-        std::thread([cmd, self_ptr]() {
+        proton::TaskPool::getInstance().submit(proton::TaskLane::Interactive, [cmd, self_ptr]() {
             int ret = system(cmd.c_str());
             (void)ret;
             g_idle_add(+[](gpointer data) -> gboolean {
@@ -868,7 +878,7 @@ void AppWindow::show_cloud_delete_confirm(const std::string& path, bool is_folde
                 self->refresh_cloud_files();
                 return G_SOURCE_REMOVE;
             }, self_ptr);
-        }).detach();
+        });
         
         gtk_window_destroy(GTK_WINDOW(del->dialog));
     }), dialog);
@@ -1,19 +1,22 @@
-// app_window_polling.cpp - Sync activity polling for AppWindow
-// Extracted from app_window.cpp to reduce file size
+// app_window_polling.cpp - Sync activity list for AppWindow
+// Extracted from app_window.cpp to reduce file size. Redrawn when
+// StatusService reports a change, not on a timer.
 
 #include "app_window.hpp"
 #include "app_window_helpers.hpp"
 #include "sync_manager.hpp"
 #include "sync_job_metadata.hpp"
 #include "notifications.hpp"
+#include "process_tracker.hpp"
+#include "local_scanner.hpp"
+#include "task_pool.hpp"
 #include "logger.hpp"
 #include <fstream>
 #include <filesystem>
+#include <mutex>
 #include <set>
 #include <sstream>
-#include <thread>
 #include <chrono>
-#include <signal.h>
 #include <cerrno>
 #include <cstring>
 #include <gtk/gtk.h>
@@ -21,35 +24,19 @@
 namespace fs = std::filesystem;
 using namespace AppWindowHelpers;
 
-void AppWindow::poll_sync_activity() {
+void AppWindow::refresh_sync_activity() {
     // Only log on first call or errors
     static bool first_call = true;
     if (first_call) {
-        Logger::debug("[poll_sync_activity] First poll");
+        Logger::debug("[SyncActivity] First poll");
         first_call = false;
     }
     
     if (!sync_activity_list_ || !no_sync_label_) {
-        Logger::error("[poll_sync_activity] sync_activity_list_ or no_sync_label_ is null!");
+        Logger::error("[SyncActivity] sync_activity_list_ or no_sync_label_ is null!");
         return;
     }
     
-    auto extract_number = [](const std::string& s, const std::string& key, double& out) -> bool {
-        std::string needle = "\"" + key + "\":";
-        size_t pos = s.find(needle);
-        if (pos == std::string::npos) return false;
-        pos += needle.size();
-        while (pos < s.size() && (s[pos] == ' ' || s[pos] == '\t')) pos++;
-        size_t end = pos;
-        while (end < s.size() && (std::isdigit(static_cast<unsigned char>(s[end])) || s[end] == '.' || s[end] == '-')) end++;
-        if (end == pos) return false;
-        try {
-            out = std::stod(s.substr(pos, end - pos));
-            return true;
-        } catch (...) {
-            return false;
-        }
-    };
     auto format_bytes = [](double bytes) -> std::string {
         const char* units[] = {"B", "KB", "MB", "GB", "TB"};
         int idx = 0;
@@ -80,21 +67,21 @@ void AppWindow::poll_sync_activity() {
         }
         return std::string(buf);
     };
-    auto extract_rc_addr = [](const std::string& cmd) -> std::string {
-        size_t pos = cmd.find("--rc-addr=");
-        if (pos != std::string::npos) {
-            pos += std::string("--rc-addr=").size();
-            size_t end = cmd.find(' ', pos);
-            return cmd.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
-        }
-        pos = cmd.find("--rc-addr");
-        if (pos != std::string::npos) {
-            pos += std::string("--rc-addr").size();
-            while (pos < cmd.size() && cmd[pos] == ' ') pos++;
-            size_t end = cmd.find(' ', pos);
-            return cmd.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+    // ps-style etime: [[dd-]hh:]mm:ss
+    auto format_elapsed = [](long seconds) -> std::string {
+        long d = seconds / 86400;
+        long h = (seconds % 86400) / 3600;
+        long m = (seconds % 3600) / 60;
+        long sec = seconds % 60;
+        char buf[64];
+        if (d > 0) {
+            std::snprintf(buf, sizeof(buf), "%ld-%02ld:%02ld:%02ld", d, h, m, sec);
+        } else if (h > 0) {
+            std::snprintf(buf, sizeof(buf), "%02ld:%02ld:%02ld", h, m, sec);
+        } else {
+            std::snprintf(buf, sizeof(buf), "%02ld:%02ld", m, sec);
         }
-        return "";
+        return std::string(buf);
     };
     
     // Collect sync process data first (without touching widgets)
@@ -105,197 +92,101 @@ void AppWindow::poll_sync_activity() {
         bool is_initial_sync = false;
         std::string status_text;
         std::string detail;
-        std::string rc_addr;
         double progress = -1.0;  // 0.0 to 1.0, -1 = unknown
         std::vector<std::string> transferring_files;  // Files currently being transferred
         double speed_bytes = 0;
     };
     std::vector<SyncInfo> active_syncs;
+    std::vector<std::pair<std::string, bool>> finished_files;  // (name, ok) from core/transferred
     
-    // Check for active rclone processes with etime (elapsed time)
-    // Filter out internal config sync processes (.proton-sync-config) to avoid polluting the UI
-    std::string ps_output = exec_command("ps -eo pid,etime,cmd 2>/dev/null | grep -E 'rclone.*(sync|copy|bisync)' | grep -v grep | grep -v '.proton-sync-config'");
-    
-    if (!ps_output.empty()) {
-        // Parse each rclone process
-        std::stringstream ps_ss(ps_output);
-        std::string ps_line;
+    // Process discovery and RC stats are gathered off the main thread by
+    // SyncManager's poller - this is just a snapshot copy, no fork/exec
+    for (const auto& job : SyncManager::getInstance().get_rc_job_stats()) {
+        SyncInfo info;
+        // The app's rcd serves the window too; it is shown but not cancellable
+        if (!job.rc_daemon) info.pid = std::to_string(job.pid);
+        info.elapsed = format_elapsed(job.elapsed_seconds);
         
-        while (std::getline(ps_ss, ps_line) && active_syncs.size() < 5) {
-            // Skip empty lines
-            if (ps_line.empty()) continue;
-            
-            // Trim leading whitespace
-            size_t start = ps_line.find_first_not_of(" \t");
-            if (start != std::string::npos) {
-                ps_line = ps_line.substr(start);
+        // Find proton: path and the local destination that follows it
+        std::string sync_info = "Syncing...";
+        std::string local_dest = "";
+        bool seen_remote = false;
+        for (const auto& arg : job.args) {
+            if (arg == "--resync") info.is_initial_sync = true;
+            if (!seen_remote && arg.rfind("proton:", 0) == 0) {
+                seen_remote = true;
+                sync_info = arg.substr(7);  // Remove "proton:"
+                if (sync_info.empty()) sync_info = "/";
+            } else if (seen_remote && local_dest.empty() && !arg.empty() && arg.front() == '/') {
+                local_dest = arg;
+                // Shorten for display
+                const char* home = getenv("HOME");
+                if (home && local_dest.find(home) == 0) {
+                    local_dest = "~" + local_dest.substr(strlen(home));
+                }
             }
-            
-            // Parse: PID ELAPSED CMD...
-            std::istringstream iss(ps_line);
-            SyncInfo info;
-            iss >> info.pid >> info.elapsed;
-            
-            // Get rest of line (command)
-            std::string cmd;
-            std::getline(iss, cmd);
-            
-            info.is_initial_sync = (cmd.find("--resync") != std::string::npos);
-            info.rc_addr = extract_rc_addr(cmd);
-            
-            // Find proton: path
-            std::string sync_info = "Syncing...";
-            std::string local_dest = "";
-            size_t proton_pos = cmd.find("proton:");
-            if (proton_pos != std::string::npos) {
-                // Find end of proton path (either quote or space)
-                size_t start_quote = cmd.rfind('"', proton_pos);
-                size_t end_quote = cmd.find('"', proton_pos);
-                size_t space_after = cmd.find(' ', proton_pos);
-                
-                std::string remote_path;
-                if (start_quote != std::string::npos && end_quote != std::string::npos) {
-                    // Quoted path
-                    remote_path = cmd.substr(proton_pos, end_quote - proton_pos);
-                } else if (space_after != std::string::npos) {
-                    remote_path = cmd.substr(proton_pos, space_after - proton_pos);
+        }
+        info.remote_path = sync_info;
+        
+        // Build status text
+        if (job.rc_daemon) {
+            info.status_text = "App transfers (" + info.elapsed + ")";
+        } else if (info.is_initial_sync) {
+            info.status_text = "Initial sync: " + sync_info + " (" + info.elapsed + ")";
+        } else {
+            info.status_text = "Syncing: " + sync_info + " (" + info.elapsed + ")";
+        }
+        
+        // Add local destination if found
+        if (!local_dest.empty()) {
+            info.detail = "→ " + local_dest;
+        }
+        
+        if (job.has_stats) {
+            std::vector<std::string> parts;
+            if (job.total_bytes > 0) {
+                parts.push_back("Transferred: " + format_bytes(job.bytes) + " / " + format_bytes(job.total_bytes));
+            } else {
+                parts.push_back("Transferred: " + format_bytes(job.bytes));
+            }
+            if (job.speed > 0) {
+                parts.push_back("Speed: " + format_speed(job.speed));
+            }
+            if (job.eta >= 0) {
+                std::string eta_str = format_eta(job.eta);
+                if (!eta_str.empty()) parts.push_back("ETA: " + eta_str);
+            }
+            if (job.transfers >= 0) {
+                if (job.total_transfers > 0) {
+                    parts.push_back("Transfers: " + std::to_string(job.transfers) + "/" + std::to_string(job.total_transfers));
                 } else {
-                    remote_path = cmd.substr(proton_pos);
+                    parts.push_back("Transfers: " + std::to_string(job.transfers));
                 }
-                
-                if (remote_path.length() > 7) {
-                    sync_info = remote_path.substr(7);  // Remove "proton:"
-                    if (sync_info.empty()) sync_info = "/";
+            }
+            if (job.checks >= 0) {
+                if (job.total_checks > 0) {
+                    parts.push_back("Checks: " + std::to_string(job.checks) + "/" + std::to_string(job.total_checks));
                 } else {
-                    sync_info = remote_path;
-                }
-                
-                // Try to find local destination path (after the proton path)
-                size_t after_proton = end_quote != std::string::npos ? end_quote + 1 : space_after;
-                if (after_proton != std::string::npos) {
-                    size_t local_start = cmd.find("/home", after_proton);
-                    if (local_start != std::string::npos) {
-                        size_t local_end = cmd.find('"', local_start);
-                        if (local_end == std::string::npos) local_end = cmd.find(' ', local_start);
-                        if (local_end == std::string::npos) local_end = cmd.length();
-                        local_dest = cmd.substr(local_start, local_end - local_start);
-                        // Shorten for display
-                        const char* home = getenv("HOME");
-                        if (home && local_dest.find(home) == 0) {
-                            local_dest = "~" + local_dest.substr(strlen(home));
-                        }
-                    }
+                    parts.push_back("Checks: " + std::to_string(job.checks));
                 }
             }
-            info.remote_path = sync_info;
-            
-            // Build status text
-            if (info.is_initial_sync) {
-                info.status_text = "Initial sync: " + sync_info + " (" + info.elapsed + ")";
-            } else {
-                info.status_text = "Syncing: " + sync_info + " (" + info.elapsed + ")";
-            }
             
-            // Add local destination if found
-            if (!local_dest.empty()) {
-                info.detail = "→ " + local_dest;
+            // Append to existing detail (which may have local dest)
+            for (const auto& part : parts) {
+                if (!info.detail.empty()) info.detail += " • ";
+                info.detail += part;
             }
             
-            // Try to get detail from rclone RC synchronously (quick timeout)
-            if (!info.rc_addr.empty()) {
-                std::string rc_cmd = "timeout 0.3 rclone rc core/stats --rc-addr=" + info.rc_addr + " 2>/dev/null";
-                std::string rc_output = exec_command(rc_cmd.c_str());
-                if (!rc_output.empty()) {
-                    double bytes = 0, total_bytes = 0, speed = 0, eta = -1;
-                    double transfers = -1, transferring = -1, checks = -1, checking = -1;
-                    bool has_bytes = extract_number(rc_output, "bytes", bytes);
-                    bool has_total = extract_number(rc_output, "totalBytes", total_bytes);
-                    bool has_speed = extract_number(rc_output, "speed", speed);
-                    bool has_eta = extract_number(rc_output, "eta", eta);
-                    bool has_transfers = extract_number(rc_output, "transfers", transfers);
-                    bool has_transferring = extract_number(rc_output, "transferring", transferring);
-                    bool has_checks = extract_number(rc_output, "checks", checks);
-                    bool has_checking = extract_number(rc_output, "checking", checking);
-                    
-                    std::vector<std::string> parts;
-                    if (has_bytes) {
-                        if (has_total && total_bytes > 0) {
-                            parts.push_back("Transferred: " + format_bytes(bytes) + " / " + format_bytes(total_bytes));
-                        } else {
-                            parts.push_back("Transferred: " + format_bytes(bytes));
-                        }
-                    }
-                    if (has_speed && speed > 0) {
-                        parts.push_back("Speed: " + format_speed(speed));
-                    }
-                    if (has_eta && eta >= 0) {
-                        std::string eta_str = format_eta(eta);
-                        if (!eta_str.empty()) parts.push_back("ETA: " + eta_str);
-                    }
-                    if (has_transfers || has_transferring) {
-                        int total = has_transfers ? static_cast<int>(transfers) : -1;
-                        int active = has_transferring ? static_cast<int>(transferring) : -1;
-                        if (total >= 0 && active >= 0) {
-                            parts.push_back("Transfers: " + std::to_string(active) + "/" + std::to_string(total));
-                        } else if (total >= 0) {
-                            parts.push_back("Transfers: " + std::to_string(total));
-                        }
-                    }
-                    if (has_checks || has_checking) {
-                        int total = has_checks ? static_cast<int>(checks) : -1;
-                        int active = has_checking ? static_cast<int>(checking) : -1;
-                        if (total >= 0 && active >= 0) {
-                            parts.push_back("Checks: " + std::to_string(active) + "/" + std::to_string(total));
-                        } else if (total >= 0) {
-                            parts.push_back("Checks: " + std::to_string(total));
-                        }
-                    }
-                    
-                    if (!parts.empty()) {
-                        // Append to existing detail (which may have local dest)
-                        if (!info.detail.empty()) info.detail += " • ";
-                        for (size_t p = 0; p < parts.size(); p++) {
-                            if (p > 0) info.detail += " • ";
-                            info.detail += parts[p];
-                        }
-                    }                    // Calculate progress fraction
-                    if (has_total && total_bytes > 0 && has_bytes) {
-                        info.progress = std::min(1.0, bytes / total_bytes);
-                    }
-                    if (has_speed) {
-                        info.speed_bytes = speed;
-                    }
-                    
-                    // Parse transferring array to get individual file names
-                    // rclone core/stats returns "transferring": [{"name":"file.txt", ...}, ...]
-                    size_t trans_arr_pos = rc_output.find("\"transferring\"");
-                    if (trans_arr_pos != std::string::npos) {
-                        size_t arr_start = rc_output.find("[", trans_arr_pos);
-                        size_t arr_end = rc_output.find("]", arr_start);
-                        if (arr_start != std::string::npos && arr_end != std::string::npos) {
-                            std::string arr_content = rc_output.substr(arr_start, arr_end - arr_start + 1);
-                            // Find each "name":"..." entry
-                            size_t name_pos = 0;
-                            while ((name_pos = arr_content.find("\"name\"", name_pos)) != std::string::npos) {
-                                size_t colon = arr_content.find(":", name_pos);
-                                if (colon == std::string::npos) break;
-                                size_t val_start = arr_content.find("\"", colon + 1);
-                                if (val_start == std::string::npos) break;
-                                size_t val_end = arr_content.find("\"", val_start + 1);
-                                if (val_end == std::string::npos) break;
-                                std::string fname = arr_content.substr(val_start + 1, val_end - val_start - 1);
-                                if (!fname.empty()) {
-                                    info.transferring_files.push_back(fname);
-                                }
-                                name_pos = val_end + 1;
-                            }
-                        }
-                    }
-                }
+            // Calculate progress fraction
+            if (job.total_bytes > 0) {
+                info.progress = std::min(1.0, job.bytes / job.total_bytes);
             }
-            
-            active_syncs.push_back(info);
+            info.speed_bytes = job.speed;
+            info.transferring_files = job.transferring_files;
+            finished_files.insert(finished_files.end(), job.completed_files.begin(), job.completed_files.end());
         }
+        
+        active_syncs.push_back(info);
     }
     
     // Now update widgets - use stable slots to prevent flicker
@@ -327,6 +218,9 @@ void AppWindow::poll_sync_activity() {
             if (label && GTK_IS_LABEL(label)) {
                 gtk_label_set_text(GTK_LABEL(label), info.status_text.c_str());
             }
+            if (cancel_btn) {
+                gtk_widget_set_visible(cancel_btn, !info.pid.empty());
+            }
             
             // Update cancel button PID if it exists
             if (cancel_btn && GTK_IS_BUTTON(cancel_btn)) {
@@ -413,19 +307,19 @@ void AppWindow::poll_sync_activity() {
                 
                 Logger::info("[Cancel] Stopping sync PID " + ci->pid + " (" + ci->remote_path + ")");
                 
-                // Use kill() syscall directly instead of shell command to prevent injection
-                pid_t pid = static_cast<pid_t>(std::stol(ci->pid));
-                if (kill(pid, SIGTERM) != 0) {
-                    Logger::warn("[Cancel] SIGTERM failed for PID " + ci->pid + ": " + std::strerror(errno));
-                }
-                
-                // Wait briefly and force kill if still alive
-                std::this_thread::sleep_for(std::chrono::milliseconds(500));
-                kill(pid, SIGKILL);
-                
-                Logger::info("[Cancel] Sent termination signal to PID " + ci->pid);
+                // TERM, then KILL after a grace period, both through one pinned
+                // pidfd so a recycled PID is never hit
+                int pid = std::stoi(ci->pid);
+                proton::TaskPool::getInstance().submit(proton::TaskLane::Interactive, [pid]() {
+                    if (!proton::ProcessTracker::getInstance().terminate(pid, std::chrono::milliseconds(500))) {
+                        Logger::warn("[Cancel] Could not stop PID " + std::to_string(pid) + ": " + std::strerror(errno));
+                        return;
+                    }
+                    Logger::info("[Cancel] Sent termination signal to PID " + std::to_string(pid));
+                });
             }), nullptr);
             g_object_set_data(G_OBJECT(item), "cancel_btn", cancel_btn);
+            gtk_widget_set_visible(cancel_btn, !info.pid.empty());
             
             gtk_box_append(GTK_BOX(top_row), cancel_btn);
             
@@ -514,6 +408,16 @@ void AppWindow::poll_sync_activity() {
         }
     }
     
+    // Files rclone reports as finished carry their real outcome
+    for (const auto& [fname, ok] : finished_files) {
+        for (const auto& item : active_transfers_) {
+            if (item.filename == fname && item.status != "Completed" && item.status != "Failed") {
+                complete_transfer_item(fname, ok);
+                break;
+            }
+        }
+    }
+    
     // Complete transfers that are no longer in the active transferring list
     if (!active_transfers_.empty()) {
         std::set<std::string> currently_transferring;
@@ -575,27 +479,34 @@ void AppWindow::poll_sync_activity() {
             auto& registry = SyncJobRegistry::getInstance();
             std::string clean_path = path;
             if (clean_path.front() == '/') clean_path = clean_path.substr(1);
-            for (const auto& job : registry.getAllJobs()) {
+            auto jobs = registry.snapshot();
+            for (const auto& job : jobs->jobs) {
                 std::string job_remote = job.remote_path;
                 if (!job_remote.empty() && job_remote.front() == '/') {
                     job_remote = job_remote.substr(1);
                 }
                 if (job_remote == clean_path && !job.local_path.empty()) {
-                    // Scan for conflict files
-                    std::error_code ec;
+                    // Scan for conflict files (names only, no stat)
                     std::vector<std::string> conflict_files;
-                    try {
-                        for (const auto& entry : fs::recursive_directory_iterator(job.local_path, 
-                                fs::directory_options::skip_permission_denied, ec)) {
-                            if (ec) break;
-                            std::string fname = entry.path().filename().string();
+                    std::mutex conflict_mutex;
+                    std::atomic<bool> enough{false};
+                    proton::LocalScanOptions options;
+                    options.include_dirs = true;
+                    options.regular_only = false;
+                    options.stat_files = false;
+                    options.cancel = &enough;
+                    proton::LocalScanner::scan(job.local_path, options, [&](std::vector<proton::ScannedEntry>& batch) {
+                        for (const auto& entry : batch) {
+                            std::string fname = fs::path(entry.path).filename().string();
                             if (fname.find(".conflict.") != std::string::npos || 
                                 fname.find(".sync-conflict-") != std::string::npos) {
-                                conflict_files.push_back(entry.path().string());
+                                std::lock_guard<std::mutex> lock(conflict_mutex);
                                 if (conflict_files.size() >= 10) break; // Limit scan
+                                conflict_files.push_back((fs::path(job.local_path) / entry.path).string());
+                                if (conflict_files.size() >= 10) enough = true;
                             }
                         }
-                    } catch (...) {}
+                    });
                     
                     if (!conflict_files.empty()) {
                         Logger::warn("[Sync] Found " + std::to_string(conflict_files.size()) + 
@@ -627,7 +538,7 @@ void AppWindow::poll_sync_activity() {
     previous_syncs = current_syncs;
     
     if (active_syncs.size() != last_sync_count) {
-        Logger::debug("[poll_sync_activity] Active syncs: " + std::to_string(active_syncs.size()));
+        Logger::debug("[SyncActivity] Active syncs: " + std::to_string(active_syncs.size()));
         last_sync_count = active_syncs.size();
     }
 }
@@ -6,7 +6,9 @@
 #include "sync_manager.hpp"
 #include "device_identity.hpp"
 #include "notifications.hpp"
+#include "sync_scheduler.hpp"
 #include "logger.hpp"
+#include "trace.hpp"
 #include <fstream>
 #include <filesystem>
 #include <set>
@@ -109,6 +111,7 @@ void AppWindow::update_setup_state() {
 
 void AppWindow::refresh_sync_jobs() {
     if (!jobs_list_) return;
+    proton::TraceSpan span("ui", "sync job rows");
     
     // Clear existing using proper GTK4 method
     while (TRUE) {
@@ -331,6 +334,7 @@ void AppWindow::refresh_sync_jobs() {
 
 void AppWindow::refresh_devices() {
     if (!devices_list_) return;
+    proton::TraceSpan span("ui", "device rows");
     
     Logger::info("[Devices] Refreshing device list...");
     
@@ -556,7 +560,7 @@ void AppWindow::refresh_devices() {
         gtk_list_box_append(GTK_LIST_BOX(devices_list_), searching_row);
         
         // Spawn background thread for cloud discovery (avoids blocking UI)
-        std::thread([this, this_device_id]() {
+        proton::TaskPool::getInstance().submit(proton::TaskLane::Background, [this, this_device_id]() {
             Logger::debug("[Devices] Background cloud discovery thread started");
             
             auto& registry = SyncJobRegistry::getInstance();
@@ -691,7 +695,7 @@ void AppWindow::refresh_devices() {
                 delete r;
                 return G_SOURCE_REMOVE;
             }, result);
-        }).detach();
+        });
     } else {
         Logger::info("[Devices] Found " + std::to_string(seen_devices.size()) + " device(s) from local registry");
     }
@@ -704,11 +708,7 @@ void AppWindow::update_service_status(bool is_running) {
     gtk_widget_remove_css_class(service_status_label_, "service-status-inactive");
     
     if (is_running) {
-        // Count active timers
-        std::string count_str = exec_command("systemctl --user list-units 'proton-drive-job-*.timer' --state=active --no-legend 2>/dev/null | wc -l");
-        count_str.erase(0, count_str.find_first_not_of(" \t\n"));
-        count_str.erase(count_str.find_last_not_of(" \t\n") + 1);
-        
+        std::string count_str = std::to_string(proton::SyncScheduler::getInstance().job_count());
         std::string status_text = "● Active (" + count_str + " sync jobs)";
         gtk_label_set_text(GTK_LABEL(service_status_label_), status_text.c_str());
         gtk_widget_add_css_class(service_status_label_, "service-status-active");
@@ -7,6 +7,7 @@
 #include "logger.hpp"
 #include <fstream>
 #include <filesystem>
+#include <ctime>
 #include <gtk/gtk.h>
 
 namespace fs = std::filesystem;
@@ -138,39 +139,126 @@ static void on_cloud_right_click(GtkGestureClick* gesture, gint n_press, gdouble
     Logger::info("[CloudBrowser] *** RIGHT-CLICK DETECTED *** at x=" + std::to_string(x) + ", y=" + std::to_string(y));
     auto* self = static_cast<AppWindow*>(data);
     
-    GtkWidget* listbox = self->get_cloud_tree();
+    guint position = 0;
+    PdFileItem* item = self->get_cloud_item_at(x, y, &position);
     
-    // For GtkListBox, we need to find which row is at this position
-    // Try using pick() to find the widget at these coordinates
-    GtkWidget* picked = gtk_widget_pick(listbox, x, y, GTK_PICK_DEFAULT);
-    Logger::info("[CloudBrowser] Picked widget: " + std::string(picked ? G_OBJECT_TYPE_NAME(picked) : "null"));
+    if (item) {
+        GtkSelectionModel* selection = gtk_list_view_get_model(GTK_LIST_VIEW(self->get_cloud_tree()));
+        gtk_selection_model_select_item(selection, position, TRUE);
+        std::string path = pd_file_item_get_browse_path(item);
+        bool is_dir = pd_file_item_get_file(item).is_directory;
+        Logger::info("[CloudBrowser] Showing context menu for: " + path);
+        self->show_cloud_context_menu(path, is_dir, x, y);
+    } else {
+        Logger::info("[CloudBrowser] No row found at click position");
+    }
+}
+
+// Cloud list rows are recycled: setup builds the widgets once per visible
+// slot, bind fills them from whichever PdFileItem scrolls into that slot
+static void on_cloud_row_setup(GtkSignalListItemFactory*, GtkListItem* list_item, gpointer) {
+    GtkWidget* row = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 8);
+    gtk_widget_add_css_class(row, "file-row");
+    gtk_widget_set_margin_start(row, 8);
+    gtk_widget_set_margin_end(row, 8);
+    gtk_widget_set_margin_top(row, 4);
+    gtk_widget_set_margin_bottom(row, 4);
+    
+    GtkWidget* icon = gtk_image_new();
+    gtk_box_append(GTK_BOX(row), icon);
+    
+    GtkWidget* info_box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 2);
+    gtk_widget_set_hexpand(info_box, TRUE);
+    
+    GtkWidget* name_label = gtk_label_new("");
+    gtk_widget_add_css_class(name_label, "file-name");
+    gtk_label_set_xalign(GTK_LABEL(name_label), 0);
+    gtk_label_set_ellipsize(GTK_LABEL(name_label), PANGO_ELLIPSIZE_END);
+    gtk_box_append(GTK_BOX(info_box), name_label);
+    
+    GtkWidget* details_label = gtk_label_new("");
+    gtk_widget_add_css_class(details_label, "file-size");
+    gtk_label_set_xalign(GTK_LABEL(details_label), 0);
+    gtk_box_append(GTK_BOX(info_box), details_label);
+    
+    gtk_box_append(GTK_BOX(row), info_box);
+    
+    GtkWidget* badge = gtk_label_new("");
+    gtk_box_append(GTK_BOX(row), badge);
+    
+    g_object_set_data(G_OBJECT(row), "icon", icon);
+    g_object_set_data(G_OBJECT(row), "name_label", name_label);
+    g_object_set_data(G_OBJECT(row), "details_label", details_label);
+    g_object_set_data(G_OBJECT(row), "badge", badge);
+    g_object_set_data(G_OBJECT(row), "list_item", list_item);
+    gtk_list_item_set_child(list_item, row);
+}
+
+static void on_cloud_row_bind(GtkSignalListItemFactory*, GtkListItem* list_item, gpointer data) {
+    auto* self = static_cast<AppWindow*>(data);
+    GtkWidget* row = gtk_list_item_get_child(list_item);
+    gpointer item = gtk_list_item_get_item(list_item);
+    if (!row || !item) return;
+    
+    const IndexedFile& file = pd_file_item_get_file(PD_FILE_ITEM(item));
+    GtkWidget* icon = GTK_WIDGET(g_object_get_data(G_OBJECT(row), "icon"));
+    GtkWidget* name_label = GTK_WIDGET(g_object_get_data(G_OBJECT(row), "name_label"));
+    GtkWidget* details_label = GTK_WIDGET(g_object_get_data(G_OBJECT(row), "details_label"));
+    GtkWidget* badge = GTK_WIDGET(g_object_get_data(G_OBJECT(row), "badge"));
+    
+    gtk_image_set_from_icon_name(GTK_IMAGE(icon), file.is_directory ? "folder-symbolic" : "text-x-generic-symbolic");
+    gtk_label_set_text(GTK_LABEL(name_label), file.name.c_str());
+    
+    if (self->get_cloud_row_style() == CloudRowStyle::Search) {
+        // Search results: full path under the name, size on the right
+        gtk_label_set_text(GTK_LABEL(details_label), file.path.c_str());
+        gtk_label_set_ellipsize(GTK_LABEL(details_label), PANGO_ELLIPSIZE_MIDDLE);
+        gtk_widget_set_visible(details_label, TRUE);
+        
+        gtk_label_set_text(GTK_LABEL(badge), file.is_directory ? "" : format_file_size(file.size).c_str());
+        const char* classes[] = { "file-size", nullptr };
+        gtk_widget_set_css_classes(badge, classes);
+        gtk_widget_set_visible(badge, !file.is_directory);
+        return;
+    }
     
-    // Walk up to find the GtkListBoxRow
-    GtkListBoxRow* row = nullptr;
-    GtkWidget* current = picked;
-    while (current && current != listbox) {
-        if (GTK_IS_LIST_BOX_ROW(current)) {
-            row = GTK_LIST_BOX_ROW(current);
-            Logger::info("[CloudBrowser] Found GtkListBoxRow in ancestor chain");
-            break;
+    bool show_details = !file.is_directory;
+    if (!file.is_directory) {
+        std::string details = format_file_size(file.size);
+        if (!file.mod_time.empty()) details += " • " + file.mod_time.substr(0, 10);
+        gtk_label_set_text(GTK_LABEL(details_label), details.c_str());
+    } else {
+        // Folder totals come from the index's aggregates, no walk needed
+        proton::PathTree::Summary summary;
+        if (FileIndex::getInstance().get_folder_summary(file.path, summary) && summary.files + summary.folders > 0) {
+            int64_t items = summary.files + summary.folders;
+            std::string details = std::to_string(items) + (items == 1 ? " item" : " items") + " • " +
+                                  format_file_size(summary.bytes);
+            if (summary.newest > 0) {
+                time_t newest = static_cast<time_t>(summary.newest);
+                struct tm tm_buf;
+                char date[16];
+                if (localtime_r(&newest, &tm_buf) && strftime(date, sizeof(date), "%Y-%m-%d", &tm_buf) > 0) {
+                    details += " • " + std::string(date);
+                }
+            }
+            gtk_label_set_text(GTK_LABEL(details_label), details.c_str());
+            show_details = true;
         }
-        current = gtk_widget_get_parent(current);
     }
+    gtk_label_set_ellipsize(GTK_LABEL(details_label), PANGO_ELLIPSIZE_NONE);
+    gtk_widget_set_visible(details_label, show_details);
     
-    if (row) {
-        Logger::info("[CloudBrowser] Row found, checking path data...");
-        gtk_list_box_select_row(GTK_LIST_BOX(listbox), row);
-        const char* path = static_cast<const char*>(g_object_get_data(G_OBJECT(row), "path"));
-        gboolean is_dir = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(row), "is_dir"));
-        if (path) {
-            Logger::info("[CloudBrowser] Showing context menu for: " + std::string(path));
-            self->show_cloud_context_menu(path, is_dir, x, y);
-        } else {
-            Logger::warn("[CloudBrowser] Row has no path data");
-        }
-    } else {
-        Logger::info("[CloudBrowser] No row found at click position");
+    auto [sync_status_text, sync_badge_class] = get_sync_status_for_path(pd_file_item_get_browse_path(PD_FILE_ITEM(item)));
+    if (sync_status_text.empty()) {
+        sync_status_text = "☁ Cloud";
+        sync_badge_class = "sync-badge-cloud";
     }
+    gtk_label_set_text(GTK_LABEL(badge), sync_status_text.c_str());
+    // Replaces whatever the previous occupant of this row left behind
+    const char* classes[] = { "sync-badge", sync_badge_class.c_str(), nullptr };
+    gtk_widget_set_css_classes(badge, classes);
+    gtk_widget_set_visible(badge, TRUE);
 }
 
 // Static callback for local browser right-click
@@ -371,7 +459,7 @@ void AppWindow::build_file_browser() {
             std::string cmd = "mkdir proton:" + AppWindowHelpers::shell_escape(new_folder_path);
             self->append_log("[CloudBrowser] Creating folder: " + new_folder_path);
             
-            std::thread([self, cmd, new_folder_path]() {
+            proton::TaskPool::getInstance().submit(proton::TaskLane::Interactive, [self, cmd, new_folder_path]() {
                 std::string output = AppWindowHelpers::exec_rclone(cmd);
                 
                 g_idle_add(+[](gpointer data) -> gboolean {
@@ -380,7 +468,7 @@ void AppWindow::build_file_browser() {
                     self->refresh_cloud_files_async(true);
                     return G_SOURCE_REMOVE;
                 }, self);
-            }).detach();
+            });
             
             GtkWidget* dlg = gtk_widget_get_ancestor(GTK_WIDGET(btn), GTK_TYPE_WINDOW);
             if (dlg) gtk_window_destroy(GTK_WINDOW(dlg));
@@ -401,27 +489,38 @@ void AppWindow::build_file_browser() {
                                    GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
     gtk_widget_set_vexpand(cloud_scroll_, TRUE);
     
-    cloud_tree_ = gtk_list_box_new();
+    // Virtualized list: the model keeps plain records and GtkListView only
+    // creates row widgets for what is on screen
+    cloud_model_ = pd_file_model_new();
+    GtkSingleSelection* cloud_selection = gtk_single_selection_new(G_LIST_MODEL(cloud_model_));  // takes the model ref
+    gtk_single_selection_set_autoselect(cloud_selection, FALSE);
+    gtk_single_selection_set_can_unselect(cloud_selection, TRUE);
+    
+    GtkListItemFactory* cloud_factory = gtk_signal_list_item_factory_new();
+    g_signal_connect(cloud_factory, "setup", G_CALLBACK(on_cloud_row_setup), nullptr);
+    g_signal_connect(cloud_factory, "bind", G_CALLBACK(on_cloud_row_bind), this);
+    
+    cloud_tree_ = gtk_list_view_new(GTK_SELECTION_MODEL(cloud_selection), cloud_factory);
     gtk_widget_add_css_class(cloud_tree_, "file-list");
-    gtk_list_box_set_selection_mode(GTK_LIST_BOX(cloud_tree_), GTK_SELECTION_SINGLE);
-    gtk_list_box_set_activate_on_single_click(GTK_LIST_BOX(cloud_tree_), FALSE);  // Double-click to activate
-    g_signal_connect(cloud_tree_, "row-activated", G_CALLBACK(+[](GtkListBox*, GtkListBoxRow* row, gpointer data) {
+    // Double-click (or Enter) to activate
+    g_signal_connect(cloud_tree_, "activate", G_CALLBACK(+[](GtkListView* view, guint position, gpointer data) {
         auto* self = static_cast<AppWindow*>(data);
-        const char* path = static_cast<const char*>(g_object_get_data(G_OBJECT(row), "path"));
-        gboolean is_dir = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(row), "is_dir"));
-        if (path) {
-            self->on_cloud_row_activated(path, is_dir);
-        }
+        gpointer item = g_list_model_get_item(G_LIST_MODEL(gtk_list_view_get_model(view)), position);
+        if (!item) return;
+        std::string path = pd_file_item_get_browse_path(PD_FILE_ITEM(item));
+        bool is_dir = pd_file_item_get_file(PD_FILE_ITEM(item)).is_directory;
+        g_object_unref(item);
+        self->on_cloud_row_activated(path, is_dir);
     }), this);
     
     // Add right-click context menu support (GTK4 style)
-    // Attach gesture to the listbox itself, not the scroll window
+    // Attach gesture to the list view itself, not the scroll window
     GtkGesture* cloud_click = gtk_gesture_click_new();
     gtk_gesture_single_set_button(GTK_GESTURE_SINGLE(cloud_click), 3); // Right-click
     gtk_event_controller_set_propagation_phase(GTK_EVENT_CONTROLLER(cloud_click), GTK_PHASE_BUBBLE);
     g_signal_connect(cloud_click, "pressed", G_CALLBACK(on_cloud_right_click), this);
     gtk_widget_add_controller(cloud_tree_, GTK_EVENT_CONTROLLER(cloud_click));
-    Logger::info("[CloudBrowser] Right-click gesture attached to cloud_tree_ (listbox)");
+    Logger::info("[CloudBrowser] Right-click gesture attached to cloud_tree_ (list view)");
     
     // Also add a debug gesture for ANY click to verify gestures work
     GtkGesture* cloud_any_click = gtk_gesture_click_new();
@@ -432,11 +531,32 @@ void AppWindow::build_file_browser() {
     gtk_widget_add_controller(cloud_tree_, GTK_EVENT_CONTROLLER(cloud_any_click));
     Logger::info("[CloudBrowser] Debug any-click gesture attached to cloud_tree_");
     
-    // Enable drag-and-drop on cloud list (accept local files/folders)
+    gtk_scrolled_window_set_child(GTK_SCROLLED_WINDOW(cloud_scroll_), cloud_tree_);
+    
+    // Loading / empty / error messages replace the list instead of posing as rows
+    cloud_view_stack_ = gtk_stack_new();
+    gtk_widget_set_vexpand(cloud_view_stack_, TRUE);
+    gtk_stack_add_named(GTK_STACK(cloud_view_stack_), cloud_scroll_, "list");
+    
+    GtkWidget* status_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 8);
+    gtk_widget_set_margin_start(status_box, 12);
+    gtk_widget_set_margin_top(status_box, 20);
+    gtk_widget_set_valign(status_box, GTK_ALIGN_START);
+    cloud_status_spinner_ = gtk_spinner_new();
+    gtk_box_append(GTK_BOX(status_box), cloud_status_spinner_);
+    cloud_status_icon_ = gtk_image_new();
+    gtk_box_append(GTK_BOX(status_box), cloud_status_icon_);
+    cloud_status_label_ = gtk_label_new("");
+    gtk_widget_add_css_class(cloud_status_label_, "dim-label");
+    gtk_box_append(GTK_BOX(status_box), cloud_status_label_);
+    gtk_stack_add_named(GTK_STACK(cloud_view_stack_), status_box, "status");
+    
+    // Enable drag-and-drop on cloud list (accept local files/folders).
+    // Attached to the stack so empty folders (status page) still accept drops.
     GtkDropTarget* cloud_drop = gtk_drop_target_new(G_TYPE_INVALID, GDK_ACTION_COPY);
     GType drop_types[] = { GDK_TYPE_FILE_LIST };
     gtk_drop_target_set_gtypes(cloud_drop, drop_types, 1);
-    g_signal_connect(cloud_drop, "drop", G_CALLBACK(+[](GtkDropTarget*, const GValue* value, gdouble /*x*/, gdouble y, gpointer data) -> gboolean {
+    g_signal_connect(cloud_drop, "drop", G_CALLBACK(+[](GtkDropTarget*, const GValue* value, gdouble x, gdouble y, gpointer data) -> gboolean {
         auto* self = static_cast<AppWindow*>(data);
         if (!G_VALUE_HOLDS(value, GDK_TYPE_FILE_LIST)) {
             return FALSE;
@@ -453,14 +573,14 @@ void AppWindow::build_file_browser() {
         }
         if (!paths.empty()) {
             // Check if dropped on a folder row
-            GtkListBoxRow* row = gtk_list_box_get_row_at_y(GTK_LIST_BOX(self->cloud_tree_), (int)y);
             std::string target_folder = self->current_cloud_path_;
-            
-            if (row) {
-                gboolean is_dir = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(row), "is_dir"));
-                const char* row_path = static_cast<const char*>(g_object_get_data(G_OBJECT(row), "path"));
-                if (is_dir && row_path) {
-                    target_folder = row_path;
+            double list_x = 0;
+            double list_y = 0;
+            if (gtk_widget_get_mapped(self->cloud_tree_) &&
+                gtk_widget_translate_coordinates(self->cloud_view_stack_, self->cloud_tree_, x, y, &list_x, &list_y)) {
+                PdFileItem* item = self->get_cloud_item_at(list_x, list_y);
+                if (item && pd_file_item_get_file(item).is_directory) {
+                    target_folder = pd_file_item_get_browse_path(item);
                     Logger::info("[CloudDrop] Dropped on folder: " + target_folder);
                 }
             }
@@ -469,10 +589,9 @@ void AppWindow::build_file_browser() {
         }
         return TRUE;
     }), this);
-    gtk_widget_add_controller(cloud_tree_, GTK_EVENT_CONTROLLER(cloud_drop));
+    gtk_widget_add_controller(cloud_view_stack_, GTK_EVENT_CONTROLLER(cloud_drop));
     
-    gtk_scrolled_window_set_child(GTK_SCROLLED_WINDOW(cloud_scroll_), cloud_tree_);
-    gtk_box_append(GTK_BOX(cloud_box), cloud_scroll_);
+    gtk_box_append(GTK_BOX(cloud_box), cloud_view_stack_);
     
     gtk_stack_add_titled(GTK_STACK(browser_stack_), cloud_box, "cloud", "☁ Cloud");
     
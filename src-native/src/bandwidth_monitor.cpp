@@ -1,13 +1,96 @@
 #include "bandwidth_monitor.hpp"
 #include "logger.hpp"
+#include "network_monitor.hpp"
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
+#include <ctime>
 
 namespace proton {
 
-BandwidthMonitor::BandwidthMonitor() {
-    session_stats_.session_start = std::chrono::steady_clock::now();
+// ============================================================================
+// RateCounter / Histogram
+// ============================================================================
+
+void RateCounter::add(uint64_t bytes, int64_t now_second) {
+    const uint64_t tag = static_cast<uint64_t>(now_second) & SECOND_MASK;
+    auto& bucket = buckets_[static_cast<size_t>(now_second) % buckets_.size()];
+    uint64_t old = bucket.load(std::memory_order_relaxed);
+    uint64_t next;
+    do {
+        // A bucket still tagged with an older second starts over from zero
+        uint64_t count = (old >> BYTE_BITS) == tag ? (old & BYTE_MASK) : 0;
+        next = (tag << BYTE_BITS) | std::min(count + bytes, BYTE_MASK);
+    } while (!bucket.compare_exchange_weak(old, next, std::memory_order_relaxed));
+    total_.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+double RateCounter::rate(int64_t now_second) const {
+    const uint64_t now_tag = static_cast<uint64_t>(now_second) & SECOND_MASK;
+    uint64_t sum = 0;
+    for (const auto& bucket : buckets_) {
+        uint64_t value = bucket.load(std::memory_order_relaxed);
+        uint64_t age = (now_tag - (value >> BYTE_BITS)) & SECOND_MASK;
+        if (age >= 1 && age <= WINDOW_SECONDS) sum += value & BYTE_MASK;
+    }
+    return static_cast<double>(sum) / WINDOW_SECONDS;
+}
+
+void RateCounter::reset() {
+    for (auto& bucket : buckets_) bucket.store(0, std::memory_order_relaxed);
+    total_.store(0, std::memory_order_relaxed);
+}
+
+void Histogram::record(uint64_t value) {
+    size_t index = value == 0 ? 0 : static_cast<size_t>(64 - __builtin_clzll(value));
+    buckets_[std::min(index, BUCKETS - 1)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void Histogram::reset() {
+    for (auto& bucket : buckets_) bucket.store(0, std::memory_order_relaxed);
+}
+
+Histogram::Summary Histogram::summarize() const {
+    std::array<uint64_t, BUCKETS> counts;
+    Summary summary;
+    for (size_t i = 0; i < BUCKETS; ++i) {
+        counts[i] = buckets_[i].load(std::memory_order_relaxed);
+        summary.count += counts[i];
+    }
+    if (summary.count == 0) return summary;
+
+    auto upper = [](size_t i) -> uint64_t { return i == 0 ? 0 : (1ull << i); };
+    auto percentile = [&](double p) {
+        uint64_t target = std::max<uint64_t>(1, static_cast<uint64_t>(p * summary.count + 0.5));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKETS; ++i) {
+            seen += counts[i];
+            if (seen >= target) return upper(i);
+        }
+        return upper(BUCKETS - 1);
+    };
+    summary.p50 = percentile(0.50);
+    summary.p90 = percentile(0.90);
+    summary.p99 = percentile(0.99);
+    for (size_t i = BUCKETS; i-- > 0;) {
+        if (counts[i]) {
+            summary.max = upper(i);
+            break;
+        }
+    }
+    return summary;
+}
+
+// ============================================================================
+// BandwidthMonitor - transfers
+// ============================================================================
+
+BandwidthMonitor::BandwidthMonitor()
+    : epoch_(std::chrono::steady_clock::now()),
+      jobs_(std::make_shared<const JobTable>()),
+      active_transfers_(std::make_shared<const TransferTable>()) {
+    session_start_ns_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        epoch_.time_since_epoch()).count();
 }
 
 BandwidthMonitor& BandwidthMonitor::getInstance() {
@@ -15,18 +98,59 @@ BandwidthMonitor& BandwidthMonitor::getInstance() {
     return instance;
 }
 
+int64_t BandwidthMonitor::now_second() const {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::steady_clock::now() - epoch_).count();
+}
+
+size_t BandwidthMonitor::size_class(size_t bytes) {
+    if (bytes < (1u << 20)) return 0;
+    if (bytes < (16u << 20)) return 1;
+    if (bytes < (256u << 20)) return 2;
+    return 3;
+}
+
+std::shared_ptr<BandwidthMonitor::ActiveTransfer> BandwidthMonitor::find_transfer(const std::string& id) const {
+    auto table = std::atomic_load(&active_transfers_);
+    auto it = table->find(id);
+    return it == table->end() ? nullptr : it->second;
+}
+
+std::shared_ptr<BandwidthMonitor::JobCounters> BandwidthMonitor::job_counters(const std::string& job) {
+    auto table = std::atomic_load(&jobs_);
+    auto it = table->find(job);
+    if (it != table->end()) return it->second;
+
+    std::lock_guard<std::mutex> lock(table_mutex_);
+    table = std::atomic_load(&jobs_);
+    it = table->find(job);
+    if (it != table->end()) return it->second;
+    auto next = std::make_shared<JobTable>(*table);
+    auto counters = std::make_shared<JobCounters>();
+    (*next)[job] = counters;
+    std::atomic_store(&jobs_, std::shared_ptr<const JobTable>(std::move(next)));
+    return counters;
+}
+
 void BandwidthMonitor::start_transfer(const std::string& id, const std::string& filename,
-                                       TransferType type, size_t total_bytes) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    TransferRecord record;
+                                       TransferType type, size_t total_bytes,
+                                       const std::string& job) {
+    auto transfer = std::make_shared<ActiveTransfer>();
+    TransferRecord& record = transfer->record;
     record.filename = filename;
+    record.job = job;
     record.type = type;
     record.bytes = total_bytes;
     record.start_time = std::chrono::steady_clock::now();
     record.completed = false;
+    transfer->job = job_counters(job);
     
-    active_transfers_[id] = record;
+    {
+        std::lock_guard<std::mutex> lock(table_mutex_);
+        auto next = std::make_shared<TransferTable>(*std::atomic_load(&active_transfers_));
+        (*next)[id] = transfer;
+        std::atomic_store(&active_transfers_, std::shared_ptr<const TransferTable>(std::move(next)));
+    }
     
     if (type == TransferType::UPLOAD) {
         active_uploads_++;
@@ -40,110 +164,111 @@ void BandwidthMonitor::start_transfer(const std::string& id, const std::string&
 }
 
 void BandwidthMonitor::update_progress(const std::string& id, size_t bytes_transferred) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    auto it = active_transfers_.find(id);
-    if (it == active_transfers_.end()) return;
+    auto transfer = find_transfer(id);
+    if (!transfer || bytes_transferred == 0) return;
     
-    auto& record = it->second;
-    auto now = std::chrono::steady_clock::now();
-    
-    // Calculate bytes since last update for speed calculation
-    // For simplicity, we use a rolling window approach
-    if (record.type == TransferType::UPLOAD) {
-        upload_samples_.push_back({bytes_transferred, now});
+    transfer->bytes.fetch_add(bytes_transferred, std::memory_order_relaxed);
+    int64_t second = now_second();
+    if (transfer->record.type == TransferType::UPLOAD) {
+        upload_rate_.add(bytes_transferred, second);
+        transfer->job->upload.add(bytes_transferred, second);
     } else {
-        download_samples_.push_back({bytes_transferred, now});
+        download_rate_.add(bytes_transferred, second);
+        transfer->job->download.add(bytes_transferred, second);
     }
+}
+
+void BandwidthMonitor::update_transferred(const std::string& id, size_t total_bytes_so_far) {
+    auto transfer = find_transfer(id);
+    if (!transfer) return;
     
-    // Clean old samples outside the window
-    auto cutoff = now - std::chrono::seconds(SPEED_WINDOW_SECONDS);
-    while (!upload_samples_.empty() && upload_samples_.front().second < cutoff) {
-        upload_samples_.pop_front();
-    }
-    while (!download_samples_.empty() && download_samples_.front().second < cutoff) {
-        download_samples_.pop_front();
+    // A counter that went backwards (e.g. rclone restarted its stats) just
+    // becomes the new baseline
+    size_t previous = transfer->last_cumulative.exchange(total_bytes_so_far);
+    if (total_bytes_so_far > previous) {
+        update_progress(id, total_bytes_so_far - previous);
     }
 }
 
+bool BandwidthMonitor::has_transfer(const std::string& id) const {
+    return find_transfer(id) != nullptr;
+}
+
 void BandwidthMonitor::complete_transfer(const std::string& id, bool success, 
                                           const std::string& error) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    auto it = active_transfers_.find(id);
-    if (it == active_transfers_.end()) return;
+    std::shared_ptr<ActiveTransfer> transfer;
+    {
+        std::lock_guard<std::mutex> lock(table_mutex_);
+        auto table = std::atomic_load(&active_transfers_);
+        auto it = table->find(id);
+        if (it == table->end()) return;
+        transfer = it->second;
+        auto next = std::make_shared<TransferTable>(*table);
+        next->erase(id);
+        std::atomic_store(&active_transfers_, std::shared_ptr<const TransferTable>(std::move(next)));
+    }
     
-    auto record = it->second;
+    TransferRecord record = transfer->record;
     record.end_time = std::chrono::steady_clock::now();
     record.completed = true;
     record.success = success;
     record.error = error;
+    size_t moved = transfer->bytes.load();
+    if (moved > 0) record.bytes = moved;
     
     // Update counters
     if (record.type == TransferType::UPLOAD) {
         active_uploads_--;
         if (success) {
-            session_stats_.total_uploaded += record.bytes;
-            session_stats_.files_uploaded++;
+            total_uploaded_ += record.bytes;
+            files_uploaded_++;
         }
     } else {
         active_downloads_--;
         if (success) {
-            session_stats_.total_downloaded += record.bytes;
-            session_stats_.files_downloaded++;
+            total_downloaded_ += record.bytes;
+            files_downloaded_++;
         }
     }
     
     if (!success) {
-        session_stats_.errors++;
+        errors_++;
     }
     
     // Add to history
-    completed_transfers_.push_back(record);
-    while (completed_transfers_.size() > MAX_HISTORY) {
-        completed_transfers_.pop_front();
+    {
+        std::lock_guard<std::mutex> lock(history_mutex_);
+        completed_transfers_.push_back(record);
+        while (completed_transfers_.size() > MAX_HISTORY) {
+            completed_transfers_.pop_front();
+        }
     }
     
-    active_transfers_.erase(it);
-    
     Logger::debug("[Bandwidth] Completed " + 
                  std::string(record.type == TransferType::UPLOAD ? "upload" : "download") +
                  ": " + record.filename + (success ? " (success)" : " (failed)"));
 }
 
-double BandwidthMonitor::calculate_speed(
-    const std::deque<std::pair<size_t, std::chrono::steady_clock::time_point>>& samples) const {
-    
-    if (samples.size() < 2) return 0.0;
-    
-    auto now = std::chrono::steady_clock::now();
-    auto cutoff = now - std::chrono::seconds(SPEED_WINDOW_SECONDS);
-    
-    size_t total_bytes = 0;
-    for (const auto& sample : samples) {
-        if (sample.second >= cutoff) {
-            total_bytes += sample.first;
-        }
-    }
+void BandwidthMonitor::record_file(const std::string& job, size_t bytes, std::chrono::milliseconds duration) {
+    uint64_t ms = static_cast<uint64_t>(std::max<int64_t>(duration.count(), 0));
+    // Sub-millisecond files count as taking 1 ms
+    uint64_t throughput = bytes * 1000 / std::max<uint64_t>(ms, 1);
     
-    // Calculate speed over the window period
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
-        now - samples.front().second);
+    auto counters = job_counters(job);
+    counters->latency_ms.record(ms);
+    counters->throughput.record(throughput);
     
-    if (duration.count() > 0) {
-        return (total_bytes * 1000.0) / duration.count();
-    }
-    return 0.0;
+    size_t cls = size_class(bytes);
+    size_class_latency_ms_[cls].record(ms);
+    size_class_throughput_[cls].record(throughput);
 }
 
 double BandwidthMonitor::get_current_upload_speed() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return calculate_speed(upload_samples_);
+    return upload_rate_.rate(now_second());
 }
 
 double BandwidthMonitor::get_current_download_speed() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return calculate_speed(download_samples_);
+    return download_rate_.rate(now_second());
 }
 
 std::string BandwidthMonitor::get_upload_speed_string() const {
@@ -155,7 +280,7 @@ std::string BandwidthMonitor::get_download_speed_string() const {
 }
 
 std::vector<TransferRecord> BandwidthMonitor::get_recent_transfers(size_t limit) const {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::lock_guard<std::mutex> lock(history_mutex_);
     
     std::vector<TransferRecord> result;
     size_t count = std::min(limit, completed_transfers_.size());
@@ -168,9 +293,55 @@ std::vector<TransferRecord> BandwidthMonitor::get_recent_transfers(size_t limit)
     return result;
 }
 
+std::vector<BandwidthMonitor::JobStats> BandwidthMonitor::get_job_stats() const {
+    auto table = std::atomic_load(&jobs_);
+    int64_t second = now_second();
+    
+    std::vector<JobStats> result;
+    result.reserve(table->size());
+    for (const auto& [job, counters] : *table) {
+        JobStats stats;
+        stats.job = job;
+        stats.upload_speed = counters->upload.rate(second);
+        stats.download_speed = counters->download.rate(second);
+        stats.uploaded = counters->upload.total();
+        stats.downloaded = counters->download.total();
+        stats.latency_ms = counters->latency_ms.summarize();
+        stats.throughput = counters->throughput.summarize();
+        result.push_back(std::move(stats));
+    }
+    return result;
+}
+
+double BandwidthMonitor::get_job_speed(const std::string& job) const {
+    auto table = std::atomic_load(&jobs_);
+    auto it = table->find(job);
+    if (it == table->end()) return 0.0;
+    int64_t second = now_second();
+    return it->second->upload.rate(second) + it->second->download.rate(second);
+}
+
+std::vector<BandwidthMonitor::SizeClassStats> BandwidthMonitor::get_size_class_stats() const {
+    static const char* labels[SIZE_CLASSES] = {"< 1 MB", "1-16 MB", "16-256 MB", ">= 256 MB"};
+    std::vector<SizeClassStats> result;
+    for (size_t i = 0; i < SIZE_CLASSES; ++i) {
+        result.push_back({labels[i], size_class_latency_ms_[i].summarize(),
+                          size_class_throughput_[i].summarize()});
+    }
+    return result;
+}
+
 BandwidthMonitor::CumulativeStats BandwidthMonitor::get_session_stats() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return session_stats_;
+    CumulativeStats stats;
+    stats.total_uploaded = total_uploaded_.load();
+    stats.total_downloaded = total_downloaded_.load();
+    stats.files_uploaded = files_uploaded_.load();
+    stats.files_downloaded = files_downloaded_.load();
+    stats.errors = errors_.load();
+    stats.session_start = std::chrono::steady_clock::time_point(
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::nanoseconds(session_start_ns_.load())));
+    return stats;
 }
 
 void BandwidthMonitor::set_upload_limit(size_t bytes_per_second) {
@@ -185,14 +356,102 @@ void BandwidthMonitor::set_download_limit(size_t bytes_per_second) {
                 (bytes_per_second == 0 ? "unlimited" : format_speed(bytes_per_second)));
 }
 
-void BandwidthMonitor::reset_session() {
-    std::lock_guard<std::mutex> lock(mutex_);
+void BandwidthMonitor::set_schedule(bool enabled, int start_hour, int end_hour, size_t bytes_per_second) {
+    schedule_start_hour_.store(start_hour);
+    schedule_end_hour_.store(end_hour);
+    schedule_limit_.store(bytes_per_second);
+    schedule_enabled_.store(enabled);
+    if (enabled) {
+        Logger::info("[Bandwidth] Limited to " + format_speed(bytes_per_second) + " between " +
+                     std::to_string(start_hour) + ":00 and " + std::to_string(end_hour) + ":00");
+    }
+}
+
+void BandwidthMonitor::set_metered_limit(size_t bytes_per_second) {
+    metered_limit_.store(bytes_per_second);
+}
+
+namespace {
+
+// Lower of two limits where 0 means unlimited
+size_t cap_limit(size_t limit, size_t cap) {
+    if (cap == 0) return limit;
+    return limit == 0 ? cap : std::min(limit, cap);
+}
+
+// rclone size suffix in KiB; a non-zero share never rounds down to "off"
+std::string rclone_size(size_t bytes_per_second) {
+    if (bytes_per_second == 0) return "off";
+    return std::to_string(std::max<size_t>(bytes_per_second / 1024, 1)) + "K";
+}
+
+} // namespace
+
+BandwidthMonitor::Limits BandwidthMonitor::get_effective_limits() const {
+    Limits limits;
+    limits.upload = upload_limit_.load();
+    limits.download = download_limit_.load();
     
-    session_stats_ = CumulativeStats();
-    session_stats_.session_start = std::chrono::steady_clock::now();
-    completed_transfers_.clear();
-    upload_samples_.clear();
-    download_samples_.clear();
+    if (schedule_enabled_.load()) {
+        std::time_t now = std::time(nullptr);
+        std::tm local{};
+        localtime_r(&now, &local);
+        int start = schedule_start_hour_.load();
+        int end = schedule_end_hour_.load();
+        bool in_window = start <= end ? (local.tm_hour >= start && local.tm_hour < end)
+                                      : (local.tm_hour >= start || local.tm_hour < end);
+        if (in_window) {
+            limits.upload = cap_limit(limits.upload, schedule_limit_.load());
+            limits.download = cap_limit(limits.download, schedule_limit_.load());
+        }
+    }
+    
+    if (NetworkMonitor::getInstance().is_metered()) {
+        limits.upload = cap_limit(limits.upload, metered_limit_.load());
+        limits.download = cap_limit(limits.download, metered_limit_.load());
+    }
+    return limits;
+}
+
+std::string BandwidthMonitor::get_rclone_rate(size_t shares, size_t cap) const {
+    Limits limits = get_effective_limits();
+    shares = std::max<size_t>(shares, 1);
+    auto share = [shares, cap](size_t limit) {
+        size_t rate = limit ? std::max<size_t>(limit / shares, 1) : 0;
+        return cap && (rate == 0 || rate > cap) ? cap : rate;
+    };
+    std::string up = rclone_size(share(limits.upload));
+    std::string down = rclone_size(share(limits.download));
+    return up == down ? up : up + ":" + down;
+}
+
+void BandwidthMonitor::reset_session() {
+    // Counters of running transfers are reset in place rather than
+    // dropped, so their jobs keep reporting
+    auto jobs = std::atomic_load(&jobs_);
+    for (const auto& [job, counters] : *jobs) {
+        counters->upload.reset();
+        counters->download.reset();
+        counters->latency_ms.reset();
+        counters->throughput.reset();
+    }
+    upload_rate_.reset();
+    download_rate_.reset();
+    for (size_t i = 0; i < SIZE_CLASSES; ++i) {
+        size_class_latency_ms_[i].reset();
+        size_class_throughput_[i].reset();
+    }
+    total_uploaded_ = 0;
+    total_downloaded_ = 0;
+    files_uploaded_ = 0;
+    files_downloaded_ = 0;
+    errors_ = 0;
+    session_start_ns_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    {
+        std::lock_guard<std::mutex> lock(history_mutex_);
+        completed_transfers_.clear();
+    }
     
     Logger::info("[Bandwidth] Session stats reset");
 }
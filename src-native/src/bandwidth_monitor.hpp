@@ -5,8 +5,10 @@
 #include <vector>
 #include <mutex>
 #include <atomic>
+#include <array>
 #include <deque>
 #include <map>
+#include <memory>
 
 namespace proton {
 
@@ -23,6 +25,7 @@ enum class TransferType {
  */
 struct TransferRecord {
     std::string filename;
+    std::string job;            // Sync job id (or "" for ad-hoc transfers)
     TransferType type;
     size_t bytes;
     std::chrono::steady_clock::time_point start_time;
@@ -32,27 +35,98 @@ struct TransferRecord {
     std::string error;
 };
 
+/**
+ * Bytes per second over a sliding window, kept in a ring of one-second
+ * buckets. Each bucket packs (second, bytes) into one 64-bit word, so
+ * add() is a single CAS loop and rate() sums a fixed number of words -
+ * no locks and no allocation on either side.
+ */
+class RateCounter {
+public:
+    static constexpr int WINDOW_SECONDS = 5;
+
+    void add(uint64_t bytes, int64_t now_second);
+    // Average over the last WINDOW_SECONDS complete seconds
+    double rate(int64_t now_second) const;
+    uint64_t total() const { return total_.load(std::memory_order_relaxed); }
+    void reset();
+
+private:
+    static constexpr int SECOND_BITS = 24;
+    static constexpr int BYTE_BITS = 64 - SECOND_BITS;
+    static constexpr uint64_t SECOND_MASK = (1ull << SECOND_BITS) - 1;
+    static constexpr uint64_t BYTE_MASK = (1ull << BYTE_BITS) - 1;
+
+    std::array<std::atomic<uint64_t>, WINDOW_SECONDS + 2> buckets_{};
+    std::atomic<uint64_t> total_{0};
+};
+
+/**
+ * Log2 histogram: bucket i counts values in [2^(i-1), 2^i). Percentiles
+ * are reported as the upper bound of the bucket they fall in.
+ */
+class Histogram {
+public:
+    static constexpr size_t BUCKETS = 48;
+
+    void record(uint64_t value);
+    void reset();
+
+    struct Summary {
+        uint64_t count = 0;
+        uint64_t p50 = 0;
+        uint64_t p90 = 0;
+        uint64_t p99 = 0;
+        uint64_t max = 0;
+    };
+    Summary summarize() const;
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKETS> buckets_{};
+};
+
 /**
  * Bandwidth Monitor
- * 
- * Tracks transfer speeds and provides statistics similar to 
+ *
+ * Tracks transfer speeds and provides statistics similar to
  * Nextcloud/ownCloud desktop clients:
- * - Real-time upload/download speeds
+ * - Real-time upload/download speeds, overall and per sync job
+ * - Latency/throughput histograms per job and per file size class
  * - Recent transfer history
  * - Bandwidth throttling (optional)
  * - Transfer queue monitoring
+ *
+ * Progress updates and speed reads are lock-free: every counter is an
+ * atomic, and the tables of jobs and active transfers are immutable maps
+ * swapped in on start/complete (copy-on-write), so the 1 Hz UI poll and
+ * the tray never wait on the stats poller.
+ *
+ * The upload/download limits are one global budget for every rclone
+ * process. The effective limit is the lowest of the configured limit, the
+ * work-hours schedule and the metered-link cap; SyncManager splits it
+ * evenly across running transfers through RC core/bwlimit.
  */
 class BandwidthMonitor {
 public:
     static BandwidthMonitor& getInstance();
     
-    // Record transfer events
+    // Record transfer events. `job` groups transfers for per-job stats.
     void start_transfer(const std::string& id, const std::string& filename,
-                       TransferType type, size_t total_bytes);
+                       TransferType type, size_t total_bytes,
+                       const std::string& job = "");
+    // Add `bytes_transferred` new bytes to a running transfer
     void update_progress(const std::string& id, size_t bytes_transferred);
-    void complete_transfer(const std::string& id, bool success, 
+    // Report a cumulative byte counter (e.g. rclone core/stats "bytes");
+    // the delta since the previous report feeds the speed window
+    void update_transferred(const std::string& id, size_t total_bytes_so_far);
+    bool has_transfer(const std::string& id) const;
+    void complete_transfer(const std::string& id, bool success,
                           const std::string& error = "");
     
+    // One finished file inside a job (e.g. an rclone core/transferred
+    // entry); feeds the latency and throughput histograms
+    void record_file(const std::string& job, size_t bytes, std::chrono::milliseconds duration);
+    
     // Get current speeds (bytes per second)
     double get_current_upload_speed() const;
     double get_current_download_speed() const;
@@ -69,6 +143,28 @@ public:
     // Get recent transfer history
     std::vector<TransferRecord> get_recent_transfers(size_t limit = 10) const;
     
+    // Per-job speeds, totals and histograms (latency in ms, throughput in B/s)
+    struct JobStats {
+        std::string job;
+        double upload_speed = 0;
+        double download_speed = 0;
+        uint64_t uploaded = 0;
+        uint64_t downloaded = 0;
+        Histogram::Summary latency_ms;
+        Histogram::Summary throughput;
+    };
+    std::vector<JobStats> get_job_stats() const;
+    // Upload + download speed of one job (0 if it has not moved data)
+    double get_job_speed(const std::string& job) const;
+    
+    // File histograms bucketed by size ("< 1 MB", "1-16 MB", ...)
+    struct SizeClassStats {
+        std::string label;
+        Histogram::Summary latency_ms;
+        Histogram::Summary throughput;
+    };
+    std::vector<SizeClassStats> get_size_class_stats() const;
+    
     // Get cumulative stats
     struct CumulativeStats {
         size_t total_uploaded = 0;
@@ -86,9 +182,26 @@ public:
     size_t get_upload_limit() const { return upload_limit_.load(); }
     size_t get_download_limit() const { return download_limit_.load(); }
     
+    // Cap both directions to `bytes_per_second` between start_hour and
+    // end_hour local time (end < start wraps past midnight)
+    void set_schedule(bool enabled, int start_hour, int end_hour, size_t bytes_per_second);
+    // Cap both directions while NetworkMonitor reports a metered link
+    void set_metered_limit(size_t bytes_per_second);
+    
+    struct Limits {
+        size_t upload = 0;      // bytes/s, 0 = unlimited
+        size_t download = 0;
+    };
+    Limits get_effective_limits() const;
+    
+    // core/bwlimit "rate" for one of `shares` processes splitting the
+    // effective budget: "off", "512K" or "UP:DOWN" such as "256K:off".
+    // A nonzero `cap` (bytes/s) bounds both directions of the share.
+    std::string get_rclone_rate(size_t shares, size_t cap = 0) const;
+    
     // Reset session stats
     void reset_session();
-
+    
 private:
     BandwidthMonitor();
     ~BandwidthMonitor() = default;
@@ -96,24 +209,47 @@ private:
     BandwidthMonitor(const BandwidthMonitor&) = delete;
     BandwidthMonitor& operator=(const BandwidthMonitor&) = delete;
     
-    // Speed calculation using sliding window
-    void add_speed_sample(TransferType type, size_t bytes, 
-                         std::chrono::milliseconds duration);
-    double calculate_speed(const std::deque<std::pair<size_t, std::chrono::steady_clock::time_point>>& samples) const;
+    struct JobCounters {
+        RateCounter upload;
+        RateCounter download;
+        Histogram latency_ms;
+        Histogram throughput;
+    };
+    
+    struct ActiveTransfer {
+        TransferRecord record;                  // Immutable after start
+        std::shared_ptr<JobCounters> job;
+        std::atomic<size_t> bytes{0};           // Moved so far
+        std::atomic<size_t> last_cumulative{0}; // For update_transferred
+    };
+    
+    using JobTable = std::map<std::string, std::shared_ptr<JobCounters>>;
+    using TransferTable = std::map<std::string, std::shared_ptr<ActiveTransfer>>;
+    
+    std::shared_ptr<ActiveTransfer> find_transfer(const std::string& id) const;
+    std::shared_ptr<JobCounters> job_counters(const std::string& job);
+    int64_t now_second() const;
+    
+    static constexpr size_t SIZE_CLASSES = 4;
+    static size_t size_class(size_t bytes);
     
-    mutable std::mutex mutex_;
+    std::chrono::steady_clock::time_point epoch_;
     
-    // Active transfers
-    std::map<std::string, TransferRecord> active_transfers_;
+    // Copy-on-write tables: readers atomic_load, writers swap under table_mutex_
+    std::mutex table_mutex_;
+    std::shared_ptr<const JobTable> jobs_;
+    std::shared_ptr<const TransferTable> active_transfers_;
     
-    // Recent completed transfers
+    // Recent completed transfers (touched on completion and history reads only)
+    mutable std::mutex history_mutex_;
     std::deque<TransferRecord> completed_transfers_;
     static constexpr size_t MAX_HISTORY = 100;
     
-    // Speed samples (rolling window)
-    std::deque<std::pair<size_t, std::chrono::steady_clock::time_point>> upload_samples_;
-    std::deque<std::pair<size_t, std::chrono::steady_clock::time_point>> download_samples_;
-    static constexpr size_t SPEED_WINDOW_SECONDS = 5;
+    // Overall speed and per-size-class histograms
+    RateCounter upload_rate_;
+    RateCounter download_rate_;
+    std::array<Histogram, SIZE_CLASSES> size_class_latency_ms_;
+    std::array<Histogram, SIZE_CLASSES> size_class_throughput_;
     
     // Counters
     std::atomic<int> active_uploads_{0};
@@ -121,11 +257,21 @@ private:
     std::atomic<int> pending_transfers_{0};
     
     // Cumulative stats
-    CumulativeStats session_stats_;
+    std::atomic<size_t> total_uploaded_{0};
+    std::atomic<size_t> total_downloaded_{0};
+    std::atomic<int> files_uploaded_{0};
+    std::atomic<int> files_downloaded_{0};
+    std::atomic<int> errors_{0};
+    std::atomic<int64_t> session_start_ns_{0};
     
     // Throttling limits (0 = unlimited)
     std::atomic<size_t> upload_limit_{0};
     std::atomic<size_t> download_limit_{0};
+    std::atomic<bool> schedule_enabled_{false};
+    std::atomic<int> schedule_start_hour_{9};
+    std::atomic<int> schedule_end_hour_{17};
+    std::atomic<size_t> schedule_limit_{0};
+    std::atomic<size_t> metered_limit_{0};
 };
 
 /**
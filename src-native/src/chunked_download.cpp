@@ -0,0 +1,419 @@
+// chunked_download.cpp - Parallel ranged downloads with an on-disk chunk journal
+
+#include "chunked_download.hpp"
+#include "file_index.hpp"
+#include "logger.hpp"
+#include "rclone_rc.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace proton {
+
+namespace {
+
+constexpr const char* JOURNAL_MAGIC = "proton-drive-partial 1";
+
+// Ranged GETs through the daemon are cheap to issue; the CLI fallback pays a
+// process start and a login per chunk, so it uses fewer, larger chunks
+constexpr uint64_t RC_CHUNK_SIZE = 32ull << 20;
+constexpr uint64_t CLI_MIN_CHUNK_SIZE = 64ull << 20;
+constexpr int CLI_MAX_CHUNKS = 16;
+
+// A chunk fails once no bytes arrive for this long - never on total time
+constexpr int STALL_SECONDS = 60;
+
+std::string partial_dir() {
+    const char* home = std::getenv("HOME");
+    return std::string(home ? home : "/tmp") + "/.cache/proton-drive/partial";
+}
+
+std::string shell_quote(const std::string& arg) {
+    std::string escaped = "'";
+    for (char c : arg) {
+        if (c == '\'') escaped += "'\"'\"'";
+        else escaped += c;
+    }
+    escaped += "'";
+    return escaped;
+}
+
+// Value of a top-level string or number field in a flat lsjson object
+std::string json_field(const std::string& json, const char* key) {
+    std::string needle = std::string("\"") + key + "\"";
+    size_t pos = json.find(needle);
+    if (pos == std::string::npos) return "";
+    pos = json.find_first_not_of(" \t\r\n:", pos + needle.size());
+    if (pos == std::string::npos) return "";
+    if (json[pos] == '"') {
+        size_t end = json.find('"', pos + 1);
+        return end == std::string::npos ? "" : json.substr(pos + 1, end - pos - 1);
+    }
+    size_t end = json.find_first_of(",}\r\n ", pos);
+    return json.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+}
+
+// RFC 3339 ("2024-05-01T10:20:30.123456789+02:00") to a timespec in UTC
+bool parse_mod_time(const std::string& text, struct timespec& out) {
+    struct tm tm = {};
+    int consumed = 0;
+    if (std::sscanf(text.c_str(), "%4d-%2d-%2dT%2d:%2d:%2d%n", &tm.tm_year, &tm.tm_mon, &tm.tm_mday,
+                    &tm.tm_hour, &tm.tm_min, &tm.tm_sec, &consumed) != 6) {
+        return false;
+    }
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+
+    size_t pos = static_cast<size_t>(consumed);
+    long nanos = 0;
+    if (pos < text.size() && text[pos] == '.') {
+        long scale = 100000000;
+        for (++pos; pos < text.size() && std::isdigit(static_cast<unsigned char>(text[pos])); ++pos) {
+            nanos += (text[pos] - '0') * scale;
+            scale /= 10;
+        }
+    }
+    long offset = 0;
+    if (pos < text.size() && (text[pos] == '+' || text[pos] == '-')) {
+        int hours = 0, minutes = 0;
+        if (std::sscanf(text.c_str() + pos + 1, "%2d:%2d", &hours, &minutes) == 2) {
+            offset = (hours * 3600L + minutes * 60L) * (text[pos] == '-' ? -1 : 1);
+        }
+    }
+    out.tv_sec = timegm(&tm) - offset;
+    out.tv_nsec = nanos;
+    return true;
+}
+
+bool write_all(int fd, const std::string& data) {
+    size_t written = 0;
+    while (written < data.size()) {
+        ssize_t n = write(fd, data.data() + written, data.size() - written);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        written += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool pwrite_all(int fd, const char* data, size_t size, uint64_t offset) {
+    while (size > 0) {
+        ssize_t n = pwrite(fd, data, size, static_cast<off_t>(offset));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+ChunkedDownload::ChunkedDownload(std::string remote, std::string local_path, std::string rclone_path)
+    : remote_(std::move(remote)), local_path_(std::move(local_path)), rclone_path_(std::move(rclone_path)) {
+    // One part file per (source, destination) pair so repeated attempts find it
+    std::ostringstream name;
+    name << std::hex << std::hash<std::string>{}(remote_ + '\n' + local_path_);
+    part_path_ = partial_dir() + "/" + name.str() + ".part";
+    journal_path_ = partial_dir() + "/" + name.str() + ".journal";
+    if (rclone_path_.empty()) rclone_path_ = "rclone";
+}
+
+bool ChunkedDownload::prepare() {
+    std::string out;
+    if (!FileIndex::fetch_lsjson("--stat", remote_, 30, out) || out.find('{') == std::string::npos) {
+        error_ = "could not stat " + remote_;
+        return false;
+    }
+    if (json_field(out, "IsDir") == "true") return false;
+    try {
+        size_ = std::stoull(json_field(out, "Size"));
+    } catch (...) {
+        return false;
+    }
+    mod_time_ = json_field(out, "ModTime");
+    use_rc_ = RcloneRC::getInstance().is_ready();
+    chunk_size_ = use_rc_ ? RC_CHUNK_SIZE : std::max(CLI_MIN_CHUNK_SIZE, size_ / CLI_MAX_CHUNKS);
+    return size_ >= MIN_SIZE;
+}
+
+// Header: magic, remote, "<size> <chunk size> <mod time>"; then one
+// "done <index>" line per chunk that is fully on disk. A journal for a
+// different version of the file (size or ModTime changed) is discarded.
+bool ChunkedDownload::load_journal(std::vector<bool>& done) {
+    std::ifstream in(journal_path_);
+    std::string magic, remote, header;
+    if (!std::getline(in, magic) || magic != JOURNAL_MAGIC) return false;
+    if (!std::getline(in, remote) || remote != remote_) return false;
+    if (!std::getline(in, header)) return false;
+
+    std::istringstream fields(header);
+    uint64_t size = 0, chunk_size = 0;
+    std::string mod_time;
+    if (!(fields >> size >> chunk_size) || size != size_ || chunk_size == 0) return false;
+    std::getline(fields >> std::ws, mod_time);
+    if (mod_time != mod_time_) return false;
+
+    struct stat st;
+    if (stat(part_path_.c_str(), &st) != 0 || static_cast<uint64_t>(st.st_size) != size_) return false;
+
+    chunk_size_ = chunk_size;
+    done.assign(static_cast<size_t>((size_ + chunk_size_ - 1) / chunk_size_), false);
+    std::string line;
+    while (std::getline(in, line)) {
+        // A torn last line from a crash is simply not counted
+        if (line.rfind("done ", 0) != 0) continue;
+        char* end = nullptr;
+        unsigned long index = std::strtoul(line.c_str() + 5, &end, 10);
+        if (end && *end == '\0' && index < done.size()) done[index] = true;
+    }
+    journal_fd_ = open(journal_path_.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+    return journal_fd_ >= 0;
+}
+
+bool ChunkedDownload::start_journal() {
+    journal_fd_ = open(journal_path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (journal_fd_ < 0) return false;
+    std::string header = std::string(JOURNAL_MAGIC) + "\n" + remote_ + "\n" +
+                         std::to_string(size_) + " " + std::to_string(chunk_size_) + " " + mod_time_ + "\n";
+    if (!write_all(journal_fd_, header)) return false;
+    return fdatasync(journal_fd_) == 0;
+}
+
+bool ChunkedDownload::fetch_chunk(int fd, uint64_t offset, uint64_t length, std::atomic<uint64_t>& received) {
+    uint64_t written = 0;
+    bool write_failed = false;
+    auto sink = [&](const char* data, size_t size) {
+        if (cancelled_.load()) return false;
+        // Never write past the chunk, whatever the server sends
+        size_t usable = static_cast<size_t>(std::min<uint64_t>(size, length - written));
+        if (!pwrite_all(fd, data, usable, offset + written)) {
+            write_failed = true;
+            return false;
+        }
+        written += usable;
+        received.fetch_add(usable, std::memory_order_relaxed);
+        return true;
+    };
+
+    bool ok = false;
+    if (use_rc_ && RcloneRC::getInstance().is_ready()) {
+        ok = RcloneRC::getInstance().read_range(remote_, offset, length, sink, STALL_SECONDS);
+    } else {
+        // --timeout is rclone's IO idle timeout, so this also fails on stalls only
+        std::string cmd = rclone_path_ + " cat --offset " + std::to_string(offset) +
+                          " --count " + std::to_string(length) +
+                          " --timeout " + std::to_string(STALL_SECONDS) + "s --contimeout 15s " +
+                          shell_quote(remote_) + " 2>/dev/null";
+        FILE* pipe = popen(cmd.c_str(), "r");
+        if (pipe) {
+            std::vector<char> buffer(1 << 20);
+            size_t n;
+            bool keep_going = true;
+            while (keep_going && (n = std::fread(buffer.data(), 1, buffer.size(), pipe)) > 0) {
+                keep_going = sink(buffer.data(), n);
+            }
+            ok = pclose(pipe) == 0 && keep_going;
+        }
+    }
+    if (write_failed) write_errno_.store(errno);
+
+    if (ok && written == length) return true;
+    // Partial bytes will be fetched again; keep the progress honest
+    received.fetch_sub(written, std::memory_order_relaxed);
+    return false;
+}
+
+bool ChunkedDownload::run(const ProgressCallback& on_progress) {
+    if (size_ == 0 || chunk_size_ == 0) {
+        error_ = "prepare() was not called";
+        return false;
+    }
+    std::error_code ec;
+    fs::create_directories(partial_dir(), ec);
+
+    std::vector<bool> done;
+    bool resumed = load_journal(done);
+    if (!resumed) {
+        if (journal_fd_ >= 0) close(journal_fd_);
+        journal_fd_ = -1;
+        done.assign(static_cast<size_t>((size_ + chunk_size_ - 1) / chunk_size_), false);
+    }
+
+    int fd = open(part_path_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC | (resumed ? 0 : O_TRUNC), 0600);
+    if (fd < 0 || (!resumed && (ftruncate(fd, static_cast<off_t>(size_)) != 0 || !start_journal()))) {
+        error_ = std::string("cannot create partial file: ") + std::strerror(errno);
+        if (fd >= 0) close(fd);
+        if (journal_fd_ >= 0) close(journal_fd_);
+        journal_fd_ = -1;
+        return false;
+    }
+
+    std::vector<size_t> pending;
+    uint64_t already = 0;
+    for (size_t i = 0; i < done.size(); ++i) {
+        uint64_t length = std::min(chunk_size_, size_ - i * chunk_size_);
+        if (done[i]) already += length;
+        else pending.push_back(i);
+    }
+    const int chunks_total = static_cast<int>(done.size());
+    if (resumed) {
+        Logger::info("[ChunkedDownload] Resuming " + remote_ + ": " + std::to_string(chunks_total - pending.size()) +
+                     "/" + std::to_string(chunks_total) + " chunks already on disk");
+    } else {
+        Logger::info("[ChunkedDownload] " + remote_ + ": " + std::to_string(size_) + " bytes in " +
+                     std::to_string(chunks_total) + " chunks (" + (use_rc_ ? "rc" : "cli") + ")");
+    }
+
+    std::atomic<size_t> next{0};
+    std::atomic<uint64_t> received{0};
+    std::atomic<int> chunks_done{chunks_total - static_cast<int>(pending.size())};
+    std::atomic<int> running{0};
+    std::atomic<bool> failed{false};
+    std::mutex journal_mutex;
+
+    auto worker = [&]() {
+        while (!failed.load() && !cancelled_.load()) {
+            size_t slot = next.fetch_add(1);
+            if (slot >= pending.size()) break;
+            size_t index = pending[slot];
+            uint64_t offset = index * chunk_size_;
+            uint64_t length = std::min(chunk_size_, size_ - offset);
+
+            bool ok = false;
+            for (int attempt = 0; attempt < MAX_ATTEMPTS && !ok && !cancelled_.load(); ++attempt) {
+                if (attempt > 0) {
+                    Logger::debug("[ChunkedDownload] Retrying chunk " + std::to_string(index) +
+                                  " (attempt " + std::to_string(attempt + 1) + ")");
+                    std::this_thread::sleep_for(std::chrono::seconds(1 << attempt));
+                }
+                ok = fetch_chunk(fd, offset, length, received);
+            }
+            if (!ok) {
+                failed.store(true);
+                break;
+            }
+            // The data must be durable before the journal says it is there
+            if (fdatasync(fd) != 0) {
+                failed.store(true);
+                break;
+            }
+            std::lock_guard<std::mutex> lock(journal_mutex);
+            if (!write_all(journal_fd_, "done " + std::to_string(index) + "\n") || fdatasync(journal_fd_) != 0) {
+                failed.store(true);
+                break;
+            }
+            chunks_done.fetch_add(1);
+        }
+        running.fetch_sub(1);
+    };
+
+    auto started = std::chrono::steady_clock::now();
+    int streams = static_cast<int>(std::min<size_t>(MAX_STREAMS, pending.size()));
+    running.store(streams);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < streams; ++i) workers.emplace_back(worker);
+
+    auto report = [&]() {
+        if (!on_progress) return;
+        Progress progress;
+        progress.bytes = already + received.load();
+        progress.total = size_;
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        progress.speed = seconds > 0 ? received.load() / seconds : 0;
+        progress.chunks_done = chunks_done.load();
+        progress.chunks_total = chunks_total;
+        on_progress(progress);
+    };
+    while (running.load() > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+        report();
+    }
+    for (auto& thread : workers) thread.join();
+
+    close(journal_fd_);
+    journal_fd_ = -1;
+    if (failed.load() || cancelled_.load() || chunks_done.load() != chunks_total) {
+        if (write_errno_.load()) error_ = std::string("write failed: ") + std::strerror(write_errno_.load());
+        else if (error_.empty()) error_ = cancelled_.load() ? "cancelled" : "chunk download failed";
+        Logger::warn("[ChunkedDownload] " + remote_ + " stopped at " + std::to_string(chunks_done.load()) + "/" +
+                     std::to_string(chunks_total) + " chunks (" + error_ + "); will resume");
+        close(fd);
+        return false;
+    }
+    report();
+    return finish(fd);
+}
+
+bool ChunkedDownload::finish(int fd) {
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<uint64_t>(st.st_size) != size_) {
+        error_ = "size mismatch after download";
+        close(fd);
+        return false;
+    }
+    struct timespec mtime;
+    if (parse_mod_time(mod_time_, mtime)) {
+        struct timespec times[2] = {{0, UTIME_OMIT}, mtime};
+        futimens(fd, times);
+    }
+    close(fd);
+
+    std::error_code ec;
+    fs::create_directories(fs::path(local_path_).parent_path(), ec);
+    if (rename(part_path_.c_str(), local_path_.c_str()) != 0) {
+        if (errno != EXDEV) {
+            error_ = std::string("rename failed: ") + std::strerror(errno);
+            return false;
+        }
+        // Cache and destination are on different filesystems: copy next to
+        // the destination under a hidden name, then rename over it
+        fs::path dest(local_path_);
+        fs::path staging = dest.parent_path() / ("." + dest.filename().string() + ".proton-part");
+        fs::copy_file(part_path_, staging, fs::copy_options::overwrite_existing, ec);
+        if (!ec) {
+            int staged = open(staging.c_str(), O_WRONLY | O_CLOEXEC);
+            if (staged >= 0) {
+                if (parse_mod_time(mod_time_, mtime)) {
+                    struct timespec times[2] = {{0, UTIME_OMIT}, mtime};
+                    futimens(staged, times);
+                }
+                fsync(staged);
+                close(staged);
+            }
+            fs::rename(staging, dest, ec);
+        }
+        if (ec) {
+            error_ = "copy to destination failed: " + ec.message();
+            fs::remove(staging, ec);
+            return false;
+        }
+        fs::remove(part_path_, ec);
+    }
+    unlink(journal_path_.c_str());
+    Logger::info("[ChunkedDownload] Completed " + remote_ + " -> " + local_path_);
+    return true;
+}
+
+} // namespace proton
@@ -0,0 +1,208 @@
+// cloud_dir_cache.cpp - Stale-while-revalidate cache of cloud folder listings
+
+#include "cloud_dir_cache.hpp"
+#include "app_window_helpers.hpp"
+#include "lsjson_parser.hpp"
+#include "logger.hpp"
+#include <algorithm>
+
+using AppWindowHelpers::exec_rclone_with_timeout;
+using AppWindowHelpers::shell_escape;
+
+CloudDirCache& CloudDirCache::getInstance() {
+    static CloudDirCache instance;
+    return instance;
+}
+
+std::string CloudDirCache::index_key(const std::string& path) {
+    // FileIndex stores children with parent_path "proton:/Documents" ("proton:/" at the root)
+    std::string key = "proton:" + path;
+    if (key.size() > 8 && key.back() == '/') key.pop_back();
+    return key;
+}
+
+CloudDirCache::ListingPtr CloudDirCache::make_listing(std::vector<IndexedFile> entries, std::string mod_time) {
+    std::sort(entries.begin(), entries.end(), [](const IndexedFile& a, const IndexedFile& b) {
+        if (a.is_directory != b.is_directory) return a.is_directory;
+        return a.name < b.name;
+    });
+    auto listing = std::make_shared<Listing>();
+    listing->bytes = sizeof(Listing) + entries.capacity() * sizeof(IndexedFile);
+    for (const auto& e : entries) {
+        listing->bytes += e.name.capacity() + e.path.capacity() + e.parent_path.capacity() +
+                          e.mod_time.capacity() + e.local_path.capacity() + e.extension.capacity();
+    }
+    listing->entries = std::move(entries);
+    listing->mod_time = std::move(mod_time);
+    return listing;
+}
+
+CloudDirCache::ListingPtr CloudDirCache::lookup(const std::string& path, bool& fresh) {
+    fresh = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = nodes_.find(path);
+        if (it != nodes_.end()) {
+            lru_.splice(lru_.begin(), lru_, it->second);
+            fresh = std::chrono::steady_clock::now() - it->second->validated_at <
+                    std::chrono::seconds(FRESH_SECONDS);
+            return it->second->listing;
+        }
+    }
+
+    // Not in memory: whatever the index holds from an earlier session (stale)
+    auto& index = FileIndex::getInstance();
+    std::string key = index_key(path);
+    auto rows = index.get_directory_contents(key);
+    if (rows.empty()) return nullptr;  // Never listed, or empty - either way ask rclone
+    ListingPtr listing = make_listing(std::move(rows), index.get_folder_cursor(key));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = nodes_.find(path);
+    if (it != nodes_.end()) return it->second->listing;  // Raced with a fetch
+    store(path, listing, false);
+    return listing;
+}
+
+void CloudDirCache::store(const std::string& path, ListingPtr listing, bool validated) {
+    auto validated_at = validated ? std::chrono::steady_clock::now()
+                                  : std::chrono::steady_clock::time_point{};
+    auto it = nodes_.find(path);
+    if (it != nodes_.end()) {
+        bytes_ -= it->second->listing->bytes;
+        it->second->listing = std::move(listing);
+        it->second->validated_at = validated_at;
+        lru_.splice(lru_.begin(), lru_, it->second);
+    } else {
+        lru_.push_front(Node{path, std::move(listing), validated_at});
+        nodes_[path] = lru_.begin();
+    }
+    bytes_ += lru_.front().listing->bytes;
+
+    // Evict least recently used folders, but never the one just stored
+    while (bytes_ > budget_ && lru_.size() > 1) {
+        Node& victim = lru_.back();
+        bytes_ -= victim.listing->bytes;
+        nodes_.erase(victim.path);
+        lru_.pop_back();
+    }
+}
+
+void CloudDirCache::get(const std::string& path, bool force, Callback callback) {
+    bool fresh = false;
+    ListingPtr cached = lookup(path, fresh);
+    if (cached && fresh && !force) {
+        callback(cached, true);
+        return;
+    }
+    if (cached) callback(cached, false);
+    revalidate(path, cached, force, proton::TaskLane::Interactive, std::move(callback));
+}
+
+void CloudDirCache::revalidate(const std::string& path, ListingPtr cached, bool force,
+                               proton::TaskLane lane, Callback callback) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = in_flight_.find(path);
+        if (it != in_flight_.end()) {
+            // Coalesce: one listing serves every waiter
+            if (callback) it->second.push_back(std::move(callback));
+            return;
+        }
+        auto& waiters = in_flight_[path];
+        if (callback) waiters.push_back(std::move(callback));
+    }
+
+    proton::TaskPool::getInstance().submit(lane, [this, path, cached, force, lane]() {
+        std::string target = "proton:" + path;
+
+        // The folder's own ModTime acts as its ETag (the root has none)
+        std::string mod_time;
+        if (path != "/") {
+            std::string stat = exec_rclone_with_timeout("lsjson --stat " + shell_escape(target), 15);
+            auto items = LsjsonParser::parse(stat, target.substr(0, target.rfind('/') + 1));
+            if (!items.empty()) mod_time = items.front().mod_time;
+        }
+
+        ListingPtr result;
+        if (!force && cached && !mod_time.empty() && mod_time == cached->mod_time) {
+            result = cached;
+            Logger::debug("[DirCache] Unchanged since last listing: " + path);
+        } else {
+            std::string output = exec_rclone_with_timeout("lsjson --fast-list " + shell_escape(target), 30);
+            Logger::info("[DirCache] rclone lsjson returned " + std::to_string(output.size()) + " bytes for " + path);
+            if (output.find('[') != std::string::npos) {
+                std::string prefix = target.back() == '/' ? target : target + "/";
+                result = make_listing(LsjsonParser::parse(output, prefix), mod_time);
+                FileIndex::getInstance().store_directory_listing(index_key(path), result->entries, mod_time);
+            }
+        }
+
+        std::vector<Callback> waiters;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = in_flight_.find(path);
+            if (it != in_flight_.end()) {
+                waiters = std::move(it->second);
+                in_flight_.erase(it);
+            }
+            if (result) store(path, result, true);
+        }
+        for (auto& waiter : waiters) {
+            proton::TaskPool::post_to_main([waiter = std::move(waiter), result]() { waiter(result, true); });
+        }
+
+        if (result && result != cached && lane == proton::TaskLane::Interactive) {
+            prefetch_children(result);
+        }
+    });
+}
+
+void CloudDirCache::prefetch_children(const ListingPtr& listing) {
+    // The most recently modified subfolders are the likeliest next stop
+    std::vector<const IndexedFile*> folders;
+    for (const auto& entry : listing->entries) {
+        if (entry.is_directory) folders.push_back(&entry);
+    }
+    std::sort(folders.begin(), folders.end(), [](const IndexedFile* a, const IndexedFile* b) {
+        return a->mod_time > b->mod_time;
+    });
+
+    size_t queued = 0;
+    for (const IndexedFile* folder : folders) {
+        if (queued >= PREFETCH_CHILDREN) break;
+        if (folder->path.compare(0, 7, "proton:") != 0) continue;
+        std::string child = folder->path.substr(7);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (nodes_.count(child) || in_flight_.count(child)) continue;
+        }
+        bool fresh = false;
+        ListingPtr cached = lookup(child, fresh);
+        if (fresh) continue;
+        revalidate(child, cached, false, proton::TaskLane::Background, nullptr);
+        queued++;
+    }
+}
+
+void CloudDirCache::invalidate(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = nodes_.find(path);
+    if (it != nodes_.end()) it->second->validated_at = {};
+}
+
+void CloudDirCache::invalidate_all() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& node : lru_) node.validated_at = {};
+}
+
+void CloudDirCache::set_memory_budget(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    budget_ = bytes;
+    while (bytes_ > budget_ && lru_.size() > 1) {
+        Node& victim = lru_.back();
+        bytes_ -= victim.listing->bytes;
+        nodes_.erase(victim.path);
+        lru_.pop_back();
+    }
+}
@@ -0,0 +1,84 @@
+// cloud_dir_cache.hpp - Stale-while-revalidate cache of cloud folder listings
+// Holds parsed IndexedFile rows per folder, LRU-bounded by approximate
+// memory use. A miss falls back to the folder's rows in FileIndex, so
+// listings survive restarts. Anything older than a few seconds is served
+// immediately and revalidated in the background: a cheap `lsjson --stat`
+// compares the folder's ModTime with the one recorded in FileIndex (its
+// folder cursor) and only a changed folder is listed again. Concurrent
+// requests for one folder share a single listing, and a few subfolders of
+// each fresh listing are prefetched on the background lane.
+
+#ifndef CLOUD_DIR_CACHE_HPP
+#define CLOUD_DIR_CACHE_HPP
+
+#include <chrono>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "file_index.hpp"
+#include "task_pool.hpp"
+
+class CloudDirCache {
+public:
+    static CloudDirCache& getInstance();
+
+    struct Listing {
+        std::vector<IndexedFile> entries;  // Folders first, then by name
+        std::string mod_time;              // Folder ModTime the entries match ("" = unknown)
+        size_t bytes = 0;                  // Approximate heap footprint
+    };
+    using ListingPtr = std::shared_ptr<const Listing>;
+
+    // Delivered on the GTK main thread. `listing` is null if the folder
+    // could not be listed; `final` is false for a stale copy shown while
+    // revalidation runs (a final call always follows).
+    using Callback = std::function<void(const ListingPtr& listing, bool final)>;
+
+    // Browse path ("/", "/Documents"). `force` skips the ModTime check and
+    // always re-lists, but still shows the cached copy meanwhile.
+    void get(const std::string& path, bool force, Callback callback);
+
+    // Mark one folder (or everything) stale without dropping it
+    void invalidate(const std::string& path);
+    void invalidate_all();
+
+    void set_memory_budget(size_t bytes);
+
+private:
+    CloudDirCache() = default;
+
+    CloudDirCache(const CloudDirCache&) = delete;
+    CloudDirCache& operator=(const CloudDirCache&) = delete;
+
+    struct Node {
+        std::string path;
+        ListingPtr listing;
+        std::chrono::steady_clock::time_point validated_at;  // Epoch = stale
+    };
+
+    // Memory lookup, then FileIndex; touches the LRU order
+    ListingPtr lookup(const std::string& path, bool& fresh);
+    void store(const std::string& path, ListingPtr listing, bool validated);  // mutex_ held
+    void revalidate(const std::string& path, ListingPtr cached, bool force,
+                    proton::TaskLane lane, Callback callback);
+    void prefetch_children(const ListingPtr& listing);
+
+    static std::string index_key(const std::string& path);
+    static ListingPtr make_listing(std::vector<IndexedFile> entries, std::string mod_time);
+
+    std::mutex mutex_;
+    std::list<Node> lru_;  // Most recently used first
+    std::unordered_map<std::string, std::list<Node>::iterator> nodes_;
+    std::unordered_map<std::string, std::vector<Callback>> in_flight_;
+    size_t bytes_ = 0;
+    size_t budget_ = 32 * 1024 * 1024;
+
+    static constexpr int FRESH_SECONDS = 30;
+    static constexpr size_t PREFETCH_CHILDREN = 3;
+};
+
+#endif // CLOUD_DIR_CACHE_HPP
@@ -0,0 +1,100 @@
+// cloud_file_model.cpp - Lazily materialized GListModel of IndexedFile rows
+
+#include "cloud_file_model.hpp"
+
+// ---- PdFileItem: one row, created on demand by get_item ----
+
+struct _PdFileItem {
+    GObject parent_instance;
+    IndexedFile* file;
+};
+
+G_DEFINE_TYPE(PdFileItem, pd_file_item, G_TYPE_OBJECT)
+
+static void pd_file_item_finalize(GObject* object) {
+    delete PD_FILE_ITEM(object)->file;
+    G_OBJECT_CLASS(pd_file_item_parent_class)->finalize(object);
+}
+
+static void pd_file_item_class_init(PdFileItemClass* klass) {
+    G_OBJECT_CLASS(klass)->finalize = pd_file_item_finalize;
+}
+
+static void pd_file_item_init(PdFileItem* self) {
+    self->file = new IndexedFile{};
+}
+
+const IndexedFile& pd_file_item_get_file(PdFileItem* item) {
+    return *item->file;
+}
+
+std::string pd_file_item_get_browse_path(PdFileItem* item) {
+    const std::string& path = item->file->path;
+    if (path.compare(0, 7, "proton:") == 0) return path.substr(7);
+    return path;
+}
+
+// ---- PdFileModel: owns the records, implements GListModel ----
+
+struct _PdFileModel {
+    GObject parent_instance;
+    std::vector<IndexedFile>* files;
+};
+
+static void pd_file_model_list_model_init(GListModelInterface* iface);
+
+G_DEFINE_TYPE_WITH_CODE(PdFileModel, pd_file_model, G_TYPE_OBJECT,
+                        G_IMPLEMENT_INTERFACE(G_TYPE_LIST_MODEL, pd_file_model_list_model_init))
+
+static GType pd_file_model_get_item_type(GListModel*) {
+    return PD_TYPE_FILE_ITEM;
+}
+
+static guint pd_file_model_get_n_items(GListModel* list) {
+    return static_cast<guint>(PD_FILE_MODEL(list)->files->size());
+}
+
+static gpointer pd_file_model_get_item(GListModel* list, guint position) {
+    PdFileModel* self = PD_FILE_MODEL(list);
+    if (position >= self->files->size()) return nullptr;
+
+    PdFileItem* item = PD_FILE_ITEM(g_object_new(PD_TYPE_FILE_ITEM, nullptr));
+    *item->file = (*self->files)[position];
+    return item;
+}
+
+static void pd_file_model_list_model_init(GListModelInterface* iface) {
+    iface->get_item_type = pd_file_model_get_item_type;
+    iface->get_n_items = pd_file_model_get_n_items;
+    iface->get_item = pd_file_model_get_item;
+}
+
+static void pd_file_model_finalize(GObject* object) {
+    delete PD_FILE_MODEL(object)->files;
+    G_OBJECT_CLASS(pd_file_model_parent_class)->finalize(object);
+}
+
+static void pd_file_model_class_init(PdFileModelClass* klass) {
+    G_OBJECT_CLASS(klass)->finalize = pd_file_model_finalize;
+}
+
+static void pd_file_model_init(PdFileModel* self) {
+    self->files = new std::vector<IndexedFile>();
+}
+
+PdFileModel* pd_file_model_new() {
+    return PD_FILE_MODEL(g_object_new(PD_TYPE_FILE_MODEL, nullptr));
+}
+
+void pd_file_model_set_files(PdFileModel* model, std::vector<IndexedFile> files) {
+    guint removed = static_cast<guint>(model->files->size());
+    *model->files = std::move(files);
+    guint added = static_cast<guint>(model->files->size());
+    if (removed || added) {
+        g_list_model_items_changed(G_LIST_MODEL(model), 0, removed, added);
+    }
+}
+
+void pd_file_model_clear(PdFileModel* model) {
+    pd_file_model_set_files(model, {});
+}
@@ -0,0 +1,43 @@
+// cloud_file_model.hpp - Lazily materialized GListModel of IndexedFile rows
+// Backs the cloud browser's GtkListView. The model holds plain IndexedFile
+// records and only creates a PdFileItem when GTK asks for a position, and
+// GtkListView only asks for rows in (or near) the viewport - so object and
+// widget counts follow the window height, not the folder size.
+
+#ifndef CLOUD_FILE_MODEL_HPP
+#define CLOUD_FILE_MODEL_HPP
+
+#include <gtk/gtk.h>
+#include <string>
+#include <vector>
+#include "file_index.hpp"
+
+G_BEGIN_DECLS
+
+#define PD_TYPE_FILE_ITEM (pd_file_item_get_type())
+G_DECLARE_FINAL_TYPE(PdFileItem, pd_file_item, PD, FILE_ITEM, GObject)
+
+#define PD_TYPE_FILE_MODEL (pd_file_model_get_type())
+G_DECLARE_FINAL_TYPE(PdFileModel, pd_file_model, PD, FILE_MODEL, GObject)
+
+G_END_DECLS
+
+// How the list view renders rows
+enum class CloudRowStyle {
+    Browse,   // name, "size • date", sync badge
+    Search    // name, full path, size
+};
+
+PdFileModel* pd_file_model_new();
+
+// Replace every row at once (one items-changed emission)
+void pd_file_model_set_files(PdFileModel* model, std::vector<IndexedFile> files);
+void pd_file_model_clear(PdFileModel* model);
+
+// The record behind a row
+const IndexedFile& pd_file_item_get_file(PdFileItem* item);
+
+// Browser path for a row: the index path without the "proton:" prefix
+std::string pd_file_item_get_browse_path(PdFileItem* item);
+
+#endif // CLOUD_FILE_MODEL_HPP
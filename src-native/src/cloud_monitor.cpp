@@ -0,0 +1,313 @@
+// cloud_monitor.cpp - Cloud change monitoring for automatic sync
+
+#include "cloud_monitor.hpp"
+#include "app_window_helpers.hpp"
+#include "sync_job_metadata.hpp"
+#include "remote_snapshot.hpp"
+#include "sync_scheduler.hpp"
+#include "task_pool.hpp"
+#include "logger.hpp"
+#include <chrono>
+#include <filesystem>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace AppWindowHelpers;
+
+namespace proton {
+
+CloudMonitor& CloudMonitor::getInstance() {
+    static CloudMonitor instance;
+    return instance;
+}
+
+CloudMonitor::~CloudMonitor() {
+    stop();
+}
+
+void CloudMonitor::set_events(Events events) {
+    std::lock_guard<std::mutex> lock(events_mutex_);
+    events_ = std::move(events);
+}
+
+void CloudMonitor::emit(std::function<void(const Events&)> fn) {
+    TaskPool::post_to_main([this, fn = std::move(fn)]() {
+        Events events;
+        {
+            std::lock_guard<std::mutex> lock(events_mutex_);
+            events = events_;
+        }
+        fn(events);
+    });
+}
+
+void CloudMonitor::emit_log(const std::string& line) {
+    emit([line](const Events& events) {
+        if (events.log) events.log(line);
+    });
+}
+
+bool CloudMonitor::claim_download(const std::string& key) {
+    std::lock_guard<std::mutex> lock(download_mutex_);
+    return active_downloads_.insert(key).second;
+}
+
+size_t CloudMonitor::release_download(const std::string& key) {
+    std::lock_guard<std::mutex> lock(download_mutex_);
+    active_downloads_.erase(key);
+    return active_downloads_.size();
+}
+
+void CloudMonitor::start() {
+    if (active_.exchange(true)) {
+        Logger::debug("[CloudMonitor] Already running");
+        return;
+    }
+    stop_.store(false);
+    try {
+        thread_ = std::thread(&CloudMonitor::run, this);
+    } catch (const std::exception& e) {
+        active_.store(false);
+        Logger::error("[CloudMonitor] Failed to start monitor thread: " + std::string(e.what()));
+    }
+}
+
+void CloudMonitor::stop() {
+    if (active_.exchange(false)) {
+        stop_.store(true);
+        {
+            std::lock_guard<std::mutex> lock(wait_mutex_);
+        }
+        wait_cv_.notify_all();
+
+        // Kill any rclone lsjson processes we spawned (only our UID, only lsjson)
+        std::string uid = std::to_string(getuid());
+        [[maybe_unused]] int result = std::system(
+            ("pkill -U " + uid + " -f 'rclone.*lsjson.*proton:' 2>/dev/null").c_str());
+    }
+    if (thread_.joinable()) thread_.join();
+}
+
+void CloudMonitor::run() {
+    Logger::info("[CloudMonitor] Started monitoring cloud changes");
+    while (active_.load()) {
+        try {
+            scan();
+        } catch (const std::exception& e) {
+            Logger::error("[CloudMonitor] Exception in monitor loop: " + std::string(e.what()));
+        } catch (...) {
+            Logger::error("[CloudMonitor] Unknown exception in monitor loop");
+        }
+
+        // Wait between checks (reduced API load); stop() wakes this early
+        std::unique_lock<std::mutex> lock(wait_mutex_);
+        wait_cv_.wait_for(lock, std::chrono::seconds(SCAN_INTERVAL_SECONDS), [this] {
+            return !active_.load();
+        });
+    }
+    Logger::info("[CloudMonitor] Stopped monitoring");
+}
+
+void CloudMonitor::scan() {
+    auto registry_snapshot = SyncJobRegistry::getInstance().snapshot();
+    const auto& jobs = registry_snapshot->jobs;
+
+    Logger::info("[CloudMonitor] === SCAN START ===");
+    Logger::info("[CloudMonitor] Total sync jobs: " + std::to_string(jobs.size()));
+
+    if (jobs.empty()) {
+        Logger::info("[CloudMonitor] No sync jobs configured - nothing to monitor");
+        return;
+    }
+
+    for (const auto& job : jobs) {
+        if (!active_.load()) break;
+
+        std::string remote_path = job.remote_path;
+        if (remote_path.empty() || remote_path.front() != '/') {
+            remote_path = "/" + remote_path;
+        }
+
+        Logger::info("[CloudMonitor] Job: " + job.job_id);
+        Logger::info("[CloudMonitor]   Remote: " + remote_path);
+        Logger::info("[CloudMonitor]   Local: " + job.local_path);
+
+        // Check if we need to scan this job (avoid hammering the API)
+        auto now = std::time(nullptr);
+        auto last_check_it = last_check_.find(job.job_id);
+        if (last_check_it != last_check_.end()) {
+            auto elapsed = now - last_check_it->second;
+            Logger::debug("[CloudMonitor]   Last checked: " + std::to_string(elapsed) + "s ago");
+            if (elapsed < MIN_JOB_RESCAN_SECONDS) {
+                Logger::debug("[CloudMonitor]   Skipping (too soon)");
+                continue;
+            }
+        }
+        last_check_[job.job_id] = now;
+
+        Logger::info("[CloudMonitor] >>> Scanning cloud folder: proton:" + remote_path);
+
+        // Only the root's direct children are compared, so a depth-1 listing
+        // from the shared snapshot is enough; it is refreshed at most once
+        // per cycle, and a whole-tree snapshot taken after a sync serves too.
+        auto snapshot = RemoteSnapshotService::getInstance().get("proton:" + remote_path, &stop_);
+        if (!snapshot) {
+            Logger::info("[CloudMonitor] ⚠️  No valid listing from cloud scan");
+            continue;
+        }
+        auto root_it = snapshot->folders.find(snapshot->root);
+        if (root_it == snapshot->folders.end() || !root_it->second.children) {
+            Logger::info("[CloudMonitor] ⚠️  No valid listing for " + remote_path);
+            continue;
+        }
+
+        Logger::info("[CloudMonitor] ✓ Listing has " + std::to_string(root_it->second.children->size()) +
+                     " items");
+        // Compare mod_time and size, not just existence
+        const std::vector<IndexedFile>& cloud_files = *root_it->second.children;
+        std::vector<std::pair<std::string, std::string>> pending_files;  // <cloud_path, filename>
+
+        for (const auto& cf : cloud_files) {
+            if (cf.is_directory) continue;
+
+            // Check if file exists locally AND matches size
+            std::string local_file = job.local_path;
+            if (local_file.back() != '/') local_file += "/";
+            local_file += cf.name;
+
+            bool needs_download = false;
+            if (!safe_exists(local_file)) {
+                needs_download = true;
+                Logger::debug("[CloudMonitor]   ⬇️  " + cf.name + " - missing locally");
+            } else {
+                // File exists - check size to detect changes
+                std::error_code ec;
+                auto local_size = fs::file_size(local_file, ec);
+                if (!ec && static_cast<int64_t>(local_size) != cf.size) {
+                    needs_download = true;
+                    Logger::debug("[CloudMonitor]   ⬇️  " + cf.name +
+                                " - size mismatch (local=" + std::to_string(local_size) +
+                                " cloud=" + std::to_string(cf.size) + ")");
+                }
+            }
+
+            if (needs_download) {
+                std::string cloud_path = remote_path;
+                if (cloud_path.back() != '/') cloud_path += "/";
+                cloud_path += cf.name;
+                pending_files.push_back({cloud_path, cf.name});
+            }
+        }
+
+        // Subfolders re-listed (the root always is) or files to fetch mean
+        // the remote is active; the scheduler shortens this job's interval
+        if (snapshot->relisted > 1 || !pending_files.empty()) {
+            SyncScheduler::getInstance().note_remote_change(job.job_id);
+        }
+
+        int total_files = 0, total_dirs = 0;
+        for (const auto& cf : cloud_files) {
+            if (cf.is_directory) total_dirs++; else total_files++;
+        }
+
+        Logger::info("[CloudMonitor] Scan complete for " + remote_path + ":");
+        Logger::info("[CloudMonitor]   Dirs: " + std::to_string(total_dirs) +
+                    "  Files: " + std::to_string(total_files) +
+                    "  Pending: " + std::to_string(pending_files.size()));
+
+        if (pending_files.empty()) {
+            Logger::info("[CloudMonitor] ✓ All files synced for this job");
+            continue;
+        }
+
+        Logger::info("[CloudMonitor] 🚀 " + std::to_string(pending_files.size()) +
+                    " files need downloading");
+
+        // For small batches (≤5 files), use individual copyto for precise tracking
+        // For large batches, use rclone copy which handles everything in one call
+        if (pending_files.size() <= 5) {
+            for (const auto& [cloud_path, filename] : pending_files) {
+                if (!claim_download(cloud_path)) {
+                    Logger::debug("[CloudMonitor] Already downloading: " + filename);
+                    continue;
+                }
+
+                std::string local_dest = job.local_path;
+                if (local_dest.back() != '/') local_dest += "/";
+                local_dest += filename;
+
+                TaskPool::getInstance().submit(TaskLane::Transfer, [this, path = cloud_path, name = filename, local_dest]() {
+                    bool success = false;
+                    try {
+                        fs::path parent = fs::path(local_dest).parent_path();
+                        if (!parent.empty() && !safe_exists(parent.string())) {
+                            std::error_code ec_mkd;
+                            fs::create_directories(parent, ec_mkd);
+                        }
+
+                        emit([name](const Events& events) {
+                            if (events.download_started) events.download_started(name);
+                            if (events.log) events.log("[AutoSync] Downloading: " + name);
+                        });
+
+                        success = run_rclone_with_timeout(
+                            "copyto " + shell_escape("proton:" + path) + " " +
+                            shell_escape(local_dest), 300) == 0;
+                    } catch (const std::exception& e) {
+                        Logger::error("[CloudMonitor] Download error: " + std::string(e.what()));
+                    }
+                    release_download(path);
+
+                    emit([name, success](const Events& events) {
+                        if (events.download_finished) events.download_finished(name, success);
+                        if (events.log) events.log(std::string("[AutoSync] ") + (success ? "Downloaded: " : "Failed: ") + name);
+                    });
+                });
+            }
+        } else {
+            // Batch download: use rclone copy for the entire folder
+            // This is O(1) command invocations instead of O(n)
+            Logger::info("[CloudMonitor] Using batch rclone copy for " +
+                        std::to_string(pending_files.size()) + " files");
+
+            std::string batch_key = "batch:" + remote_path;
+            if (!claim_download(batch_key)) {
+                Logger::debug("[CloudMonitor] Batch already running for " + remote_path);
+                continue;
+            }
+
+            int count = static_cast<int>(pending_files.size());
+            emit_log("[AutoSync] Batch downloading " + std::to_string(count) + " files...");
+
+            TaskPool::getInstance().submit(TaskLane::Transfer, [this, batch_key, batch_remote = remote_path, batch_local = job.local_path, count]() {
+                bool success = false;
+                try {
+                    // rclone copy handles creating directories, comparing files, etc.
+                    Logger::info("[CloudMonitor] Batch cmd: rclone copy (transfers=4)");
+
+                    success = run_rclone_with_timeout(
+                        "copy " + shell_escape("proton:" + batch_remote) + " " +
+                        shell_escape(batch_local) + " --update --transfers 4 --checkers 8",
+                        600) == 0;
+                } catch (const std::exception& e) {
+                    Logger::error("[CloudMonitor] Batch download error: " + std::string(e.what()));
+                }
+                release_download(batch_key);
+
+                emit([success, count](const Events& events) {
+                    if (events.log) {
+                        events.log(success ? "[AutoSync] Batch complete: " + std::to_string(count) + " files"
+                                           : "[AutoSync] Batch download had errors");
+                    }
+                    if (events.batch_finished) events.batch_finished();
+                });
+            });
+        }
+    }
+
+    Logger::info("[CloudMonitor] === SCAN COMPLETE ===");
+}
+
+} // namespace proton
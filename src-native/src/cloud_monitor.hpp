@@ -0,0 +1,76 @@
+// cloud_monitor.hpp - Cloud change monitoring for automatic sync
+// Every minute each sync job's remote tree is compared with its local
+// folder (through the shared RemoteSnapshotService) and new or resized
+// files are downloaded: one copyto per file for small batches, a single
+// `rclone copy --update` otherwise. Used to live in AppWindow; it has no UI
+// of its own so the headless daemon can run it too. Whoever hosts it sees
+// progress through Events, always delivered on the main loop.
+
+#ifndef CLOUD_MONITOR_HPP
+#define CLOUD_MONITOR_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <ctime>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+namespace proton {
+
+class CloudMonitor {
+public:
+    static CloudMonitor& getInstance();
+
+    struct Events {
+        std::function<void(const std::string& line)> log;
+        std::function<void(const std::string& name)> download_started;
+        std::function<void(const std::string& name, bool ok)> download_finished;
+        std::function<void()> batch_finished;   // Local and cloud views are stale
+    };
+    void set_events(Events events);
+
+    void start();
+    void stop();
+    bool is_running() const { return active_.load(); }
+
+    // Download de-duplication, shared with the GUI's auto-downloads: false
+    // if `key` is already being fetched. release_download() returns how
+    // many are still in flight.
+    bool claim_download(const std::string& key);
+    size_t release_download(const std::string& key);
+
+private:
+    CloudMonitor() = default;
+    ~CloudMonitor();
+    CloudMonitor(const CloudMonitor&) = delete;
+    CloudMonitor& operator=(const CloudMonitor&) = delete;
+
+    void run();
+    void scan();
+    void emit(std::function<void(const Events&)> fn);
+    void emit_log(const std::string& line);
+
+    std::atomic<bool> active_{false};
+    std::atomic<bool> stop_{false};   // Inverse of active_, for cancellable listings
+    std::thread thread_;
+    std::mutex wait_mutex_;
+    std::condition_variable wait_cv_;
+    std::map<std::string, std::time_t> last_check_;   // job_id -> last check time, monitor thread only
+
+    std::mutex events_mutex_;
+    Events events_;
+
+    std::mutex download_mutex_;
+    std::set<std::string> active_downloads_;
+
+    static constexpr int SCAN_INTERVAL_SECONDS = 60;
+    static constexpr int MIN_JOB_RESCAN_SECONDS = 30;
+};
+
+} // namespace proton
+
+#endif // CLOUD_MONITOR_HPP
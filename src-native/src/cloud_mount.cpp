@@ -0,0 +1,716 @@
+// cloud_mount.cpp - FUSE callbacks, block cache and pinned copies
+
+#ifdef HAVE_FUSE3
+#define FUSE_USE_VERSION 31
+#include <fuse.h>
+#endif
+
+#include "cloud_mount.hpp"
+#include "chunked_download.hpp"
+#include "logger.hpp"
+#include "rclone_rc.hpp"
+#include "settings.hpp"
+#include "task_pool.hpp"
+#include "transfer_scheduler.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace proton {
+
+namespace {
+
+// Sequential readers get this many blocks per range request
+constexpr uint64_t READAHEAD_BLOCKS = 8;
+// Listings are re-read from the index after this long
+constexpr std::chrono::seconds LISTING_TTL{2};
+constexpr size_t MAX_CACHED_LISTINGS = 256;
+
+const char* const XATTR_PINNED = "user.proton.pinned";
+const char* const XATTR_STATUS = "user.proton.status";
+
+std::string quote(const std::string& arg) {
+    std::string escaped = "'";
+    for (char c : arg) {
+        if (c == '\'') escaped += "'\"'\"'";
+        else escaped += c;
+    }
+    escaped += "'";
+    return escaped;
+}
+
+// Index ModTime ("YYYY-MM-DDTHH:MM:SS", UTC) to seconds since the epoch
+time_t index_time(const std::string& mod_time) {
+    struct tm tm = {};
+    if (std::sscanf(mod_time.c_str(), "%4d-%2d-%2dT%2d:%2d:%2d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday,
+                    &tm.tm_hour, &tm.tm_min, &tm.tm_sec) != 6) {
+        return 0;
+    }
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+    return timegm(&tm);
+}
+
+// "proton:/Docs/a.pdf" -> "proton:/Docs", "proton:/a.pdf" -> "proton:/"
+std::string remote_parent(const std::string& remote) {
+    size_t slash = remote.rfind('/');
+    if (slash == std::string::npos) return remote;
+    std::string parent = remote.substr(0, slash);
+    if (!parent.empty() && parent.back() == ':') parent += "/";
+    return parent;
+}
+
+std::string pins_file() {
+    return SettingsManager::getInstance().get_config_dir() + "/pinned-files";
+}
+
+} // namespace
+
+// ============================================================================
+// BlockCache
+// ============================================================================
+
+std::string BlockCache::key(const std::string& remote, uint64_t block) {
+    return remote + '\0' + std::to_string(block);
+}
+
+std::shared_ptr<const std::string> BlockCache::get(const std::string& remote, uint64_t block) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key(remote, block));
+    if (it == index_.end()) {
+        misses_++;
+        return nullptr;
+    }
+    hits_++;
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return it->second->data;
+}
+
+void BlockCache::put(const std::string& remote, uint64_t block, std::shared_ptr<const std::string> data) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::string k = key(remote, block);
+    auto it = index_.find(k);
+    if (it != index_.end()) {
+        bytes_ -= it->second->data->size();
+        lru_.erase(it->second);
+        index_.erase(it);
+    }
+    bytes_ += data->size();
+    lru_.push_front(Entry{k, std::move(data)});
+    index_[lru_.front().key] = lru_.begin();
+    evict_locked();
+}
+
+void BlockCache::invalidate(const std::string& remote) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::string prefix = remote + '\0';
+    for (auto it = lru_.begin(); it != lru_.end();) {
+        if (it->key.compare(0, prefix.size(), prefix) == 0) {
+            bytes_ -= it->data->size();
+            index_.erase(it->key);
+            it = lru_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void BlockCache::set_capacity(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_ = bytes;
+    evict_locked();
+}
+
+void BlockCache::evict_locked() {
+    while (bytes_ > capacity_ && !lru_.empty()) {
+        bytes_ -= lru_.back().data->size();
+        index_.erase(lru_.back().key);
+        lru_.pop_back();
+    }
+}
+
+BlockCache::Stats BlockCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats;
+    stats.bytes = bytes_;
+    stats.blocks = lru_.size();
+    stats.hits = hits_;
+    stats.misses = misses_;
+    return stats;
+}
+
+// ============================================================================
+// CloudMount - index lookups and pinned copies
+// ============================================================================
+
+CloudMount& CloudMount::getInstance() {
+    static CloudMount instance;
+    return instance;
+}
+
+CloudMount::~CloudMount() {
+    stop();
+}
+
+std::string CloudMount::mount_point() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return mount_point_;
+}
+
+std::string CloudMount::remote_for(const std::string& path) {
+    return path == "/" ? "proton:/" : "proton:" + path;
+}
+
+std::shared_ptr<const CloudMount::DirListing> CloudMount::listing(const std::string& remote_dir) {
+    auto now = Clock::now();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = dirs_.find(remote_dir);
+        if (it != dirs_.end() && now - it->second->loaded < LISTING_TTL) return it->second;
+    }
+
+    // `ls -l` stats every entry; one index read serves all of them
+    auto fresh = std::make_shared<DirListing>();
+    fresh->loaded = now;
+    for (auto& file : FileIndex::getInstance().get_directory_contents(remote_dir)) {
+        std::string name = file.name;
+        fresh->entries.emplace(std::move(name), std::move(file));
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (dirs_.size() >= MAX_CACHED_LISTINGS) dirs_.clear();
+    dirs_[remote_dir] = fresh;
+    return fresh;
+}
+
+bool CloudMount::index_entry(const std::string& remote, IndexedFile& out) {
+    std::string parent = remote_parent(remote);
+    auto dir = listing(parent);
+    auto it = dir->entries.find(remote.substr(remote.rfind('/') + 1));
+    if (it == dir->entries.end()) return false;
+    out = it->second;
+    return true;
+}
+
+bool CloudMount::lookup(const std::string& path, IndexedFile& out) {
+    if (path == "/") {
+        out = IndexedFile{};
+        out.path = "proton:/";
+        out.is_directory = true;
+        return true;
+    }
+    return index_entry(remote_for(path), out);
+}
+
+std::string CloudMount::pinned_copy(const std::string& remote) const {
+    const char* home = std::getenv("HOME");
+    std::ostringstream name;
+    name << std::hex << std::hash<std::string>{}(remote);
+    return std::string(home ? home : "/tmp") + "/.cache/proton-drive/pinned/" + name.str();
+}
+
+// A pinned copy is stamped with the index ModTime when it is fetched, so a
+// size or time difference means the cloud file changed since
+bool CloudMount::pinned_copy_current(const IndexedFile& file) const {
+    struct stat st;
+    if (stat(pinned_copy(file.path).c_str(), &st) != 0) return false;
+    return st.st_size == file.size && st.st_mtime == index_time(file.mod_time);
+}
+
+void CloudMount::fetch_pinned(const IndexedFile& file) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!pins_fetching_.insert(file.path).second) return;
+    }
+    TaskPool::getInstance().submit(TaskLane::Transfer, [this, file]() {
+        std::string dest = pinned_copy(file.path);
+        std::error_code ec;
+        fs::create_directories(fs::path(dest).parent_path(), ec);
+        Logger::info("[CloudMount] Fetching pinned file " + file.path);
+        auto ticket = TransferScheduler::getInstance().begin(TransferPriority::UserCopy, file.path);
+
+        bool ok = false;
+        ChunkedDownload chunked(file.path, dest, "");
+        if (chunked.prepare()) {
+            ok = chunked.run();
+        } else {
+            std::string output;
+            int exit_code = 1;
+            ok = RcloneRC::getInstance().run("copyto " + quote(file.path) + " " + quote(dest), 600, output, exit_code) &&
+                 exit_code == 0;
+        }
+        if (ok) {
+            struct timespec times[2] = {{0, UTIME_OMIT}, {index_time(file.mod_time), 0}};
+            utimensat(AT_FDCWD, dest.c_str(), times, 0);
+            // Reads now come from the copy; the cached blocks are dead weight
+            cache_.invalidate(file.path);
+        } else {
+            Logger::warn("[CloudMount] Could not fetch pinned file " + file.path);
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        pins_fetching_.erase(file.path);
+    });
+}
+
+void CloudMount::pin(const std::string& remote) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!pins_.insert(remote).second) return;
+        save_pins_locked();
+    }
+    IndexedFile file;
+    if (index_entry(remote, file) && !file.is_directory && !pinned_copy_current(file)) fetch_pinned(file);
+}
+
+void CloudMount::unpin(const std::string& remote) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pins_.erase(remote) == 0) return;
+        save_pins_locked();
+    }
+    unlink(pinned_copy(remote).c_str());
+}
+
+bool CloudMount::is_pinned(const std::string& remote) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pins_.count(remote) > 0;
+}
+
+void CloudMount::load_pins() {
+    std::ifstream in(pins_file());
+    std::string line;
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (std::getline(in, line)) {
+        if (!line.empty()) pins_.insert(line);
+    }
+}
+
+void CloudMount::save_pins_locked() const {
+    std::string path = pins_file();
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        for (const auto& remote : pins_) out << remote << '\n';
+    }
+    std::rename(tmp.c_str(), path.c_str());
+}
+
+#ifdef HAVE_FUSE3
+
+// ============================================================================
+// CloudMount - FUSE operations
+// ============================================================================
+
+int CloudMount::op_getattr(const std::string& path, struct stat* st) {
+    std::memset(st, 0, sizeof(*st));
+    IndexedFile file;
+    if (!lookup(path, file)) return -ENOENT;
+
+    st->st_uid = getuid();
+    st->st_gid = getgid();
+    if (file.is_directory) {
+        st->st_mode = S_IFDIR | 0555;
+        st->st_nlink = 2;
+    } else {
+        st->st_mode = S_IFREG | 0444;
+        st->st_nlink = 1;
+        st->st_size = file.size > 0 ? file.size : 0;
+        st->st_blocks = (st->st_size + 511) / 512;
+    }
+    st->st_mtime = st->st_ctime = st->st_atime = index_time(file.mod_time);
+    return 0;
+}
+
+int CloudMount::op_readdir(const std::string& path, void* buf, void* filler_ptr, bool plus) {
+    IndexedFile dir;
+    if (!lookup(path, dir)) return -ENOENT;
+    if (!dir.is_directory) return -ENOTDIR;
+
+    auto filler = reinterpret_cast<fuse_fill_dir_t>(filler_ptr);
+    filler(buf, ".", nullptr, 0, static_cast<fuse_fill_dir_flags>(0));
+    filler(buf, "..", nullptr, 0, static_cast<fuse_fill_dir_flags>(0));
+    auto entries = listing(remote_for(path));
+    for (const auto& [name, file] : entries->entries) {
+        struct stat st;
+        std::memset(&st, 0, sizeof(st));
+        st.st_mode = file.is_directory ? (S_IFDIR | 0555) : (S_IFREG | 0444);
+        if (plus) {
+            // READDIRPLUS: hand the kernel full attributes so `ls -l` needs no getattr round-trips
+            st.st_uid = getuid();
+            st.st_gid = getgid();
+            st.st_nlink = file.is_directory ? 2 : 1;
+            st.st_size = file.is_directory || file.size < 0 ? 0 : file.size;
+            st.st_mtime = st.st_ctime = st.st_atime = index_time(file.mod_time);
+        }
+        if (filler(buf, name.c_str(), &st, 0, plus ? FUSE_FILL_DIR_PLUS : static_cast<fuse_fill_dir_flags>(0))) break;
+    }
+    return 0;
+}
+
+int CloudMount::op_open(const std::string& path, uint64_t& handle) {
+    IndexedFile file;
+    if (!lookup(path, file)) return -ENOENT;
+    if (file.is_directory) return -EISDIR;
+
+    auto open_file = std::make_shared<OpenFile>();
+    open_file->remote = file.path;
+    open_file->size = file.size > 0 ? static_cast<uint64_t>(file.size) : 0;
+
+    // A synced or pinned local copy of the same size is read directly
+    auto try_local = [&](const std::string& local) {
+        if (local.empty() || open_file->fd >= 0) return;
+        int fd = ::open(local.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat st;
+        if (fd >= 0 && fstat(fd, &st) == 0 && static_cast<uint64_t>(st.st_size) == open_file->size) {
+            open_file->fd = fd;
+        } else if (fd >= 0) {
+            close(fd);
+        }
+    };
+    if (file.is_synced) try_local(file.local_path);
+    if (is_pinned(file.path)) {
+        if (pinned_copy_current(file)) try_local(pinned_copy(file.path));
+        else fetch_pinned(file);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    handle = next_handle_++;
+    open_files_[handle] = std::move(open_file);
+    return 0;
+}
+
+bool CloudMount::fetch_blocks(const OpenFile& file, uint64_t first, uint64_t count) {
+    const uint64_t total_blocks = (file.size + BlockCache::BLOCK_SIZE - 1) / BlockCache::BLOCK_SIZE;
+    count = std::min(count, total_blocks - first);
+
+    // Claim the run of blocks; if another reader is already fetching the
+    // first one, wait for it instead of downloading it twice
+    std::vector<std::string> claimed;
+    {
+        std::unique_lock<std::mutex> lock(inflight_mutex_);
+        std::string first_key = file.remote + '\0' + std::to_string(first);
+        if (inflight_.count(first_key)) {
+            inflight_cv_.wait(lock, [&] { return !inflight_.count(first_key); });
+            return true;
+        }
+        for (uint64_t i = 0; i < count; ++i) {
+            std::string key = file.remote + '\0' + std::to_string(first + i);
+            if (inflight_.count(key)) break;
+            inflight_.insert(key);
+            claimed.push_back(std::move(key));
+        }
+    }
+    count = claimed.size();
+
+    // Some application is blocked on this read: sync jobs yield meanwhile
+    auto ticket = TransferScheduler::getInstance().begin(TransferPriority::UserOpen, file.remote);
+    uint64_t offset = first * BlockCache::BLOCK_SIZE;
+    uint64_t length = std::min<uint64_t>(count * BlockCache::BLOCK_SIZE, file.size - offset);
+    std::string data;
+    data.reserve(length);
+    bool ok = RcloneRC::getInstance().read_range(file.remote, offset, length, [&](const char* bytes, size_t size) {
+        data.append(bytes, size);
+        return true;
+    }, 30);
+
+    if (ok) {
+        for (uint64_t i = 0; i < count; ++i) {
+            size_t start = i * BlockCache::BLOCK_SIZE;
+            size_t size = std::min<size_t>(BlockCache::BLOCK_SIZE, data.size() - start);
+            cache_.put(file.remote, first + i, std::make_shared<const std::string>(data, start, size));
+        }
+    } else {
+        Logger::debug("[CloudMount] Range read failed for " + file.remote + " @" + std::to_string(offset));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(inflight_mutex_);
+        for (const auto& key : claimed) inflight_.erase(key);
+    }
+    inflight_cv_.notify_all();
+    return ok;
+}
+
+int CloudMount::op_read(uint64_t handle, char* buf, size_t size, uint64_t offset) {
+    std::shared_ptr<OpenFile> file;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = open_files_.find(handle);
+        if (it == open_files_.end()) return -EBADF;
+        file = it->second;
+    }
+
+    if (file->fd >= 0) {
+        ssize_t n = pread(file->fd, buf, size, static_cast<off_t>(offset));
+        return n < 0 ? -errno : static_cast<int>(n);
+    }
+
+    if (offset >= file->size) return 0;
+    size = static_cast<size_t>(std::min<uint64_t>(size, file->size - offset));
+    bool sequential = file->next_offset.load() == offset && offset > 0;
+
+    size_t copied = 0;
+    while (copied < size) {
+        uint64_t position = offset + copied;
+        uint64_t block = position / BlockCache::BLOCK_SIZE;
+        auto data = cache_.get(file->remote, block);
+        if (!data) {
+            if (!RcloneRC::getInstance().is_ready()) return -EIO;
+            // Retry once: a wait on another reader's fetch may have ended in its failure
+            for (int attempt = 0; attempt < 2 && !data; ++attempt) {
+                fetch_blocks(*file, block, sequential ? READAHEAD_BLOCKS : 1);
+                data = cache_.get(file->remote, block);
+            }
+            if (!data) return copied > 0 ? static_cast<int>(copied) : -EIO;
+        }
+        size_t within = static_cast<size_t>(position - block * BlockCache::BLOCK_SIZE);
+        if (within >= data->size()) break;
+        size_t n = std::min(size - copied, data->size() - within);
+        std::memcpy(buf + copied, data->data() + within, n);
+        copied += n;
+    }
+    file->next_offset.store(offset + copied);
+    return static_cast<int>(copied);
+}
+
+void CloudMount::op_release(uint64_t handle) {
+    std::shared_ptr<OpenFile> file;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = open_files_.find(handle);
+        if (it == open_files_.end()) return;
+        file = std::move(it->second);
+        open_files_.erase(it);
+    }
+    if (file->fd >= 0) close(file->fd);
+}
+
+int CloudMount::op_getxattr(const std::string& path, const std::string& name, char* value, size_t size) {
+    IndexedFile file;
+    if (!lookup(path, file)) return -ENOENT;
+
+    std::string result;
+    if (name == XATTR_PINNED) {
+        result = is_pinned(file.path) ? "1" : "0";
+    } else if (name == XATTR_STATUS) {
+        if (file.is_directory) result = "folder";
+        else if (file.is_synced) result = "synced";
+        else if (is_pinned(file.path)) result = pinned_copy_current(file) ? "pinned" : "pinning";
+        else result = "cloud";
+    } else {
+        return -ENODATA;
+    }
+    if (size == 0) return static_cast<int>(result.size());
+    if (size < result.size()) return -ERANGE;
+    std::memcpy(value, result.data(), result.size());
+    return static_cast<int>(result.size());
+}
+
+int CloudMount::op_setxattr(const std::string& path, const std::string& name, const char* value, size_t size) {
+    if (name != XATTR_PINNED) return -ENOTSUP;
+    IndexedFile file;
+    if (!lookup(path, file)) return -ENOENT;
+    if (file.is_directory) return -EISDIR;
+
+    std::string flag(value, size);
+    if (flag == "1" || flag == "true") pin(file.path);
+    else if (flag == "0" || flag == "false") unpin(file.path);
+    else return -EINVAL;
+    return 0;
+}
+
+int CloudMount::op_listxattr(char* list, size_t size) {
+    std::string names = std::string(XATTR_PINNED) + '\0' + XATTR_STATUS + '\0';
+    if (size == 0) return static_cast<int>(names.size());
+    if (size < names.size()) return -ERANGE;
+    std::memcpy(list, names.data(), names.size());
+    return static_cast<int>(names.size());
+}
+
+namespace {
+
+int fuse_getattr(const char* path, struct stat* st, struct fuse_file_info*) {
+    return CloudMount::getInstance().op_getattr(path, st);
+}
+
+int fuse_readdir(const char* path, void* buf, fuse_fill_dir_t filler, off_t, struct fuse_file_info*,
+                 enum fuse_readdir_flags flags) {
+    return CloudMount::getInstance().op_readdir(path, buf, reinterpret_cast<void*>(filler),
+                                                (flags & FUSE_READDIR_PLUS) != 0);
+}
+
+int fuse_open(const char* path, struct fuse_file_info* fi) {
+    if ((fi->flags & O_ACCMODE) != O_RDONLY) return -EROFS;
+    uint64_t handle = 0;
+    int result = CloudMount::getInstance().op_open(path, handle);
+    fi->fh = handle;
+    return result;
+}
+
+int fuse_read(const char*, char* buf, size_t size, off_t offset, struct fuse_file_info* fi) {
+    return CloudMount::getInstance().op_read(fi->fh, buf, size, static_cast<uint64_t>(offset));
+}
+
+int fuse_release(const char*, struct fuse_file_info* fi) {
+    CloudMount::getInstance().op_release(fi->fh);
+    return 0;
+}
+
+int fuse_getxattr(const char* path, const char* name, char* value, size_t size) {
+    return CloudMount::getInstance().op_getxattr(path, name, value, size);
+}
+
+int fuse_setxattr(const char* path, const char* name, const char* value, size_t size, int) {
+    return CloudMount::getInstance().op_setxattr(path, name, value, size);
+}
+
+int fuse_listxattr(const char*, char* list, size_t size) {
+    return CloudMount::getInstance().op_listxattr(list, size);
+}
+
+void* fuse_init_fs(struct fuse_conn_info*, struct fuse_config* cfg) {
+    // The index refreshes in the background; let the kernel cache attributes
+    // briefly and drop cached pages whenever a file's size or mtime changes
+    cfg->entry_timeout = 5;
+    cfg->attr_timeout = 5;
+    cfg->negative_timeout = 5;
+    cfg->auto_cache = 1;
+    return nullptr;
+}
+
+struct fuse_operations make_operations() {
+    struct fuse_operations ops;
+    std::memset(&ops, 0, sizeof(ops));
+    ops.getattr = fuse_getattr;
+    ops.readdir = fuse_readdir;
+    ops.open = fuse_open;
+    ops.read = fuse_read;
+    ops.release = fuse_release;
+    ops.getxattr = fuse_getxattr;
+    ops.setxattr = fuse_setxattr;
+    ops.listxattr = fuse_listxattr;
+    ops.init = fuse_init_fs;
+    return ops;
+}
+
+void lazy_unmount(const std::string& mount_point) {
+    std::string cmd = "fusermount3 -u -z " + quote(mount_point) + " >/dev/null 2>&1 || fusermount -u -z " +
+                      quote(mount_point) + " >/dev/null 2>&1";
+    if (std::system(cmd.c_str()) != 0) {
+        Logger::debug("[CloudMount] fusermount -u -z " + mount_point + " failed");
+    }
+}
+
+} // namespace
+
+bool CloudMount::start(const std::string& mount_point, size_t cache_bytes) {
+    if (mounted_.load()) return true;
+    cache_.set_capacity(cache_bytes);
+
+    // A previous crash leaves a dead endpoint ("Transport endpoint is not connected")
+    struct stat st;
+    if (stat(mount_point.c_str(), &st) != 0 && errno == ENOTCONN) {
+        Logger::info("[CloudMount] Cleaning up stale mount at " + mount_point);
+        lazy_unmount(mount_point);
+    }
+    std::error_code ec;
+    fs::create_directories(mount_point, ec);
+
+    struct fuse_args args = FUSE_ARGS_INIT(0, nullptr);
+    fuse_opt_add_arg(&args, "proton-drive");
+    fuse_opt_add_arg(&args, "-o");
+    fuse_opt_add_arg(&args, "ro,fsname=proton-drive,subtype=proton-drive,default_permissions");
+    static const struct fuse_operations ops = make_operations();
+    struct fuse* fuse = fuse_new(&args, &ops, sizeof(ops), nullptr);
+    fuse_opt_free_args(&args);
+    if (!fuse) {
+        Logger::warn("[CloudMount] fuse_new failed");
+        return false;
+    }
+    if (fuse_mount(fuse, mount_point.c_str()) != 0) {
+        Logger::warn("[CloudMount] Could not mount at " + mount_point + " (is fuse3 installed and /dev/fuse accessible?)");
+        fuse_destroy(fuse);
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        mount_point_ = mount_point;
+        fuse_ = fuse;
+    }
+    load_pins();
+    loop_done_.store(false);
+    loop_thread_ = std::thread([this, fuse]() {
+        fuse_loop_mt(fuse, 0);
+        loop_done_.store(true);
+    });
+    mounted_.store(true);
+    Logger::info("[CloudMount] Mounted cloud files at " + mount_point);
+
+    // Bring pinned copies up to date with the index
+    TaskPool::getInstance().submit(TaskLane::Background, [this]() {
+        std::set<std::string> pins;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pins = pins_;
+        }
+        for (const auto& remote : pins) {
+            IndexedFile file;
+            if (index_entry(remote, file) && !file.is_directory && !pinned_copy_current(file)) fetch_pinned(file);
+        }
+    });
+    return true;
+}
+
+void CloudMount::stop() {
+    if (!mounted_.exchange(false)) return;
+    struct fuse* fuse;
+    std::string mount_point;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        fuse = static_cast<struct fuse*>(fuse_);
+        mount_point = mount_point_;
+    }
+    fuse_exit(fuse);
+    fuse_unmount(fuse);
+    // An application still holding a file open keeps a regular unmount busy
+    for (int i = 0; i < 20 && !loop_done_.load(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    if (!loop_done_.load()) lazy_unmount(mount_point);
+    if (loop_thread_.joinable()) loop_thread_.join();
+    fuse_destroy(fuse);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    fuse_ = nullptr;
+    for (auto& [handle, file] : open_files_) {
+        if (file->fd >= 0) close(file->fd);
+    }
+    open_files_.clear();
+    dirs_.clear();
+    Logger::info("[CloudMount] Unmounted " + mount_point);
+}
+
+#else // !HAVE_FUSE3
+
+bool CloudMount::start(const std::string& mount_point, size_t) {
+    Logger::warn("[CloudMount] Built without libfuse3 - cannot mount " + mount_point);
+    return false;
+}
+
+void CloudMount::stop() {}
+
+#endif // HAVE_FUSE3
+
+} // namespace proton
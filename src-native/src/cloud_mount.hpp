@@ -0,0 +1,163 @@
+// cloud_mount.hpp - Files-on-demand FUSE view of the cloud index
+// Exposes the whole drive as a read-only FUSE mount so any application can
+// open cloud-only files without a full bisync mirror. Directory listings and
+// attributes come from FileIndex (the in-memory path tree, no network);
+// file contents are fetched on first read as byte ranges through the RC
+// daemon into a bounded in-memory LRU block cache. Files already synced
+// locally are read straight from their local copy, and pinned ("keep on
+// this device") files are downloaded whole to the cache directory and kept
+// up to date. Pin with `setfattr -n user.proton.pinned -v 1 <file>`.
+// Built only when libfuse3 is available (HAVE_FUSE3).
+
+#ifndef CLOUD_MOUNT_HPP
+#define CLOUD_MOUNT_HPP
+
+#include "file_index.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <sys/stat.h>
+
+namespace proton {
+
+/**
+ * LRU cache of fixed-size blocks of remote files, bounded in bytes.
+ * A block is identified by (remote path, index); the last block of a file
+ * may be short. Thread-safe.
+ */
+class BlockCache {
+public:
+    static constexpr size_t BLOCK_SIZE = 1 << 20;
+
+    explicit BlockCache(size_t capacity_bytes) : capacity_(capacity_bytes) {}
+
+    std::shared_ptr<const std::string> get(const std::string& remote, uint64_t block);
+    void put(const std::string& remote, uint64_t block, std::shared_ptr<const std::string> data);
+    // Drop every block of `remote` (the file changed or was pinned)
+    void invalidate(const std::string& remote);
+    void set_capacity(size_t bytes);
+
+    struct Stats {
+        size_t bytes = 0;
+        size_t blocks = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+    };
+    Stats stats() const;
+
+private:
+    static std::string key(const std::string& remote, uint64_t block);
+    void evict_locked();
+
+    struct Entry {
+        std::string key;
+        std::shared_ptr<const std::string> data;
+    };
+
+    mutable std::mutex mutex_;
+    std::list<Entry> lru_;          // Front = most recently used
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    size_t capacity_;
+    size_t bytes_ = 0;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+};
+
+class CloudMount {
+public:
+    static CloudMount& getInstance();
+
+    // Mount the drive at `mount_point` (created if missing) and serve it
+    // from a background thread. False if FUSE is unavailable or the mount
+    // failed; the reason is logged.
+    bool start(const std::string& mount_point, size_t cache_bytes);
+    void stop();
+    bool is_mounted() const { return mounted_.load(); }
+    std::string mount_point() const;
+
+    // Keep a full local copy of a cloud file ("proton:/Docs/a.pdf") so it
+    // opens without the network; persisted across restarts
+    void pin(const std::string& remote);
+    void unpin(const std::string& remote);
+    bool is_pinned(const std::string& remote) const;
+
+    BlockCache::Stats cache_stats() const { return cache_.stats(); }
+
+    // FUSE callbacks (cloud_mount.cpp) - public only so the C trampolines
+    // can reach them
+    int op_getattr(const std::string& path, struct stat* st);
+    int op_readdir(const std::string& path, void* buf, void* filler, bool plus);
+    int op_open(const std::string& path, uint64_t& handle);
+    int op_read(uint64_t handle, char* buf, size_t size, uint64_t offset);
+    void op_release(uint64_t handle);
+    int op_getxattr(const std::string& path, const std::string& name, char* value, size_t size);
+    int op_setxattr(const std::string& path, const std::string& name, const char* value, size_t size);
+    int op_listxattr(char* list, size_t size);
+
+private:
+    CloudMount() = default;
+    ~CloudMount();
+
+    CloudMount(const CloudMount&) = delete;
+    CloudMount& operator=(const CloudMount&) = delete;
+
+    using Clock = std::chrono::steady_clock;
+
+    struct OpenFile {
+        std::string remote;
+        uint64_t size = 0;
+        int fd = -1;                        // Local copy (synced or pinned), else -1
+        std::atomic<uint64_t> next_offset{0};   // Where a sequential reader goes next
+    };
+
+    struct DirListing {
+        Clock::time_point loaded;
+        std::map<std::string, IndexedFile> entries;   // By name
+    };
+
+    static std::string remote_for(const std::string& path);
+    std::shared_ptr<const DirListing> listing(const std::string& remote_dir);
+    bool index_entry(const std::string& remote, IndexedFile& out);
+    bool lookup(const std::string& path, IndexedFile& out);
+    std::string pinned_copy(const std::string& remote) const;
+    bool pinned_copy_current(const IndexedFile& file) const;
+    void fetch_pinned(const IndexedFile& file);
+    void load_pins();
+    void save_pins_locked() const;
+
+    // Fill blocks [first, first + count) of `file` from the cloud
+    bool fetch_blocks(const OpenFile& file, uint64_t first, uint64_t count);
+
+    BlockCache cache_{256u << 20};
+
+    mutable std::mutex mutex_;
+    std::string mount_point_;
+    std::map<std::string, std::shared_ptr<const DirListing>> dirs_;
+    std::set<std::string> pins_;            // Remote paths
+    std::set<std::string> pins_fetching_;
+    uint64_t next_handle_ = 1;
+    std::unordered_map<uint64_t, std::shared_ptr<OpenFile>> open_files_;
+
+    // Blocks being downloaded; other readers of the same block wait
+    std::mutex inflight_mutex_;
+    std::condition_variable inflight_cv_;
+    std::set<std::string> inflight_;
+
+    void* fuse_ = nullptr;                  // struct fuse*
+    std::thread loop_thread_;
+    std::atomic<bool> loop_done_{false};
+    std::atomic<bool> mounted_{false};
+};
+
+} // namespace proton
+
+#endif // CLOUD_MOUNT_HPP
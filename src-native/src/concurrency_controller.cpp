@@ -0,0 +1,129 @@
+// concurrency_controller.cpp - Hill-climbing transfer counts per sync job
+
+#include "concurrency_controller.hpp"
+#include "logger.hpp"
+#include <algorithm>
+
+namespace proton {
+
+namespace {
+
+// A run must beat the best count's throughput by this much to replace it;
+// smaller gains are within the run-to-run noise of changing file mixes
+constexpr double MIN_GAIN = 1.10;
+
+// rclone reports the Proton API pushing back as 429s or 5xx responses
+bool is_pushback_error(const std::string& error) {
+    std::string lower = error;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    for (const char* needle : {"429", "too many", "rate limit", "502", "503", "bad gateway"}) {
+        if (lower.find(needle) != std::string::npos) return true;
+    }
+    return false;
+}
+
+} // namespace
+
+ConcurrencyController& ConcurrencyController::getInstance() {
+    static ConcurrencyController instance;
+    return instance;
+}
+
+int ConcurrencyController::checkers_for(int transfers) {
+    return std::clamp(transfers * 2, 4, 64);
+}
+
+void ConcurrencyController::observe(int pid, const std::string& job_id, int transfers,
+                                    double throughput, int errors, const std::string& last_error) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = runs_.find(pid);
+    if (it == runs_.end()) {
+        Run run;
+        run.job_id = job_id;
+        run.transfers = std::clamp(transfers, MIN_TRANSFERS, MAX_TRANSFERS);
+        run.errors = errors;
+        it = runs_.emplace(pid, std::move(run)).first;
+    }
+    Run& run = it->second;
+
+    if (errors > run.errors) {
+        run.errors = errors;
+        if (is_pushback_error(last_error)) run.pushback = true;
+    }
+    // Listing and checking phases move no data; they say nothing about streams
+    if (throughput > 0) {
+        run.throughput_sum += throughput;
+        run.samples++;
+    }
+}
+
+Concurrency ConcurrencyController::finish(int pid, std::string& job_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = runs_.find(pid);
+    if (it == runs_.end()) return {};
+    Run run = std::move(it->second);
+    runs_.erase(it);
+    job_id = run.job_id;
+    if (job_id.empty()) return {};
+
+    Concurrency next = next_run(history_[job_id], run);
+    if (next.valid() && next.transfers != run.transfers) {
+        Logger::debug("[Concurrency] Job " + job_id + ": next run " + std::to_string(run.transfers) +
+                      " -> " + std::to_string(next.transfers) + " transfers");
+    }
+    return next;
+}
+
+Concurrency ConcurrencyController::next_run(JobHistory& history, const Run& run) {
+    auto setting = [&](int transfers) {
+        transfers = std::clamp(transfers, MIN_TRANSFERS, history.ceiling);
+        return Concurrency{transfers, checkers_for(transfers)};
+    };
+
+    // Multiplicative decrease: the server told this run to slow down
+    if (run.pushback && run.transfers > MIN_TRANSFERS) {
+        history.ceiling = std::max(MIN_TRANSFERS, run.transfers - 1);
+        history.climbing = false;
+        history.settled_runs = 0;
+        history.best_transfers = 0;
+        history.best_throughput = 0;
+        return setting(run.transfers / 2);
+    }
+    if (run.samples < MIN_SAMPLES) return {};  // Too little data moved to judge
+
+    double average = run.throughput_sum / run.samples;
+    if (history.best_transfers == 0 || run.transfers == history.best_transfers) {
+        // First measurement, or another run at the best count: keep a running average
+        history.best_throughput = history.best_transfers == 0
+            ? average : (history.best_throughput + average) / 2;
+        history.best_transfers = run.transfers;
+    } else if (average >= history.best_throughput * MIN_GAIN) {
+        // The probe paid for itself: it becomes the count to beat
+        history.best_transfers = run.transfers;
+        history.best_throughput = average;
+        history.climbing = true;
+    } else {
+        // Not worth the extra streams: settle on the best count
+        history.climbing = false;
+        history.settled_runs = 0;
+        return setting(history.best_transfers);
+    }
+
+    int best = history.best_transfers;
+    if (best >= history.ceiling) {
+        history.climbing = false;
+        return setting(best);
+    }
+    if (history.climbing) {
+        // Grow by half while it keeps helping, so 2 -> 16 takes a few runs
+        return setting(best + std::max(1, best / 2));
+    }
+    if (++history.settled_runs >= REPROBE_RUNS) {
+        // Conditions change (file sizes, other jobs); probe one more stream
+        history.settled_runs = 0;
+        return setting(best + 1);
+    }
+    return setting(best);
+}
+
+} // namespace proton
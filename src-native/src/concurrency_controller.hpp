@@ -0,0 +1,85 @@
+// concurrency_controller.hpp - Adaptive rclone --transfers/--checkers per sync job
+// Small-file jobs are latency bound and keep getting faster up to 16+
+// streams; large files saturate the link with a few. rclone sizes its
+// transfer pool at startup, so the count cannot be changed mid-run: the
+// controller instead hill-climbs from run to run. It averages the
+// throughput BandwidthMonitor measures for each run, compares it with the
+// best count seen for the job, and picks the next run's count, halving it on
+// rate-limit and server errors. SyncManager stores the result in
+// SyncJobMetadata, and it is passed as --transfers/--checkers when the job
+// next starts.
+
+#ifndef CONCURRENCY_CONTROLLER_HPP
+#define CONCURRENCY_CONTROLLER_HPP
+
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace proton {
+
+struct Concurrency {
+    int transfers = 0;
+    int checkers = 0;
+    bool valid() const { return transfers > 0; }
+};
+
+class ConcurrencyController {
+public:
+    static ConcurrencyController& getInstance();
+
+    // One stats round for a running process. `transfers` is what it was
+    // started with, `throughput` the job's current bytes/s and
+    // `errors`/`last_error` rclone's core/stats counters.
+    void observe(int pid, const std::string& job_id, int transfers,
+                 double throughput, int errors, const std::string& last_error);
+
+    // Forget a finished process. Returns the setting for the job's next run
+    // (invalid if this run taught nothing) and the job it belonged to.
+    Concurrency finish(int pid, std::string& job_id);
+
+    // Checkers to run alongside a transfer count
+    static int checkers_for(int transfers);
+
+    static constexpr int MIN_TRANSFERS = 1;
+    static constexpr int MAX_TRANSFERS = 32;
+    static constexpr int DEFAULT_TRANSFERS = 4;  // rclone's own default
+    static constexpr int MIN_SAMPLES = 10;       // Seconds of moving data before a run counts
+    static constexpr int REPROBE_RUNS = 5;       // Settled runs before trying one more stream
+
+private:
+    ConcurrencyController() = default;
+
+    ConcurrencyController(const ConcurrencyController&) = delete;
+    ConcurrencyController& operator=(const ConcurrencyController&) = delete;
+
+    // One running process
+    struct Run {
+        std::string job_id;
+        int transfers = DEFAULT_TRANSFERS;
+        int errors = 0;
+        bool pushback = false;       // Rate-limit or server errors seen
+        double throughput_sum = 0;
+        int samples = 0;
+    };
+
+    // What earlier runs of a job showed (this session only; the persisted
+    // learned_transfers is the starting point after a restart)
+    struct JobHistory {
+        int best_transfers = 0;
+        double best_throughput = 0;
+        int ceiling = MAX_TRANSFERS;  // Lowered when the server pushes back
+        bool climbing = true;
+        int settled_runs = 0;
+    };
+
+    Concurrency next_run(JobHistory& history, const Run& run);
+
+    std::mutex mutex_;
+    std::map<int, Run> runs_;
+    std::map<std::string, JobHistory> history_;
+};
+
+} // namespace proton
+
+#endif // CONCURRENCY_CONTROLLER_HPP
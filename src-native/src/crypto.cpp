@@ -8,10 +8,12 @@
 #include <openssl/rand.h>
 #include <openssl/err.h>
 #include <openssl/sha.h>
+#include <openssl/hmac.h>
 
 #include <fstream>
 #include <filesystem>
 #include <cstring>
+#include <algorithm>
 
 namespace fs = std::filesystem;
 
@@ -189,40 +191,351 @@ std::vector<uint8_t> decrypt(const std::vector<uint8_t>& ciphertext,
     return plaintext;
 }
 
-bool is_encrypted_file(const std::string& path) {
+namespace {
+
+constexpr size_t STREAM_SEGMENT_OVERHEAD = TAG_SIZE;
+
+// 0 = not ours, 1 = PDCRYPT1 (single GCM message), 2 = PDCRYPT2 (segmented)
+int encrypted_file_version(const std::string& path) {
     std::ifstream file(path, std::ios::binary);
-    if (!file) return false;
+    if (!file) return 0;
     
     uint8_t header[sizeof(MAGIC)];
     file.read(reinterpret_cast<char*>(header), sizeof(MAGIC));
-    
-    return file.gcount() == sizeof(MAGIC) && 
-           std::memcmp(header, MAGIC, sizeof(MAGIC)) == 0;
+    if (file.gcount() != sizeof(MAGIC)) return 0;
+    if (std::memcmp(header, MAGIC, sizeof(MAGIC)) == 0) return 1;
+    if (std::memcmp(header, MAGIC_V2, sizeof(MAGIC_V2)) == 0) return 2;
+    return 0;
 }
 
-bool encrypt_file(const std::string& path, const std::vector<uint8_t>& key) {
+struct StreamHeader {
+    uint8_t raw[STREAM_HEADER_SIZE];
+    uint32_t segment_size = 0;
+    const uint8_t* salt() const { return raw + sizeof(MAGIC_V2) + 4; }
+    const uint8_t* nonce_prefix() const { return salt() + SALT_SIZE; }
+};
+
+bool parse_stream_header(const uint8_t* raw, StreamHeader& header) {
+    if (std::memcmp(raw, MAGIC_V2, sizeof(MAGIC_V2)) != 0) return false;
+    std::memcpy(header.raw, raw, STREAM_HEADER_SIZE);
+    const uint8_t* p = raw + sizeof(MAGIC_V2);
+    header.segment_size = (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+    return header.segment_size > 0 && header.segment_size <= 16 * 1024 * 1024;
+}
+
+std::vector<uint8_t> stream_file_key(const std::vector<uint8_t>& key, const StreamHeader& header) {
+    uint8_t input[sizeof(MAGIC_V2) + SALT_SIZE];
+    std::memcpy(input, MAGIC_V2, sizeof(MAGIC_V2));
+    std::memcpy(input + sizeof(MAGIC_V2), header.salt(), SALT_SIZE);
+    
+    std::vector<uint8_t> file_key(KEY_SIZE);
+    unsigned int len = 0;
+    if (!HMAC(EVP_sha256(), key.data(), static_cast<int>(key.size()), input, sizeof(input),
+              file_key.data(), &len) || len != KEY_SIZE) {
+        Logger::error("[Crypto] Failed to derive stream key");
+        return {};
+    }
+    return file_key;
+}
+
+void segment_nonce(const StreamHeader& header, uint64_t index, bool final, uint8_t* nonce) {
+    std::memcpy(nonce, header.nonce_prefix(), STREAM_NONCE_PREFIX_SIZE);
+    nonce[7] = static_cast<uint8_t>(index >> 24);
+    nonce[8] = static_cast<uint8_t>(index >> 16);
+    nonce[9] = static_cast<uint8_t>(index >> 8);
+    nonce[10] = static_cast<uint8_t>(index);
+    nonce[11] = final ? 1 : 0;
+}
+
+// out must hold len + TAG_SIZE bytes
+bool seal_segment(EVP_CIPHER_CTX* ctx, const std::vector<uint8_t>& file_key, const StreamHeader& header,
+                  uint64_t index, bool final, const uint8_t* in, size_t len, uint8_t* out) {
+    uint8_t nonce[IV_SIZE];
+    segment_nonce(header, index, final, nonce);
+    int out_len = 0;
+    int final_len = 0;
+    return EVP_EncryptInit_ex(ctx, EVP_aes_256_gcm(), nullptr, file_key.data(), nonce) == 1 &&
+           EVP_EncryptUpdate(ctx, nullptr, &out_len, header.raw, STREAM_HEADER_SIZE) == 1 &&
+           EVP_EncryptUpdate(ctx, out, &out_len, in, static_cast<int>(len)) == 1 &&
+           EVP_EncryptFinal_ex(ctx, out + out_len, &final_len) == 1 &&
+           EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, TAG_SIZE, out + len) == 1;
+}
+
+// in holds len ciphertext bytes followed by the tag; out must hold len bytes
+bool open_segment(EVP_CIPHER_CTX* ctx, const std::vector<uint8_t>& file_key, const StreamHeader& header,
+                  uint64_t index, bool final, const uint8_t* in, size_t len, uint8_t* out) {
+    uint8_t nonce[IV_SIZE];
+    segment_nonce(header, index, final, nonce);
+    uint8_t tag[TAG_SIZE];
+    std::memcpy(tag, in + len, TAG_SIZE);
+    int out_len = 0;
+    int final_len = 0;
+    return EVP_DecryptInit_ex(ctx, EVP_aes_256_gcm(), nullptr, file_key.data(), nonce) == 1 &&
+           EVP_DecryptUpdate(ctx, nullptr, &out_len, header.raw, STREAM_HEADER_SIZE) == 1 &&
+           EVP_DecryptUpdate(ctx, out, &out_len, in, static_cast<int>(len)) == 1 &&
+           EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, TAG_SIZE, tag) == 1 &&
+           EVP_DecryptFinal_ex(ctx, out + out_len, &final_len) == 1;
+}
+
+// Fill buf from in; returns bytes read (short only at EOF)
+size_t read_full(std::istream& in, uint8_t* buf, size_t len) {
+    in.read(reinterpret_cast<char*>(buf), static_cast<std::streamsize>(len));
+    return static_cast<size_t>(in.gcount());
+}
+
+bool at_eof(std::istream& in) {
+    return in.peek() == std::char_traits<char>::eof();
+}
+
+// Legacy PDCRYPT1: one GCM message over the whole file
+bool decrypt_file_v1(const std::string& path, const std::string& temp_path, const std::vector<uint8_t>& key) {
     // Read entire file
     std::ifstream in_file(path, std::ios::binary | std::ios::ate);
     if (!in_file) {
-        Logger::error("[Crypto] Failed to open file for encryption: " + path);
+        Logger::error("[Crypto] Failed to open file for decryption: " + path);
         return false;
     }
     
     size_t file_size = in_file.tellg();
-    in_file.seekg(0);
+    in_file.seekg(sizeof(MAGIC));  // Skip magic header
     
-    std::vector<uint8_t> plaintext(file_size);
-    in_file.read(reinterpret_cast<char*>(plaintext.data()), file_size);
+    std::vector<uint8_t> ciphertext(file_size - sizeof(MAGIC));
+    in_file.read(reinterpret_cast<char*>(ciphertext.data()), ciphertext.size());
     in_file.close();
     
-    // Encrypt
-    std::vector<uint8_t> ciphertext = encrypt(plaintext, key);
-    if (ciphertext.empty()) {
-        Logger::error("[Crypto] Encryption failed for file: " + path);
+    // Decrypt
+    std::vector<uint8_t> plaintext = decrypt(ciphertext, key);
+    if (plaintext.empty()) {
+        Logger::error("[Crypto] Decryption failed for file: " + path);
+        return false;
+    }
+    
+    // Write decrypted file
+    std::ofstream out_file(temp_path, std::ios::binary);
+    if (!out_file) {
+        Logger::error("[Crypto] Failed to create decrypted file: " + temp_path);
+        return false;
+    }
+    
+    out_file.write(reinterpret_cast<const char*>(plaintext.data()), plaintext.size());
+    return static_cast<bool>(out_file);
+}
+
+} // namespace
+
+bool encrypt_stream(std::istream& in, std::ostream& out, const std::vector<uint8_t>& key,
+                    size_t segment_size) {
+    if (key.size() != KEY_SIZE) {
+        Logger::error("[Crypto] Invalid key size: " + std::to_string(key.size()));
+        return false;
+    }
+    
+    StreamHeader header;
+    header.segment_size = static_cast<uint32_t>(segment_size);
+    uint8_t* p = header.raw;
+    std::memcpy(p, MAGIC_V2, sizeof(MAGIC_V2));
+    p += sizeof(MAGIC_V2);
+    *p++ = static_cast<uint8_t>(segment_size >> 24);
+    *p++ = static_cast<uint8_t>(segment_size >> 16);
+    *p++ = static_cast<uint8_t>(segment_size >> 8);
+    *p++ = static_cast<uint8_t>(segment_size);
+    if (RAND_bytes(p, SALT_SIZE + STREAM_NONCE_PREFIX_SIZE) != 1) {
+        Logger::error("[Crypto] Failed to generate stream salt");
+        return false;
+    }
+    
+    std::vector<uint8_t> file_key = stream_file_key(key, header);
+    if (file_key.empty()) return false;
+    
+    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+    if (!ctx) {
+        Logger::error("[Crypto] Failed to create cipher context");
         return false;
     }
     
-    // Write encrypted file with magic header
+    out.write(reinterpret_cast<const char*>(header.raw), STREAM_HEADER_SIZE);
+    
+    // Constant memory: one plaintext and one sealed segment
+    std::vector<uint8_t> plain(segment_size);
+    std::vector<uint8_t> sealed(segment_size + STREAM_SEGMENT_OVERHEAD);
+    bool ok = true;
+    for (uint64_t index = 0; ok; index++) {
+        size_t len = read_full(in, plain.data(), segment_size);
+        bool final = len < segment_size || at_eof(in);
+        if (index > UINT32_MAX ||
+            !seal_segment(ctx, file_key, header, index, final, plain.data(), len, sealed.data())) {
+            Logger::error("[Crypto] Failed to encrypt segment " + std::to_string(index));
+            ok = false;
+            break;
+        }
+        out.write(reinterpret_cast<const char*>(sealed.data()), len + TAG_SIZE);
+        if (!out) {
+            Logger::error("[Crypto] Write failed while encrypting");
+            ok = false;
+        }
+        if (final) break;
+    }
+    
+    EVP_CIPHER_CTX_free(ctx);
+    OPENSSL_cleanse(plain.data(), plain.size());
+    return ok;
+}
+
+bool decrypt_stream(std::istream& in, std::ostream& out, const std::vector<uint8_t>& key) {
+    if (key.size() != KEY_SIZE) {
+        Logger::error("[Crypto] Invalid key size for decryption");
+        return false;
+    }
+    
+    uint8_t raw[STREAM_HEADER_SIZE];
+    StreamHeader header;
+    if (read_full(in, raw, STREAM_HEADER_SIZE) != STREAM_HEADER_SIZE || !parse_stream_header(raw, header)) {
+        Logger::error("[Crypto] Invalid PDCRYPT2 header");
+        return false;
+    }
+    
+    std::vector<uint8_t> file_key = stream_file_key(key, header);
+    if (file_key.empty()) return false;
+    
+    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+    if (!ctx) {
+        Logger::error("[Crypto] Failed to create cipher context");
+        return false;
+    }
+    
+    size_t sealed_size = header.segment_size + STREAM_SEGMENT_OVERHEAD;
+    std::vector<uint8_t> sealed(sealed_size);
+    std::vector<uint8_t> plain(header.segment_size);
+    bool ok = true;
+    for (uint64_t index = 0; ; index++) {
+        size_t got = read_full(in, sealed.data(), sealed_size);
+        bool final = got < sealed_size || at_eof(in);
+        if (got < TAG_SIZE || index > UINT32_MAX) {
+            Logger::error("[Crypto] Truncated PDCRYPT2 stream at segment " + std::to_string(index));
+            ok = false;
+            break;
+        }
+        size_t len = got - TAG_SIZE;
+        if (!open_segment(ctx, file_key, header, index, final, sealed.data(), len, plain.data())) {
+            Logger::error("[Crypto] Segment " + std::to_string(index) + " failed authentication");
+            ok = false;
+            break;
+        }
+        out.write(reinterpret_cast<const char*>(plain.data()), len);
+        if (!out) {
+            Logger::error("[Crypto] Write failed while decrypting");
+            ok = false;
+            break;
+        }
+        if (final) break;
+    }
+    
+    EVP_CIPHER_CTX_free(ctx);
+    OPENSSL_cleanse(plain.data(), plain.size());
+    return ok;
+}
+
+bool EncryptedFileReader::open(const std::string& path, const std::vector<uint8_t>& key) {
+    file_.close();
+    file_.clear();
+    cached_index_ = UINT64_MAX;
+    if (key.size() != KEY_SIZE) return false;
+    
+    file_.open(path, std::ios::binary | std::ios::ate);
+    if (!file_) {
+        Logger::error("[Crypto] Failed to open encrypted file: " + path);
+        return false;
+    }
+    uint64_t file_size = static_cast<uint64_t>(file_.tellg());
+    file_.seekg(0);
+    
+    uint8_t raw[STREAM_HEADER_SIZE];
+    StreamHeader header;
+    if (file_size < STREAM_HEADER_SIZE + TAG_SIZE ||
+        read_full(file_, raw, STREAM_HEADER_SIZE) != STREAM_HEADER_SIZE || !parse_stream_header(raw, header)) {
+        Logger::error("[Crypto] Not a PDCRYPT2 file: " + path);
+        return false;
+    }
+    header_.assign(raw, raw + STREAM_HEADER_SIZE);
+    file_key_ = stream_file_key(key, header);
+    if (file_key_.empty()) return false;
+    
+    // Every segment but the last is full, so sizes follow from the file size
+    segment_size_ = header.segment_size;
+    uint64_t sealed_size = segment_size_ + STREAM_SEGMENT_OVERHEAD;
+    uint64_t body = file_size - STREAM_HEADER_SIZE;
+    uint64_t full = body / sealed_size;
+    uint64_t rem = body % sealed_size;
+    if (rem != 0 && rem < TAG_SIZE) {
+        Logger::error("[Crypto] Truncated PDCRYPT2 file: " + path);
+        return false;
+    }
+    segment_count_ = full + (rem ? 1 : 0);
+    plaintext_size_ = full * segment_size_ + (rem ? rem - TAG_SIZE : 0);
+    
+    sealed_.resize(sealed_size);
+    plain_.resize(segment_size_);
+    return true;
+}
+
+bool EncryptedFileReader::load_segment(uint64_t index) {
+    if (index == cached_index_) return true;
+    
+    bool final = index + 1 == segment_count_;
+    uint64_t len = final ? plaintext_size_ - index * segment_size_ : segment_size_;
+    file_.clear();
+    file_.seekg(static_cast<std::streamoff>(STREAM_HEADER_SIZE + index * (segment_size_ + STREAM_SEGMENT_OVERHEAD)));
+    if (read_full(file_, sealed_.data(), len + TAG_SIZE) != len + TAG_SIZE) return false;
+    
+    StreamHeader header;
+    parse_stream_header(header_.data(), header);
+    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+    if (!ctx) return false;
+    bool ok = open_segment(ctx, file_key_, header, index, final, sealed_.data(), len, plain_.data());
+    EVP_CIPHER_CTX_free(ctx);
+    
+    if (!ok) {
+        Logger::error("[Crypto] Segment " + std::to_string(index) + " failed authentication");
+        cached_index_ = UINT64_MAX;
+        return false;
+    }
+    cached_index_ = index;
+    return true;
+}
+
+bool EncryptedFileReader::read(uint64_t offset, size_t length, std::vector<uint8_t>& out) {
+    out.clear();
+    if (!file_.is_open() || offset >= plaintext_size_) return file_.is_open();
+    
+    uint64_t end = std::min<uint64_t>(plaintext_size_, offset + length);
+    out.reserve(static_cast<size_t>(end - offset));
+    while (offset < end) {
+        uint64_t index = offset / segment_size_;
+        if (!load_segment(index)) {
+            out.clear();
+            return false;
+        }
+        uint64_t seg_start = index * segment_size_;
+        uint64_t from = offset - seg_start;
+        uint64_t to = std::min<uint64_t>(end - seg_start, segment_size_);
+        out.insert(out.end(), plain_.begin() + from, plain_.begin() + to);
+        offset = seg_start + to;
+    }
+    return true;
+}
+
+bool is_encrypted_file(const std::string& path) {
+    return encrypted_file_version(path) != 0;
+}
+
+bool encrypt_file(const std::string& path, const std::vector<uint8_t>& key) {
+    std::ifstream in_file(path, std::ios::binary);
+    if (!in_file) {
+        Logger::error("[Crypto] Failed to open file for encryption: " + path);
+        return false;
+    }
+    
+    // Stream into a temp file with the PDCRYPT2 header
     std::string temp_path = path + ".enc";
     std::ofstream out_file(temp_path, std::ios::binary);
     if (!out_file) {
@@ -230,9 +543,14 @@ bool encrypt_file(const std::string& path, const std::vector<uint8_t>& key) {
         return false;
     }
     
-    out_file.write(reinterpret_cast<const char*>(MAGIC), sizeof(MAGIC));
-    out_file.write(reinterpret_cast<const char*>(ciphertext.data()), ciphertext.size());
+    bool ok = encrypt_stream(in_file, out_file, key);
+    in_file.close();
     out_file.close();
+    if (!ok || !out_file) {
+        Logger::error("[Crypto] Encryption failed for file: " + path);
+        fs::remove(temp_path);
+        return false;
+    }
     
     // Replace original with encrypted version
     try {
@@ -247,43 +565,35 @@ bool encrypt_file(const std::string& path, const std::vector<uint8_t>& key) {
 }
 
 bool decrypt_file(const std::string& path, const std::vector<uint8_t>& key) {
-    if (!is_encrypted_file(path)) {
+    int version = encrypted_file_version(path);
+    if (version == 0) {
         Logger::debug("[Crypto] File is not encrypted: " + path);
         return true;  // Not an error, just not encrypted
     }
     
-    // Read entire file
-    std::ifstream in_file(path, std::ios::binary | std::ios::ate);
-    if (!in_file) {
-        Logger::error("[Crypto] Failed to open file for decryption: " + path);
-        return false;
-    }
-    
-    size_t file_size = in_file.tellg();
-    in_file.seekg(sizeof(MAGIC));  // Skip magic header
-    
-    std::vector<uint8_t> ciphertext(file_size - sizeof(MAGIC));
-    in_file.read(reinterpret_cast<char*>(ciphertext.data()), ciphertext.size());
-    in_file.close();
-    
-    // Decrypt
-    std::vector<uint8_t> plaintext = decrypt(ciphertext, key);
-    if (plaintext.empty()) {
-        Logger::error("[Crypto] Decryption failed for file: " + path);
-        return false;
-    }
-    
-    // Write decrypted file
     std::string temp_path = path + ".dec";
-    std::ofstream out_file(temp_path, std::ios::binary);
-    if (!out_file) {
-        Logger::error("[Crypto] Failed to create decrypted file: " + temp_path);
+    bool ok;
+    if (version == 1) {
+        ok = decrypt_file_v1(path, temp_path, key);
+    } else {
+        std::ifstream in_file(path, std::ios::binary);
+        std::ofstream out_file(temp_path, std::ios::binary);
+        if (!in_file || !out_file) {
+            Logger::error("[Crypto] Failed to open file for decryption: " + path);
+            ok = false;
+        } else {
+            ok = decrypt_stream(in_file, out_file, key);
+            out_file.close();
+            ok = ok && static_cast<bool>(out_file);
+        }
+        if (!ok) Logger::error("[Crypto] Decryption failed for file: " + path);
+    }
+    if (!ok) {
+        std::error_code ec;
+        fs::remove(temp_path, ec);
         return false;
     }
     
-    out_file.write(reinterpret_cast<const char*>(plaintext.data()), plaintext.size());
-    out_file.close();
-    
     // Replace encrypted with decrypted version
     try {
         fs::rename(temp_path, path);
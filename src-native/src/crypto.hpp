@@ -7,6 +7,8 @@
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <fstream>
+#include <iosfwd>
 
 namespace crypto {
 
@@ -31,16 +33,16 @@ std::vector<uint8_t> encrypt(const std::vector<uint8_t>& plaintext,
 std::vector<uint8_t> decrypt(const std::vector<uint8_t>& ciphertext,
                               const std::vector<uint8_t>& key);
 
-// Encrypt a file in-place
+// Encrypt a file in-place (PDCRYPT2, streamed in constant memory)
 // Creates: original_path + encrypted content
 // Deletes: original file after successful encryption
 bool encrypt_file(const std::string& path, const std::vector<uint8_t>& key);
 
 // Decrypt a file in-place
-// Replaces encrypted content with plaintext
+// Replaces encrypted content with plaintext; reads PDCRYPT1 and PDCRYPT2
 bool decrypt_file(const std::string& path, const std::vector<uint8_t>& key);
 
-// Check if a file appears to be encrypted (has our magic header)
+// Check if a file appears to be encrypted (has either magic header)
 bool is_encrypted_file(const std::string& path);
 
 // Hash a device ID to create a machine-specific key component
@@ -62,6 +64,56 @@ constexpr size_t TAG_SIZE = 16;
 constexpr size_t SALT_SIZE = 16;
 constexpr size_t KEY_SIZE = 32;  // 256 bits
 
+// ---- PDCRYPT2: chunked streaming format ----
+//
+// header:  MAGIC_V2(8) | segment size (u32 BE) | salt(16) | nonce prefix(7)
+// body:    segment 0 | segment 1 | ... | final segment
+// segment: ciphertext (segment size bytes; final may be shorter, even 0) | tag(16)
+//
+// Each file gets its own key, HMAC-SHA256(key, MAGIC_V2 || salt). Segment i
+// is sealed under nonce = prefix || i (u32 BE) || final flag, with the header
+// as AAD, so segments can't be reordered, dropped or truncated and any one
+// can be opened without reading the others.
+constexpr uint8_t MAGIC_V2[8] = {'P', 'D', 'C', 'R', 'Y', 'P', 'T', '2'};
+constexpr size_t STREAM_SEGMENT_SIZE = 64 * 1024;
+constexpr size_t STREAM_NONCE_PREFIX_SIZE = 7;
+constexpr size_t STREAM_HEADER_SIZE = sizeof(MAGIC_V2) + 4 + SALT_SIZE + STREAM_NONCE_PREFIX_SIZE;
+
+// Encrypt `in` to `out` as PDCRYPT2, one segment buffer at a time
+bool encrypt_stream(std::istream& in, std::ostream& out, const std::vector<uint8_t>& key,
+                    size_t segment_size = STREAM_SEGMENT_SIZE);
+
+// Decrypt a PDCRYPT2 stream (including its header) to `out`
+bool decrypt_stream(std::istream& in, std::ostream& out, const std::vector<uint8_t>& key);
+
+// Random-access reader for PDCRYPT2 files: decrypts only the segments that
+// cover the requested range, keeping the most recent one cached
+class EncryptedFileReader {
+public:
+    EncryptedFileReader() = default;
+    
+    bool open(const std::string& path, const std::vector<uint8_t>& key);
+    
+    // Plaintext size, known from the file size without decrypting anything
+    uint64_t size() const { return plaintext_size_; }
+    
+    // Decrypt [offset, offset + length) into out (clamped to size())
+    bool read(uint64_t offset, size_t length, std::vector<uint8_t>& out);
+    
+private:
+    bool load_segment(uint64_t index);
+    
+    std::ifstream file_;
+    std::vector<uint8_t> file_key_;
+    std::vector<uint8_t> header_;
+    std::vector<uint8_t> sealed_;     // ciphertext + tag of one segment
+    std::vector<uint8_t> plain_;      // plaintext of cached_index_
+    uint64_t segment_size_ = 0;
+    uint64_t segment_count_ = 0;
+    uint64_t plaintext_size_ = 0;
+    uint64_t cached_index_ = UINT64_MAX;
+};
+
 } // namespace crypto
 
 #endif // CRYPTO_HPP
@@ -0,0 +1,240 @@
+/**
+ * Proton Drive Linux - headless sync daemon
+ *
+ * proton-drive-daemon runs the sync engine without GTK or a display: file
+ * watchers, the sync scheduler, cloud change monitoring, the file index
+ * (and the files-on-demand mount when enabled). It is controlled over
+ * D-Bus (daemon_service.hpp), where it also publishes its status; a GUI
+ * started alongside it leaves all of the above to the daemon and becomes
+ * a client.
+ */
+
+#include "logger.hpp"
+#include "task_pool.hpp"
+#include "file_index.hpp"
+#include "sync_job_metadata.hpp"
+#include "sync_manager.hpp"
+#include "cloud_monitor.hpp"
+#include "daemon_service.hpp"
+#include "status_service.hpp"
+#include "settings.hpp"
+#include "rclone_rc.hpp"
+#include "cloud_mount.hpp"
+#include "app_window_helpers.hpp"
+#include "trace.hpp"
+#include <gio/gio.h>
+#include <glib-unix.h>
+#include <iostream>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+static GMainLoop* global_loop = nullptr;
+
+static gboolean quit_handler(gpointer /*user_data*/) {
+    Logger::info("[Shutdown] Signal received - stopping daemon...");
+    if (global_loop) g_main_loop_quit(global_loop);
+    return G_SOURCE_REMOVE;
+}
+
+/**
+ * Fatal signals: resume frozen syncs, then die with the default action
+ */
+static void crash_handler(int sig) {
+    SyncManager::resume_frozen_for_crash();
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+/**
+ * One daemon per user, also where there is no session bus to arbitrate.
+ * Separate from the GUI's lock: the two are meant to run side by side.
+ */
+static bool ensure_single_daemon() {
+    const char* xdg_runtime = std::getenv("XDG_RUNTIME_DIR");
+    std::string lock_file = xdg_runtime ? std::string(xdg_runtime) + "/proton-drive-daemon.lock"
+                                        : "/tmp/proton-drive-daemon-" + std::to_string(getuid()) + ".lock";
+    int lock_fd = open(lock_file.c_str(), O_CREAT | O_RDWR | O_CLOEXEC, 0600);
+    if (lock_fd < 0) {
+        Logger::error("[SingleInstance] Failed to create lock file: " + lock_file);
+        return true;  // Fail open - allow to run
+    }
+    if (flock(lock_fd, LOCK_EX | LOCK_NB) < 0) {
+        close(lock_fd);
+        std::cerr << "proton-drive-daemon is already running\n";
+        return false;
+    }
+    if (ftruncate(lock_fd, 0) == 0) {
+        std::string pid = std::to_string(getpid());
+        if (write(lock_fd, pid.c_str(), pid.length()) < 0) {
+            Logger::error("[SingleInstance] Failed to write PID to lock file");
+        }
+    }
+    // Kept open (and locked) for the lifetime of the process
+    return true;
+}
+
+/**
+ * Open the index and bring it up to date, as the GUI does after first paint
+ */
+static void init_file_index() {
+    auto& file_index = FileIndex::getInstance();
+    if (!file_index.initialize()) {
+        Logger::warn("[Init] Failed to initialize file index - search may be limited");
+        return;
+    }
+    Logger::info("[Init] File index initialized");
+
+    auto stats = file_index.get_stats();
+    if (stats.total_files == 0 && stats.total_folders == 0) {
+        Logger::info("[Init] File index is empty, starting initial index...");
+        file_index.start_background_index(true);  // Full index
+    } else if (file_index.needs_refresh(2)) {
+        Logger::info("[Init] File index is stale (>2 hours), starting background refresh...");
+        file_index.start_background_index(false);  // Incremental update
+    }
+
+    // Periodic incremental refresh every 2 hours
+    g_timeout_add_seconds(7200, +[](gpointer) -> gboolean {
+        auto& index = FileIndex::getInstance();
+        if (!index.is_indexing()) {
+            Logger::info("[Index] Scheduled 2-hour refresh starting...");
+            index.start_background_index(false);
+        }
+        return G_SOURCE_CONTINUE;
+    }, nullptr);
+}
+
+int main(int argc, char* argv[]) {
+    bool debug_mode = false;
+    std::string trace_file;
+    for (int i = 1; i < argc; i++) {
+        std::string arg(argv[i]);
+        if (arg == "--debug") {
+            debug_mode = true;
+        } else if (arg.rfind("--trace=", 0) == 0) {
+            trace_file = arg.substr(8);
+        } else if (arg == "--help" || arg == "-h") {
+            std::cout << "Proton Drive Linux - headless sync daemon\n\n"
+                      << "Usage: proton-drive-daemon [options]\n\n"
+                      << "Options:\n"
+                      << "  --debug         Enable debug logging\n"
+                      << "  --trace=FILE    Record timing spans; written to FILE (Chrome trace JSON) on exit\n"
+                      << "  --help          Show this help message\n\n"
+                      << "Controlled over D-Bus: " << proton::DAEMON_BUS_NAME << " "
+                      << proton::DAEMON_OBJECT_PATH << "\n";
+            return 0;
+        } else {
+            std::cerr << "Unknown option: " << arg << "\n";
+            return 2;
+        }
+    }
+
+    if (!ensure_single_daemon()) {
+        return 1;
+    }
+    // A window started without the daemon runs the engine itself
+    if (!proton::acquire_engine_lock()) {
+        std::cerr << "The Proton Drive window is running the sync engine; quit it first\n";
+        return 1;
+    }
+
+    const char* home = std::getenv("HOME");
+    std::string log_dir = home ? std::string(home) + "/.cache/proton-drive" : "/tmp";
+    std::error_code ec;
+    std::filesystem::create_directories(log_dir, ec);
+    Logger::init(debug_mode ? LogLevel::DEBUG : LogLevel::INFO, log_dir + "/proton-drive-daemon.log");
+    Logger::start_async();
+    Logger::info("Proton Drive Linux - Starting (daemon)...");
+    if (!trace_file.empty()) proton::Trace::set_enabled(true);
+
+    gchar* rclone = g_find_program_in_path(AppWindowHelpers::get_rclone_path().c_str());
+    if (!rclone) {
+        Logger::error("[Dependency] CRITICAL: rclone not found in PATH");
+        std::cerr << "MISSING: rclone - Required for cloud sync operations\n";
+        Logger::shutdown();
+        return 1;
+    }
+    g_free(rclone);
+
+    auto& settings = proton::SettingsManager::getInstance();
+    settings.load();
+    Logger::set_tag_levels(settings.get_log_tag_levels());
+
+    if (proton::RcloneRC::getInstance().start(AppWindowHelpers::get_rclone_path())) {
+        Logger::info("[Init] rclone RC daemon starting");
+    } else {
+        Logger::warn("[Init] rclone RC daemon unavailable - using per-command rclone");
+    }
+
+    global_loop = g_main_loop_new(nullptr, FALSE);
+    for (int sig : {SIGSEGV, SIGABRT, SIGFPE, SIGBUS, SIGILL}) {
+        signal(sig, crash_handler);
+    }
+    g_unix_signal_add(SIGTERM, quit_handler, nullptr);
+    g_unix_signal_add(SIGINT, quit_handler, nullptr);
+
+    // Claim the bus name; if another process holds it the loop quits as soon as it runs
+    auto& service = proton::DaemonService::getInstance();
+    service.start([]() { quit_handler(nullptr); });
+
+    init_file_index();
+
+    if (settings.get_mount_enabled()) {
+        proton::CloudMount::getInstance().start(settings.get_mount_point(), settings.get_mount_cache_size());
+    }
+
+    if (!SyncJobRegistry::ensureDefaultSyncLocation()) {
+        Logger::warn("[Init] Could not create default ProtonDrive folder");
+    }
+
+    // Engine events become D-Bus signals
+    SyncManager::Observer observer;
+    observer.log = [&service](const std::string& line) { service.emit_log(line); };
+    observer.jobs_changed = [&service]() { service.emit_jobs_changed(); };
+    observer.remote_changed = [&service]() { service.emit_remote_changed(); };
+    auto& sync = SyncManager::getInstance();
+    sync.set_observer(std::move(observer));
+    sync.init();
+
+    proton::CloudMonitor::Events events;
+    events.log = [&service](const std::string& line) { service.emit_log(line); };
+    events.batch_finished = [&service]() { service.emit_remote_changed(); };
+    auto& monitor = proton::CloudMonitor::getInstance();
+    monitor.set_events(std::move(events));
+    monitor.start();
+
+    // Status properties (and metrics) follow the engine from here on
+    auto& status = proton::StatusService::getInstance();
+    status.start();
+    int metrics_port = settings.get_metrics_port();
+    if (metrics_port > 0 && metrics_port < 65536) {
+        status.start_metrics(static_cast<uint16_t>(metrics_port));
+    }
+
+    Logger::info("[Init] Daemon running");
+    g_main_loop_run(global_loop);
+
+    // Shutdown mirrors the GUI's order
+    Logger::info("[Shutdown] Main loop finished, cleaning up...");
+    service.stop();
+    status.stop();
+    monitor.stop();
+    sync.shutdown();
+    proton::CloudMount::getInstance().stop();
+    proton::TaskPool::getInstance().shutdown();
+    FileIndex::getInstance().shutdown();
+    proton::RcloneRC::getInstance().stop();
+    g_main_loop_unref(global_loop);
+    global_loop = nullptr;
+
+    if (!trace_file.empty()) proton::Trace::export_chrome_json(trace_file);
+
+    Logger::info("Proton Drive Linux daemon - Exiting.");
+    Logger::shutdown();
+    return 0;
+}
@@ -0,0 +1,446 @@
+// daemon_service.cpp - D-Bus control interface of proton-drive-daemon
+
+#include "daemon_service.hpp"
+#include "status_service.hpp"
+#include "sync_manager.hpp"
+#include "sync_job_metadata.hpp"
+#include "sync_scheduler.hpp"
+#include "task_pool.hpp"
+#include "logger.hpp"
+#include <cstdlib>
+#include <mutex>
+#include <vector>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+namespace proton {
+
+// D-Bus interface XML for the daemon object
+static const char* DAEMON_INTROSPECTION_XML = R"XML(
+<node>
+  <interface name="me.proton.drive.Daemon1">
+    <method name="SyncNow">
+      <arg type="s" name="job_id" direction="in"/>
+    </method>
+    <method name="SyncAll"/>
+    <method name="Pause"/>
+    <method name="Resume"/>
+    <method name="ListJobs">
+      <arg type="a(ssss)" name="jobs" direction="out"/>
+    </method>
+    <method name="GetStatus">
+      <arg type="a{sv}" name="status" direction="out"/>
+    </method>
+    <signal name="Log">
+      <arg type="s" name="line"/>
+    </signal>
+    <signal name="JobsChanged"/>
+    <signal name="RemoteChanged"/>
+    <property name="SchedulerActive" type="b" access="read"/>
+    <property name="Online" type="b" access="read"/>
+    <property name="Jobs" type="u" access="read"/>
+    <property name="RunningSyncs" type="u" access="read"/>
+    <property name="QueuedTransfers" type="u" access="read"/>
+    <property name="TransferRate" type="t" access="read"/>
+    <property name="BytesTransferred" type="t" access="read"/>
+    <property name="BytesTotal" type="t" access="read"/>
+    <property name="Errors" type="u" access="read"/>
+    <property name="LastError" type="s" access="read"/>
+    <property name="Indexing" type="b" access="read"/>
+    <property name="IndexProgress" type="u" access="read"/>
+    <property name="IndexedFiles" type="t" access="read"/>
+    <property name="IndexedFolders" type="t" access="read"/>
+    <property name="LastIndexed" type="s" access="read"/>
+  </interface>
+</node>
+)XML";
+
+DaemonService& DaemonService::getInstance() {
+    static DaemonService instance;
+    return instance;
+}
+
+bool DaemonService::start(std::function<void()> name_lost_handler) {
+    if (owner_id_ > 0) return true;
+
+    GError* error = nullptr;
+    node_info_ = g_dbus_node_info_new_for_xml(DAEMON_INTROSPECTION_XML, &error);
+    if (error) {
+        Logger::error("[Daemon] Failed to parse introspection: " + std::string(error->message));
+        g_error_free(error);
+        return false;
+    }
+
+    on_name_lost_ = std::move(name_lost_handler);
+    auto& status = StatusService::getInstance();
+    published_ = status.current();
+    status_listener_id_ = status.add_listener([this](const SyncStatus& current) {
+        emit_properties_changed(current);
+    });
+    owner_id_ = g_bus_own_name(G_BUS_TYPE_SESSION, DAEMON_BUS_NAME,
+        G_BUS_NAME_OWNER_FLAGS_DO_NOT_QUEUE,
+        on_bus_acquired, on_name_acquired, on_name_lost,
+        this, nullptr);
+    return true;
+}
+
+void DaemonService::stop() {
+    if (status_listener_id_ > 0) {
+        StatusService::getInstance().remove_listener(status_listener_id_);
+        status_listener_id_ = 0;
+    }
+    if (connection_ && registration_id_ > 0) {
+        g_dbus_connection_unregister_object(connection_, registration_id_);
+    }
+    registration_id_ = 0;
+    connection_ = nullptr;
+    if (owner_id_ > 0) {
+        g_bus_unown_name(owner_id_);
+        owner_id_ = 0;
+    }
+    if (node_info_) {
+        g_dbus_node_info_unref(node_info_);
+        node_info_ = nullptr;
+    }
+}
+
+void DaemonService::on_bus_acquired(GDBusConnection* connection, const gchar* /*name*/, gpointer user_data) {
+    auto* self = static_cast<DaemonService*>(user_data);
+    self->connection_ = connection;
+
+    static const GDBusInterfaceVTable vtable = {
+        DaemonService::handle_method_call,
+        DaemonService::handle_get_property,
+        nullptr,
+        {nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr}  // padding
+    };
+
+    GError* error = nullptr;
+    self->registration_id_ = g_dbus_connection_register_object(
+        connection, DAEMON_OBJECT_PATH,
+        self->node_info_->interfaces[0],
+        &vtable, self, nullptr, &error);
+    if (error) {
+        Logger::error("[Daemon] Failed to register object: " + std::string(error->message));
+        g_error_free(error);
+    }
+}
+
+void DaemonService::on_name_acquired(GDBusConnection* /*connection*/, const gchar* name, gpointer /*user_data*/) {
+    Logger::info("[Daemon] Acquired bus name " + std::string(name));
+}
+
+void DaemonService::on_name_lost(GDBusConnection* connection, const gchar* name, gpointer user_data) {
+    auto* self = static_cast<DaemonService*>(user_data);
+    if (!connection) {
+        // Servers without a session bus still sync; they just cannot be controlled
+        Logger::warn("[Daemon] No session bus - running without the control interface");
+        return;
+    }
+    Logger::error("[Daemon] Bus name " + std::string(name) + " is owned by another process");
+    if (self->on_name_lost_) self->on_name_lost_();
+}
+
+void DaemonService::handle_method_call(GDBusConnection* /*connection*/, const gchar* /*sender*/,
+                                       const gchar* /*object_path*/, const gchar* /*interface_name*/,
+                                       const gchar* method_name, GVariant* parameters,
+                                       GDBusMethodInvocation* invocation, gpointer /*user_data*/) {
+    std::string method = method_name;
+    Logger::debug("[Daemon] Method called: " + method);
+    auto& sync = SyncManager::getInstance();
+
+    if (method == "SyncNow") {
+        const gchar* job_id = nullptr;
+        g_variant_get(parameters, "(&s)", &job_id);
+        if (!SyncJobRegistry::getInstance().getJobById(job_id)) {
+            g_dbus_method_invocation_return_error(invocation, G_DBUS_ERROR,
+                G_DBUS_ERROR_INVALID_ARGS, "Unknown sync job: %s", job_id);
+            return;
+        }
+        sync.sync_job_now(job_id, "requested over D-Bus");
+        g_dbus_method_invocation_return_value(invocation, nullptr);
+    } else if (method == "SyncAll") {
+        auto jobs = SyncJobRegistry::getInstance().snapshot();
+        for (const auto& job : jobs->jobs) {
+            sync.sync_job_now(job.job_id, "requested over D-Bus");
+        }
+        g_dbus_method_invocation_return_value(invocation, nullptr);
+    } else if (method == "Pause") {
+        SyncScheduler::getInstance().pause();
+        StatusService::getInstance().refresh();
+        g_dbus_method_invocation_return_value(invocation, nullptr);
+    } else if (method == "Resume") {
+        SyncScheduler::getInstance().resume();
+        StatusService::getInstance().refresh();
+        g_dbus_method_invocation_return_value(invocation, nullptr);
+    } else if (method == "ListJobs") {
+        GVariantBuilder builder;
+        g_variant_builder_init(&builder, G_VARIANT_TYPE("a(ssss)"));
+        auto jobs = SyncJobRegistry::getInstance().snapshot();
+        for (const auto& job : jobs->jobs) {
+            g_variant_builder_add(&builder, "(ssss)", job.job_id.c_str(), job.local_path.c_str(),
+                                  job.remote_path.c_str(), job.sync_type.c_str());
+        }
+        g_dbus_method_invocation_return_value(invocation, g_variant_new("(a(ssss))", &builder));
+    } else if (method == "GetStatus") {
+        // Same values as the properties, in one round trip
+        SyncStatus status = StatusService::getInstance().current();
+        GVariantBuilder builder;
+        g_variant_builder_init(&builder, G_VARIANT_TYPE("a{sv}"));
+        for (const char* const* name = STATUS_PROPERTY_NAMES; *name; ++name) {
+            g_variant_builder_add(&builder, "{sv}", *name, status_property(status, *name));
+        }
+        g_dbus_method_invocation_return_value(invocation, g_variant_new("(a{sv})", &builder));
+    } else {
+        g_dbus_method_invocation_return_error(invocation, G_DBUS_ERROR,
+            G_DBUS_ERROR_UNKNOWN_METHOD, "Unknown method: %s", method_name);
+    }
+}
+
+GVariant* DaemonService::handle_get_property(GDBusConnection* /*connection*/, const gchar* /*sender*/,
+                                              const gchar* /*object_path*/, const gchar* /*interface_name*/,
+                                              const gchar* property_name, GError** error,
+                                              gpointer /*user_data*/) {
+    GVariant* value = status_property(StatusService::getInstance().current(), property_name);
+    if (!value) {
+        g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_PROPERTY,
+                    "Unknown property: %s", property_name);
+    }
+    return value;
+}
+
+void DaemonService::emit_properties_changed(const SyncStatus& status) {
+    // Only the properties that differ from what was last announced
+    GVariantBuilder changed;
+    g_variant_builder_init(&changed, G_VARIANT_TYPE("a{sv}"));
+    bool any = false;
+    for (const char* const* name = STATUS_PROPERTY_NAMES; *name; ++name) {
+        GVariant* before = g_variant_ref_sink(status_property(published_, *name));
+        GVariant* after = g_variant_ref_sink(status_property(status, *name));
+        if (!g_variant_equal(before, after)) {
+            g_variant_builder_add(&changed, "{sv}", *name, after);
+            any = true;
+        }
+        g_variant_unref(before);
+        g_variant_unref(after);
+    }
+    published_ = status;
+    if (!any || !connection_) {
+        g_variant_builder_clear(&changed);
+        return;
+    }
+
+    GError* error = nullptr;
+    g_dbus_connection_emit_signal(connection_, nullptr, DAEMON_OBJECT_PATH,
+        "org.freedesktop.DBus.Properties", "PropertiesChanged",
+        g_variant_new("(sa{sv}as)", DAEMON_INTERFACE, &changed, nullptr), &error);
+    if (error) {
+        Logger::debug("[Daemon] Failed to emit PropertiesChanged: " + std::string(error->message));
+        g_error_free(error);
+    }
+}
+
+void DaemonService::emit(const char* signal, GVariant* params) {
+    // Keep the floating reference alive until the main loop sends it
+    if (params) g_variant_ref_sink(params);
+    TaskPool::post_to_main([this, signal, params]() {
+        if (connection_) {
+            GError* error = nullptr;
+            g_dbus_connection_emit_signal(connection_, nullptr, DAEMON_OBJECT_PATH,
+                DAEMON_INTERFACE, signal, params, &error);
+            if (error) {
+                Logger::debug("[Daemon] Failed to emit " + std::string(signal) + ": " + error->message);
+                g_error_free(error);
+            }
+        }
+        if (params) g_variant_unref(params);
+    });
+}
+
+void DaemonService::emit_log(const std::string& line) {
+    emit("Log", g_variant_new("(s)", line.c_str()));
+}
+
+void DaemonService::emit_jobs_changed() {
+    emit("JobsChanged", nullptr);
+}
+
+void DaemonService::emit_remote_changed() {
+    emit("RemoteChanged", nullptr);
+}
+
+bool acquire_engine_lock() {
+    static int lock_fd = -1;
+    if (lock_fd >= 0) return true;
+
+    const char* runtime_dir = std::getenv("XDG_RUNTIME_DIR");
+    std::string path = runtime_dir ? std::string(runtime_dir) + "/proton-drive-engine.lock"
+                                   : "/tmp/proton-drive-engine-" + std::to_string(getuid()) + ".lock";
+    int fd = open(path.c_str(), O_CREAT | O_RDWR | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        Logger::warn("[Daemon] Cannot open engine lock " + path + " - running the engine unguarded");
+        return true;  // Fail open, like the single-instance locks
+    }
+    if (flock(fd, LOCK_EX | LOCK_NB) < 0) {
+        close(fd);
+        return false;
+    }
+    // Released by the kernel when this process exits, however it exits
+    lock_fd = fd;
+    return true;
+}
+
+// ============================================================================
+// Client side
+// ============================================================================
+
+namespace {
+
+std::mutex g_client_mutex;
+GDBusConnection* g_client_connection = nullptr;
+std::vector<guint> g_subscriptions;
+guint g_watch_id = 0;
+DaemonClient::Handlers g_handlers;
+SyncStatus g_remote_status;     // Daemon's properties as last seen
+
+GDBusConnection* client_connection() {
+    std::lock_guard<std::mutex> lock(g_client_mutex);
+    if (!g_client_connection) {
+        GError* error = nullptr;
+        g_client_connection = g_bus_get_sync(G_BUS_TYPE_SESSION, nullptr, &error);
+        if (error) {
+            Logger::debug("[Daemon] No session bus: " + std::string(error->message));
+            g_error_free(error);
+        }
+    }
+    return g_client_connection;
+}
+
+void on_daemon_signal(GDBusConnection* /*connection*/, const gchar* /*sender*/,
+                      const gchar* /*object_path*/, const gchar* /*interface_name*/,
+                      const gchar* signal_name, GVariant* parameters, gpointer /*user_data*/) {
+    std::string signal = signal_name;
+    if (signal == "Log" && g_handlers.log) {
+        const gchar* line = nullptr;
+        g_variant_get(parameters, "(&s)", &line);
+        g_handlers.log(line);
+    } else if (signal == "JobsChanged" && g_handlers.jobs_changed) {
+        g_handlers.jobs_changed();
+    } else if (signal == "RemoteChanged" && g_handlers.remote_changed) {
+        g_handlers.remote_changed();
+    }
+}
+
+// Merge an a{sv} of properties and hand the full status on
+void apply_remote_properties(GVariant* properties) {
+    GVariantIter iter;
+    const gchar* name = nullptr;
+    GVariant* value = nullptr;
+    g_variant_iter_init(&iter, properties);
+    while (g_variant_iter_next(&iter, "{&sv}", &name, &value)) {
+        apply_status_property(g_remote_status, name, value);
+        g_variant_unref(value);
+    }
+    if (g_handlers.status) g_handlers.status(g_remote_status);
+}
+
+void on_daemon_properties_changed(GDBusConnection* /*connection*/, const gchar* /*sender*/,
+                                  const gchar* /*object_path*/, const gchar* /*interface_name*/,
+                                  const gchar* /*signal_name*/, GVariant* parameters, gpointer /*user_data*/) {
+    GVariant* changed = g_variant_get_child_value(parameters, 1);
+    apply_remote_properties(changed);
+    g_variant_unref(changed);
+}
+
+void on_get_all_finished(GObject* source, GAsyncResult* result, gpointer /*user_data*/) {
+    GError* error = nullptr;
+    GVariant* reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), result, &error);
+    if (!reply) {
+        Logger::debug("[Daemon] GetAll failed: " + std::string(error ? error->message : "unknown"));
+        if (error) g_error_free(error);
+        return;
+    }
+    GVariant* properties = g_variant_get_child_value(reply, 0);
+    apply_remote_properties(properties);
+    g_variant_unref(properties);
+    g_variant_unref(reply);
+}
+
+void on_daemon_vanished(GDBusConnection* /*connection*/, const gchar* /*name*/, gpointer /*user_data*/) {
+    Logger::warn("[Daemon] proton-drive-daemon left the session bus");
+    if (g_handlers.vanished) g_handlers.vanished();
+}
+
+} // namespace
+
+bool DaemonClient::is_running() {
+    GDBusConnection* connection = client_connection();
+    if (!connection) return false;
+
+    GError* error = nullptr;
+    GVariant* result = g_dbus_connection_call_sync(connection,
+        "org.freedesktop.DBus", "/org/freedesktop/DBus", "org.freedesktop.DBus",
+        "NameHasOwner", g_variant_new("(s)", DAEMON_BUS_NAME),
+        G_VARIANT_TYPE("(b)"), G_DBUS_CALL_FLAGS_NONE, 500, nullptr, &error);
+    if (!result) {
+        Logger::debug("[Daemon] NameHasOwner failed: " + std::string(error ? error->message : "unknown"));
+        if (error) g_error_free(error);
+        return false;
+    }
+    gboolean owned = FALSE;
+    g_variant_get(result, "(b)", &owned);
+    g_variant_unref(result);
+    return owned;
+}
+
+void DaemonClient::call(const char* method, GVariant* params) {
+    GDBusConnection* connection = client_connection();
+    if (!connection) {
+        if (params) g_variant_unref(g_variant_ref_sink(params));
+        return;
+    }
+    g_dbus_connection_call(connection, DAEMON_BUS_NAME, DAEMON_OBJECT_PATH, DAEMON_INTERFACE,
+        method, params, nullptr, G_DBUS_CALL_FLAGS_NONE, -1, nullptr, nullptr, nullptr);
+}
+
+void DaemonClient::subscribe(Handlers handlers) {
+    GDBusConnection* connection = client_connection();
+    if (!connection) return;
+    unsubscribe();
+    g_handlers = std::move(handlers);
+    for (const char* signal : {"Log", "JobsChanged", "RemoteChanged"}) {
+        g_subscriptions.push_back(g_dbus_connection_signal_subscribe(connection,
+            DAEMON_BUS_NAME, DAEMON_INTERFACE, signal, DAEMON_OBJECT_PATH, nullptr,
+            G_DBUS_SIGNAL_FLAGS_NONE, on_daemon_signal, nullptr, nullptr));
+    }
+
+    // Status: the current values once, then only what changes
+    g_subscriptions.push_back(g_dbus_connection_signal_subscribe(connection,
+        DAEMON_BUS_NAME, "org.freedesktop.DBus.Properties", "PropertiesChanged",
+        DAEMON_OBJECT_PATH, DAEMON_INTERFACE, G_DBUS_SIGNAL_FLAGS_NONE,
+        on_daemon_properties_changed, nullptr, nullptr));
+    g_dbus_connection_call(connection, DAEMON_BUS_NAME, DAEMON_OBJECT_PATH,
+        "org.freedesktop.DBus.Properties", "GetAll", g_variant_new("(s)", DAEMON_INTERFACE),
+        G_VARIANT_TYPE("(a{sv})"), G_DBUS_CALL_FLAGS_NONE, -1, nullptr, on_get_all_finished, nullptr);
+
+    // Also reports a name that is already gone by now
+    g_watch_id = g_bus_watch_name_on_connection(connection, DAEMON_BUS_NAME, G_BUS_NAME_WATCHER_FLAGS_NONE,
+                                                nullptr, on_daemon_vanished, nullptr, nullptr);
+}
+
+void DaemonClient::unsubscribe() {
+    if (g_client_connection) {
+        for (guint id : g_subscriptions) {
+            g_dbus_connection_signal_unsubscribe(g_client_connection, id);
+        }
+    }
+    g_subscriptions.clear();
+    if (g_watch_id > 0) {
+        g_bus_unwatch_name(g_watch_id);
+        g_watch_id = 0;
+    }
+    g_handlers = Handlers();
+}
+
+} // namespace proton
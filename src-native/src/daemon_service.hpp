@@ -0,0 +1,99 @@
+// daemon_service.hpp - D-Bus control interface of proton-drive-daemon
+// The headless daemon owns me.proton.drive.Daemon on the session bus and
+// exports one object with methods to start and pause syncs, signals that
+// mirror what the window's log and job list show, and the StatusService
+// fields as read-only properties announced with PropertiesChanged. When the GUI finds that
+// name owned at startup it leaves the sync engine, cloud monitor, index
+// refresh and mount to the daemon and acts as a client of this interface,
+// taking the engine back if the name vanishes. The engine lock keeps the
+// two from ever running the engine at the same time.
+
+#ifndef DAEMON_SERVICE_HPP
+#define DAEMON_SERVICE_HPP
+
+#include "status_service.hpp"
+#include <gio/gio.h>
+#include <functional>
+#include <string>
+
+namespace proton {
+
+constexpr const char* DAEMON_BUS_NAME = "me.proton.drive.Daemon";
+constexpr const char* DAEMON_OBJECT_PATH = "/me/proton/drive/Daemon";
+constexpr const char* DAEMON_INTERFACE = "me.proton.drive.Daemon1";
+
+// Exclusive lock held by whichever process runs the sync engine, the
+// daemon or a GUI without one. Non-blocking; true once this process holds
+// it (kept until exit). The daemon refuses to start without it.
+bool acquire_engine_lock();
+
+// Server side, run by proton-drive-daemon
+class DaemonService {
+public:
+    static DaemonService& getInstance();
+
+    // Export the object and request the name. `name_lost_handler` runs on the
+    // main loop if another process owns the name; without a session bus
+    // the daemon keeps running with no control interface.
+    bool start(std::function<void()> name_lost_handler);
+    void stop();
+
+    // Signals; safe from any thread
+    void emit_log(const std::string& line);
+    void emit_jobs_changed();
+    void emit_remote_changed();
+
+private:
+    DaemonService() = default;
+    ~DaemonService() = default;
+    DaemonService(const DaemonService&) = delete;
+    DaemonService& operator=(const DaemonService&) = delete;
+
+    void emit(const char* signal, GVariant* params);
+    void emit_properties_changed(const SyncStatus& status);
+
+    static void on_bus_acquired(GDBusConnection* connection, const gchar* name, gpointer user_data);
+    static void on_name_acquired(GDBusConnection* connection, const gchar* name, gpointer user_data);
+    static void on_name_lost(GDBusConnection* connection, const gchar* name, gpointer user_data);
+    static void handle_method_call(GDBusConnection* connection, const gchar* sender,
+                                   const gchar* object_path, const gchar* interface_name,
+                                   const gchar* method_name, GVariant* parameters,
+                                   GDBusMethodInvocation* invocation, gpointer user_data);
+    static GVariant* handle_get_property(GDBusConnection* connection, const gchar* sender,
+                                         const gchar* object_path, const gchar* interface_name,
+                                         const gchar* property_name, GError** error,
+                                         gpointer user_data);
+
+    GDBusConnection* connection_ = nullptr;
+    GDBusNodeInfo* node_info_ = nullptr;
+    guint owner_id_ = 0;
+    guint registration_id_ = 0;
+    std::function<void()> on_name_lost_;
+    int status_listener_id_ = 0;
+    SyncStatus published_;      // Last values announced in PropertiesChanged
+};
+
+// Client side, used by the GUI
+class DaemonClient {
+public:
+    // Whether proton-drive-daemon currently owns its name (blocking, short timeout)
+    static bool is_running();
+
+    // Fire-and-forget method call, e.g. call("Pause")
+    static void call(const char* method, GVariant* params = nullptr);
+
+    struct Handlers {
+        std::function<void(const std::string& line)> log;
+        std::function<void()> jobs_changed;
+        std::function<void()> remote_changed;
+        std::function<void(const SyncStatus& status)> status;  // All properties, on any change
+        std::function<void()> vanished;  // The daemon left the bus (exited or crashed)
+    };
+    // Deliver the daemon's signals on the main loop. Call from the main thread.
+    static void subscribe(Handlers handlers);
+    static void unsubscribe();
+};
+
+} // namespace proton
+
+#endif // DAEMON_SERVICE_HPP
@@ -1,7 +1,15 @@
 #include "file_index.hpp"
 #include "logger.hpp"
 #include "crypto.hpp"
+#include "sqlite_page_vfs.hpp"
 #include "sync_job_metadata.hpp"
+#include "rclone_rc.hpp"
+#include "lsjson_parser.hpp"
+#include "index_batch.hpp"
+#include "remote_snapshot.hpp"
+#include "settings.hpp"
+#include "trace.hpp"
+#include "transfer_scheduler.hpp"
 #include <sqlite3.h>
 #include <sstream>
 #include <fstream>
@@ -11,11 +19,18 @@
 #include <regex>
 #include <algorithm>
 #include <ctime>
+#include <cctype>
 #include <cstring>
 #include <iomanip>
 #include <unistd.h>
 #include <limits.h>
 #include <set>
+#include <unordered_set>
+#include <deque>
+#include <condition_variable>
+#include <future>
+#include <map>
+#include <unordered_map>
 #include <openssl/rand.h>
 
 namespace fs = std::filesystem;
@@ -104,6 +119,44 @@ static std::string get_rclone_path() {
     return "rclone";
 }
 
+// Shell-quote a single argument (same scheme as AppWindowHelpers::shell_escape)
+static std::string fi_shell_escape(const std::string& arg) {
+    std::string escaped = "'";
+    for (char c : arg) {
+        if (c == '\'') escaped += "'\"'\"'";
+        else escaped += c;
+    }
+    escaped += "'";
+    return escaped;
+}
+
+// Uses the persistent RC daemon when it is up, otherwise spawns rclone
+// under `timeout`
+bool FileIndex::fetch_lsjson(const std::string& flags, const std::string& target, int timeout_seconds,
+                             std::string& out, const std::atomic<bool>* stop) {
+    out.clear();
+    proton::TraceSpan span("rclone", "lsjson");
+    span.set_detail(flags + " " + target);
+    std::string args = flags + " " + fi_shell_escape(target);
+    int exit_code = 0;
+    if (proton::RcloneRC::getInstance().run("lsjson " + args, timeout_seconds, out, exit_code)) {
+        if (exit_code != 0) out.clear();
+        return true;
+    }
+    
+    ensure_valid_cwd();
+    std::string cmd = "timeout " + std::to_string(timeout_seconds) + " " + get_rclone_path() +
+                      " lsjson " + args + " 2>/dev/null";
+    std::array<char, 8192> buffer;
+    std::unique_ptr<FILE, decltype(&pclose)> pipe(popen(cmd.c_str(), "r"), pclose);
+    if (!pipe) return false;
+    while (fgets(buffer.data(), buffer.size(), pipe.get()) != nullptr) {
+        if (stop && stop->load()) return false;
+        out += buffer.data();
+    }
+    return true;
+}
+
 // Helper to get current ISO8601 timestamp
 static std::string get_current_timestamp() {
     auto now = std::chrono::system_clock::now();
@@ -122,6 +175,30 @@ static std::chrono::system_clock::time_point parse_timestamp(const std::string&
     return std::chrono::system_clock::from_time_t(std::mktime(&tm));
 }
 
+namespace {
+constexpr size_t GROUP_COMMIT_OPS = 1000;
+constexpr auto GROUP_COMMIT_INTERVAL = std::chrono::milliseconds(50);
+}
+
+// Queued mutation for the single-writer pipeline (see "Write pipeline" below)
+struct FileIndex::WriteOp {
+    enum class Kind { Upsert, Batch, SyncStatus, MarkSynced, Remove, Prune, Meta, MetaDelete, Exec, LoadTree, Barrier };
+    
+    Kind kind = Kind::Barrier;
+    IndexedFile file;                               // Upsert
+    const std::vector<IndexedFile>* batch = nullptr; // Batch (owned by waiting caller)
+    const IndexBatch* records = nullptr;            // Batch from an arena, instead of batch
+    std::string path;                               // SyncStatus/Remove/Prune parent/Meta key/Exec SQL/MarkSynced prefix
+    std::string value;                              // SyncStatus local_path/Meta value/MarkSynced local root
+    bool flag = false;                              // SyncStatus is_synced
+    std::vector<std::string> paths;                 // Prune paths_seen
+    
+    // Set for ops a caller blocks on; the caller owns the op in that case
+    std::promise<bool>* done = nullptr;
+    bool ok = true;
+    WriteOp* next = nullptr;
+};
+
 FileIndex& FileIndex::getInstance() {
     static FileIndex instance;
     return instance;
@@ -139,10 +216,13 @@ FileIndex::FileIndex() {
 
 FileIndex::~FileIndex() {
     // If shutdown() wasn't called, close the DB
-    // Note: Database will remain unencrypted on disk if app crashed
-    // It will be encrypted on next clean shutdown
+    // Note: in whole-file mode the database remains unencrypted on disk if
+    // the app crashed; it will be encrypted on next clean shutdown. Page
+    // encryption keeps it encrypted throughout.
     if (!shutdown_complete_ && db_) {
-        Logger::warn("[FileIndex] Destructor called without shutdown() - database remains unencrypted");
+        if (!page_encryption_) {
+            Logger::warn("[FileIndex] Destructor called without shutdown() - database remains unencrypted");
+        }
         sqlite3_close(static_cast<sqlite3*>(db_));
         db_ = nullptr;
     }
@@ -153,6 +233,9 @@ void FileIndex::shutdown() {
     
     Logger::info("[FileIndex] Graceful shutdown initiated...");
     stop_background_index();
+    ready_.store(false, std::memory_order_release);
+    stop_writer();
+    close_read_pool();
     
     if (db_) {
         // Checkpoint WAL to ensure all data is written to main database file
@@ -163,8 +246,9 @@ void FileIndex::shutdown() {
         db_ = nullptr;
         Logger::info("[FileIndex] Database closed");
         
-        // Encrypt database file if we have a key
-        if (!encryption_key_.empty() && fi_safe_exists(db_path_)) {
+        // Whole-file mode: encrypt database file if we have a key. Page
+        // encryption already wrote every page encrypted.
+        if (!page_encryption_ && !encryption_key_.empty() && fi_safe_exists(db_path_)) {
             Logger::info("[FileIndex] Encrypting database...");
             if (crypto::encrypt_file(db_path_, std::vector<uint8_t>(encryption_key_.begin(), encryption_key_.end()))) {
                 Logger::info("[FileIndex] Database encrypted successfully");
@@ -213,9 +297,17 @@ bool FileIndex::initialize() {
     // Convert key to string for internal storage
     encryption_key_ = std::string(key.begin(), key.end());
     
+    // Page-level encryption keeps the database encrypted at rest while it is
+    // open, so there is no whole-file pass at startup or shutdown. The
+    // PDCRYPT1 whole-file format remains as a fallback for SQLite builds that
+    // cannot reserve per-page space.
+    page_encryption_ = crypto::register_page_vfs(key);
+    is_encrypted_ = page_encryption_;
+    
     // Check if database file exists and is encrypted
     bool db_exists = fi_safe_exists(db_path_);
     bool is_encrypted = db_exists && crypto::is_encrypted_file(db_path_);
+    bool is_page_encrypted = db_exists && crypto::is_page_encrypted_db(db_path_);
     
     if (is_encrypted) {
         Logger::info("[FileIndex] Database is encrypted, decrypting...");
@@ -229,19 +321,91 @@ bool FileIndex::initialize() {
         } else {
             Logger::info("[FileIndex] Database decrypted successfully");
         }
+    } else if (is_page_encrypted) {
+        Logger::info("[FileIndex] Database is page-encrypted");
     } else if (db_exists) {
         Logger::info("[FileIndex] Database exists but is not encrypted (will encrypt on shutdown)");
     } else {
         Logger::info("[FileIndex] No existing database - will create new encrypted database");
     }
     
-    int rc = sqlite3_open(db_path_.c_str(), reinterpret_cast<sqlite3**>(&db_));
+    if (is_page_encrypted && !page_encryption_) {
+        // Can't read it without the VFS; it is only a cache, so start over
+        std::string backup = db_path_ + ".corrupted." + std::to_string(time(nullptr));
+        move_database_files(db_path_, backup);
+        Logger::warn("[FileIndex] Page-encrypted database unreadable without page VFS, moved to: " + backup);
+        is_page_encrypted = false;
+    }
+    
+    // One-time migration: a plaintext database (or one just decrypted from
+    // PDCRYPT1) has no reserved page space, so move it aside and copy its
+    // rows into a fresh page-encrypted file after the schema exists.
+    std::string legacy_path;
+    if (page_encryption_ && !is_page_encrypted && fi_safe_exists(db_path_)) {
+        legacy_path = db_path_ + ".legacy";
+        move_database_files(db_path_, legacy_path);
+    }
+    
+    if (!open_database()) return false;
+    
+    bool tables_ok = create_tables();
+    if (!tables_ok && is_page_encrypted) {
+        // Pages failed authentication - wrong key or a damaged file
+        Logger::error("[FileIndex] Failed to read page-encrypted database - key may be incorrect or file corrupted");
+        sqlite3_close(static_cast<sqlite3*>(db_));
+        db_ = nullptr;
+        std::string backup = db_path_ + ".corrupted." + std::to_string(time(nullptr));
+        move_database_files(db_path_, backup);
+        Logger::warn("[FileIndex] Corrupted database moved to: " + backup);
+        Logger::info("[FileIndex] Starting with fresh database");
+        if (!open_database()) return false;
+        tables_ok = create_tables();
+    }
+    if (tables_ok && !legacy_path.empty()) {
+        migrate_legacy_database(legacy_path);
+    }
+    if (tables_ok) {
+        start_writer();
+        open_read_pool();
+        ready_.store(true, std::memory_order_release);
+        
+        // Built on the writer thread, so no write can slip in between the
+        // snapshot and the first mirrored op
+        auto* load = new WriteOp;
+        load->kind = WriteOp::Kind::LoadTree;
+        enqueue_write(load);
+        
+        // Log current stats
+        auto stats = get_stats();
+        Logger::info("[FileIndex] Loaded existing index: " + std::to_string(stats.total_files) + 
+                    " files, " + std::to_string(stats.total_folders) + " folders");
+    }
+    return tables_ok;
+}
+
+bool FileIndex::open_database() {
+    sqlite3* db = nullptr;
+    int flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_URI;
+    int rc = sqlite3_open_v2(db_path_.c_str(), &db, flags,
+                             page_encryption_ ? crypto::PAGE_VFS_NAME : nullptr);
+    db_ = db;
     if (rc != SQLITE_OK) {
         Logger::error("[FileIndex] Failed to open database: " + 
-                      std::string(sqlite3_errmsg(static_cast<sqlite3*>(db_))));
+                      std::string(db ? sqlite3_errmsg(db) : "out of memory"));
+        sqlite3_close(db);
+        db_ = nullptr;
         return false;
     }
     
+    if (page_encryption_) {
+        // Reserve IV + tag space per page; only takes effect on a new file
+        if (!crypto::configure_page_encryption(db)) {
+            Logger::warn("[FileIndex] Failed to reserve page space for encryption");
+        }
+        // Keep sorter/temp b-trees off disk - the VFS passes temp files through
+        sqlite3_exec(db, "PRAGMA temp_store=MEMORY;", nullptr, nullptr, nullptr);
+    }
+    
     Logger::info("[FileIndex] Database opened successfully");
     
     // Set restrictive permissions (owner read/write only)
@@ -250,19 +414,81 @@ bool FileIndex::initialize() {
                     fs::perm_options::replace);
     
     // Enable WAL mode for better concurrency
-    sqlite3_exec(static_cast<sqlite3*>(db_), "PRAGMA journal_mode=WAL;", nullptr, nullptr, nullptr);
+    sqlite3_exec(db, "PRAGMA journal_mode=WAL;", nullptr, nullptr, nullptr);
+    
+    // WAL + NORMAL only fsyncs at checkpoints; an OS crash can lose the last
+    // group commit but never corrupts the index
+    sqlite3_exec(db, "PRAGMA synchronous=NORMAL;", nullptr, nullptr, nullptr);
     
     // Enable foreign keys
-    sqlite3_exec(static_cast<sqlite3*>(db_), "PRAGMA foreign_keys=ON;", nullptr, nullptr, nullptr);
+    sqlite3_exec(db, "PRAGMA foreign_keys=ON;", nullptr, nullptr, nullptr);
+    return true;
+}
+
+void FileIndex::move_database_files(const std::string& from, const std::string& to) {
+    for (const char* suffix : {"", "-wal", "-shm"}) {
+        std::error_code ec;
+        fs::remove(to + suffix, ec);
+        if (fi_safe_exists(from + suffix)) {
+            fs::rename(from + suffix, to + suffix, ec);
+            if (ec) Logger::warn("[FileIndex] Failed to move " + from + suffix + ": " + ec.message());
+        }
+    }
+}
+
+void FileIndex::migrate_legacy_database(const std::string& legacy_path) {
+    sqlite3* db = static_cast<sqlite3*>(db_);
+    Logger::info("[FileIndex] Migrating plaintext database to page encryption...");
     
-    bool tables_ok = create_tables();
-    if (tables_ok) {
-        // Log current stats
-        auto stats = get_stats();
-        Logger::info("[FileIndex] Loaded existing index: " + std::to_string(stats.total_files) + 
-                    " files, " + std::to_string(stats.total_folders) + " folders");
+    // Attach through the default VFS so the legacy pages are read as-is
+    std::string uri = "file:";
+    for (char c : legacy_path) {
+        if (c == '%') uri += "%25";
+        else if (c == '?') uri += "%3f";
+        else if (c == '#') uri += "%23";
+        else uri += c;
     }
-    return tables_ok;
+    sqlite3_vfs* plain_vfs = sqlite3_vfs_find(nullptr);
+    if (plain_vfs) uri += "?vfs=" + std::string(plain_vfs->zName);
+    
+    sqlite3_stmt* attach = nullptr;
+    bool ok = sqlite3_prepare_v2(db, "ATTACH DATABASE ? AS legacy", -1, &attach, nullptr) == SQLITE_OK;
+    if (ok) {
+        sqlite3_bind_text(attach, 1, uri.c_str(), -1, SQLITE_TRANSIENT);
+        ok = sqlite3_step(attach) == SQLITE_DONE;
+    }
+    sqlite3_finalize(attach);
+    
+    char* err = nullptr;
+    if (ok) {
+        const char* sql_copy = R"(
+            BEGIN;
+            INSERT OR IGNORE INTO main.files
+                (name, path, parent_path, size, mod_time, is_directory, is_synced, local_path, extension, indexed_at)
+                SELECT name, path, parent_path, size, mod_time, is_directory, is_synced, local_path, extension, indexed_at
+                FROM legacy.files;
+            INSERT OR REPLACE INTO main.index_meta (key, value)
+                SELECT key, value FROM legacy.index_meta;
+            COMMIT;
+        )";
+        if (sqlite3_exec(db, sql_copy, nullptr, nullptr, &err) != SQLITE_OK) {
+            Logger::warn("[FileIndex] Legacy migration failed, starting with fresh index: " +
+                         std::string(err ? err : sqlite3_errmsg(db)));
+            sqlite3_free(err);
+            sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+        }
+        sqlite3_exec(db, "DETACH DATABASE legacy;", nullptr, nullptr, nullptr);
+    } else {
+        Logger::warn("[FileIndex] Could not attach legacy database, starting with fresh index: " +
+                     std::string(sqlite3_errmsg(db)));
+    }
+    
+    // Drop the plaintext copy either way; the index can always be rebuilt
+    for (const char* suffix : {"", "-wal", "-shm"}) {
+        std::error_code ec;
+        fs::remove(legacy_path + suffix, ec);
+    }
+    Logger::info("[FileIndex] Legacy database migrated");
 }
 
 bool FileIndex::create_tables() {
@@ -337,6 +563,59 @@ bool FileIndex::create_tables() {
         // Don't return false - basic search will still work
     }
     
+    // Trigram index over names for substring and typo-tolerant search.
+    // Names only: path matches are covered by files_fts above, and indexing
+    // every path's trigrams would roughly triple the index size.
+    bool had_trigram = false;
+    {
+        sqlite3_stmt* check = nullptr;
+        if (sqlite3_prepare_v2(db, "SELECT 1 FROM sqlite_master WHERE name = 'files_trigram'",
+                               -1, &check, nullptr) == SQLITE_OK) {
+            had_trigram = sqlite3_step(check) == SQLITE_ROW;
+        }
+        sqlite3_finalize(check);
+    }
+    const char* sql_trigram = R"(
+        CREATE VIRTUAL TABLE IF NOT EXISTS files_trigram USING fts5(
+            name,
+            content='files',
+            content_rowid='id',
+            tokenize='trigram'
+        );
+        
+        -- Per-trigram document counts, to pick selective trigrams for fuzzy search
+        CREATE VIRTUAL TABLE IF NOT EXISTS files_trigram_vocab USING fts5vocab(files_trigram, 'row');
+        
+        CREATE TRIGGER IF NOT EXISTS files_trigram_ai AFTER INSERT ON files BEGIN
+            INSERT INTO files_trigram(rowid, name) VALUES (new.id, new.name);
+        END;
+        
+        CREATE TRIGGER IF NOT EXISTS files_trigram_ad AFTER DELETE ON files BEGIN
+            INSERT INTO files_trigram(files_trigram, rowid, name) VALUES ('delete', old.id, old.name);
+        END;
+        
+        -- Sync status updates leave the name alone and skip the index
+        CREATE TRIGGER IF NOT EXISTS files_trigram_au AFTER UPDATE OF name ON files BEGIN
+            INSERT INTO files_trigram(files_trigram, rowid, name) VALUES ('delete', old.id, old.name);
+            INSERT INTO files_trigram(rowid, name) VALUES (new.id, new.name);
+        END;
+    )";
+    
+    rc = sqlite3_exec(db, sql_trigram, nullptr, nullptr, &err);
+    if (rc != SQLITE_OK) {
+        // Needs SQLite 3.34+; search falls back to word-prefix matching
+        Logger::warn("[FileIndex] Trigram index unavailable: " + std::string(err));
+        sqlite3_free(err);
+        trigram_available_ = false;
+    } else {
+        trigram_available_ = true;
+        if (!had_trigram) {
+            // Existing database: index the rows already there (one time)
+            Logger::info("[FileIndex] Building trigram search index...");
+            sqlite3_exec(db, "INSERT INTO files_trigram(files_trigram) VALUES ('rebuild');", nullptr, nullptr, nullptr);
+        }
+    }
+    
     // Metadata table for tracking index state
     const char* sql_meta = R"(
         CREATE TABLE IF NOT EXISTS index_meta (
@@ -357,6 +636,28 @@ bool FileIndex::create_tables() {
         return false;
     }
     
+    // Rows used to be written with INSERT OR REPLACE, whose implicit delete
+    // fires no delete trigger, leaving dead rows in both search indexes.
+    // Upserts keep them consistent; rebuild once to drop what is there.
+    bool indexes_clean = false;
+    {
+        sqlite3_stmt* check = nullptr;
+        if (sqlite3_prepare_v2(db, "SELECT 1 FROM index_meta WHERE key = 'search_index_upserts'",
+                               -1, &check, nullptr) == SQLITE_OK) {
+            indexes_clean = sqlite3_step(check) == SQLITE_ROW;
+        }
+        sqlite3_finalize(check);
+    }
+    if (!indexes_clean) {
+        Logger::info("[FileIndex] Rebuilding search indexes...");
+        sqlite3_exec(db, "INSERT INTO files_fts(files_fts) VALUES ('rebuild');", nullptr, nullptr, nullptr);
+        if (trigram_available_ && had_trigram) {
+            sqlite3_exec(db, "INSERT INTO files_trigram(files_trigram) VALUES ('rebuild');", nullptr, nullptr, nullptr);
+        }
+        sqlite3_exec(db, "INSERT OR IGNORE INTO index_meta (key, value) VALUES ('search_index_upserts', '1');",
+                     nullptr, nullptr, nullptr);
+    }
+    
     Logger::info("[FileIndex] Database initialized successfully");
     return true;
 }
@@ -370,25 +671,281 @@ std::string FileIndex::get_extension(const std::string& filename) {
     return ext;
 }
 
-std::vector<IndexedFile> FileIndex::search(const std::string& query, int limit, bool include_folders) {
-    std::vector<IndexedFile> results;
-    if (!db_ || query.empty()) return results;
+// ============================================================================
+// Read pool - queries run on a few read-only WAL connections, each with its
+// own prepared-statement cache. A connection is leased to one thread at a
+// time, so its cache is effectively thread-private while in use, and readers
+// never queue behind the writer's open transaction.
+// ============================================================================
+
+namespace {
+constexpr int READ_POOL_SIZE = 3;
+constexpr size_t STATEMENT_CACHE_LIMIT = 32;
+
+const char* const QUERY_NAMES[] = {
+    "search", "search_with_filters", "get_directory_contents",
+    "get_recent_files", "get_stats", "needs_refresh", "path_exists", "folder_cursors"
+};
+
+// Columns 0-9 of the standard `SELECT id, name, path, ...` projection
+IndexedFile file_from_row(sqlite3_stmt* stmt) {
+    auto text = [stmt](int col) {
+        const char* v = reinterpret_cast<const char*>(sqlite3_column_text(stmt, col));
+        return std::string(v ? v : "");
+    };
+    IndexedFile file;
+    file.id = sqlite3_column_int64(stmt, 0);
+    file.name = text(1);
+    file.path = text(2);
+    file.parent_path = text(3);
+    file.size = sqlite3_column_int64(stmt, 4);
+    file.mod_time = text(5);
+    file.is_directory = sqlite3_column_int(stmt, 6) != 0;
+    file.is_synced = sqlite3_column_int(stmt, 7) != 0;
+    file.local_path = text(8);
+    file.extension = text(9);
+    file.relevance_score = 0.0;
+    return file;
+}
+
+// Candidates pulled from the trigram index for ranking in C++. SQL orders
+// them first (exact and prefix matches, then shortest names; bm25 for fuzzy
+// search), so the cap only drops the weakest matches of very common queries.
+constexpr int TRIGRAM_CANDIDATES = 2000;
+constexpr int FUZZY_CANDIDATES = 5000;
+
+size_t utf8_length(const std::string& s) {
+    size_t n = 0;
+    for (unsigned char c : s) n += (c & 0xC0) != 0x80;
+    return n;
+}
+
+std::string ascii_lower(std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return std::tolower(c); });
+    return s;
+}
+
+// FTS5 string literal
+std::string fts_quote(const std::string& s) {
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"') out += '"';
+        out += c;
+    }
+    return out + "\"";
+}
+
+// Lower is better: exact name, then name prefix, then a match at a word
+// start, then anywhere; -1 if the name does not contain the query
+int substring_rank(const std::string& name_lower, const std::string& query_lower) {
+    size_t pos = name_lower.find(query_lower);
+    if (pos == std::string::npos) return -1;
+    if (name_lower.size() == query_lower.size()) return 0;
+    if (pos == 0) return 1;
+    return std::isalnum(static_cast<unsigned char>(name_lower[pos - 1])) ? 3 : 2;
+}
+
+// Fewest edits (insert, delete, substitute, swap adjacent) turning the query
+// into some substring of `text`
+size_t substring_edit_distance(const std::string& query, const std::string& text) {
+    const size_t m = query.size();
+    std::vector<size_t> prev2(m + 1), prev(m + 1), cur(m + 1);
+    for (size_t i = 0; i <= m; ++i) prev[i] = i;
+    size_t best = prev[m];
+    for (size_t j = 1; j <= text.size(); ++j) {
+        cur[0] = 0;  // A match may start anywhere in the text
+        for (size_t i = 1; i <= m; ++i) {
+            size_t cost = query[i - 1] == text[j - 1] ? 0 : 1;
+            cur[i] = std::min({prev[i] + 1, cur[i - 1] + 1, prev[i - 1] + cost});
+            if (i > 1 && j > 1 && query[i - 1] == text[j - 2] && query[i - 2] == text[j - 1]) {
+                cur[i] = std::min(cur[i], prev2[i - 2] + 1);
+            }
+        }
+        best = std::min(best, cur[m]);
+        std::swap(prev2, prev);
+        std::swap(prev, cur);
+    }
+    return best;
+}
+
+size_t max_typos(size_t query_length) {
+    return query_length <= 4 ? 1 : query_length <= 8 ? 2 : 3;
+}
+}
+
+struct FileIndex::ReadConnection {
+    sqlite3* db = nullptr;
+    std::unordered_map<std::string, sqlite3_stmt*> statements;
     
-    sqlite3* db = static_cast<sqlite3*>(db_);
+    ~ReadConnection() {
+        for (auto& [sql, stmt] : statements) sqlite3_finalize(stmt);
+        if (db) sqlite3_close(db);
+    }
+};
+
+/**
+ * RAII lease on a pooled read connection. Records the query's latency on
+ * release. Falls back to the main connection (without statement caching)
+ * when the pool could not be opened.
+ */
+class FileIndex::ReadLease {
+public:
+    ReadLease(const FileIndex& index, QueryKind kind)
+        : index_(index), kind_(kind), start_(std::chrono::steady_clock::now()) {
+        conn_ = index_.acquire_read_connection();
+    }
+    
+    ~ReadLease() {
+        // Reset everything we stepped so no read transaction outlives the lease
+        for (sqlite3_stmt* stmt : used_) sqlite3_reset(stmt);
+        for (sqlite3_stmt* stmt : transient_) sqlite3_finalize(stmt);
+        if (conn_) index_.release_read_connection(conn_);
+        
+        auto end = std::chrono::steady_clock::now();
+        auto us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(end - start_).count());
+        auto& counter = index_.query_counters_[static_cast<size_t>(kind_)];
+        if (proton::Trace::enabled()) {
+            proton::Trace::record("index", QUERY_NAMES[static_cast<size_t>(kind_)], start_, end);
+        }
+        counter.calls.fetch_add(1, std::memory_order_relaxed);
+        counter.total_us.fetch_add(us, std::memory_order_relaxed);
+        uint64_t prev = counter.max_us.load(std::memory_order_relaxed);
+        while (us > prev && !counter.max_us.compare_exchange_weak(prev, us, std::memory_order_relaxed)) {
+        }
+    }
+    
+    ReadLease(const ReadLease&) = delete;
+    ReadLease& operator=(const ReadLease&) = delete;
+    
+    sqlite3* db() const {
+        return conn_ ? conn_->db : static_cast<sqlite3*>(index_.db_);
+    }
+    
+    // Returns a reset statement with cleared bindings, or nullptr on error
+    sqlite3_stmt* prepare(const std::string& sql) {
+        if (conn_) {
+            auto it = conn_->statements.find(sql);
+            if (it != conn_->statements.end()) {
+                sqlite3_reset(it->second);
+                sqlite3_clear_bindings(it->second);
+                used_.push_back(it->second);
+                return it->second;
+            }
+        }
+        
+        index_.query_counters_[static_cast<size_t>(kind_)].prepares.fetch_add(1, std::memory_order_relaxed);
+        sqlite3_stmt* stmt = nullptr;
+        if (sqlite3_prepare_v2(db(), sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+            if (stmt) sqlite3_finalize(stmt);
+            return nullptr;
+        }
+        
+        if (conn_) {
+            if (conn_->statements.size() >= STATEMENT_CACHE_LIMIT) {
+                // Dynamic filter queries can produce many shapes; start over rather than grow
+                for (auto& [cached_sql, cached] : conn_->statements) sqlite3_finalize(cached);
+                conn_->statements.clear();
+                used_.clear();
+            }
+            conn_->statements.emplace(sql, stmt);
+            used_.push_back(stmt);
+        } else {
+            transient_.push_back(stmt);
+        }
+        return stmt;
+    }
     
-    // Try FTS5 first, fall back to LIKE if it fails
-    std::string sql;
+private:
+    const FileIndex& index_;
+    QueryKind kind_;
+    std::chrono::steady_clock::time_point start_;
+    ReadConnection* conn_ = nullptr;
+    std::vector<sqlite3_stmt*> used_;
+    std::vector<sqlite3_stmt*> transient_;
+};
+
+void FileIndex::open_read_pool() {
+    std::lock_guard<std::mutex> lock(read_pool_mutex_);
+    for (int i = 0; i < READ_POOL_SIZE; i++) {
+        auto* conn = new ReadConnection;
+        int rc = sqlite3_open_v2(db_path_.c_str(), &conn->db,
+                                 SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX,
+                                 page_encryption_ ? crypto::PAGE_VFS_NAME : nullptr);
+        if (rc != SQLITE_OK) {
+            Logger::warn("[FileIndex] Failed to open read connection: " +
+                         std::string(conn->db ? sqlite3_errmsg(conn->db) : "out of memory"));
+            delete conn;
+            break;
+        }
+        sqlite3_busy_timeout(conn->db, 2000);
+        read_pool_idle_.push_back(conn);
+    }
+    read_pool_size_ = static_cast<int>(read_pool_idle_.size());
+    Logger::debug("[FileIndex] Read pool: " + std::to_string(read_pool_size_) + " connections");
+}
+
+void FileIndex::close_read_pool() {
+    std::unique_lock<std::mutex> lock(read_pool_mutex_);
+    // Wait for outstanding leases so nothing still reads when the file is encrypted
+    read_pool_cv_.wait_for(lock, std::chrono::seconds(5), [this] {
+        return static_cast<int>(read_pool_idle_.size()) >= read_pool_size_;
+    });
+    for (auto* conn : read_pool_idle_) delete conn;
+    read_pool_idle_.clear();
+    read_pool_size_ = 0;
+}
+
+FileIndex::ReadConnection* FileIndex::acquire_read_connection() const {
+    std::unique_lock<std::mutex> lock(read_pool_mutex_);
+    if (read_pool_size_ == 0) return nullptr;
+    read_pool_cv_.wait(lock, [this] { return !read_pool_idle_.empty() || read_pool_size_ == 0; });
+    if (read_pool_idle_.empty()) return nullptr;
+    ReadConnection* conn = read_pool_idle_.back();
+    read_pool_idle_.pop_back();
+    return conn;
+}
+
+void FileIndex::release_read_connection(ReadConnection* conn) const {
+    {
+        std::lock_guard<std::mutex> lock(read_pool_mutex_);
+        read_pool_idle_.push_back(conn);
+    }
+    read_pool_cv_.notify_all();
+}
+
+std::vector<QueryLatencyStats> FileIndex::get_query_latency_stats() const {
+    std::vector<QueryLatencyStats> out;
+    for (size_t i = 0; i < query_counters_.size(); i++) {
+        const auto& c = query_counters_[i];
+        QueryLatencyStats s;
+        s.query = QUERY_NAMES[i];
+        s.calls = c.calls.load(std::memory_order_relaxed);
+        s.avg_ms = s.calls ? c.total_us.load(std::memory_order_relaxed) / 1000.0 / s.calls : 0.0;
+        s.max_ms = c.max_us.load(std::memory_order_relaxed) / 1000.0;
+        s.statement_prepares = c.prepares.load(std::memory_order_relaxed);
+        out.push_back(s);
+    }
+    return out;
+}
+
+std::vector<IndexedFile> FileIndex::search(const std::string& query, int limit, bool include_folders) {
+    std::vector<IndexedFile> results;
+    if (!is_ready() || query.empty()) return results;
     
-    // Prepare query for FTS5 (escape special characters, add wildcards)
-    std::string fts_query = query;
-    // Replace * with FTS5 wildcard syntax
-    std::replace(fts_query.begin(), fts_query.end(), '*', '*');
+    ReadLease lease(*this, QueryKind::Search);
+    const size_t wanted = limit > 0 ? static_cast<size_t>(limit) : SIZE_MAX;
+    const bool use_trigrams = trigram_available_ && utf8_length(query) >= 3;
+    std::unordered_set<int64_t> seen;
     
-    // Check if we should use FTS5 or LIKE
-    bool use_fts = true;
+    // Substring matches on the name, ranked in memory
+    if (use_trigrams) {
+        search_trigram(lease, query, include_folders, wanted, results);
+        for (const auto& file : results) seen.insert(file.id);
+    }
     
-    if (use_fts) {
-        sql = R"(
+    // Word-prefix matches (also finds files by folder names in their path)
+    if (results.size() < wanted) {
+        std::string sql = R"(
             SELECT f.id, f.name, f.path, f.parent_path, f.size, f.mod_time, 
                    f.is_directory, f.is_synced, f.local_path, f.extension,
                    bm25(files_fts) as relevance
@@ -396,93 +953,178 @@ std::vector<IndexedFile> FileIndex::search(const std::string& query, int limit,
             JOIN files f ON files_fts.rowid = f.id
             WHERE files_fts MATCH ?
         )";
-        
         if (!include_folders) {
             sql += " AND f.is_directory = 0";
         }
+        // Behind trigram results these are mostly files found by a folder
+        // name, which bm25 cannot tell apart; skip ranking every match then.
+        // LIMIT is bound (-1 = unlimited) so every limit shares one cached statement
+        sql += use_trigrams ? " LIMIT ?" : " ORDER BY relevance LIMIT ?";
         
-        sql += " ORDER BY relevance";
-        
-        if (limit > 0) {
-            sql += " LIMIT " + std::to_string(limit);
-        }
-    }
-    
-    sqlite3_stmt* stmt;
-    int rc = sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr);
-    
-    if (rc != SQLITE_OK) {
-        // FTS5 failed, try LIKE-based search
-        Logger::debug("[FileIndex] FTS5 unavailable, using LIKE search");
-        
-        std::string like_pattern = "%" + query + "%";
-        sql = R"(
-            SELECT id, name, path, parent_path, size, mod_time, 
-                   is_directory, is_synced, local_path, extension, 0.0 as relevance
-            FROM files
-            WHERE name LIKE ? OR path LIKE ?
-        )";
-        
-        if (!include_folders) {
-            sql += " AND is_directory = 0";
-        }
-        
-        sql += " ORDER BY name";
+        sqlite3_stmt* stmt = lease.prepare(sql);
         
-        if (limit > 0) {
-            sql += " LIMIT " + std::to_string(limit);
+        if (!stmt) {
+            // FTS5 failed, try LIKE-based search
+            Logger::debug("[FileIndex] FTS5 unavailable, using LIKE search");
+            
+            sql = R"(
+                SELECT id, name, path, parent_path, size, mod_time, 
+                       is_directory, is_synced, local_path, extension, 0.0 as relevance
+                FROM files
+                WHERE name LIKE ? OR path LIKE ?
+            )";
+            if (!include_folders) {
+                sql += " AND is_directory = 0";
+            }
+            sql += " ORDER BY name LIMIT ?";
+            
+            stmt = lease.prepare(sql);
+            if (!stmt) {
+                Logger::error("[FileIndex] Search prepare failed: " + std::string(sqlite3_errmsg(lease.db())));
+                return results;
+            }
+            
+            std::string like_pattern = "%" + query + "%";
+            sqlite3_bind_text(stmt, 1, like_pattern.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_text(stmt, 2, like_pattern.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_int(stmt, 3, limit > 0 ? limit : -1);
+        } else {
+            // FTS5 query - need to format properly
+            std::string fts_formatted = fts_quote(query) + "*";  // Prefix match
+            sqlite3_bind_text(stmt, 1, fts_formatted.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_int(stmt, 2, limit > 0 ? limit : -1);
         }
         
-        rc = sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr);
-        if (rc != SQLITE_OK) {
-            Logger::error("[FileIndex] Search prepare failed: " + std::string(sqlite3_errmsg(db)));
-            return results;
+        while (results.size() < wanted && sqlite3_step(stmt) == SQLITE_ROW) {
+            IndexedFile file = file_from_row(stmt);
+            if (!seen.insert(file.id).second) continue;
+            file.relevance_score = sqlite3_column_double(stmt, 10);
+            results.push_back(std::move(file));
         }
-        
-        sqlite3_bind_text(stmt, 1, like_pattern.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_text(stmt, 2, like_pattern.c_str(), -1, SQLITE_TRANSIENT);
-    } else {
-        // FTS5 query - need to format properly
-        std::string fts_formatted = "\"" + fts_query + "\"*";  // Prefix match
-        sqlite3_bind_text(stmt, 1, fts_formatted.c_str(), -1, SQLITE_TRANSIENT);
     }
     
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        IndexedFile file;
-        file.id = sqlite3_column_int64(stmt, 0);
-        file.name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        file.path = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-        
-        const char* parent = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-        file.parent_path = parent ? parent : "";
-        
-        file.size = sqlite3_column_int64(stmt, 4);
-        
-        const char* mod_time = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 5));
-        file.mod_time = mod_time ? mod_time : "";
-        
-        file.is_directory = sqlite3_column_int(stmt, 6) != 0;
-        file.is_synced = sqlite3_column_int(stmt, 7) != 0;
-        
-        const char* local = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 8));
-        file.local_path = local ? local : "";
-        
-        const char* ext = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 9));
-        file.extension = ext ? ext : "";
-        
-        file.relevance_score = sqlite3_column_double(stmt, 10);
-        
-        results.push_back(file);
+    // Nothing contains the query as typed: try it with a few typos
+    if (results.empty() && use_trigrams) {
+        search_fuzzy(lease, query, include_folders, wanted, results);
     }
     
-    sqlite3_finalize(stmt);
-    
     Logger::debug("[FileIndex] Search for '" + query + "' returned " + 
                   std::to_string(results.size()) + " results");
     
     return results;
 }
 
+void FileIndex::search_trigram(ReadLease& lease, const std::string& query, bool include_folders,
+                               size_t wanted, std::vector<IndexedFile>& out) {
+    std::string sql = R"(
+        SELECT f.id, f.name, f.path, f.parent_path, f.size, f.mod_time,
+               f.is_directory, f.is_synced, f.local_path, f.extension
+        FROM files_trigram
+        JOIN files f ON files_trigram.rowid = f.id
+        WHERE files_trigram MATCH ?
+    )";
+    if (!include_folders) {
+        sql += " AND f.is_directory = 0";
+    }
+    // Same order as substring_rank below (bar the word-boundary split), so
+    // the LIMIT keeps the best candidates; lower() is ASCII-only like ours
+    sql += R"(
+        ORDER BY CASE WHEN lower(f.name) = ?2 THEN 0
+                      WHEN instr(lower(f.name), ?2) = 1 THEN 1
+                      ELSE 2 END,
+                 length(f.name)
+        LIMIT ?3
+    )";
+    
+    sqlite3_stmt* stmt = lease.prepare(sql);
+    if (!stmt) return;
+    std::string match = fts_quote(query);
+    std::string query_lower = ascii_lower(query);
+    sqlite3_bind_text(stmt, 1, match.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 2, query_lower.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 3, TRIGRAM_CANDIDATES);
+    
+    std::vector<IndexedFile> candidates;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        IndexedFile file = file_from_row(stmt);
+        int rank = substring_rank(ascii_lower(file.name), query_lower);
+        file.relevance_score = rank < 0 ? 4 : rank;  // Non-ASCII case folding: still a match
+        candidates.push_back(std::move(file));
+    }
+    
+    std::stable_sort(candidates.begin(), candidates.end(), [](const IndexedFile& a, const IndexedFile& b) {
+        if (a.relevance_score != b.relevance_score) return a.relevance_score < b.relevance_score;
+        return a.name.size() < b.name.size();
+    });
+    if (candidates.size() > wanted) candidates.resize(wanted);
+    for (auto& file : candidates) out.push_back(std::move(file));
+}
+
+void FileIndex::search_fuzzy(ReadLease& lease, const std::string& query, bool include_folders,
+                             size_t wanted, std::vector<IndexedFile>& out) {
+    // A name within k edits of the query misses at most 3k of its trigrams,
+    // so it contains at least one of any 3k+1 of them. Using the rarest
+    // 3k+1 keeps the candidate set small without losing any match.
+    std::string query_lower = ascii_lower(query);
+    const size_t allowed = max_typos(query_lower.size());
+    std::set<std::string> unique;
+    for (size_t i = 0; i + 3 <= query_lower.size(); ++i) unique.insert(query_lower.substr(i, 3));
+    
+    std::vector<std::pair<int64_t, std::string>> by_frequency;
+    sqlite3_stmt* vocab = lease.prepare("SELECT doc FROM files_trigram_vocab WHERE term = ?");
+    if (!vocab) return;
+    for (const auto& trigram : unique) {
+        sqlite3_reset(vocab);
+        sqlite3_bind_text(vocab, 1, trigram.c_str(), -1, SQLITE_TRANSIENT);
+        int64_t docs = sqlite3_step(vocab) == SQLITE_ROW ? sqlite3_column_int64(vocab, 0) : 0;
+        if (docs > 0) by_frequency.emplace_back(docs, trigram);
+    }
+    std::sort(by_frequency.begin(), by_frequency.end());
+    if (by_frequency.size() > 3 * allowed + 1) by_frequency.resize(3 * allowed + 1);
+    if (by_frequency.empty()) return;
+    
+    std::string match;
+    for (const auto& [docs, trigram] : by_frequency) {
+        if (!match.empty()) match += " OR ";
+        match += fts_quote(trigram);
+    }
+    
+    std::string sql = R"(
+        SELECT f.id, f.name, f.path, f.parent_path, f.size, f.mod_time,
+               f.is_directory, f.is_synced, f.local_path, f.extension
+        FROM files_trigram
+        JOIN files f ON files_trigram.rowid = f.id
+        WHERE files_trigram MATCH ?
+    )";
+    if (!include_folders) {
+        sql += " AND f.is_directory = 0";
+    }
+    // Names sharing more of the rare trigrams first, so the LIMIT drops the
+    // least likely matches rather than arbitrary ones
+    sql += " ORDER BY bm25(files_trigram), length(f.name) LIMIT ?";
+    
+    sqlite3_stmt* stmt = lease.prepare(sql);
+    if (!stmt) return;
+    sqlite3_bind_text(stmt, 1, match.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 2, FUZZY_CANDIDATES);
+    
+    std::vector<IndexedFile> candidates;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        IndexedFile file = file_from_row(stmt);
+        size_t distance = substring_edit_distance(query_lower, ascii_lower(file.name));
+        if (distance > allowed) continue;
+        file.relevance_score = static_cast<double>(distance);
+        candidates.push_back(std::move(file));
+    }
+    
+    std::stable_sort(candidates.begin(), candidates.end(), [](const IndexedFile& a, const IndexedFile& b) {
+        if (a.relevance_score != b.relevance_score) return a.relevance_score < b.relevance_score;
+        return a.name.size() < b.name.size();
+    });
+    if (candidates.size() > wanted) candidates.resize(wanted);
+    for (auto& file : candidates) out.push_back(std::move(file));
+}
+
 std::vector<IndexedFile> FileIndex::search_with_filters(
     const std::string& query,
     const std::string& extension_filter,
@@ -492,9 +1134,7 @@ std::vector<IndexedFile> FileIndex::search_with_filters(
     int limit
 ) {
     std::vector<IndexedFile> results;
-    if (!db_) return results;
-    
-    sqlite3* db = static_cast<sqlite3*>(db_);
+    if (!is_ready()) return results;
     
     std::ostringstream sql;
     sql << "SELECT id, name, path, parent_path, size, mod_time, "
@@ -503,7 +1143,14 @@ std::vector<IndexedFile> FileIndex::search_with_filters(
     
     std::vector<std::string> params;
     
-    if (!query.empty()) {
+    if (!query.empty() && trigram_available_ && utf8_length(query) >= 3) {
+        // Names through the trigram index, folder names in the path through
+        // the word index, instead of a LIKE scan of every row
+        sql << " AND id IN (SELECT rowid FROM files_trigram WHERE files_trigram MATCH ?"
+            << " UNION SELECT rowid FROM files_fts WHERE files_fts MATCH ?)";
+        params.push_back(fts_quote(query));
+        params.push_back("path : " + fts_quote(query) + "*");
+    } else if (!query.empty()) {
         sql << " AND (name LIKE ? OR path LIKE ?)";
         std::string pattern = "%" + query + "%";
         params.push_back(pattern);
@@ -549,15 +1196,11 @@ std::vector<IndexedFile> FileIndex::search_with_filters(
         sql << " AND is_synced = 0";
     }
     
-    sql << " ORDER BY name";
-    
-    if (limit > 0) {
-        sql << " LIMIT " << limit;
-    }
+    sql << " ORDER BY name LIMIT ?";
     
-    sqlite3_stmt* stmt;
-    int rc = sqlite3_prepare_v2(db, sql.str().c_str(), -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
+    ReadLease lease(*this, QueryKind::SearchWithFilters);
+    sqlite3_stmt* stmt = lease.prepare(sql.str());
+    if (!stmt) {
         Logger::error("[FileIndex] Filter search prepare failed");
         return results;
     }
@@ -565,172 +1208,87 @@ std::vector<IndexedFile> FileIndex::search_with_filters(
     for (size_t i = 0; i < params.size(); i++) {
         sqlite3_bind_text(stmt, i + 1, params[i].c_str(), -1, SQLITE_TRANSIENT);
     }
+    sqlite3_bind_int(stmt, params.size() + 1, limit > 0 ? limit : -1);
     
     while (sqlite3_step(stmt) == SQLITE_ROW) {
-        IndexedFile file;
-        file.id = sqlite3_column_int64(stmt, 0);
-        file.name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        file.path = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-        
-        const char* parent = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-        file.parent_path = parent ? parent : "";
-        
-        file.size = sqlite3_column_int64(stmt, 4);
-        
-        const char* mod_time = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 5));
-        file.mod_time = mod_time ? mod_time : "";
-        
-        file.is_directory = sqlite3_column_int(stmt, 6) != 0;
-        file.is_synced = sqlite3_column_int(stmt, 7) != 0;
-        
-        const char* local = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 8));
-        file.local_path = local ? local : "";
-        
-        const char* ext = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 9));
-        file.extension = ext ? ext : "";
-        
-        file.relevance_score = 0.0;
-        
-        results.push_back(file);
+        results.push_back(file_from_row(stmt));
     }
     
-    sqlite3_finalize(stmt);
     return results;
 }
 
 std::vector<IndexedFile> FileIndex::get_directory_contents(const std::string& path) {
     std::vector<IndexedFile> results;
-    if (!db_) return results;
-    
-    sqlite3* db = static_cast<sqlite3*>(db_);
+    if (!is_ready()) return results;
+    if (path_tree_.list(path, results)) return results;
     
-    const char* sql = R"(
+    ReadLease lease(*this, QueryKind::DirectoryContents);
+    sqlite3_stmt* stmt = lease.prepare(R"(
         SELECT id, name, path, parent_path, size, mod_time, 
                is_directory, is_synced, local_path, extension
         FROM files
         WHERE parent_path = ?
         ORDER BY is_directory DESC, name ASC
-    )";
-    
-    sqlite3_stmt* stmt;
-    int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) return results;
+    )");
+    if (!stmt) return results;
     
     sqlite3_bind_text(stmt, 1, path.c_str(), -1, SQLITE_TRANSIENT);
     
     while (sqlite3_step(stmt) == SQLITE_ROW) {
-        IndexedFile file;
-        file.id = sqlite3_column_int64(stmt, 0);
-        file.name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        file.path = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-        
-        const char* parent = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-        file.parent_path = parent ? parent : "";
-        
-        file.size = sqlite3_column_int64(stmt, 4);
-        
-        const char* mod_time = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 5));
-        file.mod_time = mod_time ? mod_time : "";
-        
-        file.is_directory = sqlite3_column_int(stmt, 6) != 0;
-        file.is_synced = sqlite3_column_int(stmt, 7) != 0;
-        
-        const char* local = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 8));
-        file.local_path = local ? local : "";
-        
-        const char* ext = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 9));
-        file.extension = ext ? ext : "";
-        
-        file.relevance_score = 0.0;
-        
-        results.push_back(file);
+        results.push_back(file_from_row(stmt));
     }
     
-    sqlite3_finalize(stmt);
     return results;
 }
 
 std::vector<IndexedFile> FileIndex::get_recent_files(int limit) {
     std::vector<IndexedFile> results;
-    if (!db_) return results;
-    
-    sqlite3* db = static_cast<sqlite3*>(db_);
+    if (!is_ready()) return results;
     
-    std::string sql = R"(
+    ReadLease lease(*this, QueryKind::RecentFiles);
+    sqlite3_stmt* stmt = lease.prepare(R"(
         SELECT id, name, path, parent_path, size, mod_time, 
                is_directory, is_synced, local_path, extension
         FROM files
         WHERE is_directory = 0
         ORDER BY mod_time DESC
         LIMIT ?
-    )";
-    
-    sqlite3_stmt* stmt;
-    int rc = sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) return results;
+    )");
+    if (!stmt) return results;
     
     sqlite3_bind_int(stmt, 1, limit);
     
     while (sqlite3_step(stmt) == SQLITE_ROW) {
-        IndexedFile file;
-        file.id = sqlite3_column_int64(stmt, 0);
-        file.name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        file.path = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-        
-        const char* parent = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-        file.parent_path = parent ? parent : "";
-        
-        file.size = sqlite3_column_int64(stmt, 4);
-        
-        const char* mod_time = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 5));
-        file.mod_time = mod_time ? mod_time : "";
-        
-        file.is_directory = sqlite3_column_int(stmt, 6) != 0;
-        file.is_synced = sqlite3_column_int(stmt, 7) != 0;
-        
-        const char* local = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 8));
-        file.local_path = local ? local : "";
-        
-        const char* ext = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 9));
-        file.extension = ext ? ext : "";
-        
-        file.relevance_score = 0.0;
-        
-        results.push_back(file);
+        results.push_back(file_from_row(stmt));
     }
     
-    sqlite3_finalize(stmt);
     return results;
 }
 
 IndexStats FileIndex::get_stats() {
     IndexStats stats = {};
-    if (!db_) return stats;
+    if (!is_ready()) return stats;
     
-    sqlite3* db = static_cast<sqlite3*>(db_);
-    sqlite3_stmt* stmt;
+    ReadLease lease(*this, QueryKind::Stats);
     
     // Get file/folder counts
-    const char* sql_counts = R"(
+    if (sqlite3_stmt* stmt = lease.prepare(R"(
         SELECT 
             SUM(CASE WHEN is_directory = 0 THEN 1 ELSE 0 END) as files,
             SUM(CASE WHEN is_directory = 1 THEN 1 ELSE 0 END) as folders,
             SUM(CASE WHEN is_directory = 0 THEN size ELSE 0 END) as total_size
         FROM files
-    )";
-    
-    if (sqlite3_prepare_v2(db, sql_counts, -1, &stmt, nullptr) == SQLITE_OK) {
+    )")) {
         if (sqlite3_step(stmt) == SQLITE_ROW) {
             stats.total_files = sqlite3_column_int64(stmt, 0);
             stats.total_folders = sqlite3_column_int64(stmt, 1);
             stats.total_size_bytes = sqlite3_column_int64(stmt, 2);
         }
-        sqlite3_finalize(stmt);
     }
     
     // Get last index times
-    const char* sql_meta = "SELECT key, value FROM index_meta WHERE key IN ('last_full_index', 'last_partial_index')";
-    if (sqlite3_prepare_v2(db, sql_meta, -1, &stmt, nullptr) == SQLITE_OK) {
+    if (sqlite3_stmt* stmt = lease.prepare(
+            "SELECT key, value FROM index_meta WHERE key IN ('last_full_index', 'last_partial_index')")) {
         while (sqlite3_step(stmt) == SQLITE_ROW) {
             const char* key = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
             const char* value = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
@@ -742,7 +1300,6 @@ IndexStats FileIndex::get_stats() {
                 }
             }
         }
-        sqlite3_finalize(stmt);
     }
     
     stats.is_indexing = is_indexing_.load();
@@ -810,10 +1367,17 @@ void FileIndex::index_worker(bool full_reindex) {
     if (full_reindex) {
         // Clear existing data
         report_progress(5, "Clearing old index...");
-        sqlite3_exec(db, "DELETE FROM files;", nullptr, nullptr, nullptr);
-        
-        // Full recursive scan
-        index_worker_full(db);
+        WriteOp clear;
+        clear.kind = WriteOp::Kind::Exec;
+        clear.path = "DELETE FROM files; DELETE FROM index_meta WHERE key LIKE 'cursor:%';";
+        enqueue_write_and_wait(clear);
+        
+        // Full recursive scan - sharded by top-level folder unless disabled
+        if (proton::SettingsManager::getInstance().get_index_crawl_workers() > 1) {
+            index_worker_parallel(db);
+        } else {
+            index_worker_full(db);
+        }
     } else {
         // Incremental: only scan synced folders + top-level structure
         index_worker_incremental(db);
@@ -821,190 +1385,372 @@ void FileIndex::index_worker(bool full_reindex) {
 }
 
 void FileIndex::index_worker_incremental(void* db_handle) {
-    sqlite3* db = static_cast<sqlite3*>(db_handle);
+    (void)db_handle;  // Reads go through the pool, writes through the writer
     auto start_time = std::chrono::steady_clock::now();
     
-    report_progress(5, "Scanning top-level folders...");
-    Logger::info("[FileIndex] Starting INCREMENTAL index (synced folders + top-level)");
-    
-    // Ensure valid working directory before popen()
-    ensure_valid_cwd();
-    
-    std::string rclone = get_rclone_path();
-    
-    // ========================================================================
-    // Phase 1: Quick top-level scan (depth 1 only — single API call)
-    // ========================================================================
-    std::string cmd = "timeout 30 " + rclone + " lsjson --max-depth 1 \"" + remote_name_ + ":/\" 2>/dev/null";
+    report_progress(5, "Checking folder timestamps...");
+    Logger::info("[FileIndex] Starting INCREMENTAL index (changed folders only)");
     
-    std::array<char, 8192> buffer;
-    std::string top_json;
-    {
-        std::unique_ptr<FILE, decltype(&pclose)> pipe(popen(cmd.c_str(), "r"), pclose);
-        if (!pipe) {
-            Logger::error("[FileIndex] Failed to run rclone for incremental index");
-            report_progress(100, "Error: rclone failed");
+    int changed_folders = 0;
+    int total_updated = refresh_changed_folders(remote_name_ + ":/", "", 10, 95, &changed_folders);
+    if (total_updated < 0) {
+        if (stop_requested_) {
+            Logger::info("[FileIndex] Incremental: cancelled");
             is_indexing_ = false;
             return;
         }
-        while (fgets(buffer.data(), buffer.size(), pipe.get()) != nullptr) {
-            if (stop_requested_) { is_indexing_ = false; return; }
-            top_json += buffer.data();
-        }
-    }
-    
-    if (top_json.empty() || top_json.find('[') == std::string::npos) {
-        Logger::warn("[FileIndex] Incremental: no valid JSON from top-level scan");
-        report_progress(100, "Error: No data from cloud");
+        Logger::error("[FileIndex] Failed to run rclone for incremental index");
+        report_progress(100, "Error: rclone failed");
         is_indexing_ = false;
         return;
     }
     
-    // Parse top-level items and upsert them
-    auto top_items = parse_lsjson_output(top_json, remote_name_ + ":/");
-    int total_updated = 0;
+    auto total_elapsed = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::steady_clock::now() - start_time).count();
     
-    if (!top_items.empty()) {
-        insert_files_batch(top_items);
-        total_updated += top_items.size();
-        Logger::info("[FileIndex] Incremental: updated " + std::to_string(top_items.size()) + " top-level items");
+    update_last_index_time();
+    report_progress(100, "Updated " + std::to_string(total_updated) + " items (" + 
+                   std::to_string(total_elapsed) + "s)");
+    
+    Logger::info("[FileIndex] Incremental index complete: " + std::to_string(total_updated) + 
+                " items in " + std::to_string(total_elapsed) + "s " +
+                "(re-listed " + std::to_string(changed_folders) + " changed folders)");
+    
+    is_indexing_ = false;
+}
+
+// ============================================================================
+// Folder cursors - index_meta rows "cursor:<folder path>" = folder ModTime as
+// of the last time its direct children were listed. The files row for a
+// folder is rewritten whenever its parent is listed, so it can't serve as
+// the cursor; the cursor only advances after the folder itself was re-listed.
+// ============================================================================
+
+std::map<std::string, std::string> FileIndex::load_folder_cursors(const std::string& prefix) const {
+    std::map<std::string, std::string> cursors;
+    if (!is_ready()) return cursors;
+    
+    // Range scan on the primary key: every key that starts with cursor:<prefix>
+    // (prefix ends in '/', and '0' is the next byte after '/')
+    std::string lower = "cursor:" + prefix;
+    std::string upper = lower.substr(0, lower.size() - 1) + "0";
+    
+    ReadLease lease(*this, QueryKind::FolderCursors);
+    sqlite3_stmt* stmt = lease.prepare("SELECT key, value FROM index_meta WHERE key >= ? AND key < ?");
+    if (!stmt) return cursors;
+    
+    sqlite3_bind_text(stmt, 1, lower.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 2, upper.c_str(), -1, SQLITE_TRANSIENT);
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char* key = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+        const char* value = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+        if (key) cursors[key + 7] = value ? value : "";  // strip "cursor:"
     }
+    return cursors;
+}
+
+std::string FileIndex::get_folder_cursor(const std::string& folder) {
+    if (!is_ready()) return "";
     
-    report_progress(15, "Top-level scanned (" + std::to_string(top_items.size()) + " items)");
+    ReadLease lease(*this, QueryKind::FolderCursors);
+    sqlite3_stmt* stmt = lease.prepare("SELECT value FROM index_meta WHERE key = ?");
+    if (!stmt) return "";
     
-    // ========================================================================
-    // Phase 2: Scan synced folders recursively (these are what the user cares about)
-    // ========================================================================
-    // Get active sync job remote paths from SyncJobRegistry
-    std::vector<std::string> synced_folders;
-    {
-        // Query for folders that are marked as synced in the index
-        sqlite3_stmt* stmt;
-        const char* sql = "SELECT DISTINCT parent_path FROM files WHERE is_synced = 1";
-        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK) {
-            while (sqlite3_step(stmt) == SQLITE_ROW) {
-                const char* path = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
-                if (path && strlen(path) > 0) {
-                    synced_folders.push_back(path);
-                }
-            }
-            sqlite3_finalize(stmt);
+    std::string key = "cursor:" + folder;
+    sqlite3_bind_text(stmt, 1, key.c_str(), -1, SQLITE_TRANSIENT);
+    std::string value;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char* text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+        if (text) value = text;
+    }
+    return value;
+}
+
+void FileIndex::store_directory_listing(const std::string& folder,
+                                        const std::vector<IndexedFile>& entries,
+                                        const std::string& mod_time) {
+    if (!is_ready()) return;
+    
+    if (!entries.empty()) insert_files_batch(entries);
+    
+    std::vector<std::string> seen;
+    seen.reserve(entries.size());
+    for (const auto& entry : entries) seen.push_back(entry.path);
+    auto* prune = new WriteOp;
+    prune->kind = WriteOp::Kind::Prune;
+    prune->path = folder;
+    prune->paths = std::move(seen);
+    enqueue_write(prune);
+    
+    if (!mod_time.empty()) {
+        auto* op = new WriteOp;
+        op->kind = WriteOp::Kind::Meta;
+        op->path = "cursor:" + folder;
+        op->value = mod_time;
+        enqueue_write(op);
+    }
+}
+
+void FileIndex::seed_folder_cursors() {
+    // After a complete crawl every folder's children are known
+    auto* op = new WriteOp;
+    op->kind = WriteOp::Kind::Exec;
+    op->path = "DELETE FROM index_meta WHERE key LIKE 'cursor:%';"
+               "INSERT OR REPLACE INTO index_meta (key, value) "
+               "SELECT 'cursor:' || path, mod_time FROM files WHERE is_directory = 1;";
+    enqueue_write(op);
+}
+
+int FileIndex::refresh_changed_folders(const std::string& root, const std::string& local_root,
+                                       int progress_from, int progress_to, int* changed_count) {
+    auto child_prefix = [](const std::string& folder) {
+        return folder.back() == '/' ? folder : folder + "/";
+    };
+    const std::string root_prefix = child_prefix(root);
+    
+    // Sync job trees come from the snapshot CloudMonitor reads too, so a
+    // job's remote is listed once per cycle rather than once per consumer
+    proton::RemoteSnapshotService::SnapshotPtr snapshot;
+    std::vector<IndexedFile> dirs;
+    if (!local_root.empty()) {
+        snapshot = proton::RemoteSnapshotService::getInstance().get(root, &stop_requested_, true);
+        if (!snapshot) return -1;
+        for (const auto& [path, folder] : snapshot->folders) {
+            if (path == snapshot->root) continue;
+            IndexedFile dir{};
+            dir.path = path;
+            dir.mod_time = folder.mod_time;
+            dirs.push_back(std::move(dir));
+        }
+    } else if (!skeleton_scan_due(root)) {
+        return walk_changed_folders(root, progress_from, progress_to, changed_count);
+    } else {
+        // Directory skeleton only: O(folders) rows instead of O(files)
+        std::string dirs_json;
+        if (!fetch_lsjson("--recursive --dirs-only --fast-list", root, 300,
+                          dirs_json, &stop_requested_)) {
+            return -1;
+        }
+        if (dirs_json.find('[') == std::string::npos) {
+            Logger::warn("[FileIndex] No folder listing for " + root);
+            return -1;
         }
+        dirs = LsjsonParser::parse(dirs_json, root_prefix);
     }
     
-    // Also check for top-level directories that have changed mod_time
-    // Compare each top-level folder's mod_time against what's in the DB
-    std::vector<std::string> changed_folders;
-    for (const auto& item : top_items) {
-        if (!item.is_directory) continue;
-        if (stop_requested_) { is_indexing_ = false; return; }
-        
-        // Check stored mod_time for this folder
-        sqlite3_stmt* stmt;
-        const char* sql = "SELECT mod_time FROM files WHERE path = ?";
-        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK) {
-            sqlite3_bind_text(stmt, 1, item.path.c_str(), -1, SQLITE_TRANSIENT);
-            if (sqlite3_step(stmt) == SQLITE_ROW) {
-                const char* stored_mod = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
-                std::string stored = stored_mod ? stored_mod : "";
-                if (stored != item.mod_time) {
-                    // Mod time changed — folder contents may have changed
-                    changed_folders.push_back(item.path);
-                    Logger::info("[FileIndex] Incremental: folder changed: " + item.path + 
-                               " (stored=" + stored + " vs cloud=" + item.mod_time + ")");
-                }
-            } else {
-                // New folder not in index yet
-                changed_folders.push_back(item.path);
-                Logger::info("[FileIndex] Incremental: new folder: " + item.path);
-            }
-            sqlite3_finalize(stmt);
+    flush();  // Cursors written by a previous pass must be visible to the read pool
+    auto cursors = load_folder_cursors(root_prefix);
+    
+    // The root's own ModTime isn't part of its listing, so it is always re-listed
+    std::vector<std::pair<std::string, std::string>> changed;  // <folder, ModTime>
+    changed.emplace_back(root, "");
+    std::set<std::string> live;
+    for (const auto& dir : dirs) {
+        live.insert(dir.path);
+        auto it = cursors.find(dir.path);
+        if (it == cursors.end() || it->second != dir.mod_time) {
+            changed.emplace_back(dir.path, dir.mod_time);
         }
     }
     
-    // Merge synced_folders and changed_folders into a unique set to scan
-    std::set<std::string> folders_to_scan;
-    for (const auto& f : synced_folders) folders_to_scan.insert(f);
-    for (const auto& f : changed_folders) folders_to_scan.insert(f);
-    
-    int total_folders = folders_to_scan.size();
-    int folder_idx = 0;
+    // Cursors of folders that no longer exist
+    for (const auto& [path, mod_time] : cursors) {
+        if (live.count(path)) continue;
+        auto* op = new WriteOp;
+        op->kind = WriteOp::Kind::MetaDelete;
+        op->path = "cursor:" + path;
+        enqueue_write(op);
+    }
     
-    Logger::info("[FileIndex] Incremental: " + std::to_string(total_folders) + 
-                " folders to scan (" + std::to_string(synced_folders.size()) + " synced, " +
-                std::to_string(changed_folders.size()) + " changed)");
+    Logger::info("[FileIndex] " + root + ": " + std::to_string(changed.size() - 1) + " of " +
+                 std::to_string(dirs.size()) + " folders changed since last scan");
+    if (changed_count) *changed_count = static_cast<int>(changed.size()) - 1;
     
-    for (const auto& folder_path : folders_to_scan) {
-        if (stop_requested_) {
-            Logger::info("[FileIndex] Incremental: cancelled");
-            is_indexing_ = false;
-            return;
-        }
-        
-        folder_idx++;
-        int progress = 15 + (folder_idx * 80 / std::max(total_folders, 1));
-        report_progress(progress, "Scanning folder " + std::to_string(folder_idx) + "/" + 
-                       std::to_string(total_folders) + "...");
-        
-        // Extract the cloud path from the full path (remove "proton:" prefix)
-        std::string cloud_path = folder_path;
-        size_t colon = cloud_path.find(':');
-        if (colon != std::string::npos) {
-            cloud_path = cloud_path.substr(colon + 1);
-        }
-        if (cloud_path.empty()) cloud_path = "/";
-        
-        // Shell-escape the path
-        std::string safe_remote = remote_name_ + ":" + cloud_path;
-        std::string escaped = "'";
-        for (char c : safe_remote) {
-            if (c == '\'') escaped += "'\"'\"'";
-            else escaped += c;
+    int total_updated = 0;
+    int idx = 0;
+    for (const auto& [folder, mod_time] : changed) {
+        if (stop_requested_) return -1;
+        
+        idx++;
+        if (progress_to > progress_from) {
+            report_progress(progress_from + idx * (progress_to - progress_from) / static_cast<int>(changed.size()),
+                            "Scanning folder " + std::to_string(idx) + "/" + std::to_string(changed.size()) + "...");
         }
-        escaped += "'";
         
-        // Scan this folder recursively (but with a timeout to prevent hangs)
-        std::string scan_cmd = "timeout 60 " + rclone + " lsjson --recursive --fast-list " + escaped + " 2>/dev/null";
-        
-        std::string folder_json;
-        {
-            std::unique_ptr<FILE, decltype(&pclose)> pipe(popen(scan_cmd.c_str(), "r"), pclose);
-            if (!pipe) {
-                Logger::warn("[FileIndex] Incremental: failed to scan " + folder_path);
+        std::vector<IndexedFile> items;
+        std::vector<std::string> seen;
+        auto add_item = [&](IndexedFile&& file) {
+            if (!local_root.empty()) {
+                file.is_synced = true;
+                file.local_path = local_root + "/" + file.path.substr(root_prefix.size());
+            }
+            seen.push_back(file.path);
+            items.push_back(std::move(file));
+        };
+        
+        if (snapshot) {
+            auto it = snapshot->folders.find(folder);
+            if (it == snapshot->folders.end() || !it->second.children) {
+                Logger::warn("[FileIndex] No snapshot listing for changed folder " + folder);
                 continue;
             }
-            while (fgets(buffer.data(), buffer.size(), pipe.get()) != nullptr) {
-                if (stop_requested_) { is_indexing_ = false; return; }
-                folder_json += buffer.data();
+            for (IndexedFile file : *it->second.children) add_item(std::move(file));
+        } else {
+            std::string json;
+            if (!fetch_lsjson("--max-depth 1", folder, 60, json, &stop_requested_) ||
+                json.find('[') == std::string::npos) {
+                // Cursor not advanced - retried on the next pass
+                Logger::warn("[FileIndex] Failed to list changed folder " + folder);
+                continue;
             }
+            LsjsonParser parser(child_prefix(folder), add_item);
+            parser.feed(json);
         }
         
-        if (folder_json.empty() || folder_json.find('[') == std::string::npos) {
-            Logger::debug("[FileIndex] Incremental: empty or invalid output for " + folder_path);
-            continue;
-        }
-        
-        auto items = parse_lsjson_output(folder_json, folder_path + "/");
         if (!items.empty()) {
             insert_files_batch(items);
-            total_updated += items.size();
-            Logger::info("[FileIndex] Incremental: updated " + std::to_string(items.size()) + 
-                        " items in " + folder_path);
+            total_updated += static_cast<int>(items.size());
+        }
+        // Children are stored with parent_path == folder ("proton:/" for the root).
+        // Queued directly: unlike prune_stale_entries, an empty listing here is
+        // authoritative and must clear the folder.
+        auto* prune = new WriteOp;
+        prune->kind = WriteOp::Kind::Prune;
+        prune->path = folder;
+        prune->paths = std::move(seen);
+        enqueue_write(prune);
+        
+        if (!mod_time.empty()) {
+            auto* op = new WriteOp;
+            op->kind = WriteOp::Kind::Meta;
+            op->path = "cursor:" + folder;
+            op->value = mod_time;
+            enqueue_write(op);
         }
     }
     
-    auto total_elapsed = std::chrono::duration_cast<std::chrono::seconds>(
-        std::chrono::steady_clock::now() - start_time).count();
+    // Unchanged folders were skipped above; their entries still belong to the job
+    if (!local_root.empty()) {
+        auto* op = new WriteOp;
+        op->kind = WriteOp::Kind::MarkSynced;
+        op->path = root_prefix;
+        op->value = local_root;
+        enqueue_write(op);
+    }
+    if (!snapshot) {
+        auto* op = new WriteOp;
+        op->kind = WriteOp::Kind::Meta;
+        op->path = "skeleton_scan:" + root;
+        op->value = get_current_timestamp();
+        enqueue_write(op);
+    }
     
-    update_last_index_time();
-    report_progress(100, "Updated " + std::to_string(total_updated) + " items (" + 
-                   std::to_string(total_elapsed) + "s)");
+    return total_updated;
+}
+
+bool FileIndex::skeleton_scan_due(const std::string& root) const {
+    if (!is_ready()) return true;
     
-    Logger::info("[FileIndex] Incremental index complete: " + std::to_string(total_updated) + 
-                " items in " + std::to_string(total_elapsed) + "s " +
-                "(scanned " + std::to_string(total_folders) + " folders)");
+    ReadLease lease(*this, QueryKind::FolderCursors);
+    sqlite3_stmt* stmt = lease.prepare("SELECT value FROM index_meta WHERE key = ?");
+    if (!stmt) return true;
     
-    is_indexing_ = false;
+    std::string key = "skeleton_scan:" + root;
+    sqlite3_bind_text(stmt, 1, key.c_str(), -1, SQLITE_TRANSIENT);
+    if (sqlite3_step(stmt) != SQLITE_ROW) return true;
+    const char* value = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+    if (!value || !*value) return true;
+    
+    auto age = std::chrono::system_clock::now() - parse_timestamp(value);
+    return age >= std::chrono::hours(SKELETON_SCAN_HOURS);
+}
+
+int FileIndex::walk_changed_folders(const std::string& root, int progress_from, int progress_to,
+                                    int* changed_count) {
+    auto child_prefix = [](const std::string& folder) {
+        return folder.back() == '/' ? folder : folder + "/";
+    };
+    
+    flush();  // Cursors written by a previous pass must be visible to the read pool
+    auto cursors = load_folder_cursors(child_prefix(root));
+    
+    // Breadth-first from the root, which is always listed. Each listing
+    // carries its subfolders' ModTimes; only those that moved are queued,
+    // so an unchanged subtree costs nothing beyond its parent's listing.
+    std::deque<std::pair<std::string, std::string>> pending;  // <folder, ModTime>
+    pending.emplace_back(root, "");
+    int listed = 0;
+    int total_updated = 0;
+    
+    while (!pending.empty()) {
+        if (stop_requested_) return -1;
+        auto [folder, mod_time] = std::move(pending.front());
+        pending.pop_front();
+        
+        std::string json;
+        if (!fetch_lsjson("--max-depth 1", folder, 60, json, &stop_requested_) ||
+            json.find('[') == std::string::npos) {
+            if (folder == root) return -1;
+            // Cursor not advanced - this subtree is retried on the next pass
+            Logger::warn("[FileIndex] Failed to list changed folder " + folder);
+            continue;
+        }
+        listed++;
+        
+        const std::string prefix = child_prefix(folder);
+        std::vector<IndexedFile> children = LsjsonParser::parse(json, prefix);
+        std::set<std::string> subfolders;
+        for (const auto& child : children) {
+            if (!child.is_directory) continue;
+            subfolders.insert(child.path);
+            auto it = cursors.find(child.path);
+            if (it == cursors.end() || it->second != child.mod_time) {
+                pending.emplace_back(child.path, child.mod_time);
+            }
+        }
+        
+        // Cursors of subfolders that are gone, and of everything below them
+        for (auto it = cursors.lower_bound(prefix); it != cursors.end() && it->first.rfind(prefix, 0) == 0;) {
+            const std::string& path = it->first;
+            bool direct_child = path.find('/', prefix.size()) == std::string::npos;
+            if (!direct_child || subfolders.count(path)) {
+                ++it;
+                continue;
+            }
+            // Descendants sort after siblings like "name " or "name-", so find
+            // them by their own prefix rather than next to the folder itself
+            const std::string gone = path + "/";
+            auto first = cursors.lower_bound(gone);
+            auto last = first;
+            while (last != cursors.end() && last->first.rfind(gone, 0) == 0) ++last;
+            for (auto del = first; del != last; ++del) {
+                auto* op = new WriteOp;
+                op->kind = WriteOp::Kind::MetaDelete;
+                op->path = "cursor:" + del->first;
+                enqueue_write(op);
+            }
+            cursors.erase(first, last);
+            auto* op = new WriteOp;
+            op->kind = WriteOp::Kind::MetaDelete;
+            op->path = "cursor:" + path;
+            enqueue_write(op);
+            it = cursors.erase(it);
+        }
+        
+        total_updated += static_cast<int>(children.size());
+        store_directory_listing(folder, children, mod_time);
+        
+        if (progress_to > progress_from) {
+            int known = listed + static_cast<int>(pending.size());
+            report_progress(progress_from + listed * (progress_to - progress_from) / known,
+                            "Scanning folder " + std::to_string(listed) + "/" + std::to_string(known) + "...");
+        }
+    }
+    
+    Logger::info("[FileIndex] " + root + ": " + std::to_string(listed - 1) +
+                 " changed folders below the root re-listed");
+    if (changed_count) *changed_count = listed - 1;
+    return total_updated;
 }
 
 void FileIndex::index_worker_full(void* db_handle) {
@@ -1021,7 +1767,7 @@ void FileIndex::index_worker_full(void* db_handle) {
     // Use rclone lsjson --recursive with --fast-list for better performance
     std::string cmd = get_rclone_path() + " lsjson --recursive --fast-list \"" + remote_name_ + ":/\" 2>/dev/null";
     
-    std::array<char, 8192> buffer;  // Reasonable buffer size
+    std::array<char, 65536> buffer;
     std::unique_ptr<FILE, decltype(&pclose)> pipe(popen(cmd.c_str(), "r"), pclose);
     
     if (!pipe) {
@@ -1031,76 +1777,35 @@ void FileIndex::index_worker_full(void* db_handle) {
         return;
     }
     
-    // Streaming parser state - minimal memory usage
-    std::vector<IndexedFile> batch;
-    batch.reserve(500);  // Pre-allocate batch size
-    int total_saved = 0;
-    int brace_depth = 0;
-    bool in_string = false;
-    bool escape_next = false;
-    std::string current_object;
-    current_object.reserve(2048);  // Reserve reasonable size for one JSON object
-    
+    // Streaming parser state - one arena reused for every batch
     const size_t BATCH_SIZE = 500;  // Save every 500 files
+    IndexBatch batch(BATCH_SIZE);
+    int total_saved = 0;
     
-    // Fast manual JSON value extractors (replace regex for ~10x faster parsing)
-    auto extract_string = [](const std::string& obj, const char* key, std::string& out) -> bool {
-        std::string needle = std::string("\"") + key + "\":";
-        size_t pos = obj.find(needle);
-        if (pos == std::string::npos) return false;
-        pos += needle.size();
-        while (pos < obj.size() && (obj[pos] == ' ' || obj[pos] == '\t')) pos++;
-        if (pos >= obj.size() || obj[pos] != '"') return false;
-        pos++; // skip opening quote
-        std::string result;
-        result.reserve(128);
-        while (pos < obj.size() && obj[pos] != '"') {
-            if (obj[pos] == '\\' && pos + 1 < obj.size()) {
-                pos++;
-                switch (obj[pos]) {
-                    case '"': result += '"'; break;
-                    case '\\': result += '\\'; break;
-                    case '/': result += '/'; break;
-                    case 'n': result += '\n'; break;
-                    case 't': result += '\t'; break;
-                    default: result += obj[pos]; break;
-                }
-            } else {
-                result += obj[pos];
-            }
-            pos++;
+    LsjsonParser parser(remote_name_ + ":/", [&](IndexedFile&& file) {
+        batch.add(file);  // Copied, so the parser keeps its buffers
+        
+        // Save batch when it reaches threshold
+        if (batch.size() >= BATCH_SIZE) {
+            auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::steady_clock::now() - start_time).count();
+            
+            insert_files_batch(batch);
+            total_saved += batch.size();
+            batch.clear();
+            
+            int progress = std::min(10 + (total_saved / 100), 90);
+            report_progress(progress, "Indexed " + std::to_string(total_saved) + 
+                          " files (" + std::to_string(elapsed) + "s)...");
+            Logger::debug("[FileIndex] Saved batch, total: " + std::to_string(total_saved) + " files");
         }
-        out = std::move(result);
-        return true;
-    };
-    
-    auto extract_int64 = [](const std::string& obj, const char* key, int64_t& out) -> bool {
-        std::string needle = std::string("\"") + key + "\":";
-        size_t pos = obj.find(needle);
-        if (pos == std::string::npos) return false;
-        pos += needle.size();
-        while (pos < obj.size() && (obj[pos] == ' ' || obj[pos] == '\t')) pos++;
-        size_t end = pos;
-        if (end < obj.size() && obj[end] == '-') end++;
-        while (end < obj.size() && std::isdigit(static_cast<unsigned char>(obj[end]))) end++;
-        if (end == pos) return false;
-        try { out = std::stoll(obj.substr(pos, end - pos)); return true; }
-        catch (...) { return false; }
-    };
-    
-    auto extract_bool = [](const std::string& obj, const char* key) -> bool {
-        std::string needle = std::string("\"") + key + "\":";
-        size_t pos = obj.find(needle);
-        if (pos == std::string::npos) return false;
-        pos += needle.size();
-        while (pos < obj.size() && (obj[pos] == ' ' || obj[pos] == '\t')) pos++;
-        return (pos + 3 < obj.size() && obj.substr(pos, 4) == "true");
-    };
+    });
     
     Logger::info("[FileIndex] Reading rclone output stream...");
     
-    // Process character by character directly from buffer - NO accumulation
-    while (fgets(buffer.data(), buffer.size(), pipe.get()) != nullptr) {
+    // Feed raw pipe reads straight into the parser - NO accumulation
+    size_t n;
+    while ((n = fread(buffer.data(), 1, buffer.size(), pipe.get())) > 0) {
         if (stop_requested_) {
             // Save what we have before stopping
             if (!batch.empty()) {
@@ -1112,93 +1817,7 @@ void FileIndex::index_worker_full(void* db_handle) {
             return;
         }
         
-        // Process this line directly - do NOT accumulate into json_buffer
-        const char* ptr = buffer.data();
-        while (*ptr) {
-            char c = *ptr++;
-            
-            if (escape_next) {
-                escape_next = false;
-                if (brace_depth > 0) current_object += c;
-                continue;
-            }
-            
-            if (c == '\\' && in_string) {
-                escape_next = true;
-                if (brace_depth > 0) current_object += c;
-                continue;
-            }
-            
-            if (c == '"' && !escape_next) {
-                in_string = !in_string;
-            }
-            
-            if (!in_string) {
-                if (c == '{') {
-                    if (brace_depth == 0) {
-                        current_object.clear();
-                    }
-                    brace_depth++;
-                } else if (c == '}') {
-                    brace_depth--;
-                    if (brace_depth == 0) {
-                        current_object += c;
-                        
-                        // Parse this complete JSON object using fast extractors
-                        IndexedFile file;
-                        std::string path_value;
-                        
-                        if (extract_string(current_object, "Path", path_value)) {
-                            file.path = remote_name_ + ":/" + path_value;
-                        }
-                        extract_string(current_object, "Name", file.name);
-                        extract_int64(current_object, "Size", file.size);
-                        std::string mod_value;
-                        if (extract_string(current_object, "ModTime", mod_value)) {
-                            file.mod_time = mod_value.substr(0, 19);
-                        }
-                        file.is_directory = extract_bool(current_object, "IsDir");
-                        
-                        // Calculate parent path and extension
-                        size_t last_slash = file.path.rfind('/');
-                        if (last_slash != std::string::npos && last_slash > file.path.find(':') + 1) {
-                            file.parent_path = file.path.substr(0, last_slash);
-                        } else {
-                            file.parent_path = remote_name_ + ":/";
-                        }
-                        
-                        file.extension = get_extension(file.name);
-                        file.is_synced = false;
-                        
-                        if (!file.name.empty() && !file.path.empty()) {
-                            batch.push_back(std::move(file));
-                        }
-                        
-                        // Save batch when it reaches threshold
-                        if (batch.size() >= BATCH_SIZE) {
-                            auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
-                                std::chrono::steady_clock::now() - start_time).count();
-                            
-                            insert_files_batch(batch);
-                            total_saved += batch.size();
-                            batch.clear();
-                            
-                            int progress = std::min(10 + (total_saved / 100), 90);
-                            report_progress(progress, "Indexed " + std::to_string(total_saved) + 
-                                          " files (" + std::to_string(elapsed) + "s)...");
-                            Logger::debug("[FileIndex] Saved batch, total: " + std::to_string(total_saved) + " files");
-                        }
-                        
-                        current_object.clear();
-                        continue;
-                    }
-                }
-            }
-            
-            if (brace_depth > 0) {
-                current_object += c;
-            }
-        }
+        parser.feed(buffer.data(), n);
     }
     
     // Save remaining files
@@ -1222,6 +1841,7 @@ void FileIndex::index_worker_full(void* db_handle) {
     }
     
     report_progress(95, "Updating statistics...");
+    seed_folder_cursors();
     update_last_index_time();
     
     report_progress(100, "Indexed " + std::to_string(total_saved) + " items");
@@ -1232,291 +1852,739 @@ void FileIndex::index_worker_full(void* db_handle) {
 }
 
 // ============================================================================
-// parse_lsjson_output - Parse rclone lsjson JSON into IndexedFile vector
-// base_path: the parent path prefix (e.g. "proton:/" or "proton:/Documents/")
+// index_worker_parallel - Full index sharded by top-level folder
+// Lists the root once, then crawls each top-level subtree with its own
+// `lsjson --recursive` on a bounded worker pool. Workers only parse; a single
+// writer thread drains their batches into insert_files_batch so SQLite never
+// sees concurrent write transactions from the indexer.
 // ============================================================================
-std::vector<IndexedFile> FileIndex::parse_lsjson_output(const std::string& json, const std::string& base_path) {
-    std::vector<IndexedFile> items;
-    if (json.empty() || json.find('[') == std::string::npos) return items;
-    
-    // Fast manual JSON value extractors
-    auto extract_str = [](const std::string& obj, const char* key, std::string& out) -> bool {
-        std::string needle = std::string("\"" ) + key + "\":";
-        size_t pos = obj.find(needle);
-        if (pos == std::string::npos) return false;
-        pos += needle.size();
-        while (pos < obj.size() && (obj[pos] == ' ' || obj[pos] == '\t')) pos++;
-        if (pos >= obj.size() || obj[pos] != '"') return false;
-        pos++;
-        std::string result;
-        result.reserve(128);
-        while (pos < obj.size() && obj[pos] != '"') {
-            if (obj[pos] == '\\' && pos + 1 < obj.size()) {
-                pos++;
-                switch (obj[pos]) {
-                    case '"': result += '"'; break;
-                    case '\\': result += '\\'; break;
-                    case '/': result += '/'; break;
-                    case 'n': result += '\n'; break;
-                    case 't': result += '\t'; break;
-                    default: result += obj[pos]; break;
+void FileIndex::index_worker_parallel(void* db_handle) {
+    const int max_workers = proton::SettingsManager::getInstance().get_index_crawl_workers();
+    auto start_time = std::chrono::steady_clock::now();
+    
+    report_progress(8, "Listing top-level folders...");
+    Logger::info("[FileIndex] Starting PARALLEL full index (" + std::to_string(max_workers) + " workers)");
+    
+    std::string top_json;
+    if (!fetch_lsjson("--max-depth 1", remote_name_ + ":/", 60, top_json, &stop_requested_)) {
+        if (stop_requested_) { is_indexing_ = false; return; }
+        Logger::warn("[FileIndex] Top-level listing failed, falling back to single-stream crawl");
+        index_worker_full(db_handle);
+        return;
+    }
+    
+    auto top_items = parse_lsjson_output(top_json, remote_name_ + ":/");
+    if (top_items.empty()) {
+        Logger::warn("[FileIndex] Top-level listing empty, falling back to single-stream crawl");
+        index_worker_full(db_handle);
+        return;
+    }
+    
+    // One shard per top-level folder (cloud path without the remote prefix)
+    std::vector<std::string> shards;
+    for (const auto& item : top_items) {
+        if (item.is_directory) shards.push_back(item.path.substr(remote_name_.size() + 1));
+    }
+    
+    const size_t BATCH_SIZE = 500;
+    const size_t MAX_QUEUED_BATCHES = 16;  // Backpressure so parsers can't outrun SQLite
+    
+    std::mutex queue_mutex;
+    std::condition_variable queue_cv;
+    std::deque<IndexBatch> queue;
+    std::vector<IndexBatch> spare;  // Written batches, arenas kept for reuse
+    bool producers_done = false;
+    std::atomic<int> total_saved{0};
+    
+    IndexBatch top_batch(top_items.size());
+    for (const auto& item : top_items) top_batch.add(item);
+    queue.push_back(std::move(top_batch));
+    
+    auto take_batch = [&]() {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        if (spare.empty()) return IndexBatch(BATCH_SIZE);
+        IndexBatch batch = std::move(spare.back());
+        spare.pop_back();
+        return batch;
+    };
+    
+    auto push_batch = [&](IndexBatch&& batch) {
+        std::unique_lock<std::mutex> lock(queue_mutex);
+        queue_cv.wait(lock, [&] { return queue.size() < MAX_QUEUED_BATCHES || stop_requested_; });
+        queue.push_back(std::move(batch));
+        queue_cv.notify_all();
+    };
+    
+    auto writer_loop = [&]() {
+        std::unique_lock<std::mutex> lock(queue_mutex);
+        while (true) {
+            queue_cv.wait(lock, [&] { return !queue.empty() || producers_done; });
+            if (queue.empty()) break;
+            auto batch = std::move(queue.front());
+            queue.pop_front();
+            lock.unlock();
+            queue_cv.notify_all();
+            
+            insert_files_batch(batch);
+            total_saved += static_cast<int>(batch.size());
+            batch.clear();
+            
+            lock.lock();
+            spare.push_back(std::move(batch));
+        }
+    };
+    
+    std::atomic<size_t> next_shard{0};
+    std::atomic<int> shards_done{0};
+    std::atomic<int> shards_failed{0};
+    std::mutex failed_mutex;
+    std::vector<std::string> failed_shards;
+    auto mark_failed = [&](const std::string& shard) {
+        std::lock_guard<std::mutex> lock(failed_mutex);
+        failed_shards.push_back(shard);
+        shards_failed++;
+    };
+    const int total_shards = static_cast<int>(shards.size());
+    
+    auto crawl_loop = [&]() {
+        std::array<char, 65536> buffer;
+        while (!stop_requested_) {
+            // Listings are the lowest priority; let opens and copies go first
+            proton::TransferScheduler::getInstance().yield_to_foreground(std::chrono::seconds(30), &stop_requested_);
+            size_t idx = next_shard++;
+            if (idx >= shards.size()) break;
+            const std::string& shard = shards[idx];
+            
+            std::string cmd = get_rclone_path() + " lsjson --recursive --fast-list " +
+                              fi_shell_escape(remote_name_ + ":" + shard) + " 2>/dev/null";
+            FILE* pipe = popen(cmd.c_str(), "r");
+            if (!pipe) {
+                Logger::warn("[FileIndex] Failed to start listing for " + shard);
+                mark_failed(shard);
+                shards_done++;
+                continue;
+            }
+            
+            IndexBatch batch = take_batch();
+            LsjsonParser parser(remote_name_ + ":" + shard + "/", [&](IndexedFile&& file) {
+                batch.add(file);
+                if (batch.size() >= BATCH_SIZE) {
+                    push_batch(std::move(batch));
+                    batch = take_batch();
                 }
-            } else {
-                result += obj[pos];
+            });
+            
+            size_t n;
+            while (!stop_requested_ && (n = fread(buffer.data(), 1, buffer.size(), pipe)) > 0) {
+                parser.feed(buffer.data(), n);
             }
-            pos++;
+            int status = pclose(pipe);
+            
+            if (!batch.empty()) push_batch(std::move(batch));
+            if (status != 0 && !stop_requested_) {
+                Logger::warn("[FileIndex] Listing for " + shard + " exited with status " + std::to_string(status));
+                mark_failed(shard);
+            }
+            
+            int done = ++shards_done;
+            auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::steady_clock::now() - start_time).count();
+            report_progress(10 + done * 85 / std::max(total_shards, 1),
+                            "Indexed " + std::to_string(total_saved.load()) + " files (" +
+                            std::to_string(done) + "/" + std::to_string(total_shards) + " folders, " +
+                            std::to_string(elapsed) + "s)...");
+            Logger::debug("[FileIndex] Shard done: " + shard + " (" + std::to_string(parser.count()) + " items)");
         }
-        out = std::move(result);
-        return true;
     };
     
-    auto extract_i64 = [](const std::string& obj, const char* key, int64_t& out) -> bool {
-        std::string needle = std::string("\"" ) + key + "\":";
-        size_t pos = obj.find(needle);
-        if (pos == std::string::npos) return false;
-        pos += needle.size();
-        while (pos < obj.size() && (obj[pos] == ' ' || obj[pos] == '\t')) pos++;
-        size_t end = pos;
-        if (end < obj.size() && obj[end] == '-') end++;
-        while (end < obj.size() && std::isdigit(static_cast<unsigned char>(obj[end]))) end++;
-        if (end == pos) return false;
-        try { out = std::stoll(obj.substr(pos, end - pos)); return true; }
-        catch (...) { return false; }
-    };
+    // Ensure valid working directory before the workers popen()
+    ensure_valid_cwd();
+    report_progress(10, "Indexing " + std::to_string(total_shards) + " folders...");
+    
+    std::thread writer;
+    std::vector<std::thread> workers;
+    try {
+        writer = std::thread(writer_loop);
+        int n_workers = std::min(max_workers, std::max(total_shards, 1));
+        for (int i = 0; i < n_workers; i++) {
+            workers.emplace_back(crawl_loop);
+        }
+    } catch (const std::system_error& e) {
+        // Whatever started still drains the shard list; a missing pool just runs slower
+        Logger::error("[FileIndex] Failed to create crawl thread: " + std::string(e.what()));
+        if (workers.empty()) {
+            if (writer.joinable()) {
+                crawl_loop();
+            } else {
+                stop_requested_ = true;
+            }
+        }
+    }
+    
+    for (auto& t : workers) t.join();
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        producers_done = true;
+    }
+    queue_cv.notify_all();
+    if (writer.joinable()) writer.join();
+    
+    auto total_elapsed = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::steady_clock::now() - start_time).count();
+    
+    if (stop_requested_) {
+        Logger::info("[FileIndex] Indexing cancelled, saved " + std::to_string(total_saved.load()) + " files");
+        is_indexing_ = false;
+        return;
+    }
     
-    auto extract_b = [](const std::string& obj, const char* key) -> bool {
-        std::string needle = std::string("\"" ) + key + "\":";
-        size_t pos = obj.find(needle);
-        if (pos == std::string::npos) return false;
-        pos += needle.size();
-        while (pos < obj.size() && (obj[pos] == ' ' || obj[pos] == '\t')) pos++;
-        return (pos + 3 < obj.size() && obj.substr(pos, 4) == "true");
+    Logger::info("[FileIndex] Parallel crawl complete: " + std::to_string(total_saved.load()) + " files in " +
+                 std::to_string(total_elapsed) + "s (" + std::to_string(total_shards) + " shards, " +
+                 std::to_string(shards_failed.load()) + " failed)");
+    
+    if (shards_failed > 0) {
+        // Parts of the tree are missing: leave the index stale so the next
+        // refresh crawls again instead of trusting an incomplete one
+        std::string names;
+        for (const auto& shard : failed_shards) names += (names.empty() ? "" : ", ") + shard;
+        Logger::warn("[FileIndex] Index left stale, failed shards: " + names);
+        report_progress(95, "Error: " + std::to_string(shards_failed.load()) +
+                        " folders could not be listed - index incomplete");
+        is_indexing_ = false;
+        return;
+    }
+    
+    report_progress(95, "Updating statistics...");
+    seed_folder_cursors();
+    update_last_index_time();
+    
+    report_progress(100, "Indexed " + std::to_string(total_saved.load()) + " items");
+    is_indexing_ = false;
+}
+
+// ============================================================================
+// parse_lsjson_output - Parse rclone lsjson JSON into IndexedFile vector
+// base_path: the parent path prefix (e.g. "proton:/" or "proton:/Documents/")
+// ============================================================================
+std::vector<IndexedFile> FileIndex::parse_lsjson_output(const std::string& json, const std::string& base_path) {
+    if (json.empty() || json.find('[') == std::string::npos) return {};
+    // base_path already includes trailing separator
+    return LsjsonParser::parse(json, base_path);
+}
+
+// ============================================================================
+// Write pipeline - every mutation of files/index_meta goes through one writer
+// thread. Producers push onto a lock-free stack; the writer wakes every 50 ms
+// (or as soon as GROUP_COMMIT_OPS are pending / someone waits), reverses the
+// stack into submission order and applies it in group-committed transactions.
+// ============================================================================
+
+void FileIndex::start_writer() {
+    if (writer_running_) return;
+    writer_running_ = true;
+    try {
+        writer_thread_ = std::thread(&FileIndex::writer_loop, this);
+    } catch (const std::system_error& e) {
+        // Writes are applied inline by the producer instead
+        Logger::error("[FileIndex] Failed to create writer thread: " + std::string(e.what()));
+        writer_running_ = false;
+    }
+}
+
+void FileIndex::stop_writer() {
+    if (writer_thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(writer_wake_mutex_);
+            writer_running_ = false;
+            writer_wake_ = true;
+        }
+        writer_cv_.notify_one();
+        writer_thread_.join();
+    }
+    writer_running_ = false;
+    // Anything pushed after the writer's last drain
+    process_pending_writes();
+}
+
+void FileIndex::enqueue_write(WriteOp* op) {
+    op->next = write_head_.load(std::memory_order_relaxed);
+    while (!write_head_.compare_exchange_weak(op->next, op,
+                                              std::memory_order_release,
+                                              std::memory_order_relaxed)) {
+    }
+    size_t pending = pending_writes_.fetch_add(1, std::memory_order_relaxed) + 1;
+    
+    if (!writer_running_) {
+        process_pending_writes();
+        return;
+    }
+    
+    // Plain mutations wait for the next tick; only wake early when a group is
+    // full or somebody is blocked on the result
+    if (op->done || pending >= GROUP_COMMIT_OPS) {
+        {
+            std::lock_guard<std::mutex> lock(writer_wake_mutex_);
+            writer_wake_ = true;
+        }
+        writer_cv_.notify_one();
+    }
+}
+
+bool FileIndex::enqueue_write_and_wait(WriteOp& op) {
+    std::promise<bool> promise;
+    auto result = promise.get_future();
+    op.done = &promise;
+    enqueue_write(&op);
+    return result.get();
+}
+
+void FileIndex::flush() {
+    if (!is_ready()) return;
+    WriteOp barrier;
+    barrier.kind = WriteOp::Kind::Barrier;
+    enqueue_write_and_wait(barrier);
+}
+
+void FileIndex::writer_loop() {
+    Logger::debug("[FileIndex] Writer thread started");
+    while (true) {
+        bool running;
+        {
+            std::unique_lock<std::mutex> lock(writer_wake_mutex_);
+            writer_cv_.wait_for(lock, GROUP_COMMIT_INTERVAL, [this] { return writer_wake_; });
+            writer_wake_ = false;
+            running = writer_running_;
+        }
+        process_pending_writes();
+        if (!running) break;
+    }
+    Logger::debug("[FileIndex] Writer thread stopped");
+}
+
+void FileIndex::process_pending_writes() {
+    std::lock_guard<std::mutex> apply_lock(writer_apply_mutex_);
+    
+    WriteOp* head = write_head_.exchange(nullptr, std::memory_order_acquire);
+    if (!head) return;
+    
+    // Stack is newest-first; reverse into submission order
+    std::vector<WriteOp*> ops;
+    for (WriteOp* op = head; op; op = op->next) ops.push_back(op);
+    std::reverse(ops.begin(), ops.end());
+    pending_writes_.fetch_sub(ops.size(), std::memory_order_relaxed);
+    
+    sqlite3* db = static_cast<sqlite3*>(db_);
+    
+    auto finish = [](WriteOp* op, bool committed) {
+        if (op->done) {
+            op->done->set_value(committed && op->ok);
+        } else {
+            delete op;
+        }
     };
     
-    // Parse JSON objects using brace-depth tracking
-    int brace_depth = 0;
-    bool in_string = false;
-    bool escape_next = false;
-    std::string current_object;
-    current_object.reserve(2048);
+    if (!db) {
+        for (WriteOp* op : ops) finish(op, false);
+        return;
+    }
     
-    for (size_t i = 0; i < json.size(); i++) {
-        char c = json[i];
-        
-        if (escape_next) { escape_next = false; if (brace_depth > 0) current_object += c; continue; }
-        if (c == '\\' && in_string) { escape_next = true; if (brace_depth > 0) current_object += c; continue; }
-        if (c == '"' && !escape_next) in_string = !in_string;
+    const char* upsert_sql = R"(
+        INSERT INTO files 
+        (name, path, parent_path, size, mod_time, is_directory, is_synced, local_path, extension, indexed_at)
+        VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, CURRENT_TIMESTAMP)
+        ON CONFLICT(path) DO UPDATE SET
+            name = excluded.name, parent_path = excluded.parent_path, size = excluded.size,
+            mod_time = excluded.mod_time, is_directory = excluded.is_directory,
+            is_synced = excluded.is_synced, local_path = excluded.local_path,
+            extension = excluded.extension, indexed_at = excluded.indexed_at
+    )";
+    
+    size_t i = 0;
+    while (i < ops.size()) {
+        proton::TraceSpan span("index", "write group");
+        
+        // One transaction per group; statements are prepared once per group
+        sqlite3_stmt* upsert = nullptr;
+        sqlite3_stmt* sync_status = nullptr;
+        sqlite3_stmt* remove = nullptr;
+        sqlite3_stmt* remove_tree = nullptr;
+        sqlite3_stmt* list_children = nullptr;
+        sqlite3_stmt* meta_delete = nullptr;
+        sqlite3_stmt* mark_synced = nullptr;
+        std::map<std::string, std::string> meta;  // Last write per key wins
+        
+        auto prepare = [db](sqlite3_stmt*& stmt, const char* sql) -> sqlite3_stmt* {
+            if (!stmt && sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+                Logger::error("[FileIndex] prepare failed: " + std::string(sqlite3_errmsg(db)));
+                stmt = nullptr;
+            }
+            return stmt;
+        };
+        
+        // SQLITE_STATIC: every upsert is stepped and reset before its op is
+        // finished, so the caller's strings outlive the bind
+        auto bind_view = [](sqlite3_stmt* stmt, int index, std::string_view text) {
+            // An empty view may have no data pointer, which would bind NULL
+            sqlite3_bind_text(stmt, index, text.empty() ? "" : text.data(), static_cast<int>(text.size()),
+                              SQLITE_STATIC);
+        };
+        
+        auto upsert_file = [&](const IndexedFileRef& file) -> bool {
+            sqlite3_stmt* stmt = prepare(upsert, upsert_sql);
+            if (!stmt) return false;
+            bind_view(stmt, 1, file.name);
+            bind_view(stmt, 2, file.path);
+            bind_view(stmt, 3, file.parent_path);
+            sqlite3_bind_int64(stmt, 4, file.size);
+            bind_view(stmt, 5, file.mod_time);
+            sqlite3_bind_int(stmt, 6, file.is_directory ? 1 : 0);
+            sqlite3_bind_int(stmt, 7, file.is_synced ? 1 : 0);
+            bind_view(stmt, 8, file.local_path);
+            bind_view(stmt, 9, file.extension);
+            bool ok = sqlite3_step(stmt) == SQLITE_DONE;
+            sqlite3_reset(stmt);
+            return ok;
+        };
+        
+        auto delete_tree = [&](const std::string& path) {
+            sqlite3_stmt* stmt = prepare(remove_tree, "DELETE FROM files WHERE path = ? OR path LIKE ?");
+            if (!stmt) return;
+            std::string prefix = path + "/%";
+            sqlite3_bind_text(stmt, 1, path.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_text(stmt, 2, prefix.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_step(stmt);
+            sqlite3_reset(stmt);
+        };
+        
+        char* err_msg = nullptr;
+        if (sqlite3_exec(db, "BEGIN TRANSACTION;", nullptr, nullptr, &err_msg) != SQLITE_OK) {
+            Logger::error("[FileIndex] BEGIN TRANSACTION failed: " + std::string(err_msg ? err_msg : "unknown"));
+            if (err_msg) sqlite3_free(err_msg);
+        }
         
-        if (!in_string) {
-            if (c == '{') {
-                if (brace_depth == 0) current_object.clear();
-                brace_depth++;
-            } else if (c == '}') {
-                brace_depth--;
-                if (brace_depth == 0) {
-                    current_object += c;
-                    
-                    IndexedFile file;
-                    std::string path_value;
+        size_t group_start = i;
+        size_t weight = 0;
+        while (i < ops.size() && weight < GROUP_COMMIT_OPS) {
+            WriteOp* op = ops[i++];
+            switch (op->kind) {
+                case WriteOp::Kind::Upsert:
+                    weight++;
+                    if (!upsert_file(IndexedFileRef::of(op->file))) {
+                        op->ok = false;
+                        Logger::warn("[FileIndex] Failed to add/update file: " + op->file.path);
+                    }
+                    break;
                     
-                    extract_str(current_object, "Name", file.name);
-                    if (extract_str(current_object, "Path", path_value)) {
-                        // base_path already includes trailing separator
-                        file.path = base_path + path_value;
+                case WriteOp::Kind::Batch: {
+                    int inserted = 0, errors = 0;
+                    auto insert = [&](const IndexedFileRef& file) {
+                        if (upsert_file(file)) {
+                            inserted++;
+                        } else if (++errors <= 3) {
+                            Logger::warn("[FileIndex] Insert failed for: " + std::string(file.path) + " - " +
+                                         sqlite3_errmsg(db));
+                        }
+                    };
+                    if (op->records) {
+                        for (const auto& file : op->records->records()) insert(file);
+                        weight += op->records->size();
                     } else {
-                        file.path = base_path + file.name;
+                        for (const auto& file : *op->batch) insert(IndexedFileRef::of(file));
+                        weight += op->batch->size();
                     }
-                    extract_i64(current_object, "Size", file.size);
-                    std::string mod_value;
-                    if (extract_str(current_object, "ModTime", mod_value)) {
-                        file.mod_time = mod_value.substr(0, 19);
+                    Logger::info("[FileIndex] Batch insert complete: " + std::to_string(inserted) + " inserted, " + 
+                                std::to_string(errors) + " errors");
+                    break;
+                }
+                    
+                case WriteOp::Kind::SyncStatus:
+                    weight++;
+                    if (sqlite3_stmt* stmt = prepare(sync_status,
+                            "UPDATE files SET is_synced = ?, local_path = ? WHERE path = ?")) {
+                        sqlite3_bind_int(stmt, 1, op->flag ? 1 : 0);
+                        sqlite3_bind_text(stmt, 2, op->value.c_str(), -1, SQLITE_TRANSIENT);
+                        sqlite3_bind_text(stmt, 3, op->path.c_str(), -1, SQLITE_TRANSIENT);
+                        sqlite3_step(stmt);
+                        sqlite3_reset(stmt);
                     }
-                    file.is_directory = extract_b(current_object, "IsDir");
+                    break;
                     
-                    // Calculate parent path
-                    size_t last_slash = file.path.rfind('/');
-                    if (last_slash != std::string::npos && last_slash > file.path.find(':') + 1) {
-                        file.parent_path = file.path.substr(0, last_slash);
-                    } else {
-                        file.parent_path = remote_name_ + ":/";
+                case WriteOp::Kind::MarkSynced: {
+                    weight++;
+                    // Whole subtree under a sync job: local path mirrors the remote layout
+                    std::string upper = op->path.substr(0, op->path.size() - 1) + "0";
+                    if (sqlite3_stmt* stmt = prepare(mark_synced,
+                            "UPDATE files SET is_synced = 1, local_path = ?1 || '/' || substr(path, length(?2) + 1) "
+                            "WHERE path >= ?2 AND path < ?3 AND is_synced = 0")) {
+                        sqlite3_bind_text(stmt, 1, op->value.c_str(), -1, SQLITE_TRANSIENT);
+                        sqlite3_bind_text(stmt, 2, op->path.c_str(), -1, SQLITE_TRANSIENT);
+                        sqlite3_bind_text(stmt, 3, upper.c_str(), -1, SQLITE_TRANSIENT);
+                        sqlite3_step(stmt);
+                        sqlite3_reset(stmt);
+                    }
+                    break;
+                }
+                    
+                case WriteOp::Kind::Remove:
+                    weight++;
+                    if (sqlite3_stmt* stmt = prepare(remove, "DELETE FROM files WHERE path = ?")) {
+                        sqlite3_bind_text(stmt, 1, op->path.c_str(), -1, SQLITE_TRANSIENT);
+                        sqlite3_step(stmt);
+                        sqlite3_reset(stmt);
+                        Logger::debug("[FileIndex] Removed file from index: " + op->path);
+                    }
+                    break;
+                    
+                case WriteOp::Kind::Prune: {
+                    weight++;
+                    // Runs inside the transaction, so it sees upserts queued before it
+                    std::vector<std::string> stale;
+                    std::set<std::string> seen(op->paths.begin(), op->paths.end());
+                    if (sqlite3_stmt* stmt = prepare(list_children, "SELECT path FROM files WHERE parent_path = ?")) {
+                        sqlite3_bind_text(stmt, 1, op->path.c_str(), -1, SQLITE_TRANSIENT);
+                        while (sqlite3_step(stmt) == SQLITE_ROW) {
+                            const char* p = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+                            if (p && !seen.count(p)) stale.emplace_back(p);
+                        }
+                        sqlite3_reset(stmt);
                     }
+                    for (const auto& path : stale) delete_tree(path);
+                    if (!stale.empty()) {
+                        Logger::info("[FileIndex] Pruned " + std::to_string(stale.size()) + 
+                                     " stale entries from: " + op->path);
+                    }
+                    break;
+                }
                     
-                    file.extension = get_extension(file.name);
-                    file.is_synced = false;
+                case WriteOp::Kind::Meta:
+                    meta[op->path] = op->value;
+                    break;
                     
-                    if (!file.name.empty() && !file.path.empty()) {
-                        items.push_back(std::move(file));
+                case WriteOp::Kind::MetaDelete:
+                    meta.erase(op->path);
+                    if (sqlite3_stmt* stmt = prepare(meta_delete, "DELETE FROM index_meta WHERE key = ?")) {
+                        sqlite3_bind_text(stmt, 1, op->path.c_str(), -1, SQLITE_TRANSIENT);
+                        sqlite3_step(stmt);
+                        sqlite3_reset(stmt);
                     }
+                    break;
                     
-                    current_object.clear();
-                    continue;
+                case WriteOp::Kind::Exec:
+                    weight++;
+                    if (sqlite3_exec(db, op->path.c_str(), nullptr, nullptr, &err_msg) != SQLITE_OK) {
+                        Logger::error("[FileIndex] Write failed: " + std::string(err_msg ? err_msg : "unknown"));
+                        if (err_msg) sqlite3_free(err_msg);
+                        err_msg = nullptr;
+                        op->ok = false;
+                    }
+                    break;
+                    
+                case WriteOp::Kind::LoadTree:
+                case WriteOp::Kind::Barrier:
+                    break;
+            }
+        }
+        
+        if (!meta.empty()) {
+            sqlite3_stmt* stmt = nullptr;
+            if (sqlite3_prepare_v2(db, "INSERT OR REPLACE INTO index_meta (key, value) VALUES (?, ?)",
+                                   -1, &stmt, nullptr) == SQLITE_OK) {
+                for (const auto& [key, value] : meta) {
+                    sqlite3_bind_text(stmt, 1, key.c_str(), -1, SQLITE_TRANSIENT);
+                    sqlite3_bind_text(stmt, 2, value.c_str(), -1, SQLITE_TRANSIENT);
+                    sqlite3_step(stmt);
+                    sqlite3_reset(stmt);
+                }
+                sqlite3_finalize(stmt);
+            }
+        }
+        
+        for (sqlite3_stmt* stmt : {upsert, sync_status, mark_synced, remove, remove_tree, list_children, meta_delete}) {
+            if (stmt) sqlite3_finalize(stmt);
+        }
+        
+        bool committed = sqlite3_exec(db, "COMMIT;", nullptr, nullptr, &err_msg) == SQLITE_OK;
+        if (!committed) {
+            Logger::error("[FileIndex] COMMIT failed: " + std::string(err_msg ? err_msg : "unknown"));
+            if (err_msg) sqlite3_free(err_msg);
+            sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+        }
+        
+        // Replay the group into the path tree; a load reads the committed
+        // state, which already includes every op in the group
+        if (committed) {
+            bool reload = path_tree_.needs_compaction();
+            for (size_t j = group_start; j < i; j++) {
+                if (ops[j]->kind == WriteOp::Kind::LoadTree) reload = true;
+            }
+            if (reload) {
+                load_path_tree(db);
+            } else if (path_tree_.loaded()) {
+                for (size_t j = group_start; j < i; j++) {
+                    if (ops[j]->ok) mirror_to_path_tree(*ops[j]);
                 }
             }
         }
         
-        if (brace_depth > 0) current_object += c;
+        span.set_detail(std::to_string(i - group_start) + " ops, " + std::to_string(weight) + " rows");
+        for (size_t j = group_start; j < i; j++) finish(ops[j], committed);
     }
-    
-    return items;
 }
 
-bool FileIndex::insert_files_batch(const std::vector<IndexedFile>& files) {
-    if (!db_ || files.empty()) {
-        Logger::warn("[FileIndex] insert_files_batch: empty files list or no db");
-        return false;
-    }
-    
-    sqlite3* db = static_cast<sqlite3*>(db_);
-    
-    Logger::debug("[FileIndex] Beginning transaction for " + std::to_string(files.size()) + " files");
+void FileIndex::load_path_tree(void* db_handle) {
+    sqlite3* db = static_cast<sqlite3*>(db_handle);
+    auto start = std::chrono::steady_clock::now();
     
-    // Begin transaction
-    char* err_msg = nullptr;
-    int rc = sqlite3_exec(db, "BEGIN TRANSACTION;", nullptr, nullptr, &err_msg);
-    if (rc != SQLITE_OK) {
-        Logger::error("[FileIndex] BEGIN TRANSACTION failed: " + std::string(err_msg ? err_msg : "unknown"));
-        if (err_msg) sqlite3_free(err_msg);
-        return false;
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "SELECT id, name, path, parent_path, size, mod_time, "
+                               "is_directory, is_synced, local_path, extension FROM files",
+                           -1, &stmt, nullptr) != SQLITE_OK) {
+        Logger::warn("[FileIndex] Path tree load failed: " + std::string(sqlite3_errmsg(db)));
+        return;
     }
-    
-    const char* sql = R"(
-        INSERT OR REPLACE INTO files 
-        (name, path, parent_path, size, mod_time, is_directory, is_synced, local_path, extension)
-        VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)
-    )";
-    
-    sqlite3_stmt* stmt;
-    rc = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
-        Logger::error("[FileIndex] prepare failed: " + std::string(sqlite3_errmsg(db)));
-        sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
-        return false;
+    proton::PathTree fresh;
+    size_t row_bytes = 0;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        IndexedFile file = file_from_row(stmt);
+        row_bytes += sizeof(IndexedFile) + file.name.capacity() + file.path.capacity() +
+                     file.parent_path.capacity() + file.mod_time.capacity() + file.local_path.capacity() +
+                     file.extension.capacity();
+        fresh.upsert(file);
     }
+    sqlite3_finalize(stmt);
     
-    int inserted = 0;
-    int errors = 0;
-    for (const auto& file : files) {
-        sqlite3_bind_text(stmt, 1, file.name.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_text(stmt, 2, file.path.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_text(stmt, 3, file.parent_path.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_int64(stmt, 4, file.size);
-        sqlite3_bind_text(stmt, 5, file.mod_time.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_int(stmt, 6, file.is_directory ? 1 : 0);
-        sqlite3_bind_int(stmt, 7, file.is_synced ? 1 : 0);
-        sqlite3_bind_text(stmt, 8, file.local_path.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_text(stmt, 9, file.extension.c_str(), -1, SQLITE_TRANSIENT);
-        
-        rc = sqlite3_step(stmt);
-        if (rc != SQLITE_DONE) {
-            errors++;
-            if (errors <= 3) {
-                Logger::warn("[FileIndex] Insert failed for: " + file.path + " - " + sqlite3_errmsg(db));
+    size_t entries = fresh.entry_count();
+    size_t bytes = fresh.memory_bytes();
+    path_tree_.replace_with(fresh);
+    
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    Logger::info("[FileIndex] Path tree loaded: " + std::to_string(entries) + " entries, " +
+                 std::to_string(bytes / 1024) + " KiB (" + std::to_string(row_bytes / 1024) +
+                 " KiB as rows) in " + std::to_string(ms) + " ms");
+}
+
+void FileIndex::mirror_to_path_tree(const WriteOp& op) {
+    switch (op.kind) {
+        case WriteOp::Kind::Upsert:
+            path_tree_.upsert(op.file);
+            break;
+        case WriteOp::Kind::Batch:
+            if (op.records) {
+                for (const auto& file : op.records->records()) path_tree_.upsert(file);
+            } else {
+                for (const auto& file : *op.batch) path_tree_.upsert(file);
             }
-        } else {
-            inserted++;
-        }
-        sqlite3_reset(stmt);
+            break;
+        case WriteOp::Kind::SyncStatus:
+            path_tree_.set_sync_status(op.path, op.flag, op.value);
+            break;
+        case WriteOp::Kind::MarkSynced:
+            // op.path is the folder with a trailing '/'
+            path_tree_.mark_synced(op.path.substr(0, op.path.size() - 1), op.value);
+            break;
+        case WriteOp::Kind::Remove:
+            path_tree_.remove(op.path);
+            break;
+        case WriteOp::Kind::Prune:
+            path_tree_.prune(op.path, std::set<std::string>(op.paths.begin(), op.paths.end()));
+            break;
+        case WriteOp::Kind::Exec:
+            // Other statements only touch index_meta
+            if (op.path.rfind("DELETE FROM files;", 0) == 0) path_tree_.reset();
+            break;
+        default:
+            break;
+    }
+}
+
+bool FileIndex::get_folder_summary(const std::string& folder, proton::PathTree::Summary& out) const {
+    return is_ready() && path_tree_.summarize(folder, out);
+}
+
+bool FileIndex::insert_files_batch(const std::vector<IndexedFile>& files) {
+    if (!is_ready() || files.empty()) {
+        Logger::warn("[FileIndex] insert_files_batch: empty files list or no db");
+        return false;
     }
     
-    sqlite3_finalize(stmt);
+    Logger::debug("[FileIndex] Queueing batch of " + std::to_string(files.size()) + " files");
     
-    rc = sqlite3_exec(db, "COMMIT;", nullptr, nullptr, &err_msg);
-    if (rc != SQLITE_OK) {
-        Logger::error("[FileIndex] COMMIT failed: " + std::string(err_msg ? err_msg : "unknown"));
-        if (err_msg) sqlite3_free(err_msg);
+    // Blocks until committed - the caller's vector is read in place by the
+    // writer and this also gives bulk producers natural backpressure
+    WriteOp op;
+    op.kind = WriteOp::Kind::Batch;
+    op.batch = &files;
+    return enqueue_write_and_wait(op);
+}
+
+bool FileIndex::insert_files_batch(const IndexBatch& batch) {
+    if (!is_ready() || batch.empty()) {
+        Logger::warn("[FileIndex] insert_files_batch: empty files list or no db");
         return false;
     }
     
-    Logger::info("[FileIndex] Batch insert complete: " + std::to_string(inserted) + " inserted, " + 
-                std::to_string(errors) + " errors");
+    Logger::debug("[FileIndex] Queueing batch of " + std::to_string(batch.size()) + " files");
     
-    return true;
+    // As above: the arena must not be cleared until the batch has committed
+    WriteOp op;
+    op.kind = WriteOp::Kind::Batch;
+    op.records = &batch;
+    return enqueue_write_and_wait(op);
 }
 
 void FileIndex::update_last_index_time() {
-    if (!db_) return;
+    if (!is_ready()) return;
     
-    sqlite3* db = static_cast<sqlite3*>(db_);
     std::string now = get_current_timestamp();
     
-    // Use INSERT OR REPLACE to ensure the row exists
-    sqlite3_stmt* stmt;
-    const char* sql = "INSERT OR REPLACE INTO index_meta (key, value) VALUES ('last_full_index', ?)";
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK) {
-        sqlite3_bind_text(stmt, 1, now.c_str(), -1, SQLITE_TRANSIENT);
-        int rc = sqlite3_step(stmt);
-        if (rc == SQLITE_DONE) {
-            Logger::info("[FileIndex] Updated last_full_index timestamp: " + now);
-        } else {
-            Logger::error("[FileIndex] Failed to update timestamp: " + std::string(sqlite3_errmsg(db)));
-        }
-        sqlite3_finalize(stmt);
+    WriteOp op;
+    op.kind = WriteOp::Kind::Meta;
+    op.path = "last_full_index";
+    op.value = now;
+    if (enqueue_write_and_wait(op)) {
+        Logger::info("[FileIndex] Updated last_full_index timestamp: " + now);
+    } else {
+        Logger::error("[FileIndex] Failed to update timestamp");
     }
 }
 
 void FileIndex::update_sync_status(const std::string& remote_path, bool is_synced, const std::string& local_path) {
-    if (!db_) return;
-    
-    sqlite3* db = static_cast<sqlite3*>(db_);
-    
-    const char* sql = "UPDATE files SET is_synced = ?, local_path = ? WHERE path = ?";
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK) {
-        sqlite3_bind_int(stmt, 1, is_synced ? 1 : 0);
-        sqlite3_bind_text(stmt, 2, local_path.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_text(stmt, 3, remote_path.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_step(stmt);
-        sqlite3_finalize(stmt);
-    }
+    if (!is_ready()) return;
+    
+    auto* op = new WriteOp;
+    op->kind = WriteOp::Kind::SyncStatus;
+    op->path = remote_path;
+    op->value = local_path;
+    op->flag = is_synced;
+    enqueue_write(op);
 }
 
 void FileIndex::clear_index() {
-    if (!db_) return;
+    if (!is_ready()) return;
     
-    sqlite3* db = static_cast<sqlite3*>(db_);
-    sqlite3_exec(db, "DELETE FROM files;", nullptr, nullptr, nullptr);
-    sqlite3_exec(db, "UPDATE index_meta SET value = '' WHERE key = 'last_full_index';", nullptr, nullptr, nullptr);
+    auto* clear = new WriteOp;
+    clear->kind = WriteOp::Kind::Exec;
+    clear->path = "DELETE FROM files; DELETE FROM index_meta WHERE key LIKE 'cursor:%';";
+    enqueue_write(clear);
+    
+    WriteOp meta;
+    meta.kind = WriteOp::Kind::Meta;
+    meta.path = "last_full_index";
+    enqueue_write_and_wait(meta);
     
     Logger::info("[FileIndex] Index cleared");
 }
 
 void FileIndex::prune_stale_entries(const std::string& parent_path,
                                      const std::vector<std::string>& paths_seen) {
-    if (!db_ || paths_seen.empty()) return;
-    
-    sqlite3* db = static_cast<sqlite3*>(db_);
-    
-    // Get existing entries for this parent
-    auto existing = get_directory_contents(parent_path);
-    
-    int removed = 0;
-    for (const auto& entry : existing) {
-        bool found = false;
-        for (const auto& seen : paths_seen) {
-            if (entry.path == seen) {
-                found = true;
-                break;
-            }
-        }
-        if (!found) {
-            // This entry is stale - remove it and its children
-            const char* del_sql = "DELETE FROM files WHERE path = ? OR path LIKE ?";
-            sqlite3_stmt* stmt;
-            if (sqlite3_prepare_v2(db, del_sql, -1, &stmt, nullptr) == SQLITE_OK) {
-                sqlite3_bind_text(stmt, 1, entry.path.c_str(), -1, SQLITE_TRANSIENT);
-                std::string prefix = entry.path + "/%";
-                sqlite3_bind_text(stmt, 2, prefix.c_str(), -1, SQLITE_TRANSIENT);
-                sqlite3_step(stmt);
-                sqlite3_finalize(stmt);
-                removed++;
-            }
-        }
-    }
-    
-    if (removed > 0) {
-        Logger::info("[FileIndex] Pruned " + std::to_string(removed) + 
-                     " stale entries from: " + parent_path);
-    }
+    if (!is_ready() || paths_seen.empty()) return;
+    
+    // Diffed against the table by the writer, after any upserts queued before it
+    auto* op = new WriteOp;
+    op->kind = WriteOp::Kind::Prune;
+    op->path = parent_path;
+    op->paths = paths_seen;
+    enqueue_write(op);
 }
 
 // ============================================================================
@@ -1530,209 +2598,64 @@ void FileIndex::add_or_update_file(const std::string& remote_path,
                                     bool is_directory,
                                     bool is_synced,
                                     const std::string& local_path) {
-    if (!db_) return;
-    
-    sqlite3* db = static_cast<sqlite3*>(db_);
+    if (!is_ready()) return;
+    
+    auto* op = new WriteOp;
+    op->kind = WriteOp::Kind::Upsert;
+    IndexedFile& file = op->file;
+    file.name = name;
+    file.path = remote_path;
+    file.size = size;
+    file.mod_time = mod_time;
+    file.is_directory = is_directory;
+    file.is_synced = is_synced;
+    file.local_path = local_path;
     
     // Extract parent path
-    std::string parent_path = "";
     size_t last_slash = remote_path.rfind('/');
     if (last_slash != std::string::npos && last_slash > 0) {
-        parent_path = remote_path.substr(0, last_slash);
+        file.parent_path = remote_path.substr(0, last_slash);
     }
     
-    std::string extension = is_directory ? "" : get_extension(name);
+    file.extension = is_directory ? "" : get_extension(name);
+    enqueue_write(op);
     
-    const char* sql = R"(
-        INSERT OR REPLACE INTO files 
-        (name, path, parent_path, size, mod_time, is_directory, is_synced, local_path, extension, indexed_at)
-        VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, CURRENT_TIMESTAMP)
-    )";
-    
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK) {
-        sqlite3_bind_text(stmt, 1, name.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_text(stmt, 2, remote_path.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_text(stmt, 3, parent_path.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_int64(stmt, 4, size);
-        sqlite3_bind_text(stmt, 5, mod_time.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_int(stmt, 6, is_directory ? 1 : 0);
-        sqlite3_bind_int(stmt, 7, is_synced ? 1 : 0);
-        sqlite3_bind_text(stmt, 8, local_path.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_text(stmt, 9, extension.c_str(), -1, SQLITE_TRANSIENT);
-        
-        if (sqlite3_step(stmt) != SQLITE_DONE) {
-            Logger::warn("[FileIndex] Failed to add/update file: " + remote_path);
-        }
-        sqlite3_finalize(stmt);
-    }
-    
-    // Update partial index timestamp
-    sqlite3_stmt* meta_stmt;
-    const char* meta_sql = "UPDATE index_meta SET value = ? WHERE key = 'last_partial_index'";
-    if (sqlite3_prepare_v2(db, meta_sql, -1, &meta_stmt, nullptr) == SQLITE_OK) {
-        std::string now = get_current_timestamp();
-        sqlite3_bind_text(meta_stmt, 1, now.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_step(meta_stmt);
-        sqlite3_finalize(meta_stmt);
-    }
+    // Update partial index timestamp (coalesced per group by the writer)
+    auto* meta = new WriteOp;
+    meta->kind = WriteOp::Kind::Meta;
+    meta->path = "last_partial_index";
+    meta->value = get_current_timestamp();
+    enqueue_write(meta);
 }
 
 void FileIndex::remove_file(const std::string& remote_path) {
-    if (!db_) return;
+    if (!is_ready()) return;
     
-    sqlite3* db = static_cast<sqlite3*>(db_);
-    
-    const char* sql = "DELETE FROM files WHERE path = ?";
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK) {
-        sqlite3_bind_text(stmt, 1, remote_path.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_step(stmt);
-        sqlite3_finalize(stmt);
-        Logger::debug("[FileIndex] Removed file from index: " + remote_path);
-    }
+    auto* op = new WriteOp;
+    op->kind = WriteOp::Kind::Remove;
+    op->path = remote_path;
+    enqueue_write(op);
 }
 
 void FileIndex::update_files_from_sync(const std::string& job_id,
                                         const std::string& local_path,
                                         const std::string& remote_path) {
-    if (!db_) return;
+    if (!is_ready()) return;
     
     Logger::info("[FileIndex] Updating index from sync job: " + job_id);
     
-    // Ensure valid working directory before popen()
-    ensure_valid_cwd();
-    
-    // Use rclone to get the current state of this remote folder
-    // Use shell quoting instead of double quotes for safe path handling
-    std::string safe_remote = remote_name_ + ":" + remote_path;
-    // Shell-escape using single quotes
-    std::string escaped_remote = "'";
-    for (char c : safe_remote) {
-        if (c == '\'') escaped_remote += "'\"'\"'";
-        else escaped_remote += c;
-    }
-    escaped_remote += "'";
-    std::string cmd = "timeout 60 " + get_rclone_path() + " lsjson --fast-list " + escaped_remote + " 2>/dev/null";
+    std::string root = remote_name_ + ":" + (remote_path.empty() || remote_path[0] != '/' ? "/" : "") + remote_path;
+    while (root.size() > remote_name_.size() + 2 && root.back() == '/') root.pop_back();
     
-    std::array<char, 8192> buffer;
-    std::string json_output;
-    std::unique_ptr<FILE, decltype(&pclose)> pipe(popen(cmd.c_str(), "r"), pclose);
-    
-    if (!pipe) {
+    // Only folders whose ModTime moved since the last pass are re-listed
+    int updated = refresh_changed_folders(root, local_path, 0, 0);
+    if (updated < 0) {
         Logger::warn("[FileIndex] Failed to run rclone for incremental update");
         return;
     }
     
-    while (fgets(buffer.data(), buffer.size(), pipe.get()) != nullptr) {
-        json_output += buffer.data();
-    }
-    
-    if (json_output.empty() || json_output[0] != '[') {
-        Logger::warn("[FileIndex] No JSON output from rclone for: " + remote_path);
-        return;
-    }
-    
-    // Parse JSON using fast manual extractors
-    std::vector<IndexedFile> files;
-    
-    // Fast manual JSON value extractors (same as index_worker)
-    auto extract_str = [](const std::string& obj, const char* key, std::string& out) -> bool {
-        std::string needle = std::string("\"") + key + "\":";
-        size_t pos = obj.find(needle);
-        if (pos == std::string::npos) return false;
-        pos += needle.size();
-        while (pos < obj.size() && (obj[pos] == ' ' || obj[pos] == '\t')) pos++;
-        if (pos >= obj.size() || obj[pos] != '"') return false;
-        pos++;
-        std::string result;
-        while (pos < obj.size() && obj[pos] != '"') {
-            if (obj[pos] == '\\' && pos + 1 < obj.size()) { pos++; result += obj[pos]; }
-            else { result += obj[pos]; }
-            pos++;
-        }
-        out = std::move(result);
-        return true;
-    };
-    
-    auto extract_i64 = [](const std::string& obj, const char* key, int64_t& out) -> bool {
-        std::string needle = std::string("\"") + key + "\":";
-        size_t pos = obj.find(needle);
-        if (pos == std::string::npos) return false;
-        pos += needle.size();
-        while (pos < obj.size() && (obj[pos] == ' ' || obj[pos] == '\t')) pos++;
-        size_t end = pos;
-        if (end < obj.size() && obj[end] == '-') end++;
-        while (end < obj.size() && std::isdigit(static_cast<unsigned char>(obj[end]))) end++;
-        if (end == pos) return false;
-        try { out = std::stoll(obj.substr(pos, end - pos)); return true; }
-        catch (...) { return false; }
-    };
-    
-    auto extract_b = [](const std::string& obj, const char* key) -> bool {
-        std::string needle = std::string("\"") + key + "\":";
-        size_t pos = obj.find(needle);
-        if (pos == std::string::npos) return false;
-        pos += needle.size();
-        while (pos < obj.size() && (obj[pos] == ' ' || obj[pos] == '\t')) pos++;
-        return (pos + 3 < obj.size() && obj.substr(pos, 4) == "true");
-    };
-    
-    // Split by },{ to get individual objects
-    size_t pos = 0;
-    while ((pos = json_output.find('{', pos)) != std::string::npos) {
-        size_t end = json_output.find('}', pos);
-        if (end == std::string::npos) break;
-        
-        std::string obj = json_output.substr(pos, end - pos + 1);
-        
-        IndexedFile file;
-        
-        extract_str(obj, "Name", file.name);
-        std::string rel_path;
-        if (extract_str(obj, "Path", rel_path)) {
-            file.path = remote_path + "/" + rel_path;
-        } else {
-            file.path = remote_path + "/" + file.name;
-        }
-        extract_i64(obj, "Size", file.size);
-        file.is_directory = extract_b(obj, "IsDir");
-        extract_str(obj, "ModTime", file.mod_time);
-        
-        // Build parent path
-        size_t last_slash = file.path.rfind('/');
-        if (last_slash != std::string::npos && last_slash > 0) {
-            file.parent_path = file.path.substr(0, last_slash);
-        }
-        
-        file.extension = file.is_directory ? "" : get_extension(file.name);
-        
-        // This file is synced (it's from a sync job)
-        file.is_synced = true;
-        
-        // Construct local path
-        std::string relative = file.path;
-        if (relative.find(remote_path) == 0) {
-            relative = relative.substr(remote_path.length());
-            if (!relative.empty() && relative[0] == '/') {
-                relative = relative.substr(1);
-            }
-        }
-        file.local_path = local_path + "/" + relative;
-        
-        if (!file.name.empty()) {
-            files.push_back(file);
-        }
-        
-        pos = end + 1;
-    }
-    
-    // Batch insert
-    if (!files.empty()) {
-        insert_files_batch(files);
-        Logger::info("[FileIndex] Updated " + std::to_string(files.size()) + 
-                     " files from sync job: " + job_id);
-    }
+    Logger::info("[FileIndex] Updated " + std::to_string(updated) + 
+                 " files from sync job: " + job_id);
 }
 
 void FileIndex::set_encryption_key(const std::string& key) {
@@ -1744,16 +2667,14 @@ void FileIndex::set_encryption_key(const std::string& key) {
 }
 
 bool FileIndex::needs_refresh(int max_age_hours) const {
-    if (!db_) {
+    if (!is_ready()) {
         Logger::debug("[FileIndex] needs_refresh: db not initialized, returning true");
         return true;
     }
     
-    sqlite3* db = static_cast<sqlite3*>(const_cast<void*>(db_));
-    sqlite3_stmt* stmt;
-    
-    const char* sql = "SELECT value FROM index_meta WHERE key = 'last_full_index'";
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+    ReadLease lease(*this, QueryKind::NeedsRefresh);
+    sqlite3_stmt* stmt = lease.prepare("SELECT value FROM index_meta WHERE key = 'last_full_index'");
+    if (!stmt) {
         Logger::debug("[FileIndex] needs_refresh: failed to query metadata, returning true");
         return true;
     }
@@ -1778,27 +2699,21 @@ bool FileIndex::needs_refresh(int max_age_hours) const {
         Logger::debug("[FileIndex] needs_refresh: no last_full_index metadata found");
     }
     
-    sqlite3_finalize(stmt);
     return needs_refresh;
 }
 
 bool FileIndex::path_exists(const std::string& path) const {
-    if (!db_) return false;
-    
-    sqlite3* db = static_cast<sqlite3*>(const_cast<void*>(db_));
-    sqlite3_stmt* stmt;
+    if (!is_ready()) return false;
+    int known = path_tree_.exists(path);
+    if (known >= 0) return known == 1;
     
-    const char* sql = "SELECT 1 FROM files WHERE path = ? LIMIT 1";
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        return false;
-    }
+    ReadLease lease(*this, QueryKind::PathExists);
+    sqlite3_stmt* stmt = lease.prepare("SELECT 1 FROM files WHERE path = ? LIMIT 1");
+    if (!stmt) return false;
     
     sqlite3_bind_text(stmt, 1, path.c_str(), -1, SQLITE_TRANSIENT);
     
-    bool exists = (sqlite3_step(stmt) == SQLITE_ROW);
-    sqlite3_finalize(stmt);
-    
-    return exists;
+    return sqlite3_step(stmt) == SQLITE_ROW;
 }
 
 void FileIndex::report_progress(int percent, const std::string& status) {
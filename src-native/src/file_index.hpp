@@ -2,12 +2,18 @@
 #define FILE_INDEX_HPP
 
 #include <string>
+#include <string_view>
 #include <vector>
+#include <map>
 #include <functional>
 #include <thread>
 #include <atomic>
 #include <mutex>
+#include <condition_variable>
 #include <chrono>
+#include <array>
+#include <cstdint>
+#include "path_tree.hpp"
 
 /**
  * FileIndex - SQLite-based cache for cloud file metadata
@@ -41,6 +47,45 @@ struct IndexedFile {
     double relevance_score;     // Calculated during search
 };
 
+// The same record with borrowed strings - from an IndexedFile, or from an
+// IndexBatch arena during bulk indexing. Valid only while the owner is.
+struct IndexedFileRef {
+    std::string_view name;
+    std::string_view path;
+    std::string_view parent_path;
+    std::string_view mod_time;
+    std::string_view local_path;
+    std::string_view extension;
+    int64_t size = 0;
+    bool is_directory = false;
+    bool is_synced = false;
+
+    static IndexedFileRef of(const IndexedFile& file) {
+        IndexedFileRef ref;
+        ref.name = file.name;
+        ref.path = file.path;
+        ref.parent_path = file.parent_path;
+        ref.mod_time = file.mod_time;
+        ref.local_path = file.local_path;
+        ref.extension = file.extension;
+        ref.size = file.size;
+        ref.is_directory = file.is_directory;
+        ref.is_synced = file.is_synced;
+        return ref;
+    }
+};
+
+class IndexBatch;
+
+// Per-query latency counters (see FileIndex::get_query_latency_stats)
+struct QueryLatencyStats {
+    std::string query;
+    uint64_t calls;
+    double avg_ms;
+    double max_ms;
+    uint64_t statement_prepares;    // Cache misses - steady state should stop growing
+};
+
 struct IndexStats {
     int64_t total_files;
     int64_t total_folders;
@@ -58,8 +103,14 @@ public:
     
     // Initialize database (call once at startup)
     bool initialize();
+    // True once initialize() finished opening the database; until then
+    // (and after shutdown) queries return empty results
+    bool is_ready() const { return ready_.load(std::memory_order_acquire); }
     
-    // Search files by name or path (uses FTS5 full-text search)
+    // Search files by name or path. Queries of 3+ characters match anywhere
+    // in the name (FTS5 trigram index); word prefixes also match folder
+    // names in the path, and if nothing matches, names within a few typos
+    // of the query are returned instead.
     // query: search terms (supports wildcards: * and ?)
     // limit: max results (0 = no limit)
     // include_folders: whether to include folders in results
@@ -83,9 +134,35 @@ public:
     // Get recently modified files
     std::vector<IndexedFile> get_recent_files(int limit = 50);
     
+    // Recursive file/folder count and size below `folder`, from the in-memory
+    // path tree. False until the tree has loaded or if the folder is unknown.
+    bool get_folder_summary(const std::string& folder, proton::PathTree::Summary& out) const;
+    
+    // Lowercase extension of a file name ("" if none)
+    static std::string get_extension(const std::string& filename);
+    
+    // Folder ModTime recorded the last time `folder`'s children were listed
+    // ("" if never listed, or for the root, whose ModTime is unknown)
+    std::string get_folder_cursor(const std::string& folder);
+    
+    // Replace `folder`'s children with a complete listing (an empty one
+    // clears it) and advance its cursor to `mod_time` if given
+    void store_directory_listing(const std::string& folder,
+                                 const std::vector<IndexedFile>& entries,
+                                 const std::string& mod_time);
+    
+    // Run `rclone lsjson <flags> <target>` and collect its output. Returns
+    // false if the listing could not be started or was cancelled via `stop`
+    // (a failed listing returns true with empty output).
+    static bool fetch_lsjson(const std::string& flags, const std::string& target, int timeout_seconds,
+                             std::string& out, const std::atomic<bool>* stop = nullptr);
+    
     // Get index statistics
     IndexStats get_stats();
     
+    // Cumulative latency of each read query since startup
+    std::vector<QueryLatencyStats> get_query_latency_stats() const;
+    
     // Background indexing
     void start_background_index(bool full_reindex = false);
     void stop_background_index();
@@ -105,7 +182,7 @@ public:
                             const std::string& local_path = "");
     
     // Incremental index updates (called when files are synced)
-    // These avoid the full 5-10 minute reindex
+    // These avoid a full reindex
     void add_or_update_file(const std::string& remote_path,
                             const std::string& name,
                             int64_t size,
@@ -124,6 +201,11 @@ public:
     // Clear the entire index (for troubleshooting)
     void clear_index();
     
+    // Mutations above are queued to a single writer thread and group-committed.
+    // flush() blocks until everything queued before the call is committed, for
+    // callers that need to read back what they just wrote.
+    void flush();
+    
     // Remove index entries that no longer exist in cloud
     // paths_seen: set of full paths (e.g. "proton:/Documents") that were found in a scan
     // parent_path: the parent whose children should be pruned
@@ -143,7 +225,8 @@ public:
     // Key should be derived from user's Proton session or passphrase
     void set_encryption_key(const std::string& key);
     
-    // Graceful shutdown - encrypts database before app exits
+    // Graceful shutdown - checkpoints (and in whole-file mode encrypts) the
+    // database before app exits
     // MUST be called before gtk_main_quit() to avoid crash
     void shutdown();
 
@@ -156,32 +239,92 @@ private:
     FileIndex& operator=(const FileIndex&) = delete;
     
     // Database operations
+    bool open_database();
+    static void move_database_files(const std::string& from, const std::string& to);
+    void migrate_legacy_database(const std::string& legacy_path);
     bool create_tables();
     bool insert_file(const IndexedFile& file);
     bool insert_files_batch(const std::vector<IndexedFile>& files);
+    bool insert_files_batch(const IndexBatch& batch);  // Bound without copies
     void update_last_index_time();
     
     // Indexing worker
     void index_worker(bool full_reindex);
     void index_worker_full(void* db_handle);
+    void index_worker_parallel(void* db_handle);
+    
+    // Change tracking: re-list only folders whose ModTime moved since their
+    // cursor. Returns entries upserted, or -1 if the folder scan failed.
+    int refresh_changed_folders(const std::string& root, const std::string& local_root,
+                                int progress_from, int progress_to, int* changed_count = nullptr);
+    // Without a snapshot, changes are found by walking down from the root
+    // and descending only into folders whose ModTime moved. That relies on
+    // a change bumping each ancestor's ModTime, so the whole folder skeleton
+    // is still compared once every SKELETON_SCAN_HOURS.
+    int walk_changed_folders(const std::string& root, int progress_from, int progress_to,
+                             int* changed_count);
+    bool skeleton_scan_due(const std::string& root) const;
+    static constexpr int SKELETON_SCAN_HOURS = 24;
+    std::map<std::string, std::string> load_folder_cursors(const std::string& prefix) const;
+    void seed_folder_cursors();
     void index_worker_incremental(void* db_handle);
     std::vector<IndexedFile> parse_lsjson_output(const std::string& json, const std::string& base_path);
     std::vector<IndexedFile> fetch_remote_listing(const std::string& path, bool recursive);
     
-    // Helper to get extension from filename
-    static std::string get_extension(const std::string& filename);
-    
     // Report progress
     void report_progress(int percent, const std::string& status);
     
+    // Read pool: read-only WAL connections with per-connection statement caches
+    enum class QueryKind {
+        Search, SearchWithFilters, DirectoryContents, RecentFiles, Stats, NeedsRefresh, PathExists,
+        FolderCursors,
+        Count
+    };
+    struct QueryCounter {
+        std::atomic<uint64_t> calls{0};
+        std::atomic<uint64_t> total_us{0};
+        std::atomic<uint64_t> max_us{0};
+        std::atomic<uint64_t> prepares{0};
+    };
+    struct ReadConnection;
+    class ReadLease;
+    // Trigram-index halves of search(): substring matches ranked by where
+    // the query sits in the name, and the typo-tolerant fallback
+    void search_trigram(ReadLease& lease, const std::string& query, bool include_folders,
+                        size_t wanted, std::vector<IndexedFile>& out);
+    void search_fuzzy(ReadLease& lease, const std::string& query, bool include_folders,
+                      size_t wanted, std::vector<IndexedFile>& out);
+    void open_read_pool();
+    void close_read_pool();
+    ReadConnection* acquire_read_connection() const;
+    void release_read_connection(ReadConnection* conn) const;
+    
+    // Single-writer mutation pipeline
+    struct WriteOp;
+    void start_writer();
+    void stop_writer();
+    void enqueue_write(WriteOp* op);
+    bool enqueue_write_and_wait(WriteOp& op);
+    void writer_loop();
+    void process_pending_writes();
+    
+    // Directory listings and existence checks are served from here once
+    // loaded; the writer replays every committed write into it
+    void load_path_tree(void* db_handle);
+    void mirror_to_path_tree(const WriteOp& op);
+    proton::PathTree path_tree_;
+    
     // Database handle (opaque pointer for SQLite)
     void* db_ = nullptr;
     std::string db_path_;
     
     // Encryption
     bool is_encrypted_ = false;
+    bool page_encryption_ = false;  // opened through crypto::PAGE_VFS_NAME
+    bool trigram_available_ = false;  // files_trigram exists (SQLite 3.34+)
     std::string encryption_key_;
     bool shutdown_complete_ = false;
+    std::atomic<bool> ready_{false};  // Published last, so db_ is never seen half-open
     
     // Indexing state
     std::atomic<bool> is_indexing_{false};
@@ -189,6 +332,23 @@ private:
     std::atomic<int> index_progress_{0};
     std::thread index_thread_;
     
+    // Read pool state
+    mutable std::mutex read_pool_mutex_;
+    mutable std::condition_variable read_pool_cv_;
+    mutable std::vector<ReadConnection*> read_pool_idle_;
+    int read_pool_size_ = 0;
+    mutable std::array<QueryCounter, static_cast<size_t>(QueryKind::Count)> query_counters_;
+    
+    // Writer queue: lock-free MPSC stack, reversed by the writer into FIFO order
+    std::atomic<WriteOp*> write_head_{nullptr};
+    std::atomic<size_t> pending_writes_{0};
+    std::atomic<bool> writer_running_{false};
+    std::thread writer_thread_;
+    std::mutex writer_wake_mutex_;
+    std::condition_variable writer_cv_;
+    bool writer_wake_ = false;
+    std::mutex writer_apply_mutex_;  // Serializes appliers (writer thread or inline fallback)
+    
     // Callback
     std::mutex callback_mutex_;
     ProgressCallback progress_callback_;
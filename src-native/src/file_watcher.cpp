@@ -1,10 +1,16 @@
-// file_watcher.cpp - inotify-based file watcher implementation
-// Uses native Linux inotify API for maximum compatibility
+// file_watcher.cpp - inotify/fanotify file watcher implementation
+// fanotify filesystem marks when permitted, inotify per-directory watches otherwise
 
 #include "file_watcher.hpp"
 #include "logger.hpp"
+#include "trace.hpp"
 
 #include <sys/inotify.h>
+#include <sys/fanotify.h>
+#include <sys/statfs.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <dirent.h>
 #include <sys/stat.h>
@@ -13,6 +19,7 @@
 #include <poll.h>
 #include <csignal>
 #include <atomic>
+#include <algorithm>
 
 // Size of inotify event buffer
 #define EVENT_BUF_LEN (1024 * (sizeof(struct inotify_event) + 256))
@@ -20,12 +27,57 @@
 // Events we care about for sync
 #define WATCH_EVENTS (IN_CREATE | IN_DELETE | IN_MODIFY | IN_MOVED_FROM | IN_MOVED_TO | IN_CLOSE_WRITE)
 
+#ifdef FAN_REPORT_DFID_NAME
+#define HAVE_FANOTIFY_FID 1
+
+// Same events as WATCH_EVENTS. fanotify uses the inotify bit values, so the
+// journaling code below handles both backends with IN_* masks.
+#define FAN_WATCH_EVENTS (FAN_CREATE | FAN_DELETE | FAN_MODIFY | FAN_MOVED_FROM | FAN_MOVED_TO | FAN_CLOSE_WRITE | FAN_ONDIR)
+static_assert(FAN_CREATE == IN_CREATE && FAN_DELETE == IN_DELETE && FAN_MODIFY == IN_MODIFY &&
+              FAN_MOVED_FROM == IN_MOVED_FROM && FAN_MOVED_TO == IN_MOVED_TO &&
+              FAN_CLOSE_WRITE == IN_CLOSE_WRITE && FAN_ONDIR == IN_ISDIR &&
+              FAN_Q_OVERFLOW == IN_Q_OVERFLOW,
+              "fanotify and inotify event bits differ");
+
+// Directory handle cache bound before it is simply dropped
+static constexpr size_t MAX_DIR_HANDLE_CACHE = 8192;
+
+static uint64_t fsid_key(const void* fsid) {
+    uint64_t key = 0;
+    std::memcpy(&key, fsid, sizeof(key));
+    return key;
+}
+#endif
+
+// Collect regular files below `path` (hidden entries skipped, as for watches)
+static void collect_files(const std::string& path, std::vector<std::string>& out) {
+    DIR* dir = opendir(path.c_str());
+    if (!dir) return;
+    
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (entry->d_name[0] == '.') continue;
+        std::string full_path = path + "/" + entry->d_name;
+        struct stat st;
+        if (stat(full_path.c_str(), &st) != 0) continue;
+        if (S_ISDIR(st.st_mode)) {
+            collect_files(full_path, out);
+        } else if (S_ISREG(st.st_mode)) {
+            out.push_back(full_path);
+        }
+    }
+    closedir(dir);
+}
+
 // Global flag for graceful shutdown (set by main signal handler)
 static std::atomic<bool> g_graceful_shutdown_requested{false};
 
 FileWatcher::FileWatcher() 
     : inotify_fd_(-1)
+    , fanotify_fd_(-1)
     , debounce_seconds_(3)
+    , wake_fd_(-1)
+    , timer_fd_(-1)
     , running_(false) {
 }
 
@@ -34,6 +86,15 @@ FileWatcher::~FileWatcher() {
     if (inotify_fd_ >= 0) {
         close(inotify_fd_);
     }
+    if (fanotify_fd_ >= 0) {
+        close(fanotify_fd_);
+    }
+    if (wake_fd_ >= 0) {
+        close(wake_fd_);
+    }
+    if (timer_fd_ >= 0) {
+        close(timer_fd_);
+    }
 }
 
 bool FileWatcher::start() {
@@ -48,31 +109,51 @@ bool FileWatcher::start() {
         return false;
     }
     
+#ifdef HAVE_FANOTIFY_FID
+    // Filesystem-wide marks need CAP_SYS_ADMIN; without it every job uses inotify
+    fanotify_fd_ = fanotify_init(FAN_CLASS_NOTIF | FAN_CLOEXEC | FAN_NONBLOCK | FAN_REPORT_DFID_NAME,
+                                 O_RDONLY | O_LARGEFILE);
+    if (fanotify_fd_ >= 0) {
+        Logger::info("[FileWatcher] fanotify available - jobs use filesystem-wide marks");
+    } else {
+        Logger::debug("[FileWatcher] fanotify unavailable (" + std::string(strerror(errno)) + ") - using inotify");
+    }
+#endif
+    
+    // Debounce deadlines and stop() wake the loop; nothing polls on a timeout
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (wake_fd_ < 0 || timer_fd_ < 0) {
+        Logger::error("[FileWatcher] Failed to create eventfd/timerfd: " + std::string(strerror(errno)));
+        for (int* fd : {&inotify_fd_, &fanotify_fd_, &wake_fd_, &timer_fd_}) {
+            if (*fd >= 0) close(*fd);
+            *fd = -1;
+        }
+        return false;
+    }
+    
     running_.store(true);
     
     try {
         // Start the watcher thread
         watcher_thread_ = std::thread(&FileWatcher::watch_loop, this);
         
-        // Start the debounce thread
-        debounce_thread_ = std::thread(&FileWatcher::debounce_loop, this);
-        
         Logger::info("[FileWatcher] Started file watcher (inotify fd=" + std::to_string(inotify_fd_) + ")");
         return true;
     } catch (const std::system_error& e) {
         Logger::error("[FileWatcher] Failed to create threads: " + std::string(e.what()));
         running_.store(false);
-        if (inotify_fd_ >= 0) {
-            close(inotify_fd_);
-            inotify_fd_ = -1;
+        for (int* fd : {&inotify_fd_, &fanotify_fd_, &wake_fd_, &timer_fd_}) {
+            if (*fd >= 0) close(*fd);
+            *fd = -1;
         }
         return false;
     } catch (const std::exception& e) {
         Logger::error("[FileWatcher] Unexpected exception starting watcher: " + std::string(e.what()));
         running_.store(false);
-        if (inotify_fd_ >= 0) {
-            close(inotify_fd_);
-            inotify_fd_ = -1;
+        for (int* fd : {&inotify_fd_, &fanotify_fd_, &wake_fd_, &timer_fd_}) {
+            if (*fd >= 0) close(*fd);
+            *fd = -1;
         }
         return false;
     }
@@ -85,7 +166,10 @@ void FileWatcher::stop() {
     
     running_.store(false);
     
-    // Wake up the watcher thread by closing the fd
+    // Wake up the watcher thread
+    uint64_t one = 1;
+    [[maybe_unused]] ssize_t woke = write(wake_fd_, &one, sizeof(one));
+    
     if (inotify_fd_ >= 0) {
         // Remove all watches first
         std::lock_guard<std::mutex> lock(mutex_);
@@ -96,19 +180,29 @@ void FileWatcher::stop() {
         job_to_wds_.clear();
         job_to_path_.clear();
         wd_to_path_.clear();
+        
+        // Closing the fanotify group below drops its marks
+        for (const auto& pair : fs_marks_) {
+            close(pair.second.mount_fd);
+        }
+        fs_marks_.clear();
+        fanotify_jobs_.clear();
+        dir_handle_cache_.clear();
     }
     
-    // Wait for threads to finish
+    // Wait for the thread to finish
     if (watcher_thread_.joinable()) {
         watcher_thread_.join();
     }
-    if (debounce_thread_.joinable()) {
-        debounce_thread_.join();
-    }
     
-    if (inotify_fd_ >= 0) {
-        close(inotify_fd_);
-        inotify_fd_ = -1;
+    for (int* fd : {&inotify_fd_, &fanotify_fd_, &wake_fd_, &timer_fd_}) {
+        if (*fd >= 0) close(*fd);
+        *fd = -1;
+    }
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        pending_syncs_.clear();
+        deadlines_ = {};
     }
     
     Logger::info("[FileWatcher] Stopped file watcher");
@@ -126,6 +220,12 @@ bool FileWatcher::add_watch(const std::string& job_id, const std::string& path)
     std::lock_guard<std::mutex> lock(mutex_);
     job_to_path_[job_id] = path;
     
+    // One filesystem mark covers the whole tree: no crawl, no per-directory watches
+    if (fanotify_fd_ >= 0 && add_fanotify_mark(job_id, path)) {
+        Logger::info("[FileWatcher] Added watch for job " + job_id + " (fanotify, filesystem-wide)");
+        return true;
+    }
+    
     // Add recursive watches
     if (!add_watch_recursive(job_id, path)) {
         Logger::error("[FileWatcher] Failed to add watch for job " + job_id + " path: " + path);
@@ -137,7 +237,8 @@ bool FileWatcher::add_watch(const std::string& job_id, const std::string& path)
     return true;
 }
 
-bool FileWatcher::add_watch_recursive(const std::string& job_id, const std::string& path) {
+bool FileWatcher::add_watch_recursive(const std::string& job_id, const std::string& path,
+                                      std::vector<std::string>* found_files) {
     // Add watch for this directory
     int wd = inotify_add_watch(inotify_fd_, path.c_str(), WATCH_EVENTS);
     if (wd < 0) {
@@ -185,7 +286,9 @@ bool FileWatcher::add_watch_recursive(const std::string& job_id, const std::stri
         struct stat st;
         if (stat(full_path.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
             // Recursively watch subdirectories
-            add_watch_recursive(job_id, full_path);
+            add_watch_recursive(job_id, full_path, found_files);
+        } else if (found_files && S_ISREG(st.st_mode)) {
+            found_files->push_back(full_path);
         }
     }
     
@@ -196,6 +299,17 @@ bool FileWatcher::add_watch_recursive(const std::string& job_id, const std::stri
 void FileWatcher::remove_watch(const std::string& job_id) {
     std::lock_guard<std::mutex> lock(mutex_);
     
+    if (fanotify_jobs_.count(job_id) > 0) {
+        remove_fanotify_mark(job_id);
+        job_to_path_.erase(job_id);
+        {
+            std::lock_guard<std::mutex> plock(pending_mutex_);
+            pending_syncs_.erase(job_id);
+        }
+        Logger::info("[FileWatcher] Removed watch for job " + job_id);
+        return;
+    }
+    
     auto it = job_to_wds_.find(job_id);
     if (it == job_to_wds_.end()) {
         return;
@@ -224,7 +338,8 @@ void FileWatcher::remove_watch(const std::string& job_id) {
 
 bool FileWatcher::is_watching(const std::string& job_id) const {
     std::lock_guard<std::mutex> lock(mutex_);
-    return job_to_wds_.find(job_id) != job_to_wds_.end();
+    return job_to_wds_.find(job_id) != job_to_wds_.end() ||
+           fanotify_jobs_.find(job_id) != fanotify_jobs_.end();
 }
 
 void FileWatcher::set_sync_callback(SyncCallback callback) {
@@ -238,6 +353,10 @@ void FileWatcher::set_debounce_delay(int seconds) {
 std::string FileWatcher::get_status(const std::string& job_id) const {
     std::lock_guard<std::mutex> lock(mutex_);
     
+    if (fanotify_jobs_.find(job_id) != fanotify_jobs_.end()) {
+        return "Watching (filesystem-wide)";
+    }
+    
     auto it = job_to_wds_.find(job_id);
     if (it == job_to_wds_.end()) {
         return "Not watching";
@@ -247,17 +366,19 @@ std::string FileWatcher::get_status(const std::string& job_id) const {
 }
 
 void FileWatcher::watch_loop() {
-    char buffer[EVENT_BUF_LEN];
-    
-    Logger::info("[FileWatcher] Watch loop started");
+    Logger::info("[FileWatcher] Watch loop started (debounce: " + std::to_string(debounce_seconds_) + "s)");
     
     while (running_.load()) {
-        // Use poll to wait for events with a timeout
-        struct pollfd pfd;
-        pfd.fd = inotify_fd_;
-        pfd.events = POLLIN;
+        // Sleep until something happens - no timeout (poll ignores fd -1)
+        struct pollfd pfds[4];
+        int fds[4] = { inotify_fd_, fanotify_fd_, timer_fd_, wake_fd_ };
+        for (int i = 0; i < 4; ++i) {
+            pfds[i].fd = fds[i];
+            pfds[i].events = POLLIN;
+            pfds[i].revents = 0;
+        }
         
-        int poll_result = poll(&pfd, 1, 500);  // 500ms timeout
+        int poll_result = poll(pfds, 4, -1);
         
         if (poll_result < 0) {
             if (errno == EINTR) {
@@ -267,45 +388,82 @@ void FileWatcher::watch_loop() {
             break;
         }
         
-        if (poll_result == 0) {
-            // Timeout, no events - just loop and check running_
-            continue;
+        if (pfds[3].revents & POLLIN) {
+            uint64_t value;
+            [[maybe_unused]] ssize_t n = read(wake_fd_, &value, sizeof(value));
+            continue;  // stop() - re-check running_
         }
-        
-        // Read events
-        ssize_t len = read(inotify_fd_, buffer, EVENT_BUF_LEN);
-        if (len < 0) {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                continue;  // No data available
-            }
-            if (errno == EINTR) {
-                continue;  // Interrupted
-            }
-            Logger::error("[FileWatcher] read() error: " + std::string(strerror(errno)));
-            break;
+        if (pfds[1].revents & POLLIN) {
+            proton::TraceSpan span("watcher", "fanotify events");
+            read_fanotify_events();
         }
-        
-        // Process events
-        ssize_t i = 0;
-        while (i < len) {
-            struct inotify_event* event = reinterpret_cast<struct inotify_event*>(buffer + i);
-            
-            if (event->len > 0) {
-                handle_event(event->wd, event->mask, event->name);
-            } else {
-                handle_event(event->wd, event->mask, nullptr);
-            }
-            
-            i += sizeof(struct inotify_event) + event->len;
+        if (pfds[0].revents & POLLIN) {
+            proton::TraceSpan span("watcher", "inotify events");
+            if (!read_inotify_events()) break;
+        }
+        if (pfds[2].revents & POLLIN) {
+            uint64_t expirations;
+            [[maybe_unused]] ssize_t n = read(timer_fd_, &expirations, sizeof(expirations));
+            fire_due_syncs();
         }
     }
     
     Logger::info("[FileWatcher] Watch loop ended");
 }
 
+bool FileWatcher::read_inotify_events() {
+    alignas(struct inotify_event) char buffer[EVENT_BUF_LEN];
+    
+    ssize_t len = read(inotify_fd_, buffer, EVENT_BUF_LEN);
+    if (len < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+            return true;  // No data available / interrupted
+        }
+        Logger::error("[FileWatcher] read() error: " + std::string(strerror(errno)));
+        return false;
+    }
+    
+    // Process events
+    ssize_t i = 0;
+    while (i < len) {
+        struct inotify_event* event = reinterpret_cast<struct inotify_event*>(buffer + i);
+        
+        if (event->len > 0) {
+            handle_event(event->wd, event->mask, event->name);
+        } else {
+            handle_event(event->wd, event->mask, nullptr);
+        }
+        
+        i += sizeof(struct inotify_event) + event->len;
+    }
+    return true;
+}
+
+void FileWatcher::schedule_full_sync_all() {
+    std::vector<std::string> jobs;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& pair : job_to_path_) {
+            jobs.push_back(pair.first);
+        }
+    }
+    Logger::warn("[FileWatcher] Event queue overflow - scheduling full sync for " +
+                 std::to_string(jobs.size()) + " jobs");
+    for (const auto& job : jobs) {
+        schedule_sync(job, {}, false, true);
+    }
+}
+
 void FileWatcher::handle_event(int wd, uint32_t mask, const char* name) {
+    // The kernel dropped events, so no journal is complete any more
+    if (mask & IN_Q_OVERFLOW) {
+        schedule_full_sync_all();
+        return;
+    }
+    
     std::string job_id;
     std::string dir_path;
+    std::string root_path;
     
     {
         std::lock_guard<std::mutex> lock(mutex_);
@@ -319,8 +477,18 @@ void FileWatcher::handle_event(int wd, uint32_t mask, const char* name) {
         if (path_it != wd_to_path_.end()) {
             dir_path = path_it->second;
         }
+        
+        auto root_it = job_to_path_.find(job_id);
+        if (root_it != job_to_path_.end()) {
+            root_path = root_it->second;
+        }
     }
     
+    record_event(job_id, root_path, dir_path, mask, name);
+}
+
+void FileWatcher::record_event(const std::string& job_id, std::string root_path,
+                               const std::string& dir_path, uint32_t mask, const char* name) {
     // Skip temporary files and common editor backup files
     if (name != nullptr) {
         std::string filename(name);
@@ -339,13 +507,19 @@ void FileWatcher::handle_event(int wd, uint32_t mask, const char* name) {
         }
     }
     
-    // If a new directory was created, add a watch for it
-    if ((mask & IN_CREATE) && (mask & IN_ISDIR) && name != nullptr) {
+    // If a new directory was created (or moved in), add a watch for it and
+    // pick up files that landed in it before the watch existed
+    std::vector<std::string> found_files;
+    if ((mask & (IN_CREATE | IN_MOVED_TO)) && (mask & IN_ISDIR) && name != nullptr) {
         std::string new_dir = dir_path + "/" + std::string(name);
-        Logger::debug("[FileWatcher] New directory created: " + new_dir);
+        Logger::debug("[FileWatcher] New directory: " + new_dir);
         
         std::lock_guard<std::mutex> lock(mutex_);
-        add_watch_recursive(job_id, new_dir);
+        if (fanotify_jobs_.count(job_id) > 0) {
+            collect_files(new_dir, found_files);  // already covered by the filesystem mark
+        } else {
+            add_watch_recursive(job_id, new_dir, &found_files);
+        }
     }
     
     // Log the event (debug level to avoid spam)
@@ -361,60 +535,345 @@ void FileWatcher::handle_event(int wd, uint32_t mask, const char* name) {
     std::string filename = name ? name : "(dir)";
     Logger::debug("[FileWatcher] Event: " + event_type + " - " + filename + " (job: " + job_id + ")");
     
+    // Journal the change relative to the job root. MODIFY/CLOSE_WRITE/CREATE
+    // mark a path as existing, DELETE/MOVED_FROM as gone; a rename is simply
+    // the old path gone and the new one existing.
+    while (root_path.size() > 1 && root_path.back() == '/') {
+        root_path.pop_back();
+    }
+    auto relative = [&root_path](const std::string& full) -> std::string {
+        if (root_path.empty() || full.compare(0, root_path.size(), root_path) != 0) {
+            return "";
+        }
+        size_t pos = root_path.size();
+        while (pos < full.size() && full[pos] == '/') ++pos;
+        return full.substr(pos);
+    };
+    
+    bool exists = !(mask & (IN_DELETE | IN_MOVED_FROM));
+    std::vector<std::string> paths;
+    bool full_sync = false;
+    if (name == nullptr) {
+        // Event on a watched directory itself
+        full_sync = true;
+    } else if (mask & IN_ISDIR) {
+        if (!exists) {
+            // A subtree vanished: its children are not reported one by one
+            full_sync = true;
+        } else {
+            for (const auto& file : found_files) {
+                paths.push_back(relative(file));
+            }
+        }
+    } else {
+        paths.push_back(relative(dir_path + "/" + std::string(name)));
+    }
+    
     // Schedule a sync for this job
-    schedule_sync(job_id);
+    schedule_sync(job_id, paths, exists, full_sync);
 }
 
-void FileWatcher::schedule_sync(const std::string& job_id) {
-    std::lock_guard<std::mutex> lock(pending_mutex_);
+#ifdef HAVE_FANOTIFY_FID
+
+bool FileWatcher::add_fanotify_mark(const std::string& job_id, const std::string& path) {
+    struct statfs sfs;
+    if (statfs(path.c_str(), &sfs) != 0) {
+        return false;
+    }
+    uint64_t fsid = fsid_key(&sfs.f_fsid);
     
-    // Update the trigger time (this provides debouncing - we keep pushing it forward)
-    bool is_new = pending_syncs_.find(job_id) == pending_syncs_.end();
-    pending_syncs_[job_id] = std::chrono::steady_clock::now();
+    auto it = fs_marks_.find(fsid);
+    if (it != fs_marks_.end()) {
+        it->second.refs++;
+        fanotify_jobs_[job_id] = fsid;
+        return true;
+    }
     
-    if (is_new) {
-        Logger::debug("[FileWatcher] Scheduled sync for job " + job_id + " (waiting " + std::to_string(debounce_seconds_) + "s)");
+    if (fanotify_mark(fanotify_fd_, FAN_MARK_ADD | FAN_MARK_FILESYSTEM, FAN_WATCH_EVENTS,
+                      AT_FDCWD, path.c_str()) != 0) {
+        // e.g. EXDEV on btrfs subvolumes, ENODEV on filesystems without fsid
+        Logger::debug("[FileWatcher] fanotify mark failed for " + path + ": " +
+                      std::string(strerror(errno)) + " - using inotify");
+        return false;
+    }
+    
+    // Events carry directory handles; make sure we can open them
+    // (open_by_handle_at needs CAP_DAC_READ_SEARCH)
+    int mount_fd = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    bool resolvable = false;
+    if (mount_fd >= 0) {
+        alignas(struct file_handle) char handle_buf[sizeof(struct file_handle) + MAX_HANDLE_SZ];
+        auto* handle = reinterpret_cast<struct file_handle*>(handle_buf);
+        handle->handle_bytes = MAX_HANDLE_SZ;
+        int mount_id = 0;
+        if (name_to_handle_at(AT_FDCWD, path.c_str(), handle, &mount_id, 0) == 0) {
+            int probe = open_by_handle_at(mount_fd, handle, O_PATH);
+            if (probe >= 0) {
+                resolvable = true;
+                close(probe);
+            }
+        }
+    }
+    if (!resolvable) {
+        Logger::debug("[FileWatcher] Cannot resolve file handles on " + path + " - using inotify");
+        fanotify_mark(fanotify_fd_, FAN_MARK_REMOVE | FAN_MARK_FILESYSTEM, FAN_WATCH_EVENTS,
+                      AT_FDCWD, path.c_str());
+        if (mount_fd >= 0) close(mount_fd);
+        return false;
+    }
+    
+    fs_marks_[fsid] = FilesystemMark{mount_fd, 1};
+    fanotify_jobs_[job_id] = fsid;
+    return true;
+}
+
+void FileWatcher::remove_fanotify_mark(const std::string& job_id) {
+    auto job_it = fanotify_jobs_.find(job_id);
+    if (job_it == fanotify_jobs_.end()) {
+        return;
     }
+    
+    auto it = fs_marks_.find(job_it->second);
+    if (it != fs_marks_.end() && --it->second.refs <= 0) {
+        // Remove via the mount fd: the job's own path may be gone by now
+        fanotify_mark(fanotify_fd_, FAN_MARK_REMOVE | FAN_MARK_FILESYSTEM, FAN_WATCH_EVENTS,
+                      it->second.mount_fd, nullptr);
+        close(it->second.mount_fd);
+        fs_marks_.erase(it);
+        dir_handle_cache_.clear();
+    }
+    fanotify_jobs_.erase(job_it);
 }
 
-void FileWatcher::debounce_loop() {
-    Logger::info("[FileWatcher] Debounce loop started (delay: " + std::to_string(debounce_seconds_) + "s)");
+std::string FileWatcher::resolve_dir_handle(uint64_t fsid, const void* handle_ptr) {
+    auto* handle = static_cast<const struct file_handle*>(handle_ptr);
     
-    while (running_.load()) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    std::string key(reinterpret_cast<const char*>(&fsid), sizeof(fsid));
+    key.append(reinterpret_cast<const char*>(&handle->handle_type), sizeof(handle->handle_type));
+    key.append(reinterpret_cast<const char*>(handle->f_handle), handle->handle_bytes);
+    
+    auto cached = dir_handle_cache_.find(key);
+    if (cached != dir_handle_cache_.end()) {
+        return cached->second;
+    }
+    
+    auto mark = fs_marks_.find(fsid);
+    if (mark == fs_marks_.end()) {
+        return "";
+    }
+    
+    int fd = open_by_handle_at(mark->second.mount_fd, const_cast<struct file_handle*>(handle), O_PATH);
+    if (fd < 0) {
+        return "";  // ESTALE: directory already deleted
+    }
+    
+    char link[64];
+    char target[PATH_MAX];
+    snprintf(link, sizeof(link), "/proc/self/fd/%d", fd);
+    ssize_t n = readlink(link, target, sizeof(target) - 1);
+    close(fd);
+    if (n <= 0) {
+        return "";
+    }
+    std::string path(target, static_cast<size_t>(n));
+    
+    if (dir_handle_cache_.size() >= MAX_DIR_HANDLE_CACHE) {
+        dir_handle_cache_.clear();
+    }
+    dir_handle_cache_[key] = path;
+    return path;
+}
+
+void FileWatcher::read_fanotify_events() {
+    alignas(struct fanotify_event_metadata) char buffer[EVENT_BUF_LEN];
+    
+    ssize_t len = read(fanotify_fd_, buffer, sizeof(buffer));
+    if (len <= 0) {
+        return;  // EAGAIN / EINTR - poll again
+    }
+    
+    auto* meta = reinterpret_cast<struct fanotify_event_metadata*>(buffer);
+    for (; FAN_EVENT_OK(meta, len); meta = FAN_EVENT_NEXT(meta, len)) {
+        if (meta->vers != FANOTIFY_METADATA_VERSION) {
+            Logger::error("[FileWatcher] Unexpected fanotify metadata version");
+            break;
+        }
+        if (meta->fd >= 0) {
+            close(meta->fd);  // FID groups report FAN_NOFD, but stay safe
+        }
+        if (meta->mask & FAN_Q_OVERFLOW) {
+            schedule_full_sync_all();
+            continue;
+        }
+        if (meta->event_len <= meta->metadata_len) {
+            continue;
+        }
         
-        auto now = std::chrono::steady_clock::now();
-        std::vector<std::string> ready_jobs;
+        auto* info = reinterpret_cast<struct fanotify_event_info_fid*>(
+            reinterpret_cast<char*>(meta) + meta->metadata_len);
+        if (info->hdr.info_type != FAN_EVENT_INFO_TYPE_DFID_NAME) {
+            continue;  // Event on a directory itself - nothing to journal
+        }
+        auto* handle = reinterpret_cast<struct file_handle*>(info->handle);
+        const char* name = reinterpret_cast<const char*>(handle->f_handle + handle->handle_bytes);
+        uint64_t fsid = fsid_key(&info->fsid);
         
+        std::string job_id;
+        std::string root_path;
+        std::string dir_path;
         {
-            std::lock_guard<std::mutex> lock(pending_mutex_);
+            std::lock_guard<std::mutex> lock(mutex_);
+            dir_path = resolve_dir_handle(fsid, handle);
+            if (dir_path.empty()) {
+                continue;
+            }
+            
+            // Directories were renamed or removed: cached paths may be stale
+            if ((meta->mask & FAN_ONDIR) && (meta->mask & (FAN_MOVED_FROM | FAN_MOVED_TO | FAN_DELETE))) {
+                dir_handle_cache_.clear();
+            }
             
-            for (auto it = pending_syncs_.begin(); it != pending_syncs_.end(); ) {
-                auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - it->second);
-                
-                if (elapsed.count() >= debounce_seconds_) {
-                    // Enough time has passed since the last change, trigger sync
-                    ready_jobs.push_back(it->first);
-                    it = pending_syncs_.erase(it);
-                } else {
-                    ++it;
+            // The mark sees the whole filesystem; keep events under a job root
+            // (deepest root wins for nested jobs)
+            for (const auto& pair : fanotify_jobs_) {
+                std::string root = job_to_path_[pair.first];
+                while (root.size() > 1 && root.back() == '/') root.pop_back();
+                bool inside = dir_path == root ||
+                              (dir_path.compare(0, root.size(), root) == 0 && dir_path[root.size()] == '/');
+                if (inside && root.size() > root_path.size()) {
+                    job_id = pair.first;
+                    root_path = root;
                 }
             }
         }
+        if (job_id.empty()) {
+            continue;
+        }
+        
+        // inotify never watches hidden directories; match that here
+        if (dir_path.find("/.", root_path.size()) != std::string::npos) {
+            continue;
+        }
+        
+        record_event(job_id, root_path, dir_path, static_cast<uint32_t>(meta->mask), name);
+    }
+}
+
+#else
+
+bool FileWatcher::add_fanotify_mark(const std::string&, const std::string&) { return false; }
+void FileWatcher::remove_fanotify_mark(const std::string&) {}
+std::string FileWatcher::resolve_dir_handle(uint64_t, const void*) { return ""; }
+void FileWatcher::read_fanotify_events() {}
+
+#endif
+
+void FileWatcher::schedule_sync(const std::string& job_id, const std::vector<std::string>& paths,
+                                bool exists, bool overflow) {
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    
+    // Update the trigger time (this provides debouncing - we keep pushing it forward)
+    bool is_new = pending_syncs_.find(job_id) == pending_syncs_.end();
+    PendingSync& pending = pending_syncs_[job_id];
+    pending.last_event = std::chrono::steady_clock::now();
+    if (is_new) pending.first_event = pending.last_event;
+    
+    if (!pending.overflow) {
+        pending.overflow = overflow;
+        for (const auto& path : paths) {
+            // --files-from lists are line based
+            if (path.empty() || path.find('\n') != std::string::npos) {
+                pending.overflow = true;
+                break;
+            }
+            pending.paths[path] = exists;
+        }
+        if (pending.paths.size() > MAX_JOURNAL_ENTRIES) {
+            pending.overflow = true;
+        }
+        if (pending.overflow) {
+            Logger::debug("[FileWatcher] Change journal for job " + job_id + " overflowed, will run full sync");
+            pending.paths.clear();
+        }
+    }
+    
+    if (is_new) {
+        // Later events only move last_event; fire_due_syncs() re-queues the
+        // job when its deadline turns out to have moved
+        deadlines_.emplace(pending.last_event + std::chrono::seconds(debounce_seconds_), job_id);
+        arm_timer();
+        Logger::debug("[FileWatcher] Scheduled sync for job " + job_id + " (waiting " + std::to_string(debounce_seconds_) + "s)");
+    }
+}
+
+void FileWatcher::arm_timer() {
+    struct itimerspec spec{};  // all zero disarms
+    if (!deadlines_.empty()) {
+        // steady_clock is CLOCK_MONOTONIC on Linux
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            deadlines_.top().first.time_since_epoch()).count();
+        if (ns <= 0) ns = 1;
+        spec.it_value.tv_sec = static_cast<time_t>(ns / 1000000000);
+        spec.it_value.tv_nsec = static_cast<long>(ns % 1000000000);
+    }
+    if (timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &spec, nullptr) != 0) {
+        Logger::error("[FileWatcher] timerfd_settime failed: " + std::string(strerror(errno)));
+    }
+}
+
+void FileWatcher::fire_due_syncs() {
+    auto now = std::chrono::steady_clock::now();
+    std::vector<std::pair<std::string, ChangeJournal>> ready_jobs;
+    
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
         
-        // Trigger syncs for ready jobs
-        for (const auto& job_id : ready_jobs) {
-            Logger::info("[FileWatcher] Triggering sync for job " + job_id + " (file changes detected)");
+        while (!deadlines_.empty() && deadlines_.top().first <= now) {
+            std::string job_id = deadlines_.top().second;
+            deadlines_.pop();
             
-            if (sync_callback_) {
-                try {
-                    sync_callback_(job_id);
-                } catch (const std::exception& e) {
-                    Logger::error("[FileWatcher] Sync callback error: " + std::string(e.what()));
-                }
+            auto it = pending_syncs_.find(job_id);
+            if (it == pending_syncs_.end()) {
+                continue;  // Watch removed meanwhile
+            }
+            
+            auto deadline = it->second.last_event + std::chrono::seconds(debounce_seconds_);
+            if (deadline > now) {
+                deadlines_.emplace(deadline, job_id);  // Newer events extended it
+                continue;
+            }
+            
+            // Enough time has passed since the last change, trigger sync
+            ChangeJournal journal;
+            journal.overflow = it->second.overflow;
+            journal.since = it->second.first_event;
+            for (const auto& entry : it->second.paths) {
+                (entry.second ? journal.changed : journal.deleted).push_back(entry.first);
             }
+            std::sort(journal.changed.begin(), journal.changed.end());
+            std::sort(journal.deleted.begin(), journal.deleted.end());
+            ready_jobs.emplace_back(job_id, std::move(journal));
+            pending_syncs_.erase(it);
         }
+        
+        arm_timer();
     }
     
-    Logger::info("[FileWatcher] Debounce loop ended");
+    // Trigger syncs for ready jobs
+    for (const auto& [job_id, journal] : ready_jobs) {
+        Logger::info("[FileWatcher] Triggering sync for job " + job_id + " (" +
+                     (journal.overflow ? std::string("full sync")
+                                       : std::to_string(journal.changed.size()) + " changed, " +
+                                         std::to_string(journal.deleted.size()) + " deleted") + ")");
+        
+        if (sync_callback_) {
+            proton::TraceSpan span("watcher", "dispatch sync");
+            span.set_detail(job_id);
+            try {
+                sync_callback_(job_id, journal);
+            } catch (const std::exception& e) {
+                Logger::error("[FileWatcher] Sync callback error: " + std::string(e.what()));
+            }
+        }
+    }
 }
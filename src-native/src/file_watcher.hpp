@@ -1,5 +1,7 @@
-// file_watcher.hpp - inotify-based file watcher for real-time sync
-// Uses native Linux inotify API (kernel 2.6.13+, universally available)
+// file_watcher.hpp - inotify/fanotify file watcher for real-time sync
+// Uses a filesystem-wide fanotify mark per job when the process may create
+// one (CAP_SYS_ADMIN + CAP_DAC_READ_SEARCH, kernel 5.9+), otherwise one
+// inotify watch per directory (kernel 2.6.13+, universally available)
 
 #ifndef FILE_WATCHER_HPP
 #define FILE_WATCHER_HPP
@@ -12,10 +14,25 @@
 #include <atomic>
 #include <mutex>
 #include <chrono>
+#include <vector>
+#include <cstdint>
+#include <queue>
+
+// Paths that changed under one job's root since its last sync trigger.
+// Paths are relative to the job's local root, deduplicated, latest state wins.
+struct ChangeJournal {
+    std::vector<std::string> changed;  // created, modified or moved into the tree
+    std::vector<std::string> deleted;  // removed or moved out of the tree
+    bool overflow = false;             // too many / unrepresentable changes - run a full sync
+    std::chrono::steady_clock::time_point since;  // first event in the window
+};
 
 class FileWatcher {
 public:
-    using SyncCallback = std::function<void(const std::string& job_id)>;
+    using SyncCallback = std::function<void(const std::string& job_id, const ChangeJournal& changes)>;
+    
+    // Journal size per job before it collapses into a full-sync request
+    static constexpr size_t MAX_JOURNAL_ENTRIES = 2000;
     
     FileWatcher();
     ~FileWatcher();
@@ -52,6 +69,23 @@ private:
     // inotify file descriptor
     int inotify_fd_;
     
+    // fanotify group (FAN_REPORT_DFID_NAME), -1 when unavailable
+    int fanotify_fd_;
+    
+    // One filesystem mark per filesystem, shared by the jobs on it.
+    // mount_fd is any directory on that filesystem, used to open handles.
+    struct FilesystemMark {
+        int mount_fd;
+        int refs;
+    };
+    std::unordered_map<uint64_t, FilesystemMark> fs_marks_;  // keyed by fsid
+    
+    // Jobs watched through fanotify -> fsid of their filesystem
+    std::unordered_map<std::string, uint64_t> fanotify_jobs_;
+    
+    // Directory handle -> path, so busy directories are resolved once
+    std::unordered_map<std::string, std::string> dir_handle_cache_;
+    
     // Map from watch descriptor to job_id
     std::unordered_map<int, std::string> wd_to_job_;
     
@@ -64,8 +98,20 @@ private:
     // Map from watch descriptor to path (for recursive watching)
     std::unordered_map<int, std::string> wd_to_path_;
     
-    // Pending syncs with their trigger times (for debouncing)
-    std::unordered_map<std::string, std::chrono::steady_clock::time_point> pending_syncs_;
+    // Pending sync for one job: last event time (for debouncing) plus the
+    // journal of relative paths seen since the last trigger
+    struct PendingSync {
+        std::chrono::steady_clock::time_point first_event;
+        std::chrono::steady_clock::time_point last_event;
+        std::unordered_map<std::string, bool> paths;  // relative path -> still exists
+        bool overflow = false;
+    };
+    std::unordered_map<std::string, PendingSync> pending_syncs_;
+    
+    // Min-heap of debounce deadlines, one entry per pending job. Entries are
+    // re-checked when they fire: a job that saw newer events is pushed back.
+    using Deadline = std::pair<std::chrono::steady_clock::time_point, std::string>;
+    std::priority_queue<Deadline, std::vector<Deadline>, std::greater<Deadline>> deadlines_;
     
     // Callback to trigger sync
     SyncCallback sync_callback_;
@@ -73,27 +119,57 @@ private:
     // Debounce delay
     int debounce_seconds_;
     
-    // Thread management
+    // Thread management: one thread, asleep in poll() until an event, the
+    // next debounce deadline (timer_fd_) or stop() (wake_fd_)
     std::thread watcher_thread_;
-    std::thread debounce_thread_;
+    int wake_fd_;
+    int timer_fd_;
     std::atomic<bool> running_;
     mutable std::mutex mutex_;
     std::mutex pending_mutex_;
     
-    // Add recursive watches for a directory
-    bool add_watch_recursive(const std::string& job_id, const std::string& path);
+    // Add recursive watches for a directory. Regular files found on the way
+    // are appended to `found_files` (if given) as full paths.
+    bool add_watch_recursive(const std::string& job_id, const std::string& path,
+                             std::vector<std::string>* found_files = nullptr);
     
     // Main watcher loop
     void watch_loop();
     
-    // Debounce loop - checks pending syncs and triggers them
-    void debounce_loop();
+    // Drain the inotify queue; false on a fatal read error
+    bool read_inotify_events();
+    
+    // Trigger syncs whose debounce deadline has passed
+    void fire_due_syncs();
+    
+    // Point timer_fd_ at the earliest deadline, or disarm it (pending_mutex_ held)
+    void arm_timer();
     
     // Handle an inotify event
     void handle_event(int wd, uint32_t mask, const char* name);
     
-    // Schedule a sync for a job (with debouncing)
-    void schedule_sync(const std::string& job_id);
+    // fanotify backend: place/drop a filesystem mark (mutex_ held)
+    bool add_fanotify_mark(const std::string& job_id, const std::string& path);
+    void remove_fanotify_mark(const std::string& job_id);
+    
+    // Drain the fanotify queue and dispatch events to the owning job
+    void read_fanotify_events();
+    
+    // Map a directory file handle back to its current path (mutex_ held)
+    std::string resolve_dir_handle(uint64_t fsid, const void* handle);
+    
+    // Journal one event for a job; `name` is the entry inside `dir_path`
+    void record_event(const std::string& job_id, std::string root_path,
+                      const std::string& dir_path, uint32_t mask, const char* name);
+    
+    // Events were lost: every job needs a full sync
+    void schedule_full_sync_all();
+    
+    // Schedule a sync for a job (with debouncing), journaling `paths`
+    // (relative to the job root) as existing or deleted. A job-wide change
+    // (`overflow`) turns the journal into a full-sync request.
+    void schedule_sync(const std::string& job_id, const std::vector<std::string>& paths,
+                       bool exists, bool overflow = false);
 };
 
 #endif // FILE_WATCHER_HPP
@@ -0,0 +1,246 @@
+// hash_service.cpp - Parallel local file hashing with a persistent cache
+
+#include "hash_service.hpp"
+#include "logger.hpp"
+#include <sqlite3.h>
+#include <openssl/evp.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <system_error>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace proton {
+
+namespace {
+
+constexpr size_t READ_CHUNK = 1024 * 1024;
+
+std::string to_hex(const unsigned char* digest, unsigned int len) {
+    static const char* hex = "0123456789abcdef";
+    std::string out;
+    out.reserve(len * 2);
+    for (unsigned int i = 0; i < len; ++i) {
+        out += hex[digest[i] >> 4];
+        out += hex[digest[i] & 0x0f];
+    }
+    return out;
+}
+
+std::string cache_path() {
+    const char* home = std::getenv("HOME");
+    return std::string(home ? home : "/tmp") + "/.cache/proton-drive/hash-cache.db";
+}
+
+} // namespace
+
+HashService& HashService::getInstance() {
+    static HashService instance;
+    return instance;
+}
+
+HashService::~HashService() {
+    if (db_) sqlite3_close(db_);
+}
+
+bool HashService::stat_key(const std::string& path, FileKey& key) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) return false;
+    key.dev = static_cast<uint64_t>(st.st_dev);
+    key.inode = static_cast<uint64_t>(st.st_ino);
+    key.size = static_cast<int64_t>(st.st_size);
+    key.mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+    return true;
+}
+
+std::string HashService::compute(const std::string& path, const std::atomic<bool>* cancel) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return "";
+    // Read-ahead for the whole file, and don't let a big batch evict the
+    // page cache of everything else once we are done with it
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> ctx(EVP_MD_CTX_new(), EVP_MD_CTX_free);
+    bool ok = ctx && EVP_DigestInit_ex(ctx.get(), EVP_sha1(), nullptr) == 1;
+
+    std::vector<unsigned char> buffer(READ_CHUNK);
+    while (ok) {
+        if (cancel && cancel->load()) {
+            ok = false;
+            break;
+        }
+        ssize_t n = ::read(fd, buffer.data(), buffer.size());
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) ok = false;
+        if (n <= 0) break;
+        EVP_DigestUpdate(ctx.get(), buffer.data(), static_cast<size_t>(n));
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd);
+    if (!ok) return "";
+
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int len = 0;
+    EVP_DigestFinal_ex(ctx.get(), digest, &len);
+    return to_hex(digest, len);
+}
+
+sqlite3* HashService::cache() {
+    if (db_ || db_failed_) return db_;
+
+    std::string path = cache_path();
+    std::error_code ec;
+    fs::create_directories(fs::path(path).parent_path(), ec);
+
+    if (sqlite3_open_v2(path.c_str(), &db_, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr) != SQLITE_OK) {
+        Logger::warn("[Hash] Cache unavailable (" + path + "), hashing without it");
+        sqlite3_close(db_);
+        db_ = nullptr;
+        db_failed_ = true;
+        return nullptr;
+    }
+    fs::permissions(path, fs::perms::owner_read | fs::perms::owner_write, fs::perm_options::replace, ec);
+
+    sqlite3_busy_timeout(db_, 2000);
+    sqlite3_exec(db_, "PRAGMA journal_mode=WAL;", nullptr, nullptr, nullptr);
+    sqlite3_exec(db_, "PRAGMA synchronous=NORMAL;", nullptr, nullptr, nullptr);
+    sqlite3_exec(db_,
+        "CREATE TABLE IF NOT EXISTS hashes ("
+        "  dev INTEGER NOT NULL,"
+        "  inode INTEGER NOT NULL,"
+        "  size INTEGER NOT NULL,"
+        "  mtime_ns INTEGER NOT NULL,"
+        "  sha1 TEXT NOT NULL,"
+        "  PRIMARY KEY (dev, inode)"
+        ") WITHOUT ROWID;",
+        nullptr, nullptr, nullptr);
+    return db_;
+}
+
+std::string HashService::lookup(const FileKey& key) {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    sqlite3* db = cache();
+    if (!db) return "";
+
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "SELECT sha1 FROM hashes WHERE dev = ? AND inode = ? AND size = ? AND mtime_ns = ?",
+                           -1, &stmt, nullptr) != SQLITE_OK) {
+        return "";
+    }
+    sqlite3_bind_int64(stmt, 1, static_cast<int64_t>(key.dev));
+    sqlite3_bind_int64(stmt, 2, static_cast<int64_t>(key.inode));
+    sqlite3_bind_int64(stmt, 3, key.size);
+    sqlite3_bind_int64(stmt, 4, key.mtime_ns);
+    std::string hash;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        const unsigned char* text = sqlite3_column_text(stmt, 0);
+        if (text) hash = reinterpret_cast<const char*>(text);
+    }
+    sqlite3_finalize(stmt);
+    return hash;
+}
+
+void HashService::store(const std::vector<std::pair<FileKey, std::string>>& results) {
+    if (results.empty()) return;
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    sqlite3* db = cache();
+    if (!db) return;
+
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "INSERT OR REPLACE INTO hashes (dev, inode, size, mtime_ns, sha1) VALUES (?, ?, ?, ?, ?)",
+                           -1, &stmt, nullptr) != SQLITE_OK) {
+        return;
+    }
+    sqlite3_exec(db, "BEGIN;", nullptr, nullptr, nullptr);
+    for (const auto& [key, hash] : results) {
+        sqlite3_bind_int64(stmt, 1, static_cast<int64_t>(key.dev));
+        sqlite3_bind_int64(stmt, 2, static_cast<int64_t>(key.inode));
+        sqlite3_bind_int64(stmt, 3, key.size);
+        sqlite3_bind_int64(stmt, 4, key.mtime_ns);
+        sqlite3_bind_text(stmt, 5, hash.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+    }
+    sqlite3_finalize(stmt);
+    if (sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+    }
+}
+
+std::string HashService::cached_hash(const std::string& path) {
+    FileKey key;
+    if (!stat_key(path, key)) return "";
+    return lookup(key);
+}
+
+std::string HashService::hash_file(const std::string& path) {
+    return hash_files({path}).front();
+}
+
+std::vector<std::string> HashService::hash_files(const std::vector<std::string>& paths,
+                                                 const std::atomic<bool>* cancel) {
+    std::vector<std::string> results(paths.size());
+    std::vector<FileKey> keys(paths.size());
+    std::vector<size_t> pending;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (!stat_key(paths[i], keys[i])) continue;
+        results[i] = lookup(keys[i]);
+        if (results[i].empty()) pending.push_back(i);
+    }
+    if (pending.empty()) return results;
+
+    // Largest first, so the long tail is small files spread over all workers
+    std::sort(pending.begin(), pending.end(), [&](size_t a, size_t b) { return keys[a].size > keys[b].size; });
+
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t n; (n = next.fetch_add(1)) < pending.size();) {
+            if (cancel && cancel->load()) return;
+            size_t i = pending[n];
+            results[i] = compute(paths[i], cancel);
+        }
+    };
+
+    unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+    size_t worker_count = std::min<size_t>({pending.size(), static_cast<size_t>(MAX_WORKERS), hw});
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < worker_count; ++t) {
+        try {
+            threads.emplace_back(worker);
+        } catch (const std::system_error& e) {
+            Logger::warn("[Hash] Failed to start hash worker: " + std::string(e.what()));
+            break;
+        }
+    }
+    worker();  // The caller's thread takes a share too
+    for (auto& thread : threads) thread.join();
+
+    // Only cache results for files that did not change while being read
+    std::vector<std::pair<FileKey, std::string>> fresh;
+    for (size_t i : pending) {
+        FileKey after;
+        if (results[i].empty() || !stat_key(paths[i], after)) continue;
+        if (after.size != keys[i].size || after.mtime_ns != keys[i].mtime_ns || after.inode != keys[i].inode) {
+            results[i].clear();
+            continue;
+        }
+        fresh.emplace_back(keys[i], results[i]);
+    }
+    store(fresh);
+
+    if (pending.size() > 1) {
+        Logger::debug("[Hash] Hashed " + std::to_string(fresh.size()) + "/" + std::to_string(pending.size()) +
+                      " file(s) on " + std::to_string(threads.size() + 1) + " thread(s), " +
+                      std::to_string(paths.size() - pending.size()) + " from cache");
+    }
+    return results;
+}
+
+} // namespace proton
@@ -0,0 +1,69 @@
+// hash_service.hpp - Parallel local file hashing with a persistent cache
+// Hashes are SHA-1, the Proton Drive backend's native hash, so a local
+// result compares directly with `rclone hashsum sha1` / `lsjson --hash`.
+// Batches are spread over a few worker threads that pull files largest
+// first (one slow file never holds up the rest); reads are large,
+// sequential and hinted to the kernel with posix_fadvise, and the digest is
+// OpenSSL's, which picks SHA-NI/AVX2/NEON kernels at runtime. Results are
+// cached on disk keyed by (device, inode, size, mtime), so unchanged files
+// are never read twice.
+
+#ifndef HASH_SERVICE_HPP
+#define HASH_SERVICE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct sqlite3;
+
+namespace proton {
+
+class HashService {
+public:
+    static HashService& getInstance();
+
+    // SHA-1 (lowercase hex) of one file, "" if it cannot be read
+    std::string hash_file(const std::string& path);
+
+    // Hash many files; results line up with `paths` ("" for unreadable or
+    // cancelled entries)
+    std::vector<std::string> hash_files(const std::vector<std::string>& paths,
+                                        const std::atomic<bool>* cancel = nullptr);
+
+    // Cached hash if the file is unchanged since it was hashed, else ""
+    std::string cached_hash(const std::string& path);
+
+    static constexpr int MAX_WORKERS = 4;
+
+private:
+    HashService() = default;
+    ~HashService();
+
+    HashService(const HashService&) = delete;
+    HashService& operator=(const HashService&) = delete;
+
+    struct FileKey {
+        uint64_t dev = 0;
+        uint64_t inode = 0;
+        int64_t size = 0;
+        int64_t mtime_ns = 0;
+    };
+
+    static bool stat_key(const std::string& path, FileKey& key);
+    static std::string compute(const std::string& path, const std::atomic<bool>* cancel);
+
+    sqlite3* cache();  // cache_mutex_ held
+    std::string lookup(const FileKey& key);
+    void store(const std::vector<std::pair<FileKey, std::string>>& results);
+
+    std::mutex cache_mutex_;
+    sqlite3* db_ = nullptr;
+    bool db_failed_ = false;
+};
+
+} // namespace proton
+
+#endif // HASH_SERVICE_HPP
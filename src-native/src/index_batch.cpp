@@ -0,0 +1,49 @@
+// index_batch.cpp - Arena-backed batch of index records
+
+#include "index_batch.hpp"
+#include <algorithm>
+#include <cstring>
+
+IndexBatch::IndexBatch(size_t expected_records) {
+    records_.reserve(expected_records);
+}
+
+std::string_view IndexBatch::store(std::string_view text) {
+    if (text.empty()) return {};
+
+    // Move on to the next block that fits; oversized strings get their own
+    while (block_ < blocks_.size() && used_ + text.size() > blocks_[block_].size) {
+        block_++;
+        used_ = 0;
+    }
+    if (block_ == blocks_.size()) {
+        size_t size = std::max(BLOCK_SIZE, text.size());
+        blocks_.push_back({std::make_unique<char[]>(size), size});
+        used_ = 0;
+    }
+
+    char* dest = blocks_[block_].data.get() + used_;
+    std::memcpy(dest, text.data(), text.size());
+    used_ += text.size();
+    return std::string_view(dest, text.size());
+}
+
+void IndexBatch::add(const IndexedFile& file) {
+    IndexedFileRef ref;
+    ref.name = store(file.name);
+    ref.path = store(file.path);
+    ref.parent_path = store(file.parent_path);
+    ref.mod_time = store(file.mod_time);
+    ref.local_path = store(file.local_path);
+    ref.extension = store(file.extension);
+    ref.size = file.size;
+    ref.is_directory = file.is_directory;
+    ref.is_synced = file.is_synced;
+    records_.push_back(ref);
+}
+
+void IndexBatch::clear() {
+    records_.clear();
+    block_ = 0;
+    used_ = 0;
+}
@@ -0,0 +1,53 @@
+// index_batch.hpp - Arena-backed batch of index records
+// A full crawl writes a million-plus rows in batches of 500. Kept as
+// std::vector<IndexedFile>, every record owned six heap strings, freed after
+// each batch and copied once more by SQLITE_TRANSIENT binds. IndexBatch
+// instead copies each record's strings into a few large blocks and keeps
+// IndexedFileRef views into them. clear() rewinds the blocks without freeing
+// them, so a batch reused across a crawl allocates only while it grows to
+// its largest size. The writer binds the views with SQLITE_STATIC.
+
+#ifndef INDEX_BATCH_HPP
+#define INDEX_BATCH_HPP
+
+#include "file_index.hpp"
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+class IndexBatch {
+public:
+    explicit IndexBatch(size_t expected_records = 500);
+
+    IndexBatch(IndexBatch&&) noexcept = default;
+    IndexBatch& operator=(IndexBatch&&) noexcept = default;
+    IndexBatch(const IndexBatch&) = delete;
+    IndexBatch& operator=(const IndexBatch&) = delete;
+
+    // Copy the record's strings into the arena
+    void add(const IndexedFile& file);
+
+    const std::vector<IndexedFileRef>& records() const { return records_; }
+    size_t size() const { return records_.size(); }
+    bool empty() const { return records_.empty(); }
+
+    // Drop the records; blocks are kept for the next batch
+    void clear();
+
+private:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+    std::string_view store(std::string_view text);
+
+    struct Block {
+        std::unique_ptr<char[]> data;
+        size_t size;
+    };
+    std::vector<Block> blocks_;  // Never reallocated in place: views stay valid
+    size_t block_ = 0;           // Block being filled
+    size_t used_ = 0;            // Bytes used in it
+    std::vector<IndexedFileRef> records_;
+};
+
+#endif // INDEX_BATCH_HPP
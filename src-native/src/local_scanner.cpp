@@ -0,0 +1,323 @@
+// local_scanner.cpp - Parallel walk of a local directory tree
+
+#include "local_scanner.hpp"
+#include "logger.hpp"
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <system_error>
+#include <thread>
+
+namespace proton {
+
+namespace {
+
+constexpr size_t DIRENT_BUFFER = 256 * 1024;
+constexpr size_t BATCH_MAX = 4096;         // Entries handed to the visitor at once
+constexpr int64_t REPORT_INTERVAL_MS = 100;
+
+// Record layout returned by getdents64
+struct Dirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[1];
+};
+
+int64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Errors that only mean "skip this directory", like
+// directory_options::skip_permission_denied plus entries removed mid-walk
+bool benign_errno(int err) {
+    return err == EACCES || err == EPERM || err == ENOENT || err == ENOTDIR || err == ELOOP;
+}
+
+// lstat() of `name` inside the open directory `dir_fd`
+bool stat_at(int dir_fd, const char* name, ScannedEntry& out, mode_t& mode) {
+#ifdef STATX_BASIC_STATS
+    struct statx stx;
+    if (statx(dir_fd, name, AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT | AT_STATX_DONT_SYNC,
+              STATX_TYPE | STATX_INO | STATX_SIZE | STATX_MTIME, &stx) != 0) {
+        return false;
+    }
+    mode = stx.stx_mode;
+    out.inode = stx.stx_ino;
+    out.size = static_cast<int64_t>(stx.stx_size);
+    out.mtime_ns = static_cast<int64_t>(stx.stx_mtime.tv_sec) * 1000000000LL + stx.stx_mtime.tv_nsec;
+#else
+    struct stat st;
+    if (fstatat(dir_fd, name, &st, AT_SYMLINK_NOFOLLOW) != 0) return false;
+    mode = st.st_mode;
+    out.inode = static_cast<uint64_t>(st.st_ino);
+    out.size = static_cast<int64_t>(st.st_size);
+    out.mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+#endif
+    return true;
+}
+
+class Walk {
+public:
+    Walk(const std::string& root, const LocalScanOptions& options, const LocalScanner::Visitor& visit)
+        : root_(root), options_(options), visit_(visit) {
+        while (root_.size() > 1 && root_.back() == '/') root_.pop_back();
+    }
+
+    bool run(LocalScanProgress* totals) {
+        unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+        size_t worker_count = std::min<size_t>(hw, LocalScanner::MAX_WORKERS);
+        for (size_t i = 0; i < worker_count; ++i) queues_.push_back(std::make_unique<Queue>());
+        push(0, "");
+
+        std::vector<std::thread> threads;
+        for (size_t t = 1; t < worker_count; ++t) {
+            try {
+                threads.emplace_back(&Walk::worker, this, t);
+            } catch (const std::system_error& e) {
+                Logger::warn("[LocalScanner] Failed to start scan worker: " + std::string(e.what()));
+                break;
+            }
+        }
+        worker(0);  // The caller's thread takes a share too
+        for (auto& thread : threads) thread.join();
+
+        LocalScanProgress done = snapshot();
+        if (options_.progress) options_.progress(done);
+        if (totals) *totals = done;
+        return !failed_.load() && !cancelled();
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::string> dirs;   // Relative paths
+    };
+
+    bool cancelled() const { return options_.cancel && options_.cancel->load(); }
+
+    LocalScanProgress snapshot() const {
+        LocalScanProgress progress;
+        progress.dirs = dirs_.load();
+        progress.files = files_.load();
+        progress.bytes = bytes_.load();
+        return progress;
+    }
+
+    void push(size_t id, std::string rel) {
+        pending_.fetch_add(1);
+        {
+            std::lock_guard<std::mutex> lock(queues_[id]->mutex);
+            queues_[id]->dirs.push_back(std::move(rel));
+        }
+        idle_cv_.notify_one();
+    }
+
+    // Own queue newest first (depth-first keeps it short), then steal the
+    // oldest (largest remaining subtrees) from the others
+    bool next_dir(size_t id, std::string& out) {
+        {
+            std::lock_guard<std::mutex> lock(queues_[id]->mutex);
+            auto& dirs = queues_[id]->dirs;
+            if (!dirs.empty()) {
+                out = std::move(dirs.back());
+                dirs.pop_back();
+                return true;
+            }
+        }
+        for (size_t n = 1; n < queues_.size(); ++n) {
+            auto& victim = *queues_[(id + n) % queues_.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.dirs.empty()) {
+                out = std::move(victim.dirs.front());
+                victim.dirs.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void worker(size_t id) {
+        std::vector<char> buffer(DIRENT_BUFFER);
+        std::string rel;
+        while (!cancelled()) {
+            if (next_dir(id, rel)) {
+                read_dir(id, rel, buffer);
+                if (pending_.fetch_sub(1) == 1) {
+                    std::lock_guard<std::mutex> lock(idle_mutex_);
+                    idle_cv_.notify_all();
+                }
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(idle_mutex_);
+            if (pending_.load() == 0) return;
+            idle_cv_.wait_for(lock, std::chrono::milliseconds(2));
+        }
+    }
+
+    void read_dir(size_t id, const std::string& rel, std::vector<char>& buffer) {
+        std::string dir_path = rel.empty() ? root_ : (root_ == "/" ? "" : root_) + "/" + rel;
+        // The root itself may be a symlink to the synced folder
+        int flags = O_RDONLY | O_DIRECTORY | O_CLOEXEC | (rel.empty() ? 0 : O_NOFOLLOW);
+        int fd = open(dir_path.c_str(), flags);
+        if (fd < 0) {
+            int err = errno;
+            if (rel.empty() || !benign_errno(err)) {
+                Logger::warn("[LocalScanner] Cannot read " + dir_path + ": " + std::strerror(err));
+                failed_ = true;
+            }
+            return;
+        }
+        dirs_.fetch_add(1);
+
+        std::vector<ScannedEntry> batch;
+        while (!cancelled()) {
+            long n = syscall(SYS_getdents64, fd, buffer.data(), buffer.size());
+            if (n < 0) {
+                if (!benign_errno(errno)) failed_ = true;
+                break;
+            }
+            if (n == 0) break;
+            for (long pos = 0; pos < n;) {
+                const auto* d = reinterpret_cast<const Dirent64*>(buffer.data() + pos);
+                pos += d->d_reclen;
+                const char* name = d->d_name;
+                if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) continue;
+
+                ScannedEntry entry;
+                entry.inode = d->d_ino;
+                bool is_dir = d->d_type == DT_DIR;
+                bool is_reg = d->d_type == DT_REG;
+                bool wanted = is_reg || (is_dir && options_.include_dirs) || (!is_dir && !options_.regular_only);
+                if (d->d_type == DT_UNKNOWN || (options_.stat_files && wanted)) {
+                    mode_t mode = 0;
+                    if (!stat_at(fd, name, entry, mode)) continue;  // Removed since the listing
+                    is_dir = S_ISDIR(mode);
+                    is_reg = S_ISREG(mode);
+                }
+
+                std::string child = rel.empty() ? std::string(name) : rel + '/' + name;
+                if (is_dir) {
+                    if (options_.include_dirs) {
+                        entry.path = child;
+                        entry.is_dir = true;
+                        batch.push_back(std::move(entry));
+                    }
+                    push(id, std::move(child));
+                } else if (is_reg || !options_.regular_only) {
+                    files_.fetch_add(1);
+                    if (is_reg) bytes_.fetch_add(entry.size);
+                    entry.path = std::move(child);
+                    batch.push_back(std::move(entry));
+                }
+                if (batch.size() >= BATCH_MAX) {
+                    if (visit_) visit_(batch);
+                    batch.clear();
+                }
+            }
+        }
+        close(fd);
+
+        if (!batch.empty() && visit_) visit_(batch);
+        report();
+    }
+
+    void report() {
+        if (!options_.progress) return;
+        int64_t now = now_ms();
+        int64_t last = last_report_ms_.load();
+        if (now - last < REPORT_INTERVAL_MS || !last_report_ms_.compare_exchange_strong(last, now)) return;
+        std::unique_lock<std::mutex> lock(report_mutex_, std::try_to_lock);
+        if (lock.owns_lock()) options_.progress(snapshot());
+    }
+
+    std::string root_;
+    const LocalScanOptions& options_;
+    const LocalScanner::Visitor& visit_;
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::atomic<size_t> pending_{0};    // Directories queued or being read
+    std::mutex idle_mutex_;
+    std::condition_variable idle_cv_;
+    std::atomic<bool> failed_{false};
+
+    std::atomic<uint64_t> dirs_{0};
+    std::atomic<uint64_t> files_{0};
+    std::atomic<int64_t> bytes_{0};
+    std::atomic<int64_t> last_report_ms_{0};
+    std::mutex report_mutex_;
+};
+
+} // namespace
+
+bool LocalScanner::scan(const std::string& root, const LocalScanOptions& options, const Visitor& visit,
+                        LocalScanProgress* totals) {
+    auto start = std::chrono::steady_clock::now();
+    Walk walk(root, options, visit);
+    LocalScanProgress done;
+    bool ok = walk.run(&done);
+    if (totals) *totals = done;
+
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    if (ms >= 1000) {
+        Logger::debug("[LocalScanner] Scanned " + root + ": " + std::to_string(done.files) + " file(s) in " +
+                      std::to_string(done.dirs) + " folder(s), " + std::to_string(ms) + " ms");
+    }
+    return ok;
+}
+
+int64_t LocalScanner::total_bytes(const std::string& root, const std::atomic<bool>* cancel) {
+    LocalScanOptions options;
+    options.cancel = cancel;
+    LocalScanProgress totals;
+    scan(root, options, Visitor(), &totals);
+    return totals.bytes;
+}
+
+std::vector<ScannedEntry> LocalScanner::largest_files(const std::string& root, size_t limit,
+                                                      const LocalScanOptions& options) {
+    auto smaller = [](const ScannedEntry& a, const ScannedEntry& b) { return a.size > b.size; };
+    // Min-heap of the largest seen so far; its top is the entry to beat
+    std::priority_queue<ScannedEntry, std::vector<ScannedEntry>, decltype(smaller)> top(smaller);
+    std::mutex mutex;
+
+    LocalScanOptions files_only = options;
+    files_only.include_dirs = false;
+    files_only.regular_only = true;
+    files_only.stat_files = true;
+    scan(root, files_only, [&](std::vector<ScannedEntry>& batch) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& entry : batch) {
+            if (entry.size <= 0 || limit == 0) continue;
+            if (top.size() >= limit) {
+                if (entry.size <= top.top().size) continue;
+                top.pop();
+            }
+            top.push(std::move(entry));
+        }
+    });
+
+    std::vector<ScannedEntry> result;
+    result.reserve(top.size());
+    while (!top.empty()) {
+        result.push_back(top.top());
+        top.pop();
+    }
+    std::reverse(result.begin(), result.end());
+    return result;
+}
+
+} // namespace proton
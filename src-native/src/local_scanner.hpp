@@ -0,0 +1,69 @@
+// local_scanner.hpp - Parallel walk of a local directory tree
+// One shared scanner for everything that needs to look at a whole local
+// tree (cleanup dialog, trash sizes, local state baselines, conflict
+// scans). Directories are spread over a few worker threads, each with its
+// own queue that idle workers steal from, so one deep subtree never holds
+// up the rest. Directories are read with getdents64 into a large buffer and
+// files are stat'ed with statx relative to the open directory, asking only
+// for the fields the caller needs; entries whose type the listing already
+// gives (d_type) are never stat'ed when no size is wanted.
+
+#ifndef LOCAL_SCANNER_HPP
+#define LOCAL_SCANNER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace proton {
+
+struct ScannedEntry {
+    std::string path;      // Relative to the scan root
+    uint64_t inode = 0;
+    int64_t size = 0;
+    int64_t mtime_ns = 0;
+    bool is_dir = false;
+};
+
+struct LocalScanProgress {
+    uint64_t dirs = 0;
+    uint64_t files = 0;
+    int64_t bytes = 0;
+};
+
+struct LocalScanOptions {
+    bool include_dirs = false;      // Report directories as entries too
+    bool regular_only = true;       // Else symlinks, sockets etc. are reported (lstat'ed, not followed)
+    bool stat_files = true;         // Fill inode/size/mtime; names only when false
+    const std::atomic<bool>* cancel = nullptr;
+    // Running totals, called from a worker thread about ten times a second
+    std::function<void(const LocalScanProgress&)> progress;
+};
+
+class LocalScanner {
+public:
+    // Receives the entries of one directory at a time, from several worker
+    // threads concurrently; the batch may be moved from
+    using Visitor = std::function<void(std::vector<ScannedEntry>& batch)>;
+
+    // Walk `root` (not following symlinks). False if the root could not be
+    // read, the scan was cancelled, or part of the tree failed with an error
+    // other than permission denied or vanished.
+    static bool scan(const std::string& root, const LocalScanOptions& options, const Visitor& visit,
+                     LocalScanProgress* totals = nullptr);
+
+    // Total size of the regular files under `root`
+    static int64_t total_bytes(const std::string& root, const std::atomic<bool>* cancel = nullptr);
+
+    // The `limit` largest non-empty regular files, largest first
+    static std::vector<ScannedEntry> largest_files(const std::string& root, size_t limit,
+                                                   const LocalScanOptions& options = {});
+
+    static constexpr int MAX_WORKERS = 8;
+};
+
+} // namespace proton
+
+#endif // LOCAL_SCANNER_HPP
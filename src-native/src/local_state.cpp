@@ -0,0 +1,400 @@
+// local_state.cpp - Per-job database of local file state
+
+#include "local_state.hpp"
+#include "hash_service.hpp"
+#include "local_scanner.hpp"
+#include "logger.hpp"
+#include <sqlite3.h>
+#include <sys/stat.h>
+#include <cstdlib>
+#include <filesystem>
+#include <iterator>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+namespace proton {
+
+namespace {
+
+// Binds and steps one statement; finalized on scope exit
+struct Statement {
+    sqlite3_stmt* stmt = nullptr;
+    Statement(sqlite3* db, const char* sql) { sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr); }
+    ~Statement() { sqlite3_finalize(stmt); }
+    explicit operator bool() const { return stmt != nullptr; }
+    void text(int i, const std::string& s) { sqlite3_bind_text(stmt, i, s.c_str(), -1, SQLITE_TRANSIENT); }
+    void int64(int i, int64_t v) { sqlite3_bind_int64(stmt, i, v); }
+    int step() { return sqlite3_step(stmt); }
+    void reset() { sqlite3_reset(stmt); sqlite3_clear_bindings(stmt); }
+};
+
+LocalFileState read_row(sqlite3_stmt* stmt) {
+    LocalFileState row;
+    const unsigned char* path = sqlite3_column_text(stmt, 0);
+    const unsigned char* hash = sqlite3_column_text(stmt, 5);
+    row.path = path ? reinterpret_cast<const char*>(path) : "";
+    row.inode = static_cast<uint64_t>(sqlite3_column_int64(stmt, 1));
+    row.size = sqlite3_column_int64(stmt, 2);
+    row.mtime_ns = sqlite3_column_int64(stmt, 3);
+    row.is_dir = sqlite3_column_int(stmt, 4) != 0;
+    row.hash = hash ? reinterpret_cast<const char*>(hash) : "";
+    return row;
+}
+
+void insert_rows(sqlite3* db, const std::vector<LocalFileState>& rows) {
+    Statement insert(db, "INSERT OR REPLACE INTO files (path, inode, size, mtime_ns, is_dir, hash) "
+                         "VALUES (?, ?, ?, ?, ?, ?)");
+    if (!insert) return;
+    for (const auto& row : rows) {
+        insert.text(1, row.path);
+        insert.int64(2, static_cast<int64_t>(row.inode));
+        insert.int64(3, row.size);
+        insert.int64(4, row.mtime_ns);
+        insert.int64(5, row.is_dir ? 1 : 0);
+        if (row.hash.empty()) sqlite3_bind_null(insert.stmt, 6); else insert.text(6, row.hash);
+        insert.step();
+        insert.reset();
+    }
+}
+
+} // namespace
+
+LocalStateStore& LocalStateStore::getInstance() {
+    static LocalStateStore instance;
+    return instance;
+}
+
+LocalStateStore::~LocalStateStore() {
+    for (auto& [job_id, db] : dbs_) sqlite3_close(db);
+}
+
+std::string LocalStateStore::db_path(const std::string& job_id) {
+    const char* home = std::getenv("HOME");
+    return std::string(home ? home : "/tmp") + "/.cache/proton-drive/state/" + job_id + ".db";
+}
+
+sqlite3* LocalStateStore::open(const std::string& job_id) {
+    auto it = dbs_.find(job_id);
+    if (it != dbs_.end()) return it->second;
+
+    std::string path = db_path(job_id);
+    std::error_code ec;
+    fs::create_directories(fs::path(path).parent_path(), ec);
+
+    sqlite3* db = nullptr;
+    if (sqlite3_open_v2(path.c_str(), &db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr) != SQLITE_OK) {
+        Logger::error("[LocalState] Failed to open " + path + ": " +
+                      std::string(db ? sqlite3_errmsg(db) : "out of memory"));
+        sqlite3_close(db);
+        return nullptr;
+    }
+    fs::permissions(path, fs::perms::owner_read | fs::perms::owner_write, fs::perm_options::replace, ec);
+
+    sqlite3_busy_timeout(db, 2000);
+    sqlite3_exec(db, "PRAGMA journal_mode=WAL;", nullptr, nullptr, nullptr);
+    sqlite3_exec(db, "PRAGMA synchronous=NORMAL;", nullptr, nullptr, nullptr);
+    sqlite3_exec(db,
+        "CREATE TABLE IF NOT EXISTS files ("
+        "  path TEXT PRIMARY KEY,"
+        "  inode INTEGER NOT NULL,"
+        "  size INTEGER NOT NULL,"
+        "  mtime_ns INTEGER NOT NULL,"
+        "  is_dir INTEGER NOT NULL,"
+        "  hash TEXT"
+        ") WITHOUT ROWID;"
+        "CREATE TABLE IF NOT EXISTS meta (key TEXT PRIMARY KEY, value TEXT);",
+        nullptr, nullptr, nullptr);
+
+    dbs_[job_id] = db;
+    return db;
+}
+
+bool LocalStateStore::lookup(sqlite3* db, const std::string& path, LocalFileState& out) {
+    Statement select(db, "SELECT path, inode, size, mtime_ns, is_dir, hash FROM files WHERE path = ?");
+    if (!select) return false;
+    select.text(1, path);
+    if (select.step() != SQLITE_ROW) return false;
+    out = read_row(select.stmt);
+    return true;
+}
+
+bool LocalStateStore::stat_path(const std::string& full_path, LocalFileState& out) {
+    struct stat st;
+    if (lstat(full_path.c_str(), &st) != 0) return false;
+    out.inode = static_cast<uint64_t>(st.st_ino);
+    out.size = static_cast<int64_t>(st.st_size);
+    out.mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+    out.is_dir = S_ISDIR(st.st_mode);
+    return true;
+}
+
+bool LocalStateStore::has_state(const std::string& job_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sqlite3* db = open(job_id);
+    if (!db) return false;
+    Statement select(db, "SELECT 1 FROM meta WHERE key = 'baseline'");
+    return select && select.step() == SQLITE_ROW;
+}
+
+LocalStateStore::Delta LocalStateStore::diff(const std::string& job_id, const std::string& local_root,
+                                            const ChangeJournal& journal) {
+    Delta delta;
+    std::string prefix = local_root.empty() || local_root.back() == '/' ? local_root : local_root + "/";
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    sqlite3* db = open(job_id);
+    auto rescanned = rescanned_.find(job_id);
+    if (rescanned != rescanned_.end() && journal.since < rescanned->second) {
+        // The walk may have recorded these changes already, so a stat match
+        // proves nothing: everything journaled goes through as-is
+        lock.unlock();
+        for (const auto& path : journal.changed) {
+            LocalFileState now;
+            if (!stat_path(prefix + path, now)) {
+                delta.deleted.push_back(path);
+                delta.removals.push_back(path);
+                continue;
+            }
+            now.path = path;
+            delta.changed.push_back(path);
+            delta.upserts.push_back(std::move(now));
+        }
+        for (const auto& path : journal.deleted) {
+            delta.deleted.push_back(path);
+            delta.removals.push_back(path);
+        }
+        return delta;
+    }
+
+    // Journaled paths as they are now, and the recorded state of those now gone
+    std::vector<LocalFileState> present;
+    std::map<std::string, LocalFileState> gone;  // Recorded rows
+    std::vector<std::string> gone_unknown;       // No row: passed through as-is
+    auto note_gone = [&](const std::string& path) {
+        LocalFileState row;
+        if (db && lookup(db, path, row)) gone[path] = row;
+        else gone_unknown.push_back(path);
+    };
+    for (const auto& path : journal.deleted) note_gone(path);
+    for (const auto& path : journal.changed) {
+        LocalFileState now;
+        if (!stat_path(prefix + path, now)) {
+            note_gone(path);
+            continue;
+        }
+        now.path = path;
+        present.push_back(std::move(now));
+    }
+
+    // Children of a renamed folder are still recorded under its old path
+    auto recorded = [&](const std::string& path, LocalFileState& row) {
+        if (!db) return false;
+        for (const auto& [from, to] : delta.renamed) {
+            if (path.size() > to.size() && path.compare(0, to.size(), to) == 0 && path[to.size()] == '/') {
+                return lookup(db, from + path.substr(to.size()), row);
+            }
+        }
+        return lookup(db, path, row);
+    };
+    auto take_rename = [&](std::map<std::string, LocalFileState>::iterator from, LocalFileState& now) {
+        if (now.hash.empty()) now.hash = from->second.hash;
+        delta.renamed.emplace_back(from->first, now.path);
+        delta.upserts.push_back(now);
+        gone.erase(from);
+    };
+
+    // Pass 1: same inode, same type, and for files the size and mtime a
+    // rename preserves. Done for every path before pass 2, so children of a
+    // renamed folder can be found under its old path there.
+    std::vector<bool> handled(present.size(), false);
+    for (size_t i = 0; i < present.size(); ++i) {
+        LocalFileState& now = present[i];
+        LocalFileState row;
+        if (recorded(now.path, row) && row.inode == now.inode) continue;
+        for (auto it = gone.begin(); it != gone.end(); ++it) {
+            const LocalFileState& old = it->second;
+            if (old.inode != now.inode || old.is_dir != now.is_dir) continue;
+            if (!now.is_dir && (old.size != now.size || old.mtime_ns != now.mtime_ns)) continue;
+            take_rename(it, now);
+            handled[i] = true;
+            break;
+        }
+    }
+
+    // Pass 2: unchanged entries drop out; new content may still match a
+    // removed file by hash (copy + delete, or a rename across filesystems).
+    // Everything left to hash goes to HashService as one parallel batch,
+    // outside the lock; nothing below reads the database.
+    std::vector<size_t> to_hash;
+    std::vector<std::string> hash_paths;
+    for (size_t i = 0; i < present.size(); ++i) {
+        if (handled[i]) continue;
+        const LocalFileState& now = present[i];
+        LocalFileState row;
+        if (recorded(now.path, row) && row.inode == now.inode && row.is_dir == now.is_dir &&
+            (now.is_dir || (row.size == now.size && row.mtime_ns == now.mtime_ns))) {
+            delta.unchanged++;
+            handled[i] = true;
+            continue;
+        }
+        if (!now.is_dir && now.size <= HASH_MAX_BYTES) {
+            to_hash.push_back(i);
+            hash_paths.push_back(prefix + now.path);
+        }
+    }
+    lock.unlock();
+    auto hashes = HashService::getInstance().hash_files(hash_paths);
+    for (size_t n = 0; n < to_hash.size(); ++n) present[to_hash[n]].hash = std::move(hashes[n]);
+
+    for (size_t i = 0; i < present.size(); ++i) {
+        if (handled[i]) continue;
+        LocalFileState& now = present[i];
+        bool renamed = false;
+        if (!now.hash.empty()) {
+            for (auto it = gone.begin(); it != gone.end(); ++it) {
+                if (!it->second.is_dir && it->second.size == now.size && it->second.hash == now.hash) {
+                    take_rename(it, now);
+                    renamed = true;
+                    break;
+                }
+            }
+        }
+        if (renamed) continue;
+
+        delta.changed.push_back(now.path);
+        delta.upserts.push_back(std::move(now));
+    }
+
+    for (const auto& [path, row] : gone) {
+        delta.deleted.push_back(path);
+        delta.removals.push_back(path);
+    }
+    for (const auto& path : gone_unknown) {
+        delta.deleted.push_back(path);
+        delta.removals.push_back(path);
+    }
+    return delta;
+}
+
+void LocalStateStore::commit(const std::string& job_id, const Delta& delta) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sqlite3* db = open(job_id);
+    if (!db) return;
+
+    sqlite3_exec(db, "BEGIN;", nullptr, nullptr, nullptr);
+    {
+        // A folder's rows move with it; an overwritten target is replaced
+        Statement move(db, "UPDATE OR REPLACE files SET path = ?2 || substr(path, length(?1) + 1) "
+                           "WHERE path = ?1 OR substr(path, 1, length(?1) + 1) = ?1 || '/'");
+        for (const auto& [from, to] : delta.renamed) {
+            if (!move) break;
+            move.text(1, from);
+            move.text(2, to);
+            move.step();
+            move.reset();
+        }
+        Statement remove(db, "DELETE FROM files WHERE path = ?1 OR substr(path, 1, length(?1) + 1) = ?1 || '/'");
+        for (const auto& path : delta.removals) {
+            if (!remove) break;
+            remove.text(1, path);
+            remove.step();
+            remove.reset();
+        }
+    }
+    insert_rows(db, delta.upserts);
+    if (sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        Logger::warn("[LocalState] Commit failed for job " + job_id + ": " + sqlite3_errmsg(db));
+        sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+    }
+}
+
+void LocalStateStore::rescan(const std::string& job_id, const std::string& local_root) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        rescans_running_[job_id]++;
+        rescanned_[job_id] = std::chrono::steady_clock::time_point::max();
+    }
+    // Journals that began before the walk ended are not refined against it
+    auto finish = [this, &job_id]() {
+        if (--rescans_running_[job_id] > 0) return;  // mutex_ held
+        rescans_running_.erase(job_id);
+        rescanned_[job_id] = std::chrono::steady_clock::now();
+    };
+
+    // Existing hashes survive for entries whose stat is unchanged
+    std::unordered_map<std::string, LocalFileState> previous;
+    for (auto& row : files(job_id)) previous.emplace(row.path, std::move(row));
+
+    std::vector<LocalFileState> rows;
+    std::mutex rows_mutex;
+    LocalScanOptions options;
+    options.include_dirs = true;
+    options.regular_only = false;
+    bool complete = LocalScanner::scan(local_root, options, [&](std::vector<ScannedEntry>& batch) {
+        std::vector<LocalFileState> scanned;
+        scanned.reserve(batch.size());
+        for (auto& entry : batch) {
+            LocalFileState row;
+            row.path = std::move(entry.path);
+            row.inode = entry.inode;
+            row.size = entry.size;
+            row.mtime_ns = entry.mtime_ns;
+            row.is_dir = entry.is_dir;
+            auto prev = previous.find(row.path);
+            if (prev != previous.end() && prev->second.inode == row.inode &&
+                prev->second.size == row.size && prev->second.mtime_ns == row.mtime_ns) {
+                row.hash = prev->second.hash;
+            }
+            scanned.push_back(std::move(row));
+        }
+        std::lock_guard<std::mutex> lock(rows_mutex);
+        std::move(scanned.begin(), scanned.end(), std::back_inserter(rows));
+    });
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!complete) {
+        Logger::warn("[LocalState] Scan of " + local_root + " stopped early");
+        finish();
+        return;  // Keep the old baseline rather than record a partial tree
+    }
+    sqlite3* db = open(job_id);
+    if (!db) {
+        finish();
+        return;
+    }
+    sqlite3_exec(db, "BEGIN; DELETE FROM files;", nullptr, nullptr, nullptr);
+    insert_rows(db, rows);
+    sqlite3_exec(db, "INSERT OR REPLACE INTO meta (key, value) VALUES ('baseline', strftime('%s','now'));",
+                 nullptr, nullptr, nullptr);
+    bool committed = sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr) == SQLITE_OK;
+    if (!committed) sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+    finish();
+    if (!committed) return;
+    Logger::info("[LocalState] Recorded " + std::to_string(rows.size()) + " entries for job " + job_id);
+}
+
+std::vector<LocalFileState> LocalStateStore::files(const std::string& job_id) {
+    std::vector<LocalFileState> rows;
+    std::lock_guard<std::mutex> lock(mutex_);
+    sqlite3* db = open(job_id);
+    if (!db) return rows;
+    Statement select(db, "SELECT path, inode, size, mtime_ns, is_dir, hash FROM files WHERE is_dir = 0");
+    while (select && select.step() == SQLITE_ROW) rows.push_back(read_row(select.stmt));
+    return rows;
+}
+
+void LocalStateStore::forget_job(const std::string& job_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    rescanned_.erase(job_id);
+    auto it = dbs_.find(job_id);
+    if (it != dbs_.end()) {
+        sqlite3_close(it->second);
+        dbs_.erase(it);
+    }
+    std::string path = db_path(job_id);
+    std::error_code ec;
+    for (const char* suffix : {"", "-wal", "-shm"}) fs::remove(path + suffix, ec);
+}
+
+} // namespace proton
@@ -0,0 +1,97 @@
+// local_state.hpp - Per-job database of local file state
+// Records (inode, size, mtime, content hash) for every entry under a sync
+// job's local root, so a FileWatcher journal can be turned into an exact
+// change set without walking the tree: journaled paths whose state did not
+// change are dropped, and a delete + create pair with the same inode (or
+// the same size and content hash) becomes a rename, moved server-side
+// instead of re-uploaded. Hashes are filled in lazily, when a file is
+// reported changed. The baseline is built by one walk per job (and again
+// after the watcher lost events, and after each successful full sync).
+
+#ifndef LOCAL_STATE_HPP
+#define LOCAL_STATE_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include "file_watcher.hpp"
+
+struct sqlite3;
+
+namespace proton {
+
+struct LocalFileState {
+    std::string path;      // Relative to the job root
+    uint64_t inode = 0;
+    int64_t size = 0;
+    int64_t mtime_ns = 0;
+    bool is_dir = false;
+    std::string hash;      // SHA-1 hex (HashService); "" until a change is seen
+};
+
+class LocalStateStore {
+public:
+    static LocalStateStore& getInstance();
+
+    struct Delta {
+        std::vector<std::string> changed;
+        std::vector<std::string> deleted;
+        std::vector<std::pair<std::string, std::string>> renamed;  // <from, to>
+        size_t unchanged = 0;  // Journaled paths whose state had not moved
+        bool empty() const { return changed.empty() && deleted.empty() && renamed.empty(); }
+
+    private:
+        friend class LocalStateStore;
+        std::vector<LocalFileState> upserts;
+        std::vector<std::string> removals;
+    };
+
+    // True once a baseline exists for the job
+    bool has_state(const std::string& job_id);
+
+    // Refine a journal against the recorded state. Nothing is written until
+    // commit(), so a failed transfer leaves the old state in place. A journal
+    // that began before the job's last rescan finished is passed through
+    // unrefined: the walk may already have recorded its changes.
+    Delta diff(const std::string& job_id, const std::string& local_root, const ChangeJournal& journal);
+    void commit(const std::string& job_id, const Delta& delta);
+
+    // Rebuild the baseline from a walk of the tree (keeps hashes of entries
+    // whose stat is unchanged)
+    void rescan(const std::string& job_id, const std::string& local_root);
+
+    // Regular files recorded for the job
+    std::vector<LocalFileState> files(const std::string& job_id);
+
+    // Drop the job's database
+    void forget_job(const std::string& job_id);
+
+    // Files above this size are matched for renames by inode only
+    static constexpr int64_t HASH_MAX_BYTES = 64 * 1024 * 1024;
+
+private:
+    LocalStateStore() = default;
+    ~LocalStateStore();
+
+    LocalStateStore(const LocalStateStore&) = delete;
+    LocalStateStore& operator=(const LocalStateStore&) = delete;
+
+    sqlite3* open(const std::string& job_id);  // mutex_ held
+    bool lookup(sqlite3* db, const std::string& path, LocalFileState& out);
+    static std::string db_path(const std::string& job_id);
+    static bool stat_path(const std::string& full_path, LocalFileState& out);
+
+    std::mutex mutex_;
+    std::map<std::string, sqlite3*> dbs_;
+    // Per job, until when a rescan may have seen changes (max() while one runs)
+    std::map<std::string, std::chrono::steady_clock::time_point> rescanned_;
+    std::map<std::string, int> rescans_running_;
+};
+
+} // namespace proton
+
+#endif // LOCAL_STATE_HPP
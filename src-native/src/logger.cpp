@@ -1,30 +1,203 @@
 #include "logger.hpp"
 #include <iostream>
 #include <chrono>
-#include <iomanip>
+#include <ctime>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <condition_variable>
+#include <unordered_map>
+#include <filesystem>
+#include <system_error>
+#include <vector>
+#include <cctype>
 
-LogLevel Logger::current_level = LogLevel::INFO;
+std::atomic<LogLevel> Logger::current_level{LogLevel::INFO};
 std::ofstream Logger::log_file;
+std::string Logger::log_path;
+size_t Logger::log_file_size = 0;
 std::mutex Logger::log_mutex;
 
+namespace {
+
+// ---- Async ring: bounded MPSC queue (per-slot sequence numbers) ----
+
+struct LogRecord {
+    LogLevel level = LogLevel::INFO;
+    long long timestamp_us = 0;
+    std::string message;
+};
+
+struct Slot {
+    std::atomic<size_t> sequence{0};
+    LogRecord record;
+};
+
+constexpr size_t RING_SIZE = 8192;  // power of two
+constexpr size_t RING_MASK = RING_SIZE - 1;
+constexpr size_t DRAIN_BATCH = 512;
+
+// Allocated once by start_async() and never freed: a producer that saw
+// async mode just before shutdown may still touch it
+Slot* g_ring = nullptr;
+std::atomic<size_t> g_enqueue_pos{0};
+size_t g_dequeue_pos = 0;  // drain thread only
+
+std::atomic<bool> g_async{false};
+std::atomic<bool> g_stop{false};
+std::atomic<size_t> g_dropped{0};
+std::thread g_drain_thread;
+
+// Wakeup: the drain thread only sleeps when the ring is empty and says so
+std::mutex g_wake_mutex;
+std::condition_variable g_wake_cv;
+std::atomic<bool> g_drain_sleeping{false};
+
+bool ring_push(LogRecord&& record) {
+    size_t pos = g_enqueue_pos.load(std::memory_order_relaxed);
+    for (;;) {
+        Slot& slot = g_ring[pos & RING_MASK];
+        size_t seq = slot.sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (g_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                slot.record = std::move(record);
+                slot.sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;  // Full
+        } else {
+            pos = g_enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool ring_has_data() {
+    const Slot& slot = g_ring[g_dequeue_pos & RING_MASK];
+    return slot.sequence.load(std::memory_order_acquire) == g_dequeue_pos + 1;
+}
+
+bool ring_pop(LogRecord& out) {
+    if (!ring_has_data()) return false;
+    Slot& slot = g_ring[g_dequeue_pos & RING_MASK];
+    out = std::move(slot.record);
+    slot.sequence.store(g_dequeue_pos + RING_SIZE, std::memory_order_release);
+    ++g_dequeue_pos;
+    return true;
+}
+
+// ---- Per-tag levels: copy-on-write map, read without locks ----
+
+using TagLevels = std::unordered_map<std::string, LogLevel>;
+std::shared_ptr<const TagLevels> g_tag_levels;
+std::atomic<bool> g_has_tag_levels{false};
+std::mutex g_tag_write_mutex;
+
+// ---- File rotation ----
+
+size_t g_max_file_bytes = 10 * 1024 * 1024;
+int g_keep_files = 3;
+
+// ---- Timestamp cache (log_mutex held): localtime once per second ----
+
+time_t g_cached_second = -1;
+char g_cached_stamp[32] = "";  // "%Y-%m-%d %H:%M:%S"
+
+const char* format_stamp(long long timestamp_us) {
+    time_t second = static_cast<time_t>(timestamp_us / 1000000);
+    if (second != g_cached_second) {
+        struct tm tm_buf;
+        localtime_r(&second, &tm_buf);
+        strftime(g_cached_stamp, sizeof(g_cached_stamp), "%Y-%m-%d %H:%M:%S", &tm_buf);
+        g_cached_second = second;
+    }
+    return g_cached_stamp;
+}
+
+long long now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+bool parse_level(std::string name, LogLevel& level) {
+    for (auto& c : name) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    if (name == "debug") level = LogLevel::DEBUG;
+    else if (name == "info") level = LogLevel::INFO;
+    else if (name == "warn" || name == "warning") level = LogLevel::WARN;
+    else if (name == "error") level = LogLevel::ERROR;
+    else return false;
+    return true;
+}
+
+std::string trim(const std::string& s) {
+    size_t start = s.find_first_not_of(" \t[");
+    size_t end = s.find_last_not_of(" \t]");
+    if (start == std::string::npos) return "";
+    return s.substr(start, end - start + 1);
+}
+
+} // namespace
+
 void Logger::init(LogLevel level, const std::string& log_file_path) {
     std::lock_guard<std::mutex> lock(log_mutex);
-    current_level = level;
+    current_level.store(level);
     if (!log_file_path.empty()) {
         log_file.open(log_file_path, std::ios::app);
+        log_path = log_file_path;
+        std::error_code ec;
+        auto size = std::filesystem::file_size(log_file_path, ec);
+        log_file_size = ec ? 0 : static_cast<size_t>(size);
+    }
+}
+
+bool Logger::enabled(LogLevel level, const std::string& message) {
+    if (g_has_tag_levels.load(std::memory_order_relaxed) && !message.empty() && message[0] == '[') {
+        size_t end = message.find(']');
+        if (end != std::string::npos) {
+            auto levels = std::atomic_load(&g_tag_levels);
+            if (levels) {
+                auto it = levels->find(message.substr(1, end - 1));
+                if (it != levels->end()) return level >= it->second;
+            }
+        }
     }
+    return level >= current_level.load(std::memory_order_relaxed);
 }
 
 void Logger::log(LogLevel level, const std::string& message) {
-    if (level < current_level) return;
+    if (!enabled(level, message)) return;
+
+    if (g_async.load(std::memory_order_acquire)) {
+        if (!ring_push(LogRecord{level, now_us(), message})) {
+            g_dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        // Pairs with the fence in drain_loop: either we see it sleeping or it sees our record
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (g_drain_sleeping.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(g_wake_mutex);
+            g_wake_cv.notify_one();
+        }
+        return;
+    }
 
     std::lock_guard<std::mutex> lock(log_mutex);
-    
-    // Timestamp
-    auto now = std::chrono::system_clock::now();
-    auto time = std::chrono::system_clock::to_time_t(now);
-    
-    std::string level_str;
+    std::string file_out;
+    std::string console_out;
+    write_line(level, now_us(), message, file_out, console_out);
+    if (log_file.is_open()) {
+        log_file << file_out << std::flush;
+        log_file_size += file_out.size();
+        rotate_if_needed();
+    }
+    std::cout << console_out << std::flush;
+}
+
+void Logger::write_line(LogLevel level, long long timestamp_us, const std::string& message,
+                        std::string& file_out, std::string& console_out) {
+    const char* level_str = "[INFO] ";
     switch (level) {
         case LogLevel::DEBUG: level_str = "[DEBUG]"; break;
         case LogLevel::INFO:  level_str = "[INFO] "; break;
@@ -32,11 +205,145 @@ void Logger::log(LogLevel level, const std::string& message) {
         case LogLevel::ERROR: level_str = "[ERROR]"; break;
     }
 
+    const char* stamp = format_stamp(timestamp_us);
     if (log_file.is_open()) {
-        log_file << std::put_time(std::localtime(&time), "%Y-%m-%d %H:%M:%S") 
-                 << " " << level_str << " " << message << std::endl;
+        file_out.append(stamp).append(" ").append(level_str).append(" ").append(message).append("\n");
+    }
+    // Console shows the time only ("%H:%M:%S" is the tail of the stamp)
+    console_out.append(stamp + 11).append(" ").append(level_str).append(" ").append(message).append("\n");
+}
+
+void Logger::rotate_if_needed() {
+    if (g_max_file_bytes == 0 || log_file_size < g_max_file_bytes || log_path.empty()) return;
+
+    log_file.close();
+    std::error_code ec;
+    if (g_keep_files > 0) {
+        for (int i = g_keep_files - 1; i >= 1; --i) {
+            std::filesystem::rename(log_path + "." + std::to_string(i),
+                                    log_path + "." + std::to_string(i + 1), ec);
+        }
+        std::filesystem::rename(log_path, log_path + ".1", ec);
+        log_file.open(log_path, std::ios::app);
+    } else {
+        log_file.open(log_path, std::ios::trunc);
+    }
+    log_file_size = 0;
+}
+
+void Logger::drain_loop() {
+    std::vector<LogRecord> batch;
+    batch.reserve(DRAIN_BATCH);
+    std::string file_out;
+    std::string console_out;
+
+    for (;;) {
+        LogRecord record;
+        while (batch.size() < DRAIN_BATCH && ring_pop(record)) {
+            batch.push_back(std::move(record));
+        }
+
+        size_t dropped = g_dropped.exchange(0, std::memory_order_relaxed);
+        if (!batch.empty() || dropped > 0) {
+            std::lock_guard<std::mutex> lock(log_mutex);
+            file_out.clear();
+            console_out.clear();
+            for (const auto& r : batch) {
+                write_line(r.level, r.timestamp_us, r.message, file_out, console_out);
+            }
+            if (dropped > 0) {
+                write_line(LogLevel::WARN, now_us(),
+                           "[Logger] Dropped " + std::to_string(dropped) + " messages (queue full)",
+                           file_out, console_out);
+            }
+            // One write per batch instead of a flush per line
+            if (log_file.is_open()) {
+                log_file << file_out << std::flush;
+                log_file_size += file_out.size();
+                rotate_if_needed();
+            }
+            std::cout << console_out << std::flush;
+            batch.clear();
+            continue;
+        }
+
+        if (g_stop.load(std::memory_order_acquire)) break;
+
+        std::unique_lock<std::mutex> lock(g_wake_mutex);
+        g_drain_sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        g_wake_cv.wait(lock, [] { return ring_has_data() || g_stop.load(std::memory_order_acquire); });
+        g_drain_sleeping.store(false, std::memory_order_relaxed);
     }
-    
-    std::cout << std::put_time(std::localtime(&time), "%H:%M:%S") 
-              << " " << level_str << " " << message << std::endl;
+}
+
+void Logger::start_async() {
+    static std::once_flag once;
+    std::call_once(once, [] {
+        g_ring = new Slot[RING_SIZE];
+        for (size_t i = 0; i < RING_SIZE; ++i) {
+            g_ring[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        try {
+            g_drain_thread = std::thread(&Logger::drain_loop);
+        } catch (const std::system_error& e) {
+            log(LogLevel::WARN, "[Logger] Failed to start log thread, staying synchronous: " + std::string(e.what()));
+            return;
+        }
+        g_async.store(true, std::memory_order_release);
+        std::atexit(&Logger::shutdown);
+    });
+}
+
+void Logger::shutdown() {
+    if (!g_async.exchange(false)) return;
+
+    // New messages are written synchronously from here; the thread drains the rest
+    {
+        std::lock_guard<std::mutex> lock(g_wake_mutex);
+        g_stop.store(true, std::memory_order_release);
+        g_wake_cv.notify_one();
+    }
+    if (g_drain_thread.joinable()) {
+        g_drain_thread.join();
+    }
+}
+
+void Logger::set_tag_level(const std::string& tag, LogLevel level) {
+    std::lock_guard<std::mutex> lock(g_tag_write_mutex);
+    auto current = std::atomic_load(&g_tag_levels);
+    auto updated = std::make_shared<TagLevels>(current ? *current : TagLevels{});
+    (*updated)[trim(tag)] = level;
+    std::atomic_store(&g_tag_levels, std::shared_ptr<const TagLevels>(std::move(updated)));
+    g_has_tag_levels.store(true, std::memory_order_relaxed);
+}
+
+void Logger::set_tag_levels(const std::string& spec) {
+    auto levels = std::make_shared<TagLevels>();
+    size_t pos = 0;
+    while (pos <= spec.size()) {
+        size_t comma = spec.find(',', pos);
+        if (comma == std::string::npos) comma = spec.size();
+        std::string entry = spec.substr(pos, comma - pos);
+        size_t eq = entry.find('=');
+        LogLevel level;
+        if (eq != std::string::npos && parse_level(trim(entry.substr(eq + 1)), level)) {
+            std::string tag = trim(entry.substr(0, eq));
+            if (!tag.empty()) (*levels)[tag] = level;
+        } else if (!trim(entry).empty()) {
+            log(LogLevel::WARN, "[Logger] Ignoring bad tag level: " + entry);
+        }
+        pos = comma + 1;
+    }
+
+    std::lock_guard<std::mutex> lock(g_tag_write_mutex);
+    bool any = !levels->empty();
+    std::atomic_store(&g_tag_levels, std::shared_ptr<const TagLevels>(std::move(levels)));
+    g_has_tag_levels.store(any, std::memory_order_relaxed);
+}
+
+void Logger::set_rotation(size_t max_bytes, int keep_files) {
+    std::lock_guard<std::mutex> lock(log_mutex);
+    g_max_file_bytes = max_bytes;
+    g_keep_files = keep_files < 0 ? 0 : keep_files;
 }
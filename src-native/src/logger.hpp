@@ -2,6 +2,8 @@
 #include <string>
 #include <fstream>
 #include <mutex>
+#include <atomic>
+#include <cstddef>
 
 enum class LogLevel {
     DEBUG,
@@ -14,14 +16,41 @@ class Logger {
 public:
     static void init(LogLevel level, const std::string& log_file_path = "");
     static void log(LogLevel level, const std::string& message);
-    
+
     static void debug(const std::string& message) { log(LogLevel::DEBUG, message); }
     static void info(const std::string& message) { log(LogLevel::INFO, message); }
     static void warn(const std::string& message) { log(LogLevel::WARN, message); }
     static void error(const std::string& message) { log(LogLevel::ERROR, message); }
 
+    // Hand messages to a background thread instead of writing on the caller.
+    // Producers only push into a lock-free ring; the drain thread formats
+    // and writes in batches. If the ring is full the message is dropped
+    // (and counted) rather than blocking the caller.
+    static void start_async();
+
+    // Drain everything queued and stop the background thread (also runs at exit)
+    static void shutdown();
+
+    // Per-tag level overrides, keyed by the leading "[Tag]" of a message.
+    // `spec` is "Tag=level,Tag2=level" (levels: debug, info, warn, error);
+    // an empty spec clears all overrides.
+    static void set_tag_levels(const std::string& spec);
+    static void set_tag_level(const std::string& tag, LogLevel level);
+
+    // Rotate the log file once it exceeds `max_bytes`, keeping `keep_files`
+    // old copies (proton-drive.log.1 ... .N). 0 disables rotation.
+    static void set_rotation(size_t max_bytes, int keep_files);
+
 private:
-    static LogLevel current_level;
+    static bool enabled(LogLevel level, const std::string& message);
+    static void write_line(LogLevel level, long long timestamp_us, const std::string& message,
+                           std::string& file_out, std::string& console_out);
+    static void rotate_if_needed();
+    static void drain_loop();
+
+    static std::atomic<LogLevel> current_level;
     static std::ofstream log_file;
+    static std::string log_path;
+    static size_t log_file_size;
     static std::mutex log_mutex;
 };
@@ -0,0 +1,338 @@
+// lsjson_parser.cpp - Streaming parser for `rclone lsjson` output
+
+#include "lsjson_parser.hpp"
+#include "trace.hpp"
+#include <cstring>
+#include <cctype>
+
+namespace {
+
+inline bool is_ws(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+inline int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+void assign_lowercase_extension(const std::string& name, std::string& ext) {
+    size_t dot = name.rfind('.');
+    if (dot == std::string::npos || dot == 0) {
+        ext.clear();
+        return;
+    }
+    ext.assign(name, dot + 1, std::string::npos);
+    for (auto& ch : ext) ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+}
+
+constexpr uint32_t REPLACEMENT_CHAR = 0xFFFD;
+
+} // namespace
+
+LsjsonParser::LsjsonParser(std::string path_prefix, Callback on_entry)
+    : prefix_(std::move(path_prefix)), on_entry_(std::move(on_entry)) {
+    key_.reserve(16);
+    scalar_.reserve(24);
+}
+
+std::vector<IndexedFile> LsjsonParser::parse(std::string_view json, const std::string& path_prefix) {
+    std::vector<IndexedFile> items;
+    LsjsonParser parser(path_prefix, [&items](IndexedFile&& f) { items.push_back(std::move(f)); });
+    parser.feed(json);
+    return items;
+}
+
+void LsjsonParser::begin_object() {
+    // Reset in place: a callback that copies the record leaves the string
+    // capacity here for the next one
+    file_.name.clear();
+    file_.parent_path.clear();
+    file_.mod_time.clear();
+    file_.local_path.clear();
+    file_.extension.clear();
+    file_.id = 0;
+    file_.size = 0;
+    file_.is_directory = false;
+    file_.is_synced = false;
+    file_.relevance_score = 0.0;
+    file_.path.assign(prefix_);
+    have_path_ = false;
+}
+
+void LsjsonParser::end_object() {
+    if (!have_path_) file_.path += file_.name;
+    if (file_.mod_time.size() > 19) file_.mod_time.resize(19);
+
+    // parent_path: everything before the last '/', or the remote root
+    size_t colon = file_.path.find(':');
+    size_t root_end = (colon == std::string::npos) ? 0 : colon + 1;
+    size_t last_slash = file_.path.rfind('/');
+    if (last_slash != std::string::npos && last_slash > root_end) {
+        file_.parent_path.assign(file_.path, 0, last_slash);
+    } else if (colon != std::string::npos) {
+        file_.parent_path.assign(file_.path, 0, colon + 1);
+        file_.parent_path += '/';
+    }
+
+    assign_lowercase_extension(file_.name, file_.extension);
+
+    if (!file_.name.empty()) {
+        count_++;
+        on_entry_(std::move(file_));
+    }
+    state_ = State::Outside;
+}
+
+std::string* LsjsonParser::string_target() {
+    switch (field_) {
+        case Field::Path:    have_path_ = true; return &file_.path;
+        case Field::Name:    return &file_.name;
+        case Field::ModTime: return &file_.mod_time;
+        default:             return nullptr;
+    }
+}
+
+void LsjsonParser::finish_scalar() {
+    if (field_ == Field::Size) {
+        const char* s = scalar_.c_str();
+        bool neg = (*s == '-');
+        if (neg) s++;
+        int64_t v = 0;
+        while (*s >= '0' && *s <= '9') v = v * 10 + (*s++ - '0');
+        file_.size = neg ? -v : v;
+    } else if (field_ == Field::IsDir) {
+        file_.is_directory = (scalar_ == "true");
+    }
+    scalar_.clear();
+}
+
+void LsjsonParser::append_codepoint(uint32_t cp) {
+    std::string* out = string_target();
+    if (!out) return;
+    if (cp < 0x80) {
+        out->push_back(static_cast<char>(cp));
+    } else if (cp < 0x800) {
+        out->push_back(static_cast<char>(0xC0 | (cp >> 6)));
+        out->push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        out->push_back(static_cast<char>(0xE0 | (cp >> 12)));
+        out->push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out->push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else {
+        out->push_back(static_cast<char>(0xF0 | (cp >> 18)));
+        out->push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+        out->push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out->push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+}
+
+void LsjsonParser::feed(const char* data, size_t len) {
+    proton::TraceSpan span("json", "lsjson feed");
+    span.set_detail(std::to_string(len) + " bytes");
+    const char* p = data;
+    const char* end = data + len;
+
+    while (p < end) {
+        char c = *p;
+        switch (state_) {
+            case State::Outside: {
+                // Jump straight to the next element; separators and the
+                // enclosing '[' ']' carry no information.
+                const void* brace = std::memchr(p, '{', static_cast<size_t>(end - p));
+                if (!brace) return;
+                p = static_cast<const char*>(brace) + 1;
+                begin_object();
+                state_ = State::ExpectKey;
+                continue;
+            }
+
+            case State::ExpectKey:
+                if (c == '"') {
+                    key_.clear();
+                    state_ = State::Key;
+                } else if (c == '}') {
+                    end_object();
+                }
+                p++;
+                continue;
+
+            case State::Key: {
+                const char* start = p;
+                while (p < end && *p != '"' && *p != '\\') p++;
+                key_.append(start, static_cast<size_t>(p - start));
+                if (p == end) return;
+                if (*p == '\\') {
+                    state_ = State::KeyEscape;
+                } else {
+                    // One dispatch per key
+                    switch (key_.size()) {
+                        case 4:
+                            field_ = key_ == "Path" ? Field::Path
+                                   : key_ == "Name" ? Field::Name
+                                   : key_ == "Size" ? Field::Size : Field::None;
+                            break;
+                        case 5: field_ = key_ == "IsDir" ? Field::IsDir : Field::None; break;
+                        case 7: field_ = key_ == "ModTime" ? Field::ModTime : Field::None; break;
+                        default: field_ = Field::None; break;
+                    }
+                    state_ = State::ExpectColon;
+                }
+                p++;
+                continue;
+            }
+
+            case State::KeyEscape:
+                // None of the keys we dispatch on contain escapes; keep the
+                // raw byte so unknown keys still terminate correctly.
+                key_.push_back(c);
+                state_ = State::Key;
+                p++;
+                continue;
+
+            case State::ExpectColon:
+                if (c == ':') state_ = State::ValueStart;
+                p++;
+                continue;
+
+            case State::ValueStart:
+                if (is_ws(c)) {
+                    p++;
+                } else if (c == '"') {
+                    pending_high_surrogate_ = 0;
+                    state_ = State::String;
+                    p++;
+                } else if (c == '{' || c == '[') {
+                    skip_depth_ = 1;
+                    skip_in_string_ = false;
+                    skip_escape_ = false;
+                    state_ = State::Skip;
+                    p++;
+                } else {
+                    scalar_.clear();
+                    state_ = State::Scalar;
+                }
+                continue;
+
+            case State::String: {
+                const char* start = p;
+                while (p < end && *p != '"' && *p != '\\') p++;
+                if (p != start) {
+                    if (pending_high_surrogate_) {
+                        append_codepoint(REPLACEMENT_CHAR);
+                        pending_high_surrogate_ = 0;
+                    }
+                    if (std::string* out = string_target()) {
+                        out->append(start, static_cast<size_t>(p - start));
+                    }
+                }
+                if (p == end) return;
+                if (*p == '\\') {
+                    state_ = State::StringEscape;
+                } else {
+                    if (pending_high_surrogate_) {
+                        append_codepoint(REPLACEMENT_CHAR);
+                        pending_high_surrogate_ = 0;
+                    }
+                    field_ = Field::None;
+                    state_ = State::ExpectKey;
+                }
+                p++;
+                continue;
+            }
+
+            case State::StringEscape: {
+                if (c == 'u') {
+                    unicode_value_ = 0;
+                    unicode_digits_ = 0;
+                    state_ = State::Unicode;
+                    p++;
+                    continue;
+                }
+                if (pending_high_surrogate_) {
+                    append_codepoint(REPLACEMENT_CHAR);
+                    pending_high_surrogate_ = 0;
+                }
+                char decoded;
+                switch (c) {
+                    case 'n': decoded = '\n'; break;
+                    case 't': decoded = '\t'; break;
+                    case 'r': decoded = '\r'; break;
+                    case 'b': decoded = '\b'; break;
+                    case 'f': decoded = '\f'; break;
+                    default:  decoded = c; break;  // \" \\ \/
+                }
+                if (std::string* out = string_target()) out->push_back(decoded);
+                state_ = State::String;
+                p++;
+                continue;
+            }
+
+            case State::Unicode: {
+                int h = hex_value(c);
+                if (h < 0) {
+                    // Malformed escape - emit a replacement and resume the string
+                    append_codepoint(REPLACEMENT_CHAR);
+                    pending_high_surrogate_ = 0;
+                    state_ = State::String;
+                    continue;
+                }
+                unicode_value_ = (unicode_value_ << 4) | static_cast<uint32_t>(h);
+                p++;
+                if (++unicode_digits_ < 4) continue;
+
+                uint32_t cp = unicode_value_;
+                if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                    if (pending_high_surrogate_) {
+                        append_codepoint(0x10000 + ((pending_high_surrogate_ - 0xD800) << 10) + (cp - 0xDC00));
+                    } else {
+                        append_codepoint(REPLACEMENT_CHAR);
+                    }
+                    pending_high_surrogate_ = 0;
+                } else {
+                    if (pending_high_surrogate_) append_codepoint(REPLACEMENT_CHAR);
+                    pending_high_surrogate_ = 0;
+                    if (cp >= 0xD800 && cp <= 0xDBFF) {
+                        pending_high_surrogate_ = cp;
+                    } else {
+                        append_codepoint(cp);
+                    }
+                }
+                state_ = State::String;
+                continue;
+            }
+
+            case State::Scalar:
+                if (c == ',' || c == '}' || c == ']' || is_ws(c)) {
+                    finish_scalar();
+                    field_ = Field::None;
+                    state_ = State::ExpectKey;
+                    continue;  // re-dispatch the terminator
+                }
+                scalar_.push_back(c);
+                p++;
+                continue;
+
+            case State::Skip:
+                if (skip_escape_) {
+                    skip_escape_ = false;
+                } else if (skip_in_string_) {
+                    if (c == '\\') skip_escape_ = true;
+                    else if (c == '"') skip_in_string_ = false;
+                } else if (c == '"') {
+                    skip_in_string_ = true;
+                } else if (c == '{' || c == '[') {
+                    skip_depth_++;
+                } else if (c == '}' || c == ']') {
+                    if (--skip_depth_ == 0) {
+                        field_ = Field::None;
+                        state_ = State::ExpectKey;
+                    }
+                }
+                p++;
+                continue;
+        }
+    }
+}
@@ -0,0 +1,94 @@
+// lsjson_parser.hpp - Streaming parser for `rclone lsjson` output
+// Single pass over the raw bytes with no per-object copies: string values are
+// appended straight into the IndexedFile being built, keys are dispatched once,
+// and unknown/nested values (Hashes, Metadata, ...) are skipped structurally.
+
+#ifndef LSJSON_PARSER_HPP
+#define LSJSON_PARSER_HPP
+
+#include "file_index.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+/**
+ * Incremental lsjson parser.
+ *
+ * Feed it arbitrary chunks (pipe reads, a whole RC response, ...) and it
+ * emits one IndexedFile per array element as soon as the element's closing
+ * brace is seen. Objects may span chunk boundaries.
+ *
+ * Emitted records have:
+ *   path        = path_prefix + Path   (or path_prefix + Name if Path absent)
+ *   parent_path = path up to the last '/', or "<remote>:/" for top-level items
+ *   mod_time    = first 19 chars of ModTime (YYYY-MM-DDTHH:MM:SS)
+ *   extension   = lowercase suffix of Name
+ * Remaining fields are zero/false; callers fill is_synced/local_path.
+ * The callback may move from the record. One that only copies it (e.g.
+ * into an IndexBatch) lets the parser reuse the record's string buffers.
+ */
+class LsjsonParser {
+public:
+    using Callback = std::function<void(IndexedFile&&)>;
+
+    LsjsonParser(std::string path_prefix, Callback on_entry);
+
+    void feed(const char* data, size_t len);
+    void feed(std::string_view chunk) { feed(chunk.data(), chunk.size()); }
+
+    // Number of records emitted so far
+    size_t count() const { return count_; }
+
+    // Parse a complete lsjson document in one go
+    static std::vector<IndexedFile> parse(std::string_view json, const std::string& path_prefix);
+
+private:
+    enum class State {
+        Outside,        // before/between array elements
+        ExpectKey,      // inside object, waiting for a key or '}'
+        Key,            // inside a key string
+        KeyEscape,      // backslash inside a key
+        ExpectColon,
+        ValueStart,
+        String,         // inside a string value
+        StringEscape,
+        Unicode,        // collecting \uXXXX hex digits
+        Scalar,         // number / true / false / null
+        Skip            // nested object/array we do not care about
+    };
+
+    enum class Field { None, Path, Name, Size, ModTime, IsDir };
+
+    void begin_object();
+    void end_object();
+    void finish_scalar();
+    void append_codepoint(uint32_t cp);
+    std::string* string_target();
+
+    std::string prefix_;
+    Callback on_entry_;
+    size_t count_ = 0;
+
+    State state_ = State::Outside;
+    Field field_ = Field::None;
+    IndexedFile file_;
+    bool have_path_ = false;
+
+    // Small reusable buffers - keys and scalars are a handful of bytes
+    std::string key_;
+    std::string scalar_;
+
+    // \uXXXX decoding
+    uint32_t unicode_value_ = 0;
+    int unicode_digits_ = 0;
+    uint32_t pending_high_surrogate_ = 0;
+
+    // Nested value skipping
+    int skip_depth_ = 0;
+    bool skip_in_string_ = false;
+    bool skip_escape_ = false;
+};
+
+#endif // LSJSON_PARSER_HPP
@@ -15,12 +15,20 @@
 #include "app_window.hpp"
 #include "tray.hpp"
 #include "logger.hpp"
+#include "task_pool.hpp"
 #include "file_index.hpp"
 #include "sync_job_metadata.hpp"
 #include "sync_manager.hpp"
 #include "trash_manager.hpp"
 #include "settings.hpp"
 #include "notifications.hpp"
+#include "rclone_rc.hpp"
+#include "cloud_mount.hpp"
+#include "cloud_browser.hpp"
+#include "daemon_service.hpp"
+#include "app_window_helpers.hpp"
+#include "startup.hpp"
+#include "trace.hpp"
 #include <iostream>
 #include <memory>
 #include <cstdlib>
@@ -49,6 +57,9 @@ namespace fs = std::filesystem;
  * Crash handler - writes stack trace to log file
  */
 static void crash_handler(int sig) {
+    // Syncs frozen for a file open would otherwise stay stopped
+    SyncManager::resume_frozen_for_crash();
+    
     // Get home directory for crash dump location
     const char* home = getenv("HOME");
     std::string crash_file = home ? std::string(home) + "/.cache/proton-drive/crash.log" : "/tmp/proton-drive-crash.log";
@@ -122,10 +133,128 @@ static void crash_handler(int sig) {
  */
 static GtkApplication* global_app = nullptr;
 static std::unique_ptr<TrayIcon> global_tray_icon = nullptr;
+static std::thread background_init_thread;
+
+/**
+ * Bring up what the window does not need for its first frame: trash
+ * metadata, the file index (opening and loading its path tree), the sync
+ * registry and file watcher. Runs once, after the first frame is painted.
+ */
+static void start_background_init() {
+    if (background_init_thread.joinable()) return;
+    background_init_thread = std::thread([]() {
+        auto& timeline = proton::StartupTimeline::getInstance();
+        
+        // Only logged; `rclone version` alone can take longer than first paint
+        FILE* pipe = popen((AppWindowHelpers::get_rclone_path() + " version 2>&1").c_str(), "r");
+        if (pipe) {
+            char buffer[256];
+            if (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
+                Logger::info("[Dependency] Found: " + std::string(buffer));
+            }
+            pclose(pipe);
+        }
+        timeline.mark("rclone version");
+        
+        auto& trash = proton::TrashManager::getInstance();
+        if (trash.initialize()) {
+            Logger::info("[Init] Trash manager initialized");
+        } else {
+            Logger::warn("[Init] Failed to initialize trash manager");
+        }
+        timeline.mark("trash");
+        
+        // With proton-drive-daemon running the window is only a client: the
+        // daemon keeps the engine, cloud monitor, index refresh and mount
+        bool daemon_running = proton::DaemonClient::is_running();
+        if (daemon_running) {
+            Logger::info("[Init] proton-drive-daemon is running - leaving sync to it");
+        } else if (!proton::acquire_engine_lock()) {
+            // Daemon still starting up: it holds the lock but has no bus name yet
+            daemon_running = true;
+            Logger::info("[Init] proton-drive-daemon holds the engine lock - leaving sync to it");
+        }
+        timeline.mark("daemon check");
+        
+        // Initialize file index for cloud file search
+        auto& file_index = FileIndex::getInstance();
+        if (file_index.initialize()) {
+            Logger::info("[Init] File index initialized");
+            
+            // Check if index is empty or stale
+            auto stats = file_index.get_stats();
+            bool is_empty = (stats.total_files == 0 && stats.total_folders == 0);
+            bool is_stale = file_index.needs_refresh(2);  // 2 hours instead of 24
+            
+            if (daemon_running) {
+                // The daemon refreshes it; reads see its writes
+            } else if (is_empty) {
+                Logger::info("[Init] File index is empty, starting initial index...");
+                file_index.start_background_index(true);  // Full index
+            } else if (is_stale) {
+                Logger::info("[Init] File index is stale (>2 hours), starting background refresh...");
+                file_index.start_background_index(false);  // Incremental update
+            } else {
+                Logger::info("[Init] File index is up-to-date (" + std::to_string(stats.total_files) + 
+                            " files, " + std::to_string(stats.total_folders) + " folders)");
+            }
+        } else {
+            Logger::warn("[Init] Failed to initialize file index - search may be limited");
+        }
+        timeline.mark("file index");
+        
+        // Files-on-demand mount serves listings from the index loaded above
+        auto& settings = proton::SettingsManager::getInstance();
+        if (settings.get_mount_enabled() && !daemon_running) {
+            proton::CloudMount::getInstance().start(settings.get_mount_point(), settings.get_mount_cache_size());
+            timeline.mark("cloud mount");
+        }
+        
+        // Ensure default ProtonDrive folder exists
+        if (!SyncJobRegistry::ensureDefaultSyncLocation()) {
+            Logger::warn("[Init] Could not create default ProtonDrive folder - user will need to select custom location for syncs");
+        }
+        
+        // Initialize SyncManager (loads sync jobs, starts file watcher for real-time sync)
+        SyncManager::Observer observer;
+        observer.log = [](const std::string& line) { AppWindow::getInstance().append_log(line); };
+        observer.jobs_changed = []() { AppWindow::getInstance().refresh_sync_jobs(); };
+        observer.remote_changed = []() { CloudBrowser::getInstance().refresh(); };
+        SyncManager::getInstance().set_observer(std::move(observer));
+        SyncManager::getInstance().init(!daemon_running);
+        Logger::info("[Init] SyncManager initialized");
+        timeline.mark("sync manager");
+        timeline.report("Background init finished");
+        
+        proton::TaskPool::post_to_main([]() {
+            AppWindow::getInstance().on_background_init_complete();
+        });
+    });
+}
+
+/**
+ * Wait for start_background_init() so nothing shuts down under it
+ */
+static void join_background_init() {
+    if (background_init_thread.joinable()) background_init_thread.join();
+}
+
+/**
+ * First frame on screen: report window-ready time, then start the rest
+ */
+static void on_first_frame(GdkFrameClock* clock, gpointer /*user_data*/) {
+    g_signal_handlers_disconnect_by_func(clock, reinterpret_cast<gpointer>(on_first_frame), nullptr);
+    proton::StartupTimeline::getInstance().mark("first frame");
+    proton::StartupTimeline::getInstance().report("Window ready", proton::StartupTimeline::WINDOW_READY_BUDGET_MS);
+    start_background_init();
+}
 
 static gboolean shutdown_handler_glib(gpointer /*user_data*/) {
     Logger::info("[Shutdown] Main signal handler called - initiating full application shutdown...");
     
+    // Deferred init may still be opening the index or starting SyncManager
+    join_background_init();
+    
     // Save any pending state
     auto& settings = proton::SettingsManager::getInstance();
     settings.save();
@@ -248,6 +377,15 @@ bool ensure_single_instance() {
     return true;
 }
 
+/**
+ * Whether `program` (a name or an absolute path) is an executable on PATH
+ */
+static bool program_available(const std::string& program) {
+    gchar* found = g_find_program_in_path(program.c_str());
+    g_free(found);
+    return found != nullptr;
+}
+
 /**
  * Check for required dependencies on startup
  * Returns true if all dependencies are satisfied, false otherwise
@@ -255,22 +393,13 @@ bool ensure_single_instance() {
 bool check_dependencies(std::vector<std::string>& missing_deps, std::vector<std::string>& warnings) {
     bool all_ok = true;
     
-    // 1. Check for rclone (CRITICAL - required for sync)
-    std::string rclone_check = "command -v rclone >/dev/null 2>&1";
-    if (system(rclone_check.c_str()) != 0) {
+    // 1. Check for rclone (CRITICAL - required for sync). Looked up
+    // in-process rather than through a shell; the version is logged later
+    // by the background init.
+    if (!program_available(AppWindowHelpers::get_rclone_path())) {
         missing_deps.push_back("rclone - Required for cloud sync operations");
         all_ok = false;
         Logger::error("[Dependency] CRITICAL: rclone not found in PATH");
-    } else {
-        // Check rclone version
-        FILE* pipe = popen("rclone version 2>&1 | head -1", "r");
-        if (pipe) {
-            char buffer[256];
-            if (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
-                Logger::info("[Dependency] Found: " + std::string(buffer));
-            }
-            pclose(pipe);
-        }
     }
     
     // 2. Check for SQLite3 library (CRITICAL - required for file index)
@@ -318,8 +447,7 @@ bool check_dependencies(std::vector<std::string>& missing_deps, std::vector<std:
                  std::to_string(gtk_get_micro_version()));
     
     // 6. Optional: Check for systemd (for sync service management)
-    std::string systemctl_check = "command -v systemctl >/dev/null 2>&1";
-    if (system(systemctl_check.c_str()) != 0) {
+    if (!program_available("systemctl")) {
         warnings.push_back("systemctl not found - recurring sync jobs require systemd");
         Logger::warn("[Dependency] systemctl not found - sync scheduling may be limited");
     } else {
@@ -327,8 +455,7 @@ bool check_dependencies(std::vector<std::string>& missing_deps, std::vector<std:
     }
     
     // 7. Optional: Check for xdg-open (for opening browser)
-    std::string xdg_check = "command -v xdg-open >/dev/null 2>&1";
-    if (system(xdg_check.c_str()) != 0) {
+    if (!program_available("xdg-open")) {
         warnings.push_back("xdg-open not found - OAuth login may require manual browser");
         Logger::warn("[Dependency] xdg-open not found - browser launch may fail");
     }
@@ -440,6 +567,9 @@ void show_dependency_error_dialog(const std::vector<std::string>& missing_deps)
 }
 
 int main(int argc, char* argv[]) {
+    // Startup phases are timed from here
+    auto& startup = proton::StartupTimeline::getInstance();
+    
     // Install crash handlers FIRST
     install_crash_handlers();
     
@@ -456,6 +586,7 @@ int main(int argc, char* argv[]) {
     
     // Parse arguments and build new argv without consumed options
     bool debug_mode = false;
+    std::string trace_file;
     std::vector<char*> new_argv;
     new_argv.push_back(argv[0]);  // Program name
     
@@ -463,12 +594,15 @@ int main(int argc, char* argv[]) {
         std::string arg(argv[i]);
         if (arg == "--debug") {
             debug_mode = true;
+        } else if (arg.rfind("--trace=", 0) == 0) {
+            trace_file = arg.substr(8);
         } else if (arg == "--help" || arg == "-h") {
             std::cout << "Proton Drive Linux Desktop Client\n\n"
                       << "Usage: proton-drive [options]\n\n"
                       << "Options:\n"
-                      << "  --debug    Enable debug logging\n"
-                      << "  --help     Show this help message\n";
+                      << "  --debug         Enable debug logging\n"
+                      << "  --trace=FILE    Record timing spans; written to FILE (Chrome trace JSON) on exit\n"
+                      << "  --help          Show this help message\n";
             return 0;
         } else {
             // Keep unconsumed arguments for GTK
@@ -487,8 +621,15 @@ int main(int argc, char* argv[]) {
     std::filesystem::create_directories(log_dir);
     
     Logger::init(debug_mode ? LogLevel::DEBUG : LogLevel::INFO, log_file);
+    // Write from a background thread so logging never stalls the GTK main loop
+    Logger::start_async();
     Logger::info("Proton Drive Linux - Starting (Native UI)...");
     if (debug_mode) Logger::debug("Debug mode enabled");
+    if (!trace_file.empty()) proton::Trace::set_enabled(true);
+    
+    // Decrypt last session's cloud view while the rest starts up
+    proton::FirstPaintSnapshot::getInstance().preload();
+    startup.mark("logger");
     
     // Check for required dependencies BEFORE initializing anything else
     std::vector<std::string> missing_deps;
@@ -519,52 +660,25 @@ int main(int argc, char* argv[]) {
     }
     
     Logger::info("[Init] All required dependencies satisfied ✓");
+    startup.mark("dependencies");
     
     // Initialize settings
     auto& settings = proton::SettingsManager::getInstance();
     settings.load();
+    Logger::set_tag_levels(settings.get_log_tag_levels());
     Logger::info("[Init] Settings loaded");
     
-    // Initialize trash manager
-    auto& trash = proton::TrashManager::getInstance();
-    if (trash.initialize()) {
-        Logger::info("[Init] Trash manager initialized");
+    // Start the persistent rclone RC daemon so cloud operations reuse one
+    // authenticated session instead of spawning rclone per call
+    if (proton::RcloneRC::getInstance().start(AppWindowHelpers::get_rclone_path())) {
+        Logger::info("[Init] rclone RC daemon starting");
     } else {
-        Logger::warn("[Init] Failed to initialize trash manager");
+        Logger::warn("[Init] rclone RC daemon unavailable - using per-command rclone");
     }
+    startup.mark("settings + rclone daemon");
     
-    // Initialize file index for cloud file search
-    auto& file_index = FileIndex::getInstance();
-    if (file_index.initialize()) {
-        Logger::info("[Init] File index initialized");
-        
-        // Check if index is empty or stale
-        auto stats = file_index.get_stats();
-        bool is_empty = (stats.total_files == 0 && stats.total_folders == 0);
-        bool is_stale = file_index.needs_refresh(2);  // 2 hours instead of 24
-        
-        if (is_empty) {
-            Logger::info("[Init] File index is empty, starting initial index...");
-            file_index.start_background_index(true);  // Full index
-        } else if (is_stale) {
-            Logger::info("[Init] File index is stale (>2 hours), starting background refresh...");
-            file_index.start_background_index(false);  // Incremental update
-        } else {
-            Logger::info("[Init] File index is up-to-date (" + std::to_string(stats.total_files) + 
-                        " files, " + std::to_string(stats.total_folders) + " folders)");
-        }
-    } else {
-        Logger::warn("[Init] Failed to initialize file index - search may be limited");
-    }
-    
-    // Ensure default ProtonDrive folder exists
-    if (!SyncJobRegistry::ensureDefaultSyncLocation()) {
-        Logger::warn("[Init] Could not create default ProtonDrive folder - user will need to select custom location for syncs");
-    }
-    
-    // Initialize SyncManager (starts file watcher for real-time sync)
-    SyncManager::getInstance().init();
-    Logger::info("[Init] SyncManager initialized");
+    // Trash, file index and SyncManager start after the first frame
+    // (start_background_init), so the window never waits on them
     
     // Initialize GTK
 #ifdef USE_GTK4
@@ -573,6 +687,7 @@ int main(int argc, char* argv[]) {
     GtkApplication* app = gtk_application_new("me.proton.drive", G_APPLICATION_FLAGS_NONE);  // Compatible with GTK 4.6+
     global_app = app;  // Store for signal handler
     Logger::debug("[Init] GtkApplication created");
+    startup.mark("gtk init");
     
     // In GTK4, we need to handle the 'activate' signal to create windows
     g_signal_connect(app, "activate", G_CALLBACK(+[](GtkApplication* app, gpointer user_data) {
@@ -590,6 +705,7 @@ int main(int argc, char* argv[]) {
             return;
         }
         Logger::debug("[Activate] AppWindow initialized");
+        proton::StartupTimeline::getInstance().mark("window");
         
         // Initialize notification manager
         proton::NotificationManager::getInstance().init(G_APPLICATION(app));
@@ -617,11 +733,21 @@ int main(int argc, char* argv[]) {
         Logger::debug("[Activate] Initializing tray icon...");
         global_tray_icon->init();
         Logger::debug("[Activate] Tray icon initialized");
+        proton::StartupTimeline::getInstance().mark("notifications + tray");
         
         // Show the main window
         Logger::debug("[Activate] Showing main window...");
         app_window.show();
         Logger::debug("[Activate] Main window shown");
+        proton::StartupTimeline::getInstance().mark("show");
+        
+        // Everything deferred starts once the window is actually on screen
+        GdkFrameClock* clock = gtk_widget_get_frame_clock(window);
+        if (clock) {
+            g_signal_connect(clock, "after-paint", G_CALLBACK(on_first_frame), nullptr);
+        } else {
+            start_background_init();
+        }
         
         // Log startup complete
         app_window.append_log("Proton Drive started");
@@ -629,7 +755,8 @@ int main(int argc, char* argv[]) {
         // Schedule periodic file index refresh every 2 hours (7200000 ms)
         g_timeout_add_seconds(7200, +[](gpointer) -> gboolean {
             auto& file_index = FileIndex::getInstance();
-            if (!file_index.is_indexing()) {
+            // proton-drive-daemon, if running, refreshes it on its own schedule
+            if (!file_index.is_indexing() && SyncManager::getInstance().runs_engine()) {
                 Logger::info("[Index] Scheduled 2-hour refresh starting...");
                 file_index.start_background_index(false);  // Incremental
             }
@@ -671,7 +798,7 @@ int main(int argc, char* argv[]) {
     kill_result = std::system(
         ("pkill -U " + uid_str + " -f 'rclone.*copyto.*proton:' 2>/dev/null").c_str());
     
-    // Stop TrayIcon background thread (status monitoring)
+    // Stop TrayIcon (D-Bus objects, status listener)
     if (global_tray_icon) {
         Logger::debug("[Shutdown] Stopping tray icon...");
         global_tray_icon->stop();
@@ -679,6 +806,9 @@ int main(int argc, char* argv[]) {
         Logger::debug("[Shutdown] Tray icon stopped");
     }
     
+    // Deferred init must be done before its subsystems are shut down
+    join_background_init();
+    
     // Stop AppWindow threads first (CloudMonitor)
     try {
         AppWindow::getInstance().shutdown();
@@ -686,12 +816,24 @@ int main(int argc, char* argv[]) {
         Logger::error("[Shutdown] AppWindow shutdown threw exception");
     }
     
+    // Unmount before the index and RC daemon it reads from go away
+    proton::CloudMount::getInstance().stop();
+    
+    // Drop queued background work before the index and RC daemon go away
+    proton::TaskPool::getInstance().shutdown();
+    
     // Shutdown FileIndex (encrypts database)
     FileIndex::getInstance().shutdown();
     
+    // Stop the rclone RC daemon last - shutdown paths above may still use it
+    proton::RcloneRC::getInstance().stop();
+    
     g_object_unref(app);
     
+    if (!trace_file.empty()) proton::Trace::export_chrome_json(trace_file);
+    
     Logger::info("Proton Drive Linux - Exiting.");
+    Logger::shutdown();
     return status;
 #else
     gtk_init(&argc, &argv);
@@ -717,17 +859,22 @@ int main(int argc, char* argv[]) {
     
     // Show the main window
     app_window.show();
+    start_background_init();
     
     // Log startup complete
     app_window.append_log("Proton Drive started");
     
     // Run main loop
     gtk_main();
+    join_background_init();
+    proton::CloudMount::getInstance().stop();
     
     // Gracefully shutdown FileIndex
     FileIndex::getInstance().shutdown();
+    proton::RcloneRC::getInstance().stop();
     
     Logger::info("Proton Drive Linux - Exiting.");
+    Logger::shutdown();
     return 0;
 #endif
 }
@@ -1,30 +1,57 @@
 #include "network_monitor.hpp"
 #include "logger.hpp"
-#include <cstdlib>
-#include <cstring>
+#include <gio/gio.h>
+#include <glib-unix.h>
 #include <fstream>
+#include <sstream>
+#include <cerrno>
+#include <cstring>
 #include <unistd.h>
-#include <limits.h>
-#include <chrono>
-#include <array>
-#include <memory>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
 
 namespace proton {
 
-// Helper to ensure valid working directory for popen() calls
-static void ensure_valid_cwd() {
-    char cwd[PATH_MAX];
-    if (getcwd(cwd, sizeof(cwd)) == nullptr) {
-        // Current directory is invalid, switch to home or /tmp
-        const char* home = std::getenv("HOME");
-        if (home && chdir(home) == 0) {
-            // Successfully switched
-        } else if (chdir("/tmp") != 0) {
-            // Both attempts failed, but we'll continue anyway
-        }
+namespace {
+
+constexpr const char* NM_BUS_NAME = "org.freedesktop.NetworkManager";
+constexpr const char* NM_OBJECT_PATH = "/org/freedesktop/NetworkManager";
+constexpr const char* NM_INTERFACE = "org.freedesktop.NetworkManager";
+
+// NMConnectivityState / NMMetered values we care about
+constexpr unsigned NM_CONNECTIVITY_UNKNOWN = 0;
+constexpr unsigned NM_CONNECTIVITY_FULL = 4;
+constexpr unsigned NM_METERED_YES = 1;
+constexpr unsigned NM_METERED_GUESS_YES = 3;
+
+// Netlink bursts (link up -> address -> routes) settle into one evaluation
+constexpr guint NETLINK_SETTLE_MS = 250;
+// Without netlink or D-Bus there is no event source; re-read routes slowly
+constexpr guint FALLBACK_INTERVAL_S = 30;
+
+// Read a uint32 property of the NetworkManager root object
+bool get_nm_uint_property(GDBusConnection* bus, const char* name, unsigned& value) {
+    GError* error = nullptr;
+    GVariant* result = g_dbus_connection_call_sync(
+        bus, NM_BUS_NAME, NM_OBJECT_PATH, "org.freedesktop.DBus.Properties", "Get",
+        g_variant_new("(ss)", NM_INTERFACE, name), G_VARIANT_TYPE("(v)"),
+        G_DBUS_CALL_FLAGS_NONE, 2000, nullptr, &error);
+    if (!result) {
+        if (error) g_error_free(error);
+        return false;
     }
+    GVariant* inner = nullptr;
+    g_variant_get(result, "(v)", &inner);
+    bool ok = inner && g_variant_is_of_type(inner, G_VARIANT_TYPE_UINT32);
+    if (ok) value = g_variant_get_uint32(inner);
+    if (inner) g_variant_unref(inner);
+    g_variant_unref(result);
+    return ok;
 }
 
+} // namespace
+
 NetworkMonitor& NetworkMonitor::getInstance() {
     static NetworkMonitor instance;
     return instance;
@@ -36,7 +63,7 @@ NetworkMonitor::~NetworkMonitor() {
 
 void NetworkMonitor::start() {
     if (running_) return;
-    
+
     running_ = true;
     try {
         monitor_thread_ = std::thread(&NetworkMonitor::monitor_loop, this);
@@ -52,10 +79,24 @@ void NetworkMonitor::start() {
 
 void NetworkMonitor::stop() {
     running_ = false;
+    {
+        // Quit from inside the loop's own context so a stop() racing with
+        // startup is seen as soon as the loop begins running
+        std::lock_guard<std::mutex> lock(context_mutex_);
+        if (context_) {
+            GSource* source = g_idle_source_new();
+            g_source_set_callback(source, [](gpointer data) -> gboolean {
+                g_main_loop_quit(static_cast<GMainLoop*>(data));
+                return G_SOURCE_REMOVE;
+            }, loop_, nullptr);
+            g_source_attach(source, context_);
+            g_source_unref(source);
+        }
+    }
     if (monitor_thread_.joinable()) {
         monitor_thread_.join();
+        Logger::info("[NetworkMonitor] Stopped monitoring");
     }
-    Logger::info("[NetworkMonitor] Stopped monitoring");
 }
 
 bool NetworkMonitor::is_online() const {
@@ -67,104 +108,291 @@ bool NetworkMonitor::is_metered() const {
 }
 
 void NetworkMonitor::set_status_callback(StatusCallback callback) {
+    std::lock_guard<std::mutex> lock(callback_mutex_);
     callback_ = std::move(callback);
 }
 
 bool NetworkMonitor::check_connectivity() {
-    // Try multiple methods to check connectivity
-    
-    // Method 1: Check /sys/class/net for carrier status
-    std::vector<std::string> interfaces = {"eth0", "enp0s3", "wlan0", "wlp2s0", "eno1"};
-    
-    for (const auto& iface : interfaces) {
-        std::string carrier_path = "/sys/class/net/" + iface + "/carrier";
-        std::ifstream carrier_file(carrier_path);
-        if (carrier_file.good()) {
-            std::string status;
-            std::getline(carrier_file, status);
-            if (status == "1") {
-                return true;  // Interface has carrier
-            }
-        }
+    NetworkMonitor& monitor = getInstance();
+    if (monitor.running_) return monitor.online_;
+
+    // NetworkManager knows whether the internet (not just a LAN) is reachable
+    GError* error = nullptr;
+    GDBusConnection* bus = g_bus_get_sync(G_BUS_TYPE_SYSTEM, nullptr, &error);
+    if (bus) {
+        unsigned connectivity = NM_CONNECTIVITY_UNKNOWN;
+        bool known = get_nm_uint_property(bus, "Connectivity", connectivity) &&
+                     connectivity != NM_CONNECTIVITY_UNKNOWN;
+        g_object_unref(bus);
+        if (known) return connectivity == NM_CONNECTIVITY_FULL;
+    } else if (error) {
+        g_error_free(error);
     }
-    
-    // Method 2: Try to reach a known endpoint (non-blocking ping)
-    // Using curl with short timeout
-    int result = std::system("curl -s --connect-timeout 2 -o /dev/null https://account.proton.me/api/ping 2>/dev/null");
-    
-    return (result == 0);
+
+    return has_default_route();
 }
 
-bool NetworkMonitor::check_metered_connection() {
-    // Check NetworkManager for metered connection status
-    // Uses nmcli to query
-    ensure_valid_cwd();
-    
-    std::array<char, 128> buffer;
-    std::string result;
-    
-    std::unique_ptr<FILE, decltype(&pclose)> pipe(
-        popen("nmcli -t -f GENERAL.METERED dev show 2>/dev/null | head -1 | cut -d: -f2", "r"),
-        pclose
-    );
-    
-    if (pipe) {
-        while (fgets(buffer.data(), buffer.size(), pipe.get()) != nullptr) {
-            result += buffer.data();
-        }
-        
-        // Trim whitespace
-        while (!result.empty() && (result.back() == '\n' || result.back() == '\r')) {
-            result.pop_back();
-        }
-        
-        // "yes" or "guess-yes" indicates metered
-        if (result == "yes" || result == "guess-yes") {
+bool NetworkMonitor::has_default_route() {
+    // IPv4: Destination 00000000 with RTF_UP on a non-loopback interface
+    std::ifstream route4("/proc/net/route");
+    std::string line;
+    std::getline(route4, line);  // Header
+    while (std::getline(route4, line)) {
+        std::istringstream fields(line);
+        std::string iface, destination, gateway;
+        unsigned flags = 0;
+        if (!(fields >> iface >> destination >> gateway >> std::hex >> flags)) continue;
+        if (iface != "lo" && destination == "00000000" && (flags & 0x1)) return true;
+    }
+
+    // IPv6: ::/0 prefix; the device name is the last column
+    std::ifstream route6("/proc/net/ipv6_route");
+    while (std::getline(route6, line)) {
+        std::istringstream fields(line);
+        std::string destination, prefix_len, column, iface;
+        if (!(fields >> destination >> prefix_len)) continue;
+        while (fields >> column) iface = column;
+        if (iface != "lo" && prefix_len == "00" &&
+            destination.find_first_not_of('0') == std::string::npos) {
             return true;
         }
     }
-    
     return false;
 }
 
+void NetworkMonitor::query_nm_properties() {
+    if (!system_bus_) return;
+    unsigned value = 0;
+    if (get_nm_uint_property(system_bus_, "Connectivity", value)) nm_connectivity_ = value;
+    if (get_nm_uint_property(system_bus_, "Metered", value)) nm_metered_ = value;
+}
+
+void NetworkMonitor::on_nm_property(const std::string& name, unsigned value) {
+    if (name == "Connectivity") {
+        nm_connectivity_ = value;
+    } else if (name == "Metered") {
+        nm_metered_ = value;
+    }
+}
+
+void NetworkMonitor::on_netlink_readable() {
+    // Drain everything queued; the messages only tell us "something changed"
+    char buffer[8192];
+    for (;;) {
+        ssize_t n = recv(netlink_fd_, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (n > 0) continue;
+        if (n < 0 && errno == EINTR) continue;
+        break;  // EAGAIN, or ENOBUFS after an overrun - either way re-evaluate
+    }
+
+    if (settle_source_) return;
+    GSource* source = g_timeout_source_new(NETLINK_SETTLE_MS);
+    g_source_set_callback(source, [](gpointer data) -> gboolean {
+        auto* self = static_cast<NetworkMonitor*>(data);
+        self->settle_source_ = 0;
+        // NetworkManager's PropertiesChanged may trail the kernel event
+        if (self->nm_available_) self->query_nm_properties();
+        self->evaluate();
+        return G_SOURCE_REMOVE;
+    }, this, nullptr);
+    settle_source_ = g_source_attach(source, context_);
+    g_source_unref(source);
+}
+
+void NetworkMonitor::evaluate() {
+    bool now_online;
+    if (nm_available_ && nm_connectivity_ != NM_CONNECTIVITY_UNKNOWN) {
+        // Portal / limited connectivity can't reach Proton either
+        now_online = nm_connectivity_ == NM_CONNECTIVITY_FULL;
+    } else {
+        now_online = has_default_route();
+    }
+    bool now_metered = nm_available_ &&
+                       (nm_metered_ == NM_METERED_YES || nm_metered_ == NM_METERED_GUESS_YES);
+
+    bool was_online = online_.exchange(now_online);
+    bool was_metered = metered_.exchange(now_metered);
+    bool changed = now_online != was_online || now_metered != was_metered;
+
+    if (first_evaluation_) {
+        first_evaluation_ = false;
+        Logger::info(std::string("[NetworkMonitor] Initial state: ") +
+                     (now_online ? "online" : "offline") + (now_metered ? ", metered" : "") +
+                     (nm_available_ ? " (NetworkManager)" : " (routing table)"));
+    }
+    if (!changed) return;
+
+    if (now_online && !was_online) {
+        Logger::info("[NetworkMonitor] Network connection restored");
+    } else if (!now_online && was_online) {
+        Logger::warn("[NetworkMonitor] Network connection lost");
+    }
+
+    if (now_metered && !was_metered) {
+        Logger::info("[NetworkMonitor] Metered connection detected");
+    } else if (!now_metered && was_metered) {
+        Logger::info("[NetworkMonitor] Connection is no longer metered");
+    }
+
+    StatusCallback callback;
+    {
+        std::lock_guard<std::mutex> lock(callback_mutex_);
+        callback = callback_;
+    }
+    if (callback) {
+        callback(now_online, now_metered);
+    }
+}
+
 void NetworkMonitor::monitor_loop() {
-    bool was_online = true;
-    bool was_metered = false;
-    
-    while (running_) {
-        // Check connectivity every 10 seconds
-        bool now_online = check_connectivity();
-        bool now_metered = check_metered_connection();
-        
-        // Update atomic flags
-        online_ = now_online;
-        metered_ = now_metered;
-        
-        // Notify on status change
-        if (now_online != was_online || now_metered != was_metered) {
-            if (now_online && !was_online) {
-                Logger::info("[NetworkMonitor] Network connection restored");
-            } else if (!now_online && was_online) {
-                Logger::warn("[NetworkMonitor] Network connection lost");
-            }
-            
-            if (now_metered && !was_metered) {
-                Logger::info("[NetworkMonitor] Metered connection detected");
-            }
-            
-            if (callback_) {
-                callback_(now_online, now_metered);
-            }
-            
-            was_online = now_online;
-            was_metered = now_metered;
-        }
-        
-        // Sleep for 10 seconds, but check running_ more frequently for fast shutdown
-        for (int i = 0; i < 100 && running_; ++i) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    GMainContext* context = g_main_context_new();
+    g_main_context_push_thread_default(context);
+    GMainLoop* loop = g_main_loop_new(context, FALSE);
+    {
+        std::lock_guard<std::mutex> lock(context_mutex_);
+        context_ = context;
+        loop_ = loop;
+    }
+    first_evaluation_ = true;
+
+    // rtnetlink: link, address and route changes, straight from the kernel
+    netlink_fd_ = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_ROUTE);
+    if (netlink_fd_ >= 0) {
+        sockaddr_nl addr{};
+        addr.nl_family = AF_NETLINK;
+        addr.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR |
+                         RTMGRP_IPV4_ROUTE | RTMGRP_IPV6_ROUTE;
+        if (bind(netlink_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            Logger::warn("[NetworkMonitor] netlink bind failed: " + std::string(strerror(errno)));
+            close(netlink_fd_);
+            netlink_fd_ = -1;
         }
+    } else {
+        Logger::warn("[NetworkMonitor] netlink socket failed: " + std::string(strerror(errno)));
+    }
+    GSource* netlink_source = nullptr;
+    if (netlink_fd_ >= 0) {
+        netlink_source = g_unix_fd_source_new(netlink_fd_, G_IO_IN);
+        g_source_set_callback(netlink_source, G_SOURCE_FUNC(+[](gint, GIOCondition, gpointer data) -> gboolean {
+            static_cast<NetworkMonitor*>(data)->on_netlink_readable();
+            return G_SOURCE_CONTINUE;
+        }), this, nullptr);
+        g_source_attach(netlink_source, context);
+    }
+
+    // NetworkManager: Connectivity / Metered property changes
+    GError* error = nullptr;
+    system_bus_ = g_bus_get_sync(G_BUS_TYPE_SYSTEM, nullptr, &error);
+    if (!system_bus_) {
+        Logger::warn("[NetworkMonitor] System bus unavailable: " +
+                     std::string(error ? error->message : "unknown error"));
+        if (error) g_error_free(error);
+    }
+
+    guint properties_subscription = 0;
+    guint name_watch = 0;
+    if (system_bus_) {
+        properties_subscription = g_dbus_connection_signal_subscribe(
+            system_bus_, NM_BUS_NAME, "org.freedesktop.DBus.Properties", "PropertiesChanged",
+            NM_OBJECT_PATH, NM_INTERFACE, G_DBUS_SIGNAL_FLAGS_NONE,
+            [](GDBusConnection*, const gchar*, const gchar*, const gchar*, const gchar*,
+               GVariant* parameters, gpointer data) {
+                auto* self = static_cast<NetworkMonitor*>(data);
+                GVariant* changed = nullptr;
+                g_variant_get(parameters, "(s@a{sv}@as)", nullptr, &changed, nullptr);
+                GVariantIter iter;
+                const gchar* key = nullptr;
+                GVariant* value = nullptr;
+                bool relevant = false;
+                g_variant_iter_init(&iter, changed);
+                while (g_variant_iter_next(&iter, "{&sv}", &key, &value)) {
+                    if (g_variant_is_of_type(value, G_VARIANT_TYPE_UINT32)) {
+                        std::string name(key);
+                        if (name == "Connectivity" || name == "Metered") {
+                            self->on_nm_property(name, g_variant_get_uint32(value));
+                            relevant = true;
+                        }
+                    }
+                    g_variant_unref(value);
+                }
+                g_variant_unref(changed);
+                if (relevant) self->evaluate();
+            },
+            this, nullptr);
+
+        // Called once right away with the current owner (or lack of one)
+        name_watch = g_bus_watch_name_on_connection(
+            system_bus_, NM_BUS_NAME, G_BUS_NAME_WATCHER_FLAGS_NONE,
+            [](GDBusConnection*, const gchar*, const gchar*, gpointer data) {
+                auto* self = static_cast<NetworkMonitor*>(data);
+                self->nm_available_ = true;
+                self->query_nm_properties();
+                self->evaluate();
+            },
+            [](GDBusConnection*, const gchar*, gpointer data) {
+                auto* self = static_cast<NetworkMonitor*>(data);
+                bool was_available = self->nm_available_;
+                self->nm_available_ = false;
+                self->nm_connectivity_ = NM_CONNECTIVITY_UNKNOWN;
+                self->nm_metered_ = 0;
+                if (was_available) Logger::warn("[NetworkMonitor] NetworkManager left the bus");
+                self->evaluate();
+            },
+            this, nullptr);
+    } else {
+        evaluate();
+    }
+
+    GSource* fallback_source = nullptr;
+    if (netlink_fd_ < 0 && !system_bus_) {
+        fallback_source = g_timeout_source_new_seconds(FALLBACK_INTERVAL_S);
+        g_source_set_callback(fallback_source, [](gpointer data) -> gboolean {
+            static_cast<NetworkMonitor*>(data)->evaluate();
+            return G_SOURCE_CONTINUE;
+        }, this, nullptr);
+        g_source_attach(fallback_source, context);
+    }
+
+    if (running_) {
+        g_main_loop_run(loop);
+    }
+
+    // Teardown on this thread: signal handlers belong to this context
+    if (name_watch) g_bus_unwatch_name(name_watch);
+    if (properties_subscription) g_dbus_connection_signal_unsubscribe(system_bus_, properties_subscription);
+    if (system_bus_) {
+        g_object_unref(system_bus_);
+        system_bus_ = nullptr;
+    }
+    if (fallback_source) {
+        g_source_destroy(fallback_source);
+        g_source_unref(fallback_source);
+    }
+    if (settle_source_) {
+        GSource* settle = g_main_context_find_source_by_id(context, settle_source_);
+        if (settle) g_source_destroy(settle);
+        settle_source_ = 0;
+    }
+    if (netlink_source) {
+        g_source_destroy(netlink_source);
+        g_source_unref(netlink_source);
+    }
+    if (netlink_fd_ >= 0) {
+        close(netlink_fd_);
+        netlink_fd_ = -1;
+    }
+    nm_available_ = false;
+
+    {
+        std::lock_guard<std::mutex> lock(context_mutex_);
+        context_ = nullptr;
+        loop_ = nullptr;
     }
+    // Run anything still pending (e.g. a late quit request) before dropping the context
+    while (g_main_context_iteration(context, FALSE)) {}
+    g_main_loop_unref(loop);
+    g_main_context_pop_thread_default(context);
+    g_main_context_unref(context);
 }
 
 } // namespace proton
@@ -4,51 +4,79 @@
 #include <functional>
 #include <atomic>
 #include <thread>
+#include <mutex>
+#include <gio/gio.h>
 
 namespace proton {
 
 /**
  * Network Monitor
- * 
+ *
  * Monitors network connectivity and status to:
  * - Pause sync when offline
  * - Detect metered connections
  * - Resume sync when back online
+ *
+ * Event driven: NetworkManager's Connectivity/Metered properties are
+ * followed over D-Bus and rtnetlink link/address/route events are read
+ * from a netlink socket, both on one thread running its own GMainContext.
+ * Nothing is polled and no processes are spawned. Without NetworkManager
+ * the state comes from the kernel routing table alone.
  */
 class NetworkMonitor {
 public:
     static NetworkMonitor& getInstance();
-    
+
     // Start/stop monitoring
     void start();
     void stop();
-    
+
     // Status queries
     bool is_online() const;
     bool is_metered() const;
-    
-    // Callbacks
+
+    // Callbacks (invoked on the monitor thread)
     using StatusCallback = std::function<void(bool online, bool metered)>;
     void set_status_callback(StatusCallback callback);
-    
+
     // Check connectivity (one-shot check)
     static bool check_connectivity();
-    
+
 private:
     NetworkMonitor() = default;
     ~NetworkMonitor();
-    
+
     NetworkMonitor(const NetworkMonitor&) = delete;
     NetworkMonitor& operator=(const NetworkMonitor&) = delete;
-    
+
     void monitor_loop();
-    bool check_metered_connection();
-    
+
+    // Event sources (monitor thread)
+    void query_nm_properties();
+    void on_nm_property(const std::string& name, unsigned value);
+    void on_netlink_readable();
+    void evaluate();
+
+    static bool has_default_route();
+
     std::atomic<bool> online_{true};
     std::atomic<bool> metered_{false};
     std::atomic<bool> running_{false};
     std::thread monitor_thread_;
+    std::mutex callback_mutex_;
     StatusCallback callback_;
+
+    // Monitor thread state
+    std::mutex context_mutex_;        // Guards context_ for stop()
+    GMainContext* context_ = nullptr;
+    GMainLoop* loop_ = nullptr;
+    GDBusConnection* system_bus_ = nullptr;
+    bool nm_available_ = false;
+    unsigned nm_connectivity_ = 0;    // NMConnectivityState
+    unsigned nm_metered_ = 0;         // NMMetered
+    int netlink_fd_ = -1;
+    unsigned settle_source_ = 0;      // Coalesces netlink bursts
+    bool first_evaluation_ = true;
 };
 
 } // namespace proton
@@ -0,0 +1,626 @@
+// path_tree.cpp - Memory-resident mirror of the file index's path hierarchy
+
+#include "path_tree.hpp"
+#include "file_index.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+
+namespace proton {
+
+namespace {
+
+// Splits "proton:/a/b/" into the root "proton:" and segments a, b
+bool split_path(std::string_view path, std::string_view& root, std::vector<std::string_view>& segments) {
+    size_t colon = path.find(':');
+    if (colon == std::string_view::npos) return false;
+    root = path.substr(0, colon + 1);
+    segments.clear();
+    size_t pos = colon + 1;
+    while (pos < path.size()) {
+        size_t slash = path.find('/', pos);
+        if (slash == std::string_view::npos) slash = path.size();
+        if (slash > pos) segments.push_back(path.substr(pos, slash - pos));
+        pos = slash + 1;
+    }
+    return true;
+}
+
+size_t mix(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return static_cast<size_t>(key);
+}
+
+// Days since 1970-01-01 for a proleptic Gregorian date
+int64_t days_from_civil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+void civil_from_days(int64_t z, int64_t& y, unsigned& m, unsigned& d) {
+    z += 719468;
+    const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = static_cast<int64_t>(yoe) + era * 400 + (m <= 2);
+}
+
+// mtime_fmt_ layout: bits 0-29 fraction, 30-33 fraction digits,
+// 34-35 zone kind, 36-47 offset minutes + 1440. The index truncates
+// ModTimes to "YYYY-MM-DDTHH:MM:SS" UTC (as cloud_mount's index_time()
+// reads them); ZONE_NONE keeps that form, with no suffix to write back.
+enum ZoneKind : uint64_t { ZONE_EMPTY = 0, ZONE_UTC = 1, ZONE_OFFSET = 2, ZONE_NONE = 3 };
+
+// Fixed-width decimal field at s[pos]; views need not be NUL-terminated
+bool digits_at(std::string_view s, size_t pos, size_t width, int& out) {
+    if (pos + width > s.size()) return false;
+    out = 0;
+    for (size_t i = pos; i < pos + width; i++) {
+        if (s[i] < '0' || s[i] > '9') return false;
+        out = out * 10 + (s[i] - '0');
+    }
+    return true;
+}
+
+bool parse_rfc3339(std::string_view s, int64_t& secs, uint64_t& fmt) {
+    int year, month, day, hour, minute, second;
+    if (s.size() < 19 || s[4] != '-' || s[7] != '-' || s[10] != 'T' || s[13] != ':' || s[16] != ':' ||
+        !digits_at(s, 0, 4, year) || !digits_at(s, 5, 2, month) || !digits_at(s, 8, 2, day) ||
+        !digits_at(s, 11, 2, hour) || !digits_at(s, 14, 2, minute) || !digits_at(s, 17, 2, second)) {
+        return false;
+    }
+    size_t pos = 19;
+    uint64_t fraction = 0, digits = 0;
+    if (pos < s.size() && s[pos] == '.') {
+        ++pos;
+        while (pos < s.size() && s[pos] >= '0' && s[pos] <= '9' && digits < 9) {
+            fraction = fraction * 10 + static_cast<uint64_t>(s[pos++] - '0');
+            ++digits;
+        }
+        if (digits == 0) return false;
+    }
+    uint64_t zone, offset = 1440;
+    if (pos == s.size()) {
+        zone = ZONE_NONE;
+    } else if (s[pos] == 'Z') {
+        zone = ZONE_UTC;
+        ++pos;
+    } else if (pos + 6 == s.size() && (s[pos] == '+' || s[pos] == '-') && s[pos + 3] == ':') {
+        int oh = 0, om = 0;
+        if (!digits_at(s, pos + 1, 2, oh) || !digits_at(s, pos + 4, 2, om)) return false;
+        int minutes = (oh * 60 + om) * (s[pos] == '-' ? -1 : 1);
+        if (minutes < -1440 || minutes > 1440) return false;
+        zone = ZONE_OFFSET;
+        offset = static_cast<uint64_t>(minutes + 1440);
+        pos += 6;
+    } else {
+        return false;
+    }
+    if (pos != s.size()) return false;
+
+    secs = days_from_civil(year, static_cast<unsigned>(month), static_cast<unsigned>(day)) * 86400 +
+           hour * 3600 + minute * 60 + second;
+    fmt = fraction | (digits << 30) | (zone << 34) | (offset << 36);
+    return true;
+}
+
+std::string format_rfc3339(int64_t secs, uint64_t fmt) {
+    uint64_t zone = (fmt >> 34) & 0x3;
+    if (zone == ZONE_EMPTY) return "";
+    int64_t days = secs >= 0 ? secs / 86400 : (secs - 86399) / 86400;
+    int64_t rem = secs - days * 86400;
+    int64_t y;
+    unsigned m, d;
+    civil_from_days(days, y, m, d);
+
+    char buf[64];
+    int n = std::snprintf(buf, sizeof(buf), "%04lld-%02u-%02uT%02lld:%02lld:%02lld", static_cast<long long>(y), m, d,
+                          static_cast<long long>(rem / 3600), static_cast<long long>(rem / 60 % 60),
+                          static_cast<long long>(rem % 60));
+    std::string out(buf, static_cast<size_t>(n));
+    uint64_t digits = (fmt >> 30) & 0xF;
+    if (digits > 0) {
+        std::snprintf(buf, sizeof(buf), ".%0*llu", static_cast<int>(digits),
+                      static_cast<unsigned long long>(fmt & 0x3FFFFFFF));
+        out += buf;
+    }
+    if (zone == ZONE_UTC) {
+        out += 'Z';
+    } else if (zone == ZONE_OFFSET) {
+        int minutes = static_cast<int>((fmt >> 36) & 0xFFF) - 1440;
+        std::snprintf(buf, sizeof(buf), "%c%02d:%02d", minutes < 0 ? '-' : '+', std::abs(minutes) / 60,
+                      std::abs(minutes) % 60);
+        out += buf;
+    }
+    return out;
+}
+
+// Buckets, one heap node per entry, and string storage past the SSO buffer
+size_t side_table_bytes(const std::unordered_map<uint32_t, std::string>& table) {
+    size_t bytes = table.bucket_count() * sizeof(void*);
+    const size_t inline_capacity = std::string().capacity();
+    for (const auto& [node, text] : table) {
+        bytes += sizeof(void*) + sizeof(std::pair<const uint32_t, std::string>);
+        if (text.capacity() > inline_capacity) bytes += text.capacity() + 1;
+    }
+    return bytes;
+}
+
+// Instant the packed ModTime names, or false for empty ones
+bool utc_seconds(int64_t secs, uint64_t fmt, int64_t& out) {
+    uint64_t zone = (fmt >> 34) & 0x3;
+    if (zone == ZONE_EMPTY) return false;
+    out = zone == ZONE_OFFSET ? secs - (static_cast<int64_t>((fmt >> 36) & 0xFFF) - 1440) * 60 : secs;
+    return true;
+}
+
+} // namespace
+
+bool PathTree::loaded() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return loaded_;
+}
+
+void PathTree::replace_with(PathTree& fresh) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    pool_.swap(fresh.pool_);
+    seg_offset_.swap(fresh.seg_offset_);
+    seg_slots_.swap(fresh.seg_slots_);
+    seg_.swap(fresh.seg_);
+    parent_.swap(fresh.parent_);
+    first_child_.swap(fresh.first_child_);
+    next_sibling_.swap(fresh.next_sibling_);
+    size_.swap(fresh.size_);
+    mtime_secs_.swap(fresh.mtime_secs_);
+    mtime_fmt_.swap(fresh.mtime_fmt_);
+    flags_.swap(fresh.flags_);
+    node_slots_.swap(fresh.node_slots_);
+    agg_files_.swap(fresh.agg_files_);
+    agg_folders_.swap(fresh.agg_folders_);
+    agg_bytes_.swap(fresh.agg_bytes_);
+    agg_newest_.swap(fresh.agg_newest_);
+    roots_.swap(fresh.roots_);
+    local_paths_.swap(fresh.local_paths_);
+    raw_mtimes_.swap(fresh.raw_mtimes_);
+    std::swap(rows_, fresh.rows_);
+    loaded_ = true;
+}
+
+void PathTree::reset() {
+    PathTree empty;
+    replace_with(empty);
+}
+
+// ----------------------------------------------------------------------------
+// Interning and node lookup (callers hold the lock)
+// ----------------------------------------------------------------------------
+
+std::string_view PathTree::segment(uint32_t id) const {
+    return std::string_view(pool_).substr(seg_offset_[id], seg_offset_[id + 1] - seg_offset_[id]);
+}
+
+uint32_t PathTree::intern(std::string_view name) {
+    size_t count = seg_offset_.size() - 1;
+    if (seg_slots_.empty() || (count + 1) * 2 > seg_slots_.size()) {
+        std::vector<uint32_t> slots(std::max<size_t>(1024, seg_slots_.size() * 2), NONE);
+        size_t mask = slots.size() - 1;
+        for (uint32_t id = 0; id < count; ++id) {
+            size_t i = std::hash<std::string_view>{}(segment(id)) & mask;
+            while (slots[i] != NONE) i = (i + 1) & mask;
+            slots[i] = id;
+        }
+        seg_slots_.swap(slots);
+    }
+    size_t mask = seg_slots_.size() - 1;
+    size_t i = std::hash<std::string_view>{}(name) & mask;
+    for (; seg_slots_[i] != NONE; i = (i + 1) & mask) {
+        if (segment(seg_slots_[i]) == name) return seg_slots_[i];
+    }
+    uint32_t id = static_cast<uint32_t>(count);
+    pool_.append(name.data(), name.size());
+    seg_offset_.push_back(static_cast<uint32_t>(pool_.size()));
+    seg_slots_[i] = id;
+    return id;
+}
+
+uint32_t PathTree::child(uint32_t parent, uint32_t seg) const {
+    if (node_slots_.empty()) return NONE;
+    size_t mask = node_slots_.size() - 1;
+    for (size_t i = mix((uint64_t(parent) << 32) | seg) & mask; node_slots_[i] != NONE; i = (i + 1) & mask) {
+        uint32_t node = node_slots_[i];
+        if (parent_[node] == parent && seg_[node] == seg) return node;
+    }
+    return NONE;
+}
+
+void PathTree::grow_node_slots() {
+    std::vector<uint32_t> slots(std::max<size_t>(1024, node_slots_.size() * 2), NONE);
+    size_t mask = slots.size() - 1;
+    for (uint32_t node = 0; node < seg_.size(); ++node) {
+        if (parent_[node] == NONE) continue;  // Roots are found through roots_
+        size_t i = mix((uint64_t(parent_[node]) << 32) | seg_[node]) & mask;
+        while (slots[i] != NONE) i = (i + 1) & mask;
+        slots[i] = node;
+    }
+    node_slots_.swap(slots);
+}
+
+uint32_t PathTree::add_node(uint32_t parent, uint32_t seg) {
+    uint32_t node = static_cast<uint32_t>(seg_.size());
+    seg_.push_back(seg);
+    parent_.push_back(parent);
+    first_child_.push_back(NONE);
+    next_sibling_.push_back(NONE);
+    size_.push_back(-1);
+    mtime_secs_.push_back(0);
+    mtime_fmt_.push_back(0);
+    flags_.push_back(0);
+    agg_files_.push_back(0);
+    agg_folders_.push_back(0);
+    agg_bytes_.push_back(0);
+    agg_newest_.push_back(NO_TIME);
+    if (parent == NONE) return node;
+
+    next_sibling_[node] = first_child_[parent];
+    first_child_[parent] = node;
+    if ((seg_.size() + 1) * 2 > node_slots_.size()) {
+        grow_node_slots();  // Inserts the new node too
+    } else {
+        size_t mask = node_slots_.size() - 1;
+        size_t i = mix((uint64_t(parent) << 32) | seg) & mask;
+        while (node_slots_[i] != NONE) i = (i + 1) & mask;
+        node_slots_[i] = node;
+    }
+    return node;
+}
+
+uint32_t PathTree::find(const std::string& path) const {
+    std::string_view root;
+    std::vector<std::string_view> segments;
+    if (!split_path(path, root, segments)) return NONE;
+    auto it = roots_.find(std::string(root));
+    if (it == roots_.end()) return NONE;
+    uint32_t node = it->second;
+    if (segments.empty()) return node;
+    if (seg_slots_.empty()) return NONE;
+
+    // Segments never interned cannot name a node; look them up read-only
+    size_t mask = seg_slots_.size() - 1;
+    for (auto name : segments) {
+        uint32_t seg = NONE;
+        for (size_t i = std::hash<std::string_view>{}(name) & mask; seg_slots_[i] != NONE; i = (i + 1) & mask) {
+            if (segment(seg_slots_[i]) == name) {
+                seg = seg_slots_[i];
+                break;
+            }
+        }
+        if (seg == NONE) return NONE;
+        node = child(node, seg);
+        if (node == NONE) return NONE;
+    }
+    return node;
+}
+
+uint32_t PathTree::ensure(std::string_view path) {
+    std::string_view root;
+    std::vector<std::string_view> segments;
+    if (!split_path(path, root, segments)) return NONE;
+    auto it = roots_.find(std::string(root));
+    uint32_t node;
+    if (it != roots_.end()) {
+        node = it->second;
+    } else {
+        node = add_node(NONE, intern(root));
+        flags_[node] = DIR;
+        roots_.emplace(std::string(root), node);
+    }
+    for (auto name : segments) {
+        uint32_t seg = intern(name);
+        uint32_t next = child(node, seg);
+        if (next == NONE) {
+            next = add_node(node, seg);
+            flags_[next] = DIR;  // Until the entry itself shows up
+        }
+        node = next;
+    }
+    return node;
+}
+
+std::string PathTree::full_path(uint32_t node) const {
+    std::vector<uint32_t> chain;
+    for (uint32_t n = node; n != NONE; n = parent_[n]) chain.push_back(n);
+    std::string path(segment(seg_[chain.back()]));  // "proton:"
+    if (chain.size() == 1) return path + "/";
+    for (auto it = chain.rbegin() + 1; it != chain.rend(); ++it) {
+        path += '/';
+        path += segment(seg_[*it]);
+    }
+    return path;
+}
+
+// ----------------------------------------------------------------------------
+// ModTimes
+// ----------------------------------------------------------------------------
+
+void PathTree::set_mtime(uint32_t node, std::string_view mod_time) {
+    int64_t secs = 0;
+    uint64_t fmt = 0;
+    bool packed = mod_time.empty() || (parse_rfc3339(mod_time, secs, fmt) && format_rfc3339(secs, fmt) == mod_time);
+    if (packed) {
+        mtime_secs_[node] = secs;
+        mtime_fmt_[node] = fmt;
+        flags_[node] &= ~RAW_MTIME;
+        raw_mtimes_.erase(node);
+    } else {
+        flags_[node] |= RAW_MTIME;
+        raw_mtimes_[node].assign(mod_time);
+    }
+}
+
+std::string PathTree::mtime(uint32_t node) const {
+    if (flags_[node] & RAW_MTIME) {
+        auto it = raw_mtimes_.find(node);
+        return it != raw_mtimes_.end() ? it->second : "";
+    }
+    return format_rfc3339(mtime_secs_[node], mtime_fmt_[node]);
+}
+
+// ----------------------------------------------------------------------------
+// Aggregates (callers hold the lock)
+// ----------------------------------------------------------------------------
+
+int64_t PathTree::own_newest(uint32_t node) const {
+    int64_t time;
+    if ((flags_[node] & (ROW | DIR | RAW_MTIME)) != ROW) return NO_TIME;
+    return utc_seconds(mtime_secs_[node], mtime_fmt_[node], time) ? time : NO_TIME;
+}
+
+void PathTree::add_to_ancestors(uint32_t node, int64_t files, int64_t folders, int64_t bytes) {
+    if (files == 0 && folders == 0 && bytes == 0) return;
+    for (uint32_t n = parent_[node]; n != NONE; n = parent_[n]) {
+        agg_files_[n] = static_cast<uint32_t>(agg_files_[n] + files);
+        agg_folders_[n] = static_cast<uint32_t>(agg_folders_[n] + folders);
+        agg_bytes_[n] += bytes;
+    }
+}
+
+void PathTree::raise_newest(uint32_t from, int64_t time) {
+    for (uint32_t n = from; n != NONE && agg_newest_[n] < time; n = parent_[n]) agg_newest_[n] = time;
+}
+
+// `time` left the subtree of `from`; only ancestors whose maximum it was
+// need their children rescanned, and the climb stops once one keeps it
+void PathTree::lower_newest(uint32_t from, int64_t time) {
+    if (time == NO_TIME) return;
+    for (uint32_t n = from; n != NONE && agg_newest_[n] == time; n = parent_[n]) {
+        int64_t newest = NO_TIME;
+        for (uint32_t c = first_child_[n]; c != NONE; c = next_sibling_[c]) {
+            newest = std::max({newest, own_newest(c), agg_newest_[c]});
+        }
+        agg_newest_[n] = newest;
+        if (newest == time) break;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Writes
+// ----------------------------------------------------------------------------
+
+void PathTree::upsert(const IndexedFile& file) {
+    upsert(IndexedFileRef::of(file));
+}
+
+void PathTree::upsert(const IndexedFileRef& file) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    uint32_t node = ensure(file.path);
+    if (node == NONE || parent_[node] == NONE) return;
+
+    bool was_row = flags_[node] & ROW, was_dir = flags_[node] & DIR;
+    int64_t old_bytes = was_row && !was_dir && size_[node] > 0 ? size_[node] : 0;
+    int64_t old_newest = own_newest(node);
+    if (!was_row) rows_++;
+
+    flags_[node] = static_cast<uint8_t>(ROW | (file.is_directory ? DIR : 0) | (file.is_synced ? SYNCED : 0));
+    size_[node] = file.size;
+    set_mtime(node, file.mod_time);
+    if (file.local_path.empty()) local_paths_.erase(node);
+    else local_paths_[node].assign(file.local_path);
+
+    int64_t old_files = was_row && !was_dir, old_folders = was_row && was_dir;
+    int64_t bytes = !file.is_directory && file.size > 0 ? file.size : 0;
+    add_to_ancestors(node, int64_t(!file.is_directory) - old_files, int64_t(file.is_directory) - old_folders,
+                     bytes - old_bytes);
+    int64_t newest = own_newest(node);
+    if (newest > old_newest) raise_newest(parent_[node], newest);
+    else if (newest < old_newest) lower_newest(parent_[node], old_newest);
+}
+
+void PathTree::set_sync_status(const std::string& path, bool synced, const std::string& local_path) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    uint32_t node = find(path);
+    if (node == NONE || !(flags_[node] & ROW)) return;
+    if (synced) flags_[node] |= SYNCED;
+    else flags_[node] &= ~SYNCED;
+    if (local_path.empty()) local_paths_.erase(node);
+    else local_paths_[node] = local_path;
+}
+
+void PathTree::mark_synced(const std::string& folder, const std::string& local_root) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    uint32_t top = find(folder);
+    if (top == NONE) return;
+
+    // Depth-first with the relative path built alongside
+    std::vector<std::pair<uint32_t, std::string>> stack;
+    for (uint32_t c = first_child_[top]; c != NONE; c = next_sibling_[c]) {
+        stack.emplace_back(c, std::string(segment(seg_[c])));
+    }
+    while (!stack.empty()) {
+        auto [node, rel] = std::move(stack.back());
+        stack.pop_back();
+        if ((flags_[node] & ROW) && !(flags_[node] & SYNCED)) {
+            flags_[node] |= SYNCED;
+            local_paths_[node] = local_root + "/" + rel;
+        }
+        for (uint32_t c = first_child_[node]; c != NONE; c = next_sibling_[c]) {
+            stack.emplace_back(c, rel + "/" + std::string(segment(seg_[c])));
+        }
+    }
+}
+
+int64_t PathTree::clear_subtree(uint32_t top) {
+    bool row = flags_[top] & ROW, dir = flags_[top] & DIR;
+    int64_t newest = std::max(own_newest(top), agg_newest_[top]);
+    add_to_ancestors(top, -(int64_t(row && !dir) + agg_files_[top]), -(int64_t(row && dir) + agg_folders_[top]),
+                     -((row && !dir && size_[top] > 0 ? size_[top] : 0) + agg_bytes_[top]));
+
+    std::vector<uint32_t> stack{top};
+    while (!stack.empty()) {
+        uint32_t node = stack.back();
+        stack.pop_back();
+        if (flags_[node] & ROW) rows_--;
+        flags_[node] &= DIR;
+        local_paths_.erase(node);
+        raw_mtimes_.erase(node);
+        agg_files_[node] = 0;
+        agg_folders_[node] = 0;
+        agg_bytes_[node] = 0;
+        agg_newest_[node] = NO_TIME;
+        for (uint32_t c = first_child_[node]; c != NONE; c = next_sibling_[c]) stack.push_back(c);
+    }
+    return newest;
+}
+
+void PathTree::remove(const std::string& path) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    uint32_t node = find(path);
+    if (node == NONE || !(flags_[node] & ROW)) return;
+    // Only the entry goes; anything indexed below it still counts
+    bool dir = flags_[node] & DIR;
+    add_to_ancestors(node, -int64_t(!dir), -int64_t(dir), !dir && size_[node] > 0 ? -size_[node] : 0);
+    int64_t newest = own_newest(node);
+    rows_--;
+    flags_[node] &= DIR;
+    local_paths_.erase(node);
+    raw_mtimes_.erase(node);
+    lower_newest(parent_[node], newest);
+}
+
+void PathTree::remove_tree(const std::string& path) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    uint32_t node = find(path);
+    if (node != NONE && parent_[node] != NONE) lower_newest(parent_[node], clear_subtree(node));
+}
+
+void PathTree::prune(const std::string& parent, const std::set<std::string>& seen) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    uint32_t node = find(parent);
+    if (node == NONE) return;
+    std::string prefix = full_path(node);
+    if (prefix.back() != '/') prefix += '/';
+    int64_t newest = NO_TIME;
+    for (uint32_t c = first_child_[node]; c != NONE; c = next_sibling_[c]) {
+        if ((flags_[c] & ROW) && !seen.count(prefix + std::string(segment(seg_[c])))) {
+            newest = std::max(newest, clear_subtree(c));
+        }
+    }
+    lower_newest(node, newest);  // Once for the whole batch
+}
+
+// ----------------------------------------------------------------------------
+// Reads
+// ----------------------------------------------------------------------------
+
+IndexedFile PathTree::make_file(uint32_t node, const std::string& parent_path) const {
+    IndexedFile file{};
+    file.id = 0;  // Row ids are not mirrored
+    file.name = std::string(segment(seg_[node]));
+    file.parent_path = parent_path;
+    file.path = parent_path.back() == '/' ? parent_path + file.name : parent_path + "/" + file.name;
+    file.size = size_[node];
+    file.mod_time = mtime(node);
+    file.is_directory = flags_[node] & DIR;
+    file.is_synced = flags_[node] & SYNCED;
+    auto local = local_paths_.find(node);
+    if (local != local_paths_.end()) file.local_path = local->second;
+    file.extension = file.is_directory ? "" : FileIndex::get_extension(file.name);
+    file.relevance_score = 0.0;
+    return file;
+}
+
+bool PathTree::list(const std::string& folder, std::vector<IndexedFile>& out) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    if (!loaded_) return false;
+    uint32_t node = find(folder);
+    if (node == NONE) return true;
+
+    std::vector<uint32_t> children;
+    for (uint32_t c = first_child_[node]; c != NONE; c = next_sibling_[c]) {
+        if (flags_[c] & ROW) children.push_back(c);
+    }
+    std::sort(children.begin(), children.end(), [this](uint32_t a, uint32_t b) {
+        bool a_dir = flags_[a] & DIR, b_dir = flags_[b] & DIR;
+        if (a_dir != b_dir) return a_dir;
+        return segment(seg_[a]) < segment(seg_[b]);
+    });
+
+    std::string parent_path = full_path(node);
+    out.reserve(out.size() + children.size());
+    for (uint32_t c : children) out.push_back(make_file(c, parent_path));
+    return true;
+}
+
+int PathTree::exists(const std::string& path) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    if (!loaded_) return -1;
+    uint32_t node = find(path);
+    return node != NONE && (flags_[node] & ROW) ? 1 : 0;
+}
+
+bool PathTree::summarize(const std::string& folder, Summary& out) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    if (!loaded_) return false;
+    uint32_t top = find(folder);
+    if (top == NONE) return false;
+
+    out.files = agg_files_[top];
+    out.folders = agg_folders_[top];
+    out.bytes = agg_bytes_[top];
+    out.newest = agg_newest_[top] == NO_TIME ? 0 : agg_newest_[top];
+    return true;
+}
+
+size_t PathTree::entry_count() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return rows_;
+}
+
+size_t PathTree::memory_bytes() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    size_t bytes = pool_.capacity() + (seg_offset_.capacity() + seg_slots_.capacity()) * sizeof(uint32_t);
+    bytes += (seg_.capacity() + parent_.capacity() + first_child_.capacity() + next_sibling_.capacity() +
+              node_slots_.capacity() + agg_files_.capacity() + agg_folders_.capacity()) * sizeof(uint32_t);
+    bytes += (size_.capacity() + mtime_secs_.capacity() + mtime_fmt_.capacity() + agg_bytes_.capacity() +
+              agg_newest_.capacity()) * sizeof(int64_t);
+    bytes += flags_.capacity();
+    bytes += side_table_bytes(local_paths_) + side_table_bytes(raw_mtimes_);
+    return bytes;
+}
+
+bool PathTree::needs_compaction() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return seg_.size() > 100000 && seg_.size() > rows_ * 2;
+}
+
+} // namespace proton
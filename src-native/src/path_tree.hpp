@@ -0,0 +1,142 @@
+// path_tree.hpp - Memory-resident mirror of the file index's path hierarchy
+// Holds every indexed entry as a node with a parent id and an interned name
+// segment instead of full path strings; sizes, modification times and flags
+// live in parallel arrays. FileIndex loads it once from SQLite and replays
+// each committed write into it, so directory listings and existence checks
+// are answered from RAM. ModTimes are stored as packed fields and rendered
+// back to the exact text they came in as: RFC 3339 from rclone, or the
+// index's zone-less UTC "YYYY-MM-DDTHH:MM:SS". Every node also carries
+// recursive file/folder counts, bytes and the newest file ModTime of what
+// lies below it, kept current along the ancestor chain on each write.
+
+#ifndef PATH_TREE_HPP
+#define PATH_TREE_HPP
+
+#include <cstdint>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct IndexedFile;
+struct IndexedFileRef;
+
+namespace proton {
+
+class PathTree {
+public:
+    PathTree() = default;
+    PathTree(const PathTree&) = delete;
+    PathTree& operator=(const PathTree&) = delete;
+
+    // False until the first load; queries then return "unknown"
+    bool loaded() const;
+    // Swap in a tree built off to the side (marks this one loaded)
+    void replace_with(PathTree& fresh);
+    // Drop every entry but stay loaded (the index was cleared)
+    void reset();
+
+    // Mirrors of the index's write operations
+    void upsert(const IndexedFile& file);
+    void upsert(const IndexedFileRef& file);  // Copies what it keeps
+    void set_sync_status(const std::string& path, bool synced, const std::string& local_path);
+    // Entries strictly below `folder` that are not yet synced map to
+    // `local_root` + their path relative to `folder`
+    void mark_synced(const std::string& folder, const std::string& local_root);
+    void remove(const std::string& path);       // The entry only
+    void remove_tree(const std::string& path);  // The entry and everything below it
+    // Remove children of `parent` (with their subtrees) missing from `seen`
+    void prune(const std::string& parent, const std::set<std::string>& seen);
+
+    // Entries whose parent is `folder`, folders first, then by name (the
+    // order get_directory_contents returns). False if not loaded.
+    bool list(const std::string& folder, std::vector<IndexedFile>& out) const;
+    // 1/0 if loaded, -1 if not
+    int exists(const std::string& path) const;
+
+    struct Summary {
+        int64_t files = 0;
+        int64_t folders = 0;
+        int64_t bytes = 0;
+        int64_t newest = 0;  // Newest file ModTime below, Unix seconds (0 if none)
+    };
+    // Recursive totals below `folder`, read from its aggregates; false if
+    // not loaded or unknown
+    bool summarize(const std::string& folder, Summary& out) const;
+
+    size_t entry_count() const;
+    size_t memory_bytes() const;
+    // Removed entries keep their nodes until the next load
+    bool needs_compaction() const;
+
+private:
+    static constexpr uint32_t NONE = 0xFFFFFFFFu;
+    static constexpr int64_t NO_TIME = INT64_MIN;
+
+    enum Flag : uint8_t {
+        ROW = 1,        // Present in the index (ancestors may exist only implicitly)
+        DIR = 2,
+        SYNCED = 4,
+        RAW_MTIME = 8,  // Unparseable ModTime, kept verbatim in raw_mtimes_
+    };
+
+    uint32_t intern(std::string_view segment);
+    std::string_view segment(uint32_t id) const;
+    uint32_t child(uint32_t parent, uint32_t seg) const;
+    uint32_t add_node(uint32_t parent, uint32_t seg);
+    void grow_node_slots();
+
+    // Node for `path` ("proton:/a/b"); NONE if absent (find) or unparseable
+    uint32_t find(const std::string& path) const;
+    uint32_t ensure(std::string_view path);
+    std::string full_path(uint32_t node) const;
+    IndexedFile make_file(uint32_t node, const std::string& parent_path) const;
+    // Returns the newest ModTime that left with the subtree (NO_TIME if none)
+    int64_t clear_subtree(uint32_t node);
+
+    // Aggregates: what a node contributes to its ancestors, and keeping
+    // the newest-ModTime maximum correct as contributions come and go
+    int64_t own_newest(uint32_t node) const;
+    void add_to_ancestors(uint32_t node, int64_t files, int64_t folders, int64_t bytes);
+    void raise_newest(uint32_t from, int64_t time);
+    void lower_newest(uint32_t from, int64_t time);
+
+    void set_mtime(uint32_t node, std::string_view mod_time);
+    std::string mtime(uint32_t node) const;
+
+    mutable std::shared_mutex mutex_;
+    bool loaded_ = false;
+
+    // Interned name segments: segment i is pool_[seg_offset_[i], seg_offset_[i + 1])
+    std::string pool_;
+    std::vector<uint32_t> seg_offset_{0};
+    std::vector<uint32_t> seg_slots_;  // Open addressing; NONE = empty
+
+    // Nodes, one index per entry across all arrays
+    std::vector<uint32_t> seg_;
+    std::vector<uint32_t> parent_;
+    std::vector<uint32_t> first_child_;
+    std::vector<uint32_t> next_sibling_;
+    std::vector<int64_t> size_;
+    std::vector<int64_t> mtime_secs_;   // Wall-clock seconds as written (before the offset)
+    std::vector<uint64_t> mtime_fmt_;   // Fraction, digit count and zone, packed
+    std::vector<uint8_t> flags_;
+    std::vector<uint32_t> node_slots_;  // Open addressing on (parent, segment)
+
+    // Recursive totals of the entries strictly below each node
+    std::vector<uint32_t> agg_files_;
+    std::vector<uint32_t> agg_folders_;
+    std::vector<int64_t> agg_bytes_;
+    std::vector<int64_t> agg_newest_;   // UTC seconds, NO_TIME if nothing dated below
+
+    std::unordered_map<std::string, uint32_t> roots_;  // "proton:" -> node
+    std::unordered_map<uint32_t, std::string> local_paths_;
+    std::unordered_map<uint32_t, std::string> raw_mtimes_;  // Only ModTimes parse_rfc3339 rejects
+    size_t rows_ = 0;
+};
+
+} // namespace proton
+
+#endif // PATH_TREE_HPP
@@ -0,0 +1,279 @@
+// process_tracker.cpp - /proc discovery and pidfd tracking of rclone transfers
+
+#include "process_tracker.hpp"
+#include "logger.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <cerrno>
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+#ifndef SYS_pidfd_send_signal
+#define SYS_pidfd_send_signal 424
+#endif
+
+namespace proton {
+
+namespace {
+
+// Seconds since the process started, from /proc/<pid>/stat field 22
+long process_elapsed_seconds(const std::string& pid_dir) {
+    std::ifstream stat_file(pid_dir + "/stat");
+    std::string stat;
+    if (!std::getline(stat_file, stat)) return 0;
+    size_t close_paren = stat.rfind(')');
+    if (close_paren == std::string::npos) return 0;
+
+    std::istringstream iss(stat.substr(close_paren + 2));
+    std::string field;
+    unsigned long long start_ticks = 0;
+    for (int i = 3; i <= 22 && (iss >> field); ++i) {
+        if (i == 22) {
+            try { start_ticks = std::stoull(field); } catch (...) { return 0; }
+        }
+    }
+
+    std::ifstream uptime_file("/proc/uptime");
+    double uptime = 0;
+    if (!(uptime_file >> uptime)) return 0;
+    long ticks_per_sec = sysconf(_SC_CLK_TCK);
+    if (ticks_per_sec <= 0) return 0;
+    double elapsed = uptime - static_cast<double>(start_ticks) / ticks_per_sec;
+    return elapsed > 0 ? static_cast<long>(elapsed) : 0;
+}
+
+// A pidfd becomes readable once its process has exited
+bool pidfd_exited(int pidfd) {
+    struct pollfd pfd = {pidfd, POLLIN, 0};
+    return poll(&pfd, 1, 0) > 0;
+}
+
+std::vector<int> list_pids() {
+    std::vector<int> pids;
+    DIR* dir = opendir("/proc");
+    if (!dir) return pids;
+    while (struct dirent* entry = readdir(dir)) {
+        const char* name = entry->d_name;
+        if (name[0] < '1' || name[0] > '9') continue;
+        char* end = nullptr;
+        long pid = std::strtol(name, &end, 10);
+        if (*end == '\0') pids.push_back(static_cast<int>(pid));
+    }
+    closedir(dir);
+    return pids;
+}
+
+} // namespace
+
+ProcessTracker& ProcessTracker::getInstance() {
+    static ProcessTracker instance;
+    return instance;
+}
+
+ProcessTracker::~ProcessTracker() {
+    for (auto& [pid, tracked] : tracked_) {
+        if (tracked.pidfd >= 0) close(tracked.pidfd);
+    }
+}
+
+void ProcessTracker::refresh() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    refresh_locked();
+}
+
+void ProcessTracker::refresh_if_stale_locked() {
+    if (std::chrono::steady_clock::now() - last_refresh_ > MAX_AGE) refresh_locked();
+}
+
+void ProcessTracker::refresh_locked() {
+    std::vector<int> pids = list_pids();
+    std::set<int> live(pids.begin(), pids.end());
+
+    // Drop exits first - a pidfd notices even if the PID was already reused
+    for (auto it = tracked_.begin(); it != tracked_.end();) {
+        bool gone = it->second.pidfd >= 0 ? pidfd_exited(it->second.pidfd) : !live.count(it->first);
+        if (!gone) {
+            ++it;
+            continue;
+        }
+        Logger::debug("[ProcessTracker] rclone " + std::to_string(it->first) + " exited");
+        if (it->second.pidfd >= 0) close(it->second.pidfd);
+        it = tracked_.erase(it);
+    }
+    for (auto it = ignored_.begin(); it != ignored_.end();) {
+        if (live.count(*it)) ++it;
+        else it = ignored_.erase(it);
+    }
+
+    for (int pid : pids) {
+        if (tracked_.count(pid) || ignored_.count(pid)) continue;
+        Tracked tracked;
+        if (!examine(pid, tracked)) {
+            ignored_.insert(pid);
+            continue;
+        }
+        Logger::debug("[ProcessTracker] Tracking rclone " + std::to_string(pid) + ": " + tracked.info.command);
+        tracked_.emplace(pid, std::move(tracked));
+    }
+    last_refresh_ = std::chrono::steady_clock::now();
+}
+
+// Is `pid` one of this user's rclone sync/copy/bisync transfers (the filter
+// the UI used with ps/grep, minus internal config-sync transfers)?
+bool ProcessTracker::examine(int pid, Tracked& out) const {
+    const std::string pid_dir = "/proc/" + std::to_string(pid);
+    struct stat st;
+    if (stat(pid_dir.c_str(), &st) != 0 || st.st_uid != getuid()) return false;
+
+    std::ifstream cmdline_file(pid_dir + "/cmdline", std::ios::binary);
+    std::string raw((std::istreambuf_iterator<char>(cmdline_file)), std::istreambuf_iterator<char>());
+    if (raw.empty()) return false;
+
+    std::vector<std::string> argv;
+    size_t start = 0;
+    while (start < raw.size()) {
+        size_t end = raw.find('\0', start);
+        if (end == std::string::npos) end = raw.size();
+        argv.push_back(raw.substr(start, end - start));
+        start = end + 1;
+    }
+    if (argv.empty() || fs::path(argv[0]).filename().string() != "rclone") return false;
+
+    RcloneProcess& proc = out.info;
+    bool is_transfer = false;
+    for (size_t i = 0; i < argv.size(); ++i) {
+        const std::string& arg = argv[i];
+        if (i > 0) proc.command += " ";
+        proc.command += arg;
+        if (arg.find("sync") != std::string::npos || arg.find("copy") != std::string::npos) {
+            is_transfer = true;
+        }
+        if (arg.rfind("--rc-addr=", 0) == 0) {
+            proc.rc_addr = arg.substr(10);
+        } else if (arg == "--rc-addr" && i + 1 < argv.size()) {
+            proc.rc_addr = argv[i + 1];
+        }
+    }
+    if (!is_transfer || proc.command.find(".proton-sync-config") != std::string::npos) return false;
+    // `rclone rc ...` client invocations are not transfers themselves
+    if (argv.size() > 1 && argv[1] == "rc") return false;
+
+    // Plain --rc without --rc-addr listens on the rclone default
+    if (proc.rc_addr.empty() && proc.command.find(" --rc") != std::string::npos) {
+        proc.rc_addr = "localhost:5572";
+    }
+
+    proc.pid = pid;
+    proc.args = std::move(argv);
+    // Pin the process; without pidfd support (pre-5.3 kernels) liveness
+    // falls back to the PID still being listed in /proc
+    out.pidfd = static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+    out.started = std::chrono::steady_clock::now() - std::chrono::seconds(process_elapsed_seconds(pid_dir));
+    return true;
+}
+
+std::vector<RcloneProcess> ProcessTracker::snapshot(size_t limit) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    refresh_if_stale_locked();
+
+    std::vector<const Tracked*> ordered;
+    ordered.reserve(tracked_.size());
+    for (const auto& [pid, tracked] : tracked_) ordered.push_back(&tracked);
+    std::sort(ordered.begin(), ordered.end(),
+              [](const Tracked* a, const Tracked* b) { return a->started < b->started; });
+    if (limit > 0 && ordered.size() > limit) ordered.resize(limit);
+
+    auto now = std::chrono::steady_clock::now();
+    std::vector<RcloneProcess> result;
+    result.reserve(ordered.size());
+    for (const Tracked* tracked : ordered) {
+        result.push_back(tracked->info);
+        result.back().elapsed_seconds = static_cast<long>(
+            std::chrono::duration_cast<std::chrono::seconds>(now - tracked->started).count());
+    }
+    return result;
+}
+
+bool ProcessTracker::is_syncing_path(const std::string& local_path) {
+    if (local_path.empty()) return false;
+    std::lock_guard<std::mutex> lock(mutex_);
+    refresh_if_stale_locked();
+    for (const auto& [pid, tracked] : tracked_) {
+        if (tracked.info.command.find(local_path) != std::string::npos) return true;
+    }
+    return false;
+}
+
+bool ProcessTracker::send_signal(int pid, int sig) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = tracked_.find(pid);
+    if (it == tracked_.end() || it->second.pidfd < 0) {
+        // Not ours (or already reaped from the table): the PID may be reused
+        errno = ESRCH;
+        return false;
+    }
+    // Fails with ESRCH once the process is gone instead of hitting a reused PID
+    return syscall(SYS_pidfd_send_signal, it->second.pidfd, sig, nullptr, 0) == 0;
+}
+
+bool ProcessTracker::terminate(int pid, std::chrono::milliseconds grace) {
+    // A private copy of the pidfd: refresh() closes the table's own as soon
+    // as the process exits, and SIGKILL must not go out by bare PID
+    int pidfd = -1;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = tracked_.find(pid);
+        if (it != tracked_.end() && it->second.pidfd >= 0) {
+            pidfd = fcntl(it->second.pidfd, F_DUPFD_CLOEXEC, 0);
+        }
+    }
+    if (pidfd < 0) {
+        errno = ESRCH;
+        return false;
+    }
+
+    bool sent = syscall(SYS_pidfd_send_signal, pidfd, SIGTERM, nullptr, 0) == 0;
+    if (sent) {
+        struct pollfd pfd = {pidfd, POLLIN, 0};
+        if (poll(&pfd, 1, static_cast<int>(grace.count())) == 0) {
+            syscall(SYS_pidfd_send_signal, pidfd, SIGKILL, nullptr, 0);
+        }
+    }
+    int saved_errno = errno;
+    close(pidfd);
+    errno = saved_errno;
+    return sent;
+}
+
+int ProcessTracker::resume_stopped() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    refresh_locked();
+    int resumed = 0;
+    for (const auto& [pid, tracked] : tracked_) {
+        if (tracked.pidfd < 0) continue;
+        // State follows the parenthesised comm, which may itself contain ')'
+        std::ifstream stat("/proc/" + std::to_string(pid) + "/stat");
+        std::string line;
+        std::getline(stat, line);
+        size_t paren = line.rfind(')');
+        if (paren == std::string::npos || paren + 2 >= line.size() || line[paren + 2] != 'T') continue;
+        if (syscall(SYS_pidfd_send_signal, tracked.pidfd, SIGCONT, nullptr, 0) == 0) resumed++;
+    }
+    return resumed;
+}
+
+} // namespace proton
@@ -0,0 +1,85 @@
+// process_tracker.hpp - In-memory table of this user's running rclone transfers
+// Sync jobs run rclone from systemd timers and the UI, so they are not our
+// children; the tracker finds them by listing /proc and reading each new
+// PID's cmdline once. Every tracked process is pinned with a pidfd, so
+// exits are noticed without re-reading /proc and signals can never reach a
+// recycled PID. Status checks (is this folder syncing? how long has this job
+// been running?) are lookups in the table refreshed by the stats loop.
+
+#ifndef PROCESS_TRACKER_HPP
+#define PROCESS_TRACKER_HPP
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace proton {
+
+struct RcloneProcess {
+    int pid = 0;
+    long elapsed_seconds = 0;       // Filled in by snapshot()
+    std::string command;            // argv joined with spaces
+    std::vector<std::string> args;
+    std::string rc_addr;            // "host:port" if started with --rc
+};
+
+class ProcessTracker {
+public:
+    static ProcessTracker& getInstance();
+
+    // Pick up new rclone processes and drop exited ones. Reads only the
+    // cmdline of PIDs not seen before; cheap enough to call every second.
+    void refresh();
+
+    // Tracked transfers, oldest first. Refreshes first if the table is
+    // older than MAX_AGE (e.g. the stats loop is idle).
+    std::vector<RcloneProcess> snapshot(size_t limit = 0);
+
+    // True if a tracked transfer's command line mentions `local_path`
+    bool is_syncing_path(const std::string& local_path);
+
+    // Signal a tracked process through its pidfd. Untracked PIDs are never
+    // signalled: returns false with errno set to ESRCH.
+    bool send_signal(int pid, int sig);
+
+    // SIGTERM, then SIGKILL if still alive after `grace`, both through the
+    // same pidfd. Blocks for up to `grace`; call off the main thread.
+    bool terminate(int pid, std::chrono::milliseconds grace);
+
+    // SIGCONT tracked transfers left stopped (state T), e.g. frozen by an
+    // instance that crashed. Returns how many were resumed.
+    int resume_stopped();
+
+    static constexpr std::chrono::milliseconds MAX_AGE{2000};
+
+private:
+    ProcessTracker() = default;
+    ~ProcessTracker();
+
+    ProcessTracker(const ProcessTracker&) = delete;
+    ProcessTracker& operator=(const ProcessTracker&) = delete;
+
+    struct Tracked {
+        RcloneProcess info;
+        int pidfd = -1;
+        std::chrono::steady_clock::time_point started;
+    };
+
+    void refresh_locked();
+    void refresh_if_stale_locked();
+    bool examine(int pid, Tracked& out) const;
+
+    std::mutex mutex_;
+    std::map<int, Tracked> tracked_;
+    // PIDs already looked at that are not transfers; forgotten once they
+    // leave /proc so a recycled PID is examined again
+    std::set<int> ignored_;
+    std::chrono::steady_clock::time_point last_refresh_;
+};
+
+} // namespace proton
+
+#endif // PROCESS_TRACKER_HPP
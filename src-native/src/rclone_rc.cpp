@@ -0,0 +1,927 @@
+// rclone_rc.cpp - Persistent rclone remote-control daemon and HTTP client
+
+#include "rclone_rc.hpp"
+#include "logger.hpp"
+#include "trace.hpp"
+#include <curl/curl.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+namespace proton {
+
+// ============================================================================
+// RcClient
+// ============================================================================
+
+static size_t rc_write_callback(char* ptr, size_t size, size_t nmemb, void* userdata) {
+    auto* out = static_cast<std::string*>(userdata);
+    out->append(ptr, size * nmemb);
+    return size * nmemb;
+}
+
+RcClient::~RcClient() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (void* h : idle_handles_) {
+        curl_easy_cleanup(static_cast<CURL*>(h));
+    }
+    idle_handles_.clear();
+}
+
+void RcClient::set_endpoint(const std::string& addr, const std::string& user,
+                            const std::string& pass) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    addr_ = addr;
+    user_ = user;
+    pass_ = pass;
+}
+
+std::string RcClient::get_endpoint() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return addr_;
+}
+
+void* RcClient::acquire_handle() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!idle_handles_.empty()) {
+            void* h = idle_handles_.back();
+            idle_handles_.pop_back();
+            return h;
+        }
+    }
+    return curl_easy_init();
+}
+
+void RcClient::release_handle(void* handle) {
+    if (!handle) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Keep a handful of warm connections; more than that is just idle sockets
+    if (idle_handles_.size() < 8) {
+        idle_handles_.push_back(handle);
+    } else {
+        curl_easy_cleanup(static_cast<CURL*>(handle));
+    }
+}
+
+bool RcClient::call(const std::string& method, const std::string& params,
+                    std::string& response, int timeout_seconds, bool* not_sent) {
+    response.clear();
+    if (not_sent) *not_sent = true;
+
+    std::string addr, user, pass;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        addr = addr_;
+        user = user_;
+        pass = pass_;
+    }
+    if (addr.empty()) return false;
+
+    CURL* curl = static_cast<CURL*>(acquire_handle());
+    if (!curl) {
+        Logger::error("[RcClient] curl_easy_init failed");
+        return false;
+    }
+
+    std::string url = "http://" + addr + "/" + method;
+    std::string body = params.empty() ? "{}" : params;
+
+    struct curl_slist* headers = nullptr;
+    headers = curl_slist_append(headers, "Content-Type: application/json");
+
+    curl_easy_reset(curl);
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_POST, 1L);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body.c_str());
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, static_cast<long>(body.size()));
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, rc_write_callback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);  // Required for multi-threaded use
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 5L);
+    // Untimed callers (whole transfers) still get a bound, so a wedged daemon
+    // cannot hold a worker forever
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT,
+                     static_cast<long>(timeout_seconds > 0 ? timeout_seconds : DEFAULT_TIMEOUT_SECONDS));
+    if (!user.empty()) {
+        curl_easy_setopt(curl, CURLOPT_HTTPAUTH, CURLAUTH_BASIC);
+        curl_easy_setopt(curl, CURLOPT_USERNAME, user.c_str());
+        curl_easy_setopt(curl, CURLOPT_PASSWORD, pass.c_str());
+    }
+
+    CURLcode res = curl_easy_perform(curl);
+    long http_code = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+    curl_slist_free_all(headers);
+
+    if (not_sent) {
+        *not_sent = (res == CURLE_COULDNT_CONNECT || res == CURLE_COULDNT_RESOLVE_HOST);
+    }
+
+    if (res != CURLE_OK) {
+        Logger::debug("[RcClient] " + method + " failed: " + std::string(curl_easy_strerror(res)));
+        // A broken connection may leave the handle in a bad state - drop it
+        curl_easy_cleanup(curl);
+        return false;
+    }
+
+    release_handle(curl);
+    return http_code == 200;
+}
+
+namespace {
+
+struct RangeSink {
+    const RcClient::DataSink* sink;
+    uint64_t received = 0;
+};
+
+size_t rc_range_callback(char* ptr, size_t size, size_t nmemb, void* userdata) {
+    auto* state = static_cast<RangeSink*>(userdata);
+    size_t bytes = size * nmemb;
+    state->received += bytes;
+    // Returning short makes curl abort with CURLE_WRITE_ERROR
+    return (*state->sink)(ptr, bytes) ? bytes : 0;
+}
+
+} // namespace
+
+bool RcClient::get_range(const std::string& path, uint64_t offset, uint64_t length,
+                         const DataSink& sink, int stall_seconds) {
+    if (length == 0) return true;
+    std::string addr, user, pass;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        addr = addr_;
+        user = user_;
+        pass = pass_;
+    }
+    if (addr.empty()) return false;
+
+    CURL* curl = static_cast<CURL*>(acquire_handle());
+    if (!curl) {
+        Logger::error("[RcClient] curl_easy_init failed");
+        return false;
+    }
+
+    std::string url = "http://" + addr + "/" + path;
+    std::string range = std::to_string(offset) + "-" + std::to_string(offset + length - 1);
+    RangeSink state{&sink};
+
+    curl_easy_reset(curl);
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L);
+    curl_easy_setopt(curl, CURLOPT_RANGE, range.c_str());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, rc_range_callback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &state);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 5L);
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, 1024L);
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, static_cast<long>(stall_seconds > 0 ? stall_seconds : 60));
+    if (!user.empty()) {
+        curl_easy_setopt(curl, CURLOPT_HTTPAUTH, CURLAUTH_BASIC);
+        curl_easy_setopt(curl, CURLOPT_USERNAME, user.c_str());
+        curl_easy_setopt(curl, CURLOPT_PASSWORD, pass.c_str());
+    }
+
+    CURLcode res = curl_easy_perform(curl);
+    long http_code = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+    if (res != CURLE_OK) {
+        Logger::debug("[RcClient] GET " + path + " (" + range + ") failed: " + curl_easy_strerror(res));
+        curl_easy_cleanup(curl);
+        return false;
+    }
+    release_handle(curl);
+
+    // 200 means the server ignored the range - only usable from offset 0
+    bool ranged = http_code == 206 || (http_code == 200 && offset == 0);
+    return ranged && state.received == length;
+}
+
+// ============================================================================
+// Helpers for translating rclone CLI arguments into RC requests
+// ============================================================================
+
+// Split a shell-style argument string into words, honouring the quoting
+// produced by shell_escape(). Returns false if the string relies on shell
+// features (pipes, redirection, expansion) we cannot reproduce.
+static bool split_shell_words(const std::string& input, std::vector<std::string>& words) {
+    std::string current;
+    bool have_word = false;
+    size_t i = 0;
+    while (i < input.size()) {
+        char c = input[i];
+        if (c == '\'') {
+            size_t end = input.find('\'', i + 1);
+            if (end == std::string::npos) return false;
+            current.append(input, i + 1, end - i - 1);
+            have_word = true;
+            i = end + 1;
+        } else if (c == '"') {
+            i++;
+            while (i < input.size() && input[i] != '"') {
+                if (input[i] == '\\' && i + 1 < input.size()) {
+                    i++;
+                } else if (input[i] == '$' || input[i] == '`') {
+                    return false;
+                }
+                current += input[i++];
+            }
+            if (i >= input.size()) return false;
+            have_word = true;
+            i++;
+        } else if (c == '\\' && i + 1 < input.size()) {
+            current += input[i + 1];
+            have_word = true;
+            i += 2;
+        } else if (c == ' ' || c == '\t') {
+            if (have_word) {
+                words.push_back(current);
+                current.clear();
+                have_word = false;
+            }
+            i++;
+        } else if (std::strchr("|&;<>()$`*?\n", c)) {
+            return false;
+        } else {
+            current += c;
+            have_word = true;
+            i++;
+        }
+    }
+    if (have_word) words.push_back(current);
+    return true;
+}
+
+static bool is_remote_spec(const std::string& path) {
+    size_t colon = path.find(':');
+    if (colon == std::string::npos || colon == 0) return false;
+    size_t slash = path.find('/');
+    return slash == std::string::npos || colon < slash;
+}
+
+static bool is_supported_location(const std::string& path) {
+    return is_remote_spec(path) || (!path.empty() && path.front() == '/');
+}
+
+// "proton:/A/B/" -> fs "proton:", remote "A/B"
+// "/home/u/f"   -> fs "/",       remote "home/u/f"
+static void split_fs_remote(const std::string& path, std::string& fs, std::string& remote) {
+    if (is_remote_spec(path)) {
+        size_t colon = path.find(':');
+        fs = path.substr(0, colon + 1);
+        remote = path.substr(colon + 1);
+    } else {
+        fs = "/";
+        remote = path;
+    }
+    while (!remote.empty() && remote.front() == '/') remote.erase(0, 1);
+    while (!remote.empty() && remote.back() == '/') remote.pop_back();
+}
+
+// Return the raw JSON text of the array ('[') or object ('{') stored under
+// `key`, or "" if absent
+static std::string extract_json_value(const std::string& body, const char* key, char open, char close) {
+    std::string needle = std::string("\"") + key + "\"";
+    size_t pos = body.find(needle);
+    if (pos == std::string::npos) return "";
+    pos = body.find_first_not_of(" \t\r\n:", pos + needle.size());
+    if (pos == std::string::npos || body[pos] != open) return "";
+
+    int depth = 0;
+    bool in_string = false;
+    for (size_t i = pos; i < body.size(); ++i) {
+        char c = body[i];
+        if (in_string) {
+            if (c == '\\') { ++i; continue; }
+            if (c == '"') in_string = false;
+            continue;
+        }
+        if (c == '"') in_string = true;
+        else if (c == open) depth++;
+        else if (c == close && --depth == 0) return body.substr(pos, i - pos + 1);
+    }
+    return "";
+}
+
+static std::string extract_json_array(const std::string& body, const char* key) {
+    return extract_json_value(body, key, '[', ']');
+}
+
+// Raw token of a scalar under `key` (true, 42, ...), or "" if absent
+static std::string extract_json_scalar(const std::string& body, const char* key) {
+    std::string needle = std::string("\"") + key + "\"";
+    size_t pos = body.find(needle);
+    if (pos == std::string::npos) return "";
+    pos = body.find_first_not_of(" \t\r\n:", pos + needle.size());
+    if (pos == std::string::npos) return "";
+    size_t end = body.find_first_of(",}\r\n ", pos);
+    return body.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+}
+
+static std::string extract_error_message(const std::string& body) {
+    size_t pos = body.find("\"error\"");
+    if (pos == std::string::npos) return body.empty() ? "no response from rclone daemon" : body;
+    pos = body.find('"', body.find(':', pos) + 1);
+    if (pos == std::string::npos) return body;
+    std::string msg;
+    for (size_t i = pos + 1; i < body.size() && body[i] != '"'; ++i) {
+        if (body[i] == '\\' && i + 1 < body.size()) ++i;
+        msg += body[i];
+    }
+    return msg;
+}
+
+namespace {
+
+enum class FlagTarget { OPT, CONFIG, COMMAND, IGNORE };
+
+struct FlagSpec {
+    const char* name;
+    bool takes_value;
+    FlagTarget target;
+    const char* key;
+};
+
+// CLI flags we know how to express over RC. Anything else forces a fallback
+// to spawning rclone so we never silently change a command's semantics.
+const FlagSpec FLAG_SPECS[] = {
+    {"--recursive",       false, FlagTarget::OPT,     "recurse"},
+    {"-R",                false, FlagTarget::OPT,     "recurse"},
+    {"--dirs-only",       false, FlagTarget::OPT,     "dirsOnly"},
+    {"--files-only",      false, FlagTarget::OPT,     "filesOnly"},
+    {"--no-modtime",      false, FlagTarget::OPT,     "noModTime"},
+    {"--no-mimetype",     false, FlagTarget::OPT,     "noMimeType"},
+    {"--hash",            false, FlagTarget::OPT,     "showHash"},
+    {"--stat",            false, FlagTarget::COMMAND, "stat"},
+    {"--fast-list",       false, FlagTarget::CONFIG,  "UseListR"},
+    {"--update",          false, FlagTarget::CONFIG,  "UpdateOlder"},
+    {"-u",                false, FlagTarget::CONFIG,  "UpdateOlder"},
+    {"--ignore-existing", false, FlagTarget::CONFIG,  "IgnoreExisting"},
+    {"--dry-run",         false, FlagTarget::CONFIG,  "DryRun"},
+    {"-n",                false, FlagTarget::CONFIG,  "DryRun"},
+    {"--max-depth",       true,  FlagTarget::CONFIG,  "MaxDepth"},
+    {"--transfers",       true,  FlagTarget::CONFIG,  "Transfers"},
+    {"--checkers",        true,  FlagTarget::CONFIG,  "Checkers"},
+    {"--resync",          false, FlagTarget::COMMAND, "resync"},
+    {"--force",           false, FlagTarget::COMMAND, "force"},
+    {"--progress",        false, FlagTarget::IGNORE,  nullptr},
+    {"-P",                false, FlagTarget::IGNORE,  nullptr},
+    {"--verbose",         false, FlagTarget::IGNORE,  nullptr},
+    {"-v",                false, FlagTarget::IGNORE,  nullptr},
+    {"--log-level",       true,  FlagTarget::IGNORE,  nullptr},
+    {"--stats",           true,  FlagTarget::IGNORE,  nullptr},
+};
+
+struct ParsedCommand {
+    std::vector<std::string> positional;
+    std::map<std::string, std::string> opt;      // key -> JSON value
+    std::map<std::string, std::string> config;   // key -> JSON value
+    std::map<std::string, std::string> command;  // key -> JSON value
+};
+
+bool parse_command(const std::vector<std::string>& words, ParsedCommand& out) {
+    for (size_t i = 1; i < words.size(); ++i) {
+        const std::string& w = words[i];
+        if (w.size() < 2 || w[0] != '-') {
+            out.positional.push_back(w);
+            continue;
+        }
+
+        std::string name = w;
+        std::string value;
+        bool inline_value = false;
+        size_t eq = w.find('=');
+        if (eq != std::string::npos) {
+            name = w.substr(0, eq);
+            value = w.substr(eq + 1);
+            inline_value = true;
+        }
+
+        const FlagSpec* spec = nullptr;
+        for (const auto& s : FLAG_SPECS) {
+            if (name == s.name) { spec = &s; break; }
+        }
+        if (!spec) return false;
+
+        if (spec->takes_value) {
+            if (!inline_value) {
+                if (i + 1 >= words.size()) return false;
+                value = words[++i];
+            }
+        } else {
+            if (inline_value && value != "true" && value != "false") return false;
+            if (!inline_value) value = "true";
+        }
+
+        if (spec->target == FlagTarget::IGNORE) continue;
+
+        // Numeric options go in as raw JSON numbers, everything else is bool
+        std::string json_value = value;
+        if (spec->takes_value) {
+            if (value.empty() || value.find_first_not_of("0123456789-") != std::string::npos) return false;
+        }
+
+        switch (spec->target) {
+            case FlagTarget::OPT:     out.opt[spec->key] = json_value; break;
+            case FlagTarget::CONFIG:  out.config[spec->key] = json_value; break;
+            case FlagTarget::COMMAND: out.command[spec->key] = json_value; break;
+            case FlagTarget::IGNORE:  break;
+        }
+    }
+    return true;
+}
+
+std::string json_object(const std::map<std::string, std::string>& fields) {
+    std::string s = "{";
+    bool first = true;
+    for (const auto& [k, v] : fields) {
+        if (!first) s += ",";
+        first = false;
+        s += "\"" + k + "\":" + v;
+    }
+    return s + "}";
+}
+
+std::string json_str(const std::string& s) {
+    return "\"" + RcloneRC::json_escape(s) + "\"";
+}
+
+} // namespace
+
+std::string RcloneRC::json_escape(const std::string& s) {
+    std::string out;
+    out.reserve(s.size() + 8);
+    for (unsigned char c : s) {
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    char buf[8];
+                    std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    out += buf;
+                } else {
+                    out += static_cast<char>(c);
+                }
+        }
+    }
+    return out;
+}
+
+// ============================================================================
+// RcloneRC - daemon lifecycle
+// ============================================================================
+
+RcloneRC& RcloneRC::getInstance() {
+    static RcloneRC instance;
+    return instance;
+}
+
+RcloneRC::~RcloneRC() {
+    stop();
+}
+
+static std::string random_token() {
+    unsigned char bytes[16] = {0};
+    std::ifstream urandom("/dev/urandom", std::ios::binary);
+    urandom.read(reinterpret_cast<char*>(bytes), sizeof(bytes));
+    static const char* hex = "0123456789abcdef";
+    std::string token;
+    for (unsigned char b : bytes) {
+        token += hex[b >> 4];
+        token += hex[b & 0x0f];
+    }
+    return token;
+}
+
+// Ask the kernel for a free loopback port
+static int pick_free_port() {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return 0;
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    int port = 0;
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) {
+        socklen_t len = sizeof(addr);
+        if (getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) == 0) {
+            port = ntohs(addr.sin_port);
+        }
+    }
+    close(fd);
+    return port;
+}
+
+bool RcloneRC::start(const std::string& rclone_path) {
+    if (running_.load()) return true;
+
+    rclone_path_ = rclone_path.empty() ? "rclone" : rclone_path;
+    user_ = "proton-drive";
+    pass_ = random_token();
+    running_ = true;
+
+    // Readiness is awaited on the supervisor thread so startup never blocks
+    // on rclone loading its config; callers fall back to spawning until then
+    try {
+        supervisor_thread_ = std::thread(&RcloneRC::supervise_loop, this);
+    } catch (const std::exception& e) {
+        Logger::error("[RcloneRC] Failed to start supervisor thread: " + std::string(e.what()));
+        running_ = false;
+        return false;
+    }
+    return true;
+}
+
+void RcloneRC::stop() {
+    if (!running_.exchange(false)) return;
+    ready_ = false;
+    supervisor_cv_.notify_all();
+
+    if (supervisor_thread_.joinable()) {
+        supervisor_thread_.join();
+    }
+
+    pid_t pid = pid_.exchange(-1);
+    if (pid > 0) {
+        kill(pid, SIGTERM);
+        for (int i = 0; i < 30; ++i) {
+            if (waitpid(pid, nullptr, WNOHANG) == pid) { pid = -1; break; }
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        if (pid > 0) {
+            kill(pid, SIGKILL);
+            waitpid(pid, nullptr, 0);
+        }
+        Logger::info("[RcloneRC] Daemon stopped");
+    }
+}
+
+bool RcloneRC::spawn_daemon() {
+    port_ = pick_free_port();
+    if (port_ == 0) {
+        Logger::error("[RcloneRC] Could not allocate a loopback port");
+        return false;
+    }
+    std::string addr = "127.0.0.1:" + std::to_string(port_);
+
+    const char* home = std::getenv("HOME");
+    std::string log_path = home ? std::string(home) + "/.cache/proton-drive/rclone-rcd.log"
+                                : "/tmp/proton-drive-rclone-rcd.log";
+
+    // Build argv and envp before fork - only async-signal-safe calls are
+    // allowed after. The credentials go in the environment: argv is world
+    // readable in /proc/<pid>/cmdline, environ only to this user.
+    std::vector<std::string> args = {
+        rclone_path_, "rcd",
+        "--rc-addr", addr,
+        "--log-level", "NOTICE",
+        // Serve remote objects over the same authenticated endpoint, so
+        // large downloads can fetch byte ranges in parallel (read_range)
+        "--rc-serve",
+    };
+    std::vector<char*> argv;
+    for (auto& a : args) argv.push_back(a.data());
+    argv.push_back(nullptr);
+
+    std::vector<std::string> env_vars;
+    for (char** e = environ; e && *e; ++e) {
+        if (std::strncmp(*e, "RCLONE_RC_USER=", 15) == 0 || std::strncmp(*e, "RCLONE_RC_PASS=", 15) == 0) continue;
+        env_vars.emplace_back(*e);
+    }
+    env_vars.push_back("RCLONE_RC_USER=" + user_);
+    env_vars.push_back("RCLONE_RC_PASS=" + pass_);
+    std::vector<char*> envp;
+    for (auto& e : env_vars) envp.push_back(e.data());
+    envp.push_back(nullptr);
+
+    int log_fd = open(log_path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        if (log_fd >= 0) close(log_fd);
+        Logger::error("[RcloneRC] fork() failed: " + std::string(std::strerror(errno)));
+        return false;
+    }
+    if (pid == 0) {
+        // Child: die with the parent so we never leak an authenticated daemon
+        prctl(PR_SET_PDEATHSIG, SIGTERM);
+        int null_fd = open("/dev/null", O_RDWR);
+        if (null_fd >= 0) dup2(null_fd, STDIN_FILENO);
+        int out_fd = log_fd >= 0 ? log_fd : null_fd;
+        if (out_fd >= 0) {
+            dup2(out_fd, STDOUT_FILENO);
+            dup2(out_fd, STDERR_FILENO);
+        }
+        execvpe(argv[0], argv.data(), envp.data());
+        _exit(127);
+    }
+
+    if (log_fd >= 0) close(log_fd);
+    pid_ = pid;
+    client_.set_endpoint(addr, user_, pass_);
+    Logger::info("[RcloneRC] Started rclone rcd (pid " + std::to_string(pid) + ") on " + addr);
+    return true;
+}
+
+bool RcloneRC::wait_until_ready(int timeout_ms) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (running_.load() && std::chrono::steady_clock::now() < deadline) {
+        pid_t pid = pid_.load();
+        if (pid <= 0 || waitpid(pid, nullptr, WNOHANG) == pid) {
+            pid_ = -1;
+            return false;
+        }
+        std::string response;
+        if (client_.call("rc/noop", "{}", response, 2)) {
+            ready_ = true;
+            Logger::info("[RcloneRC] Daemon ready");
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    return false;
+}
+
+void RcloneRC::supervise_loop() {
+    if (!spawn_daemon() || !wait_until_ready(10000)) {
+        Logger::warn("[RcloneRC] Daemon did not come up - falling back to per-command rclone");
+    }
+
+    int backoff_seconds = 1;
+    while (running_.load()) {
+        {
+            std::unique_lock<std::mutex> lock(supervisor_mutex_);
+            supervisor_cv_.wait_for(lock, std::chrono::seconds(1), [this] { return !running_.load(); });
+        }
+        if (!running_.load()) break;
+
+        pid_t pid = pid_.load();
+        if (pid > 0) {
+            int status = 0;
+            if (waitpid(pid, &status, WNOHANG) != pid) {
+                if (!ready_.load()) {
+                    // Still alive but slow to start (e.g. large config) - keep probing
+                    std::string response;
+                    if (client_.call("rc/noop", "{}", response, 2)) {
+                        ready_ = true;
+                        Logger::info("[RcloneRC] Daemon ready");
+                    }
+                } else {
+                    backoff_seconds = 1;
+                }
+                continue;
+            }
+            Logger::warn("[RcloneRC] Daemon exited (status " + std::to_string(status) + "), restarting");
+            pid_ = -1;
+            ready_ = false;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(supervisor_mutex_);
+            supervisor_cv_.wait_for(lock, std::chrono::seconds(backoff_seconds),
+                                    [this] { return !running_.load(); });
+        }
+        if (!running_.load()) break;
+        backoff_seconds = std::min(backoff_seconds * 2, 30);
+
+        if (spawn_daemon()) {
+            wait_until_ready(10000);
+        }
+    }
+}
+
+// ============================================================================
+// RcloneRC - calls
+// ============================================================================
+
+bool RcloneRC::call(const std::string& method, const std::string& params,
+                    std::string& response, int timeout_seconds) {
+    if (!ready_.load()) return false;
+    return client_.call(method, params, response, timeout_seconds);
+}
+
+bool RcloneRC::read_range(const std::string& remote, uint64_t offset, uint64_t length,
+                          const RcClient::DataSink& sink, int stall_seconds) {
+    if (!ready_.load()) return false;
+    std::string fs, path;
+    split_fs_remote(remote, fs, path);
+
+    // --rc-serve URLs look like /[proton:]/Folder/file.bin
+    std::string url = "[" + fs + "]";
+    size_t start = 0;
+    while (start <= path.size()) {
+        size_t end = path.find('/', start);
+        if (end == std::string::npos) end = path.size();
+        if (end > start) {
+            char* escaped = curl_easy_escape(nullptr, path.c_str() + start, static_cast<int>(end - start));
+            if (!escaped) return false;
+            url += "/";
+            url += escaped;
+            curl_free(escaped);
+        }
+        start = end + 1;
+    }
+    return client_.get_range(url, offset, length, sink, stall_seconds);
+}
+
+bool RcloneRC::run_job(const std::string& method, const std::string& params, int timeout_seconds,
+                       std::string& response, bool& not_sent) {
+    std::string started;
+    if (!client_.call(method, params, started, 30, &not_sent)) {
+        response = started;
+        return false;
+    }
+    std::string jobid = extract_json_scalar(started, "jobid");
+    if (jobid.empty()) {
+        response = started;
+        return false;
+    }
+
+    const std::string job = "{\"jobid\":" + jobid + "}";
+    const auto deadline = timeout_seconds > 0
+        ? std::chrono::steady_clock::now() + std::chrono::seconds(timeout_seconds)
+        : std::chrono::steady_clock::time_point::max();
+    auto interval = std::chrono::milliseconds(100);
+    int unanswered = 0;
+    while (true) {
+        std::this_thread::sleep_for(interval);
+        interval = std::min(interval * 2, std::chrono::milliseconds(JOB_POLL_MAX_MS));
+
+        std::string status;
+        if (client_.call("job/status", job, status, 10)) {
+            unanswered = 0;
+            if (extract_json_scalar(status, "finished") == "true") {
+                response = status;
+                return extract_json_scalar(status, "success") == "true";
+            }
+        } else if (!status.empty()) {
+            // "job not found": the daemon restarted and the transfer died with it
+            response = status;
+            return false;
+        } else if (++unanswered >= 30) {
+            response.clear();
+            return false;
+        }
+
+        if (std::chrono::steady_clock::now() >= deadline) {
+            // Stop the job inside the daemon, so a retry or the next run
+            // does not overlap it on the same paths
+            std::string ignored;
+            client_.call("job/stop", job, ignored, 10);
+            for (int i = 0; i < 20; ++i) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(500));
+                if (!client_.call("job/status", job, ignored, 10) ||
+                    extract_json_scalar(ignored, "finished") == "true") {
+                    break;
+                }
+            }
+            Logger::warn("[RcloneRC] " + method + " (job " + jobid + ") stopped after " +
+                         std::to_string(timeout_seconds) + "s");
+            response = "{\"error\":\"timed out after " + std::to_string(timeout_seconds) + " seconds\"}";
+            return false;
+        }
+    }
+}
+
+bool RcloneRC::run(const std::string& args, int timeout_seconds,
+                   std::string& output, int& exit_code) {
+    if (!ready_.load()) return false;
+    TraceSpan span("rclone", "rc run");
+    span.set_detail(args);
+
+    std::vector<std::string> words;
+    if (!split_shell_words(args, words) || words.empty()) return false;
+
+    ParsedCommand cmd;
+    if (!parse_command(words, cmd)) return false;
+
+    const std::string& verb = words[0];
+    const auto& pos = cmd.positional;
+    for (const auto& p : pos) {
+        if (verb != "config" && !is_supported_location(p)) return false;
+    }
+
+    std::map<std::string, std::string> params;
+    std::string method;
+
+    bool stat = verb == "lsjson" && cmd.command.erase("stat") > 0;
+
+    if (verb == "lsjson" && pos.size() == 1) {
+        std::string fs, remote;
+        split_fs_remote(pos[0], fs, remote);
+        method = stat ? "operations/stat" : "operations/list";
+        params["fs"] = json_str(fs);
+        params["remote"] = json_str(remote);
+        if (!cmd.opt.empty()) params["opt"] = json_object(cmd.opt);
+    } else if (verb == "listremotes" && pos.empty()) {
+        method = "config/listremotes";
+    } else if ((verb == "mkdir" || verb == "rmdir" || verb == "purge" || verb == "deletefile") &&
+               pos.size() == 1) {
+        std::string fs, remote;
+        split_fs_remote(pos[0], fs, remote);
+        method = "operations/" + verb;
+        params["fs"] = json_str(fs);
+        params["remote"] = json_str(remote);
+    } else if ((verb == "copyto" || verb == "moveto") && pos.size() == 2) {
+        std::string src_fs, src_remote, dst_fs, dst_remote;
+        split_fs_remote(pos[0], src_fs, src_remote);
+        split_fs_remote(pos[1], dst_fs, dst_remote);
+        method = verb == "copyto" ? "operations/copyfile" : "operations/movefile";
+        params["srcFs"] = json_str(src_fs);
+        params["srcRemote"] = json_str(src_remote);
+        params["dstFs"] = json_str(dst_fs);
+        params["dstRemote"] = json_str(dst_remote);
+    } else if ((verb == "copy" || verb == "sync" || verb == "move") && pos.size() == 2) {
+        method = "sync/" + verb;
+        params["srcFs"] = json_str(pos[0]);
+        params["dstFs"] = json_str(pos[1]);
+    } else if (verb == "bisync" && pos.size() == 2) {
+        method = "sync/bisync";
+        params["path1"] = json_str(pos[0]);
+        params["path2"] = json_str(pos[1]);
+        for (const auto& [k, v] : cmd.command) params[k] = v;
+        auto dry = cmd.config.find("DryRun");
+        if (dry != cmd.config.end()) {
+            params["dryRun"] = dry->second;
+            cmd.config.erase(dry);
+        }
+    } else if (verb == "config" && pos.size() == 2 && pos[0] == "delete") {
+        method = "config/delete";
+        params["name"] = json_str(pos[1]);
+    } else {
+        return false;
+    }
+
+    // --resync / --force only make sense for bisync
+    if (verb != "bisync" && !cmd.command.empty()) return false;
+    if (!cmd.config.empty()) params["_config"] = json_object(cmd.config);
+
+    // Transfers count against the shared bandwidth budget while they run
+    bool is_transfer = method.rfind("sync/", 0) == 0 || method == "operations/copyfile" ||
+                       method == "operations/movefile";
+    std::string response;
+    bool not_sent = false;
+    bool ok;
+    if (is_transfer) {
+        params["_async"] = "true";
+        active_transfers_++;
+        ok = run_job(method, json_object(params), timeout_seconds, response, not_sent);
+        active_transfers_--;
+    } else {
+        ok = client_.call(method, json_object(params), response, timeout_seconds, &not_sent);
+    }
+    if (not_sent) {
+        // Daemon unreachable (likely restarting) - nothing ran, let the
+        // caller spawn rclone instead
+        return false;
+    }
+
+    exit_code = ok ? 0 : 1;
+    output.clear();
+    if (!ok) {
+        output = "ERROR : " + extract_error_message(response) + "\n";
+        Logger::debug("[RcloneRC] " + method + " failed: " + output);
+        return true;
+    }
+
+    if (stat) {
+        // Like `lsjson --stat`: the bare object, or null if it doesn't exist
+        output = extract_json_value(response, "item", '{', '}');
+        if (output.empty()) output = "null";
+        output += "\n";
+    } else if (verb == "lsjson") {
+        output = extract_json_array(response, "list");
+        if (output.empty()) output = "[]";
+        output += "\n";
+    } else if (verb == "listremotes") {
+        std::string remotes = extract_json_array(response, "remotes");
+        size_t p = 0;
+        while ((p = remotes.find('"', p)) != std::string::npos) {
+            size_t e = remotes.find('"', p + 1);
+            if (e == std::string::npos) break;
+            output += remotes.substr(p + 1, e - p - 1) + ":\n";
+            p = e + 1;
+        }
+    }
+    return true;
+}
+
+} // namespace proton
@@ -0,0 +1,159 @@
+// rclone_rc.hpp - Persistent rclone remote-control daemon and HTTP client
+// Keeps one authenticated `rclone rcd` alive for the app's lifetime so cloud
+// operations are a single HTTP round-trip instead of a fresh process + login.
+
+#ifndef RCLONE_RC_HPP
+#define RCLONE_RC_HPP
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <sys/types.h>
+
+namespace proton {
+
+/**
+ * Minimal JSON-over-HTTP client for the rclone RC API.
+ *
+ * curl easy handles are pooled and reused so repeated calls keep their
+ * TCP connection to the daemon alive. Safe to call from any thread.
+ */
+class RcClient {
+public:
+    RcClient() = default;
+    ~RcClient();
+
+    RcClient(const RcClient&) = delete;
+    RcClient& operator=(const RcClient&) = delete;
+
+    // Target daemon, e.g. "127.0.0.1:5572". Empty user disables basic auth.
+    void set_endpoint(const std::string& addr, const std::string& user = "",
+                      const std::string& pass = "");
+    std::string get_endpoint() const;
+
+    /**
+     * POST `params` (a JSON object) to http://<addr>/<method>.
+     * Returns true on HTTP 200; `response` receives the body either way
+     * so callers can surface rclone's {"error": ...} message.
+     * `not_sent` is set when the daemon could not be reached at all, i.e.
+     * the request was definitely not executed and is safe to retry.
+     * A timeout of 0 or less means DEFAULT_TIMEOUT_SECONDS, never unbounded;
+     * long operations go through RcloneRC's job polling instead.
+     */
+    static constexpr int DEFAULT_TIMEOUT_SECONDS = 3600;
+    bool call(const std::string& method, const std::string& params,
+              std::string& response, int timeout_seconds = 30,
+              bool* not_sent = nullptr);
+
+    /**
+     * GET bytes [offset, offset + length) of http://<addr>/<path> with a
+     * Range request, handing each received block to `sink` (return false
+     * from it to abort). Fails if the transfer stalls below 1 KB/s for
+     * `stall_seconds` rather than after a fixed total time, so a long but
+     * healthy download is never cut off.
+     */
+    using DataSink = std::function<bool(const char* data, size_t size)>;
+    bool get_range(const std::string& path, uint64_t offset, uint64_t length,
+                   const DataSink& sink, int stall_seconds = 60);
+
+private:
+    void* acquire_handle();
+    void release_handle(void* handle);
+
+    mutable std::mutex mutex_;
+    std::string addr_;
+    std::string user_;
+    std::string pass_;
+    std::vector<void*> idle_handles_;  // CURL*
+};
+
+/**
+ * Lifecycle manager for the long-lived `rclone rcd` backend.
+ *
+ * start() launches the daemon on a random loopback port with random
+ * credentials and a supervisor thread that restarts it if it dies.
+ * run() translates the rclone CLI argument strings used throughout the
+ * app (lsjson, copyto, mkdir, ...) into RC calls; anything it does not
+ * understand returns false so callers fall back to spawning rclone.
+ */
+class RcloneRC {
+public:
+    static RcloneRC& getInstance();
+
+    bool start(const std::string& rclone_path);
+    void stop();
+
+    // True once the daemon answered rc/noop and is accepting calls
+    bool is_ready() const { return ready_.load(); }
+
+    // Current daemon process; changes when the supervisor restarts it
+    pid_t daemon_pid() const { return pid_.load(); }
+
+    // copy/move/sync calls currently running inside the daemon
+    int active_transfers() const { return active_transfers_.load(); }
+
+    // Raw RC call against the managed daemon
+    bool call(const std::string& method, const std::string& params,
+              std::string& response, int timeout_seconds = 30);
+
+    /**
+     * Execute an rclone CLI-style argument string through the daemon.
+     * Returns false if the command cannot be expressed as an RC call (or the
+     * daemon is down) - nothing has been executed in that case.
+     * On true, `output` holds what the CLI would have printed on stdout
+     * (lsjson array, remote list) or an "ERROR : ..." line on failure,
+     * and `exit_code` is 0 on success, 1 otherwise.
+     * Transfers (copy, sync, move, bisync, copyto, moveto) run as daemon
+     * jobs: a timeout of 0 leaves them unbounded, and a timeout that
+     * expires stops the job before failure is reported.
+     */
+    bool run(const std::string& args, int timeout_seconds,
+             std::string& output, int& exit_code);
+
+    // Read a byte range of a remote object (e.g. "proton:/Videos/a.mkv")
+    // through the daemon's --rc-serve endpoint. False if the daemon is down.
+    bool read_range(const std::string& remote, uint64_t offset, uint64_t length,
+                    const RcClient::DataSink& sink, int stall_seconds = 60);
+
+    // Escape a string for embedding in a JSON document
+    static std::string json_escape(const std::string& s);
+
+private:
+    RcloneRC() = default;
+    ~RcloneRC();
+
+    RcloneRC(const RcloneRC&) = delete;
+    RcloneRC& operator=(const RcloneRC&) = delete;
+
+    // Start `method` with _async and poll job/status until it finishes
+    bool run_job(const std::string& method, const std::string& params, int timeout_seconds,
+                 std::string& response, bool& not_sent);
+    static constexpr int JOB_POLL_MAX_MS = 2000;
+
+    bool spawn_daemon();
+    bool wait_until_ready(int timeout_ms);
+    void supervise_loop();
+
+    RcClient client_;
+    std::string rclone_path_;
+    std::string user_;
+    std::string pass_;
+    int port_ = 0;
+
+    std::atomic<pid_t> pid_{-1};
+    std::atomic<bool> running_{false};
+    std::atomic<bool> ready_{false};
+    std::atomic<int> active_transfers_{0};
+    std::thread supervisor_thread_;
+    std::mutex supervisor_mutex_;
+    std::condition_variable supervisor_cv_;
+};
+
+} // namespace proton
+
+#endif // RCLONE_RC_HPP
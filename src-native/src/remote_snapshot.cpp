@@ -0,0 +1,160 @@
+// remote_snapshot.cpp - Shared per-cycle listing of sync job remote trees
+
+#include "remote_snapshot.hpp"
+#include "lsjson_parser.hpp"
+#include "logger.hpp"
+
+namespace proton {
+
+RemoteSnapshotService& RemoteSnapshotService::getInstance() {
+    static RemoteSnapshotService instance;
+    return instance;
+}
+
+std::string RemoteSnapshotService::normalize(const std::string& root) {
+    std::string key = root;
+    size_t colon = key.find(':');
+    if (colon != std::string::npos && (colon + 1 == key.size() || key[colon + 1] != '/')) {
+        key.insert(colon + 1, "/");
+    }
+    while (key.size() > colon + 2 && key.back() == '/') key.pop_back();
+    return key;
+}
+
+RemoteSnapshotService::SnapshotPtr RemoteSnapshotService::get(const std::string& root,
+                                                              const std::atomic<bool>* stop,
+                                                              bool tree) {
+    const std::string key = normalize(root);
+
+    SnapshotPtr previous;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        Entry& entry = entries_[key];
+        // Someone else is listing this tree; their result serves us too
+        refreshed_cv_.wait(lock, [&] { return !entry.refreshing; });
+
+        // A whole-tree snapshot also answers root-only callers
+        const SnapshotPtr& current = tree ? entry.tree : entry.snapshot;
+        bool stale = tree ? entry.tree_stale : entry.stale;
+        if (current && !stale &&
+            std::chrono::steady_clock::now() - current->taken_at <
+                std::chrono::seconds(CYCLE_SECONDS)) {
+            return current;
+        }
+        entry.refreshing = true;
+        previous = entry.tree;
+    }
+
+    SnapshotPtr fresh;
+    try {
+        fresh = tree ? refresh_tree(key, previous, stop) : refresh_root(key, stop);
+    } catch (const std::exception& e) {
+        Logger::error("[RemoteSnapshot] Refresh of " + key + " failed: " + e.what());
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Entry& entry = entries_[key];
+        entry.refreshing = false;
+        if (fresh) {
+            entry.snapshot = fresh;
+            entry.stale = false;
+            if (tree) {
+                entry.tree = fresh;
+                entry.tree_stale = false;
+            }
+        }
+    }
+    refreshed_cv_.notify_all();
+    return fresh;
+}
+
+void RemoteSnapshotService::invalidate(const std::string& root) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(normalize(root));
+    if (it != entries_.end()) {
+        it->second.stale = true;
+        it->second.tree_stale = true;
+    }
+}
+
+namespace {
+
+std::string child_prefix(const std::string& folder) {
+    return folder.back() == '/' ? folder : folder + "/";
+}
+
+} // namespace
+
+RemoteSnapshotService::SnapshotPtr RemoteSnapshotService::refresh_root(const std::string& root,
+                                                                       const std::atomic<bool>* stop) {
+    std::string json;
+    if (!FileIndex::fetch_lsjson("--max-depth 1", root, 60, json, stop) ||
+        json.find('[') == std::string::npos) {
+        Logger::warn("[RemoteSnapshot] Failed to list " + root);
+        return nullptr;
+    }
+
+    auto snapshot = std::make_shared<Snapshot>();
+    snapshot->root = root;
+    snapshot->folders[root] = Folder{"", std::make_shared<const std::vector<IndexedFile>>(
+                                             LsjsonParser::parse(json, child_prefix(root)))};
+    snapshot->relisted = 1;
+    snapshot->taken_at = std::chrono::steady_clock::now();
+    return snapshot;
+}
+
+RemoteSnapshotService::SnapshotPtr RemoteSnapshotService::refresh_tree(const std::string& root,
+                                                                       const SnapshotPtr& previous,
+                                                                       const std::atomic<bool>* stop) {
+
+    // Folder skeleton only: O(folders) rows instead of O(files)
+    std::string dirs_json;
+    if (!FileIndex::fetch_lsjson("--recursive --dirs-only --fast-list", root, 300, dirs_json, stop)) {
+        return nullptr;
+    }
+    if (dirs_json.find('[') == std::string::npos) {
+        Logger::warn("[RemoteSnapshot] No folder listing for " + root);
+        return nullptr;
+    }
+
+    auto snapshot = std::make_shared<Snapshot>();
+    snapshot->root = root;
+    snapshot->tree = true;
+    snapshot->folders[root] = Folder{};  // The root's own ModTime isn't in its listing
+    for (auto& dir : LsjsonParser::parse(dirs_json, child_prefix(root))) {
+        snapshot->folders[dir.path] = Folder{std::move(dir.mod_time), nullptr};
+    }
+
+    for (auto& [path, folder] : snapshot->folders) {
+        if (stop && stop->load()) return nullptr;
+
+        // Unchanged folders keep the listing from the previous cycle
+        if (previous && path != root) {
+            auto it = previous->folders.find(path);
+            if (it != previous->folders.end() && it->second.children &&
+                !folder.mod_time.empty() && it->second.mod_time == folder.mod_time) {
+                folder.children = it->second.children;
+                continue;
+            }
+        }
+
+        std::string json;
+        if (!FileIndex::fetch_lsjson("--max-depth 1", path, 60, json, stop) ||
+            json.find('[') == std::string::npos) {
+            // Left null so consumers skip it; retried on the next cycle
+            Logger::warn("[RemoteSnapshot] Failed to list folder " + path);
+            continue;
+        }
+        folder.children = std::make_shared<const std::vector<IndexedFile>>(
+            LsjsonParser::parse(json, child_prefix(path)));
+        snapshot->relisted++;
+    }
+
+    snapshot->taken_at = std::chrono::steady_clock::now();
+    Logger::info("[RemoteSnapshot] " + root + ": " + std::to_string(snapshot->relisted) + " of " +
+                 std::to_string(snapshot->folders.size()) + " folders listed");
+    return snapshot;
+}
+
+} // namespace proton
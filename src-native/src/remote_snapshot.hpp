@@ -0,0 +1,82 @@
+// remote_snapshot.hpp - Shared per-cycle listing of sync job remote trees
+// CloudMonitor and the index refresh after a sync both need the same
+// remote tree. Instead of each listing it, they read one snapshot per job
+// root that is refreshed at most once per cycle. CloudMonitor only compares
+// the root's direct children, so by default a refresh is one depth-1
+// listing. Callers that need the whole tree ask for it: that refresh lists
+// the folder skeleton (`lsjson --dirs-only`) and re-lists only folders
+// whose ModTime moved; unchanged folders keep their previous listing.
+
+#ifndef REMOTE_SNAPSHOT_HPP
+#define REMOTE_SNAPSHOT_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "file_index.hpp"
+
+namespace proton {
+
+class RemoteSnapshotService {
+public:
+    static RemoteSnapshotService& getInstance();
+
+    struct Folder {
+        std::string mod_time;  // From the skeleton ("" for the root)
+        // Direct children, or null if this folder could not be listed
+        std::shared_ptr<const std::vector<IndexedFile>> children;
+    };
+
+    struct Snapshot {
+        std::string root;                      // "proton:/Documents"
+        std::map<std::string, Folder> folders;  // Root, and every subfolder if `tree`
+        bool tree = false;
+        std::chrono::steady_clock::time_point taken_at;
+        size_t relisted = 0;                   // Folders listed by this refresh
+    };
+    using SnapshotPtr = std::shared_ptr<const Snapshot>;
+
+    // Snapshot of `root` no older than CYCLE_SECONDS. Without `tree` it may
+    // hold only the root's own listing; with it, every subfolder is listed
+    // too. Refreshes on the calling thread if needed; concurrent callers
+    // for one root wait for the same refresh. Null if it could not be listed.
+    SnapshotPtr get(const std::string& root, const std::atomic<bool>* stop = nullptr,
+                    bool tree = false);
+
+    // Force the next get() to refresh, e.g. after this app wrote to the tree
+    void invalidate(const std::string& root);
+
+    static constexpr int CYCLE_SECONDS = 45;
+
+private:
+    RemoteSnapshotService() = default;
+
+    RemoteSnapshotService(const RemoteSnapshotService&) = delete;
+    RemoteSnapshotService& operator=(const RemoteSnapshotService&) = delete;
+
+    struct Entry {
+        SnapshotPtr snapshot;  // Latest of either kind
+        SnapshotPtr tree;      // Latest whole-tree snapshot, reused folder by folder
+        bool stale = false;
+        bool tree_stale = false;
+        bool refreshing = false;
+    };
+
+    SnapshotPtr refresh_root(const std::string& root, const std::atomic<bool>* stop);
+    SnapshotPtr refresh_tree(const std::string& root, const SnapshotPtr& previous,
+                             const std::atomic<bool>* stop);
+    static std::string normalize(const std::string& root);
+
+    std::mutex mutex_;
+    std::condition_variable refreshed_cv_;
+    std::map<std::string, Entry> entries_;
+};
+
+} // namespace proton
+
+#endif // REMOTE_SNAPSHOT_HPP
@@ -53,14 +53,20 @@ void SettingsManager::ensure_defaults() {
         settings_["upload_limit"] = "0";
     if (settings_.find("download_limit") == settings_.end()) 
         settings_["download_limit"] = "0";
+    if (settings_.find("metered_limit_kb") == settings_.end()) 
+        settings_["metered_limit_kb"] = "1024";
     if (settings_.find("confirm_large_upload") == settings_.end()) 
         settings_["confirm_large_upload"] = "true";
     if (settings_.find("large_file_threshold") == settings_.end()) 
         settings_["large_file_threshold"] = "104857600";  // 100MB
     if (settings_.find("debug_logging") == settings_.end()) 
         settings_["debug_logging"] = "false";
+    if (settings_.find("log_tag_levels") == settings_.end()) 
+        settings_["log_tag_levels"] = "";
     if (settings_.find("max_parallel_transfers") == settings_.end()) 
         settings_["max_parallel_transfers"] = "4";
+    if (settings_.find("index_crawl_workers") == settings_.end()) 
+        settings_["index_crawl_workers"] = "4";
     
     // Safety settings defaults
     if (settings_.find("max_delete_percent") == settings_.end()) 
@@ -330,6 +336,14 @@ void SettingsManager::set_pause_sync_on_metered(bool enabled) {
     set_bool("pause_sync_on_metered", enabled);
 }
 
+bool SettingsManager::get_sync_paused() const {
+    return get_bool("sync_paused", false);
+}
+
+void SettingsManager::set_sync_paused(bool paused) {
+    set_bool("sync_paused", paused);
+}
+
 // Bandwidth limits
 size_t SettingsManager::get_upload_limit() const {
     return static_cast<size_t>(get_int("upload_limit", 0));
@@ -347,6 +361,57 @@ void SettingsManager::set_download_limit(size_t bytes_per_second) {
     set_int("download_limit", static_cast<int>(bytes_per_second));
 }
 
+bool SettingsManager::get_bw_scheduling_enabled() const {
+    return get_bool("bw_scheduling_enabled", false);
+}
+
+int SettingsManager::get_work_hour_start() const {
+    return get_int("work_hour_start", 9);
+}
+
+int SettingsManager::get_work_hour_end() const {
+    return get_int("work_hour_end", 17);
+}
+
+size_t SettingsManager::get_work_hour_limit() const {
+    return static_cast<size_t>(get_int("work_hour_limit_kb", 500)) * 1024;
+}
+
+size_t SettingsManager::get_metered_limit() const {
+    return static_cast<size_t>(get_int("metered_limit_kb", 1024)) * 1024;
+}
+
+void SettingsManager::set_metered_limit(size_t bytes_per_second) {
+    set_int("metered_limit_kb", static_cast<int>(bytes_per_second / 1024));
+}
+
+// Files on demand
+bool SettingsManager::get_mount_enabled() const {
+    return get_bool("mount_enabled", false);
+}
+
+void SettingsManager::set_mount_enabled(bool enabled) {
+    set_bool("mount_enabled", enabled);
+}
+
+std::string SettingsManager::get_mount_point() const {
+    const char* home = std::getenv("HOME");
+    return get_string("mount_point", std::string(home ? home : "/tmp") + "/ProtonDrive-Cloud");
+}
+
+void SettingsManager::set_mount_point(const std::string& path) {
+    set_string("mount_point", path);
+}
+
+size_t SettingsManager::get_mount_cache_size() const {
+    return static_cast<size_t>(get_int("mount_cache_mb", 256)) * 1024 * 1024;
+}
+
+// Monitoring
+int SettingsManager::get_metrics_port() const {
+    return get_int("metrics_port", 0);
+}
+
 // File handling
 std::string SettingsManager::get_download_folder() const {
     return get_string("download_folder", std::string(std::getenv("HOME")) + "/Downloads");
@@ -381,6 +446,15 @@ void SettingsManager::set_debug_logging(bool enabled) {
     set_bool("debug_logging", enabled);
 }
 
+std::string SettingsManager::get_log_tag_levels() const {
+    return get_string("log_tag_levels", "");
+}
+
+void SettingsManager::set_log_tag_levels(const std::string& spec) {
+    set_string("log_tag_levels", spec);
+    Logger::set_tag_levels(spec);
+}
+
 int SettingsManager::get_max_parallel_transfers() const {
     return get_int("max_parallel_transfers", 4);
 }
@@ -389,6 +463,14 @@ void SettingsManager::set_max_parallel_transfers(int count) {
     set_int("max_parallel_transfers", std::max(1, std::min(10, count)));
 }
 
+int SettingsManager::get_index_crawl_workers() const {
+    return std::max(1, std::min(16, get_int("index_crawl_workers", 4)));
+}
+
+void SettingsManager::set_index_crawl_workers(int count) {
+    set_int("index_crawl_workers", std::max(1, std::min(16, count)));
+}
+
 // Generic accessors
 std::string SettingsManager::get_string(const std::string& key, const std::string& default_value) const {
     std::lock_guard<std::mutex> lock(mutex_);
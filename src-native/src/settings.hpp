@@ -53,6 +53,10 @@ public:
     bool get_pause_sync_on_metered() const;
     void set_pause_sync_on_metered(bool enabled);
     
+    // Periodic sync stopped by the user (Stop button / tray Pause)
+    bool get_sync_paused() const;
+    void set_sync_paused(bool paused);
+    
     // Bandwidth limits (0 = unlimited)
     size_t get_upload_limit() const;
     void set_upload_limit(size_t bytes_per_second);
@@ -60,6 +64,26 @@ public:
     size_t get_download_limit() const;
     void set_download_limit(size_t bytes_per_second);
     
+    // Work-hours bandwidth schedule (keys shared with manage-sync-job.sh)
+    bool get_bw_scheduling_enabled() const;
+    int get_work_hour_start() const;
+    int get_work_hour_end() const;
+    size_t get_work_hour_limit() const;   // bytes/s
+    
+    // Cap applied on metered connections (0 = none)
+    size_t get_metered_limit() const;     // bytes/s
+    void set_metered_limit(size_t bytes_per_second);
+    
+    // Files on demand: read-only FUSE view of the whole drive
+    bool get_mount_enabled() const;
+    void set_mount_enabled(bool enabled);
+    std::string get_mount_point() const;
+    void set_mount_point(const std::string& path);
+    size_t get_mount_cache_size() const;  // bytes of file blocks kept in memory
+    
+    // Prometheus text endpoint on 127.0.0.1 (0 = off)
+    int get_metrics_port() const;
+    
     // File handling
     std::string get_download_folder() const;
     void set_download_folder(const std::string& path);
@@ -74,9 +98,17 @@ public:
     bool get_debug_logging() const;
     void set_debug_logging(bool enabled);
     
+    // Per-subsystem log levels, e.g. "CloudMonitor=warn,FileIndex=debug"
+    std::string get_log_tag_levels() const;
+    void set_log_tag_levels(const std::string& spec);
+    
     int get_max_parallel_transfers() const;
     void set_max_parallel_transfers(int count);
     
+    // Concurrent subtree listings during a full index (1 = single stream)
+    int get_index_crawl_workers() const;
+    void set_index_crawl_workers(int count);
+    
     // Settings change callback
     using SettingsChangeCallback = std::function<void(const std::string& key)>;
     void set_change_callback(SettingsChangeCallback callback);
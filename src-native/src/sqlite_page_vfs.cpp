@@ -0,0 +1,513 @@
+// sqlite_page_vfs.cpp - SQLite VFS that encrypts the file index page by page
+//
+// Layout: SQLite is told to leave PAGE_RESERVE_BYTES unused at the end of
+// every page. On write the page body is sealed in place with AES-256-GCM and
+// the fresh IV + tag go into that reserved tail; on read they are used to
+// open it again. Offsets and sizes never change, so the WAL, checkpoints and
+// the read pool all work unmodified.
+//
+//   main db page N:  [ ciphertext ............ | IV(12) | tag(16) ]   AAD = N
+//   page 1:          [ 100-byte header | ciphertext | IV | tag ]      header stays plain
+//   WAL frame:       [ frame header(24) | sealed page ]               no AAD
+//
+// The page 1 header only holds SQLite's own counters and sizes (it has to be
+// readable before the page size is known). WAL frames need no page-number
+// AAD: their checksums chain over the plaintext, so a swapped frame fails
+// SQLite's own validation. Rollback journals and temp files are passed
+// through - the index always runs in WAL mode with temp_store=MEMORY.
+
+#include "sqlite_page_vfs.hpp"
+#include "logger.hpp"
+#include <sqlite3.h>
+#include <openssl/evp.h>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <new>
+
+namespace crypto {
+namespace {
+
+// SQLite file format offsets
+constexpr int DB_HEADER_SIZE = 100;
+constexpr int DB_PAGE_SIZE_OFFSET = 16;
+constexpr int DB_RESERVE_OFFSET = 20;
+constexpr int WAL_HEADER_SIZE = 32;
+constexpr int WAL_PAGE_SIZE_OFFSET = 8;
+constexpr int WAL_FRAME_HEADER_SIZE = 24;
+constexpr char SQLITE_MAGIC[] = "SQLite format 3";  // 16 bytes incl. NUL
+
+const std::string PAGE_KEY_SALT = "proton-drive:file_index:pages";
+
+enum class FileKind { MainDb, Wal, Other };
+enum class Layout { Plain, Encrypted };
+
+struct PageFile {
+    sqlite3_file base;      // must stay first - SQLite sees this
+    sqlite3_file* real;     // underlying file, allocated right after us
+    FileKind kind;
+    Layout layout;
+    int page_size;          // 0 until known
+    std::string db_path;
+};
+
+std::mutex g_mutex;
+bool g_registered = false;
+uint8_t g_page_key[KEY_SIZE];
+sqlite3_vfs g_vfs;
+sqlite3_vfs* g_base = nullptr;
+
+// Main database path -> layout. A WAL file inherits its database's layout
+// because the WAL header does not record the reserved size.
+std::map<std::string, Layout> g_db_layouts;
+
+// One GCM context per thread, reused for every page
+struct CipherContext {
+    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+    ~CipherContext() { EVP_CIPHER_CTX_free(ctx); }
+};
+
+EVP_CIPHER_CTX* cipher_context() {
+    thread_local CipherContext c;
+    return c.ctx;
+}
+
+int parse_page_size(const uint8_t* p) {
+    int v = (p[0] << 8) | p[1];
+    if (v == 1) v = 65536;
+    if (v < 512 || v > 65536 || (v & (v - 1)) != 0) return 0;
+    return v;
+}
+
+int parse_wal_page_size(const uint8_t* p) {
+    uint32_t v = (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+    if (v < 512 || v > 65536 || (v & (v - 1)) != 0) return 0;
+    return static_cast<int>(v);
+}
+
+bool all_zero(const uint8_t* p, int len) {
+    for (int i = 0; i < len; i++) {
+        if (p[i]) return false;
+    }
+    return true;
+}
+
+// Encrypt page[start, page_size - RESERVE) in place and store IV + tag in the tail
+bool seal_page(uint8_t* page, int page_size, uint32_t pgno) {
+    int start = (pgno == 1) ? DB_HEADER_SIZE : 0;
+    int len = page_size - PAGE_RESERVE_BYTES - start;
+    uint8_t* iv = page + page_size - PAGE_RESERVE_BYTES;
+    uint8_t* tag = iv + IV_SIZE;
+    uint8_t aad[4] = {uint8_t(pgno >> 24), uint8_t(pgno >> 16), uint8_t(pgno >> 8), uint8_t(pgno)};
+
+    std::vector<uint8_t> fresh_iv = generate_iv();
+    if (fresh_iv.size() != IV_SIZE) return false;
+    std::memcpy(iv, fresh_iv.data(), IV_SIZE);
+
+    EVP_CIPHER_CTX* ctx = cipher_context();
+    int out_len = 0;
+    if (EVP_EncryptInit_ex(ctx, EVP_aes_256_gcm(), nullptr, g_page_key, iv) != 1) return false;
+    if (pgno && EVP_EncryptUpdate(ctx, nullptr, &out_len, aad, sizeof(aad)) != 1) return false;
+    if (EVP_EncryptUpdate(ctx, page + start, &out_len, page + start, len) != 1) return false;
+    if (EVP_EncryptFinal_ex(ctx, page + start + out_len, &out_len) != 1) return false;
+    return EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, static_cast<int>(TAG_SIZE), tag) == 1;
+}
+
+bool open_page(uint8_t* page, int page_size, uint32_t pgno) {
+    // Never-written pages (file extended by a size hint) read back as zeros.
+    // Only a wholly zero page passes unsealed: a zeroed IV + tag alone would
+    // let anyone who can write the file plant plaintext SQLite accepts.
+    if (all_zero(page, page_size)) return true;
+
+    int start = (pgno == 1) ? DB_HEADER_SIZE : 0;
+    int len = page_size - PAGE_RESERVE_BYTES - start;
+    uint8_t* iv = page + page_size - PAGE_RESERVE_BYTES;
+    uint8_t* tag = iv + IV_SIZE;
+    uint8_t aad[4] = {uint8_t(pgno >> 24), uint8_t(pgno >> 16), uint8_t(pgno >> 8), uint8_t(pgno)};
+
+    EVP_CIPHER_CTX* ctx = cipher_context();
+    int out_len = 0;
+    if (EVP_DecryptInit_ex(ctx, EVP_aes_256_gcm(), nullptr, g_page_key, iv) != 1) return false;
+    if (pgno && EVP_DecryptUpdate(ctx, nullptr, &out_len, aad, sizeof(aad)) != 1) return false;
+    if (EVP_DecryptUpdate(ctx, page + start, &out_len, page + start, len) != 1) return false;
+    if (EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, static_cast<int>(TAG_SIZE), tag) != 1) return false;
+    return EVP_DecryptFinal_ex(ctx, page + start + out_len, &out_len) == 1;
+}
+
+PageFile* page_file(sqlite3_file* f) { return reinterpret_cast<PageFile*>(f); }
+
+// Learn the main database page size from its header once it exists on disk
+void load_db_page_size(PageFile* p) {
+    uint8_t header[DB_HEADER_SIZE];
+    if (p->real->pMethods->xRead(p->real, header, DB_HEADER_SIZE, 0) == SQLITE_OK) {
+        p->page_size = parse_page_size(header + DB_PAGE_SIZE_OFFSET);
+    }
+}
+
+void load_wal_page_size(PageFile* p) {
+    uint8_t header[WAL_HEADER_SIZE];
+    if (p->real->pMethods->xRead(p->real, header, WAL_HEADER_SIZE, 0) == SQLITE_OK) {
+        p->page_size = parse_wal_page_size(header + WAL_PAGE_SIZE_OFFSET);
+    }
+}
+
+// Offset of the page image inside `buf` for a WAL access, or -1 if the
+// access is not a page (WAL header, frame header, partial read)
+int wal_page_offset(const PageFile* p, int amt, sqlite3_int64 off) {
+    if (p->page_size == 0 || off < WAL_HEADER_SIZE) return -1;
+    sqlite3_int64 frame_size = p->page_size + WAL_FRAME_HEADER_SIZE;
+    sqlite3_int64 within = (off - WAL_HEADER_SIZE) % frame_size;
+    if (within == WAL_FRAME_HEADER_SIZE && amt == p->page_size) return 0;
+    if (within == 0 && amt == frame_size) return WAL_FRAME_HEADER_SIZE;
+    return -1;
+}
+
+// ---- io methods ----
+
+int page_close(sqlite3_file* f) {
+    PageFile* p = page_file(f);
+    int rc = p->real->pMethods ? p->real->pMethods->xClose(p->real) : SQLITE_OK;
+    p->db_path.~basic_string();
+    return rc;
+}
+
+int page_read(sqlite3_file* f, void* buf, int amt, sqlite3_int64 off) {
+    PageFile* p = page_file(f);
+    int rc = p->real->pMethods->xRead(p->real, buf, amt, off);
+    if (rc != SQLITE_OK || p->layout != Layout::Encrypted) return rc;  // short reads are zero-filled
+
+    uint8_t* data = static_cast<uint8_t*>(buf);
+    if (p->kind == FileKind::MainDb) {
+        if (p->page_size == 0 && amt > DB_HEADER_SIZE) load_db_page_size(p);
+        if (p->page_size == 0 || amt != p->page_size || off % p->page_size != 0) return SQLITE_OK;
+        uint32_t pgno = static_cast<uint32_t>(off / p->page_size) + 1;
+        if (!open_page(data, p->page_size, pgno)) {
+            Logger::error("[PageVFS] Page " + std::to_string(pgno) + " failed authentication: " + p->db_path);
+            return SQLITE_IOERR_AUTH;
+        }
+    } else if (p->kind == FileKind::Wal) {
+        if (p->page_size == 0) load_wal_page_size(p);
+        int at = wal_page_offset(p, amt, off);
+        if (at < 0) return SQLITE_OK;
+        if (!open_page(data + at, p->page_size, 0)) {
+            Logger::error("[PageVFS] WAL frame failed authentication: " + p->db_path);
+            return SQLITE_IOERR_AUTH;
+        }
+    }
+    return SQLITE_OK;
+}
+
+int page_write(sqlite3_file* f, const void* buf, int amt, sqlite3_int64 off) {
+    PageFile* p = page_file(f);
+    if (p->layout != Layout::Encrypted || p->kind == FileKind::Other) {
+        return p->real->pMethods->xWrite(p->real, buf, amt, off);
+    }
+
+    const uint8_t* data = static_cast<const uint8_t*>(buf);
+    int at = -1;
+    uint32_t pgno = 0;
+    if (p->kind == FileKind::MainDb) {
+        if (off == 0 && amt >= DB_HEADER_SIZE) {
+            // Page 1 carries the header; refuse to write a layout we can't seal
+            if (data[DB_RESERVE_OFFSET] < PAGE_RESERVE_BYTES) {
+                Logger::error("[PageVFS] Database has no reserved page space - refusing plaintext write: " + p->db_path);
+                return SQLITE_IOERR_WRITE;
+            }
+            p->page_size = parse_page_size(data + DB_PAGE_SIZE_OFFSET);
+        }
+        if (p->page_size == 0) load_db_page_size(p);
+        if (p->page_size == 0 && amt >= 512 && (amt & (amt - 1)) == 0) {
+            // Header not on disk yet (pages still only in the WAL): main
+            // database writes are always whole pages
+            p->page_size = amt;
+        }
+        if (p->page_size && amt == p->page_size && off % p->page_size == 0) {
+            at = 0;
+            pgno = static_cast<uint32_t>(off / p->page_size) + 1;
+        }
+    } else {
+        if (off == 0 && amt >= WAL_HEADER_SIZE) {
+            p->page_size = parse_wal_page_size(data + WAL_PAGE_SIZE_OFFSET);
+        }
+        at = wal_page_offset(p, amt, off);
+    }
+    if (at < 0) return p->real->pMethods->xWrite(p->real, buf, amt, off);
+
+    // Seal a copy - SQLite's buffer is const and may be the live page cache
+    thread_local std::vector<uint8_t> scratch;
+    scratch.assign(data, data + amt);
+    if (!seal_page(scratch.data() + at, p->page_size, pgno)) {
+        Logger::error("[PageVFS] Failed to encrypt page: " + p->db_path);
+        return SQLITE_IOERR_WRITE;
+    }
+    return p->real->pMethods->xWrite(p->real, scratch.data(), amt, off);
+}
+
+int page_truncate(sqlite3_file* f, sqlite3_int64 size) {
+    PageFile* p = page_file(f);
+    return p->real->pMethods->xTruncate(p->real, size);
+}
+
+int page_sync(sqlite3_file* f, int flags) {
+    PageFile* p = page_file(f);
+    return p->real->pMethods->xSync(p->real, flags);
+}
+
+int page_file_size(sqlite3_file* f, sqlite3_int64* size) {
+    PageFile* p = page_file(f);
+    return p->real->pMethods->xFileSize(p->real, size);
+}
+
+int page_lock(sqlite3_file* f, int level) {
+    PageFile* p = page_file(f);
+    return p->real->pMethods->xLock(p->real, level);
+}
+
+int page_unlock(sqlite3_file* f, int level) {
+    PageFile* p = page_file(f);
+    return p->real->pMethods->xUnlock(p->real, level);
+}
+
+int page_check_reserved_lock(sqlite3_file* f, int* out) {
+    PageFile* p = page_file(f);
+    return p->real->pMethods->xCheckReservedLock(p->real, out);
+}
+
+int page_file_control(sqlite3_file* f, int op, void* arg) {
+    PageFile* p = page_file(f);
+    int rc = p->real->pMethods->xFileControl(p->real, op, arg);
+    if (op == SQLITE_FCNTL_VFSNAME && rc == SQLITE_OK) {
+        char** name = static_cast<char**>(arg);
+        *name = sqlite3_mprintf("%s/%z", PAGE_VFS_NAME, *name);
+    }
+    return rc;
+}
+
+int page_sector_size(sqlite3_file* f) {
+    PageFile* p = page_file(f);
+    return p->real->pMethods->xSectorSize(p->real);
+}
+
+int page_device_characteristics(sqlite3_file* f) {
+    PageFile* p = page_file(f);
+    return p->real->pMethods->xDeviceCharacteristics(p->real);
+}
+
+int page_shm_map(sqlite3_file* f, int region, int size, int extend, void volatile** out) {
+    PageFile* p = page_file(f);
+    return p->real->pMethods->xShmMap(p->real, region, size, extend, out);
+}
+
+int page_shm_lock(sqlite3_file* f, int offset, int n, int flags) {
+    PageFile* p = page_file(f);
+    return p->real->pMethods->xShmLock(p->real, offset, n, flags);
+}
+
+void page_shm_barrier(sqlite3_file* f) {
+    PageFile* p = page_file(f);
+    p->real->pMethods->xShmBarrier(p->real);
+}
+
+int page_shm_unmap(sqlite3_file* f, int delete_flag) {
+    PageFile* p = page_file(f);
+    return p->real->pMethods->xShmUnmap(p->real, delete_flag);
+}
+
+// Version 2: no xFetch, so SQLite never memory-maps (and bypasses) our pages
+const sqlite3_io_methods g_io_methods = {
+    2,
+    page_close,
+    page_read,
+    page_write,
+    page_truncate,
+    page_sync,
+    page_file_size,
+    page_lock,
+    page_unlock,
+    page_check_reserved_lock,
+    page_file_control,
+    page_sector_size,
+    page_device_characteristics,
+    page_shm_map,
+    page_shm_lock,
+    page_shm_barrier,
+    page_shm_unmap,
+    nullptr,
+    nullptr
+};
+
+// ---- vfs methods ----
+
+int vfs_open(sqlite3_vfs*, const char* name, sqlite3_file* f, int flags, int* out_flags) {
+    PageFile* p = page_file(f);
+    p->base.pMethods = nullptr;
+    p->real = reinterpret_cast<sqlite3_file*>(reinterpret_cast<char*>(p) + sizeof(PageFile));
+
+    int rc = g_base->xOpen(g_base, name, p->real, flags, out_flags);
+    if (rc != SQLITE_OK) return rc;
+
+    new (&p->db_path) std::string(name ? name : "");
+    p->kind = FileKind::Other;
+    p->layout = Layout::Plain;
+    p->page_size = 0;
+
+    if (name && (flags & SQLITE_OPEN_MAIN_DB)) {
+        p->kind = FileKind::MainDb;
+        uint8_t header[DB_HEADER_SIZE];
+        sqlite3_int64 size = 0;
+        p->real->pMethods->xFileSize(p->real, &size);
+        if (size < DB_HEADER_SIZE) {
+            // New database: FileIndex reserves page space before the first write
+            p->layout = Layout::Encrypted;
+        } else if (p->real->pMethods->xRead(p->real, header, DB_HEADER_SIZE, 0) == SQLITE_OK &&
+                   std::memcmp(header, SQLITE_MAGIC, sizeof(SQLITE_MAGIC)) == 0 &&
+                   header[DB_RESERVE_OFFSET] >= PAGE_RESERVE_BYTES) {
+            p->layout = Layout::Encrypted;
+            p->page_size = parse_page_size(header + DB_PAGE_SIZE_OFFSET);
+        }
+        std::lock_guard<std::mutex> lock(g_mutex);
+        g_db_layouts[p->db_path] = p->layout;
+    } else if (name && (flags & SQLITE_OPEN_WAL)) {
+        p->kind = FileKind::Wal;
+        const std::string suffix = "-wal";
+        if (p->db_path.size() > suffix.size()) {
+            std::string db = p->db_path.substr(0, p->db_path.size() - suffix.size());
+            std::lock_guard<std::mutex> lock(g_mutex);
+            auto it = g_db_layouts.find(db);
+            if (it != g_db_layouts.end()) p->layout = it->second;
+        }
+        sqlite3_int64 size = 0;
+        p->real->pMethods->xFileSize(p->real, &size);
+        if (size >= WAL_HEADER_SIZE) load_wal_page_size(p);
+    }
+
+    p->base.pMethods = &g_io_methods;
+    return SQLITE_OK;
+}
+
+int vfs_delete(sqlite3_vfs*, const char* name, int sync_dir) {
+    return g_base->xDelete(g_base, name, sync_dir);
+}
+
+int vfs_access(sqlite3_vfs*, const char* name, int flags, int* out) {
+    return g_base->xAccess(g_base, name, flags, out);
+}
+
+int vfs_full_pathname(sqlite3_vfs*, const char* name, int n, char* out) {
+    return g_base->xFullPathname(g_base, name, n, out);
+}
+
+void* vfs_dl_open(sqlite3_vfs*, const char* path) {
+    return g_base->xDlOpen(g_base, path);
+}
+
+void vfs_dl_error(sqlite3_vfs*, int n, char* msg) {
+    g_base->xDlError(g_base, n, msg);
+}
+
+void (*vfs_dl_sym(sqlite3_vfs*, void* handle, const char* sym))(void) {
+    return g_base->xDlSym(g_base, handle, sym);
+}
+
+void vfs_dl_close(sqlite3_vfs*, void* handle) {
+    g_base->xDlClose(g_base, handle);
+}
+
+int vfs_randomness(sqlite3_vfs*, int n, char* out) {
+    return g_base->xRandomness(g_base, n, out);
+}
+
+int vfs_sleep(sqlite3_vfs*, int us) {
+    return g_base->xSleep(g_base, us);
+}
+
+int vfs_current_time(sqlite3_vfs*, double* out) {
+    return g_base->xCurrentTime(g_base, out);
+}
+
+int vfs_get_last_error(sqlite3_vfs*, int n, char* msg) {
+    return g_base->xGetLastError ? g_base->xGetLastError(g_base, n, msg) : 0;
+}
+
+int vfs_current_time_int64(sqlite3_vfs*, sqlite3_int64* out) {
+    return g_base->xCurrentTimeInt64(g_base, out);
+}
+
+} // namespace
+
+bool register_page_vfs(const std::vector<uint8_t>& master_key) {
+#ifndef SQLITE_FCNTL_RESERVE_BYTES
+    (void)master_key;
+    Logger::warn("[PageVFS] SQLite too old for reserved page space - page encryption unavailable");
+    return false;
+#else
+    if (master_key.size() != KEY_SIZE) return false;
+
+    // Domain-separate the page key from the whole-file key
+    std::string password(master_key.begin(), master_key.end());
+    std::vector<uint8_t> page_key = derive_key(password, std::vector<uint8_t>(PAGE_KEY_SALT.begin(), PAGE_KEY_SALT.end()));
+    if (page_key.size() != KEY_SIZE) return false;
+
+    std::lock_guard<std::mutex> lock(g_mutex);
+    std::memcpy(g_page_key, page_key.data(), KEY_SIZE);
+    if (g_registered) return true;
+
+    g_base = sqlite3_vfs_find(nullptr);
+    if (!g_base || g_base->iVersion < 2) {
+        Logger::error("[PageVFS] No usable default SQLite VFS");
+        return false;
+    }
+
+    std::memset(&g_vfs, 0, sizeof(g_vfs));
+    g_vfs.iVersion = 2;
+    g_vfs.szOsFile = static_cast<int>(sizeof(PageFile)) + g_base->szOsFile;
+    g_vfs.mxPathname = g_base->mxPathname;
+    g_vfs.zName = PAGE_VFS_NAME;
+    g_vfs.xOpen = vfs_open;
+    g_vfs.xDelete = vfs_delete;
+    g_vfs.xAccess = vfs_access;
+    g_vfs.xFullPathname = vfs_full_pathname;
+    g_vfs.xDlOpen = vfs_dl_open;
+    g_vfs.xDlError = vfs_dl_error;
+    g_vfs.xDlSym = vfs_dl_sym;
+    g_vfs.xDlClose = vfs_dl_close;
+    g_vfs.xRandomness = vfs_randomness;
+    g_vfs.xSleep = vfs_sleep;
+    g_vfs.xCurrentTime = vfs_current_time;
+    g_vfs.xGetLastError = vfs_get_last_error;
+    g_vfs.xCurrentTimeInt64 = vfs_current_time_int64;
+
+    if (sqlite3_vfs_register(&g_vfs, 0) != SQLITE_OK) {
+        Logger::error("[PageVFS] Failed to register VFS");
+        return false;
+    }
+    g_registered = true;
+    Logger::debug("[PageVFS] Registered on top of '" + std::string(g_base->zName) + "'");
+    return true;
+#endif
+}
+
+bool configure_page_encryption(sqlite3* db) {
+#ifdef SQLITE_FCNTL_RESERVE_BYTES
+    int reserve = PAGE_RESERVE_BYTES;
+    return sqlite3_file_control(db, "main", SQLITE_FCNTL_RESERVE_BYTES, &reserve) == SQLITE_OK;
+#else
+    (void)db;
+    return false;
+#endif
+}
+
+bool is_page_encrypted_db(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+
+    uint8_t header[DB_HEADER_SIZE];
+    file.read(reinterpret_cast<char*>(header), sizeof(header));
+
+    return file.gcount() == DB_HEADER_SIZE &&
+           std::memcmp(header, SQLITE_MAGIC, sizeof(SQLITE_MAGIC)) == 0 &&
+           header[DB_RESERVE_OFFSET] >= PAGE_RESERVE_BYTES;
+}
+
+} // namespace crypto
@@ -0,0 +1,41 @@
+// sqlite_page_vfs.hpp - SQLite VFS that encrypts the file index page by page
+// Pages are sealed with AES-256-GCM as SQLite writes them and opened as it
+// reads them, so the database stays encrypted at rest without the whole-file
+// decrypt on startup / encrypt on shutdown.
+
+#ifndef SQLITE_PAGE_VFS_HPP
+#define SQLITE_PAGE_VFS_HPP
+
+#include "crypto.hpp"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+struct sqlite3;
+
+namespace crypto {
+
+// VFS name to pass to sqlite3_open_v2()
+constexpr const char* PAGE_VFS_NAME = "pdcrypt-page";
+
+// Bytes SQLite must reserve at the end of every page: IV (12) + GCM tag (16)
+constexpr int PAGE_RESERVE_BYTES = static_cast<int>(IV_SIZE + TAG_SIZE);
+
+// Register the page-encrypting VFS (not as default). The page key is derived
+// from `master_key` with derive_key(), so it never equals the whole-file key.
+// Safe to call again; later calls only replace the key. Returns false when
+// this SQLite build cannot reserve per-page space.
+bool register_page_vfs(const std::vector<uint8_t>& master_key);
+
+// Ask SQLite to reserve PAGE_RESERVE_BYTES per page on a freshly created
+// database. Must run before the first write; a no-op on existing files.
+bool configure_page_encryption(sqlite3* db);
+
+// True if `path` is a SQLite database laid out for page encryption
+// (reserved space large enough for IV + tag). Legacy plaintext databases
+// and PDCRYPT1 whole-file blobs return false.
+bool is_page_encrypted_db(const std::string& path);
+
+} // namespace crypto
+
+#endif // SQLITE_PAGE_VFS_HPP
@@ -0,0 +1,193 @@
+// startup.cpp - Startup phase timings and the first-paint cloud view snapshot
+
+#include "startup.hpp"
+#include "crypto.hpp"
+#include "logger.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+namespace fs = std::filesystem;
+
+namespace proton {
+
+namespace {
+
+constexpr char SNAPSHOT_MAGIC[] = "PDSNAP1";
+constexpr size_t ENTRY_FIELDS = 7;
+
+// Fields are NUL-terminated; no path component can contain a NUL
+void put_field(std::string& out, const std::string& field) {
+    out += field;
+    out.push_back('\0');
+}
+
+bool next_field(const std::string& in, size_t& pos, std::string& field) {
+    size_t end = in.find('\0', pos);
+    if (end == std::string::npos) return false;
+    field.assign(in, pos, end - pos);
+    pos = end + 1;
+    return true;
+}
+
+} // namespace
+
+// ============================================================================
+// StartupTimeline
+// ============================================================================
+
+StartupTimeline& StartupTimeline::getInstance() {
+    static StartupTimeline instance;
+    return instance;
+}
+
+StartupTimeline::StartupTimeline()
+    : start_(std::chrono::steady_clock::now()), last_(start_) {}
+
+void StartupTimeline::mark(const std::string& phase) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto now = std::chrono::steady_clock::now();
+    phases_.emplace_back(phase, std::chrono::duration_cast<std::chrono::milliseconds>(now - last_).count());
+    if (Trace::enabled()) Trace::record("startup", "phase", last_, now, phase);
+    last_ = now;
+}
+
+void StartupTimeline::report(const std::string& milestone, int64_t budget_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto now = std::chrono::steady_clock::now();
+    auto total = std::chrono::duration_cast<std::chrono::milliseconds>(now - start_).count();
+    std::string breakdown;
+    for (const auto& [phase, ms] : phases_) {
+        if (!breakdown.empty()) breakdown += ", ";
+        breakdown += phase + " " + std::to_string(ms) + " ms";
+    }
+    phases_.clear();
+    last_ = now;
+
+    std::string line = "[Startup] " + milestone + " after " + std::to_string(total) + " ms";
+    if (!breakdown.empty()) line += " (" + breakdown + ")";
+    if (budget_ms > 0 && total > budget_ms) {
+        Logger::warn(line + " - over the " + std::to_string(budget_ms) + " ms budget");
+    } else {
+        Logger::info(line);
+    }
+}
+
+int64_t StartupTimeline::elapsed_ms() const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start_).count();
+}
+
+// ============================================================================
+// FirstPaintSnapshot
+// ============================================================================
+
+FirstPaintSnapshot& FirstPaintSnapshot::getInstance() {
+    static FirstPaintSnapshot instance;
+    return instance;
+}
+
+FirstPaintSnapshot::FirstPaintSnapshot() {
+    const char* home = std::getenv("HOME");
+    if (home) file_path_ = std::string(home) + "/.cache/proton-drive/first_paint.bin";
+}
+
+void FirstPaintSnapshot::preload() {
+    if (file_path_.empty() || pending_.valid()) return;
+    pending_ = std::async(std::launch::async, [this]() { return load(); });
+}
+
+bool FirstPaintSnapshot::take(std::string& path, std::vector<IndexedFile>& entries) {
+    if (!pending_.valid()) return false;
+    View view = pending_.get();
+    if (view.path.empty()) return false;
+    path = std::move(view.path);
+    entries = std::move(view.entries);
+    return true;
+}
+
+FirstPaintSnapshot::View FirstPaintSnapshot::load() const {
+    View view;
+    std::ifstream in(file_path_, std::ios::binary);
+    if (!in) return view;
+    std::vector<uint8_t> sealed((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    // Same key as the index it mirrors; none yet means nothing was saved
+    std::vector<uint8_t> key = crypto::retrieve_encrypted_key();
+    if (key.empty()) return view;
+    std::vector<uint8_t> plain = crypto::decrypt(sealed, key);
+    if (plain.empty()) {
+        Logger::warn("[Startup] First-paint snapshot unreadable, ignoring it");
+        return view;
+    }
+
+    std::string body(plain.begin(), plain.end());
+    size_t pos = 0;
+    std::string magic, path;
+    if (!next_field(body, pos, magic) || magic != SNAPSHOT_MAGIC || !next_field(body, pos, path)) {
+        return view;
+    }
+
+    std::string fields[ENTRY_FIELDS];
+    while (pos < body.size()) {
+        for (auto& field : fields) {
+            if (!next_field(body, pos, field)) return View{};
+        }
+        IndexedFile file{};
+        file.path = fields[0];
+        file.parent_path = fields[1];
+        file.name = fields[2];
+        file.mod_time = fields[3];
+        file.extension = fields[4];
+        file.size = std::strtoll(fields[5].c_str(), nullptr, 10);
+        file.is_directory = fields[6] == "1";
+        view.entries.push_back(std::move(file));
+    }
+    view.path = std::move(path);
+    return view;
+}
+
+void FirstPaintSnapshot::save(const std::string& path, const std::vector<IndexedFile>& entries) {
+    if (file_path_.empty() || path.empty()) return;
+    std::vector<uint8_t> key = crypto::retrieve_encrypted_key();
+    if (key.empty()) return;
+
+    std::string body;
+    put_field(body, SNAPSHOT_MAGIC);
+    put_field(body, path);
+    size_t count = std::min(entries.size(), MAX_ENTRIES);
+    for (size_t i = 0; i < count; i++) {
+        const auto& file = entries[i];
+        put_field(body, file.path);
+        put_field(body, file.parent_path);
+        put_field(body, file.name);
+        put_field(body, file.mod_time);
+        put_field(body, file.extension);
+        put_field(body, std::to_string(file.size));
+        put_field(body, file.is_directory ? "1" : "0");
+    }
+
+    std::vector<uint8_t> sealed = crypto::encrypt(std::vector<uint8_t>(body.begin(), body.end()), key);
+    if (sealed.empty()) return;
+
+    std::string tmp = file_path_ + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) return;
+        out.write(reinterpret_cast<const char*>(sealed.data()), static_cast<std::streamsize>(sealed.size()));
+        if (!out) return;
+    }
+    std::error_code ec;
+    fs::permissions(tmp, fs::perms::owner_read | fs::perms::owner_write, fs::perm_options::replace, ec);
+    fs::rename(tmp, file_path_, ec);
+    if (ec) {
+        Logger::warn("[Startup] Failed to save first-paint snapshot: " + ec.message());
+        return;
+    }
+    Logger::debug("[Startup] Saved first-paint snapshot of " + path + " (" + std::to_string(count) + " entries)");
+}
+
+} // namespace proton
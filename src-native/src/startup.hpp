@@ -0,0 +1,80 @@
+// startup.hpp - Startup pipeline support: phase timings and first paint
+// StartupTimeline records how long each step from main() to an interactive
+// window took and logs the breakdown once the first frame is drawn, against
+// a 300 ms window-ready budget, and again when the deferred subsystems are
+// up. FirstPaintSnapshot persists the rows of the last cloud view (encrypted
+// with the index key) so the next launch can paint them before FileIndex is
+// open; the live listing replaces them once the index is ready.
+
+#ifndef STARTUP_HPP
+#define STARTUP_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include "file_index.hpp"
+
+namespace proton {
+
+class StartupTimeline {
+public:
+    static StartupTimeline& getInstance();
+
+    static constexpr int64_t WINDOW_READY_BUDGET_MS = 300;
+
+    // Close the phase running since the previous mark (or process start)
+    void mark(const std::string& phase);
+    // Log the phases marked since the last report and the time since
+    // process start, warning if that exceeds `budget_ms` (0 = no budget)
+    void report(const std::string& milestone, int64_t budget_ms = 0);
+    int64_t elapsed_ms() const;
+
+private:
+    StartupTimeline();
+
+    StartupTimeline(const StartupTimeline&) = delete;
+    StartupTimeline& operator=(const StartupTimeline&) = delete;
+
+    std::mutex mutex_;
+    std::chrono::steady_clock::time_point start_;
+    std::chrono::steady_clock::time_point last_;
+    std::vector<std::pair<std::string, int64_t>> phases_;
+};
+
+class FirstPaintSnapshot {
+public:
+    static FirstPaintSnapshot& getInstance();
+
+    // Start reading and decrypting the snapshot on a worker thread
+    void preload();
+    // Wait for preload() and hand over its result; false if there is none
+    bool take(std::string& path, std::vector<IndexedFile>& entries);
+    // Persist `entries` as the view of `path` (browse path, "/Documents")
+    void save(const std::string& path, const std::vector<IndexedFile>& entries);
+
+private:
+    FirstPaintSnapshot();
+
+    FirstPaintSnapshot(const FirstPaintSnapshot&) = delete;
+    FirstPaintSnapshot& operator=(const FirstPaintSnapshot&) = delete;
+
+    struct View {
+        std::string path;
+        std::vector<IndexedFile> entries;
+    };
+    View load() const;
+
+    std::string file_path_;
+    std::future<View> pending_;
+
+    // Only what fits a window or two; the rest arrives with revalidation
+    static constexpr size_t MAX_ENTRIES = 2000;
+};
+
+} // namespace proton
+
+#endif // STARTUP_HPP
@@ -0,0 +1,282 @@
+// status_service.cpp - One published view of the sync engine's state
+
+#include "status_service.hpp"
+#include "sync_manager.hpp"
+#include "sync_job_metadata.hpp"
+#include "sync_scheduler.hpp"
+#include "network_monitor.hpp"
+#include "file_index.hpp"
+#include "task_pool.hpp"
+#include "logger.hpp"
+#include <sstream>
+
+namespace proton {
+
+bool SyncStatus::operator==(const SyncStatus& other) const {
+    return scheduler_active == other.scheduler_active &&
+           online == other.online &&
+           jobs == other.jobs &&
+           running_syncs == other.running_syncs &&
+           queued_transfers == other.queued_transfers &&
+           transfer_rate == other.transfer_rate &&
+           bytes_transferred == other.bytes_transferred &&
+           bytes_total == other.bytes_total &&
+           errors == other.errors &&
+           last_error == other.last_error &&
+           indexing == other.indexing &&
+           index_progress == other.index_progress &&
+           indexed_files == other.indexed_files &&
+           indexed_folders == other.indexed_folders &&
+           last_indexed == other.last_indexed;
+}
+
+const char* const STATUS_PROPERTY_NAMES[] = {
+    "SchedulerActive", "Online", "Jobs", "RunningSyncs", "QueuedTransfers",
+    "TransferRate", "BytesTransferred", "BytesTotal", "Errors", "LastError",
+    "Indexing", "IndexProgress", "IndexedFiles", "IndexedFolders", "LastIndexed",
+    nullptr
+};
+
+GVariant* status_property(const SyncStatus& status, const char* name) {
+    std::string n = name;
+    if (n == "SchedulerActive") return g_variant_new_boolean(status.scheduler_active);
+    if (n == "Online") return g_variant_new_boolean(status.online);
+    if (n == "Jobs") return g_variant_new_uint32(status.jobs);
+    if (n == "RunningSyncs") return g_variant_new_uint32(status.running_syncs);
+    if (n == "QueuedTransfers") return g_variant_new_uint32(status.queued_transfers);
+    if (n == "TransferRate") return g_variant_new_uint64(status.transfer_rate);
+    if (n == "BytesTransferred") return g_variant_new_uint64(status.bytes_transferred);
+    if (n == "BytesTotal") return g_variant_new_uint64(status.bytes_total);
+    if (n == "Errors") return g_variant_new_uint32(status.errors);
+    if (n == "LastError") return g_variant_new_string(status.last_error.c_str());
+    if (n == "Indexing") return g_variant_new_boolean(status.indexing);
+    if (n == "IndexProgress") return g_variant_new_uint32(status.index_progress);
+    if (n == "IndexedFiles") return g_variant_new_uint64(status.indexed_files);
+    if (n == "IndexedFolders") return g_variant_new_uint64(status.indexed_folders);
+    if (n == "LastIndexed") return g_variant_new_string(status.last_indexed.c_str());
+    return nullptr;
+}
+
+bool apply_status_property(SyncStatus& status, const char* name, GVariant* value) {
+    std::string n = name;
+    auto is = [value](const char* type) { return g_variant_is_of_type(value, G_VARIANT_TYPE(type)); };
+    if (is("b")) {
+        bool v = g_variant_get_boolean(value);
+        if (n == "SchedulerActive") status.scheduler_active = v;
+        else if (n == "Online") status.online = v;
+        else if (n == "Indexing") status.indexing = v;
+        else return false;
+    } else if (is("u")) {
+        uint32_t v = g_variant_get_uint32(value);
+        if (n == "Jobs") status.jobs = v;
+        else if (n == "RunningSyncs") status.running_syncs = v;
+        else if (n == "QueuedTransfers") status.queued_transfers = v;
+        else if (n == "Errors") status.errors = v;
+        else if (n == "IndexProgress") status.index_progress = v;
+        else return false;
+    } else if (is("t")) {
+        uint64_t v = g_variant_get_uint64(value);
+        if (n == "TransferRate") status.transfer_rate = v;
+        else if (n == "BytesTransferred") status.bytes_transferred = v;
+        else if (n == "BytesTotal") status.bytes_total = v;
+        else if (n == "IndexedFiles") status.indexed_files = v;
+        else if (n == "IndexedFolders") status.indexed_folders = v;
+        else return false;
+    } else if (is("s")) {
+        const gchar* v = g_variant_get_string(value, nullptr);
+        if (n == "LastError") status.last_error = v;
+        else if (n == "LastIndexed") status.last_indexed = v;
+        else return false;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+StatusService& StatusService::getInstance() {
+    static StatusService instance;
+    return instance;
+}
+
+void StatusService::start() {
+    if (timer_id_ > 0) return;
+    refresh();
+    timer_id_ = g_timeout_add_seconds(1, +[](gpointer data) -> gboolean {
+        static_cast<StatusService*>(data)->refresh();
+        return G_SOURCE_CONTINUE;
+    }, this);
+}
+
+void StatusService::stop() {
+    if (timer_id_ > 0) {
+        g_source_remove(timer_id_);
+        timer_id_ = 0;
+    }
+    if (metrics_service_) {
+        g_socket_service_stop(metrics_service_);
+        g_socket_listener_close(G_SOCKET_LISTENER(metrics_service_));
+        g_object_unref(metrics_service_);
+        metrics_service_ = nullptr;
+    }
+}
+
+SyncStatus StatusService::sample() {
+    SyncStatus s;
+    s.scheduler_active = SyncScheduler::getInstance().is_active();
+    s.online = NetworkMonitor::getInstance().is_online();
+    s.jobs = static_cast<uint32_t>(SyncJobRegistry::getInstance().snapshot()->jobs.size());
+    s.queued_transfers = static_cast<uint32_t>(TaskPool::getInstance().queued(TaskLane::Transfer));
+
+    // Snapshot copy kept current by SyncManager's RC poller
+    double rate = 0, bytes = 0, total = 0;
+    for (const auto& job : SyncManager::getInstance().get_rc_job_stats()) {
+        if (!job.rc_daemon) s.running_syncs++;
+        rate += job.speed;
+        bytes += job.bytes;
+        total += job.total_bytes;
+        s.errors += static_cast<uint32_t>(job.errors);
+        if (!job.last_error.empty()) s.last_error = job.last_error;
+    }
+    s.transfer_rate = static_cast<uint64_t>(rate);
+    s.bytes_transferred = static_cast<uint64_t>(bytes);
+    s.bytes_total = static_cast<uint64_t>(total);
+
+    auto& index = FileIndex::getInstance();
+    s.indexing = index.is_indexing();
+    s.index_progress = s.indexing ? static_cast<uint32_t>(index.get_index_progress()) : 0;
+
+    // The counts are a table scan: read them at startup and after each index run
+    if (!sampled_ || (was_indexing_ && !s.indexing)) {
+        auto stats = index.get_stats();
+        s.indexed_files = static_cast<uint64_t>(stats.total_files);
+        s.indexed_folders = static_cast<uint64_t>(stats.total_folders);
+        s.last_indexed = stats.last_full_index;
+    } else {
+        std::lock_guard<std::mutex> lock(mutex_);
+        s.indexed_files = status_.indexed_files;
+        s.indexed_folders = status_.indexed_folders;
+        s.last_indexed = status_.last_indexed;
+    }
+    sampled_ = true;
+    was_indexing_ = s.indexing;
+    return s;
+}
+
+void StatusService::refresh() {
+    publish(sample());
+}
+
+void StatusService::publish(const SyncStatus& status) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (status == status_) return;
+        status_ = status;
+    }
+    // Copy: a listener may remove itself
+    auto listeners = listeners_;
+    for (const auto& [id, listener] : listeners) {
+        listener(status);
+    }
+}
+
+SyncStatus StatusService::current() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return status_;
+}
+
+int StatusService::add_listener(Listener listener) {
+    int id = next_listener_id_++;
+    listeners_[id] = std::move(listener);
+    return id;
+}
+
+void StatusService::remove_listener(int id) {
+    listeners_.erase(id);
+}
+
+std::string StatusService::metrics_text() const {
+    SyncStatus s = current();
+    std::ostringstream out;
+    auto metric = [&out](const char* name, const char* type, const char* help, auto value) {
+        out << "# HELP proton_drive_" << name << " " << help << "\n"
+            << "# TYPE proton_drive_" << name << " " << type << "\n"
+            << "proton_drive_" << name << " " << value << "\n";
+    };
+    metric("scheduler_active", "gauge", "1 while scheduled sync runs, 0 while paused", s.scheduler_active ? 1 : 0);
+    metric("online", "gauge", "1 when the network is reachable", s.online ? 1 : 0);
+    metric("sync_jobs", "gauge", "Registered sync jobs", s.jobs);
+    metric("running_syncs", "gauge", "Running rclone sync processes", s.running_syncs);
+    metric("queued_transfers", "gauge", "Transfers waiting for a worker", s.queued_transfers);
+    metric("transfer_rate_bytes", "gauge", "Combined transfer rate of running syncs in bytes per second", s.transfer_rate);
+    metric("transferred_bytes", "gauge", "Bytes moved so far by running syncs", s.bytes_transferred);
+    metric("transfer_total_bytes", "gauge", "Bytes running syncs expect to move", s.bytes_total);
+    metric("sync_errors", "gauge", "Errors reported by running syncs", s.errors);
+    metric("indexing", "gauge", "1 while the file index is being built", s.indexing ? 1 : 0);
+    metric("index_progress_percent", "gauge", "Progress of the running index build", s.index_progress);
+    metric("indexed_files", "gauge", "Files in the index", s.indexed_files);
+    metric("indexed_folders", "gauge", "Folders in the index", s.indexed_folders);
+    return out.str();
+}
+
+bool StatusService::start_metrics(uint16_t port) {
+    if (metrics_service_ || port == 0) return metrics_service_ != nullptr;
+
+    // Loopback only: the numbers are not secret but the port is unauthenticated
+    GSocketService* service = g_threaded_socket_service_new(2);
+    GInetAddress* loopback = g_inet_address_new_loopback(G_SOCKET_FAMILY_IPV4);
+    GSocketAddress* address = g_inet_socket_address_new(loopback, port);
+    GError* error = nullptr;
+    gboolean ok = g_socket_listener_add_address(G_SOCKET_LISTENER(service), address,
+        G_SOCKET_TYPE_STREAM, G_SOCKET_PROTOCOL_TCP, nullptr, nullptr, &error);
+    g_object_unref(address);
+    g_object_unref(loopback);
+    if (!ok) {
+        Logger::warn("[Status] Metrics endpoint unavailable on port " + std::to_string(port) + ": " +
+                     (error ? error->message : "unknown"));
+        if (error) g_error_free(error);
+        g_object_unref(service);
+        return false;
+    }
+
+    g_signal_connect(service, "run", G_CALLBACK(on_metrics_request), this);
+    g_socket_service_start(service);
+    metrics_service_ = service;
+    Logger::info("[Status] Metrics at http://127.0.0.1:" + std::to_string(port) + "/metrics");
+    return true;
+}
+
+// Runs on a GThreadedSocketService worker, one connection per call
+gboolean StatusService::on_metrics_request(GThreadedSocketService* /*service*/, GSocketConnection* connection,
+                                           GObject* /*source*/, gpointer user_data) {
+    auto* self = static_cast<StatusService*>(user_data);
+    g_socket_set_timeout(g_socket_connection_get_socket(connection), 5);
+
+    // Read the request head; only the request line matters
+    GInputStream* in = g_io_stream_get_input_stream(G_IO_STREAM(connection));
+    std::string request;
+    char buf[1024];
+    while (request.size() < 8192 && request.find("\r\n\r\n") == std::string::npos) {
+        gssize n = g_input_stream_read(in, buf, sizeof(buf), nullptr, nullptr);
+        if (n <= 0) break;
+        request.append(buf, static_cast<size_t>(n));
+    }
+
+    std::string status_line = "HTTP/1.0 200 OK";
+    std::string body;
+    if (request.rfind("GET /metrics ", 0) == 0 || request.rfind("GET / ", 0) == 0) {
+        body = self->metrics_text();
+    } else {
+        status_line = "HTTP/1.0 404 Not Found";
+        body = "Not found\n";
+    }
+    std::string response = status_line + "\r\n"
+        "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+        "Content-Length: " + std::to_string(body.size()) + "\r\n"
+        "Connection: close\r\n\r\n" + body;
+
+    GOutputStream* out = g_io_stream_get_output_stream(G_IO_STREAM(connection));
+    g_output_stream_write_all(out, response.data(), response.size(), nullptr, nullptr, nullptr);
+    return TRUE;
+}
+
+} // namespace proton
@@ -0,0 +1,103 @@
+// status_service.hpp - One published view of the sync engine's state
+// The window, the tray and outside monitoring used to each work out whether
+// syncs were running on their own timers (the tray forked systemctl every
+// five seconds). StatusService samples the engine's in-memory state once a
+// second in the process that runs it and tells listeners only when
+// something changed. The daemon exports the same fields as D-Bus properties
+// with PropertiesChanged (daemon_service.hpp). A GUI that is a client of the
+// daemon feeds those into publish(), so its listeners see the same stream.
+// With a metrics port configured, it also serves Prometheus text on
+// 127.0.0.1.
+
+#ifndef STATUS_SERVICE_HPP
+#define STATUS_SERVICE_HPP
+
+#include <gio/gio.h>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace proton {
+
+struct SyncStatus {
+    bool scheduler_active = false;  // Scheduled sync running (not paused)
+    bool online = true;
+    uint32_t jobs = 0;              // Registered sync jobs
+    uint32_t running_syncs = 0;     // rclone sync/copy/bisync processes
+    uint32_t queued_transfers = 0;  // Waiting on the TaskPool Transfer lane
+    uint64_t transfer_rate = 0;     // bytes/s over all running syncs
+    uint64_t bytes_transferred = 0;
+    uint64_t bytes_total = 0;
+    uint32_t errors = 0;            // Errors reported by running syncs
+    std::string last_error;
+    bool indexing = false;
+    uint32_t index_progress = 0;    // 0-100
+    uint64_t indexed_files = 0;
+    uint64_t indexed_folders = 0;
+    std::string last_indexed;       // ISO8601, last full index
+
+    bool operator==(const SyncStatus& other) const;
+    bool operator!=(const SyncStatus& other) const { return !(*this == other); }
+};
+
+// D-Bus property names of SyncStatus, nullptr-terminated
+extern const char* const STATUS_PROPERTY_NAMES[];
+
+// Floating GVariant for one property, nullptr for an unknown name
+GVariant* status_property(const SyncStatus& status, const char* name);
+
+// Set one field from its property value; false for an unknown name or type
+bool apply_status_property(SyncStatus& status, const char* name, GVariant* value);
+
+class StatusService {
+public:
+    static StatusService& getInstance();
+
+    // Sample the engine running in this process every second. Main thread.
+    void start();
+    void stop();
+
+    // Sample now (e.g. right after Pause/Resume) instead of on the next tick
+    void refresh();
+
+    // Replace the current status, e.g. with the daemon's. Main thread.
+    void publish(const SyncStatus& status);
+
+    SyncStatus current() const;
+
+    // Called on the main thread with the new status whenever it changes
+    using Listener = std::function<void(const SyncStatus& status)>;
+    int add_listener(Listener listener);
+    void remove_listener(int id);
+
+    // Prometheus text exposition on 127.0.0.1:port
+    bool start_metrics(uint16_t port);
+    std::string metrics_text() const;
+
+private:
+    StatusService() = default;
+    ~StatusService() = default;
+    StatusService(const StatusService&) = delete;
+    StatusService& operator=(const StatusService&) = delete;
+
+    SyncStatus sample();
+    static gboolean on_metrics_request(GThreadedSocketService* service, GSocketConnection* connection,
+                                       GObject* source, gpointer user_data);
+
+    mutable std::mutex mutex_;
+    SyncStatus status_;
+    bool sampled_ = false;
+    bool was_indexing_ = false;
+
+    guint timer_id_ = 0;
+    std::map<int, Listener> listeners_;
+    int next_listener_id_ = 1;
+
+    GSocketService* metrics_service_ = nullptr;
+};
+
+} // namespace proton
+
+#endif // STATUS_SERVICE_HPP
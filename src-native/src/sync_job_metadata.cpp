@@ -1,7 +1,12 @@
 #include "sync_job_metadata.hpp"
 #include "device_identity.hpp"
 #include "app_window_helpers.hpp"
+#include "rclone_rc.hpp"
+#include "file_index.hpp"
+#include "lsjson_parser.hpp"
 #include "logger.hpp"
+#include "task_pool.hpp"
+#include "local_state.hpp"
 #include <fstream>
 #include <sstream>
 #include <random>
@@ -15,6 +20,7 @@
 #include <atomic>
 #include <cstdio>
 #include <unistd.h>
+#include <fcntl.h>
 #include <sys/statfs.h>
 #include <sys/stat.h>
 #include <sys/mount.h>
@@ -51,6 +57,8 @@ std::string SyncJobMetadata::toJson() const {
     ss << "    \"last_sync_time\": " << last_sync_time << ",\n";
     ss << "    \"last_sync_device_id\": \"" << last_sync_device_id << "\",\n";
     ss << "    \"last_sync_status\": \"" << last_sync_status << "\",\n";
+    ss << "    \"learned_transfers\": " << learned_transfers << ",\n";
+    ss << "    \"learned_checkers\": " << learned_checkers << ",\n";
     ss << "    \"shared_devices\": [\n";
     for (size_t i = 0; i < shared_devices.size(); i++) {
         ss << "      " << shared_devices[i].toJson();
@@ -94,6 +102,54 @@ void SyncJobMetadata::removeSharedDevice(const std::string& device_id) {
     );
 }
 
+// ============ SyncJobSnapshot Implementation ============
+
+std::string SyncJobSnapshot::normalizeLocalPath(const std::string& path) {
+    std::string normal = fs::path(path).lexically_normal().string();
+    while (normal.size() > 1 && normal.back() == '/') normal.pop_back();
+    return normal;
+}
+
+void SyncJobSnapshot::buildIndexes() {
+    by_id_.clear();
+    by_local_.clear();
+    by_id_.reserve(jobs.size());
+    for (size_t i = 0; i < jobs.size(); i++) {
+        by_id_.emplace(jobs[i].job_id, i);
+        if (!jobs[i].local_path.empty()) by_local_.emplace(normalizeLocalPath(jobs[i].local_path), i);
+    }
+}
+
+const SyncJobMetadata* SyncJobSnapshot::findById(const std::string& job_id) const {
+    auto it = by_id_.find(job_id);
+    return it == by_id_.end() ? nullptr : &jobs[it->second];
+}
+
+const SyncJobMetadata* SyncJobSnapshot::findByLocalPath(const std::string& local_path) const {
+    auto it = by_local_.find(normalizeLocalPath(local_path));
+    return it == by_local_.end() ? nullptr : &jobs[it->second];
+}
+
+const SyncJobMetadata* SyncJobSnapshot::findNestedLocalPath(const std::string& local_path) const {
+    const std::string path = normalizeLocalPath(local_path);
+    
+    // A synced folder above `path`: one lookup per ancestor
+    fs::path ancestor(path);
+    while (ancestor.has_relative_path()) {
+        ancestor = ancestor.parent_path();
+        auto it = by_local_.find(ancestor.string());
+        if (it != by_local_.end()) return &jobs[it->second];
+    }
+    
+    // A synced folder below it sorts right after "path/"
+    const std::string prefix = path == "/" ? path : path + "/";
+    auto it = by_local_.lower_bound(prefix);
+    if (it != by_local_.end() && it->first != path && it->first.compare(0, prefix.size(), prefix) == 0) {
+        return &jobs[it->second];
+    }
+    return nullptr;
+}
+
 // ============ SyncJobRegistry Implementation ============
 
 SyncJobRegistry& SyncJobRegistry::getInstance() {
@@ -104,6 +160,7 @@ SyncJobRegistry& SyncJobRegistry::getInstance() {
 void SyncJobRegistry::loadJobs() {
     const char* home = std::getenv("HOME");
     if (!home) return;
+    std::lock_guard<std::recursive_mutex> lock(write_mutex_);
     
     config_path_ = std::string(home) + "/.config/proton-drive/sync_jobs.json";
     
@@ -180,6 +237,18 @@ void SyncJobRegistry::loadJobs() {
                 if (start < end) job.sync_mode = content.substr(start, end - start);
             }
             
+            // Learned concurrency (numbers; only within this job's block)
+            size_t block_end = content.find("\"job_id\"", pos + 1);
+            auto extract_int = [&](const char* key, int& out) {
+                size_t key_pos = content.find(key, pos);
+                if (key_pos == std::string::npos || key_pos > block_end) return;
+                size_t colon = content.find(':', key_pos);
+                if (colon == std::string::npos) return;
+                try { out = std::stoi(content.substr(colon + 1, 16)); } catch (...) {}
+            };
+            extract_int("\"learned_transfers\"", job.learned_transfers);
+            extract_int("\"learned_checkers\"", job.learned_checkers);
+            
             if (!job.job_id.empty()) {
                 jobs_.push_back(job);
                 job_count++;
@@ -197,6 +266,10 @@ void SyncJobRegistry::loadJobs() {
     
     // MIGRATION: Import orphan .conf files that were created by old code before registry was added
     migrateOrphanConfFiles();
+    
+    // Publish what was loaded even when neither step above saved; the file
+    // itself is only rewritten once something changes
+    publish();
 }
 
 void SyncJobRegistry::migrateOrphanConfFiles() {
@@ -326,6 +399,7 @@ void SyncJobRegistry::migrateOrphanConfFiles() {
 void SyncJobRegistry::cleanupStaleEntries() {
     const char* home = std::getenv("HOME");
     if (!home) return;
+    std::lock_guard<std::recursive_mutex> lock(write_mutex_);
     
     std::string job_dir = std::string(home) + "/.config/proton-drive/jobs";
     std::string cache_dir = std::string(home) + "/.cache/rclone/bisync";
@@ -391,57 +465,62 @@ void SyncJobRegistry::cleanupStaleEntries() {
 }
 
 void SyncJobRegistry::saveJobs() {
+    std::lock_guard<std::recursive_mutex> lock(write_mutex_);
+    commit(true);
+}
+
+void SyncJobRegistry::publish() {
+    auto next = std::make_shared<SyncJobSnapshot>();
+    next->version = snapshot()->version + 1;
+    next->jobs = jobs_;
+    next->buildIndexes();
+    std::atomic_store(&snapshot_, SyncJobSnapshotPtr(std::move(next)));
+}
+
+void SyncJobRegistry::commit(bool export_to_cloud) {
+    publish();
+    
     if (config_path_.empty()) {
         const char* home = std::getenv("HOME");
         if (!home) return;
         config_path_ = std::string(home) + "/.config/proton-drive/sync_jobs.json";
     }
     
-    // Ensure directory exists
-    std::error_code ec_dir;
-    fs::path config_dir = fs::path(config_path_).parent_path();
-    if (!fs::exists(config_dir, ec_dir)) {
-        fs::create_directories(config_dir, ec_dir);
-    }
-    
-    std::ofstream file(config_path_);
-    if (!file.is_open()) {
-        Logger::error("[SyncJobRegistry] Failed to save jobs to " + config_path_);
-        return;
-    }
-    
-    file << "{\n";
-    file << "  \"version\": 2,\n";
-    file << "  \"device_id\": \"" << DeviceIdentity::getInstance().getDeviceId() << "\",\n";
-    file << "  \"jobs\": [\n";
-    
+    std::string content;
+    content += "{\n";
+    content += "  \"version\": 2,\n";
+    content += "  \"device_id\": \"" + DeviceIdentity::getInstance().getDeviceId() + "\",\n";
+    content += "  \"jobs\": [\n";
     for (size_t i = 0; i < jobs_.size(); i++) {
-        file << jobs_[i].toJson();
-        if (i < jobs_.size() - 1) file << ",";
-        file << "\n";
+        content += jobs_[i].toJson();
+        if (i < jobs_.size() - 1) content += ",";
+        content += "\n";
     }
+    content += "  ]\n";
+    content += "}\n";
     
-    file << "  ]\n";
-    file << "}\n";
-    file.close();
+    // Most commits (sync start/finish bookkeeping) rewrite identical bytes
+    if (content == saved_content_) return;
+    if (!writeConfigAtomically(content)) return;
+    saved_content_ = std::move(content);
     
     Logger::info("[SyncJobRegistry] Saved " + std::to_string(jobs_.size()) + " sync jobs");
     
     // Export config to cloud for multi-device discovery (async, non-blocking)
     // Debounce: only export if at least 30 seconds since last export
-    if (!jobs_.empty()) {
+    if (export_to_cloud && !jobs_.empty()) {
         static std::atomic<std::time_t> last_export_time{0};
         std::time_t now = std::time(nullptr);
         std::time_t last = last_export_time.load();
         if (now - last >= 30) {
             last_export_time.store(now);
-            std::thread([this]() {
+            proton::TaskPool::getInstance().submit(proton::TaskLane::Background, [this]() {
                 try {
                     exportConfigToCloud();
                 } catch (const std::exception& e) {
                     Logger::warn("[SyncJobRegistry] Cloud export failed: " + std::string(e.what()));
                 }
-            }).detach();
+            });
         } else {
             Logger::debug("[SyncJobRegistry] Skipping cloud export (debounce, last was " + 
                          std::to_string(now - last) + "s ago)");
@@ -449,6 +528,38 @@ void SyncJobRegistry::saveJobs() {
     }
 }
 
+// Write to a temp file, fsync and rename over the config, so a crash or a
+// full disk leaves either the old registry or the new one - never half of it
+bool SyncJobRegistry::writeConfigAtomically(const std::string& content) {
+    std::error_code ec_dir;
+    fs::path config_dir = fs::path(config_path_).parent_path();
+    if (!fs::exists(config_dir, ec_dir)) {
+        fs::create_directories(config_dir, ec_dir);
+    }
+    
+    std::string tmp_path = config_path_ + ".tmp";
+    int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        Logger::error("[SyncJobRegistry] Failed to save jobs to " + config_path_ + ": " + std::strerror(errno));
+        return false;
+    }
+    size_t written = 0;
+    while (written < content.size()) {
+        ssize_t n = write(fd, content.data() + written, content.size() - written);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        written += static_cast<size_t>(n);
+    }
+    bool ok = written == content.size() && fsync(fd) == 0;
+    close(fd);
+    if (!ok || rename(tmp_path.c_str(), config_path_.c_str()) != 0) {
+        Logger::error("[SyncJobRegistry] Failed to save jobs to " + config_path_ + ": " + std::strerror(errno));
+        unlink(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
 std::string SyncJobRegistry::createJob(const std::string& local_path,
                                         const std::string& remote_path,
                                         const std::string& sync_type) {
@@ -476,6 +587,7 @@ std::string SyncJobRegistry::createJob(const std::string& local_path,
     job.last_sync_time = 0;
     job.last_sync_status = "pending";
     
+    std::lock_guard<std::recursive_mutex> lock(write_mutex_);
     jobs_.push_back(job);
     saveJobs();
     
@@ -484,6 +596,7 @@ std::string SyncJobRegistry::createJob(const std::string& local_path,
 }
 
 void SyncJobRegistry::updateJob(const SyncJobMetadata& job) {
+    std::lock_guard<std::recursive_mutex> lock(write_mutex_);
     for (auto& existing : jobs_) {
         if (existing.job_id == job.job_id) {
             existing = job;
@@ -509,14 +622,18 @@ void SyncJobRegistry::deleteJob(const std::string& job_id) {
         }
     }
     
-    jobs_.erase(
-        std::remove_if(jobs_.begin(), jobs_.end(),
-            [&job_id](const SyncJobMetadata& job) {
-                return job.job_id == job_id;
-            }),
-        jobs_.end()
-    );
-    saveJobs();
+    {
+        std::lock_guard<std::recursive_mutex> lock(write_mutex_);
+        jobs_.erase(
+            std::remove_if(jobs_.begin(), jobs_.end(),
+                [&job_id](const SyncJobMetadata& job) {
+                    return job.job_id == job_id;
+                }),
+            jobs_.end()
+        );
+        saveJobs();
+    }
+    proton::LocalStateStore::getInstance().forget_job(job_id);
     Logger::info("[SyncJobRegistry] Deleted job " + job_id);
 }
 
@@ -530,52 +647,28 @@ SyncJobMetadata* SyncJobRegistry::getJob(const std::string& job_id) {
 }
 
 std::optional<SyncJobMetadata> SyncJobRegistry::getJobById(const std::string& job_id) const {
-    for (const auto& job : jobs_) {
-        if (job.job_id == job_id) {
-            return job;
-        }
-    }
+    auto current = snapshot();
+    if (const SyncJobMetadata* job = current->findById(job_id)) return *job;
     return std::nullopt;
 }
 
 std::vector<SyncJobMetadata> SyncJobRegistry::getAllJobs() const {
-    return jobs_;
+    return snapshot()->jobs;
 }
 
 std::optional<SyncJobMetadata> SyncJobRegistry::findJobByLocalPath(const std::string& local_path) const {
-    fs::path check_path = fs::path(local_path).lexically_normal();
-    
-    for (const auto& job : jobs_) {
-        fs::path job_path = fs::path(job.local_path).lexically_normal();
-        if (check_path == job_path) {
-            return job;
-        }
-    }
+    auto current = snapshot();
+    if (const SyncJobMetadata* job = current->findByLocalPath(local_path)) return *job;
     return std::nullopt;
 }
 
 bool SyncJobRegistry::isPathNestedWithSyncedFolder(const std::string& local_path, 
                                                     std::string& conflicting_path) const {
-    fs::path check_path = fs::path(local_path).lexically_normal();
-    
-    for (const auto& job : jobs_) {
-        fs::path job_path = fs::path(job.local_path).lexically_normal();
-        
-        // Check if check_path is inside job_path (syncing a subfolder of existing sync)
-        auto rel = check_path.lexically_relative(job_path);
-        if (!rel.empty() && rel.native()[0] != '.') {
-            conflicting_path = job.local_path;
-            return true;
-        }
-        
-        // Check if job_path is inside check_path (syncing a parent of existing sync)
-        rel = job_path.lexically_relative(check_path);
-        if (!rel.empty() && rel.native()[0] != '.') {
-            conflicting_path = job.local_path;
-            return true;
-        }
-    }
-    return false;
+    auto current = snapshot();
+    const SyncJobMetadata* job = current->findNestedLocalPath(local_path);
+    if (!job) return false;
+    conflicting_path = job->local_path;
+    return true;
 }
 
 bool SyncJobRegistry::cloudPathsConflict(const std::string& path1, const std::string& path2) const {
@@ -604,7 +697,8 @@ SyncJobRegistry::ConflictInfo SyncJobRegistry::checkForConflicts(
     // Normalize local path for comparison
     fs::path normalized_local = fs::path(local_path).lexically_normal();
     
-    for (const auto& job : jobs_) {
+    auto current = snapshot();
+    for (const auto& job : current->jobs) {
         fs::path job_local = fs::path(job.local_path).lexically_normal();
         
         // Check for EXACT DUPLICATE: same local path AND same remote path on THIS device
@@ -1015,6 +1109,7 @@ SyncJobRegistry::LocalConflictInfo SyncJobRegistry::checkLocalPathConflicts(cons
     return info;
 }
 void SyncJobRegistry::enableSharedSync(const std::string& job_id) {
+    std::lock_guard<std::recursive_mutex> lock(write_mutex_);
     SyncJobMetadata* job = getJob(job_id);
     if (job) {
         job->sync_mode = "shared";
@@ -1024,6 +1119,7 @@ void SyncJobRegistry::enableSharedSync(const std::string& job_id) {
 }
 
 void SyncJobRegistry::joinSharedSync(const std::string& job_id) {
+    std::lock_guard<std::recursive_mutex> lock(write_mutex_);
     SyncJobMetadata* job = getJob(job_id);
     if (job && job->sync_mode == "shared") {
         DeviceInfo this_device;
@@ -1037,6 +1133,7 @@ void SyncJobRegistry::joinSharedSync(const std::string& job_id) {
 }
 
 void SyncJobRegistry::leaveSharedSync(const std::string& job_id) {
+    std::lock_guard<std::recursive_mutex> lock(write_mutex_);
     SyncJobMetadata* job = getJob(job_id);
     if (job) {
         std::string this_device_id = DeviceIdentity::getInstance().getDeviceId();
@@ -1047,20 +1144,33 @@ void SyncJobRegistry::leaveSharedSync(const std::string& job_id) {
 }
 
 void SyncJobRegistry::recordSyncStart(const std::string& job_id) {
+    std::lock_guard<std::recursive_mutex> lock(write_mutex_);
     SyncJobMetadata* job = getJob(job_id);
     if (job) {
         job->last_sync_device_id = DeviceIdentity::getInstance().getDeviceId();
         job->last_sync_status = "running";
-        saveJobs();
+        commit(false);
     }
 }
 
 void SyncJobRegistry::recordSyncComplete(const std::string& job_id, bool success) {
+    std::lock_guard<std::recursive_mutex> lock(write_mutex_);
     SyncJobMetadata* job = getJob(job_id);
     if (job) {
         job->last_sync_time = std::time(nullptr);
         job->last_sync_status = success ? "success" : "failed";
-        saveJobs();
+        commit(false);
+    }
+}
+
+void SyncJobRegistry::recordConcurrency(const std::string& job_id, int transfers, int checkers) {
+    std::lock_guard<std::recursive_mutex> lock(write_mutex_);
+    SyncJobMetadata* job = getJob(job_id);
+    if (job && (job->learned_transfers != transfers || job->learned_checkers != checkers)) {
+        job->learned_transfers = transfers;
+        job->learned_checkers = checkers;
+        // Tuned to this machine's link; not worth a cloud config upload
+        commit(false);
     }
 }
 
@@ -1094,96 +1204,214 @@ static std::string exec_cmd(const char* cmd) {
     return result;
 }
 
-bool SyncJobRegistry::checkCloudFolderExists(const std::string& remote_path) {
-    // Use rclone lsjson to check if folder exists
-    // remote_path format: "proton:/FolderName"
-    std::string cmd = "rclone lsjson --dirs-only " + meta_shell_escape(remote_path) + " 2>/dev/null";
-    std::string output = exec_cmd(cmd.c_str());
-    
-    // If the folder exists, lsjson returns valid JSON (even empty [])
-    // If it doesn't exist or there's an error, it returns an error
-    if (output.empty() || output.find("error") != std::string::npos) {
-        // Check if the path itself is a valid directory
-        cmd = "rclone lsd " + meta_shell_escape(remote_path) + " 2>/dev/null";
-        output = exec_cmd(cmd.c_str());
-        return !output.empty() && output.find("Failed") == std::string::npos;
-    }
-    
-    return true;
+// Cached cloud folder state, shared by the static cloud folder functions
+namespace {
+
+const char* const CLOUD_META_FILE = ".proton-sync-meta.json";
+
+struct CloudFolderEntry {
+    SyncJobRegistry::CloudFolderState state;
+    std::string meta_mod_time;  // ModTime of the metadata file `state.meta` was read from
+    std::chrono::steady_clock::time_point fetched_at;
+};
+
+std::mutex cloud_folder_mutex;
+std::unordered_map<std::string, CloudFolderEntry> cloud_folder_cache;
+
+// "proton:/A/" -> "proton:/A"; the root keeps its slash
+std::string cloud_folder_key(const std::string& remote_path) {
+    std::string key = remote_path;
+    while (key.size() > 1 && key.back() == '/' && key[key.size() - 2] != ':') key.pop_back();
+    return key;
 }
 
-SyncJobRegistry::CloudFolderMeta SyncJobRegistry::getCloudFolderMetadata(const std::string& remote_path) {
-    CloudFolderMeta meta;
-    meta.is_valid = false;
-    
-    // Check for .proton-sync-meta.json in the cloud folder
-    std::string meta_path = remote_path;
-    if (!meta_path.empty() && meta_path.back() != '/') {
-        meta_path += "/";
+std::string cloud_parent(const std::string& folder) {
+    size_t slash = folder.rfind('/');
+    if (slash == std::string::npos) return folder;
+    size_t colon = folder.find(':');
+    if (colon != std::string::npos && slash == colon + 1) return folder.substr(0, slash + 1);
+    return folder.substr(0, slash);
+}
+
+// Escape rclone filter glob characters in a literal name
+std::string glob_escape(const std::string& name) {
+    std::string out;
+    for (char c : name) {
+        if (std::strchr("*?[]{}\\", c)) out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+SyncJobRegistry::CloudFolderMeta parse_cloud_folder_meta(const std::string& content) {
+    SyncJobRegistry::CloudFolderMeta meta;
+    auto extract = [&content](const char* key) -> std::string {
+        size_t pos = content.find(std::string("\"") + key + "\"");
+        if (pos == std::string::npos) return "";
+        size_t start = content.find(": \"", pos);
+        if (start == std::string::npos) return "";
+        start += 3;
+        size_t end = content.find('"', start);
+        return end == std::string::npos ? "" : content.substr(start, end - start);
+    };
+    meta.device_id = extract("device_id");
+    meta.device_name = extract("device_name");
+    meta.folder_name = extract("folder_name");
+    meta.created_at = extract("created_at");
+    meta.is_valid = !meta.device_id.empty();
+    return meta;
+}
+
+// Read a metadata file, through the RC daemon when it is up
+std::string read_cloud_file(const std::string& path, int64_t size) {
+    std::string content;
+    if (size > 0 && size < 64 * 1024 &&
+        proton::RcloneRC::getInstance().read_range(path, 0, static_cast<uint64_t>(size),
+            [&content](const char* data, size_t len) { content.append(data, len); return true; }, 30)) {
+        return content;
+    }
+    content.clear();
+    std::string cmd = AppWindowHelpers::get_rclone_path() + " cat " + meta_shell_escape(path) + " 2>/dev/null";
+    return exec_cmd(cmd.c_str());
+}
+
+} // namespace
+
+std::map<std::string, SyncJobRegistry::CloudFolderState> SyncJobRegistry::getCloudFolderStates(
+    const std::vector<std::string>& remote_paths) {
+    std::map<std::string, CloudFolderState> result;
+    auto now = std::chrono::steady_clock::now();
+    auto ttl = std::chrono::seconds(CLOUD_META_TTL_SECONDS);
+    
+    // Cache first; whatever is left is grouped under its parent folder
+    std::map<std::string, std::vector<std::string>> by_parent;  // parent -> folder keys
+    std::unordered_map<std::string, CloudFolderEntry> previous;
+    {
+        std::lock_guard<std::mutex> lock(cloud_folder_mutex);
+        for (const auto& path : remote_paths) {
+            std::string key = cloud_folder_key(path);
+            auto it = cloud_folder_cache.find(key);
+            if (it != cloud_folder_cache.end() && now - it->second.fetched_at < ttl) {
+                result[path] = it->second.state;
+                continue;
+            }
+            if (it != cloud_folder_cache.end()) previous[key] = it->second;
+            auto& siblings = by_parent[cloud_parent(key)];
+            if (std::find(siblings.begin(), siblings.end(), key) == siblings.end()) siblings.push_back(key);
+        }
     }
-    meta_path += ".proton-sync-meta.json";
-    
-    // Try to read the metadata file using rclone cat
-    std::string cmd = "rclone cat " + meta_shell_escape(meta_path) + " 2>/dev/null";
-    std::string content = exec_cmd(cmd.c_str());
+    if (by_parent.empty()) return result;
     
-    if (content.empty()) {
-        Logger::info("[SyncJobRegistry] No metadata file found at " + meta_path);
-        return meta;
-    }
+    // Metadata files found per folder: ModTime and size
+    struct MetaFile { std::string mod_time; int64_t size = 0; };
+    std::unordered_map<std::string, CloudFolderState> fetched;
+    std::unordered_map<std::string, MetaFile> meta_files;
     
-    // Parse simple JSON
-    try {
-        // Extract device_id
-        size_t pos = content.find("\"device_id\"");
-        if (pos != std::string::npos) {
-            size_t start = content.find(": \"", pos) + 3;
-            size_t end = content.find("\"", start);
-            if (start < end) {
-                meta.device_id = content.substr(start, end - start);
+    auto& index = FileIndex::getInstance();
+    for (auto& [parent, folders] : by_parent) {
+        // Indexed folders are answered from the index (kept current by the cloud monitor)
+        std::vector<std::string> unindexed;
+        for (const auto& folder : folders) {
+            if (folder == parent) {
+                fetched[folder].exists = true;  // The remote root
+                continue;
             }
-        }
-        
-        // Extract device_name
-        pos = content.find("\"device_name\"");
-        if (pos != std::string::npos) {
-            size_t start = content.find(": \"", pos) + 3;
-            size_t end = content.find("\"", start);
-            if (start < end) {
-                meta.device_name = content.substr(start, end - start);
+            if (!index.path_exists(folder)) {
+                unindexed.push_back(folder);
+                continue;
             }
-        }
-        
-        // Extract folder_name
-        pos = content.find("\"folder_name\"");
-        if (pos != std::string::npos) {
-            size_t start = content.find(": \"", pos) + 3;
-            size_t end = content.find("\"", start);
-            if (start < end) {
-                meta.folder_name = content.substr(start, end - start);
+            CloudFolderState& state = fetched[folder];
+            state.exists = true;
+            for (const auto& child : index.get_directory_contents(folder)) {
+                if (!child.is_directory && child.name == CLOUD_META_FILE) {
+                    state.has_meta_file = true;
+                    meta_files[folder] = {child.mod_time, child.size};
+                }
             }
         }
+        if (unindexed.empty()) continue;
         
-        // Extract created_at
-        pos = content.find("\"created_at\"");
-        if (pos != std::string::npos) {
-            size_t start = content.find(": \"", pos) + 3;
-            size_t end = content.find("\"", start);
-            if (start < end) {
-                meta.created_at = content.substr(start, end - start);
+        // One listing of the parent, filtered down to the folders asked about
+        // and their metadata files
+        std::string flags = "--recursive --max-depth 2";
+        std::string prefix = parent.back() == '/' ? parent : parent + "/";
+        for (const auto& folder : unindexed) {
+            std::string name = "/" + glob_escape(folder.substr(prefix.size()));
+            flags += " --include " + meta_shell_escape(name + "/");
+            flags += " --include " + meta_shell_escape(name + "/" + CLOUD_META_FILE);
+            fetched[folder];  // Missing unless the listing shows it
+        }
+        std::string json;
+        FileIndex::fetch_lsjson(flags, parent, 30, json);
+        for (const auto& item : LsjsonParser::parse(json, prefix)) {
+            if (item.is_directory) {
+                auto it = fetched.find(item.path);
+                if (it != fetched.end()) it->second.exists = true;
+            } else if (item.name == CLOUD_META_FILE) {
+                auto it = fetched.find(item.parent_path);
+                if (it == fetched.end()) continue;
+                it->second.exists = true;
+                it->second.has_meta_file = true;
+                meta_files[item.parent_path] = {item.mod_time, item.size};
             }
         }
-        
-        if (!meta.device_id.empty()) {
-            meta.is_valid = true;
-            Logger::info("[SyncJobRegistry] Found cloud folder metadata from device: " + 
-                        meta.device_name + " (" + meta.device_id + ")");
+        Logger::debug("[SyncJobRegistry] Listed " + std::to_string(unindexed.size()) + " cloud folder(s) under " + parent);
+    }
+    
+    // Metadata content is read again only when its ModTime moved
+    for (auto& [folder, state] : fetched) {
+        if (!state.has_meta_file) continue;
+        const MetaFile& file = meta_files[folder];
+        auto prev = previous.find(folder);
+        if (prev != previous.end() && prev->second.state.has_meta_file && !file.mod_time.empty() &&
+            prev->second.meta_mod_time == file.mod_time) {
+            state.meta = prev->second.state.meta;
+            continue;
+        }
+        std::string content = read_cloud_file(folder + "/" + CLOUD_META_FILE, file.size);
+        state.meta = parse_cloud_folder_meta(content);
+        if (state.meta.is_valid) {
+            Logger::info("[SyncJobRegistry] Found cloud folder metadata from device: " +
+                        state.meta.device_name + " (" + state.meta.device_id + ")");
         }
-    } catch (...) {
-        Logger::error("[SyncJobRegistry] Failed to parse cloud folder metadata");
     }
     
-    return meta;
+    std::lock_guard<std::mutex> lock(cloud_folder_mutex);
+    for (auto& [folder, state] : fetched) {
+        CloudFolderEntry& entry = cloud_folder_cache[folder];
+        entry.state = state;
+        entry.meta_mod_time = state.has_meta_file ? meta_files[folder].mod_time : "";
+        entry.fetched_at = now;
+    }
+    for (const auto& path : remote_paths) {
+        auto it = fetched.find(cloud_folder_key(path));
+        if (it != fetched.end()) result[path] = it->second;
+    }
+    return result;
+}
+
+void SyncJobRegistry::invalidateCloudFolderCache(const std::string& remote_path) {
+    std::lock_guard<std::mutex> lock(cloud_folder_mutex);
+    if (remote_path.empty()) {
+        cloud_folder_cache.clear();
+    } else {
+        cloud_folder_cache.erase(cloud_folder_key(remote_path));
+    }
+}
+
+bool SyncJobRegistry::checkCloudFolderExists(const std::string& remote_path) {
+    // remote_path format: "proton:/FolderName"
+    return getCloudFolderStates({remote_path})[remote_path].exists;
+}
+
+SyncJobRegistry::CloudFolderMeta SyncJobRegistry::getCloudFolderMetadata(const std::string& remote_path) {
+    CloudFolderState state = getCloudFolderStates({remote_path})[remote_path];
+    if (!state.has_meta_file) {
+        Logger::info("[SyncJobRegistry] No metadata file found in " + remote_path);
+    } else if (!state.meta.is_valid) {
+        Logger::error("[SyncJobRegistry] Failed to parse cloud folder metadata in " + remote_path);
+    }
+    return state.meta;
 }
 
 bool SyncJobRegistry::writeCloudFolderMetadata(const std::string& remote_path, const CloudFolderMeta& meta) {
@@ -1218,24 +1446,79 @@ bool SyncJobRegistry::writeCloudFolderMetadata(const std::string& remote_path, c
     }
     dest_path += ".proton-sync-meta.json";
     
-    // First, try to delete any existing metadata file (Proton Drive doesn't allow overwriting)
-    std::string delete_cmd = "rclone deletefile " + meta_shell_escape(dest_path) + " 2>/dev/null";
-    [[maybe_unused]] int del_result = system(delete_cmd.c_str());
+    auto& rc = proton::RcloneRC::getInstance();
+    std::string rc_output;
+    int rc_exit = 0;
+    
+    // The conflict check that precedes this has usually just looked; a
+    // folder known to have no metadata file needs no delete
+    bool may_have_meta = true;
+    {
+        std::lock_guard<std::mutex> lock(cloud_folder_mutex);
+        auto it = cloud_folder_cache.find(cloud_folder_key(remote_path));
+        if (it != cloud_folder_cache.end() &&
+            std::chrono::steady_clock::now() - it->second.fetched_at < std::chrono::seconds(CLOUD_META_TTL_SECONDS)) {
+            may_have_meta = it->second.state.has_meta_file;
+        }
+    }
     
-    // Small delay to let Proton Drive process the delete
-    usleep(500000);  // 500ms
+    if (may_have_meta) {
+        // First, try to delete any existing metadata file (Proton Drive doesn't allow overwriting)
+        if (!rc.run("deletefile " + meta_shell_escape(dest_path), 30, rc_output, rc_exit)) {
+            std::string delete_cmd = "rclone deletefile " + meta_shell_escape(dest_path) + " 2>/dev/null";
+            [[maybe_unused]] int del_result = system(delete_cmd.c_str());
+        }
+        
+        // Small delay to let Proton Drive process the delete
+        usleep(500000);  // 500ms
+    }
     
-    std::string cmd = "rclone copyto " + meta_shell_escape(temp_path) + " " + meta_shell_escape(dest_path) + " 2>&1";
-    std::string output = exec_cmd(cmd.c_str());
+    std::string output;
+    std::string copy_args = "copyto " + meta_shell_escape(temp_path) + " " + meta_shell_escape(dest_path);
+    if (rc.run(copy_args, 60, rc_output, rc_exit)) {
+        output = rc_exit == 0 ? "" : "Failed: " + rc_output;
+    } else {
+        std::string cmd = "rclone " + copy_args + " 2>&1";
+        output = exec_cmd(cmd.c_str());
+    }
     
     // Clean up temp file
+    std::error_code size_ec;
+    auto meta_size = fs::file_size(temp_path, size_ec);
     fs::remove(temp_path);
     
     if (output.find("Failed") != std::string::npos || output.find("error") != std::string::npos) {
         Logger::error("[SyncJobRegistry] Failed to upload metadata: " + output);
+        invalidateCloudFolderCache(remote_path);
         return false;
     }
     
+    // What we wrote is what the next check would find; the index learns
+    // about the file too, so later checks need no listing
+    CloudFolderState state;
+    state.exists = true;
+    state.has_meta_file = true;
+    state.meta = meta;
+    state.meta.created_at = time_buf;
+    state.meta.is_valid = !meta.device_id.empty();
+    std::string mod_time(time_buf, 19);
+    {
+        std::lock_guard<std::mutex> lock(cloud_folder_mutex);
+        CloudFolderEntry& entry = cloud_folder_cache[cloud_folder_key(remote_path)];
+        entry.state = state;
+        entry.meta_mod_time.clear();  // Unknown until listed; forces one read after the TTL
+        entry.fetched_at = std::chrono::steady_clock::now();
+    }
+    auto& index = FileIndex::getInstance();
+    std::string folder = cloud_folder_key(remote_path);
+    if (index.is_ready()) {
+        if (!index.path_exists(folder)) {
+            index.add_or_update_file(folder, fs::path(folder).filename().string(), 0, mod_time, true);
+        }
+        index.add_or_update_file(dest_path, CLOUD_META_FILE, size_ec ? 0 : static_cast<int64_t>(meta_size),
+                                 mod_time, false);
+    }
+    
     Logger::info("[SyncJobRegistry] Wrote cloud folder metadata to " + dest_path);
     return true;
 }
@@ -1255,14 +1538,16 @@ SyncJobRegistry::ConflictInfo SyncJobRegistry::checkForCloudFolderConflicts(
     if (rclone_path.rfind("proton:", 0) != 0) {
         rclone_path = "proton:" + rclone_path;
     }
-    if (!checkCloudFolderExists(rclone_path)) {
+    // Existence and metadata in one lookup
+    CloudFolderState state = getCloudFolderStates({rclone_path})[rclone_path];
+    if (!state.exists) {
         // No cloud folder exists - no conflict
         info.type = ConflictType::NONE;
         return info;
     }
     
     // Cloud folder exists - check its metadata
-    CloudFolderMeta cloud_meta = getCloudFolderMetadata(rclone_path);
+    const CloudFolderMeta& cloud_meta = state.meta;
     
     std::string this_device_id = DeviceIdentity::getInstance().getDeviceId();
     std::string this_device_name = DeviceIdentity::getInstance().getDeviceName();
@@ -1311,6 +1596,14 @@ SyncJobRegistry::ConflictInfo SyncJobRegistry::checkForCloudFolderConflicts(
 
 // Helper function to execute rclone command for config sync
 static std::string exec_rclone_config_cmd(const std::string& args) {
+    // Reuse the warm, authenticated RC daemon when it can express the command
+    std::string rc_output;
+    int rc_exit = 0;
+    if (proton::RcloneRC::getInstance().run(args, 120, rc_output, rc_exit)) {
+        Logger::debug("[ConfigSync] RC: " + args);
+        return rc_output;
+    }
+    
     // Use the centralized rclone path resolution for consistency
     std::string rclone_path = AppWindowHelpers::get_rclone_path();
     
@@ -1337,6 +1630,28 @@ bool SyncJobRegistry::exportConfigToCloud() {
     std::string device_id_str = device_id.getDeviceId();
     std::string device_name = device_id.getDeviceName();
     
+    // Runs on a worker thread - read the published snapshot, not jobs_
+    std::stringstream jobs_json;
+    auto current = snapshot();
+    const auto& jobs = current->jobs;
+    for (size_t i = 0; i < jobs.size(); i++) {
+        jobs_json << jobs[i].toJson();
+        if (i < jobs.size() - 1) jobs_json << ",";
+        jobs_json << "\n";
+    }
+    
+    // Nothing other devices read has changed since the last upload
+    std::string exported = device_name + "\n" + jobs_json.str();
+    bool dir_ready;
+    {
+        std::lock_guard<std::mutex> lock(cloud_config_mutex_);
+        if (exported == exported_jobs_) {
+            Logger::debug("[ConfigSync] Config unchanged since last export, skipping upload");
+            return true;
+        }
+        dir_ready = cloud_config_dir_ready_;
+    }
+    
     // Create config JSON
     std::stringstream ss;
     ss << "{\n";
@@ -1344,13 +1659,7 @@ bool SyncJobRegistry::exportConfigToCloud() {
     ss << "  \"device_name\": \"" << device_name << "\",\n";
     ss << "  \"last_updated\": " << std::time(nullptr) << ",\n";
     ss << "  \"jobs\": [\n";
-    
-    for (size_t i = 0; i < jobs_.size(); i++) {
-        ss << jobs_[i].toJson();
-        if (i < jobs_.size() - 1) ss << ",";
-        ss << "\n";
-    }
-    
+    ss << jobs_json.str();
     ss << "  ]\n";
     ss << "}\n";
     
@@ -1370,16 +1679,30 @@ bool SyncJobRegistry::exportConfigToCloud() {
     // Upload to cloud
     std::string cloud_path = "proton:/.proton-sync-config/";
     
-    // Ensure the folder exists
-    exec_rclone_config_cmd("mkdir " + meta_shell_escape(cloud_path));
+    // Ensure the folder exists (once per run)
+    if (!dir_ready) {
+        exec_rclone_config_cmd("mkdir " + meta_shell_escape(cloud_path));
+    }
     
     // Upload the config
-    exec_rclone_config_cmd("copyto " + meta_shell_escape(temp_file) + " " + meta_shell_escape(cloud_path + "device_" + device_id_str + ".json"));
+    std::string output = exec_rclone_config_cmd("copyto " + meta_shell_escape(temp_file) + " " + meta_shell_escape(cloud_path + "device_" + device_id_str + ".json"));
     
     // Clean up temp file
     std::error_code ec_rm;
     std::filesystem::remove(temp_file, ec_rm);
     
+    if (output.find("ERROR") != std::string::npos || output.find("Failed") != std::string::npos) {
+        Logger::warn("[ConfigSync] Config upload failed: " + output.substr(0, 200));
+        return false;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(cloud_config_mutex_);
+        cloud_config_dir_ready_ = true;
+        exported_jobs_ = exported;
+        device_configs_at_ = 0;  // Our own entry in the listing changed
+    }
+    
     Logger::info("[ConfigSync] Config exported to cloud successfully");
     return true;
 }
@@ -1391,6 +1714,7 @@ std::vector<SyncJobMetadata> SyncJobRegistry::importConfigFromCloud() {
     
     auto configs = getCloudDeviceConfigs();
     std::string this_device_id = DeviceIdentity::getInstance().getDeviceId();
+    auto current = snapshot();
     
     for (const auto& config : configs) {
         // Skip our own config
@@ -1401,7 +1725,7 @@ std::vector<SyncJobMetadata> SyncJobRegistry::importConfigFromCloud() {
         for (const auto& remote_job : config.jobs) {
             // Check if we already have a job for the same remote path
             bool already_exists = false;
-            for (const auto& local_job : jobs_) {
+            for (const auto& local_job : current->jobs) {
                 if (local_job.remote_path == remote_job.remote_path) {
                     already_exists = true;
                     break;
@@ -1423,6 +1747,16 @@ std::vector<SyncJobMetadata> SyncJobRegistry::importConfigFromCloud() {
 std::vector<SyncJobRegistry::CloudDeviceConfig> SyncJobRegistry::getCloudDeviceConfigs() {
     std::vector<CloudDeviceConfig> configs;
     
+    // Recently fetched: the Devices page is reopened far more often than configs change
+    {
+        std::lock_guard<std::mutex> lock(cloud_config_mutex_);
+        if (device_configs_at_ != 0 && std::time(nullptr) - device_configs_at_ < CLOUD_META_TTL_SECONDS) {
+            Logger::debug("[ConfigSync] Using cloud device configs from " +
+                          std::to_string(std::time(nullptr) - device_configs_at_) + "s ago");
+            return device_configs_;
+        }
+    }
+    
     Logger::info("[ConfigSync] Fetching cloud device configs...");
     
     // List config files from cloud
@@ -1443,6 +1777,16 @@ std::vector<SyncJobRegistry::CloudDeviceConfig> SyncJobRegistry::getCloudDeviceC
         return configs;
     }
     
+    // Same files, sizes and ModTimes as last time: nothing to download
+    {
+        std::lock_guard<std::mutex> lock(cloud_config_mutex_);
+        if (!device_configs_listing_.empty() && output == device_configs_listing_) {
+            device_configs_at_ = std::time(nullptr);
+            Logger::info("[ConfigSync] Cloud configs unchanged (" + std::to_string(device_configs_.size()) + " device(s))");
+            return device_configs_;
+        }
+    }
+    
     // Parse the JSON to find device config files
     const char* home = std::getenv("HOME");
     if (!home) return configs;
@@ -1607,5 +1951,12 @@ std::vector<SyncJobRegistry::CloudDeviceConfig> SyncJobRegistry::getCloudDeviceC
     
     Logger::info("[ConfigSync] Total configs loaded: " + std::to_string(configs.size()));
     
+    {
+        std::lock_guard<std::mutex> lock(cloud_config_mutex_);
+        device_configs_listing_ = output;
+        device_configs_ = configs;
+        device_configs_at_ = std::time(nullptr);
+    }
+    
     return configs;
 }
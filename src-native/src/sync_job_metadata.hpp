@@ -5,6 +5,11 @@
 #include <vector>
 #include <optional>
 #include <ctime>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 /**
  * SyncJobMetadata - Tracks sync job ownership and conflict detection
@@ -53,6 +58,10 @@ struct SyncJobMetadata {
     std::string last_sync_device_id;
     std::string last_sync_status;  // "success", "failed", "conflict"
     
+    // rclone concurrency learned by ConcurrencyController (0 = not yet)
+    int learned_transfers = 0;
+    int learned_checkers = 0;
+    
     // Helpers
     std::string toJson() const;
     static SyncJobMetadata fromJson(const std::string& json);
@@ -66,6 +75,38 @@ struct SyncJobMetadata {
     void removeSharedDevice(const std::string& device_id);
 };
 
+/**
+ * SyncJobSnapshot - Immutable view of every sync job at one point in time
+ *
+ * Readers hold a shared pointer and iterate or look jobs up without copying
+ * them or taking a lock. Each change to the registry publishes a new
+ * snapshot (copy-on-write), so a snapshot held across an update stays valid
+ * and unchanged; compare `version` to tell whether anything changed since.
+ */
+struct SyncJobSnapshot {
+    uint64_t version = 0;
+    std::vector<SyncJobMetadata> jobs;
+    
+    const SyncJobMetadata* findById(const std::string& job_id) const;
+    // Exact match on the normalized local folder
+    const SyncJobMetadata* findByLocalPath(const std::string& local_path) const;
+    // A job whose local folder contains, or lies inside, `local_path`
+    // (but is not the same folder)
+    const SyncJobMetadata* findNestedLocalPath(const std::string& local_path) const;
+    
+    // lexically_normal() without a trailing slash ("/a/b/../c/" -> "/a/c")
+    static std::string normalizeLocalPath(const std::string& path);
+    
+private:
+    friend class SyncJobRegistry;
+    void buildIndexes();
+    
+    std::unordered_map<std::string, size_t> by_id_;
+    std::map<std::string, size_t> by_local_;  // Sorted: a folder's descendants are contiguous
+};
+
+using SyncJobSnapshotPtr = std::shared_ptr<const SyncJobSnapshot>;
+
 /**
  * SyncJobRegistry - Manages all sync jobs with conflict detection
  */
@@ -85,8 +126,12 @@ public:
     void deleteJob(const std::string& job_id);
     SyncJobMetadata* getJob(const std::string& job_id);
     std::optional<SyncJobMetadata> getJobById(const std::string& job_id) const;
+    // Copies every job; prefer snapshot() unless the copy will be modified
     std::vector<SyncJobMetadata> getAllJobs() const;
     
+    // Current jobs, shared rather than copied - cheap enough for polling loops
+    SyncJobSnapshotPtr snapshot() const { return std::atomic_load(&snapshot_); }
+    
     // Conflict detection
     enum class ConflictType {
         NONE,                    // No conflict
@@ -130,6 +175,27 @@ public:
     static CloudFolderMeta getCloudFolderMetadata(const std::string& remote_path);
     static bool writeCloudFolderMetadata(const std::string& remote_path, const CloudFolderMeta& meta);
     
+    // What the checks above need to know about one cloud folder
+    struct CloudFolderState {
+        bool exists = false;
+        bool has_meta_file = false;  // .proton-sync-meta.json present (meta may still be invalid)
+        CloudFolderMeta meta;
+    };
+    
+    /**
+     * Existence and metadata of many "proton:/..." folders, keyed by the
+     * paths as given. Answers come from a cache kept for CLOUD_META_TTL_SECONDS,
+     * then from FileIndex for indexed folders; the rest cost one filtered
+     * listing per parent folder, plus one read per metadata file not seen
+     * before.
+     */
+    static std::map<std::string, CloudFolderState> getCloudFolderStates(const std::vector<std::string>& remote_paths);
+    
+    // Drop cached cloud folder state (everything if remote_path is empty)
+    static void invalidateCloudFolderCache(const std::string& remote_path = "");
+    
+    static constexpr int CLOUD_META_TTL_SECONDS = 60;
+    
     // Automatic cleanup of stale entries (no .conf file)
     void cleanupStaleEntries();
     
@@ -145,6 +211,7 @@ public:
     // Record sync activity
     void recordSyncStart(const std::string& job_id);
     void recordSyncComplete(const std::string& job_id, bool success);
+    void recordConcurrency(const std::string& job_id, int transfers, int checkers);
     
     // Local filesystem safety checks
     struct LocalPathStatus {
@@ -240,11 +307,32 @@ private:
     SyncJobRegistry(const SyncJobRegistry&) = delete;
     SyncJobRegistry& operator=(const SyncJobRegistry&) = delete;
     
+    // Mutable master copy; only touched with write_mutex_ held. Mutators
+    // call each other (loadJobs -> cleanupStaleEntries -> saveJobs), hence
+    // the recursive mutex.
     std::vector<SyncJobMetadata> jobs_;
+    mutable std::recursive_mutex write_mutex_;
+    SyncJobSnapshotPtr snapshot_ = std::make_shared<const SyncJobSnapshot>();
     std::string config_path_;
+    std::string saved_content_;  // Last bytes written to config_path_
+    
+    // Cloud config sync: what was last uploaded, and the last device
+    // configs read back with the listing they came from
+    std::mutex cloud_config_mutex_;
+    bool cloud_config_dir_ready_ = false;
+    std::string exported_jobs_;
+    std::string device_configs_listing_;
+    std::vector<CloudDeviceConfig> device_configs_;
+    std::time_t device_configs_at_ = 0;
     
     // Private helper function
     void migrateOrphanConfFiles();
+    // Replace the published snapshot with a copy of jobs_
+    void publish();
+    // Publish, then persist if the file content changed. Status-only
+    // changes skip the cloud config export.
+    void commit(bool export_to_cloud);
+    bool writeConfigAtomically(const std::string& content);
 };
 
 #endif // SYNC_JOB_METADATA_HPP
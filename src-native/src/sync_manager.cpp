@@ -3,82 +3,67 @@
 #include "logger.hpp"
 #include "file_watcher.hpp"
 #include "file_index.hpp"
-#include "cloud_browser.hpp"
 #include "sync_job_metadata.hpp"
 #include "device_identity.hpp"
 #include "app_window_helpers.hpp"
-#include "gtk_compat.hpp"  // GTK4 compatibility layer
-#include "app_window.hpp"
+#include "bandwidth_monitor.hpp"
+#include "network_monitor.hpp"
+#include "task_pool.hpp"
+#include "remote_snapshot.hpp"
+#include "sync_scheduler.hpp"
+#include "local_state.hpp"
+#include "process_tracker.hpp"
+#include "concurrency_controller.hpp"
+#include "transfer_scheduler.hpp"
 #include <iostream>
 #include <fstream>
 #include <regex>
 #include <array>
+#include <atomic>
+#include <algorithm>
 #include <memory>
 #include <stdexcept>
 #include <cstdio>
 #include <cstring>
 #include <sstream>
 #include <thread>
+#include <csignal>
 #include <chrono>
+#include <ctime>
 #include <cstdlib>
 #include <filesystem>
 #include <set>
 #include <utility>
 #include <vector>
-#include <gdk/gdk.h>
 #include <signal.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 namespace fs = std::filesystem;
 
-// Helper function to check if a widget is safe to update
-// Returns false if widget is null, destroyed, or its window is not visible/mapped
-// This prevents crashes when screen is locked or window is minimized
-// Note: Only used in WebView mode (GTK3), marked unused for NATIVE_UI_MODE builds
-[[maybe_unused]] static bool is_widget_safe_for_update(GtkWidget* widget) {
-    if (!widget) return false;
-    if (!GTK_IS_WIDGET(widget)) return false;
-    
-    // Check if widget is realized (has an associated GDK window)
-    if (!gtk_widget_get_realized(widget)) return false;
-    
-    // Check if widget is mapped (visible on screen)
-    if (!gtk_widget_get_mapped(widget)) return false;
-    
-    // Use compatibility helper for window visibility check
-    return is_window_visible_and_active(widget);
-}
+namespace {
 
-// Structure to safely pass UI updates from background threads
-struct ProgressUpdate {
-    std::string transferred_text;
-    std::string speed_text;
-    std::string status_text;
-    double progress_fraction;
-    std::string progress_text;
-    SyncManager* manager;
-};
+// Frozen PIDs again, where a fatal-signal handler can read them without
+// taking a lock. A process is only frozen once it has a slot here.
+std::array<std::atomic<int>, 16> g_frozen_slots{};
 
-// Helper to execute shell command and get output
-// Note: Only used in WebView mode (GTK3), marked unused for NATIVE_UI_MODE builds
-[[maybe_unused]] static std::string exec_command(const char* cmd) {
-    std::array<char, 128> buffer;
-    std::string result;
-    std::unique_ptr<FILE, decltype(&pclose)> pipe(popen(cmd, "r"), pclose);
-    if (!pipe) {
-        throw std::runtime_error("popen() failed!");
+bool remember_frozen(int pid) {
+    for (auto& slot : g_frozen_slots) {
+        int expected = 0;
+        if (slot.compare_exchange_strong(expected, pid)) return true;
     }
-    while (fgets(buffer.data(), buffer.size(), pipe.get()) != nullptr) {
-        result += buffer.data();
-    }
-    return result;
+    return false;
 }
 
-// Helper to run command without capturing output (system)
-// Note: Only used in WebView mode (GTK3), marked unused for NATIVE_UI_MODE builds
-[[maybe_unused]] static int run_system(const std::string& cmd) {
-    return std::system(cmd.c_str());
+void forget_frozen(int pid) {
+    for (auto& slot : g_frozen_slots) {
+        int expected = pid;
+        slot.compare_exchange_strong(expected, 0);
+    }
 }
 
+} // namespace
+
 std::string SyncManager::get_script_path(const std::string& script_name) {
     try {
         std::filesystem::path exe_path = std::filesystem::read_symlink("/proc/self/exe");
@@ -119,17 +104,30 @@ SyncManager& SyncManager::getInstance() {
 }
 
 // ============================================================================
-// NATIVE UI MODE STUBS
-// In native GTK4 mode, the AppWindow handles all UI. SyncManager provides
-// only core sync logic and utility functions.
+// Engine lifecycle
+// SyncManager has no UI; the GUI (AppWindow) and proton-drive-daemon host
+// it and receive its events through the Observer.
 // ============================================================================
 
-GtkWidget* SyncManager::get_widget() {
-    return nullptr; // No widget in native mode - AppWindow handles UI
+void SyncManager::set_observer(Observer observer) {
+    std::lock_guard<std::mutex> lock(observer_mutex_);
+    observer_ = std::move(observer);
 }
 
-void SyncManager::init() {
-    Logger::info("[SyncManager] Initializing in native UI mode");
+void SyncManager::notify_observer(std::function<void(const Observer&)> fn) {
+    proton::TaskPool::post_to_main([this, fn = std::move(fn)]() {
+        Observer observer;
+        {
+            std::lock_guard<std::mutex> lock(observer_mutex_);
+            observer = observer_;
+        }
+        fn(observer);
+    });
+}
+
+void SyncManager::init(bool run_engine) {
+    run_engine_ = run_engine;
+    Logger::info(std::string("[SyncManager] Initializing") + (run_engine ? "" : " (observing proton-drive-daemon)"));
     std::cout.flush();
     
     // Initialize device identity and sync registry (non-UI)
@@ -139,8 +137,56 @@ void SyncManager::init() {
     
     SyncJobRegistry::getInstance().loadJobs();
     
+    if (run_engine) start_engine();
+    
+    // Start RC stats collection for running sync processes
+    if (!rc_stats_running_.exchange(true)) {
+        try {
+            rc_stats_thread_ = std::thread(&SyncManager::rc_stats_loop, this);
+        } catch (const std::exception& e) {
+            rc_stats_running_ = false;
+            Logger::error("[SyncManager] Failed to start RC stats thread: " + std::string(e.what()));
+        }
+    }
+}
+
+void SyncManager::start_engine() {
+    run_engine_ = true;
+    
+    // A crash or SIGKILL skips shutdown(); resume syncs we may have frozen
+    int resumed = proton::ProcessTracker::getInstance().resume_stopped();
+    if (resumed > 0) {
+        Logger::warn("[SyncManager] Resumed " + std::to_string(resumed) + " stopped rclone process(es)");
+    }
+    
     // Initialize file watcher for real-time sync
     init_file_watcher();
+    
+    // Global bandwidth budget, split across transfers by the RC stats loop
+    auto& settings = proton::SettingsManager::getInstance();
+    auto& bandwidth = proton::BandwidthMonitor::getInstance();
+    bandwidth.set_upload_limit(settings.get_upload_limit());
+    bandwidth.set_download_limit(settings.get_download_limit());
+    bandwidth.set_schedule(settings.get_bw_scheduling_enabled(), settings.get_work_hour_start(),
+                           settings.get_work_hour_end(), settings.get_work_hour_limit());
+    bandwidth.set_metered_limit(settings.get_metered_limit());
+    
+    // Re-split bandwidth as soon as a foreground transfer starts or ends
+    proton::TransferScheduler::getInstance().set_change_callback([this]() {
+        request_stats_refresh();
+    });
+    
+    // Follow connectivity so offline changes are held and replayed on reconnect
+    auto& network = proton::NetworkMonitor::getInstance();
+    network.set_status_callback([this](bool online, bool metered) {
+        on_network_status(online, metered);
+    });
+    network.start();
+    
+    // Periodic runs come from the in-process scheduler while the app is up
+    proton::SyncScheduler::getInstance().start([this](const std::string& job_id) {
+        trigger_job_sync(job_id, "scheduled");
+    });
 }
 
 void SyncManager::shutdown() {
@@ -149,27 +195,40 @@ void SyncManager::shutdown() {
         file_watcher_->stop();
         Logger::info("[SyncManager] File watcher stopped");
     }
+    if (run_engine_) {
+        proton::SyncScheduler::getInstance().stop();
+        proton::NetworkMonitor::getInstance().stop();
+    }
+    if (rc_stats_running_.exchange(false)) {
+        rc_stats_wake_cv_.notify_all();
+        if (rc_stats_thread_.joinable()) rc_stats_thread_.join();
+        Logger::info("[SyncManager] RC stats poller stopped");
+    }
+    // Never leave a sync frozen behind us
+    for (const auto& [pid, since] : frozen_pids_) {
+        proton::ProcessTracker::getInstance().send_signal(pid, SIGCONT);
+        forget_frozen(pid);
+    }
+    frozen_pids_.clear();
 }
 
-void SyncManager::build_ui() {
-    // No-op in native mode
-}
-
-void SyncManager::update_ui_state() {
-    // No-op in native mode - AppWindow handles this
+void SyncManager::resume_frozen_for_crash() noexcept {
+    for (auto& slot : g_frozen_slots) {
+        int pid = slot.exchange(0);
+        if (pid > 0) kill(pid, SIGCONT);
+    }
 }
 
-void SyncManager::load_profiles() {
-    // No-op in native mode - AppWindow handles this
+void SyncManager::sync_job_now(const std::string& job_id, const std::string& reason) {
+    trigger_job_sync(job_id, reason);
 }
 
 void SyncManager::load_jobs() {
-    // No-op in native mode - AppWindow handles this
+    // No-op: the registry is the source of truth and the UI reads it directly
 }
 
 void SyncManager::show_sync_to_local_dialog(const std::string& remote_path) {
     Logger::info("[SyncManager] Sync to local dialog requested for: " + remote_path);
-    // In native mode, this would be handled by AppWindow
     // Use the full path structure to preserve folder hierarchy
     std::string home = std::getenv("HOME") ? std::getenv("HOME") : "/tmp";
     // Preserve the full cloud path under ~/ProtonDrive so scope is clear
@@ -194,145 +253,476 @@ void SyncManager::show_conflict_resolution_dialog(const std::string& local_file,
     (void)local_file; (void)remote_file; (void)conflict_type;
 }
 
-void SyncManager::show_preferences_dialog() {
-    Logger::info("[SyncManager] Preferences dialog requested (handled by AppWindow)");
-}
-
-void SyncManager::refresh_job_statuses() {
-    // No-op in native mode
-}
-
-gboolean SyncManager::on_status_timeout(gpointer data) {
-    (void)data;
-    return G_SOURCE_REMOVE; // Don't repeat in native mode
-}
-
 void SyncManager::append_log(const std::string& text) {
     Logger::info("[Sync] " + text);
-    AppWindow::getInstance().append_log(text);
-}
-
-void SyncManager::read_external_log() {
-    // No-op in native mode
-}
-
-void SyncManager::poll_rc_api_stats() {
-    // No-op in native mode
-}
-
-int SyncManager::find_active_rc_port() {
-    return 0;
-}
-
-void SyncManager::run_setup_flow() {
-    Logger::info("[SyncManager] Setup flow requested");
-}
-
-void SyncManager::run_job_flow(const std::string& edit_id, 
-                               const std::string& edit_local,
-                               const std::string& edit_remote,
-                               const std::string& edit_type) {
-    Logger::info("[SyncManager] Job flow requested");
-    (void)edit_id; (void)edit_local; (void)edit_remote; (void)edit_type;
-}
-
-void SyncManager::update_progress_ui(const std::string& transferred, 
-                                      const std::string& speed, 
-                                      const std::string& file, 
-                                      double fraction) {
-    AppWindow::getInstance().update_sync_progress(file, fraction, speed, transferred);
-}
-
-void SyncManager::load_settings_to_dialog(GtkWidget* dialog) {
-    (void)dialog;
-}
-
-void SyncManager::save_settings_from_dialog(GtkWidget* dialog) {
-    (void)dialog;
-}
-
-void SyncManager::on_start_clicked(GtkWidget* widget, gpointer data) {
-    (void)widget; (void)data;
-}
-
-void SyncManager::on_stop_clicked(GtkWidget* widget, gpointer data) {
-    (void)widget; (void)data;
-}
-
-void SyncManager::on_refresh_clicked(GtkWidget* widget, gpointer data) {
-    (void)widget; (void)data;
-}
-
-void SyncManager::on_add_profile_clicked(GtkWidget* widget, gpointer data) {
-    (void)widget; (void)data;
-}
-
-void SyncManager::on_add_job_clicked(GtkWidget* widget, gpointer data) {
-    (void)widget; (void)data;
-}
-
-void SyncManager::on_remove_job_clicked(GtkWidget* widget, gpointer data) {
-    (void)widget; (void)data;
+    notify_observer([text](const Observer& observer) {
+        if (observer.log) observer.log(text);
+    });
 }
 
-void SyncManager::on_troubleshoot_clicked(GtkWidget* widget, gpointer data) {
-    (void)widget; (void)data;
-}
+// ============================================================================
+// RC API stats collection
+// Replaces the old once-a-second `ps | grep rclone` + `rclone rc core/stats`
+// fork pipeline with ProcessTracker's /proc table and pooled HTTP calls to
+// each job's RC port.
+// ============================================================================
 
-void SyncManager::on_menu_sync_now(GtkWidget* widget, gpointer data) {
-    (void)widget; (void)data;
-}
+namespace {
 
-void SyncManager::on_menu_force_resync(GtkWidget* widget, gpointer data) {
-    (void)widget; (void)data;
+bool rc_json_number(const std::string& body, const char* key, double& out) {
+    std::string needle = std::string("\"") + key + "\":";
+    size_t pos = body.find(needle);
+    if (pos == std::string::npos) return false;
+    pos += needle.size();
+    while (pos < body.size() && (body[pos] == ' ' || body[pos] == '\t')) pos++;
+    size_t end = pos;
+    while (end < body.size() && (std::isdigit(static_cast<unsigned char>(body[end])) ||
+           body[end] == '.' || body[end] == '-' || body[end] == 'e' || body[end] == '+')) end++;
+    if (end == pos) return false;
+    try {
+        out = std::stod(body.substr(pos, end - pos));
+        return true;
+    } catch (...) {
+        return false;
+    }
 }
 
-void SyncManager::on_menu_edit_job(GtkWidget* widget, gpointer data) {
-    (void)widget; (void)data;
+// Milliseconds for an rclone RFC3339 timestamp such as
+// "2024-05-01T10:20:30.123456789+02:00". The zone is ignored: only the
+// difference between two stamps from the same process is used.
+int64_t rc_time_ms(const std::string& stamp) {
+    std::tm tm{};
+    int consumed = 0;
+    if (sscanf(stamp.c_str(), "%d-%d-%dT%d:%d:%d%n", &tm.tm_year, &tm.tm_mon, &tm.tm_mday,
+               &tm.tm_hour, &tm.tm_min, &tm.tm_sec, &consumed) != 6) {
+        return -1;
+    }
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+    int64_t ms = static_cast<int64_t>(timegm(&tm)) * 1000;
+    if (static_cast<size_t>(consumed) < stamp.size() && stamp[consumed] == '.') {
+        int scale = 100;
+        for (size_t i = consumed + 1; i < stamp.size() && scale > 0; ++i, scale /= 10) {
+            if (!std::isdigit(static_cast<unsigned char>(stamp[i]))) break;
+            ms += (stamp[i] - '0') * scale;
+        }
+    }
+    return ms;
 }
 
-void SyncManager::on_menu_edit_profile(GtkWidget* widget, gpointer data) {
-    (void)widget; (void)data;
+// --transfers the process was started with (rclone's default otherwise)
+int initial_transfers(const proton::RcloneProcess& proc) {
+    for (size_t i = 0; i < proc.args.size(); ++i) {
+        const std::string& arg = proc.args[i];
+        std::string value;
+        if (arg.rfind("--transfers=", 0) == 0) value = arg.substr(12);
+        else if (arg == "--transfers" && i + 1 < proc.args.size()) value = proc.args[i + 1];
+        else continue;
+        try { return std::stoi(value); } catch (...) {}
+    }
+    return proton::ConcurrencyController::DEFAULT_TRANSFERS;
 }
 
-void SyncManager::on_menu_remove_profile(GtkWidget* widget, gpointer data) {
-    (void)widget; (void)data;
+std::string rc_json_string(const std::string& obj, const char* key) {
+    std::string needle = std::string("\"") + key + "\":";
+    size_t pos = obj.find(needle);
+    if (pos == std::string::npos) return "";
+    pos = obj.find('"', pos + needle.size());
+    if (pos == std::string::npos) return "";
+    std::string value;
+    for (size_t i = pos + 1; i < obj.size() && obj[i] != '"'; ++i) {
+        if (obj[i] == '\\' && i + 1 < obj.size()) ++i;
+        value += obj[i];
+    }
+    return value;
 }
 
-void SyncManager::on_remove_profile_clicked(GtkWidget* widget, gpointer data) {
-    (void)widget; (void)data;
+// Split the array stored under `key` into its top-level elements
+std::vector<std::string> rc_json_array_items(const std::string& body, const char* key) {
+    std::vector<std::string> items;
+    std::string needle = std::string("\"") + key + "\":";
+    size_t pos = body.find(needle);
+    if (pos == std::string::npos) return items;
+    pos = body.find_first_not_of(" \t\r\n", pos + needle.size());
+    if (pos == std::string::npos || body[pos] != '[') return items;
+    
+    int depth = 0;
+    bool in_string = false;
+    size_t item_start = pos + 1;
+    for (size_t i = pos; i < body.size(); ++i) {
+        char c = body[i];
+        if (in_string) {
+            if (c == '\\') { ++i; continue; }
+            if (c == '"') in_string = false;
+            continue;
+        }
+        if (c == '"') {
+            in_string = true;
+        } else if (c == '[' || c == '{') {
+            depth++;
+        } else if (c == ']' || c == '}') {
+            depth--;
+            if (depth == 0) {
+                std::string item = body.substr(item_start, i - item_start);
+                if (item.find_first_not_of(" \t\r\n") != std::string::npos) items.push_back(item);
+                break;
+            }
+        } else if (c == ',' && depth == 1) {
+            items.push_back(body.substr(item_start, i - item_start));
+            item_start = i + 1;
+        }
+    }
+    return items;
 }
 
-void SyncManager::on_open_drive_clicked(GtkWidget* widget, gpointer data) {
-    (void)widget; (void)data;
+void read_core_stats(const std::string& body, SyncManager::RcJobStats& stats) {
+    stats.has_stats = true;
+    double v = 0;
+    rc_json_number(body, "bytes", stats.bytes);
+    rc_json_number(body, "totalBytes", stats.total_bytes);
+    rc_json_number(body, "speed", stats.speed);
+    if (rc_json_number(body, "eta", v)) stats.eta = v;
+    if (rc_json_number(body, "transfers", v)) stats.transfers = static_cast<int>(v);
+    if (rc_json_number(body, "totalTransfers", v)) stats.total_transfers = static_cast<int>(v);
+    if (rc_json_number(body, "checks", v)) stats.checks = static_cast<int>(v);
+    if (rc_json_number(body, "totalChecks", v)) stats.total_checks = static_cast<int>(v);
+    if (rc_json_number(body, "errors", v)) stats.errors = static_cast<int>(v);
+    stats.last_error = rc_json_string(body, "lastError");
+    for (const auto& item : rc_json_array_items(body, "transferring")) {
+        std::string fname = rc_json_string(item, "name");
+        if (!fname.empty()) stats.transferring_files.push_back(fname);
+    }
 }
 
-void SyncManager::on_settings_clicked(GtkWidget* widget, gpointer data) {
-    (void)widget; (void)data;
-}
+} // namespace
 
-void SyncManager::on_view_toggle_clicked(GtkWidget* widget, gpointer data) {
-    (void)widget; (void)data;
+std::vector<SyncManager::RcJobStats> SyncManager::get_rc_job_stats() const {
+    std::lock_guard<std::mutex> lock(rc_stats_mutex_);
+    return rc_job_stats_;
 }
 
-void SyncManager::on_pause_clicked(GtkWidget* widget, gpointer data) {
-    (void)widget; (void)data;
+void SyncManager::request_stats_refresh() {
+    {
+        std::lock_guard<std::mutex> lock(rc_stats_wake_mutex_);
+        rc_stats_wake_requested_ = true;
+    }
+    rc_stats_wake_cv_.notify_all();
 }
 
-void SyncManager::on_resume_clicked(GtkWidget* widget, gpointer data) {
-    (void)widget; (void)data;
+void SyncManager::poll_rc_api_stats() {
+    auto& tracker = proton::ProcessTracker::getInstance();
+    tracker.refresh();
+    auto processes = tracker.snapshot();
+    auto& bandwidth = proton::BandwidthMonitor::getInstance();
+    
+    std::vector<RcJobStats> snapshot;
+    std::set<std::string> live_addrs;
+    std::set<int> live_pids;
+    
+    // Bandwidth stats are grouped by the sync job whose folder the command names
+    auto jobs = SyncJobRegistry::getInstance().snapshot();
+    auto job_for = [&jobs](const proton::RcloneProcess& proc) {
+        for (const auto& arg : proc.args) {
+            if (arg.empty() || arg[0] != '/') continue;
+            if (const auto* job = jobs->findByLocalPath(arg)) return job->job_id;
+        }
+        return std::string();
+    };
+    
+    // Stats for the five oldest; the bandwidth split below covers them all
+    size_t shown = std::min<size_t>(processes.size(), 5);
+    for (size_t i = 0; i < shown; ++i) {
+        const auto& proc = processes[i];
+        const std::string job_id = job_for(proc);
+        RcJobStats stats;
+        stats.pid = proc.pid;
+        stats.elapsed_seconds = proc.elapsed_seconds;
+        stats.command = proc.command;
+        stats.args = proc.args;
+        stats.rc_addr = proc.rc_addr;
+        live_pids.insert(proc.pid);
+        
+        if (!proc.rc_addr.empty()) {
+            live_addrs.insert(proc.rc_addr);
+            auto& client = rc_clients_[proc.rc_addr];
+            if (!client) {
+                client = std::make_unique<proton::RcClient>();
+                client->set_endpoint(proc.rc_addr);
+            }
+            
+            std::string body;
+            if (client->call("core/stats", "{}", body, 1)) {
+                read_core_stats(body, stats);
+            }
+            
+            std::string done_body;
+            if (stats.has_stats && client->call("core/transferred", "{}", done_body, 1)) {
+                auto& seen = rc_seen_completed_[proc.pid];
+                for (const auto& item : rc_json_array_items(done_body, "transferred")) {
+                    // Entries with "checked":true are comparisons, not transfers
+                    if (item.find("\"checked\":true") != std::string::npos) continue;
+                    std::string fname = rc_json_string(item, "name");
+                    if (fname.empty() || rc_json_string(item, "completed_at").empty()) continue;
+                    std::string key = fname + "@" + rc_json_string(item, "completed_at");
+                    if (!seen.insert(key).second) continue;
+                    bool ok = rc_json_string(item, "error").empty();
+                    stats.completed_files.push_back({fname, ok});
+                    
+                    double size = 0;
+                    int64_t started = rc_time_ms(rc_json_string(item, "started_at"));
+                    int64_t completed = rc_time_ms(rc_json_string(item, "completed_at"));
+                    if (ok && rc_json_number(item, "size", size) && started >= 0 && completed >= started) {
+                        bandwidth.record_file(job_id, static_cast<size_t>(size),
+                                              std::chrono::milliseconds(completed - started));
+                    }
+                }
+            }
+        }
+        
+        // Feed the bandwidth monitor; direction from whether the source is the cloud
+        std::string transfer_id = "rc-job:" + std::to_string(proc.pid);
+        if (!bandwidth.has_transfer(transfer_id)) {
+            size_t src_pos = proc.command.find(" proton:");
+            size_t local_pos = proc.command.find(" /");
+            bool is_upload = local_pos != std::string::npos &&
+                             (src_pos == std::string::npos || local_pos < src_pos);
+            bandwidth.start_transfer(transfer_id, proc.command.substr(0, 80),
+                                     is_upload ? proton::TransferType::UPLOAD : proton::TransferType::DOWNLOAD, 0,
+                                     job_id);
+        }
+        if (stats.has_stats) {
+            bandwidth.update_transferred(transfer_id, static_cast<size_t>(stats.bytes));
+        }
+        
+        // Measure this run's stream count; the next run starts with the
+        // count the controller picks from it (rclone ignores live changes)
+        if (run_engine_ && stats.has_stats && !job_id.empty()) {
+            proton::ConcurrencyController::getInstance().observe(
+                proc.pid, job_id, initial_transfers(proc),
+                bandwidth.get_job_speed(job_id), stats.errors, stats.last_error);
+        }
+        
+        snapshot.push_back(std::move(stats));
+    }
+    
+    poll_rc_daemon_stats(snapshot);
+    
+    bool activity = proton::TransferScheduler::getInstance().foreground_active();
+    for (const auto& stats : snapshot) {
+        if (stats.speed > 0 || !stats.transferring_files.empty()) activity = true;
+    }
+    rc_transfer_activity_ = activity;
+    
+    // Rate limits and freezing belong to the instance running the engine;
+    // an observing GUI leaves them to proton-drive-daemon
+    if (run_engine_) {
+        // Share the global budget evenly between every rclone with an RC
+        // endpoint, plus the app's daemon while it runs ad-hoc transfers.
+        // Rates are only sent when a process's share changes, which also
+        // overrides the --bwlimit a job was started with.
+        // While the user opens or copies something, sync jobs yield: they are
+        // capped to a trickle and the budget goes to everything else.
+        auto& rc_daemon = proton::RcloneRC::getInstance();
+        auto& scheduler = proton::TransferScheduler::getInstance();
+        bool foreground = scheduler.foreground_active();
+        bool daemon_busy = rc_daemon.active_transfers() > 0 || foreground;
+        size_t shares = daemon_busy ? 1 : 0;
+        for (const auto& proc : processes) {
+            if (!proc.rc_addr.empty() && !(foreground && !job_for(proc).empty())) shares++;
+        }
+        std::string job_rate = bandwidth.get_rclone_rate(shares);
+        std::string yield_rate = bandwidth.get_rclone_rate(shares, proton::TransferScheduler::SYNC_YIELD_RATE);
+        std::map<int, std::string> applied;
+        auto apply_rate = [&](int pid, const std::string& rate, auto&& send) {
+            auto prev = rc_applied_bwlimit_.find(pid);
+            if (prev != rc_applied_bwlimit_.end() && prev->second == rate) {
+                applied[pid] = rate;
+                return;
+            }
+            std::string body;
+            if (send("{\"rate\":\"" + rate + "\"}", body)) {
+                Logger::debug("[Bandwidth] rclone " + std::to_string(pid) + " limited to " + rate);
+                applied[pid] = rate;
+            }
+        };
+        for (const auto& proc : processes) {
+            if (proc.rc_addr.empty()) continue;
+            live_addrs.insert(proc.rc_addr);
+            auto& client = rc_clients_[proc.rc_addr];
+            if (!client) {
+                client = std::make_unique<proton::RcClient>();
+                client->set_endpoint(proc.rc_addr);
+            }
+            bool yields = foreground && !job_for(proc).empty();
+            apply_rate(proc.pid, yields ? yield_rate : job_rate, [&](const std::string& params, std::string& body) {
+                return client->call("core/bwlimit", params, body, 1);
+            });
+        }
+        if (rc_daemon.is_ready()) {
+            // An idle daemon is pre-set to the share it will get once a transfer
+            // starts, so the total only overshoots until the next poll
+            std::string daemon_rate = daemon_busy ? job_rate : bandwidth.get_rclone_rate(shares + 1);
+            apply_rate(rc_daemon.daemon_pid(), daemon_rate, [&](const std::string& params, std::string& body) {
+                return rc_daemon.call("core/bwlimit", params, body, 1);
+            });
+        }
+        rc_applied_bwlimit_.swap(applied);
+    
+        // Sync processes without an RC endpoint cannot be rate-limited; they
+        // are frozen while a file is being opened, for MAX_FREEZE at most
+        bool opening = scheduler.active(proton::TransferPriority::UserOpen) > 0;
+        auto now = std::chrono::steady_clock::now();
+        if (opening) {
+            for (const auto& proc : processes) {
+                if (!proc.rc_addr.empty() || job_for(proc).empty()) continue;
+                if (frozen_pids_.count(proc.pid) || freeze_expired_.count(proc.pid)) continue;
+                if (!remember_frozen(proc.pid)) break;
+                if (tracker.send_signal(proc.pid, SIGSTOP)) {
+                    Logger::debug("[SyncManager] Froze rclone " + std::to_string(proc.pid) + " for a file open");
+                    frozen_pids_[proc.pid] = now;
+                } else {
+                    forget_frozen(proc.pid);
+                }
+            }
+        } else {
+            freeze_expired_.clear();
+        }
+        for (auto it = frozen_pids_.begin(); it != frozen_pids_.end();) {
+            bool expired = now - it->second > proton::TransferScheduler::MAX_FREEZE;
+            if (opening && !expired) {
+                ++it;
+                continue;
+            }
+            tracker.send_signal(it->first, SIGCONT);
+            forget_frozen(it->first);
+            if (expired) freeze_expired_.insert(it->first);
+            it = frozen_pids_.erase(it);
+        }
+    }
+    
+    // Retire jobs whose process has exited
+    std::vector<RcJobStats> previous;
+    {
+        std::lock_guard<std::mutex> lock(rc_stats_mutex_);
+        previous.swap(rc_job_stats_);
+        rc_job_stats_ = snapshot;
+    }
+    for (const auto& old : previous) {
+        if (old.rc_daemon || live_pids.count(old.pid)) continue;  // The rcd entry ends in poll_rc_daemon_stats
+        bandwidth.complete_transfer("rc-job:" + std::to_string(old.pid), old.errors == 0,
+                                    old.errors ? std::to_string(old.errors) + " errors" : "");
+        rc_seen_completed_.erase(old.pid);
+        
+        std::string job_id;
+        auto learned = proton::ConcurrencyController::getInstance().finish(old.pid, job_id);
+        if (learned.valid() && !job_id.empty()) {
+            SyncJobRegistry::getInstance().recordConcurrency(job_id, learned.transfers, learned.checkers);
+        }
+        
+        // A clean full run leaves the local tree in sync: record it, so the
+        // next journal is refined against what was just synced
+        bool full_run = std::any_of(old.args.begin(), old.args.end(), [](const std::string& arg) {
+            return arg == "sync" || arg == "bisync";
+        });
+        if (run_engine_ && full_run && old.has_stats && old.errors == 0) {
+            for (const auto& arg : old.args) {
+                if (arg.empty() || arg[0] != '/') continue;
+                const auto* job = jobs->findByLocalPath(arg);
+                if (!job) continue;
+                if (file_watcher_ && file_watcher_->is_watching(job->job_id)) rebuild_local_state(job->job_id);
+                break;
+            }
+        }
+    }
+    for (auto it = rc_clients_.begin(); it != rc_clients_.end();) {
+        if (live_addrs.count(it->first)) ++it;
+        else it = rc_clients_.erase(it);
+    }
 }
 
-void SyncManager::on_stop_sync_clicked(GtkWidget* widget, gpointer data) {
-    (void)widget; (void)data;
+int SyncManager::find_active_rc_port() {
+    std::lock_guard<std::mutex> lock(rc_stats_mutex_);
+    for (const auto& job : rc_job_stats_) {
+        size_t colon = job.rc_addr.rfind(':');
+        if (colon == std::string::npos) continue;
+        try { return std::stoi(job.rc_addr.substr(colon + 1)); } catch (...) {}
+    }
+    return 0;
 }
 
-void SyncManager::check_and_recover_stall(double bytes, double speed, int errors, const std::string& last_error) {
-    (void)bytes; (void)speed; (void)errors; (void)last_error;
+void SyncManager::poll_rc_daemon_stats(std::vector<RcJobStats>& snapshot) {
+    // Opens, copies and uploads from the window run inside the app's rcd,
+    // which is no sync process and so is not in the tracker's table
+    auto& rc_daemon = proton::RcloneRC::getInstance();
+    auto& bandwidth = proton::BandwidthMonitor::getInstance();
+    
+    RcJobStats stats;
+    std::string body;
+    bool answered = rc_daemon.is_ready() && rc_daemon.call("core/stats", "{}", body, 1);
+    if (answered) read_core_stats(body, stats);
+    bool busy = answered && (rc_daemon.active_transfers() > 0 || !stats.transferring_files.empty());
+    
+    // A restarted daemon starts its counters from zero
+    if (rc_daemon_busy_ && (!busy || rc_daemon.daemon_pid() != rc_daemon_pid_)) {
+        bandwidth.complete_transfer("rc-daemon:" + std::to_string(rc_daemon_pid_), true);
+        rc_daemon_busy_ = false;
+    }
+    if (!busy) return;
+    
+    if (!rc_daemon_busy_) {
+        rc_daemon_busy_ = true;
+        rc_daemon_pid_ = rc_daemon.daemon_pid();
+        rc_daemon_base_bytes_ = stats.bytes;
+        rc_daemon_base_errors_ = stats.errors;
+        rc_daemon_busy_since_ = std::chrono::steady_clock::now();
+        bandwidth.start_transfer("rc-daemon:" + std::to_string(rc_daemon_pid_), "App transfers",
+                                 proton::TransferType::DOWNLOAD, 0);
+    }
+    
+    stats.pid = rc_daemon_pid_;
+    stats.rc_daemon = true;
+    stats.command = "rclone rcd";
+    stats.elapsed_seconds = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::steady_clock::now() - rc_daemon_busy_since_).count();
+    stats.bytes = std::max(0.0, stats.bytes - rc_daemon_base_bytes_);
+    stats.errors = std::max(0, stats.errors - rc_daemon_base_errors_);
+    // Totals span the daemon's lifetime; progress is not meaningful here
+    stats.total_bytes = 0;
+    stats.eta = -1;
+    stats.transfers = stats.total_transfers = stats.checks = stats.total_checks = -1;
+    bandwidth.update_transferred("rc-daemon:" + std::to_string(rc_daemon_pid_), static_cast<size_t>(stats.bytes));
+    snapshot.push_back(std::move(stats));
 }
 
-void SyncManager::restart_bisync_with_resync() {
-    Logger::info("[SyncManager] Restart bisync with resync requested");
+void SyncManager::rc_stats_loop() {
+    int interval_ms = 1000;
+    while (rc_stats_running_.load()) {
+        try {
+            poll_rc_api_stats();
+        } catch (const std::exception& e) {
+            Logger::error("[SyncManager] RC stats poll failed: " + std::string(e.what()));
+        }
+        
+        // Data moving: 1s. rclone running but only listing or checking: up
+        // to 5s. Nothing running: up to 10s.
+        bool running;
+        {
+            std::lock_guard<std::mutex> lock(rc_stats_mutex_);
+            running = !rc_job_stats_.empty();
+        }
+        if (rc_transfer_activity_) {
+            interval_ms = 1000;
+        } else {
+            interval_ms = std::min(interval_ms * 2, running ? 5000 : 10000);
+        }
+        
+        std::unique_lock<std::mutex> lock(rc_stats_wake_mutex_);
+        rc_stats_wake_cv_.wait_for(lock, std::chrono::milliseconds(interval_ms), [this] {
+            return rc_stats_wake_requested_ || !rc_stats_running_.load();
+        });
+        if (rc_stats_wake_requested_) interval_ms = 1000;
+        rc_stats_wake_requested_ = false;
+    }
 }
 
 // ============================================================================
@@ -349,8 +739,8 @@ void SyncManager::init_file_watcher() {
     // Set up the callback to trigger sync when files change
     Logger::debug("[FileWatcher Init] Setting sync callback...");
     std::cout.flush();
-    file_watcher_->set_sync_callback([this](const std::string& job_id) {
-        trigger_job_sync(job_id);
+    file_watcher_->set_sync_callback([this](const std::string& job_id, const ChangeJournal& changes) {
+        sync_job_changes(job_id, changes);
     });
     Logger::debug("[FileWatcher Init] Sync callback set");
     std::cout.flush();
@@ -402,13 +792,16 @@ void SyncManager::setup_watches_for_jobs() {
     
     // Use the SyncJobRegistry to get all jobs (more reliable than parsing conf files)
     auto& registry = SyncJobRegistry::getInstance();
-    auto all_jobs = registry.getAllJobs();
+    auto snapshot = registry.snapshot();
     
-    for (const auto& job : all_jobs) {
+    for (const auto& job : snapshot->jobs) {
         // Use safe_exists to prevent crash on I/O errors (corrupted dirs, network issues)
         if (!job.local_path.empty() && AppWindowHelpers::safe_exists(job.local_path)) {
             if (file_watcher_->add_watch(job.job_id, job.local_path)) {
                 Logger::info("[SyncManager] Watching: " + job.local_path + " (job " + job.job_id + ")");
+                if (!proton::LocalStateStore::getInstance().has_state(job.job_id)) {
+                    rebuild_local_state(job.job_id);
+                }
             } else {
                 Logger::warn("[SyncManager] Failed to add watch for: " + job.local_path);
             }
@@ -418,31 +811,33 @@ void SyncManager::setup_watches_for_jobs() {
     }
 }
 
-void SyncManager::trigger_job_sync(const std::string& job_id) {
-    // Use g_idle_add to run on main thread
-    struct SyncData {
-        SyncManager* self;
-        std::string job_id;
-    };
-    
-    SyncData* data = new SyncData{this, job_id};
-    
-    g_idle_add([](gpointer user_data) -> gboolean {
-        SyncData* d = static_cast<SyncData*>(user_data);
+void SyncManager::trigger_job_sync(const std::string& job_id, const std::string& reason) {
+    // Run on the main loop, like the callers that start syncs by hand
+    proton::TaskPool::post_to_main([this, job_id, reason]() {
+        append_log("🔄 Auto-sync triggered for job " + job_id + " (" + reason + ")");
         
-        d->self->append_log("🔄 Auto-sync triggered for job " + d->job_id + " (file change detected)");
+        // Runs the timers fire are skipped while we hold the engine lock;
+        // this marker tells manage-sync-job.sh the run was asked for
+        const char* home = getenv("HOME");
+        std::string marker_dir = std::string(home ? home : "/tmp") + "/.cache/proton-drive/run-requested";
+        std::error_code ec;
+        std::filesystem::create_directories(marker_dir, ec);
+        std::ofstream(marker_dir + "/" + job_id).put('\n');
         
         // Trigger the sync via systemd (result intentionally ignored)
-        std::string cmd = "systemctl --user start proton-drive-job-" + d->job_id + ".service 2>/dev/null &";
+        std::string cmd = "systemctl --user start proton-drive-job-" + job_id + ".service 2>/dev/null &";
         [[maybe_unused]] int result = system(cmd.c_str());
+        request_stats_refresh();
         
-        // Refresh cloud browser to show updated files
-        CloudBrowser::getInstance().refresh();
+        // Let the views show updated files
+        notify_observer([](const Observer& observer) {
+            if (observer.remote_changed) observer.remote_changed();
+        });
         
         // Also update the file index incrementally for this job's folder
         // This runs in a background thread to avoid blocking the UI
-        std::string job_id_copy = d->job_id;
-        std::thread([job_id_copy]() {
+        std::string job_id_copy = job_id;
+        proton::TaskPool::getInstance().submit(proton::TaskLane::Background, [job_id_copy]() {
             // Read the job config to get local and remote paths
             std::string config_path = std::string(getenv("HOME")) + 
                                       "/.config/proton-drive/jobs/" + job_id_copy + ".conf";
@@ -472,9 +867,164 @@ void SyncManager::trigger_job_sync(const std::string& job_id) {
                 auto& index = FileIndex::getInstance();
                 index.update_files_from_sync(job_id_copy, local_path, remote_path);
             }
-        }).detach();
+        });
+    });
+}
+
+void SyncManager::rebuild_local_state(const std::string& job_id) {
+    auto job = SyncJobRegistry::getInstance().getJobById(job_id);
+    if (!job || job->local_path.empty()) return;
+    proton::TaskPool::getInstance().submit(proton::TaskLane::Background, [job_id, local_path = job->local_path]() {
+        proton::LocalStateStore::getInstance().rescan(job_id, local_path);
+    });
+}
+
+bool SyncManager::network_allows_sync() const {
+    auto& network = proton::NetworkMonitor::getInstance();
+    if (!network.is_online()) return false;
+    return !(network.is_metered() && proton::SettingsManager::getInstance().get_pause_sync_on_metered());
+}
+
+void SyncManager::on_network_status(bool online, bool metered) {
+    // Metered links lower the bandwidth budget; rebalance right away
+    request_stats_refresh();
+    
+    if (!online || (metered && proton::SettingsManager::getInstance().get_pause_sync_on_metered())) {
+        return;  // sync_job_changes() defers until the next status change
+    }
+    
+    std::set<std::string> deferred;
+    {
+        std::lock_guard<std::mutex> lock(deferred_sync_mutex_);
+        deferred.swap(deferred_syncs_);
+    }
+    // The journals were dropped while waiting, so each job gets a full run
+    for (const auto& job_id : deferred) {
+        Logger::info("[SyncManager] Network available, running deferred sync for job " + job_id);
+        trigger_job_sync(job_id);
+    }
+}
+
+void SyncManager::sync_job_changes(const std::string& job_id, const ChangeJournal& changes) {
+    if (!network_allows_sync()) {
+        std::lock_guard<std::mutex> lock(deferred_sync_mutex_);
+        if (deferred_syncs_.insert(job_id).second) {
+            Logger::info("[SyncManager] Network unavailable, deferring sync for job " + job_id);
+        }
+        return;
+    }
+    
+    proton::SyncScheduler::getInstance().note_local_change(job_id);
+    
+    if (changes.overflow || (changes.changed.empty() && changes.deleted.empty())) {
+        trigger_job_sync(job_id);
+        // Events were lost, so the recorded local state is rebuilt from a walk
+        if (changes.overflow) rebuild_local_state(job_id);
+        return;
+    }
+    
+    // Upload-only jobs mirror local state, so copying changed paths and
+    // deleting removed ones is equivalent to a full run. Bisync jobs always
+    // take a full run: a blind copy or delete would overwrite or remove a
+    // file changed in the cloud since their last bisync.
+    auto job = SyncJobRegistry::getInstance().getJobById(job_id);
+    if (!job || job->local_path.empty() || job->remote_path.empty() || job->sync_type != "sync") {
+        trigger_job_sync(job_id);
+        return;
+    }
+    
+    // A running job sync (or a previous partial one) already covers these paths
+    if (proton::ProcessTracker::getInstance().is_syncing_path(job->local_path)) {
+        trigger_job_sync(job_id);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(partial_sync_mutex_);
+        if (!partial_syncs_in_flight_.insert(job_id).second) {
+            trigger_job_sync(job_id);
+            return;
+        }
+    }
+    
+    proton::TaskPool::getInstance().submit(proton::TaskLane::Transfer, [this, job_id, changes, local_path = job->local_path, remote_path = job->remote_path]() {
+        const char* home = getenv("HOME");
+        std::string list_dir = std::string(home ? home : "/tmp") + "/.cache/proton-drive";
+        { std::error_code ec; std::filesystem::create_directories(list_dir, ec); }
+        
+        auto write_list = [&](const std::string& kind, const std::vector<std::string>& paths) {
+            std::string list_path = list_dir + "/journal-" + job_id + "-" + kind + ".txt";
+            std::ofstream out(list_path, std::ios::trunc);
+            for (const auto& path : paths) out << path << '\n';
+            return out.good() ? list_path : std::string();
+        };
+        
+        // Drop paths whose recorded state did not move and pair up renames
+        auto& local_state = proton::LocalStateStore::getInstance();
+        auto delta = local_state.diff(job_id, local_path, changes);
+        if (delta.empty()) {
+            Logger::debug("[SyncManager] Journal for job " + job_id + " had no real changes (" +
+                          std::to_string(delta.unchanged) + " unchanged)");
+            std::lock_guard<std::mutex> lock(partial_sync_mutex_);
+            partial_syncs_in_flight_.erase(job_id);
+            return;
+        }
         
-        delete d;
-        return FALSE;
-    }, data);
-}
\ No newline at end of file
+        std::string escaped_local = AppWindowHelpers::shell_escape(local_path);
+        std::string escaped_remote = AppWindowHelpers::shell_escape("proton:" + remote_path);
+        std::string remote_root = "proton:" + remote_path + (remote_path.empty() || remote_path.back() != '/' ? "/" : "");
+        bool ok = true;
+        
+        // Renames are server-side moves instead of delete + re-upload
+        for (const auto& [from, to] : delta.renamed) {
+            if (!ok) break;
+            ok = AppWindowHelpers::run_rclone_with_timeout(
+                "moveto " + AppWindowHelpers::shell_escape(remote_root + from) + " " +
+                AppWindowHelpers::shell_escape(remote_root + to), 300) == 0;
+        }
+        if (ok && !delta.changed.empty()) {
+            std::string list = write_list("changed", delta.changed);
+            ok = !list.empty() && AppWindowHelpers::run_rclone_with_timeout(
+                "copy --files-from-raw " + AppWindowHelpers::shell_escape(list) + " " +
+                escaped_local + " " + escaped_remote, 600) == 0;
+            if (!list.empty()) std::remove(list.c_str());
+        }
+        if (ok && !delta.deleted.empty()) {
+            std::string list = write_list("deleted", delta.deleted);
+            ok = !list.empty() && AppWindowHelpers::run_rclone_with_timeout(
+                "delete --files-from-raw " + AppWindowHelpers::shell_escape(list) + " " +
+                escaped_remote, 600) == 0;
+            if (!list.empty()) std::remove(list.c_str());
+        }
+        
+        {
+            std::lock_guard<std::mutex> lock(partial_sync_mutex_);
+            partial_syncs_in_flight_.erase(job_id);
+        }
+        
+        if (ok) {
+            local_state.commit(job_id, delta);
+            // Our own upload moved the remote past the shared snapshot
+            proton::RemoteSnapshotService::getInstance().invalidate("proton:" + remote_path);
+            FileIndex::getInstance().update_files_from_sync(job_id, local_path, remote_path);
+        }
+        
+        size_t changed = delta.changed.size();
+        size_t deleted = delta.deleted.size();
+        size_t renamed = delta.renamed.size();
+        proton::TaskPool::post_to_main([this, job_id, changed, deleted, renamed, ok]() {
+            if (ok) {
+                append_log("🔄 Auto-sync for job " + job_id + ": " +
+                           std::to_string(changed) + " changed, " +
+                           std::to_string(deleted) + " deleted" +
+                           (renamed ? ", " + std::to_string(renamed) + " renamed" : ""));
+                request_stats_refresh();
+                notify_observer([](const Observer& observer) {
+                    if (observer.remote_changed) observer.remote_changed();
+                });
+            } else {
+                Logger::warn("[SyncManager] Partial sync failed for job " + job_id + ", running full sync");
+                trigger_job_sync(job_id);
+            }
+        });
+    });
+}
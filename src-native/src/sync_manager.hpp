@@ -1,32 +1,65 @@
 #pragma once
 
-#include <gtk/gtk.h>
 #include <string>
 #include <functional>
 #include <vector>
 #include <memory>
+#include <map>
+#include <set>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <condition_variable>
 #include "device_identity.hpp"
 #include "sync_job_metadata.hpp"
+#include "rclone_rc.hpp"
 
 // Forward declaration
 class FileWatcher;
+struct ChangeJournal;
 
+/**
+ * Sync engine: file watcher, scheduler, network gating and the rclone
+ * stats poller. Has no UI of its own - the GUI and the headless daemon
+ * both host it and see its events through an Observer.
+ */
 class SyncManager {
 public:
     static SyncManager& getInstance();
 
-    // Get the main widget (sidebar container)
-    GtkWidget* get_widget();
+    /**
+     * Where engine events surface: the window's log and job list in the
+     * GUI, D-Bus signals in the daemon. Always called on the main loop.
+     */
+    struct Observer {
+        std::function<void(const std::string& line)> log;
+        std::function<void()> jobs_changed;     // A job was registered
+        std::function<void()> remote_changed;   // A sync moved files in the cloud
+    };
+    void set_observer(Observer observer);
+
+    // Load jobs and start the engine. With run_engine false (the GUI while
+    // proton-drive-daemon is running) no watcher, scheduler or network
+    // gating is started and the stats poller only observes: rate limits,
+    // stream tuning and freezing are left to the daemon's instance.
+    void init(bool run_engine = true);
+    bool runs_engine() const { return run_engine_; }
+
+    // Start the watcher, scheduler and network gating in a process that was
+    // observing the daemon (the GUI taking over after the daemon exits)
+    void start_engine();
+
+    // SIGCONT every sync frozen for a file open. Async-signal-safe, for the
+    // fatal-signal handlers.
+    static void resume_frozen_for_crash() noexcept;
 
-    // Initialize (build) the UI
-    void init();
-    
     // Shutdown - stop file watcher and cleanup
     void shutdown();
-    
-    // Set callback for view toggle (called by webview)
-    static void set_view_toggle_callback(std::function<void()> callback);
-    
+
+    // Start a full run of one job now (same path as scheduled runs)
+    void sync_job_now(const std::string& job_id, const std::string& reason = "requested");
+
     // Sync from cloud to local - public so CloudBrowser can call it
     void show_sync_to_local_dialog(const std::string& remote_path);
     
@@ -45,38 +78,46 @@ public:
     
     // Script path helper (public for async callbacks)
     static std::string get_script_path(const std::string& script_name);
+    
+    /**
+     * Live stats for one running rclone sync/copy/bisync process, as
+     * collected from its RC endpoint (core/stats + core/transferred).
+     */
+    struct RcJobStats {
+        int pid = 0;
+        long elapsed_seconds = 0;
+        std::string command;        // Space-joined argv
+        std::vector<std::string> args;
+        std::string rc_addr;        // Empty if the process has no --rc-addr
+        bool rc_daemon = false;     // The app's own rclone rcd (opens, copies, uploads)
+        bool has_stats = false;     // RC endpoint answered this round
+        double bytes = 0;
+        double total_bytes = 0;
+        double speed = 0;
+        double eta = -1;
+        int transfers = -1;         // Completed transfers
+        int total_transfers = -1;
+        int checks = -1;
+        int total_checks = -1;
+        int errors = 0;
+        std::string last_error;     // core/stats "lastError"
+        std::vector<std::string> transferring_files;
+        std::vector<std::pair<std::string, bool>> completed_files;  // New since last poll (name, ok)
+    };
+    
+    // Latest snapshot of active rclone jobs (cheap; safe from any thread)
+    std::vector<RcJobStats> get_rc_job_stats() const;
+    
+    // Wake the stats poller immediately (e.g. right after starting a sync)
+    void request_stats_refresh();
 
 private:
     SyncManager() = default;
     ~SyncManager() = default;
 
-    // GUI Elements
-    GtkWidget* container_ = nullptr;      // Main VBox
-    GtkWidget* status_label_ = nullptr;
-    GtkWidget* start_btn_ = nullptr;
-    GtkWidget* stop_btn_ = nullptr;
-    
-    // Dashboard Elements
-    GtkWidget* dashboard_frame_ = nullptr;
-    GtkWidget* lbl_transferred_ = nullptr;
-    GtkWidget* lbl_speed_ = nullptr;
-    GtkWidget* lbl_current_file_ = nullptr;
-    GtkWidget* progress_bar_ = nullptr;
-    GtkWidget* pause_btn_ = nullptr;
-    GtkWidget* resume_btn_ = nullptr;
-    
-    GtkWidget* log_view_ = nullptr;
-    GtkWidget* profiles_list_ = nullptr;  // ListBox for profiles
-    GtkWidget* jobs_list_ = nullptr;      // ListBox for sync jobs
-    
-    // Helper to build UI
-    void build_ui();
-    
-    // Updates UI state based on service status
-    void update_ui_state();
-    
-    // Load Rclone profiles into the list
-    void load_profiles();
+    std::mutex observer_mutex_;
+    Observer observer_;
+    bool run_engine_ = true;
     
     // Device & Conflict Management
     void show_device_info();
@@ -95,101 +136,67 @@ private:
                                     const std::string& sync_type);
                                            
     void enable_shared_sync_for_job(const std::string& job_id);
-
-    // Callbacks
-    static void on_start_clicked(GtkWidget* widget, gpointer data);
-    static void on_stop_clicked(GtkWidget* widget, gpointer data);
-    static void on_refresh_clicked(GtkWidget* widget, gpointer data);
-    static void on_add_profile_clicked(GtkWidget* widget, gpointer data);
-    static void on_add_job_clicked(GtkWidget* widget, gpointer data);
-    static void on_remove_job_clicked(GtkWidget* widget, gpointer data);
-    static void on_troubleshoot_clicked(GtkWidget* widget, gpointer data);
-    // GTK4 gesture handlers
-    static void on_job_gesture_pressed(GtkGestureClick* gesture, int n_press, double x, double y, gpointer data);
-    static void on_profile_gesture_pressed(GtkGestureClick* gesture, int n_press, double x, double y, gpointer data);
-    static void on_menu_sync_now(GtkWidget* widget, gpointer data);
-    static void on_menu_force_resync(GtkWidget* widget, gpointer data);
-    static void on_menu_edit_job(GtkWidget* widget, gpointer data);
-
-    static void on_menu_edit_profile(GtkWidget* widget, gpointer data);
-    static void on_menu_remove_profile(GtkWidget* widget, gpointer data);
-
-    static void on_remove_profile_clicked(GtkWidget* widget, gpointer data);
-    static void on_open_drive_clicked(GtkWidget* widget, gpointer data);
-    static void on_settings_clicked(GtkWidget* widget, gpointer data);
-    static void on_view_toggle_clicked(GtkWidget* widget, gpointer data);
-    
-    // Preferences dialog
-    void show_preferences_dialog();
-    
-    // Pause/Resume/Stop callbacks
-    static void on_pause_clicked(GtkWidget* widget, gpointer data);
-    static void on_resume_clicked(GtkWidget* widget, gpointer data);
-    static void on_stop_sync_clicked(GtkWidget* widget, gpointer data);
-    
-    // Pause/resume state
-    bool is_paused_ = false;
-    std::vector<int> paused_pids_;  // PIDs paused via SIGSTOP
-    
-    // Stall detection state
-    double last_bytes_transferred_ = 0;
-    int stall_count_ = 0;  // Consecutive polls with no progress
-    int error_count_ = 0;  // Error count from last poll
-    static constexpr int STALL_THRESHOLD = 120;  // 2 minutes of no progress
-    static constexpr int ERROR_THRESHOLD = 10;   // Restart after 10 errors
-    void check_and_recover_stall(double bytes, double speed, int errors, const std::string& last_error);
-    void restart_bisync_with_resync();
     
     // Helpers
     void append_log(const std::string& text);
-    
-    // Status updates
-    void refresh_job_statuses();
-    static gboolean on_status_timeout(gpointer data);
-
-    
-    // Log reading
-    long log_file_pos_ = 0;
-    void read_external_log();
+    // Run an observer callback on the main loop, if one is set
+    void notify_observer(std::function<void(const Observer&)> fn);
     
     // RC API polling for live stats
     void poll_rc_api_stats();
     int find_active_rc_port();
-    
-    void run_setup_flow();
-    void run_job_flow(const std::string& edit_id = "", 
-                      const std::string& edit_local = "",
-                      const std::string& edit_remote = "",
-                      const std::string& edit_type = "");
-                      
-    void update_progress_ui(const std::string& transferred, 
-                            const std::string& speed, 
-                            const std::string& file, 
-                            double fraction);
+    void rc_stats_loop();
+    
+    std::thread rc_stats_thread_;
+    std::atomic<bool> rc_stats_running_{false};
+    std::mutex rc_stats_wake_mutex_;
+    std::condition_variable rc_stats_wake_cv_;
+    bool rc_stats_wake_requested_ = false;
+    mutable std::mutex rc_stats_mutex_;
+    std::vector<RcJobStats> rc_job_stats_;
+    // Only touched by the poller thread
+    std::map<std::string, std::unique_ptr<proton::RcClient>> rc_clients_;
+    std::map<int, std::set<std::string>> rc_seen_completed_;
+    // Adds an entry for the app's rcd while it has transfers running
+    void poll_rc_daemon_stats(std::vector<RcJobStats>& snapshot);
+    // The RC daemon's core/stats counters are cumulative; a busy stretch is
+    // reported relative to where they stood when it began
+    bool rc_daemon_busy_ = false;
+    int rc_daemon_pid_ = 0;
+    double rc_daemon_base_bytes_ = 0;
+    int rc_daemon_base_errors_ = 0;
+    std::chrono::steady_clock::time_point rc_daemon_busy_since_;
+    // Set by each poll: something is moving data or the user is waiting on a transfer
+    std::atomic<bool> rc_transfer_activity_{false};
+    // Last core/bwlimit rate sent to each process (rclone jobs and the RC daemon)
+    std::map<int, std::string> rc_applied_bwlimit_;
+    // Non-RC sync processes SIGSTOPped for a foreground open, and those that
+    // hit MAX_FREEZE and stay running until the opens are over
+    std::map<int, std::chrono::steady_clock::time_point> frozen_pids_;
+    std::set<int> freeze_expired_;
     
     // New features
     void show_selective_sync_dialog(const std::string& remote_path);
     void show_conflict_resolution_dialog(const std::string& local_file, 
                                          const std::string& remote_file,
                                          const std::string& conflict_type);
-    void show_version_history_dialog(const std::string& file_path);
-    void load_settings_to_dialog(GtkWidget* dialog);
-    void save_settings_from_dialog(GtkWidget* dialog);
-    
-    // Conflict tracking
-    struct ConflictInfo {
-        std::string local_path;
-        std::string remote_path;
-        std::string local_time;
-        std::string remote_time;
-        std::string local_size;
-        std::string remote_size;
-    };
-    std::vector<ConflictInfo> pending_conflicts_;
     
     // File watcher for real-time sync
     std::unique_ptr<FileWatcher> file_watcher_;
     void init_file_watcher();
     void setup_watches_for_jobs();
-    void trigger_job_sync(const std::string& job_id);
+    void trigger_job_sync(const std::string& job_id, const std::string& reason = "file change detected");
+    // Transfer only the journaled paths; falls back to trigger_job_sync()
+    void sync_job_changes(const std::string& job_id, const ChangeJournal& changes);
+    std::mutex partial_sync_mutex_;
+    std::set<std::string> partial_syncs_in_flight_;
+    // Walk a job's tree on the background lane to (re)build its LocalStateStore baseline
+    void rebuild_local_state(const std::string& job_id);
+    
+    // Network gating: changes seen while offline (or on a metered link with
+    // pause_sync_on_metered) are deferred and synced as soon as that ends
+    bool network_allows_sync() const;
+    void on_network_status(bool online, bool metered);
+    std::mutex deferred_sync_mutex_;
+    std::set<std::string> deferred_syncs_;
 };
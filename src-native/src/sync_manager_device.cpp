@@ -1,11 +1,10 @@
 // Device Identity & Conflict Management Methods
 #include "sync_manager.hpp"
-#include "app_window.hpp"
 #include "device_identity.hpp"
 #include "sync_job_metadata.hpp"
 #include "logger.hpp"
-#include "cloud_browser.hpp"
-#include <gtk/gtk.h>
+#include "file_index.hpp"
+#include "notifications.hpp"
 #include <string>
 #include <cstring>
 #include <ctime>
@@ -19,8 +18,7 @@
 #include <sys/stat.h>
 #include <algorithm>
 
-// In native UI mode, these dialogs are replaced by the new AppWindow UI
-// Provide stub implementations that log and skip the old GTK3 dialogs
+// These dialogs are replaced by the AppWindow UI; the stubs only log
 
 void SyncManager::show_device_info() {
     Logger::info("[SyncManager] Device info dialog requested (handled by AppWindow)");
@@ -146,6 +144,19 @@ void SyncManager::execute_sync_to_local_async(const std::string& remote_path,
     struct stat buffer;
     bool first_run = (stat(state_file.c_str(), &buffer) != 0);
     
+    // A first run downloads the whole folder; the index already knows its
+    // size, so refuse up front instead of filling the disk halfway through
+    proton::PathTree::Summary summary;
+    if (first_run && FileIndex::getInstance().get_folder_summary("proton:" + remote_path, summary) && summary.bytes > 0) {
+        auto status = SyncJobRegistry::checkLocalPath(local_path, summary.bytes);
+        if (!status.has_sufficient_space) {
+            Logger::error("[SyncManager] Not starting sync of " + remote_path + ": " + status.error_message);
+            proton::NotificationManager::getInstance().notify("Sync Not Started", status.error_message,
+                                                              proton::NotificationType::ERROR);
+            return;
+        }
+    }
+    
     // Use a user-specific log file (not /tmp to avoid symlink attacks)
     std::string log_dir;
     if (home) {
@@ -169,21 +180,30 @@ void SyncManager::execute_sync_to_local_async(const std::string& remote_path,
     
     Logger::info("[SyncManager] Using RC port " + std::to_string(rc_port) + " for this sync");
     
+    // Start from the stream count learned on earlier runs of this job
+    std::string concurrency;
+    auto registry_jobs = SyncJobRegistry::getInstance().snapshot();
+    const SyncJobMetadata* learned = registry_jobs->findByLocalPath(local_path);
+    if (learned && learned->learned_transfers > 0) {
+        concurrency = " --transfers " + std::to_string(learned->learned_transfers) +
+                      " --checkers " + std::to_string(learned->learned_checkers);
+    }
+    
     if (sync_type == "bisync") {
         if (first_run) {
             Logger::info("[SyncManager] First bisync run: yes - will use copy instead to avoid --resync issues");
             cmd = escaped_rclone + " copy " + escaped_remote + " " + escaped_local +
-                  " --verbose --rc " + rc_addr + " --log-file " + sm_shell_escape(log_dir + "/rclone-copy.log") + " &";
+                  " --verbose --rc " + rc_addr + concurrency + " --log-file " + sm_shell_escape(log_dir + "/rclone-copy.log") + " &";
             Logger::info("[SyncManager] Starting copy (first run)");
         } else {
             Logger::info("[SyncManager] First bisync run: no - will use full bisync");
             cmd = escaped_rclone + " bisync " + escaped_remote + " " + escaped_local +
-                  " --verbose --rc " + rc_addr + " --log-file " + sm_shell_escape(log_dir + "/rclone-bisync.log") + " &";
+                  " --verbose --rc " + rc_addr + concurrency + " --log-file " + sm_shell_escape(log_dir + "/rclone-bisync.log") + " &";
             Logger::info("[SyncManager] Starting bisync");
         }
     } else if (sync_type == "copy") {
         cmd = escaped_rclone + " copy " + escaped_remote + " " + escaped_local +
-              " --verbose --rc " + rc_addr + " --log-file " + sm_shell_escape(log_dir + "/rclone-copy.log") + " &";
+              " --verbose --rc " + rc_addr + concurrency + " --log-file " + sm_shell_escape(log_dir + "/rclone-copy.log") + " &";
         Logger::info("[SyncManager] Starting copy");
     } else {
         Logger::error("[SyncManager] Unknown sync type: " + sync_type);
@@ -197,6 +217,7 @@ void SyncManager::execute_sync_to_local_async(const std::string& remote_path,
     Logger::debug("[SyncManager] Sync type: " + sync_type);
     int result = std::system(cmd.c_str());
     Logger::info("[SyncManager] Command execution returned: " + std::to_string(result));
+    request_stats_refresh();
     
     // Notify user that sync has started
     Logger::info("[SyncManager] Sync started: " + remote_path + " → " + local_path);
@@ -209,7 +230,8 @@ void SyncManager::execute_sync_to_local_async(const std::string& remote_path,
         // Check if a job already exists for this remote path
         bool already_registered = false;
         std::string existing_job_id;
-        for (const auto& existing : registry.getAllJobs()) {
+        auto jobs = registry.snapshot();
+        for (const auto& existing : jobs->jobs) {
             if (existing.remote_path == remote_path && existing.local_path == local_path) {
                 already_registered = true;
                 existing_job_id = existing.job_id;
@@ -237,11 +259,10 @@ void SyncManager::execute_sync_to_local_async(const std::string& remote_path,
                 Logger::info("[SyncManager] Created .conf file for job: " + job_id);
             }
 
-            // Refresh the sync jobs UI on the main thread
-            g_idle_add([](gpointer) -> gboolean {
-                AppWindow::getInstance().refresh_sync_jobs();
-                return G_SOURCE_REMOVE;
-            }, nullptr);
+            // Refresh the sync jobs list on the main thread
+            notify_observer([](const Observer& observer) {
+                if (observer.jobs_changed) observer.jobs_changed();
+            });
         }
     }
 }
@@ -0,0 +1,319 @@
+// sync_scheduler.cpp - In-process scheduler for periodic sync job runs
+
+#include "sync_scheduler.hpp"
+#include "sync_job_metadata.hpp"
+#include "network_monitor.hpp"
+#include "settings.hpp"
+#include "logger.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <system_error>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace proton {
+
+namespace {
+
+constexpr int MANUAL_ONLY_MINUTES = 9999;  // "Manual only" in the interval dropdown
+
+std::string read_sysfs(const fs::path& path) {
+    std::ifstream in(path);
+    std::string value;
+    std::getline(in, value);
+    return value;
+}
+
+} // namespace
+
+SyncScheduler& SyncScheduler::getInstance() {
+    static SyncScheduler instance;
+    return instance;
+}
+
+SyncScheduler::~SyncScheduler() {
+    stop();
+}
+
+void SyncScheduler::set_systemd_timers(bool running) {
+    const char* cmd = running
+        ? "for timer in ~/.config/systemd/user/proton-drive-job-*.timer; do "
+          "[ -f \"$timer\" ] && systemctl --user start \"$(basename \"$timer\")\" 2>/dev/null; done"
+        : "systemctl --user stop 'proton-drive-job-*.timer' 2>/dev/null";
+    [[maybe_unused]] int result = std::system(cmd);
+}
+
+void SyncScheduler::start(RunCallback callback) {
+    // A Stop from a previous session is remembered in settings, not read
+    // back from the state the timers were left in. The timers otherwise
+    // stay on while we run: job runs they fire step aside while the engine
+    // lock is held (manage-sync-job.sh), and carry on if this process dies.
+    bool paused = SettingsManager::getInstance().get_sync_paused();
+    set_systemd_timers(!paused);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (running_) return;
+        callback_ = std::move(callback);
+        paused_ = paused;
+
+        refresh_jobs();
+        running_ = true;
+        try {
+            thread_ = std::thread(&SyncScheduler::scheduler_loop, this);
+        } catch (const std::system_error& e) {
+            running_ = false;
+            Logger::error("[Scheduler] Failed to start scheduler thread: " + std::string(e.what()));
+        }
+        if (running_) {
+            Logger::info("[Scheduler] Started for " + std::to_string(jobs_.size()) + " job(s)" +
+                         (paused_ ? " (paused)" : ""));
+        }
+    }
+}
+
+void SyncScheduler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) return;
+        running_ = false;
+    }
+    wake_cv_.notify_all();
+    if (thread_.joinable()) thread_.join();
+
+    // The timers were left on; with the engine lock released they run jobs again
+    Logger::info("[Scheduler] Stopped");
+}
+
+void SyncScheduler::pause() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        paused_ = true;
+    }
+    save_paused(true);
+    set_systemd_timers(false);
+    Logger::info("[Scheduler] Periodic sync paused");
+}
+
+void SyncScheduler::resume() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        paused_ = false;
+    }
+    save_paused(false);
+    set_systemd_timers(true);
+    Logger::info("[Scheduler] Periodic sync resumed");
+    wake_cv_.notify_all();
+}
+
+void SyncScheduler::save_paused(bool paused) {
+    auto& settings = SettingsManager::getInstance();
+    if (settings.get_sync_paused() == paused) return;
+    settings.set_sync_paused(paused);
+    settings.save();
+}
+
+bool SyncScheduler::is_active() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return running_ && !paused_ && !jobs_.empty();
+}
+
+size_t SyncScheduler::job_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return jobs_.size();
+}
+
+void SyncScheduler::note_local_change(const std::string& job_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = jobs_.find(job_id);
+    if (it != jobs_.end()) it->second.activity++;
+}
+
+void SyncScheduler::note_remote_change(const std::string& job_id) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = jobs_.find(job_id);
+        if (it == jobs_.end()) return;
+        it->second.activity++;
+        // Local edits are pushed by the file watcher; remote ones wait for a run
+        auto soon = Clock::now() + min_interval();
+        if (it->second.next_run > soon) {
+            it->second.next_run = soon;
+            Logger::debug("[Scheduler] Remote change in job " + job_id + ", next run moved forward");
+        }
+    }
+    wake_cv_.notify_all();
+}
+
+void SyncScheduler::reschedule() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        manual_only_ = SettingsManager::getInstance().get_sync_interval_minutes() >= MANUAL_ONLY_MINUTES;
+        auto base = base_interval();
+        auto now = Clock::now();
+        for (auto& [job_id, state] : jobs_) {
+            state.interval = base;
+            state.next_run = now + first_run_offset(job_id, base);
+        }
+    }
+    wake_cv_.notify_all();
+}
+
+std::chrono::seconds SyncScheduler::base_interval() const {
+    int minutes = SettingsManager::getInstance().get_sync_interval_minutes();
+    return std::chrono::minutes(std::max(1, minutes));
+}
+
+std::chrono::seconds SyncScheduler::min_interval() const {
+    return std::max<std::chrono::seconds>(base_interval() / 4, std::chrono::minutes(2));
+}
+
+std::chrono::seconds SyncScheduler::max_interval() const {
+    return std::min<std::chrono::seconds>(base_interval() * 4, std::chrono::hours(6));
+}
+
+std::chrono::seconds SyncScheduler::jittered(std::chrono::seconds interval) {
+    // +/-10% so jobs that happen to align drift apart again
+    jitter_state_ = jitter_state_ * 1103515245u + 12345u;
+    long spread = std::max<long>(1, static_cast<long>(interval.count()) / 5);
+    long offset = static_cast<long>((jitter_state_ >> 8) % static_cast<unsigned>(spread)) - spread / 2;
+    return interval + std::chrono::seconds(offset);
+}
+
+std::chrono::seconds SyncScheduler::first_run_offset(const std::string& job_id, std::chrono::seconds interval) {
+    auto offset = std::hash<std::string>{}(job_id) % static_cast<size_t>(std::max<long>(1, interval.count()));
+    return std::chrono::seconds(static_cast<long>(offset));
+}
+
+void SyncScheduler::refresh_jobs() {
+    manual_only_ = SettingsManager::getInstance().get_sync_interval_minutes() >= MANUAL_ONLY_MINUTES;
+    auto snapshot = SyncJobRegistry::getInstance().snapshot();
+    const auto& jobs = snapshot->jobs;
+    auto base = base_interval();
+    auto now = Clock::now();
+
+    std::set<std::string> live;
+    for (const auto& job : jobs) {
+        live.insert(job.job_id);
+        if (jobs_.count(job.job_id)) continue;
+
+        JobState state;
+        state.interval = base;
+        state.next_run = now + first_run_offset(job.job_id, base);
+        jobs_[job.job_id] = state;
+    }
+    for (auto it = jobs_.begin(); it != jobs_.end();) {
+        it = live.count(it->first) ? std::next(it) : jobs_.erase(it);
+    }
+}
+
+bool SyncScheduler::conditions_allow(std::string& reason) const {
+    auto& settings = SettingsManager::getInstance();
+    auto& network = NetworkMonitor::getInstance();
+    if (!network.is_online()) {
+        reason = "offline";
+        return false;
+    }
+    if (network.is_metered() && settings.get_pause_sync_on_metered()) {
+        reason = "metered connection";
+        return false;
+    }
+    if (settings.get_pause_sync_on_battery() && on_battery_power()) {
+        reason = "on battery";
+        return false;
+    }
+    return true;
+}
+
+bool SyncScheduler::on_battery_power() {
+    bool have_battery = false;
+    bool discharging = false;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator("/sys/class/power_supply", ec)) {
+        std::string type = read_sysfs(entry.path() / "type");
+        if (type == "Mains" || type == "USB") {
+            if (read_sysfs(entry.path() / "online") == "1") return false;
+        } else if (type == "Battery") {
+            have_battery = true;
+            if (read_sysfs(entry.path() / "status") == "Discharging") discharging = true;
+        }
+    }
+    return have_battery && discharging;
+}
+
+void SyncScheduler::scheduler_loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    jitter_state_ = static_cast<unsigned>(Clock::now().time_since_epoch().count());
+
+    while (running_) {
+        refresh_jobs();
+
+        auto now = Clock::now();
+        auto wake_at = now + std::chrono::seconds(BLOCKED_RETRY_SECONDS);
+        if (paused_ || manual_only_ || jobs_.empty()) {
+            wake_cv_.wait_until(lock, wake_at);
+            continue;
+        }
+
+        // Earliest due job; one start per spacing window
+        auto due = std::min_element(jobs_.begin(), jobs_.end(), [](const auto& a, const auto& b) {
+            return a.second.next_run < b.second.next_run;
+        });
+        auto start_at = std::max(due->second.next_run,
+                                 last_start_ + std::chrono::seconds(START_SPACING_SECONDS));
+        if (start_at > now) {
+            wake_cv_.wait_until(lock, std::min(start_at, wake_at));
+            continue;
+        }
+        std::string job_id = due->first;
+
+        std::string reason;
+        lock.unlock();
+        bool allowed = conditions_allow(reason);
+        lock.lock();
+        if (!running_) break;
+        if (!allowed) {
+            if (reason != blocked_reason_) {
+                Logger::info("[Scheduler] Holding scheduled syncs (" + reason + ")");
+                blocked_reason_ = reason;
+            }
+            wake_cv_.wait_until(lock, wake_at);
+            continue;
+        }
+        blocked_reason_.clear();
+
+        // The job may have been removed while the lock was released
+        auto it = jobs_.find(job_id);
+        if (it == jobs_.end()) continue;
+        JobState& state = it->second;
+
+        // Busy jobs converge on min_interval, idle ones on max_interval
+        if (state.activity > 0) {
+            state.interval = std::max(min_interval(), state.interval / 2);
+        } else {
+            state.interval = std::min(max_interval(), state.interval * 3 / 2);
+        }
+        state.activity = 0;
+        state.next_run = now + jittered(state.interval);
+        last_start_ = now;
+
+        Logger::info("[Scheduler] Running job " + job_id + " (next in " +
+                     std::to_string(state.interval.count() / 60) + " min)");
+        RunCallback callback = callback_;
+        lock.unlock();
+        if (callback) {
+            try {
+                callback(job_id);
+            } catch (const std::exception& e) {
+                Logger::error("[Scheduler] Run callback threw: " + std::string(e.what()));
+            }
+        }
+        lock.lock();
+    }
+}
+
+} // namespace proton
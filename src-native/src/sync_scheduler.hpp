@@ -0,0 +1,102 @@
+// sync_scheduler.hpp - In-process scheduler for periodic sync job runs
+// While the app runs it replaces the fixed-interval proton-drive-job-*.timer
+// units. They stay enabled, but their runs step aside while the engine lock
+// is held, so sync continues on them when the app closes or crashes. Each
+// job's interval adapts to its observed change rate: runs
+// that follow local or remote activity halve it, idle runs stretch it, all
+// within bounds derived from get_sync_interval_minutes. Starts are
+// staggered so several jobs never hit the uplink in the same minute, and
+// nothing starts while offline, on a metered link or on battery when the
+// corresponding pause setting is enabled.
+
+#ifndef SYNC_SCHEDULER_HPP
+#define SYNC_SCHEDULER_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace proton {
+
+class SyncScheduler {
+public:
+    static SyncScheduler& getInstance();
+
+    // Invoked on the scheduler thread when a job is due
+    using RunCallback = std::function<void(const std::string& job_id)>;
+
+    // Take over from the systemd timers, which stay enabled but skip their
+    // runs while the engine lock is held. Starts paused if the user's last
+    // Stop (kept in settings as sync_paused) was never undone.
+    void start(RunCallback callback);
+    void stop();
+
+    // Service Start/Stop buttons; the choice is saved across restarts
+    void pause();
+    void resume();
+    bool is_active() const;
+    size_t job_count() const;
+
+    // Activity hints; remote changes also pull the next run forward
+    void note_local_change(const std::string& job_id);
+    void note_remote_change(const std::string& job_id);
+
+    // Re-read get_sync_interval_minutes and reset every job's interval
+    void reschedule();
+
+    // True if a battery is discharging and no AC adapter is online
+    static bool on_battery_power();
+
+private:
+    SyncScheduler() = default;
+    ~SyncScheduler();
+
+    SyncScheduler(const SyncScheduler&) = delete;
+    SyncScheduler& operator=(const SyncScheduler&) = delete;
+
+    using Clock = std::chrono::steady_clock;
+
+    struct JobState {
+        Clock::time_point next_run;
+        std::chrono::seconds interval{0};
+        int activity = 0;  // Changes noted since the last run
+    };
+
+    void scheduler_loop();
+    void refresh_jobs();  // mutex_ held
+    bool conditions_allow(std::string& reason) const;
+    std::chrono::seconds base_interval() const;
+    std::chrono::seconds min_interval() const;
+    std::chrono::seconds max_interval() const;
+    std::chrono::seconds jittered(std::chrono::seconds interval);
+    // Spreads first runs over one interval by job id instead of all at once
+    static std::chrono::seconds first_run_offset(const std::string& job_id, std::chrono::seconds interval);
+
+    // Fork systemctl; never called with mutex_ held
+    static void set_systemd_timers(bool running);
+    static void save_paused(bool paused);
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_cv_;
+    std::thread thread_;
+    RunCallback callback_;
+    std::map<std::string, JobState> jobs_;
+    Clock::time_point last_start_{};
+    unsigned jitter_state_ = 0;
+    bool running_ = false;
+    bool paused_ = false;
+    bool manual_only_ = false;
+    std::string blocked_reason_;  // Logged once per blocked stretch
+
+    static constexpr int START_SPACING_SECONDS = 90;
+    static constexpr int BLOCKED_RETRY_SECONDS = 60;
+};
+
+} // namespace proton
+
+#endif // SYNC_SCHEDULER_HPP
@@ -0,0 +1,198 @@
+// task_pool.cpp - Shared executor for background work
+
+#include "task_pool.hpp"
+#include "logger.hpp"
+#include "settings.hpp"
+#include <glib.h>
+#include <algorithm>
+#include <chrono>
+#include <system_error>
+#include <thread>
+
+namespace proton {
+
+namespace {
+
+// Main-thread dispatcher: one idle source drains everything posted so far
+std::mutex g_main_mutex;
+std::vector<std::function<void()>> g_main_queue;
+bool g_main_scheduled = false;
+
+gboolean dispatch_main_queue(gpointer) {
+    std::vector<std::function<void()>> batch;
+    {
+        std::lock_guard<std::mutex> lock(g_main_mutex);
+        batch.swap(g_main_queue);
+        g_main_scheduled = false;
+    }
+    for (auto& fn : batch) {
+        try {
+            fn();
+        } catch (const std::exception& e) {
+            Logger::error("[TaskPool] Main-thread callback threw: " + std::string(e.what()));
+        }
+    }
+    return G_SOURCE_REMOVE;
+}
+
+const char* lane_name(int lane) {
+    switch (lane) {
+        case 0: return "interactive";
+        case 1: return "transfer";
+        default: return "background";
+    }
+}
+
+} // namespace
+
+TaskPool& TaskPool::getInstance() {
+    // Never destroyed: detached workers may still be finishing at exit
+    static TaskPool* instance = new TaskPool();
+    return *instance;
+}
+
+TaskPool::TaskPool() {
+    lanes_[static_cast<int>(TaskLane::Interactive)].limit = 4;
+    lanes_[static_cast<int>(TaskLane::Transfer)].limit =
+        std::max(1, SettingsManager::getInstance().get_max_parallel_transfers());
+    lanes_[static_cast<int>(TaskLane::Background)].limit = 2;
+}
+
+CancelToken TaskPool::submit(TaskLane lane, Task work, CancelToken token) {
+    int transfer_limit = 0;
+    if (lane == TaskLane::Transfer) {
+        transfer_limit = std::max(1, SettingsManager::getInstance().get_max_parallel_transfers());
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopping_) {
+        token.cancel();
+        return token;
+    }
+    Lane& target = lanes_[static_cast<int>(lane)];
+    if (transfer_limit > 0) target.limit = transfer_limit;
+    target.queue.push_back(QueuedTask{std::move(work), token});
+    spawn_worker_if_needed();
+    work_cv_.notify_one();
+    return token;
+}
+
+CancelToken TaskPool::submit(TaskLane lane, std::function<void()> work) {
+    return submit(lane, [work = std::move(work)](const CancelToken&) { work(); });
+}
+
+void TaskPool::post_to_main(std::function<void()> fn) {
+    std::lock_guard<std::mutex> lock(g_main_mutex);
+    g_main_queue.push_back(std::move(fn));
+    if (!g_main_scheduled) {
+        g_main_scheduled = true;
+        g_idle_add(dispatch_main_queue, nullptr);
+    }
+}
+
+void TaskPool::set_lane_limit(TaskLane lane, int limit) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    lanes_[static_cast<int>(lane)].limit = std::max(1, limit);
+    spawn_worker_if_needed();
+    work_cv_.notify_all();
+}
+
+size_t TaskPool::queued(TaskLane lane) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lanes_[static_cast<int>(lane)].queue.size();
+}
+
+int TaskPool::running(TaskLane lane) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lanes_[static_cast<int>(lane)].running;
+}
+
+int TaskPool::next_runnable_lane() const {
+    for (int i = 0; i < LANE_COUNT; ++i) {
+        if (!lanes_[i].queue.empty() && lanes_[i].running < lanes_[i].limit) return i;
+    }
+    return -1;
+}
+
+void TaskPool::spawn_worker_if_needed() {
+    if (idle_workers_ > 0 || next_runnable_lane() < 0) return;
+
+    int capacity = 0;
+    for (const auto& lane : lanes_) capacity += lane.limit;
+    if (workers_ >= std::min(capacity, MAX_WORKERS)) return;
+
+    try {
+        std::thread(&TaskPool::worker_loop, this).detach();
+        ++workers_;
+        ++idle_workers_;  // Counted idle until it picks up work
+    } catch (const std::system_error& e) {
+        Logger::error("[TaskPool] Failed to create worker thread: " + std::string(e.what()));
+    }
+}
+
+void TaskPool::worker_loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        int lane = -1;
+        work_cv_.wait(lock, [&] {
+            lane = next_runnable_lane();
+            return stopping_ || lane >= 0;
+        });
+        if (stopping_) break;
+
+        QueuedTask task = std::move(lanes_[lane].queue.front());
+        lanes_[lane].queue.pop_front();
+        if (task.token.cancelled()) continue;
+
+        --idle_workers_;
+        ++lanes_[lane].running;
+        auto token_it = running_tokens_.insert(running_tokens_.end(), task.token);
+        // Another lane may still have work this worker isn't taking
+        spawn_worker_if_needed();
+        lock.unlock();
+
+        try {
+            task.work(task.token);
+        } catch (const std::exception& e) {
+            Logger::error(std::string("[TaskPool] ") + lane_name(lane) + " task threw: " + e.what());
+        } catch (...) {
+            Logger::error(std::string("[TaskPool] ") + lane_name(lane) + " task threw an unknown exception");
+        }
+        task = QueuedTask{};  // Release captures outside the lock
+
+        lock.lock();
+        --lanes_[lane].running;
+        ++idle_workers_;
+        running_tokens_.erase(token_it);
+        idle_cv_.notify_all();
+    }
+    --idle_workers_;
+    --workers_;
+    idle_cv_.notify_all();
+}
+
+void TaskPool::shutdown() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (stopping_) return;
+    stopping_ = true;
+
+    size_t dropped = 0;
+    for (auto& lane : lanes_) {
+        for (auto& task : lane.queue) task.token.cancel();
+        dropped += lane.queue.size();
+        lane.queue.clear();
+    }
+    for (const auto& token : running_tokens_) token.cancel();
+    work_cv_.notify_all();
+
+    bool drained = idle_cv_.wait_for(lock, std::chrono::seconds(2), [this] {
+        for (const auto& lane : lanes_) {
+            if (lane.running > 0) return false;
+        }
+        return true;
+    });
+    Logger::info("[TaskPool] Shut down (" + std::to_string(dropped) + " queued task(s) dropped" +
+                 (drained ? ")" : ", some tasks still running)"));
+}
+
+} // namespace proton
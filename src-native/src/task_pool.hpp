@@ -0,0 +1,104 @@
+// task_pool.hpp - Shared executor for background work
+// Replaces the one-detached-std::thread-per-action pattern. Work is queued
+// on a priority lane and picked up by a bounded set of workers: browsing
+// never waits behind transfers, and transfers never exceed
+// SettingsManager::get_max_parallel_transfers. Results reach GTK through
+// post_to_main(), which funnels everything into one idle dispatcher.
+
+#ifndef TASK_POOL_HPP
+#define TASK_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace proton {
+
+// Highest priority first; each lane has its own concurrency limit
+enum class TaskLane {
+    Interactive = 0,  // Folder listings, mkdir/rename/delete the user is waiting on
+    Transfer = 1,     // User uploads and downloads
+    Background = 2    // Indexing, monitoring, housekeeping
+};
+
+// Copyable cancel flag shared between the submitter and the task
+class CancelToken {
+public:
+    CancelToken() : flag_(std::make_shared<std::atomic<bool>>(false)) {}
+    void cancel() const { flag_->store(true, std::memory_order_relaxed); }
+    bool cancelled() const { return flag_->load(std::memory_order_relaxed); }
+
+private:
+    std::shared_ptr<std::atomic<bool>> flag_;
+};
+
+class TaskPool {
+public:
+    static TaskPool& getInstance();
+
+    using Task = std::function<void(const CancelToken&)>;
+
+    // Queue `work` on `lane`. A task whose token is cancelled before a
+    // worker picks it up is dropped; running tasks should poll the token.
+    CancelToken submit(TaskLane lane, Task work, CancelToken token = CancelToken());
+    CancelToken submit(TaskLane lane, std::function<void()> work);
+
+    // Run `fn` on the GTK main thread. Calls from any thread are batched
+    // into a single g_idle_add source and run in submission order.
+    static void post_to_main(std::function<void()> fn);
+
+    // Override a lane's worker limit (Transfer re-reads the setting on submit)
+    void set_lane_limit(TaskLane lane, int limit);
+
+    size_t queued(TaskLane lane) const;
+    int running(TaskLane lane) const;
+
+    // Drop queued work, cancel running tasks and wait briefly for them
+    void shutdown();
+
+private:
+    TaskPool();
+    ~TaskPool() = default;
+
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    static constexpr int LANE_COUNT = 3;
+
+    struct QueuedTask {
+        Task work;
+        CancelToken token;
+    };
+
+    struct Lane {
+        std::deque<QueuedTask> queue;
+        int running = 0;
+        int limit = 1;
+    };
+
+    void worker_loop();
+    // Index of the highest-priority lane with queued work and a free slot, or -1
+    int next_runnable_lane() const;  // mutex_ held
+    void spawn_worker_if_needed();   // mutex_ held
+
+    mutable std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable idle_cv_;  // shutdown() waits for running == 0
+    Lane lanes_[LANE_COUNT];
+    std::list<CancelToken> running_tokens_;  // Cancelled by shutdown()
+    int workers_ = 0;
+    int idle_workers_ = 0;
+    bool stopping_ = false;
+
+    static constexpr int MAX_WORKERS = 16;
+};
+
+} // namespace proton
+
+#endif // TASK_POOL_HPP
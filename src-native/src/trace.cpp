@@ -0,0 +1,161 @@
+// trace.cpp - Per-thread span buffers and Chrome trace JSON export
+
+#include "trace.hpp"
+#include "logger.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace proton {
+
+std::atomic<bool> Trace::enabled_{false};
+
+namespace {
+
+struct Event {
+    const char* category = nullptr;
+    const char* name = nullptr;
+    int64_t start_us = 0;
+    int64_t duration_us = 0;
+    std::string detail;
+};
+
+// Written by its owning thread only; the mutex is uncontended except
+// while an export or reset walks the buffer
+struct ThreadBuffer {
+    std::mutex mutex;
+    long tid = 0;
+    std::vector<Event> events;
+    size_t next = 0;      // Slot the next event goes to
+    bool wrapped = false;
+};
+
+// Buffers outlive their threads so short-lived workers still export
+std::mutex registry_mutex;
+std::vector<std::shared_ptr<ThreadBuffer>> registry;
+
+const Trace::Clock::time_point trace_epoch = Trace::Clock::now();
+
+ThreadBuffer& local_buffer() {
+    thread_local std::shared_ptr<ThreadBuffer> buffer = [] {
+        auto created = std::make_shared<ThreadBuffer>();
+        created->tid = static_cast<long>(syscall(SYS_gettid));
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        registry.push_back(created);
+        return created;
+    }();
+    return *buffer;
+}
+
+int64_t micros_since_epoch(Trace::Clock::time_point t) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(t - trace_epoch).count();
+}
+
+void append_json_string(std::string& out, const std::string& text) {
+    out += '"';
+    for (unsigned char c : text) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    char escaped[8];
+                    snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    out += escaped;
+                } else {
+                    out += static_cast<char>(c);
+                }
+        }
+    }
+    out += '"';
+}
+
+} // namespace
+
+void Trace::set_enabled(bool on) {
+    if (on && !enabled()) {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        // Buffers only the registry still holds belong to exited threads
+        registry.erase(std::remove_if(registry.begin(), registry.end(),
+                                      [](const auto& buffer) { return buffer.use_count() == 1; }),
+                       registry.end());
+        for (auto& buffer : registry) {
+            std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+            buffer->events.clear();
+            buffer->next = 0;
+            buffer->wrapped = false;
+        }
+    }
+    enabled_.store(on, std::memory_order_relaxed);
+    Logger::info(std::string("[Trace] Tracing ") + (on ? "enabled" : "disabled"));
+}
+
+void Trace::record(const char* category, const char* name,
+                   Clock::time_point start, Clock::time_point end, std::string detail) {
+    ThreadBuffer& buffer = local_buffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    if (buffer.events.size() < EVENTS_PER_THREAD) buffer.events.emplace_back();
+    Event& event = buffer.events[buffer.next];
+    event.category = category;
+    event.name = name;
+    event.start_us = micros_since_epoch(start);
+    event.duration_us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    event.detail = std::move(detail);
+    if (++buffer.next == EVENTS_PER_THREAD) {
+        buffer.next = 0;
+        buffer.wrapped = true;
+    }
+}
+
+bool Trace::export_chrome_json(const std::string& path, size_t* event_count) {
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        buffers = registry;
+    }
+
+    const long pid = static_cast<long>(getpid());
+    std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    size_t count = 0;
+    for (const auto& buffer : buffers) {
+        std::lock_guard<std::mutex> lock(buffer->mutex);
+        size_t size = buffer->events.size();
+        size_t first = buffer->wrapped ? buffer->next : 0;
+        for (size_t n = 0; n < size; n++) {
+            const Event& event = buffer->events[(first + n) % size];
+            if (count++) out += ',';
+            out += "{\"ph\":\"X\",\"cat\":\"";
+            out += event.category;
+            out += "\",\"name\":\"";
+            out += event.name;
+            out += "\",\"pid\":" + std::to_string(pid) + ",\"tid\":" + std::to_string(buffer->tid) +
+                   ",\"ts\":" + std::to_string(event.start_us) + ",\"dur\":" + std::to_string(event.duration_us);
+            if (!event.detail.empty()) {
+                out += ",\"args\":{\"detail\":";
+                append_json_string(out, event.detail);
+                out += '}';
+            }
+            out += '}';
+        }
+    }
+    out += "]}\n";
+
+    std::ofstream file(path, std::ios::trunc);
+    if (!file || !file.write(out.data(), static_cast<std::streamsize>(out.size()))) {
+        Logger::error("[Trace] Failed to write trace to " + path);
+        return false;
+    }
+    if (event_count) *event_count = count;
+    Logger::info("[Trace] Exported " + std::to_string(count) + " events to " + path);
+    return true;
+}
+
+} // namespace proton
@@ -0,0 +1,69 @@
+// trace.hpp - Lightweight span tracing for startup and hot paths
+// TraceSpan times a scope with steady_clock and, while tracing is enabled,
+// appends one event to a ring buffer owned by the calling thread (so
+// recording never contends with other threads). Disabled, a span costs one
+// relaxed atomic load. Everything recorded can be exported as Chrome trace
+// JSON (chrome://tracing, Perfetto), from `--trace=FILE` or the window's
+// hidden Ctrl+Shift+T toggle.
+
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+namespace proton {
+
+class Trace {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+    // Turning tracing on drops anything recorded in an earlier session
+    static void set_enabled(bool on);
+
+    // `category` and `name` must outlive the trace (string literals)
+    static void record(const char* category, const char* name,
+                       Clock::time_point start, Clock::time_point end, std::string detail = "");
+
+    // Write every buffered event as Chrome trace JSON; false on I/O error
+    static bool export_chrome_json(const std::string& path, size_t* event_count = nullptr);
+
+    // Events kept per thread; the oldest are overwritten past this
+    static constexpr size_t EVENTS_PER_THREAD = 16384;
+
+private:
+    static std::atomic<bool> enabled_;
+};
+
+class TraceSpan {
+public:
+    TraceSpan(const char* category, const char* name)
+        : category_(category), name_(name), active_(Trace::enabled()) {
+        if (active_) start_ = Trace::Clock::now();
+    }
+    ~TraceSpan() {
+        if (active_) Trace::record(category_, name_, start_, Trace::Clock::now(), std::move(detail_));
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+    bool active() const { return active_; }
+    // Shown as the event's args.detail; build it only if active()
+    void set_detail(std::string detail) {
+        if (active_) detail_ = std::move(detail);
+    }
+
+private:
+    const char* category_;
+    const char* name_;
+    bool active_;
+    Trace::Clock::time_point start_;
+    std::string detail_;
+};
+
+} // namespace proton
+
+#endif // TRACE_HPP
@@ -0,0 +1,90 @@
+// transfer_scheduler.cpp - Foreground transfer tickets and background yielding
+
+#include "transfer_scheduler.hpp"
+#include "logger.hpp"
+
+namespace proton {
+
+namespace {
+
+const char* priority_name(TransferPriority priority) {
+    switch (priority) {
+        case TransferPriority::UserOpen: return "open";
+        case TransferPriority::UserCopy: return "copy";
+        case TransferPriority::Sync: return "sync";
+        case TransferPriority::Background: return "background";
+    }
+    return "?";
+}
+
+bool is_foreground(TransferPriority priority) {
+    return priority == TransferPriority::UserOpen || priority == TransferPriority::UserCopy;
+}
+
+} // namespace
+
+TransferScheduler& TransferScheduler::getInstance() {
+    static TransferScheduler instance;
+    return instance;
+}
+
+TransferScheduler::Ticket& TransferScheduler::Ticket::operator=(Ticket&& other) noexcept {
+    if (this != &other) {
+        release();
+        priority_ = other.priority_;
+        active_ = other.active_;
+        other.active_ = false;
+    }
+    return *this;
+}
+
+void TransferScheduler::Ticket::release() {
+    if (!active_) return;
+    active_ = false;
+    TransferScheduler::getInstance().end(priority_);
+}
+
+TransferScheduler::Ticket TransferScheduler::begin(TransferPriority priority, const std::string& label) {
+    int before = counts_[static_cast<size_t>(priority)].fetch_add(1);
+    Logger::debug("[TransferScheduler] Begin " + std::string(priority_name(priority)) + ": " + label);
+    if (before == 0 && is_foreground(priority)) notify_change();
+    return Ticket(priority);
+}
+
+void TransferScheduler::end(TransferPriority priority) {
+    int left = counts_[static_cast<size_t>(priority)].fetch_sub(1) - 1;
+    if (left > 0 || !is_foreground(priority)) return;
+    {
+        // Taking the lock orders this with a yielder's predicate check
+        std::lock_guard<std::mutex> lock(mutex_);
+    }
+    idle_cv_.notify_all();
+    notify_change();
+}
+
+void TransferScheduler::yield_to_foreground(std::chrono::milliseconds max_wait, const std::atomic<bool>* stop) {
+    if (!foreground_active()) return;
+    Logger::debug("[TransferScheduler] Background work waiting for foreground transfers");
+    std::unique_lock<std::mutex> lock(mutex_);
+    // Re-check `stop` periodically; nothing signals the cv when it is set
+    auto deadline = std::chrono::steady_clock::now() + max_wait;
+    while (foreground_active() && !(stop && stop->load()) && std::chrono::steady_clock::now() < deadline) {
+        idle_cv_.wait_for(lock, std::chrono::milliseconds(500));
+    }
+}
+
+void TransferScheduler::set_change_callback(std::function<void()> callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    on_change_ = std::move(callback);
+}
+
+void TransferScheduler::notify_change() {
+    std::function<void()> callback;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        callback = on_change_;
+    }
+    if (callback) callback();
+}
+
+} // namespace proton
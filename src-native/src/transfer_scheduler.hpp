@@ -0,0 +1,96 @@
+// transfer_scheduler.hpp - Priority classes for everything that moves data
+// Opening a file from the cloud browser used to compete equally with a
+// running bisync and the indexer. Every transfer now registers a ticket with
+// its priority class; while a user-facing transfer (open or copy) is active,
+// SyncManager squeezes sync jobs down to a trickle through RC core/bwlimit
+// and freezes sync processes it cannot rate-limit (SIGSTOP, bounded in
+// time) during opens, and the indexer waits between listings. Everything is
+// restored as soon as the last foreground ticket ends.
+
+#ifndef TRANSFER_SCHEDULER_HPP
+#define TRANSFER_SCHEDULER_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+
+namespace proton {
+
+// Lower value = more urgent
+enum class TransferPriority {
+    UserOpen = 0,       // A file the user is waiting to open
+    UserCopy = 1,       // Uploads/downloads the user started
+    Sync = 2,           // Scheduled and watcher-triggered sync jobs
+    Background = 3      // Indexing, monitoring
+};
+
+class TransferScheduler {
+public:
+    static TransferScheduler& getInstance();
+
+    // Registration of one running transfer; ends when destroyed
+    class Ticket {
+    public:
+        Ticket() = default;
+        ~Ticket() { release(); }
+        Ticket(Ticket&& other) noexcept : priority_(other.priority_), active_(other.active_) { other.active_ = false; }
+        Ticket& operator=(Ticket&& other) noexcept;
+        Ticket(const Ticket&) = delete;
+        Ticket& operator=(const Ticket&) = delete;
+        void release();
+
+    private:
+        friend class TransferScheduler;
+        explicit Ticket(TransferPriority priority) : priority_(priority), active_(true) {}
+        TransferPriority priority_ = TransferPriority::Background;
+        bool active_ = false;
+    };
+
+    Ticket begin(TransferPriority priority, const std::string& label);
+
+    int active(TransferPriority priority) const {
+        return counts_[static_cast<size_t>(priority)].load(std::memory_order_relaxed);
+    }
+    // An open or user copy is running: lower classes should yield
+    bool foreground_active() const {
+        return active(TransferPriority::UserOpen) > 0 || active(TransferPriority::UserCopy) > 0;
+    }
+
+    // Block a background worker while foreground transfers run, up to
+    // `max_wait` (or until `stop` is set)
+    void yield_to_foreground(std::chrono::milliseconds max_wait = std::chrono::seconds(30),
+                             const std::atomic<bool>* stop = nullptr);
+
+    // Called (on the thread that began/ended a ticket) whenever the set of
+    // foreground transfers changes, so throttling is applied immediately
+    void set_change_callback(std::function<void()> callback);
+
+    // Per-process cap for sync jobs while a foreground transfer runs
+    static constexpr size_t SYNC_YIELD_RATE = 128 * 1024;
+    // Sync processes without an RC endpoint are frozen at most this long.
+    // A crash resumes them from the fatal-signal handler, and a SIGKILL is
+    // covered by the next engine start sending SIGCONT to stopped rclones.
+    static constexpr std::chrono::seconds MAX_FREEZE{120};
+
+private:
+    TransferScheduler() = default;
+    TransferScheduler(const TransferScheduler&) = delete;
+    TransferScheduler& operator=(const TransferScheduler&) = delete;
+
+    void end(TransferPriority priority);
+    void notify_change();
+
+    std::array<std::atomic<int>, 4> counts_{};
+    std::mutex mutex_;
+    std::condition_variable idle_cv_;
+    std::function<void()> on_change_;
+};
+
+} // namespace proton
+
+#endif // TRANSFER_SCHEDULER_HPP
@@ -1,6 +1,9 @@
 #include "trash_manager.hpp"
 #include "settings.hpp"
 #include "logger.hpp"
+#include "file_index.hpp"
+#include "local_scanner.hpp"
+#include "task_pool.hpp"
 #include <fstream>
 #include <sstream>
 #include <filesystem>
@@ -8,6 +11,11 @@
 #include <iomanip>
 #include <algorithm>
 #include <mutex>
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 namespace fs = std::filesystem;
 
@@ -20,21 +28,73 @@ static bool tm_safe_is_directory(const std::string& path) {
     std::error_code ec;
     return fs::is_directory(path, ec);
 }
-static bool tm_safe_is_regular_file(const std::string& path) {
-    std::error_code ec;
-    return fs::is_regular_file(path, ec);
-}
+
 namespace proton {
 
+namespace {
+
+// A delete-heavy log is rewritten once it holds this many records and
+// more than twice as many as there are live items
+constexpr size_t COMPACT_MIN_RECORDS = 256;
+// Unlinks between progress reports and cancellation checks
+constexpr size_t REAP_BATCH = 512;
+
+// Log fields are tab-separated; paths may contain anything but NUL
+std::string escape_field(const std::string& in) {
+    std::string out;
+    out.reserve(in.size());
+    for (char c : in) {
+        switch (c) {
+            case '\\': out += "\\\\"; break;
+            case '\t': out += "\\t"; break;
+            case '\n': out += "\\n"; break;
+            default: out += c;
+        }
+    }
+    return out;
+}
+
+std::vector<std::string> split_record(const std::string& line) {
+    std::vector<std::string> fields(1);
+    for (size_t i = 0; i < line.size(); ++i) {
+        char c = line[i];
+        if (c == '\t') {
+            fields.emplace_back();
+        } else if (c == '\\' && i + 1 < line.size()) {
+            char next = line[++i];
+            fields.back() += next == 't' ? '\t' : next == 'n' ? '\n' : next;
+        } else {
+            fields.back() += c;
+        }
+    }
+    return fields;
+}
+
+bool parse_size(const std::string& text, size_t& out) {
+    try {
+        out = static_cast<size_t>(std::stoull(text));
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+} // namespace
+
 TrashManager::TrashManager() {
     const char* home = std::getenv("HOME");
     if (home) {
         trash_dir_ = std::string(home) + "/.cache/proton-drive/trash";
-        metadata_file_ = trash_dir_ + "/metadata.json";
     } else {
         trash_dir_ = "/tmp/proton-drive-trash";
-        metadata_file_ = trash_dir_ + "/metadata.json";
     }
+    metadata_file_ = trash_dir_ + "/metadata.log";
+    legacy_metadata_file_ = trash_dir_ + "/metadata.json";
+    reap_dir_ = trash_dir_ + "/.reaping";
+}
+
+TrashManager::~TrashManager() {
+    if (log_fd_ >= 0) close(log_fd_);
 }
 
 TrashManager& TrashManager::getInstance() {
@@ -50,13 +110,24 @@ bool TrashManager::initialize() {
             fs::create_directories(trash_dir_, ec_mk);
             Logger::info("[TrashManager] Created trash directory: " + trash_dir_);
         }
+        std::error_code ec_reap;
+        fs::create_directories(reap_dir_, ec_reap);
         
-        // Load metadata (handles its own locking)
         {
             std::lock_guard<std::mutex> lock(mutex_);
             if (!load_metadata()) {
                 Logger::info("[TrashManager] No existing metadata, starting fresh");
             }
+            
+            // Resume deletions a previous run did not finish
+            std::error_code ec;
+            for (const auto& entry : fs::directory_iterator(reap_dir_, ec)) {
+                reap_queue_.emplace_back(entry.path().filename().string(), 0);
+            }
+            if (!reap_queue_.empty()) {
+                Logger::info("[TrashManager] Resuming deletion of " + std::to_string(reap_queue_.size()) + " item(s)");
+                start_reaper_locked();
+            }
         }
         
         // Run cleanup on startup (handles its own locking)
@@ -107,8 +178,10 @@ bool TrashManager::move_to_trash(const std::string& local_path, const std::strin
         std::string trash_name = generate_unique_trash_name(local_path);
         std::string trash_path = trash_dir_ + "/" + trash_name;
         
-        // Calculate size before moving
-        size_t size = calculate_size(local_path);
+        // Folders the index cannot size are measured after the move,
+        // so trashing a large tree returns immediately
+        size_t size = 0;
+        bool size_known = quick_size(local_path, cloud_path, size);
         bool is_dir = tm_safe_is_directory(local_path);
         
         // Move to trash
@@ -124,9 +197,9 @@ bool TrashManager::move_to_trash(const std::string& local_path, const std::strin
         item.is_directory = is_dir;
         
         items_[trash_path] = item;
-        
-        // Save metadata
-        save_metadata();
+        append_record_locked({"A", trash_name, std::to_string(std::chrono::system_clock::to_time_t(item.deleted_at)),
+                              std::to_string(size), is_dir ? "1" : "0", local_path, cloud_path});
+        if (!size_known) measure_size_async(trash_path);
         
         Logger::info("[TrashManager] Moved to trash: " + local_path + " -> " + trash_path);
         return true;
@@ -166,7 +239,8 @@ bool TrashManager::restore(const std::string& trash_path, const std::string& res
         
         // Remove from metadata
         items_.erase(it);
-        save_metadata();
+        append_record_locked({"D", fs::path(trash_path).filename().string()});
+        maybe_compact_locked();
         
         Logger::info("[TrashManager] Restored: " + trash_path + " -> " + target_path);
         return true;
@@ -180,31 +254,17 @@ bool TrashManager::restore(const std::string& trash_path, const std::string& res
 bool TrashManager::delete_permanent(const std::string& trash_path) {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    try {
-        auto it = items_.find(trash_path);
-        if (it == items_.end()) {
-            Logger::error("[TrashManager] Item not found in trash: " + trash_path);
-            return false;
-        }
-        
-        // Permanently delete
-        if (fs::is_directory(trash_path)) {
-            fs::remove_all(trash_path);
-        } else {
-            fs::remove(trash_path);
-        }
-        
-        // Remove from metadata
-        items_.erase(it);
-        save_metadata();
-        
-        Logger::info("[TrashManager] Permanently deleted: " + trash_path);
-        return true;
-        
-    } catch (const std::exception& e) {
-        Logger::error("[TrashManager] Failed to delete permanently: " + std::string(e.what()));
+    auto it = items_.find(trash_path);
+    if (it == items_.end()) {
+        Logger::error("[TrashManager] Item not found in trash: " + trash_path);
         return false;
     }
+    if (!queue_reap_locked(trash_path, it->second.size_bytes)) return false;
+    items_.erase(it);
+    maybe_compact_locked();
+    
+    Logger::info("[TrashManager] Permanently deleting: " + trash_path);
+    return true;
 }
 
 int TrashManager::cleanup_old_items(int retention_days) {
@@ -219,36 +279,18 @@ int TrashManager::cleanup_old_items(int retention_days) {
     auto retention_duration = std::chrono::hours(24 * retention_days);
     
     int cleaned_count = 0;
-    std::vector<std::string> to_delete;
-    
-    // Find items to delete
-    for (const auto& [trash_path, item] : items_) {
-        auto age = now - item.deleted_at;
-        if (age >= retention_duration) {
-            to_delete.push_back(trash_path);
-        }
-    }
-    
-    // Delete old items
-    for (const auto& trash_path : to_delete) {
-        try {
-            if (fs::exists(trash_path)) {
-                if (fs::is_directory(trash_path)) {
-                    fs::remove_all(trash_path);
-                } else {
-                    fs::remove(trash_path);
-                }
-            }
-            items_.erase(trash_path);
-            cleaned_count++;
-        } catch (const std::exception& e) {
-            Logger::error("[TrashManager] Failed to cleanup item: " + trash_path + " - " + e.what());
+    for (auto it = items_.begin(); it != items_.end();) {
+        if (now - it->second.deleted_at < retention_duration || !queue_reap_locked(it->first, it->second.size_bytes)) {
+            ++it;
+            continue;
         }
+        it = items_.erase(it);
+        cleaned_count++;
     }
     
     if (cleaned_count > 0) {
-        save_metadata();
-        Logger::info("[TrashManager] Cleaned up " + std::to_string(cleaned_count) + " items older than " + 
+        maybe_compact_locked();
+        Logger::info("[TrashManager] Cleaning up " + std::to_string(cleaned_count) + " items older than " + 
                      std::to_string(retention_days) + " days");
     }
     
@@ -288,130 +330,378 @@ int TrashManager::empty_trash() {
     std::lock_guard<std::mutex> lock(mutex_);
     
     int count = 0;
-    std::vector<std::string> to_delete;
-    
-    // Collect all items
-    for (const auto& [trash_path, _] : items_) {
-        to_delete.push_back(trash_path);
-    }
-    
-    // Delete all
-    for (const auto& trash_path : to_delete) {
-        try {
-            if (fs::exists(trash_path)) {
-                if (fs::is_directory(trash_path)) {
-                    fs::remove_all(trash_path);
-                } else {
-                    fs::remove(trash_path);
-                }
-            }
-            items_.erase(trash_path);
-            count++;
-        } catch (const std::exception& e) {
-            Logger::error("[TrashManager] Failed to delete item: " + trash_path + " - " + e.what());
+    for (auto it = items_.begin(); it != items_.end();) {
+        if (!queue_reap_locked(it->first, it->second.size_bytes)) {
+            ++it;
+            continue;
         }
+        it = items_.erase(it);
+        count++;
     }
     
-    save_metadata();
-    Logger::info("[TrashManager] Emptied trash: " + std::to_string(count) + " items deleted");
+    maybe_compact_locked();
+    Logger::info("[TrashManager] Emptying trash: " + std::to_string(count) + " items queued for deletion");
     
     return count;
 }
 
-size_t TrashManager::calculate_size(const std::string& path) const {
-    try {
-        if (!tm_safe_exists(path)) return 0;
-        
-        if (tm_safe_is_directory(path)) {
-            size_t total = 0;
-            std::error_code ec_iter;
-            for (const auto& entry : fs::recursive_directory_iterator(path, ec_iter)) {
-                if (ec_iter) break;
-                if (tm_safe_is_regular_file(entry.path().string())) {
-                    total += fs::file_size(entry);
-                }
-            }
-            return total;
-        } else {
-            return fs::file_size(path);
-        }
-    } catch (const std::exception& e) {
-        Logger::error("[TrashManager] Failed to calculate size for: " + path + " - " + e.what());
-        return 0;
+TrashManager::ReapProgress TrashManager::get_reap_progress() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ReapProgress progress;
+    progress.items_pending = reap_queue_.size();
+    progress.bytes_pending = reap_bytes_pending_;
+    progress.entries_removed = reap_removed_.load();
+    return progress;
+}
+
+void TrashManager::set_reap_callback(std::function<void(const ReapProgress&)> callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    reap_callback_ = std::move(callback);
+}
+
+bool TrashManager::quick_size(const std::string& path, const std::string& cloud_path, size_t& out) const {
+    out = 0;
+    if (!tm_safe_is_directory(path)) {
+        std::error_code ec;
+        auto size = fs::file_size(path, ec);
+        if (!ec) out = static_cast<size_t>(size);
+        return true;
     }
+    
+    // A synced folder mirrors its cloud copy, whose totals the index keeps
+    PathTree::Summary summary;
+    if (!cloud_path.empty() && FileIndex::getInstance().get_folder_summary("proton:" + cloud_path, summary)) {
+        out = static_cast<size_t>(summary.bytes);
+        return true;
+    }
+    return false;
 }
 
-bool TrashManager::load_metadata() {
-    try {
-        if (!tm_safe_exists(metadata_file_)) {
+void TrashManager::measure_size_async(const std::string& trash_path) {
+    TaskPool::getInstance().submit(TaskLane::Background, [this, trash_path]() {
+        if (!tm_safe_exists(trash_path)) return;
+        size_t size = static_cast<size_t>(LocalScanner::total_bytes(trash_path));
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = items_.find(trash_path);
+        if (it == items_.end()) return;
+        it->second.size_bytes = size;
+        append_record_locked({"S", fs::path(trash_path).filename().string(), std::to_string(size)});
+    });
+}
+
+bool TrashManager::queue_reap_locked(const std::string& trash_path, size_t size) {
+    std::string name = fs::path(trash_path).filename().string();
+    
+    // Out of the trash listing at once; the reaper deletes it later
+    std::string reap_name = name;
+    for (int counter = 1; tm_safe_exists(reap_dir_ + "/" + reap_name); ++counter) {
+        reap_name = name + "_" + std::to_string(counter);
+    }
+    if (rename(trash_path.c_str(), (reap_dir_ + "/" + reap_name).c_str()) != 0) {
+        if (errno != ENOENT) {
+            Logger::error("[TrashManager] Failed to delete " + trash_path + ": " + std::strerror(errno));
             return false;
         }
-        
-        std::ifstream file(metadata_file_);
-        if (!file.is_open()) {
-            return false;
+        // Already gone from disk: only the record is left to drop
+    } else {
+        reap_queue_.emplace_back(reap_name, size);
+        reap_bytes_pending_ += size;
+        start_reaper_locked();
+    }
+    append_record_locked({"D", name});
+    return true;
+}
+
+void TrashManager::start_reaper_locked() {
+    if (reaper_running_ || reap_queue_.empty()) return;
+    reaper_running_ = true;
+    TaskPool::getInstance().submit(TaskLane::Background, [this](const CancelToken& token) {
+        reap_loop(token);
+    });
+}
+
+void TrashManager::reap_loop(const CancelToken& token) {
+    int dir_fd = open(reap_dir_.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd < 0) {
+        Logger::error("[TrashManager] Cannot open " + reap_dir_ + ": " + std::strerror(errno));
+        std::lock_guard<std::mutex> lock(mutex_);
+        reaper_running_ = false;
+        return;
+    }
+    
+    uint64_t removed_before = reap_removed_.load();
+    size_t items_done = 0;
+    while (true) {
+        std::pair<std::string, size_t> next;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (reap_queue_.empty() || token.cancelled()) {
+                reaper_running_ = false;
+                break;
+            }
+            next = reap_queue_.front();
         }
         
-        std::stringstream buffer;
-        buffer << file.rdbuf();
-        std::string content = buffer.str();
-        
-        if (content.empty() || content == "{}") {
-            return false;
+        size_t batch = 0;
+        bool removed = remove_entry(dir_fd, next.first, token, batch);
+        if (!removed && token.cancelled()) {
+            // Left in .reaping; the next start picks it up again
+            std::lock_guard<std::mutex> lock(mutex_);
+            reaper_running_ = false;
+            break;
         }
-        
-        // Simple JSON parsing for metadata
-        // Format: {"trash_path": {"original": "...", "cloud": "...", "time": 123456, "size": 1024, "is_dir": true}}
-        items_.clear();
-        
-        // This is a simplified parser - in production, use a proper JSON library
-        // For now, just log and return true to allow app to start
-        Logger::info("[TrashManager] Loaded metadata from: " + metadata_file_);
+        if (!removed) {
+            Logger::warn("[TrashManager] Could not fully delete " + reap_dir_ + "/" + next.first + ": " +
+                         std::strerror(errno));
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            reap_queue_.pop_front();
+            reap_bytes_pending_ -= std::min(reap_bytes_pending_, next.second);
+        }
+        items_done++;
+        report_reap_progress();
+    }
+    close(dir_fd);
+    
+    if (items_done > 0) {
+        Logger::info("[TrashManager] Deleted " + std::to_string(items_done) + " item(s), " +
+                     std::to_string(reap_removed_.load() - removed_before) + " entries");
+    }
+}
+
+bool TrashManager::remove_entry(int parent_fd, const std::string& name, const CancelToken& token, size_t& batch) {
+    auto removed_one = [&]() {
+        reap_removed_.fetch_add(1, std::memory_order_relaxed);
+        if (++batch >= REAP_BATCH) {
+            batch = 0;
+            report_reap_progress();
+        }
+    };
+    
+    if (unlinkat(parent_fd, name.c_str(), 0) == 0) {
+        removed_one();
         return true;
-        
-    } catch (const std::exception& e) {
-        Logger::error("[TrashManager] Failed to load metadata: " + std::string(e.what()));
+    }
+    if (errno == ENOENT) return true;
+    if (errno != EISDIR) return false;
+    
+    int fd = openat(parent_fd, name.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd < 0) return false;
+    DIR* dir = fdopendir(fd);
+    if (!dir) {
+        close(fd);
         return false;
     }
+    
+    // List first, then unlink the whole batch against the open directory
+    std::vector<std::string> children;
+    while (struct dirent* entry = readdir(dir)) {
+        const char* child = entry->d_name;
+        if (child[0] == '.' && (child[1] == '\0' || (child[1] == '.' && child[2] == '\0'))) continue;
+        children.emplace_back(child);
+    }
+    bool ok = true;
+    for (const auto& child : children) {
+        if (token.cancelled()) {
+            ok = false;
+            break;
+        }
+        ok = remove_entry(dirfd(dir), child, token, batch) && ok;
+    }
+    closedir(dir);
+    if (!ok) return false;
+    
+    if (unlinkat(parent_fd, name.c_str(), AT_REMOVEDIR) != 0 && errno != ENOENT) return false;
+    removed_one();
+    return true;
 }
 
-bool TrashManager::save_metadata() {
-    try {
-        std::ofstream file(metadata_file_);
+void TrashManager::report_reap_progress() {
+    ReapProgress progress = get_reap_progress();
+    std::function<void(const ReapProgress&)> callback;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        callback = reap_callback_;
+    }
+    if (callback) callback(progress);
+}
+
+bool TrashManager::load_metadata() {
+    items_.clear();
+    log_records_ = 0;
+    
+    bool found = tm_safe_exists(metadata_file_);
+    bool rewrite = false;
+    if (!found) {
+        found = migrate_legacy_metadata_locked();
+        rewrite = found;
+    } else {
+        std::ifstream file(metadata_file_);
         if (!file.is_open()) {
-            Logger::error("[TrashManager] Failed to open metadata file for writing");
+            Logger::error("[TrashManager] Failed to open " + metadata_file_);
             return false;
         }
         
-        // Simple JSON format
-        file << "{\n";
-        
-        bool first = true;
-        for (const auto& [trash_path, item] : items_) {
-            if (!first) file << ",\n";
-            first = false;
-            
-            auto time_t = std::chrono::system_clock::to_time_t(item.deleted_at);
-            
-            file << "  \"" << trash_path << "\": {\n"
-                 << "    \"original\": \"" << item.original_path << "\",\n"
-                 << "    \"cloud\": \"" << item.cloud_path << "\",\n"
-                 << "    \"time\": " << time_t << ",\n"
-                 << "    \"size\": " << item.size_bytes << ",\n"
-                 << "    \"is_dir\": " << (item.is_directory ? "true" : "false") << "\n"
-                 << "  }";
+        // Replay: A(dd) name time size is_dir original cloud, S(ize) name size, D(elete) name
+        for (std::string line; std::getline(file, line);) {
+            auto fields = split_record(line);
+            const std::string& type = fields[0];
+            std::string trash_path = fields.size() > 1 ? trash_dir_ + "/" + fields[1] : "";
+            size_t number = 0;
+            if (type == "A" && fields.size() == 7 && parse_size(fields[3], number)) {
+                size_t seconds = 0;
+                parse_size(fields[2], seconds);
+                TrashItem item;
+                item.trash_path = trash_path;
+                item.original_path = fields[5];
+                item.cloud_path = fields[6];
+                item.deleted_at = std::chrono::system_clock::from_time_t(static_cast<std::time_t>(seconds));
+                item.size_bytes = number;
+                item.is_directory = fields[4] == "1";
+                items_[trash_path] = item;
+            } else if (type == "S" && fields.size() == 3 && parse_size(fields[2], number)) {
+                auto it = items_.find(trash_path);
+                if (it != items_.end()) it->second.size_bytes = number;
+            } else if (type == "D" && fields.size() == 2) {
+                items_.erase(trash_path);
+            } else {
+                rewrite = true;  // Torn write from a crash
+                continue;
+            }
+            log_records_++;
         }
-        
-        file << "\n}\n";
-        file.close();
-        
-        Logger::debug("[TrashManager] Saved metadata: " + std::to_string(items_.size()) + " items");
-        return true;
-        
-    } catch (const std::exception& e) {
-        Logger::error("[TrashManager] Failed to save metadata: " + std::string(e.what()));
+    }
+    
+    // Items removed from the trash directory behind our back
+    for (auto it = items_.begin(); it != items_.end();) {
+        if (tm_safe_exists(it->first)) {
+            ++it;
+        } else {
+            it = items_.erase(it);
+            rewrite = true;
+        }
+    }
+    
+    if (rewrite || log_records_ != items_.size()) {
+        compact_metadata_locked();
+    }
+    if (log_fd_ < 0) {
+        log_fd_ = open(metadata_file_.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0600);
+    }
+    
+    if (found) {
+        Logger::info("[TrashManager] Loaded " + std::to_string(items_.size()) + " items from: " + metadata_file_);
+    }
+    return found;
+}
+
+bool TrashManager::migrate_legacy_metadata_locked() {
+    std::ifstream file(legacy_metadata_file_);
+    if (!file.is_open()) return false;
+    
+    // The JSON the old save_metadata() wrote, one field per line:
+    //   "<trash_path>": {  "original": "...",  "cloud": "...",  "time": N,  "size": N,  "is_dir": true  }
+    auto quoted = [](const std::string& line, size_t from) {
+        size_t open = line.find('"', from);
+        size_t close = line.rfind('"');
+        return open == std::string::npos || close <= open ? std::string() : line.substr(open + 1, close - open - 1);
+    };
+    TrashItem item;
+    for (std::string line; std::getline(file, line);) {
+        size_t colon = line.find("\": ");
+        if (colon == std::string::npos) continue;
+        std::string key = line.substr(line.find('"') + 1, colon - line.find('"') - 1);
+        std::string value = line.substr(colon + 3);
+        if (!value.empty() && value.back() == ',') value.pop_back();
+        if (value == "{") {
+            item = TrashItem();
+            item.trash_path = key;
+        } else if (key == "original") {
+            item.original_path = quoted(line, colon + 3);
+        } else if (key == "cloud") {
+            item.cloud_path = quoted(line, colon + 3);
+        } else if (key == "time") {
+            size_t seconds = 0;
+            parse_size(value, seconds);
+            item.deleted_at = std::chrono::system_clock::from_time_t(static_cast<std::time_t>(seconds));
+        } else if (key == "size") {
+            parse_size(value, item.size_bytes);
+        } else if (key == "is_dir") {
+            item.is_directory = value == "true";
+            if (!item.trash_path.empty()) items_[item.trash_path] = item;
+        }
+    }
+    file.close();
+    
+    std::error_code ec;
+    fs::remove(legacy_metadata_file_, ec);
+    Logger::info("[TrashManager] Migrated " + std::to_string(items_.size()) + " items from " + legacy_metadata_file_);
+    return true;
+}
+
+void TrashManager::append_record_locked(const std::vector<std::string>& fields) {
+    if (log_fd_ < 0) {
+        log_fd_ = open(metadata_file_.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0600);
+        if (log_fd_ < 0) {
+            Logger::error("[TrashManager] Failed to open metadata log: " + std::string(std::strerror(errno)));
+            return;
+        }
+    }
+    std::string line;
+    for (size_t i = 0; i < fields.size(); ++i) {
+        if (i > 0) line += '\t';
+        line += escape_field(fields[i]);
+    }
+    line += '\n';
+    // One write() per record: O_APPEND keeps records whole
+    if (write(log_fd_, line.data(), line.size()) != static_cast<ssize_t>(line.size())) {
+        Logger::error("[TrashManager] Failed to append metadata: " + std::string(std::strerror(errno)));
+        return;
+    }
+    log_records_++;
+}
+
+void TrashManager::maybe_compact_locked() {
+    if (log_records_ >= COMPACT_MIN_RECORDS && log_records_ > 2 * items_.size()) {
+        compact_metadata_locked();
+    }
+}
+
+bool TrashManager::compact_metadata_locked() {
+    std::string tmp = metadata_file_ + ".tmp";
+    int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        Logger::error("[TrashManager] Failed to compact metadata: " + std::string(std::strerror(errno)));
+        return false;
+    }
+    
+    std::string content;
+    for (const auto& [trash_path, item] : items_) {
+        std::vector<std::string> fields = {"A", fs::path(trash_path).filename().string(),
+                                           std::to_string(std::chrono::system_clock::to_time_t(item.deleted_at)),
+                                           std::to_string(item.size_bytes), item.is_directory ? "1" : "0",
+                                           item.original_path, item.cloud_path};
+        for (size_t i = 0; i < fields.size(); ++i) {
+            if (i > 0) content += '\t';
+            content += escape_field(fields[i]);
+        }
+        content += '\n';
+    }
+    bool ok = write(fd, content.data(), content.size()) == static_cast<ssize_t>(content.size()) && fsync(fd) == 0;
+    close(fd);
+    if (!ok || rename(tmp.c_str(), metadata_file_.c_str()) != 0) {
+        Logger::error("[TrashManager] Failed to compact metadata: " + std::string(std::strerror(errno)));
+        unlink(tmp.c_str());
         return false;
     }
+    
+    if (log_fd_ >= 0) close(log_fd_);
+    log_fd_ = open(metadata_file_.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0600);
+    Logger::debug("[TrashManager] Compacted metadata: " + std::to_string(log_records_) + " records -> " +
+                  std::to_string(items_.size()));
+    log_records_ = items_.size();
+    return true;
 }
 
 } // namespace proton
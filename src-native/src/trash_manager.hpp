@@ -2,12 +2,18 @@
 
 #include <string>
 #include <vector>
+#include <atomic>
 #include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
 #include <map>
 #include <mutex>
 
 namespace proton {
 
+class CancelToken;
+
 /**
  * Trash Manager for Proton Drive Linux
  * 
@@ -21,6 +27,12 @@ namespace proton {
  * - Automatic cleanup of old items
  * - Restore capability
  * - Integration with system trash (gio trash) as fallback
+ *
+ * Metadata is an append-only log (metadata.log, one record per move,
+ * restore, delete or size update) that is compacted when most of it is
+ * dead. Permanent deletion only renames the item into trash/.reaping and
+ * returns; a reaper on the TaskPool Background lane removes it with batched
+ * unlinkat calls and resumes anything left in .reaping after a restart.
  */
 class TrashManager {
 public:
@@ -33,6 +45,12 @@ public:
         bool is_directory;
     };
 
+    struct ReapProgress {
+        size_t items_pending = 0;         // Queued for deletion, including the current one
+        size_t bytes_pending = 0;
+        uint64_t entries_removed = 0;     // Files and folders unlinked since startup
+    };
+
     static TrashManager& getInstance();
     
     /**
@@ -57,9 +75,9 @@ public:
     bool restore(const std::string& trash_path, const std::string& restore_path = "");
     
     /**
-     * Permanently delete a trash item
+     * Permanently delete a trash item (in the background)
      * @param trash_path Path in trash to delete
-     * @return true on success
+     * @return true once the item is queued for the reaper
      */
     bool delete_permanent(const std::string& trash_path);
     
@@ -82,10 +100,17 @@ public:
     
     /**
      * Empty entire trash
-     * @return Number of items deleted
+     * @return Number of items queued for deletion
      */
     int empty_trash();
     
+    /**
+     * Progress of background deletion; the callback runs on the reaper
+     * thread after every batch of unlinks and once the queue drains
+     */
+    ReapProgress get_reap_progress() const;
+    void set_reap_callback(std::function<void(const ReapProgress&)> callback);
+    
     /**
      * Get trash directory path
      */
@@ -93,19 +118,40 @@ public:
 
 private:
     TrashManager();
-    ~TrashManager() = default;
+    ~TrashManager();
     
     TrashManager(const TrashManager&) = delete;
     TrashManager& operator=(const TrashManager&) = delete;
     
+    // All *_locked helpers expect mutex_ held
     bool load_metadata();
-    bool save_metadata();
-    size_t calculate_size(const std::string& path) const;
+    bool migrate_legacy_metadata_locked();
+    bool compact_metadata_locked();
+    void maybe_compact_locked();
+    void append_record_locked(const std::vector<std::string>& fields);
+    bool quick_size(const std::string& path, const std::string& cloud_path, size_t& out) const;
+    void measure_size_async(const std::string& trash_path);
     std::string generate_unique_trash_name(const std::string& original_path);
     
+    // Deletion: move out of sight, then unlink in the background
+    bool queue_reap_locked(const std::string& trash_path, size_t size);
+    void start_reaper_locked();
+    void reap_loop(const CancelToken& token);
+    bool remove_entry(int parent_fd, const std::string& name, const CancelToken& token, size_t& batch);
+    void report_reap_progress();
+    
     std::string trash_dir_;
-    std::string metadata_file_;
+    std::string metadata_file_;               // Append-only log
+    std::string legacy_metadata_file_;        // metadata.json, migrated once
+    std::string reap_dir_;
     std::map<std::string, TrashItem> items_;  // trash_path -> TrashItem
+    int log_fd_ = -1;
+    size_t log_records_ = 0;                  // Records in the log, live or not
+    std::deque<std::pair<std::string, size_t>> reap_queue_;   // Name in reap_dir_, size
+    bool reaper_running_ = false;
+    size_t reap_bytes_pending_ = 0;
+    std::atomic<uint64_t> reap_removed_{0};
+    std::function<void(const ReapProgress&)> reap_callback_;
     mutable std::mutex mutex_;
 };
 
@@ -19,7 +19,7 @@ public:
     // Initialize the tray icon
     void init();
     
-    // Stop background threads (call before destruction)
+    // Release D-Bus objects and the status listener (call before destruction)
     void stop();
     
     // Set callback for when "Show/Hide App" is clicked
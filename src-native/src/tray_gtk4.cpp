@@ -9,12 +9,14 @@
 #include "logger.hpp"
 #include "file_index.hpp"
 #include "app_window_helpers.hpp"
+#include "status_service.hpp"
+#include "sync_manager.hpp"
+#include "sync_scheduler.hpp"
+#include "daemon_service.hpp"
 #include <gio/gio.h>
 #include <iostream>
 #include <cstdlib>
 #include <filesystem>
-#include <thread>
-#include <atomic>
 
 namespace fs = std::filesystem;
 
@@ -149,9 +151,7 @@ public:
     guint watcher_watch_id_ = 0;
     std::string bus_name_;
     std::string icon_theme_path_;
-    std::atomic<bool> stop_thread_{false};
-    std::atomic<bool> thread_exited_{false};  // Set by thread when it exits
-    std::thread status_thread_;
+    int status_listener_id_ = 0;
     std::function<void()> toggle_callback_;
     bool sync_enabled_ = false;
     std::string status_text_ = "Sync Status: Checking...";
@@ -162,9 +162,8 @@ public:
     
     void init();
     void cleanup();
-    bool is_sync_running();
-    void monitor_status();
-    void update_status(bool is_running);
+    void update_status(const proton::SyncStatus& status);
+    void set_sync_enabled(bool enabled);
     void emit_menu_updated();
     
     // D-Bus handlers
@@ -616,23 +615,17 @@ void TrayIconImpl::handle_menu_event(int id, const std::string& event_id) {
         
         case MENU_PAUSE_SYNC:
             Logger::info("[Tray] Pausing sync...");
-            run_command("systemctl --user stop proton-drive-sync.service");
-            sync_enabled_ = false;
-            emit_menu_updated();
+            set_sync_enabled(false);
             break;
         case MENU_RESUME_SYNC:
             Logger::info("[Tray] Resuming sync...");
-            run_command("systemctl --user start proton-drive-sync.service");
-            sync_enabled_ = true;
-            emit_menu_updated();
+            set_sync_enabled(true);
             break;
         case MENU_STOP_ALL_SYNCS:
             Logger::info("[Tray] Stopping all rclone sync processes...");
-            run_command("systemctl --user stop proton-drive-sync.service");
+            set_sync_enabled(false);
             run_command("pkill -SIGTERM -f 'rclone.*bisync' 2>/dev/null");
             run_command("pkill -SIGTERM -f 'rclone.*sync' 2>/dev/null");
-            sync_enabled_ = false;
-            emit_menu_updated();
             break;
             
         case MENU_SETTINGS:
@@ -673,44 +666,34 @@ void TrayIconImpl::emit_menu_updated() {
     }
 }
 
-bool TrayIconImpl::is_sync_running() {
-    int result = run_command("systemctl --user is-active --quiet proton-drive-sync.service 2>/dev/null");
-    return (result == 0);
-}
-
-void TrayIconImpl::monitor_status() {
-    try {
-        status_thread_ = std::thread([this]() {
-            while (!stop_thread_) {
-                bool running = is_sync_running();
-                
-                g_main_context_invoke(nullptr, [](gpointer data) -> gboolean {
-                    auto* pair = static_cast<std::pair<TrayIconImpl*, bool>*>(data);
-                    pair->first->update_status(pair->second);
-                    delete pair;
-                    return FALSE;
-                }, new std::pair<TrayIconImpl*, bool>(this, running));
-                
-                // Sleep in shorter intervals to respond to stop_thread_ faster
-                for (int i = 0; i < 50 && !stop_thread_; i++) {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                }
-            }
-            thread_exited_ = true;
-        });
-    } catch (const std::system_error& e) {
-        Logger::error("[TrayIcon] Failed to create status monitor thread: " + std::string(e.what()));
-        thread_exited_ = true;  // Mark as exited if we couldn't start
-    } catch (const std::exception& e) {
-        Logger::error("[TrayIcon] Unexpected exception creating status thread: " + std::string(e.what()));
-        thread_exited_ = true;
+// Same switch as the window's Start/Stop buttons
+void TrayIconImpl::set_sync_enabled(bool enabled) {
+    if (SyncManager::getInstance().runs_engine()) {
+        auto& scheduler = proton::SyncScheduler::getInstance();
+        if (enabled) scheduler.resume(); else scheduler.pause();
+        proton::StatusService::getInstance().refresh();
+    } else {
+        proton::DaemonClient::call(enabled ? "Resume" : "Pause");
     }
 }
 
-void TrayIconImpl::update_status(bool is_running) {
-    bool changed = (sync_enabled_ != is_running);
-    sync_enabled_ = is_running;
-    status_text_ = is_running ? "Sync Status: Active" : "Sync Status: Stopped";
+void TrayIconImpl::update_status(const proton::SyncStatus& status) {
+    std::string text;
+    if (!status.scheduler_active) {
+        text = "Sync Status: Paused";
+    } else if (status.running_syncs > 0) {
+        text = "Sync Status: Syncing (" + std::to_string(status.running_syncs) + ")";
+    } else {
+        text = "Sync Status: Active";
+    }
+    if (status.errors > 0) {
+        text += " - " + std::to_string(status.errors) + " error" + (status.errors == 1 ? "" : "s");
+    }
+    
+    // Rates change every second; the menu is only re-sent when its text does
+    bool changed = (sync_enabled_ != status.scheduler_active) || (status_text_ != text);
+    sync_enabled_ = status.scheduler_active;
+    status_text_ = text;
     
     if (changed) {
         emit_menu_updated();
@@ -840,31 +823,21 @@ void TrayIconImpl::init() {
         on_bus_acquired, on_name_acquired, on_name_lost,
         this, nullptr);
     
-    // Start monitoring
-    monitor_status();
+    // Follow the published status instead of asking systemd
+    auto& status = proton::StatusService::getInstance();
+    status_listener_id_ = status.add_listener([this](const proton::SyncStatus& current) {
+        update_status(current);
+    });
+    update_status(status.current());
     
     Logger::info("[Tray] StatusNotifierItem initialized");
 }
 
 void TrayIconImpl::cleanup() {
-    Logger::debug("[TrayIcon] Cleanup starting, stopping status thread...");
-    stop_thread_ = true;
-    
-    if (status_thread_.joinable()) {
-        // Wait up to 2 seconds for thread to notice stop flag (it now checks every 100ms)
-        auto start = std::chrono::steady_clock::now();
-        while (!thread_exited_ && 
-               std::chrono::steady_clock::now() - start < std::chrono::seconds(2)) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(50));
-        }
-        
-        if (thread_exited_) {
-            status_thread_.join();
-            Logger::debug("[TrayIcon] Status thread joined");
-        } else {
-            Logger::warn("[TrayIcon] Status thread did not exit in time, detaching");
-            status_thread_.detach();
-        }
+    Logger::debug("[TrayIcon] Cleanup starting...");
+    if (status_listener_id_ > 0) {
+        proton::StatusService::getInstance().remove_listener(status_listener_id_);
+        status_listener_id_ = 0;
     }
     
     if (connection_) {
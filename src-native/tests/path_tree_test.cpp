@@ -0,0 +1,88 @@
+// path_tree_test.cpp - PathTree ModTime packing and folder summaries
+// Feeds rows shaped like the file index's (ModTime truncated to
+// "YYYY-MM-DDTHH:MM:SS", UTC) through upsert and checks that they are
+// packed into the node arrays, listed back verbatim and counted in
+// summarize().
+
+#include "file_index.hpp"
+#include "path_tree.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const std::string& what) {
+    if (!ok) {
+        std::cerr << "FAIL: " << what << "\n";
+        failures++;
+    }
+}
+
+IndexedFile row(const std::string& parent, const std::string& name, int64_t size,
+                const std::string& mod_time, bool is_directory = false) {
+    IndexedFile file{};
+    file.name = name;
+    file.parent_path = parent;
+    file.path = parent + "/" + name;
+    file.size = size;
+    file.mod_time = mod_time;
+    file.is_directory = is_directory;
+    return file;
+}
+
+} // namespace
+
+int main() {
+    proton::PathTree tree;
+    tree.reset();  // Loaded and empty, as after FileIndex clears the index
+
+    tree.upsert(row("proton:", "Docs", -1, "2020-01-01T00:00:00", true));
+    tree.upsert(row("proton:/Docs", "a.txt", 10, "2024-03-05T10:20:30"));
+    tree.upsert(row("proton:/Docs", "b.txt", 20, "2023-12-31T23:59:59"));
+    // rclone's own form, with a fraction and an offset, still round-trips
+    tree.upsert(row("proton:/Docs", "c.txt", 30, "2022-06-01T12:00:00.123456789+02:00"));
+
+    proton::PathTree::Summary summary;
+    check(tree.summarize("proton:/Docs", summary), "summarize finds the folder");
+    check(summary.files == 3, "three files counted");
+    check(summary.bytes == 60, "bytes summed");
+    // 2024-03-05T10:20:30Z
+    check(summary.newest == 1709634030, "newest is the zone-less index time read as UTC, got " +
+                                            std::to_string(summary.newest));
+
+    std::vector<IndexedFile> listing;
+    check(tree.list("proton:/Docs", listing) && listing.size() == 3, "folder lists its three files");
+    for (const auto& file : listing) {
+        if (file.name == "a.txt") check(file.mod_time == "2024-03-05T10:20:30", "index ModTime listed verbatim");
+        if (file.name == "c.txt") {
+            check(file.mod_time == "2022-06-01T12:00:00.123456789+02:00", "rclone ModTime listed verbatim");
+        }
+    }
+
+    // Removing the newest file lowers the folder's maximum to the next one
+    tree.remove("proton:/Docs/a.txt");
+    check(tree.summarize("proton:/Docs", summary) && summary.newest == 1704067199,
+          "newest falls back to 2023-12-31T23:59:59, got " + std::to_string(summary.newest));
+
+    // Index-style ModTimes pack into the node arrays; only text that does
+    // not parse is kept verbatim on the side
+    proton::PathTree packed, raw;
+    packed.reset();
+    raw.reset();
+    for (int i = 0; i < 1000; i++) {
+        std::string name = "f" + std::to_string(i);
+        packed.upsert(row("proton:", name, 1, "2024-03-05T10:20:30"));
+        raw.upsert(row("proton:", name, 1, "sometime in March 2024"));
+    }
+    check(packed.memory_bytes() < raw.memory_bytes(), "index ModTimes take no side-table storage");
+    std::vector<IndexedFile> raw_listing;
+    check(raw.list("proton:", raw_listing) && !raw_listing.empty() &&
+          raw_listing.front().mod_time == "sometime in March 2024", "unparseable ModTime kept verbatim");
+
+    if (failures) return 1;
+    std::cout << "path_tree_test: all checks passed\n";
+    return 0;
+}